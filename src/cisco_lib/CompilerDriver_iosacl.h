@@ -28,6 +28,8 @@
 
 #include "CompilerDriver.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
 #include <string>
 #include <sstream>
 
@@ -55,7 +57,7 @@ namespace fwcompiler {
 protected:
         std::string system_configuration_script;
         std::string nat_script;
-        std::string policy_script;
+        ChunkedOutput policy_script;
         std::string routing_script;
         std::string safety_net_install_option_name;
         std::string safety_net_install_acl_addr_option_name;
@@ -67,10 +69,11 @@ protected:
                                          libfwbuilder::Firewall* fw,
                                          bool cluster_member);
         virtual QString printActivationCommands(libfwbuilder::Firewall *fw);
-        virtual QString assembleFwScript(libfwbuilder::Cluster *cluster,
-                                         libfwbuilder::Firewall* fw,
-                                         bool cluster_member,
-                                         OSConfigurator *ocsnf);
+        virtual void assembleFwScript(libfwbuilder::Cluster *cluster,
+                                      libfwbuilder::Firewall* fw,
+                                      bool cluster_member,
+                                      OSConfigurator *ocsnf,
+                                      ChunkedOutput &res);
         
 public:
 
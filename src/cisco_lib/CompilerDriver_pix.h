@@ -28,6 +28,8 @@
 
 #include "CompilerDriver.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
 #include <string>
 #include <sstream>
 
@@ -55,8 +57,8 @@ protected:
         std::string preamble_commands;
         std::string system_configuration_script;
         std::string named_objects_and_groups;
-        std::string nat_script;
-        std::string policy_script;
+        ChunkedOutput nat_script;
+        ChunkedOutput policy_script;
         std::string routing_script;
 
         void pixSecurityLevelChecks(libfwbuilder::Firewall *fw,
@@ -74,10 +76,11 @@ protected:
                                          libfwbuilder::Firewall* fw,
                                          bool cluster_member);
         virtual QString printActivationCommands(libfwbuilder::Firewall *fw);
-        virtual QString assembleFwScript(libfwbuilder::Cluster *cluster,
-                                         libfwbuilder::Firewall* fw,
-                                         bool cluster_member,
-                                         OSConfigurator *ocsnf);
+        virtual void assembleFwScript(libfwbuilder::Cluster *cluster,
+                                      libfwbuilder::Firewall* fw,
+                                      bool cluster_member,
+                                      OSConfigurator *ocsnf,
+                                      ChunkedOutput &res);
 
 public:
 
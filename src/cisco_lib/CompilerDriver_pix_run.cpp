@@ -116,10 +116,11 @@ QString CompilerDriver_pix::printActivationCommands(Firewall*)
     return "";
 }
 
-QString CompilerDriver_pix::assembleFwScript(Cluster *cluster,
-                                             Firewall* fw,
-                                             bool cluster_member,
-                                             OSConfigurator *oscnf)
+void CompilerDriver_pix::assembleFwScript(Cluster *cluster,
+                                          Firewall* fw,
+                                          bool cluster_member,
+                                          OSConfigurator *oscnf,
+                                          ChunkedOutput &res)
 {
     Configlet script_skeleton(fw, "pix_os", "script_skeleton");
     Configlet top_comment(fw, "pix_os", "top_comment");
@@ -175,17 +176,15 @@ QString CompilerDriver_pix::assembleFwScript(Cluster *cluster,
                                 QString::fromUtf8(
                                     named_objects_and_groups.c_str()));
 
-    script_skeleton.setVariable("policy_script",
-                                QString::fromUtf8(policy_script.c_str()));
-    script_skeleton.setVariable("nat_script",
-                                QString::fromUtf8(nat_script.c_str()));
+    script_skeleton.setVariable("policy_script", &policy_script);
+    script_skeleton.setVariable("nat_script", &nat_script);
     script_skeleton.setVariable("routing_script",
                                 QString::fromUtf8(routing_script.c_str()));
 
     assembleFwScriptInternal(cluster, fw, cluster_member, oscnf,
                              &script_skeleton, &top_comment, "!", true);
 
-    return script_skeleton.expand();
+    script_skeleton.expand(res);
 }
 
 QString CompilerDriver_pix::run(const std::string &cluster_id,
@@ -265,8 +264,6 @@ QString CompilerDriver_pix::run(const std::string &cluster_id,
 
     FWOptions* options = fw->getOptionsObject();
 
-    QString script_buffer;
-
     std::auto_ptr<NATCompiler_pix> n;
     std::auto_ptr<PolicyCompiler_pix> c;
     std::auto_ptr<RoutingCompiler_pix> r;
@@ -527,8 +524,8 @@ QString CompilerDriver_pix::run(const std::string &cluster_id,
             all_errors.push_front(getErrors("").c_str());
         }
 
-        policy_script = c->getCompiledScript();
-        nat_script = n->getCompiledScript();
+        c->appendCompiledScript(policy_script);
+        n->appendCompiledScript(nat_script);
         routing_script = r->getCompiledScript();
 
         named_objects_and_groups = named_objects_manager.getNamedObjectsDefinitions();
@@ -545,7 +542,8 @@ QString CompilerDriver_pix::run(const std::string &cluster_id,
             return formSingleRuleCompileOutput(
                 QString::fromUtf8(
                     (named_objects_and_groups +
-                     policy_script + nat_script + routing_script).c_str()));
+                     policy_script.str() + nat_script.str() +
+                     routing_script).c_str()));
         }
 
         system_configuration_script = oscnf->getCompiledScript();
@@ -557,31 +555,17 @@ QString CompilerDriver_pix::run(const std::string &cluster_id,
         // system_configuration_script += clear_commands;
 
 
-        script_buffer = assembleFwScript(
-            cluster, fw, !cluster_id.empty(), oscnf.get());
+        ChunkedOutput fw_script;
+        assembleFwScript(cluster, fw, !cluster_id.empty(), oscnf.get(), fw_script);
 
         QString ofname = getAbsOutputFileName(file_names[FW_FILE]);
 
         info("Output file name: " + ofname.toStdString());
-        QFile fw_file(ofname);
-        if (fw_file.open(QIODevice::WriteOnly))
-        {
-            QTextStream fw_str(&fw_file);
-            fw_str << script_buffer;
-            fw_file.close();
-            fw_file.setPermissions(QFile::ReadOwner | QFile::WriteOwner |
-                                   QFile::ReadGroup | QFile::ReadOther |
-                                   QFile::ExeOwner | 
-                                   QFile::ExeGroup |
-                                   QFile::ExeOther );
-
+        QString err = writeOutputFile(ofname, fw_script, true);
+        if (err.isEmpty())
             info(" Compiled successfully");
-        } else
-        {
-            QString err(" Failed to open file %1 for writing: %2; Current dir: %3");
-            abort(err.arg(fw_file.fileName())
-                  .arg(fw_file.error()).arg(QDir::current().path()).toStdString());
-        }
+        else
+            abort(" " + err.toStdString());
 
         if (!all_errors.isEmpty())
             status = BaseCompiler::FWCOMPILER_WARNING;
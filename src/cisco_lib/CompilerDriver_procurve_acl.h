@@ -53,10 +53,11 @@ protected:
         virtual QString assembleManifest(libfwbuilder::Cluster *cluster,
                                          libfwbuilder::Firewall* fw,
                                          bool cluster_member);
-        virtual QString assembleFwScript(libfwbuilder::Cluster *cluster,
-                                         libfwbuilder::Firewall* fw,
-                                         bool cluster_member,
-                                         OSConfigurator *ocsnf);
+        virtual void assembleFwScript(libfwbuilder::Cluster *cluster,
+                                      libfwbuilder::Firewall* fw,
+                                      bool cluster_member,
+                                      OSConfigurator *ocsnf,
+                                      ChunkedOutput &res);
         
 public:
 
@@ -85,18 +85,18 @@ QString CompilerDriver_procurve_acl::assembleManifest(Cluster*, Firewall*, bool)
     return script_buffer;
 }
 
-QString CompilerDriver_procurve_acl::assembleFwScript(Cluster *cluster,
-                                                Firewall *fw,
-                                                bool cluster_member,
-                                                OSConfigurator *oscnf)
+void CompilerDriver_procurve_acl::assembleFwScript(Cluster *cluster,
+                                                   Firewall *fw,
+                                                   bool cluster_member,
+                                                   OSConfigurator *oscnf,
+                                                   ChunkedOutput &res)
 {
     Configlet script_skeleton(fw, "procurve", "script_skeleton");
     Configlet top_comment(fw, "procurve", "top_comment");
 
     script_skeleton.setVariable("system_configuration_script",
                                 QString::fromUtf8(system_configuration_script.c_str()));
-    script_skeleton.setVariable("policy_script", 
-                                QString::fromUtf8(policy_script.c_str()));
+    script_skeleton.setVariable("policy_script", &policy_script);
     script_skeleton.setVariable("nat_script", 
                                 QString::fromUtf8(nat_script.c_str()));
     script_skeleton.setVariable("routing_script", 
@@ -108,7 +108,7 @@ QString CompilerDriver_procurve_acl::assembleFwScript(Cluster *cluster,
 
     assembleFwScriptInternal(cluster, fw, cluster_member, oscnf,
                              &script_skeleton, &top_comment, ";", true);
-    return script_skeleton.expand();
+    script_skeleton.expand(res);
 }
 
 QString CompilerDriver_procurve_acl::run(const std::string &cluster_id,
@@ -263,14 +263,14 @@ QString CompilerDriver_procurve_acl::run(const std::string &cluster_id,
                     {
                         if (ipv6_policy)
                         {
-                            policy_script += "\n\n";
-                            policy_script += "; ================ IPv6\n";
-                            policy_script += "\n\n";
+                            policy_script << "\n\n";
+                            policy_script << "; ================ IPv6\n";
+                            policy_script << "\n\n";
                         } else
                         {
-                            policy_script += "\n\n";
-                            policy_script += "; ================ IPv4\n";
-                            policy_script += "\n\n";
+                            policy_script << "\n\n";
+                            policy_script << "; ================ IPv4\n";
+                            policy_script << "\n\n";
                         }
                     }
 
@@ -278,7 +278,7 @@ QString CompilerDriver_procurve_acl::run(const std::string &cluster_id,
                     {
                         all_errors.push_back(c.getErrors("").c_str());
                     }
-                    policy_script +=  c.getCompiledScript();
+                    c.appendCompiledScript(policy_script);
                     clear_commands += c.printClearCommands();
                     //named_objects_manager.saveObjectGroups();
 
@@ -342,7 +342,7 @@ QString CompilerDriver_procurve_acl::run(const std::string &cluster_id,
             return formSingleRuleCompileOutput(
                 QString::fromUtf8(
                     (object_groups_definitions +
-                     policy_script + routing_script).c_str()));
+                     policy_script.str() + routing_script).c_str()));
         }
 
         if ( fw->getOptionsObject()->getBool("procurve_acl_acl_basic") ||
@@ -354,31 +354,17 @@ QString CompilerDriver_procurve_acl::run(const std::string &cluster_id,
         system_configuration_script += clear_commands;
         system_configuration_script += object_groups_definitions;
 
-        QString script_buffer = assembleFwScript(
-            cluster, fw, !cluster_id.empty(), oscnf.get());
+        ChunkedOutput fw_script;
+        assembleFwScript(cluster, fw, !cluster_id.empty(), oscnf.get(), fw_script);
 
         QString ofname = getAbsOutputFileName(file_names[FW_FILE]);
 
         info("Output file name: " + ofname.toStdString());
-        QFile fw_file(ofname);
-        if (fw_file.open(QIODevice::WriteOnly))
-        {
-            QTextStream fw_str(&fw_file);
-            fw_str << script_buffer;
-            fw_file.close();
-            fw_file.setPermissions(QFile::ReadOwner | QFile::WriteOwner |
-                                   QFile::ReadGroup | QFile::ReadOther |
-                                   QFile::ExeOwner | 
-                                   QFile::ExeGroup |
-                                   QFile::ExeOther );
-
+        QString err = writeOutputFile(ofname, fw_script, true);
+        if (err.isEmpty())
             info(" Compiled successfully");
-        } else
-        {
-            QString err(" Failed to open file %1 for writing: %2; Current dir: %3");
-            abort(err.arg(fw_file.fileName())
-                  .arg(fw_file.error()).arg(QDir::current().path()).toStdString());
-        }
+        else
+            abort(" " + err.toStdString());
 
         if (!all_errors.isEmpty())
             status = BaseCompiler::FWCOMPILER_WARNING;
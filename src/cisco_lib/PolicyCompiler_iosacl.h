@@ -248,14 +248,14 @@ namespace fwcompiler {
             struct printRulesForACL : public std::unary_function<libfwbuilder::Rule*, void>
             {
                 ciscoACL *acl;
-                std::stringstream *output;
+                std::ostream *output;
                 PolicyCompiler_iosacl *iosacl_comp;
                 PolicyCompiler_iosacl::PrintCompleteACLs *print_acl_p;
 
                 printRulesForACL(PolicyCompiler_iosacl *_comp,
                                  PolicyCompiler_iosacl::PrintCompleteACLs *pp,
                                  ciscoACL* _acl,
-                                 std::stringstream *_out)
+                                 std::ostream *_out)
                 { iosacl_comp = _comp; print_acl_p = pp; acl = _acl; output = _out; }
 
                 // print rule if it belongs to ACL <acl>
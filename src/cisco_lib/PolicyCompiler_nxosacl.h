@@ -248,14 +248,14 @@ namespace fwcompiler {
             struct printRulesForACL : public std::unary_function<libfwbuilder::Rule*, void>
             {
                 ciscoACL *acl;
-                std::stringstream *output;
+                std::ostream *output;
                 PolicyCompiler_nxosacl *nxosacl_comp;
                 PolicyCompiler_nxosacl::PrintCompleteACLs *print_acl_p;
 
                 printRulesForACL(PolicyCompiler_nxosacl *_comp,
                                  PolicyCompiler_nxosacl::PrintCompleteACLs *pp,
                                  ciscoACL* _acl,
-                                 std::stringstream *_out)
+                                 std::ostream *_out)
                 { nxosacl_comp = _comp; print_acl_p = pp; acl = _acl; output = _out; }
 
                 // print rule if it belongs to ACL <acl>
@@ -143,6 +143,8 @@ void RoutingCompiler_nxosacl::compile()
 
     add(new ConvertToAtomicForDST(
             "Convert to atomic rules by dst address elements"));
+
+    add(new aggregateRoutes("Aggregate routes"));
         
     add(new createSortedDstIdsLabel(
             "Create label with a sorted dst-id-list for 'classifyRoutingRules'"));
@@ -67,6 +67,7 @@
 #include "fwcompiler/Compiler.h"
 
 #include <QStringList>
+#include <QTime>
 #include <QtDebug>
 
 
@@ -93,19 +94,22 @@ CompilerDriver::CompilerDriver(FWObjectDatabase *db) : BaseCompiler()
     ipv4_run = true;
     ipv6_run = true;
     fw_by_id = false;
+    prune_objdb = false;
+    validate_pruned_objdb = false;
+    full_objdb = NULL;
+    specialize_members = false;
 
-    objdb = new FWObjectDatabase(*db);
-    objdb->setIgnoreReadOnlyFlag(true);
-
-    //objdb = db;
+    // the copy of the database is made when it is needed, prepare()
+    // can make pruned copy directly from db instead of the full one
+    source_objdb = db;
+    objdb = NULL;
+    objdb_copy_time = 0;
 
     persistent_objects = new Library();
     persistent_objects->setName("Persistent Objects");
-    objdb->add(persistent_objects);
 
     workspace = new Library();
     workspace->setName("Workspace");
-    objdb->add(workspace);
 
     prolog_done = false;
     epilog_done = false;
@@ -139,6 +143,27 @@ CompilerDriver::~CompilerDriver()
     }
 
     delete objdb;
+    if (full_objdb) delete full_objdb;
+}
+
+/*
+ * Make full copy of the database the driver was created with, unless
+ * the copy exists already
+ */
+void CompilerDriver::copyObjectDatabase()
+{
+    if (objdb != NULL) return;
+
+    QTime copy_timer;
+    copy_timer.start();
+
+    objdb = new FWObjectDatabase(*source_objdb);
+    objdb->setIgnoreReadOnlyFlag(true);
+
+    objdb_copy_time = copy_timer.elapsed();
+
+    objdb->add(persistent_objects);
+    objdb->add(workspace);
 }
 
 // create a copy of itself, including objdb
@@ -238,6 +263,32 @@ bool CompilerDriver::configure(const QStringList &args)
             continue;
         }
 
+        if (arg == "-xm")
+        {
+            prune_objdb = true;
+            continue;
+        }
+
+        if (arg == "-xmv")
+        {
+            prune_objdb = true;
+            validate_pruned_objdb = true;
+            continue;
+        }
+
+        if (arg == "-xs")
+        {
+            specialize_members = true;
+            continue;
+        }
+
+        if (arg == "-xd")
+        {
+            idx++;
+            dns_cache_file = args.at(idx);
+            continue;
+        }
+
         if (arg == "-xt")
         {
             setTestMode();
@@ -656,22 +707,27 @@ void CompilerDriver::setTargetId(const string &id)
 }
 
 Firewall* CompilerDriver::locateObject()
+{
+    return locateObject(objdb);
+}
+
+Firewall* CompilerDriver::locateObject(FWObjectDatabase *db)
 {
     Firewall* obj;
     if (fw_by_id)
     {
         // fwobjectname is actually object id
         obj = Firewall::cast(
-            objdb->findInIndex(
+            db->findInIndex(
                 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
-                objdb->getIntId(fwobjectname.toAscii().constData())));
+                db->getIntId(fwobjectname.toAscii().constData())));
                 #else
-                objdb->getIntId(fwobjectname.toLatin1().constData())));
+                db->getIntId(fwobjectname.toLatin1().constData())));
                 #endif
         //fwobjectname = obj->getName().c_str();
     }
     else
-        obj = objdb->findFirewallByName(fwobjectname.toUtf8().constData());
+        obj = db->findFirewallByName(fwobjectname.toUtf8().constData());
 
     return obj;
 }
@@ -1299,12 +1355,7 @@ void CompilerDriver::getFirewallAndClusterObjects(const string &cluster_id,
     (*fw)->duplicate(orig_fw);
 
     if (*cl != NULL)
-    {
-        const map<int, int> &id_map = (*fw)->getIDMappingTable();
-        map<int, int>::const_iterator it;
-        for (it=id_map.begin(); it!=id_map.end(); ++it)
-            (*cl)->replaceRef(it->first, it->second);
-    }
+        (*cl)->replaceRefs((*fw)->getIDMappingTable());
 #else
 
     *fw = orig_fw;
@@ -33,12 +33,14 @@
 #include <string>
 #include <sstream>
 #include <memory>
+#include <set>
 
 #include <QDir>
 #include <QTextStream>
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QList>
 
 
 namespace libfwbuilder {
@@ -63,9 +65,25 @@ namespace fwcompiler
 {
 
     class OSConfigurator;
+    class ChunkedOutput;
     
     class CompilerDriver : public BaseCompiler
     {
+public:
+
+        /*
+         * Name or address that differs between two cluster
+         * members. kind is 0 for names, 1 for IPv4 addresses, 2 for
+         * IPv6 addresses and 3 for MAC addresses.
+         */
+        struct MemberToken
+        {
+            QString from;
+            QString to;
+            int kind;
+        };
+
+private:
 
         QString getOutputFileNameInternal(libfwbuilder::Firewall *current_fw,
                                           const QString &from_cli,
@@ -132,10 +150,39 @@ protected:
         
         std::map<std::string,libfwbuilder::RuleSet*> branches;
 
+        // database the driver was created with. It is not modified,
+        // compilers work with objdb which is a copy made by
+        // copyObjectDatabase() or pruneObjectDatabase()
+        libfwbuilder::FWObjectDatabase *source_objdb;
         libfwbuilder::FWObjectDatabase *objdb;
         libfwbuilder::Library *persistent_objects;
         libfwbuilder::Library *workspace;
 
+        // -xm: replace full copy of the object database with a copy
+        // that holds only objects reachable from the target firewall
+        // or cluster. -xmv: compile with both copies and compare.
+        bool prune_objdb;
+        bool validate_pruned_objdb;
+        // full copy kept around when validate_pruned_objdb is set
+        libfwbuilder::FWObjectDatabase *full_objdb;
+        // time in milliseconds it took to build objdb
+        int objdb_copy_time;
+
+        // absolute paths of all files written by compile(), including
+        // those written by member firewall drivers
+        QStringList generated_files;
+
+        // -xs: generate files for cluster members that differ only in
+        // names and addresses by substitution in the files compiled
+        // for another member
+        bool specialize_members;
+        // names of members whose files were generated this way
+        QStringList specialized_members;
+
+        // -xd: file where results of DNS queries for DNSName objects
+        // are kept between compiler runs
+        QString dns_cache_file;
+
         void determineOutputFileNames(libfwbuilder::Cluster *cluster,
                                       libfwbuilder::Firewall *current_fw,
                                       bool cluster_member,
@@ -181,9 +228,76 @@ protected:
         
 
         QString getAbsOutputFileName(const QString &output_file_name);
+
+        /*
+         * Writes generated text to the file using vectored I/O, the
+         * text is never assembled in one string. Returns empty string
+         * if successful or error message.
+         */
+        QString writeOutputFile(const QString &file_name,
+                                const ChunkedOutput &text,
+                                bool executable=false);
+
+        /* Functions that build pruned copy of the object database */
+        void findReachableObjects(libfwbuilder::FWObjectDatabase *db,
+                                  libfwbuilder::FWObject *target,
+                                  std::set<libfwbuilder::FWObject*> &reachable);
+        void copyPrunedTree(libfwbuilder::FWObject *src,
+                            libfwbuilder::FWObject *dst,
+                            const std::set<libfwbuilder::FWObject*> &reachable,
+                            const std::set<libfwbuilder::FWObject*> &ancestors);
+        libfwbuilder::FWObjectDatabase* createPrunedCopy(
+            libfwbuilder::FWObjectDatabase *db, libfwbuilder::FWObject *target);
+        void copyObjectDatabase();
+        void pruneObjectDatabase(libfwbuilder::Firewall *target);
+        void reportObjectDatabaseCopy(const QString &descr);
+        void validatePrunedCopy();
+
+        static int countObjects(libfwbuilder::FWObject *obj);
+
+        /* Functions that specialize output compiled for one cluster
+         * member for another */
+        bool matchMemberInterfaces(libfwbuilder::Firewall *fw1,
+                                   libfwbuilder::Firewall *fw2,
+                                   libfwbuilder::Interface *iface1,
+                                   libfwbuilder::Interface *iface2,
+                                   QList<MemberToken> &tokens);
+        bool matchClusterMembers(libfwbuilder::Cluster *cluster,
+                                 libfwbuilder::Firewall *fw1,
+                                 libfwbuilder::Firewall *fw2,
+                                 QList<MemberToken> &tokens);
+        bool memberTokensAreUnique(libfwbuilder::FWObject *obj,
+                                   libfwbuilder::Firewall *fw1,
+                                   libfwbuilder::Firewall *fw2,
+                                   const QList<MemberToken> &tokens);
+        bool memberTokensInText(libfwbuilder::FWObject *obj,
+                                libfwbuilder::Firewall *fw1,
+                                libfwbuilder::Firewall *fw2,
+                                const QList<MemberToken> &tokens,
+                                bool inside_member=false);
+        bool haveSameClusterRoles(libfwbuilder::Cluster *cluster,
+                                  libfwbuilder::Firewall *fw1,
+                                  libfwbuilder::Firewall *fw2);
+        bool specializeMember(libfwbuilder::Cluster *cluster,
+                              libfwbuilder::Firewall *compiled_fw,
+                              const QStringList &compiled_files,
+                              libfwbuilder::Firewall *fw,
+                              QStringList &member_files);
+
+        /*
+         * Returns true if output compiled for cluster member
+         * compiled_fw can be turned into output for member fw by
+         * substitution of names and addresses. Default implementation
+         * returns false.
+         */
+        virtual bool isMemberSpecializationSupported(
+            libfwbuilder::Cluster *cluster,
+            libfwbuilder::Firewall *compiled_fw,
+            libfwbuilder::Firewall *fw);
         
 public:
 
+
         CompilerDriver(libfwbuilder::FWObjectDatabase *db);
         virtual ~CompilerDriver();
 
@@ -252,6 +366,7 @@ public:
          * Find firewall or cluster object we should process.
          */
         virtual libfwbuilder::Firewall* locateObject();
+        libfwbuilder::Firewall* locateObject(libfwbuilder::FWObjectDatabase *db);
 
         void getFirewallAndClusterObjects(const std::string &cluster_id,
                                           const std::string &fw_id,
@@ -283,6 +398,8 @@ public:
         static QString getConfFileNameFromFwFileName(const QString &file_name,
                                                      const QString &ext);
         
+        const QStringList& getSpecializedMembers() { return specialized_members; }
+
 	void setDebugRule(int dr)  { drp = drn = dr; rule_debug_on = true; }
 
     };
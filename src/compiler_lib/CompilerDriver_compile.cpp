@@ -38,6 +38,7 @@
 #include "fwbuilder/Interface.h"
 #include "fwbuilder/Library.h"
 #include "fwbuilder/Rule.h"
+#include "fwbuilder/dns.h"
 
 #include "fwcompiler/Compiler.h"
 
@@ -56,20 +57,46 @@ bool CompilerDriver::prepare(const QStringList &_args)
 
     if (!configure(args)) return false;
 
+    // DNS cache is shared by all compilers in the process, results
+    // of previous runs are not reused unless they come from the file
+    DNS::getCache()->clear();
+
     if (!single_rule_compile_on)
     {
-        Firewall *fw = locateObject();
+        // with -xm the pruned copy is made directly from the source
+        // database, full copy is not needed
+        Firewall *fw = locateObject(source_objdb);
         if (fw == NULL)
         {
             cerr << "Firewall or cluster object not found" << endl;
             return false;
         }
+
+        if (prune_objdb) pruneObjectDatabase(fw);
+        else
+        {
+            copyObjectDatabase();
+            if (verbose) reportObjectDatabaseCopy("Object database copy");
+        }
+
+        if (!dns_cache_file.isEmpty())
+        {
+            try
+            {
+                DNS::getCache()->load(dns_cache_file.toUtf8().constData());
+            } catch (FWException &ex)
+            {
+                warning(ex.toString());
+            }
+        }
     }
     return true;
 }
 
 void CompilerDriver::compile()
 {
+    copyObjectDatabase();
+
     if (single_rule_compile_on)
     {
         QMapIterator<QString,QString> it(compileSingleRule(single_rule_id));
@@ -90,22 +117,65 @@ void CompilerDriver::compile()
         // compiling cluster. 
         list<Firewall*> members;
         Cluster::cast(fw)->getMembersList(members);
+
+        // members compiled so far, absolute names of their files and
+        // compiler status. Used to specialize output for the members
+        // that follow when -xs is in effect
+        QList<Firewall*> compiled_members;
+        QList<QStringList> compiled_member_files;
+        QList<termination_status> compiled_member_status;
+
         for (list<Firewall*>::iterator it=members.begin(); it!=members.end(); ++it)
         {
             info("\n");
             info(" Firewall " + (*it)->getName() +
                  " member of cluster " + fw->getName());
 
+            if (specialize_members)
+            {
+                bool done = false;
+                for (int i=0; i<compiled_members.size() && !done; ++i)
+                {
+                    QStringList member_files;
+                    if (specializeMember(Cluster::cast(fw), compiled_members[i],
+                                         compiled_member_files[i], *it,
+                                         member_files))
+                    {
+                        generated_files << member_files;
+                        // keep the worst status of all members
+                        if (compiled_member_status[i] > status)
+                            status = compiled_member_status[i];
+                        done = true;
+                    }
+                }
+                if (done) continue;
+            }
+
             CompilerDriver *cl_driver = clone();
             cl_driver->configure(args);
+            cl_driver->copyObjectDatabase();
+            if (verbose)
+                cl_driver->reportObjectDatabaseCopy(
+                    QString("Object database copy for member %1")
+                    .arg(QString::fromUtf8((*it)->getName().c_str())));
             cl_driver->chDir();
             cl_driver->run(objdb->getStringId(fw->getId()),
                            objdb->getStringId((*it)->getId()),
                            "");
-            // if (cl_driver->status == BaseCompiler::FWCOMPILER_ERROR)
-            // We need to always copy the status to make sure
-            // FWCOMPILER_WARNING is passed through
-            status = cl_driver->status;
+            QStringList member_files;
+            foreach(QString file_name, cl_driver->file_names)
+                member_files << cl_driver->getAbsOutputFileName(file_name);
+            generated_files << member_files;
+            if (cl_driver->status != BaseCompiler::FWCOMPILER_ERROR)
+            {
+                compiled_members.push_back(*it);
+                compiled_member_files.push_back(member_files);
+                compiled_member_status.push_back(cl_driver->status);
+            }
+            // status values are ordered by severity, keep the worst
+            // one so that errors or warnings of a member compiled
+            // earlier are not lost
+            if (cl_driver->status > status) status = cl_driver->status;
             delete cl_driver;
         }
     }
@@ -114,6 +184,21 @@ void CompilerDriver::compile()
         chDir();
         commonChecks(fw);
         run("", objdb->getStringId(fw->getId()), "");
+        foreach(QString file_name, file_names)
+            generated_files << getAbsOutputFileName(file_name);
+    }
+
+    if (full_objdb != NULL) validatePrunedCopy();
+
+    if (!dns_cache_file.isEmpty())
+    {
+        try
+        {
+            DNS::getCache()->save(dns_cache_file.toUtf8().constData());
+        } catch (FWException &ex)
+        {
+            warning(ex.toString());
+        }
     }
 }
 
@@ -131,6 +216,12 @@ QMap<QString,QString> CompilerDriver::compileSingleRule(const string &rule_id)
     Cluster *cluster = NULL;
     Firewall *fw = NULL;
 
+    // the GUI compiles single rules in its own process, names must be
+    // resolved again every time
+    DNS::getCache()->clear();
+
+    copyObjectDatabase();
+
     Rule *rule = Rule::cast(
         objdb->findInIndex(FWObjectDatabase::getIntId(rule_id)));
     if (rule==NULL)
@@ -159,6 +250,7 @@ QMap<QString,QString> CompilerDriver::compileSingleRule(const string &rule_id)
         for (list<Firewall*>::iterator it=members.begin(); it!=members.end(); ++it)
         {
             CompilerDriver *cl_driver = clone();
+            cl_driver->copyObjectDatabase();
             cl_driver->single_rule_compile_on = true;
             if (inTestMode()) cl_driver->setTestMode();
             if (inEmbeddedMode()) cl_driver->setEmbeddedMode();
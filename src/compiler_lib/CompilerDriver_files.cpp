@@ -30,10 +30,17 @@
 #include "fwbuilder/Firewall.h"
 #include "fwbuilder/Resources.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QString>
 #include <QtDebug>
 
+#include <errno.h>
+#include <string.h>
+
 
 using namespace std;
 using namespace libfwbuilder;
@@ -286,3 +293,37 @@ QString CompilerDriver::unescapeFileName(QString fileName)
     return fileName.replace("\\ ", " ");
 }
 
+QString CompilerDriver::writeOutputFile(const QString &file_name,
+                                        const ChunkedOutput &text,
+                                        bool executable)
+{
+    // Unbuffered so that QFile does not hold any data of its own
+    // and everything goes directly to the file descriptor
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+    {
+        return QString("Failed to open file %1 for writing: %2; "
+                       "Current dir: %3")
+            .arg(file.fileName())
+            .arg(file.errorString())
+            .arg(QDir::current().path());
+    }
+
+    if (!text.writeTo(file.handle()))
+    {
+        QString err = QString("Failed to write file %1: %2")
+            .arg(file.fileName()).arg(strerror(errno));
+        file.close();
+        return err;
+    }
+
+    file.close();
+
+    if (executable)
+        file.setPermissions(QFile::ReadOwner | QFile::WriteOwner |
+                            QFile::ReadGroup | QFile::ReadOther |
+                            QFile::ExeOwner |
+                            QFile::ExeGroup |
+                            QFile::ExeOther );
+    return "";
+}
@@ -0,0 +1,344 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2009 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@vk.crocodile.org
+
+  $Id$
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+
+#include <iostream>
+#include <list>
+#include <set>
+
+#include "CompilerDriver.h"
+
+#include "fwbuilder/DynamicGroup.h"
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Host.h"
+#include "fwbuilder/Library.h"
+
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+using namespace std;
+using namespace libfwbuilder;
+using namespace fwcompiler;
+
+
+/*
+ * Objects compilers find by their well known ids rather than by
+ * following references.
+ */
+static int system_object_ids[] = {
+    FWObjectDatabase::ANY_ADDRESS_ID,
+    FWObjectDatabase::ANY_SERVICE_ID,
+    FWObjectDatabase::ANY_INTERVAL_ID,
+    FWObjectDatabase::DUMMY_ADDRESS_ID,
+    FWObjectDatabase::DUMMY_SERVICE_ID,
+    FWObjectDatabase::DUMMY_INTERFACE_ID,
+    -1
+};
+
+/*
+ * Walk subtree of obj and collect every object it points to. Besides
+ * references, objects point to each other by storing string ids in
+ * attributes and options (branch_id of a branching rule, network_zone
+ * of an interface and so on), so values of all attributes that look
+ * like a known object id count as links too. Members of dynamic
+ * groups are determined by keywords rather than references, these are
+ * collected by matching every object in the database.
+ */
+static void collectLinks(FWObjectDatabase *db, FWObject *obj,
+                         list<FWObject*> &links)
+{
+    FWReference *ref = FWReference::cast(obj);
+    if (ref)
+    {
+        FWObject *ptr = ref->getPointer();
+        if (ptr) links.push_back(ptr);
+    }
+
+    for (AttributeMap::const_iterator it=obj->dataBegin();
+         it!=obj->dataEnd(); ++it)
+    {
+        if (it->second.empty()) continue;
+        int id = FWObjectDatabase::getIntId(it->second);
+        if (id < 0) continue;
+        FWObject *o = db->findInIndex(id);
+        if (o && o != obj) links.push_back(o);
+    }
+
+    DynamicGroup *dg = DynamicGroup::cast(obj);
+    if (dg)
+    {
+        list<FWObject*> all_objects;
+        all_objects.push_back(db);
+        while (!all_objects.empty())
+        {
+            FWObject *o = all_objects.front();
+            all_objects.pop_front();
+            if (o != db && dg->isMemberOfGroup(o)) links.push_back(o);
+            for (FWObject::iterator i=o->begin(); i!=o->end(); ++i)
+                all_objects.push_back(*i);
+        }
+    }
+
+    for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+        collectLinks(db, *i, links);
+}
+
+int CompilerDriver::countObjects(FWObject *obj)
+{
+    int n = 1;
+    for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+        n += countObjects(*i);
+    return n;
+}
+
+/*
+ * Find transitive closure of objects reachable from the target
+ * firewall or cluster. Objects are copied with their whole subtree,
+ * so the set holds only topmost objects. An object that lives inside
+ * of a host or firewall (interface, address of an interface) pulls in
+ * the whole host because compilers walk interfaces of the parent host
+ * of such objects.
+ */
+void CompilerDriver::findReachableObjects(FWObjectDatabase *db,
+                                          FWObject *target,
+                                          set<FWObject*> &reachable)
+{
+    list<FWObject*> queue;
+    queue.push_back(target);
+
+    for (int *id=system_object_ids; *id >= 0; ++id)
+    {
+        FWObject *o = db->findInIndex(*id);
+        if (o) queue.push_back(o);
+    }
+
+    while (!queue.empty())
+    {
+        FWObject *obj = queue.front();
+        queue.pop_front();
+
+        for (FWObject *p=obj->getParent(); p!=NULL && p!=db; p=p->getParent())
+            if (Host::cast(p)) obj = p;
+
+        if (obj == db || Library::isA(obj)) continue;
+        if (reachable.count(obj) > 0) continue;
+
+        reachable.insert(obj);
+        collectLinks(db, obj, queue);
+    }
+}
+
+/*
+ * Recreate the part of the tree under src that is needed to hold
+ * reachable objects. Reachable objects are copied as a whole, their
+ * parents (libraries and system folders) are copied without children
+ * that nothing points to. All ids are preserved.
+ */
+void CompilerDriver::copyPrunedTree(FWObject *src,
+                                    FWObject *dst,
+                                    const set<FWObject*> &reachable,
+                                    const set<FWObject*> &ancestors)
+{
+    FWObjectDatabase *root = dst->getRoot();
+
+    for (FWObject::iterator i=src->begin(); i!=src->end(); ++i)
+    {
+        FWObject *o = *i;
+        if (reachable.count(o) > 0)
+        {
+            // preserve_id==false makes the copy take id of the original
+            dst->addCopyOf(o, false);
+            continue;
+        }
+        if (ancestors.count(o) > 0)
+        {
+            // last arg.==false : do not call method init() of the new
+            // object to make sure it doesn't create its children
+            FWObject *o1 = root->create(o->getTypeName(), -1, false);
+            dst->add(o1, false);
+            o1->shallowDuplicate(o, false);
+            copyPrunedTree(o, o1, reachable, ancestors);
+        }
+    }
+}
+
+FWObjectDatabase* CompilerDriver::createPrunedCopy(FWObjectDatabase *db,
+                                                   FWObject *target)
+{
+    set<FWObject*> reachable;
+    findReachableObjects(db, target, reachable);
+
+    set<FWObject*> ancestors;
+    for (set<FWObject*>::iterator it=reachable.begin(); it!=reachable.end(); ++it)
+    {
+        for (FWObject *p=(*it)->getParent(); p!=NULL && p!=db; p=p->getParent())
+            if (!ancestors.insert(p).second) break;
+    }
+
+    FWObjectDatabase *ndb = new FWObjectDatabase();
+    ndb->setIgnoreReadOnlyFlag(true);
+    ndb->setFileName(db->getFileName());
+    ndb->shallowDuplicate(db, true);
+
+    copyPrunedTree(db, ndb, reachable, ancestors);
+
+    ndb->addToIndexRecursive(ndb);
+    ndb->setDirty(false);
+    return ndb;
+}
+
+/*
+ * Make objdb a copy of the source database that holds only objects
+ * the compiler can reach from the target. The copy is made directly
+ * from the source, full copy is only made if we need it to validate
+ * the output.
+ */
+void CompilerDriver::pruneObjectDatabase(Firewall *target)
+{
+    QTime prune_timer;
+    prune_timer.start();
+
+    if (objdb != NULL)
+    {
+        objdb->remove(persistent_objects, false);
+        objdb->remove(workspace, false);
+        delete objdb;
+    }
+
+    objdb = createPrunedCopy(source_objdb, target);
+    objdb->add(persistent_objects);
+    objdb->add(workspace);
+
+    objdb_copy_time = prune_timer.elapsed();
+
+    if (verbose)
+    {
+        QString msg("Pruned object database copy: %1 of %2 objects");
+        info(msg.arg(countObjects(objdb)).arg(countObjects(source_objdb)).toStdString());
+        reportObjectDatabaseCopy("Pruned object database copy");
+    }
+
+    if (validate_pruned_objdb)
+    {
+        full_objdb = new FWObjectDatabase(*source_objdb);
+        full_objdb->setIgnoreReadOnlyFlag(true);
+    }
+}
+
+void CompilerDriver::reportObjectDatabaseCopy(const QString &descr)
+{
+    QString msg("%1: %2 objects, %3 ms");
+    info(msg.arg(descr).arg(countObjects(objdb)).arg(objdb_copy_time).toStdString());
+}
+
+/*
+ * Generated files carry a time stamp in the format of ctime(3), these
+ * are the only lines that are expected to differ between two runs.
+ */
+static QStringList readGeneratedFile(const QString &file_name)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly)) return QStringList();
+
+    QString text = QString::fromUtf8(file.readAll().constData());
+    text.replace(
+        QRegExp("\\w{3} \\w{3} [ \\d]\\d \\d{2}:\\d{2}:\\d{2} \\d{4}"),
+        "<timestamp>");
+    return text.split("\n");
+}
+
+/*
+ * Compile the same target again using full copy of the database and
+ * compare generated files with those produced using pruned copy. The
+ * files produced by the second run (with the full copy) are the ones
+ * left on disk.
+ */
+void CompilerDriver::validatePrunedCopy()
+{
+    QMap<QString, QStringList> pruned_output;
+    foreach(QString file_name, generated_files)
+        pruned_output[file_name] = readGeneratedFile(file_name);
+
+    info("\n");
+    info(" Validating pruned object database copy");
+
+    FWObjectDatabase *pruned = objdb;
+    objdb = full_objdb;
+    CompilerDriver *full_driver = clone();
+    objdb = pruned;
+
+    full_driver->configure(args);
+    full_driver->prune_objdb = false;
+    full_driver->validate_pruned_objdb = false;
+
+    QDir::setCurrent(start_current_dir.absolutePath());
+    full_driver->compile();
+
+    bool identical = true;
+
+    if (full_driver->generated_files != generated_files)
+    {
+        error("Pruned object database copy: compilers generated different "
+              "sets of files: " +
+              generated_files.join(" ").toStdString() + " vs " +
+              full_driver->generated_files.join(" ").toStdString());
+        identical = false;
+    } else
+    {
+        foreach(QString file_name, full_driver->generated_files)
+        {
+            QStringList full_lines = readGeneratedFile(file_name);
+            QStringList pruned_lines = pruned_output[file_name];
+            if (full_lines == pruned_lines) continue;
+
+            int line = 0;
+            while (line < full_lines.size() && line < pruned_lines.size() &&
+                   full_lines[line] == pruned_lines[line]) line++;
+
+            QString err("Pruned object database copy: file %1 differs "
+                        "from the one generated with full copy at line %2");
+            error(err.arg(file_name).arg(line + 1).toStdString());
+            identical = false;
+        }
+    }
+
+    if (identical)
+        info(" Pruned object database copy produced identical output");
+
+    if (full_driver->status != BaseCompiler::FWCOMPILER_SUCCESS &&
+        status == BaseCompiler::FWCOMPILER_SUCCESS)
+        status = full_driver->status;
+
+    delete full_driver;
+}
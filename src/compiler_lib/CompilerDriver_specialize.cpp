@@ -0,0 +1,709 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2009 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@vk.crocodile.org
+
+  $Id$
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+
+#include <iostream>
+
+#include "CompilerDriver.h"
+
+#include "fwbuilder/Address.h"
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/Cluster.h"
+#include "fwbuilder/ClusterGroup.h"
+#include "fwbuilder/Constants.h"
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/FailoverClusterGroup.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/InetAddr.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/Management.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleSet.h"
+#include "fwbuilder/StateSyncClusterGroup.h"
+#include "fwbuilder/physAddress.h"
+
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+
+using namespace std;
+using namespace libfwbuilder;
+using namespace fwcompiler;
+
+
+#define MEMBER_TOKEN_PLACEHOLDER "@@FWB_MEMBER_TOKEN_%1@@"
+
+/*
+ * Compare attributes of two objects other than name and id. Key
+ * ignore_key is skipped, this is used for attributes that hold
+ * addresses.
+ */
+static bool sameAttributes(FWObject *o1, FWObject *o2,
+                           const string &ignore_key="")
+{
+    if (o1->getTypeName() != o2->getTypeName()) return false;
+    if (o1->getComment() != o2->getComment()) return false;
+
+    map<string, string> d1(o1->dataBegin(), o1->dataEnd());
+    map<string, string> d2(o2->dataBegin(), o2->dataEnd());
+    if (!ignore_key.empty())
+    {
+        d1.erase(ignore_key);
+        d2.erase(ignore_key);
+    }
+    return d1 == d2;
+}
+
+static bool isInside(FWObject *obj, FWObject *parent)
+{
+    for (FWObject *p=obj; p!=NULL; p=p->getParent())
+        if (p == parent) return true;
+    return false;
+}
+
+static QRegExp memberTokenRegExp(const QString &str, int kind)
+{
+    // characters that may not surround the token in the generated
+    // text, otherwise we are looking at a part of a longer word,
+    // name or address
+    QString word_chars;
+    switch (kind)
+    {
+    case 0:  word_chars = "A-Za-z0-9_\\-"; break;   // name
+    case 1:  word_chars = "A-Za-z0-9_."; break;     // IPv4 address
+    default: word_chars = "A-Za-z0-9_.:"; break;    // IPv6 or MAC address
+    }
+    return QRegExp(QString("(^|[^%1])%2(?=[^%1]|$)")
+                   .arg(word_chars).arg(QRegExp::escape(str)));
+}
+
+static bool parseAddress(const QString &str, int kind, InetAddr *res)
+{
+    try
+    {
+        *res = InetAddr((kind == 1) ? AF_INET : AF_INET6, str.toStdString());
+    } catch (FWException&)
+    {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Finds IPv4 (kind 1) or IPv6 (kind 2) addresses in the text
+ */
+static void findAddresses(const QString &text, int kind,
+                          QStringList &addr_str, QList<InetAddr> &addr_num)
+{
+    QRegExp addr_re = (kind == 1) ?
+        QRegExp("(^|[^A-Za-z0-9_.])(\\d{1,3}\\.\\d{1,3}\\.\\d{1,3}\\.\\d{1,3})"
+                "(?=[^A-Za-z0-9_.]|$)") :
+        QRegExp("(^|[^A-Za-z0-9_.:])([0-9A-Fa-f]{0,4}(:[0-9A-Fa-f]{0,4}){2,7})"
+                "(?=[^A-Za-z0-9_.:]|$)");
+    int pos = 0;
+    while ((pos = addr_re.indexIn(text, pos)) != -1)
+    {
+        InetAddr addr;
+        if (parseAddress(addr_re.cap(2), kind, &addr))
+        {
+            addr_str << addr_re.cap(2);
+            addr_num << addr;
+        }
+        pos += addr_re.matchedLength();
+    }
+}
+
+static int sign(int n)
+{
+    return (n > 0) - (n < 0);
+}
+
+static int compareAddresses(const InetAddr &a, const InetAddr &b)
+{
+    if (a < b) return -1;
+    if (b < a) return 1;
+    return 0;
+}
+
+/*
+ * Generated code may list addresses sorted, either as numbers or as
+ * strings. Substitution keeps the order only if none of the addresses
+ * that stay in the text falls between the old and the new address of
+ * a member interface and if member addresses keep their relative
+ * order. An address that stays in the text and is equal to the old or
+ * new address written some other way (for example IPv6 address that
+ * is not compressed) can not be substituted either.
+ */
+static bool substitutionKeepsOrder(const QString &text,
+                                   const QList<CompilerDriver::MemberToken> &tokens)
+{
+    for (int kind=1; kind<=2; ++kind)
+    {
+        QStringList other_str;
+        QList<InetAddr> other_num;
+        findAddresses(text, kind, other_str, other_num);
+
+        for (int i=0; i<tokens.size(); ++i)
+        {
+            if (tokens[i].kind != kind) continue;
+            InetAddr a, b;
+            if (!parseAddress(tokens[i].from, kind, &a) ||
+                !parseAddress(tokens[i].to, kind, &b))
+                return false;
+
+            for (int k=0; k<other_num.size(); ++k)
+            {
+                const InetAddr &t = other_num[k];
+                if (compareAddresses(t, a) * compareAddresses(t, b) <= 0)
+                    return false;
+                int s1 = QString::compare(other_str[k], tokens[i].from);
+                int s2 = QString::compare(other_str[k], tokens[i].to);
+                if (sign(s1) != sign(s2)) return false;
+            }
+
+            for (int j=i+1; j<tokens.size(); ++j)
+            {
+                if (tokens[j].kind != kind) continue;
+                InetAddr c, d;
+                if (!parseAddress(tokens[j].from, kind, &c) ||
+                    !parseAddress(tokens[j].to, kind, &d))
+                    return false;
+                if (compareAddresses(a, c) != compareAddresses(b, d))
+                    return false;
+                if (sign(QString::compare(tokens[i].from, tokens[j].from)) !=
+                    sign(QString::compare(tokens[i].to, tokens[j].to)))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Text of the configlets is copied to the generated files as is, the
+ * compiler does not put member names or addresses there
+ */
+static bool configletsContain(const QList<CompilerDriver::MemberToken> &tokens)
+{
+    static QString configlet_text;
+    static bool configlets_read = false;
+    if (!configlets_read)
+    {
+        QStringList dirs;
+        dirs << QString(Constants::getResourcesDirectory().c_str()) + "/configlets"
+             << QDir::homePath() + "/fwbuilder/configlets";
+        foreach(QString dir, dirs)
+        {
+            QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+            {
+                QFile file(it.next());
+                if (!file.open(QIODevice::ReadOnly)) continue;
+                configlet_text += QString::fromUtf8(file.readAll().constData());
+                configlet_text += "\n";
+            }
+        }
+        configlets_read = true;
+    }
+
+    foreach(CompilerDriver::MemberToken tok, tokens)
+    {
+        if (configlet_text.contains(memberTokenRegExp(tok.from, tok.kind)) ||
+            configlet_text.contains(memberTokenRegExp(tok.to, tok.kind)))
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Platforms that can use member specialization override this. Output
+ * of such platforms must not depend on anything that differs between
+ * members except names and addresses and all of it must be written
+ * to the files listed in file_names.
+ */
+bool CompilerDriver::isMemberSpecializationSupported(Cluster*,
+                                                     Firewall*,
+                                                     Firewall*)
+{
+    return false;
+}
+
+/*
+ * Returns true if neither of two members is the master in any of
+ * the failover or state synchronization groups of the cluster.
+ */
+bool CompilerDriver::haveSameClusterRoles(Cluster *cluster,
+                                          Firewall *fw1,
+                                          Firewall *fw2)
+{
+    list<FWObject*> groups = cluster->getByTypeDeep(FailoverClusterGroup::TYPENAME);
+    list<FWObject*> state_sync_groups =
+        cluster->getByTypeDeep(StateSyncClusterGroup::TYPENAME);
+    groups.insert(groups.end(), state_sync_groups.begin(), state_sync_groups.end());
+
+    for (list<FWObject*>::iterator it=groups.begin(); it!=groups.end(); ++it)
+    {
+        string master_id = (*it)->getStr("master_iface");
+        if (master_id.empty()) continue;
+        FWObject *master = objdb->findInIndex(FWObjectDatabase::getIntId(master_id));
+        if (master == NULL) continue;
+        if (isInside(master, fw1) || isInside(master, fw2)) return false;
+    }
+    return true;
+}
+
+bool CompilerDriver::matchMemberInterfaces(Firewall *fw1, Firewall *fw2,
+                                           Interface *iface1, Interface *iface2,
+                                           QList<MemberToken> &tokens)
+{
+    if (iface1->getName() != iface2->getName()) return false;
+    if (!sameAttributes(iface1, iface2)) return false;
+    if (iface1->size() != iface2->size()) return false;
+
+    FWObject::iterator i1 = iface1->begin();
+    FWObject::iterator i2 = iface2->begin();
+    for (; i1!=iface1->end(); ++i1, ++i2)
+    {
+        FWObject *o1 = *i1;
+        FWObject *o2 = *i2;
+
+        if (o1->getTypeName() != o2->getTypeName()) return false;
+
+        if (Interface::cast(o1))
+        {
+            if (!matchMemberInterfaces(fw1, fw2, Interface::cast(o1),
+                                       Interface::cast(o2), tokens))
+                return false;
+            continue;
+        }
+
+        // attached networks are derived from the addresses
+        if (o1->getTypeName() == "AttachedNetworks") continue;
+
+        if (FWOptions::cast(o1))
+        {
+            if (!sameAttributes(o1, o2)) return false;
+            continue;
+        }
+
+        if (physAddress::cast(o1))
+        {
+            if (!sameAttributes(o1, o2, "address")) return false;
+            QString mac1 = physAddress::cast(o1)->getPhysAddress().c_str();
+            QString mac2 = physAddress::cast(o2)->getPhysAddress().c_str();
+            if (mac1 != mac2)
+            {
+                MemberToken tok = { mac1, mac2, 3 };
+                tokens.push_back(tok);
+            }
+            continue;
+        }
+
+        if (IPv4::cast(o1) || IPv6::cast(o1))
+        {
+            if (!sameAttributes(o1, o2)) return false;
+
+            Address *a1 = Address::cast(o1);
+            Address *a2 = Address::cast(o2);
+            if (a1->getNetmaskPtr()->toString() != a2->getNetmaskPtr()->toString())
+                return false;
+
+            // only host addresses are substituted, while generated code
+            // can also have the network of the interface (attached
+            // networks, broadcast address), so both members must be on
+            // the same subnet
+            InetAddr net1 = *(a1->getAddressPtr()) & *(a1->getNetmaskPtr());
+            InetAddr net2 = *(a2->getAddressPtr()) & *(a2->getNetmaskPtr());
+            if (net1 != net2) return false;
+
+            QString addr1 = a1->getAddressPtr()->toString().c_str();
+            QString addr2 = a2->getAddressPtr()->toString().c_str();
+            if (addr1 != addr2)
+            {
+                MemberToken tok = { addr1, addr2, IPv4::cast(o1) ? 1 : 2 };
+                tokens.push_back(tok);
+            }
+
+            // names of addresses usually include the name of the
+            // member, otherwise they become tokens of their own
+            QString name1 = o1->getName().c_str();
+            QString name2 = o2->getName().c_str();
+            name1.replace(memberTokenRegExp(fw1->getName().c_str(), 0),
+                          QString("\\1") + fw2->getName().c_str());
+            if (name1 != name2)
+            {
+                MemberToken tok = { QString(o1->getName().c_str()), name2, 0 };
+                tokens.push_back(tok);
+            }
+            continue;
+        }
+
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Two members can share generated code if they are identical except
+ * for their names and names and addresses of their interfaces, the
+ * addresses must belong to the same subnets. The list of such
+ * differences is returned in tokens.
+ */
+bool CompilerDriver::matchClusterMembers(Cluster *cluster,
+                                         Firewall *fw1, Firewall *fw2,
+                                         QList<MemberToken> &tokens)
+{
+    const char *fw_attrs[] = { "platform", "host_OS", "version", "inactive", NULL };
+    for (const char **attr=fw_attrs; *attr!=NULL; ++attr)
+        if (fw1->getStr(*attr) != fw2->getStr(*attr)) return false;
+
+    if (fw1->getComment() != fw2->getComment()) return false;
+
+    if (fw1->size() != fw2->size()) return false;
+
+    FWObject::iterator i1 = fw1->begin();
+    FWObject::iterator i2 = fw2->begin();
+    for (; i1!=fw1->end(); ++i1, ++i2)
+    {
+        FWObject *o1 = *i1;
+        FWObject *o2 = *i2;
+
+        if (o1->getTypeName() != o2->getTypeName()) return false;
+
+        if (Interface::cast(o1))
+        {
+            if (!matchMemberInterfaces(fw1, fw2, Interface::cast(o1),
+                                       Interface::cast(o2), tokens))
+                return false;
+            continue;
+        }
+
+        if (RuleSet::cast(o1))
+        {
+            // member rule sets are merged with those of the cluster,
+            // only empty ones are allowed
+            if (o1->getName() != o2->getName()) return false;
+            if (!sameAttributes(o1, o2)) return false;
+            if (o1->size() != o2->size()) return false;
+            for (FWObject::iterator j1=o1->begin(), j2=o2->begin();
+                 j1!=o1->end(); ++j1, ++j2)
+            {
+                if (Rule::cast(*j1) || Rule::cast(*j2)) return false;
+                if (!sameAttributes(*j1, *j2)) return false;
+            }
+            continue;
+        }
+
+        if (Management::cast(o1))
+        {
+            // management address is normally one of the addresses
+            // of the member interfaces
+            if (o1->size() != o2->size()) return false;
+            for (FWObject::iterator j1=o1->begin(), j2=o2->begin();
+                 j1!=o1->end(); ++j1, ++j2)
+                if (!(*j1)->cmp(*j2, true)) return false;
+            const InetAddr &addr1 = Management::cast(o1)->getAddress();
+            const InetAddr &addr2 = Management::cast(o2)->getAddress();
+            if (addr1.isV4() != addr2.isV4()) return false;
+            if (!(addr1 == addr2))
+            {
+                MemberToken tok = { QString(addr1.toString().c_str()),
+                                    QString(addr2.toString().c_str()),
+                                    addr1.isV4() ? 1 : 2 };
+                tokens.push_back(tok);
+            }
+            continue;
+        }
+
+        if (!o1->cmp(o2, true)) return false;
+    }
+
+    MemberToken name_tok = { QString(fw1->getName().c_str()),
+                             QString(fw2->getName().c_str()), 0 };
+    tokens.push_back(name_tok);
+
+    // member interfaces must be used in the same cluster groups
+    list<FWObject*> groups = cluster->getByTypeDeep(FailoverClusterGroup::TYPENAME);
+    list<FWObject*> state_sync_groups =
+        cluster->getByTypeDeep(StateSyncClusterGroup::TYPENAME);
+    groups.insert(groups.end(), state_sync_groups.begin(), state_sync_groups.end());
+
+    for (list<FWObject*>::iterator it=groups.begin(); it!=groups.end(); ++it)
+    {
+        QStringList ifaces1, ifaces2;
+        for (FWObjectTypedChildIterator j=(*it)->findByType(FWObjectReference::TYPENAME);
+             j!=j.end(); ++j)
+        {
+            FWObject *iface = FWReference::getObject(*j);
+            if (iface == NULL) continue;
+            if (isInside(iface, fw1)) ifaces1 << iface->getName().c_str();
+            if (isInside(iface, fw2)) ifaces2 << iface->getName().c_str();
+        }
+        ifaces1.sort();
+        ifaces2.sort();
+        if (ifaces1 != ifaces2) return false;
+    }
+
+    // substitution must be reversible: tokens can not repeat or
+    // collide with each other
+    for (int i=0; i<tokens.size(); ++i)
+    {
+        for (int j=i+1; j<tokens.size(); ++j)
+        {
+            if (tokens[i].from == tokens[j].from && tokens[i].to == tokens[j].to)
+            {
+                tokens.removeAt(j);
+                --j;
+                continue;
+            }
+            if (tokens[i].from == tokens[j].from ||
+                tokens[i].to == tokens[j].to ||
+                tokens[i].from == tokens[j].to ||
+                tokens[i].to == tokens[j].from)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Every occurrence of a token in the generated text is substituted,
+ * so tokens must not be names or addresses of any other object or
+ * fall inside of an address range. Objects outside of the two
+ * members can not point into them either, except for the cluster
+ * groups: a rule that uses an interface of a member by name would be
+ * compiled into the same code for every member.
+ */
+bool CompilerDriver::memberTokensAreUnique(FWObject *obj,
+                                           Firewall *fw1, Firewall *fw2,
+                                           const QList<MemberToken> &tokens)
+{
+    if (obj == fw1 || obj == fw2) return true;
+    if (ClusterGroup::cast(obj)) return true;
+
+    FWReference *ref = FWReference::cast(obj);
+    if (ref)
+    {
+        FWObject *ptr = ref->getPointer();
+        if (ptr && (isInside(ptr, fw1) || isInside(ptr, fw2))) return false;
+    }
+
+    QString name = obj->getName().c_str();
+    QString addr;
+    Address *a = Address::cast(obj);
+    if (a && a->hasInetAddress() && a->getAddressPtr())
+        addr = a->getAddressPtr()->toString().c_str();
+
+    foreach(MemberToken tok, tokens)
+    {
+        if (tok.kind == 0 && (name == tok.from || name == tok.to)) return false;
+        if (tok.kind != 0 && !addr.isEmpty() &&
+            (addr == tok.from || addr == tok.to)) return false;
+    }
+
+    // address ranges are expanded, the compiler may print any
+    // address inside of the range
+    AddressRange *range = AddressRange::cast(obj);
+    if (range)
+    {
+        foreach(MemberToken tok, tokens)
+        {
+            if (tok.kind != 1 && tok.kind != 2) continue;
+            const InetAddr &start = range->getRangeStart();
+            const InetAddr &end = range->getRangeEnd();
+            QStringList addrs;
+            addrs << tok.from << tok.to;
+            foreach(QString str, addrs)
+            {
+                InetAddr a;
+                if (!parseAddress(str, tok.kind, &a)) return false;
+                if (a.addressFamily() != start.addressFamily()) continue;
+                if (!(a < start) && !(end < a)) return false;
+            }
+        }
+    }
+
+    for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+        if (!memberTokensAreUnique(*i, fw1, fw2, tokens)) return false;
+
+    return true;
+}
+
+/*
+ * Returns true if a token appears in a comment, label, script, option
+ * or name of any object. The compiler copies such text to the
+ * generated files; substitution would rewrite it there, so tokens
+ * must only come from the names and addresses of the members
+ * themselves.
+ */
+bool CompilerDriver::memberTokensInText(FWObject *obj,
+                                        Firewall *fw1, Firewall *fw2,
+                                        const QList<MemberToken> &tokens,
+                                        bool inside_member)
+{
+    inside_member = inside_member || obj == fw1 || obj == fw2;
+
+    QStringList text;
+    text << QString::fromUtf8(obj->getComment().c_str());
+    for (AttributeMap::const_iterator i=obj->dataBegin(); i!=obj->dataEnd(); ++i)
+    {
+        // names and addresses of the member objects are the tokens
+        if (inside_member && (i->first == "name" || i->first == "address"))
+            continue;
+        text << QString::fromUtf8(i->second.c_str());
+    }
+
+    foreach(QString str, text)
+    {
+        if (str.isEmpty()) continue;
+        foreach(MemberToken tok, tokens)
+        {
+            if ((str.contains(tok.from) &&
+                 str.contains(memberTokenRegExp(tok.from, tok.kind))) ||
+                (str.contains(tok.to) &&
+                 str.contains(memberTokenRegExp(tok.to, tok.kind))))
+                return true;
+        }
+    }
+
+    for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+        if (memberTokensInText(*i, fw1, fw2, tokens, inside_member)) return true;
+
+    return false;
+}
+
+/*
+ * Generate files for the cluster member using files generated for
+ * another member that has been compiled already. Generated text is
+ * turned into a template by replacing names and addresses specific
+ * to the compiled member with placeholders; placeholders are then
+ * replaced with names and addresses of the member we specialize
+ * for. Substitution is only done when every occurrence of a token in
+ * the text can be the name or address of the compiled member put
+ * there by the compiler: tokens may not appear in any other object,
+ * in text copied from the objects (comments, labels, scripts) or in
+ * the configlets. Returns false if this can not be guaranteed or
+ * the members are too different for substitution to produce the same
+ * result as the compiler would; the caller should compile the member
+ * as usual in this case.
+ */
+bool CompilerDriver::specializeMember(Cluster *cluster,
+                                      Firewall *compiled_fw,
+                                      const QStringList &compiled_files,
+                                      Firewall *fw,
+                                      QStringList &member_files)
+{
+    if (!isMemberSpecializationSupported(cluster, compiled_fw, fw)) return false;
+
+    // names set with -O are not derived from the member name
+    if (member_file_names.contains(objdb->getStringId(compiled_fw->getId()).c_str()) ||
+        member_file_names.contains(objdb->getStringId(fw->getId()).c_str()))
+        return false;
+
+    QList<MemberToken> tokens;
+    if (!matchClusterMembers(cluster, compiled_fw, fw, tokens)) return false;
+    if (!memberTokensAreUnique(objdb, compiled_fw, fw, tokens)) return false;
+    if (memberTokensInText(objdb, compiled_fw, fw, tokens)) return false;
+    if (configletsContain(tokens)) return false;
+
+    // longer tokens go first so that the name of a member does not
+    // break up names of its addresses that include it
+    for (int i=0; i<tokens.size(); ++i)
+        for (int j=i+1; j<tokens.size(); ++j)
+            if (tokens[j].from.length() > tokens[i].from.length())
+                tokens.swap(i, j);
+
+    QStringList templates;
+    foreach(QString file_name, compiled_files)
+    {
+        QFile file(file_name);
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        QString text = QString::fromUtf8(file.readAll().constData());
+        file.close();
+
+        if (text.contains("@@FWB_MEMBER_TOKEN_")) return false;
+
+        for (int i=0; i<tokens.size(); ++i)
+            text.replace(memberTokenRegExp(tokens[i].from, tokens[i].kind),
+                         "\\1" + QString(MEMBER_TOKEN_PLACEHOLDER).arg(i));
+
+        // If names or addresses of the other member are still in the
+        // text, it refers to that member as a peer (for example in
+        // failover rules). Such text can not be specialized by
+        // substitution.
+        foreach(MemberToken tok, tokens)
+            if (text.contains(memberTokenRegExp(tok.to, tok.kind))) return false;
+
+        if (!substitutionKeepsOrder(text, tokens)) return false;
+
+        templates << text;
+    }
+
+    member_files.clear();
+    for (int f=0; f<templates.size(); ++f)
+    {
+        QString text = templates[f];
+        for (int i=0; i<tokens.size(); ++i)
+            text.replace(QString(MEMBER_TOKEN_PLACEHOLDER).arg(i), tokens[i].to);
+
+        QFileInfo compiled_file_info(compiled_files[f]);
+        QString base_name = compiled_file_info.fileName();
+        foreach(MemberToken tok, tokens)
+        {
+            if (tok.kind != 0) continue;
+            base_name.replace(memberTokenRegExp(tok.from, tok.kind),
+                              "\\1" + tok.to);
+        }
+        member_files << compiled_file_info.dir().filePath(base_name);
+        QString file_name = member_files.last();
+
+        info("Output file name: " + file_name.toStdString());
+        QFile file(file_name);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            QString err("Failed to open file %1 for writing: %2");
+            abort(err.arg(file_name).arg(file.error()).toStdString());
+        }
+        file.write(text.toUtf8());
+        file.close();
+        file.setPermissions(QFile(compiled_files[f]).permissions());
+    }
+
+    specialized_members << QString::fromUtf8(fw->getName().c_str());
+    info(" Generated by specialization of files compiled for member " +
+         compiled_fw->getName());
+    return true;
+}
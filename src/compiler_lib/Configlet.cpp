@@ -26,11 +26,14 @@
 #include "../../config.h"
 
 #include "Configlet.h"
+#include "ConfigletTemplate.h"
 
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/Resources.h"
 #include "fwbuilder/Constants.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
 #include <QRegExp>
 #include <QTextStream>
 #include <QDir>
@@ -52,6 +55,20 @@ bool Configlet::configlet_debugging = false;
 QString Configlet::begin_marker = "|||||||||||||||| Begin configlet %1";
 QString Configlet::end_marker = "|||||||||||||||| End configlet %1";
 
+/*
+ * Expand configlets using templates parsed once and cached by
+ * ConfigletTemplate. Unit tests turn this off to compare the result
+ * with expansion done by regular expressions.
+ */
+bool Configlet::use_precompiled_templates = true;
+
+/*
+ * Stream variables are substituted into the template as this
+ * character followed by the index of the stream and the same
+ * character again. Generated configuration never has it.
+ */
+static const char stream_marker = '\001';
+
 /*
  * @filename is a name of the configlet file. The program searches for
  * it in resources directory, subdirectory configlets/@prefix. If
@@ -98,6 +115,7 @@ Configlet::~Configlet()
 void Configlet::clear()
 {
     vars.clear();
+    stream_vars.clear();
     remove_comments = true;
     comment_str = "##";
     collapse_empty_strings = false;
@@ -111,23 +129,9 @@ bool Configlet::reload(const std::string &_prefix, const QString &file_name)
 
     file_path = getConfigletPath(file_name);
 
-    if (!QFile(file_path).exists())  return false;
-    else
-    {
-        QFile file(file_path);
-        if (file.open(QFile::ReadOnly))
-        {
-            QTextStream ts(&file);
-            do
-            {
-                QString line = ts.readLine();
-                code.push_back(line);
-            } while (!ts.atEnd());
-            removeComments();
-            return true;
-        }
-    }
-    return false;
+    if (!ConfigletTemplate::readFile(file_path, code)) return false;
+    removeComments();
+    return true;
 }
 
 QString Configlet::getFullPath(const QString &path)
@@ -157,6 +161,7 @@ QString Configlet::getConfigletPath(const QString &configlet_name)
 
 void Configlet::setVariable(const QString &name, const QString &value)
 {
+    stream_vars.remove(name);
     vars[name] = value.trimmed();
 }
 
@@ -164,10 +169,126 @@ void Configlet::setVariable(const QString &name, int value)
 {
     QString val;
     val.setNum(value);
+    stream_vars.remove(name);
     vars[name] = val;
 }
 
+void Configlet::setVariable(const QString &name,
+                            fwcompiler::ChunkedOutput *value, int indent)
+{
+    StreamVariable var;
+    var.stream = value;
+    var.indent = indent;
+    vars.remove(name);
+    stream_vars[name] = var;
+}
+
 QString Configlet::expand()
+{
+    if (stream_vars.isEmpty()) return expandText();
+
+    QMap<QString, QString> saved_vars = vars;
+    for (QMap<QString, StreamVariable>::iterator it=stream_vars.begin();
+         it!=stream_vars.end(); ++it)
+    {
+        fwcompiler::ChunkedOutput val;
+        val.appendTrimmed(*(it.value().stream), it.value().indent);
+        vars[it.key()] = QString::fromUtf8(val.str().c_str());
+    }
+    QString res = expandText();
+    vars = saved_vars;
+    return res;
+}
+
+void Configlet::expand(fwcompiler::ChunkedOutput &out)
+{
+    /*
+     * collapseEmptyStrings() has to remove empty lines from the text
+     * of the streams too, this can not be done without copying it.
+     */
+    if (stream_vars.isEmpty() || collapse_empty_strings)
+    {
+        QByteArray text = expand().toUtf8();
+        out.write(text.constData(), text.size());
+        return;
+    }
+
+    QMap<QString, QString> saved_vars = vars;
+    QList<StreamVariable> streams;
+    for (QMap<QString, StreamVariable>::iterator it=stream_vars.begin();
+         it!=stream_vars.end(); ++it)
+    {
+        vars[it.key()] = QString(QChar(stream_marker)) +
+            QString::number(streams.size()) + QChar(stream_marker);
+        streams.push_back(it.value());
+    }
+    QByteArray text = expandText().toUtf8();
+    vars = saved_vars;
+
+    int pos = 0;
+    int marker_pos;
+    while ((marker_pos = text.indexOf(stream_marker, pos)) != -1)
+    {
+        int marker_end = text.indexOf(stream_marker, marker_pos + 1);
+        if (marker_end == -1) break;
+        out.write(text.constData() + pos, marker_pos - pos);
+        int idx = text.mid(marker_pos + 1, marker_end - marker_pos - 1).toInt();
+        out.appendTrimmed(*(streams[idx].stream), streams[idx].indent);
+        pos = marker_end + 1;
+    }
+    out.write(text.constData() + pos, text.size() - pos);
+}
+
+QString Configlet::expandText()
+{
+    QString all_code;
+    bool precompiled = use_precompiled_templates;
+
+    /*
+     * Expansion by regular expressions substitutes values of
+     * variables into the text before it looks for {{if var}}, so
+     * macros inside of the values get expanded too. Precompiled
+     * template can not do this, use it only when values have no
+     * macros.
+     */
+    if (precompiled)
+    {
+        foreach(QString val, vars)
+        {
+            if (val.contains("{{"))
+            {
+                precompiled = false;
+                break;
+            }
+        }
+    }
+
+    if (!precompiled ||
+        !ConfigletTemplate::expandCached(file_path, remove_comments,
+                                         comment_str, vars, all_code))
+        all_code = expandVariables();
+
+    if (configlet_debugging)
+    {
+        all_code.push_front(begin_marker.arg(name) + "\n");
+        all_code.push_back(end_marker.arg(name) + "\n");
+    }
+
+    if (collapse_empty_strings)
+    {
+        QStringList res;
+        foreach(QString line, all_code.split("\n"))
+        {
+            if (line.trimmed().isEmpty()) continue;
+            res.push_back(line);
+        }
+        return res.join("\n");
+    }
+
+    return all_code;
+}
+
+QString Configlet::expandVariables()
 {
     // Need non-greedy matching so that if_re matches only one {{?var}} ... {{?}}
     // clause
@@ -219,23 +340,6 @@ QString Configlet::expand()
 
     if (counter >= 1000) qDebug() << err;
 
-    if (configlet_debugging)
-    {
-        all_code.push_front(begin_marker.arg(name) + "\n");
-        all_code.push_back(end_marker.arg(name) + "\n");
-    }
-
-    if (collapse_empty_strings)
-    {
-        QStringList res;
-        foreach(QString line, all_code.split("\n"))
-        {
-            if (line.trimmed().isEmpty()) continue;
-            res.push_back(line);
-        }
-        return res.join("\n");
-    }
-
     return all_code;
 }
 
@@ -34,10 +34,24 @@ namespace libfwbuilder {
     class FWObject;
 };
 
+namespace fwcompiler {
+    class ChunkedOutput;
+};
+
 
 class Configlet {
 
     bool processIf(QString &stream, int pos);
+    QString expandVariables();
+    QString expandText();
+
+    class StreamVariable
+    {
+        public:
+        fwcompiler::ChunkedOutput *stream;
+        int indent;
+    };
+    QMap<QString, StreamVariable> stream_vars;
     
 protected:
 
@@ -51,6 +65,7 @@ protected:
     bool collapse_empty_strings;
 
     static bool configlet_debugging;
+    static bool use_precompiled_templates;
     static QString begin_marker;
     static QString end_marker;
     
@@ -72,8 +87,22 @@ public:
     void setVariable(const QString &name, const QString &value);
     void setVariable(const QString &name, int value);
 
+    /*
+     * Value of this variable is text of the stream. The stream is not
+     * copied and must exist until the configlet is expanded. Each
+     * line of the text but the first is indented by @indent spaces.
+     */
+    void setVariable(const QString &name, fwcompiler::ChunkedOutput *value,
+                     int indent=0);
+
     QString expand();
 
+    /*
+     * Adds expanded configlet to the end of @out. Text of stream
+     * variables is not copied, it is added to @out by reference.
+     */
+    void expand(fwcompiler::ChunkedOutput &out);
+
     void removeComments(const QString &comment_str="##");
     void collapseEmptyStrings(bool f);
 
@@ -81,6 +110,8 @@ public:
      * the following methods are used in unit tests
      */
     static void setDebugging(bool f) { configlet_debugging = f; }
+    static void setPrecompiledTemplates(bool f)
+    { use_precompiled_templates = f; }
     static QString findGeneratedText(const QString &configlet_name,
                                      const QString &text,
                                      int nth=1);
@@ -0,0 +1,290 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+
+#include "ConfigletTemplate.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+
+
+class ConfigletCacheEntry
+{
+public:
+    QDateTime mtime;
+    qint64 size;
+    QStringList code;
+    // key: comment string with "1" in front if comments are removed
+    // or "0" if they are not
+    QMap<QString, ConfigletTemplate*> templates;
+
+    ~ConfigletCacheEntry() { qDeleteAll(templates); }
+};
+
+/*
+ * The cache is shared by all compilers running in the process, the
+ * GUI may run several of them in parallel threads. Templates are
+ * deleted when the file changes, so they are only used with the
+ * mutex locked.
+ */
+static QHash<QString, ConfigletCacheEntry*> configlet_cache;
+static QMutex configlet_cache_mutex;
+
+
+ConfigletTemplate::ConfigletTemplate(const QString &text)
+{
+    parse(text, 0, nodes, false);
+}
+
+ConfigletTemplate::~ConfigletTemplate()
+{
+    qDeleteAll(nodes);
+}
+
+/*
+ * Parses text starting at @pos and adds nodes to @nodes. Returns
+ * position right after {{endif}} that closes current if statement if
+ * @inside_if is true, or -1 when it reaches the end of the text. Syntax
+ * of the macros is the same as the regular expressions in
+ * Configlet::expand() and Configlet::processIf() accept: variable
+ * name is everything up to the first '}', there is exactly one space
+ * between "if" and the name of the variable, the rest of spaces
+ * belong to the name.
+ */
+int ConfigletTemplate::parse(const QString &text, int pos,
+                             QList<Node*> &nodes, bool inside_if)
+{
+    int len = text.length();
+    int literal_start = pos;
+
+    while (pos < len)
+    {
+        pos = text.indexOf("{{", pos);
+        if (pos == -1) break;
+
+        int macro_start = pos;
+        int name_start = -1;
+        Node::NodeType type = Node::TEXT;
+
+        if (text.midRef(pos + 2, 1) == QLatin1String("$"))
+        {
+            type = Node::VARIABLE;
+            name_start = pos + 3;
+        } else if (text.midRef(pos + 2, 3) == QLatin1String("if "))
+        {
+            type = Node::IF;
+            name_start = pos + 5;
+        } else if (text.midRef(pos + 2, 7) == QLatin1String("endif}}"))
+        {
+            if (inside_if)
+            {
+                if (macro_start > literal_start)
+                    nodes.push_back(
+                        new Node(Node::TEXT,
+                                 text.mid(literal_start,
+                                          macro_start - literal_start)));
+                return macro_start + 9;
+            }
+            // stray {{endif}} is just text
+            pos += 9;
+            continue;
+        }
+
+        int name_end = (name_start == -1) ? -1 : text.indexOf('}', name_start);
+        if (name_end == -1 || text.midRef(name_end, 2) != QLatin1String("}}") ||
+            (type == Node::IF && name_end == name_start))
+        {
+            // not a macro, "{{" can be followed by another "{{"
+            pos++;
+            continue;
+        }
+
+        if (macro_start > literal_start)
+            nodes.push_back(
+                new Node(Node::TEXT,
+                         text.mid(literal_start, macro_start - literal_start)));
+
+        Node *node = new Node(type,
+                              text.mid(name_start, name_end - name_start));
+        pos = name_end + 2;
+
+        if (type == Node::IF)
+        {
+            pos = parse(text, pos, node->children, true);
+            if (pos == -1)
+            {
+                // if statement without {{endif}} stays in the text,
+                // if statements inside of it are processed
+                QString if_text = text.mid(macro_start,
+                                           name_end + 2 - macro_start);
+                nodes.push_back(new Node(Node::TEXT, if_text));
+                nodes.append(node->children);
+                node->children.clear();
+                delete node;
+                return -1;
+            }
+        }
+
+        nodes.push_back(node);
+        literal_start = pos;
+    }
+
+    if (len > literal_start)
+        nodes.push_back(new Node(Node::TEXT, text.mid(literal_start)));
+
+    return -1;
+}
+
+void ConfigletTemplate::expandNodes(const QList<Node*> &nodes,
+                                    const QMap<QString, QString> &vars,
+                                    QString &res)
+{
+    foreach(Node *node, nodes)
+    {
+        switch (node->type)
+        {
+        case Node::TEXT:
+            res.append(node->text);
+            break;
+
+        case Node::VARIABLE:
+        {
+            QMap<QString, QString>::const_iterator it = vars.find(node->text);
+            if (it != vars.end()) res.append(it.value());
+            else
+            {
+                // template has a variable that has not been defined
+                res.append("{{");
+                res.append(node->text);
+                res.append("}}");
+            }
+            break;
+        }
+
+        case Node::IF:
+        {
+            QMap<QString, QString>::const_iterator it = vars.find(node->text);
+            if (it != vars.end())
+            {
+                bool ok = false;
+                int f = it.value().toInt(&ok);
+                if (ok && f) expandNodes(node->children, vars, res);
+            }
+            break;
+        }
+        }
+    }
+}
+
+QString ConfigletTemplate::expand(const QMap<QString, QString> &vars) const
+{
+    QString res;
+    expandNodes(nodes, vars, res);
+    return res;
+}
+
+bool ConfigletTemplate::readFile(const QString &file_path, QStringList &code)
+{
+    QFileInfo fi(file_path);
+    if (!fi.exists()) return false;
+
+    QMutexLocker locker(&configlet_cache_mutex);
+
+    ConfigletCacheEntry *entry = configlet_cache.value(file_path, NULL);
+    if (entry != NULL &&
+        entry->mtime == fi.lastModified() && entry->size == fi.size())
+    {
+        code = entry->code;
+        return true;
+    }
+
+    QFile file(file_path);
+    if (!file.open(QFile::ReadOnly)) return false;
+
+    delete entry;
+    entry = new ConfigletCacheEntry();
+    entry->mtime = fi.lastModified();
+    entry->size = fi.size();
+
+    QTextStream ts(&file);
+    do
+    {
+        QString line = ts.readLine();
+        entry->code.push_back(line);
+    } while (!ts.atEnd());
+
+    configlet_cache[file_path] = entry;
+    code = entry->code;
+    return true;
+}
+
+bool ConfigletTemplate::expandCached(const QString &file_path,
+                                     bool remove_comments,
+                                     const QString &comment_str,
+                                     const QMap<QString, QString> &vars,
+                                     QString &res)
+{
+    QMutexLocker locker(&configlet_cache_mutex);
+
+    ConfigletCacheEntry *entry = configlet_cache.value(file_path, NULL);
+    if (entry == NULL) return false;
+
+    QString key = (remove_comments) ? "1" + comment_str : QString("0");
+    ConfigletTemplate *tmpl = entry->templates.value(key, NULL);
+    if (tmpl != NULL)
+    {
+        res = tmpl->expand(vars);
+        return true;
+    }
+
+    QString all_code;
+    if (remove_comments)
+    {
+        QStringList res;
+        foreach(QString line, entry->code)
+        {
+            if (line.startsWith(comment_str)) continue;
+            res.push_back(line);
+        }
+        all_code = res.join("\n");
+    } else
+        all_code = entry->code.join("\n");
+
+    tmpl = new ConfigletTemplate(all_code);
+    entry->templates[key] = tmpl;
+    res = tmpl->expand(vars);
+    return true;
+}
+
+void ConfigletTemplate::clearCache()
+{
+    QMutexLocker locker(&configlet_cache_mutex);
+    qDeleteAll(configlet_cache);
+    configlet_cache.clear();
+}
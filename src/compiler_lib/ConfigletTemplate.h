@@ -0,0 +1,100 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __CONFIGLET_TEMPLATE_HH__
+#define __CONFIGLET_TEMPLATE_HH__
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QList>
+#include <QtAlgorithms>
+
+
+/**
+ * Configlet text parsed into a tree of literal text, {{$var}} and
+ * {{if var}} ... {{endif}} nodes. Parsing happens once per file,
+ * expansion walks the tree and appends to the result without
+ * searching the text again. Unmatched {{if}} and {{endif}} stay in the
+ * output as literal text, undefined variables {{$var}} turn into
+ * {{var}}, same as in Configlet::expand()
+ *
+ * Files and parsed templates are cached for the lifetime of the
+ * process, keyed on the file path. Cached entry is dropped if
+ * modification time or size of the file changes.
+ */
+class ConfigletTemplate
+{
+    class Node
+    {
+public:
+        enum NodeType { TEXT, VARIABLE, IF };
+
+        NodeType type;
+        // literal text or name of the variable
+        QString text;
+        // body of the if statement
+        QList<Node*> children;
+
+        Node(NodeType t, const QString &s) { type = t; text = s; }
+        ~Node() { qDeleteAll(children); }
+    };
+
+    QList<Node*> nodes;
+
+    static int parse(const QString &text, int pos, QList<Node*> &nodes,
+                     bool inside_if);
+    static void expandNodes(const QList<Node*> &nodes,
+                            const QMap<QString, QString> &vars,
+                            QString &res);
+
+public:
+
+    ConfigletTemplate(const QString &text);
+    ~ConfigletTemplate();
+
+    QString expand(const QMap<QString, QString> &vars) const;
+
+    /**
+     * Reads configlet file into @code, one item per line, using cached
+     * copy if the file has not changed. Returns false if the file
+     * does not exist or can not be opened.
+     */
+    static bool readFile(const QString &file_path, QStringList &code);
+
+    /**
+     * Expands parsed template for the file previously read by
+     * readFile(), with lines that start with @comment_str removed if
+     * @remove_comments is true, and puts the result in @res. Returns
+     * false if the file is not in the cache.
+     */
+    static bool expandCached(const QString &file_path,
+                             bool remove_comments,
+                             const QString &comment_str,
+                             const QMap<QString, QString> &vars,
+                             QString &res);
+
+    static void clearCache();
+};
+
+#endif
@@ -11,7 +11,10 @@ SOURCES	 =  CompilerDriver.cpp \
 			CompilerDriver_files.cpp \
 			CompilerDriver_compile.cpp \
 			CompilerDriver_generators.cpp \
+			CompilerDriver_prune.cpp \
+			CompilerDriver_specialize.cpp \
 			Configlet.cpp \
+			ConfigletTemplate.cpp \
 			interfaceProperties.cpp \
 			linux24Interfaces.cpp \
 			openbsdInterfaces.cpp \
@@ -27,6 +30,7 @@ SOURCES	 =  CompilerDriver.cpp \
 HEADERS	 = ../../config.h \
 			CompilerDriver.h \
 			Configlet.h \
+			ConfigletTemplate.h \
 			interfaceProperties.h \
 			linux24Interfaces.h \
 			openbsdInterfaces.h \
@@ -58,7 +58,7 @@ using namespace std;
 using namespace libfwbuilder;
 
 IOSImporter::IOSImporter(FWObject *lib,
-                         std::istringstream &input,
+                         std::istream &input,
                          Logger *log,
                          const std::string &fwname) : Importer(lib, "iosacl", input, log, fwname)
 {
@@ -58,7 +58,7 @@ protected:
 public:
 
     IOSImporter(libfwbuilder::FWObject *lib,
-                std::istringstream &input,
+                std::istream &input,
                 libfwbuilder::Logger *log,
                 const std::string &fwname);
     ~IOSImporter();
@@ -67,7 +67,7 @@ extern QString findBestVersionMatch(const QString &platform,
 
 
 IPTImporter::IPTImporter(FWObject *lib,
-                         std::istringstream &input,
+                         std::istream &input,
                          Logger *log,
                          const std::string &fwname) : Importer(lib, "iptables", input, log, fwname)
 {
@@ -577,7 +577,7 @@ PolicyRule* IPTImporter::createPolicyBranch(
 
     FWObjectDatabase *dbroot = getFirewallObject()->getRoot();
     PolicyRule *new_rule = PolicyRule::cast(dbroot->create(PolicyRule::TYPENAME));
-    rs->ruleset->add(new_rule);
+    appendRule(rs->ruleset, new_rule);
 
     new_rule->duplicate(rule);
 
@@ -630,7 +630,7 @@ NATRule* IPTImporter::createNATBranch(
 
     FWObjectDatabase *dbroot = getFirewallObject()->getRoot();
     NATRule *new_rule = NATRule::cast(dbroot->create(NATRule::TYPENAME));
-    rs->ruleset->add(new_rule);
+    appendRule(rs->ruleset, new_rule);
 
     new_rule->duplicate(rule);
 
@@ -667,6 +667,20 @@ NATRule* IPTImporter::createNATBranch(
     return new_rule;
 }
 
+/*
+ * Adds rule at the bottom of the rule set. Rules are always appended
+ * during import, so the new rule gets position right after the last
+ * one instead of renumbering the whole rule set every time, which
+ * made import of large configurations quadratic. All rule sets are
+ * renumbered once more in finalize().
+ */
+void IPTImporter::appendRule(RuleSet *ruleset, Rule *rule)
+{
+    Rule *last = (ruleset->empty()) ? NULL : Rule::cast(ruleset->back());
+    ruleset->add(rule);
+    rule->setPosition((last) ? last->getPosition() + 1 : 0);
+}
+
 
 void IPTImporter::pushRule()
 {
@@ -1119,10 +1133,7 @@ void IPTImporter::pushPolicyRule()
         assert(rs!=NULL);
         ruleset = rs->ruleset;
 
-        ruleset->add(current_rule);
-
-        // renumber to clean-up rule positions
-        ruleset->renumberRules();
+        appendRule(ruleset, current_rule);
 
         rule->setDirection(PolicyRule::Both);
 
@@ -1485,17 +1496,14 @@ void IPTImporter::pushNATRule()
         ruleset = RuleSet::cast(
             getFirewallObject()->getFirstByType(NAT::TYPENAME));
         assert(ruleset!=NULL);
-        ruleset->add(current_rule);
     } else
     {
         UnidirectionalRuleSet *rs = getUnidirRuleSet(current_chain, NAT::TYPENAME);
         assert(rs!=NULL);
-        rs->ruleset->add(current_rule);
         ruleset = rs->ruleset;
     }
 
-    // renumber to clean-up rule positions
-    ruleset->renumberRules();
+    appendRule(ruleset, current_rule);
 
     addStandardImportComment(current_rule, QString::fromUtf8(rule_comment.c_str()));
 
@@ -80,6 +80,8 @@ class IPTImporter : public Importer
         libfwbuilder::NATRule *rule, const std::string &branch_name,
         bool clear_rule_elements);
 
+    void appendRule(libfwbuilder::RuleSet *ruleset, libfwbuilder::Rule *rule);
+
     public:
 
     int service_group_name_seed;
@@ -138,7 +140,7 @@ class IPTImporter : public Importer
     libfwbuilder::PolicyRule *last_mark_rule;
     
     IPTImporter(libfwbuilder::FWObject *lib,
-                std::istringstream &input,
+                std::istream &input,
                 libfwbuilder::Logger *log,
                 const std::string &fwname);
     ~IPTImporter();
@@ -26,6 +26,7 @@
 #include "../../config.h"
 
 #include "IPTImporter.h"
+#include "LineFilterStream.h"
 
 #include <QString>
 #include <QStringList>
@@ -47,24 +48,7 @@ extern int fwbdebug;
 using namespace std;
 
 /*
- * Only this module depends on IPTCfgLexer and IPTCfgParser,
- * so only this file is recompiled when we change grammar
- */
-
-void IPTImporter::run()
-{
-// it is probably safer to create an empty firewall if we do not have
-// ANTLR on the system rather than try to #ifdef out chunks of code
-// here and there in this module
-//
-// Obviously we should disable GUI elements that activate this importer
-// if ANTLR runtime is not available.
-//
-
-    QStringList err;
-    ostringstream parser_debug;
-
-/* Do a bit of preprocessing of the input to simplify crazy grammar. String
+ * Do a bit of preprocessing of the input to simplify crazy grammar. String
  * operations are easier to do with Qt QString class.
  *
  * Do the following (will add more stuff here in the future):
@@ -78,23 +62,29 @@ void IPTImporter::run()
  *    modules tcp and udp it is port1[:port2]. This makes grammar difficult
  *    to write. Need to convert parameters to the unique long form before
  *    passing script to antlr
+ *
+ * Lines are processed one at a time as the lexer reads them, so the
+ * input does not have to be loaded into memory. Most lines of a large
+ * iptables-save file need no changes and are passed through as they
+ * are without conversion to QString.
  */
-    input.seekg (0, ios::end);
-    size_t input_size = input.tellg();
-    string normalized_input_buffer;
-    normalized_input_buffer.reserve(input_size);
+class IPTInputFilter : public LineFilter
+{
+    QRegExp old_negation_short;
+    QRegExp old_negation_long;
 
-    QRegExp old_negation_short("(-[^- ])\\s!");
-    QRegExp old_negation_long("(--[^- ]+)\\s!");
+public:
+    IPTInputFilter() :
+        old_negation_short("(-[^- ])\\s!"),
+        old_negation_long("(--[^- ]+)\\s!") {}
 
-    input.seekg (0, ios::beg);
-    char buf[8192];
-    while (!input.eof())
+    virtual void filter(string &line)
     {
-        input.getline(buf, sizeof(buf)-1);
+        bool multiport = (line.find("-m multiport") != string::npos);
+        if (!multiport && line.find('!') == string::npos) return;
 
-        QString str(buf);
-        if (str.contains("-m multiport"))
+        QString str(line.c_str());
+        if (multiport)
         {
             str.replace("--sports", "--source-ports");
             str.replace("--sport", "--source-ports");
@@ -133,13 +123,30 @@ void IPTImporter::run()
             pos = old_pos + match_length;
         }
 
-        normalized_input_buffer.append(str.toStdString());
-        normalized_input_buffer.append("\n");
+        line = str.toStdString();
     }
+};
+
+/*
+ * Only this module depends on IPTCfgLexer and IPTCfgParser,
+ * so only this file is recompiled when we change grammar
+ */
+
+void IPTImporter::run()
+{
+// it is probably safer to create an empty firewall if we do not have
+// ANTLR on the system rather than try to #ifdef out chunks of code
+// here and there in this module
+//
+// Obviously we should disable GUI elements that activate this importer
+// if ANTLR runtime is not available.
+//
 
-    assert(normalized_input_buffer.length() > 0);
+    QStringList err;
+    ostringstream parser_debug;
 
-    istringstream  normalized_input(normalized_input_buffer);
+    IPTInputFilter input_filter;
+    LineFilterStream normalized_input(input, &input_filter);
 
     IPTCfgLexer lexer(normalized_input);
     IPTCfgParser parser(lexer);
@@ -118,7 +118,7 @@ void Importer::SaveTmpPortToDst()
 
 Importer::Importer(FWObject *_lib,
                    const std::string &_platform,
-                   std::istringstream &_input,
+                   std::istream &_input,
                    Logger *log,
                    const std::string &fwname) : input(_input)
 {
@@ -117,7 +117,7 @@ protected:
     libfwbuilder::FWObject *library;
 
     std::string input_file_name;
-    std::istringstream &input;
+    std::istream &input;
     
     std::string platform;
 
@@ -287,7 +287,7 @@ public:
     
     Importer(libfwbuilder::FWObject *lib,
              const std::string      &platform,
-             std::istringstream     &input,
+             std::istream           &input,
              libfwbuilder::Logger   *log,
              const std::string &fwname);
     virtual ~Importer();
@@ -0,0 +1,74 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "LineFilterStream.h"
+
+using namespace std;
+
+
+LineFilterStreamBuf::LineFilterStreamBuf(istream &src, LineFilter *filter) :
+    source(src)
+{
+    line_filter = filter;
+    setg(NULL, NULL, NULL);
+}
+
+LineFilterStreamBuf::int_type LineFilterStreamBuf::underflow()
+{
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    if (!getline(source, line)) return traits_type::eof();
+
+    if (line_filter) line_filter->filter(line);
+    line.append("\n");
+
+    char *b = &line[0];
+    setg(b, b, b + line.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+LineFilterStreamBuf::pos_type LineFilterStreamBuf::seekoff(
+    off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+    if (dir != ios_base::beg) return pos_type(off_type(-1));
+    return seekpos(pos_type(off), which);
+}
+
+LineFilterStreamBuf::pos_type LineFilterStreamBuf::seekpos(
+    pos_type pos, ios_base::openmode which)
+{
+    if (pos != pos_type(0) || (which & ios_base::in) == 0)
+        return pos_type(off_type(-1));
+
+    source.clear();
+    if (!source.seekg(0, ios::beg)) return pos_type(off_type(-1));
+
+    setg(NULL, NULL, NULL);
+    return pos;
+}
+
+LineFilterStream::LineFilterStream(istream &src, LineFilter *filter) :
+    istream(NULL), buf(src, filter)
+{
+    rdbuf(&buf);
+}
@@ -0,0 +1,76 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef _LINE_FILTER_STREAM_H_
+#define _LINE_FILTER_STREAM_H_
+
+#include <istream>
+#include <streambuf>
+#include <string>
+
+
+/*
+ * Importers do some preprocessing of the configuration before it is
+ * passed to the lexer. LineFilter modifies one line of the input at a
+ * time, the line does not include the end of line character.
+ */
+class LineFilter
+{
+public:
+    virtual ~LineFilter() {}
+    virtual void filter(std::string &line) = 0;
+};
+
+/*
+ * Stream buffer that reads source stream line by line and passes
+ * each line through the filter as the lexer consumes the input. This
+ * way preprocessed configuration is never held in memory as a whole
+ * and import of a large file does not need a copy of it. The only
+ * supported seek operation is rewinding to the beginning, importers
+ * that make two passes over the input need it.
+ */
+class LineFilterStreamBuf : public std::streambuf
+{
+    std::istream &source;
+    LineFilter *line_filter;
+    std::string line;
+
+protected:
+    virtual int_type underflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+public:
+    LineFilterStreamBuf(std::istream &src, LineFilter *filter);
+};
+
+class LineFilterStream : public std::istream
+{
+    LineFilterStreamBuf buf;
+
+public:
+    LineFilterStream(std::istream &src, LineFilter *filter);
+};
+
+#endif
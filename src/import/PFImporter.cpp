@@ -71,7 +71,7 @@ using namespace libfwbuilder;
 
 
 PFImporter::PFImporter(FWObject *lib,
-                         std::istringstream &input,
+                         std::istream &input,
                          Logger *log,
                          const std::string &fwname) :
     Importer(lib, "pf", input, log, fwname)
@@ -134,7 +134,7 @@ public:
     bool scrub_rule;
 
     PFImporter(libfwbuilder::FWObject *lib,
-                std::istringstream &input,
+                std::istream &input,
                 libfwbuilder::Logger *log,
                 const std::string &fwname);
     ~PFImporter();
@@ -67,7 +67,7 @@ using namespace libfwbuilder;
 
 
 PIXImporter::PIXImporter(FWObject *lib,
-                         std::istringstream &input,
+                         std::istream &input,
                          Logger *log,
                          const std::string &fwname) :
     IOSImporter(lib, input, log, fwname)
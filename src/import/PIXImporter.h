@@ -112,7 +112,7 @@ public:
     std::map<int, std::list<GlobalPool> > global_pools;
     
     PIXImporter(libfwbuilder::FWObject *lib,
-                std::istringstream &input,
+                std::istream &input,
                 libfwbuilder::Logger *log,
                 const std::string &fwname);
     ~PIXImporter();
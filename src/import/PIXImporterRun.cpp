@@ -26,9 +26,12 @@
 #include "../../config.h"
 
 #include "PIXImporter.h"
+#include "LineFilterStream.h"
 
 #include <QString>
 #include <QStringList>
+#include <QHash>
+#include <QtAlgorithms>
 #include <QRegExp>
 #include <QtDebug>
 
@@ -46,6 +49,75 @@ extern int fwbdebug;
 using namespace std;
 
 
+/*
+ * Replaces names defined with "name" commands with addresses. This
+ * does the same as replacing regular expression "\bname\b" for
+ * every name, but scans each line once no matter how many names
+ * there are. At each word boundary we look for the longest name that
+ * starts there and ends at another word boundary.
+ */
+class PIXNamesFilter : public LineFilter
+{
+    QHash<QString, QString> named_addresses;
+    QList<int> name_lengths;
+
+    static bool isWordChar(const QChar &c)
+    {
+        return c.isLetterOrNumber() || c.isMark() || c == '_';
+    }
+
+    static bool isWordBoundary(const QString &str, int pos)
+    {
+        bool before = (pos > 0 && isWordChar(str[pos - 1]));
+        bool after = (pos < str.length() && isWordChar(str[pos]));
+        return before != after;
+    }
+
+public:
+    void addName(const QString &name, const QString &address)
+    {
+        named_addresses[name] = address;
+        if (!name_lengths.contains(name.length()))
+        {
+            name_lengths.append(name.length());
+            qSort(name_lengths.begin(), name_lengths.end(), qGreater<int>());
+        }
+    }
+
+    virtual void filter(string &line)
+    {
+        if (named_addresses.isEmpty()) return;
+        if (line.compare(0, 5, "name ") == 0) return;
+
+        QString str(line.c_str());
+        QString res;
+        bool changed = false;
+        int pos = 0;
+        while (pos < str.length())
+        {
+            bool found = false;
+            if (isWordBoundary(str, pos))
+            {
+                foreach (int len, name_lengths)
+                {
+                    if (pos + len > str.length()) continue;
+                    if (!isWordBoundary(str, pos + len)) continue;
+                    QHash<QString, QString>::iterator it =
+                        named_addresses.find(str.mid(pos, len));
+                    if (it == named_addresses.end()) continue;
+                    res.append(it.value());
+                    pos += len;
+                    found = changed = true;
+                    break;
+                }
+            }
+            if (!found) res.append(str[pos++]);
+        }
+
+        if (changed) line = res.toStdString();
+    }
+};
+
 /*
  * Only this module depends on PIXCfgLexer and PIXCfgParser,
  * so only this file is recompiled when we change grammar
@@ -65,47 +137,29 @@ void PIXImporter::run()
  * - process "names" section: isolate "name" commands and build
  *   dictionary of names and addresses, then scan input file and
  *   replace names with addresses everywhere.
+ *
+ * The first pass only collects names, the second pass feeds the
+ * lexer through the filter that replaces them, so the configuration
+ * is never loaded into memory as a whole.
  */
 
-    QMap<QString, QString> named_addresses;
-    QStringList whole_input;
+    PIXNamesFilter names_filter;
 
     input.seekg (0, ios::beg);
-    char buf[8192];
-    while (!input.eof())
-    {
-        input.getline(buf, sizeof(buf)-1);
-        whole_input.append(QString(buf));
-    }
-
-    foreach(QString str, whole_input)
+    string line;
+    while (getline(input, line))
     {
-        if (str.startsWith("name "))
+        if (line.compare(0, 5, "name ") == 0)
         {
-            QStringList items = str.split(" ");
-            named_addresses[items[2]] = items[1];
+            QStringList items = QString(line.c_str()).split(" ");
+            names_filter.addName(items[2], items[1]);
         }
     }
 
-    QStringList normalized_input_buffer;
-
-    foreach(QString str, whole_input)
-    {
-        if ( ! str.startsWith("name "))
-        {
-            QMap<QString, QString>::iterator it;
-            for (it=named_addresses.begin(); it!=named_addresses.end(); ++it)
-            {
-                QString re("\\b%1\\b");
-                str.replace(QRegExp(re.arg(it.key())), it.value());
-            }
-        }
-
-        normalized_input_buffer.append(str);
-    }
+    input.clear();
+    input.seekg (0, ios::beg);
 
-    istringstream  normalized_input(
-        normalized_input_buffer.join("\n").toStdString());
+    LineFilterStream normalized_input(input, &names_filter);
 
     PIXCfgLexer lexer(normalized_input);
     PIXCfgParser parser(lexer);
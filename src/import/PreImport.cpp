@@ -58,110 +58,103 @@ public:
 };
 
 
-void PreImport::scan()
+/*
+ * Regular expressions used to recognize the platform. These are
+ * compiled once per scan. QRegExp keeps match state in the object,
+ * so they must not be shared between PreImport objects that may run
+ * in different threads. Each list is checked in this order, if
+ * several lists match the same line, the last one wins (FWSM config
+ * matches both PIX and FWSM patterns).
+ */
+class PlatformMatchers
 {
+public:
     QList<QRegExp> pix_re;
-    pix_re << QRegExp("^ASA Version")
-           << QRegExp("^PIX Version")
-           << QRegExp("^FWSM Version")
-           << QRegExp("^nat \\(\\S+,\\S+\\)")
-           << QRegExp("^static \\(\\S+,\\S+\\)")
-           << QRegExp("^global \\(")
-           << QRegExp("^nameif \\S+")
-           << QRegExp("^fixup \\S+");
-
     QList<QRegExp> fwsm_re;
-    fwsm_re << QRegExp("^FWSM Version");
-
     QList<QRegExp> ios_re;
-    ios_re << QRegExp("IOS Version")
-           << QRegExp("^[vV]ersion 1[012]\\..*");
-
     QList<QRegExp> iptables_re;
-    iptables_re << QRegExp("# Generated by iptables-save")
-                << QRegExp("^:INPUT ")
-                << QRegExp("^:OUTPUT ")
-                << QRegExp("^:FORWARD ")
-                << QRegExp("^-A INPUT ")
-                << QRegExp("^-A OUTPUT ")
-                << QRegExp("^-A FORWARD ");
-            
     QList<QRegExp> iptables_with_counters_re;
-    iptables_with_counters_re << QRegExp("^\\[\\d+:\\d+\\] -A INPUT ")
-                              << QRegExp("^\\[\\d+:\\d+\\] -A OUTPUT ")
-                              << QRegExp("^\\[\\d+:\\d+\\] -A FORWARD ");
-
     QList<QRegExp> pf_conf_re;
-    pf_conf_re << QRegExp("^scrub\\s+\\S+")
-               << QRegExp("^set\\s+timeout\\s+\\S+")
-               << QRegExp("^pass\\s+")
-               << QRegExp("^block\\s+")
-               << QRegExp("^nat\\s+(?!\\()")
-               << QRegExp("^rdr\\s+(?!\\()")
-               << QRegExp("^table\\s+<\\S+>\\s+");
 
+    PlatformMatchers()
+    {
+        pix_re << QRegExp("^ASA Version")
+               << QRegExp("^PIX Version")
+               << QRegExp("^FWSM Version")
+               << QRegExp("^nat \\(\\S+,\\S+\\)")
+               << QRegExp("^static \\(\\S+,\\S+\\)")
+               << QRegExp("^global \\(")
+               << QRegExp("^nameif \\S+")
+               << QRegExp("^fixup \\S+");
+
+        fwsm_re << QRegExp("^FWSM Version");
+
+        ios_re << QRegExp("IOS Version")
+               << QRegExp("^[vV]ersion 1[012]\\..*");
+
+        iptables_re << QRegExp("# Generated by iptables-save")
+                    << QRegExp("^:INPUT ")
+                    << QRegExp("^:OUTPUT ")
+                    << QRegExp("^:FORWARD ")
+                    << QRegExp("^-A INPUT ")
+                    << QRegExp("^-A OUTPUT ")
+                    << QRegExp("^-A FORWARD ");
+
+        // iptables-save -c prints counters in front of every rule,
+        // we do not have to wait for the rule in a standard chain
+        iptables_with_counters_re << QRegExp("^\\[\\d+:\\d+\\] -A \\S+ ");
+
+        pf_conf_re << QRegExp("^scrub\\s+\\S+")
+                   << QRegExp("^set\\s+timeout\\s+\\S+")
+                   << QRegExp("^pass\\s+")
+                   << QRegExp("^block\\s+")
+                   << QRegExp("^nat\\s+(?!\\()")
+                   << QRegExp("^rdr\\s+(?!\\()")
+                   << QRegExp("^table\\s+<\\S+>\\s+");
+    }
 
-    foreach (QString line, *buffer)
+    static bool matches(const QList<QRegExp> &re_list, const QString &line)
     {
-        if (platform == UNKNOWN)
+        foreach (const QRegExp &re, re_list)
         {
-            foreach (QRegExp re, pix_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = PIX;
-                    break;
-                }
-            }
-
-            foreach (QRegExp re, fwsm_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = FWSM;
-                    break;
-                }
-            }
+            if (re.indexIn(line) > -1) return true;
+        }
+        return false;
+    }
+};
 
-            foreach (QRegExp re, ios_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = IOSACL;
-                    break;
-                }
-            }
+/*
+ * Only the first max_lines lines are used to recognize the platform,
+ * all supported configuration formats can be identified by the first
+ * few commands. Checking every line of a very large file against all
+ * patterns takes a long time and gives nothing.
+ */
+void PreImport::scan()
+{
+    PlatformMatchers m;
 
-            foreach (QRegExp re, iptables_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = IPTABLES;
-                    break;
-                }
-            }
+    int line_count = 0;
+    foreach (const QString &line, *buffer)
+    {
+        if (max_lines > 0 && line_count++ >= max_lines) break;
 
-            foreach (QRegExp re, pf_conf_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = PF;
-                    break;
-                }
-            }
+        if (platform == UNKNOWN)
+        {
+            if (PlatformMatchers::matches(m.pix_re, line)) platform = PIX;
+            if (PlatformMatchers::matches(m.fwsm_re, line)) platform = FWSM;
+            if (PlatformMatchers::matches(m.ios_re, line)) platform = IOSACL;
+            if (PlatformMatchers::matches(m.iptables_re, line))
+                platform = IPTABLES;
+            if (PlatformMatchers::matches(m.pf_conf_re, line)) platform = PF;
         }
 
         if (platform == IPTABLES)
         {
-            foreach (QRegExp re, iptables_with_counters_re)
-            {
-                if (re.indexIn(line) > -1)
-                {
-                    platform = IPTABLES_WITH_COUNTERS;
-                    break;
-                }
-            }
+            if (PlatformMatchers::matches(m.iptables_with_counters_re, line))
+                platform = IPTABLES_WITH_COUNTERS;
         }
+
+        if (platform != UNKNOWN && platform != IPTABLES) break;
     }
 
     /*
@@ -43,6 +43,7 @@ public:
 class PreImport
 {
     const QStringList *buffer;
+    int max_lines;
 
 public:
 
@@ -55,7 +56,17 @@ private:
 
 public:
     
-    PreImport(const QStringList *buf) { buffer = buf; platform = UNKNOWN; }
+    /*
+     * platform is recognized by the first max_lines lines of the
+     * buffer, use 0 to scan all lines
+     */
+    PreImport(const QStringList *buf, int max_lines=10000)
+    {
+        buffer = buf;
+        this->max_lines = max_lines;
+        platform = UNKNOWN;
+    }
+
     void scan();
     enum Platforms getPlatform() { return platform; }
     QString getPlatformAsString();
@@ -7,6 +7,7 @@ TEMPLATE = lib
 
 SOURCES = QStringListOperators.cpp \
 	      PreImport.cpp \
+          LineFilterStream.cpp \
           objectMaker.cpp \
 		  objectSignature.cpp \
           addressObjectMaker.cpp \
@@ -26,6 +27,7 @@ SOURCES = QStringListOperators.cpp \
 
 HEADERS = QStringListOperators.h \
 	      PreImport.h \
+          LineFilterStream.h \
           objectMaker.h \
 		  objectSignature.h \
           addressObjectMaker.h \
@@ -86,18 +86,20 @@ void ObjectMaker::clear()
 
 FWObject* ObjectMaker::findMatchingObject(const ObjectSignature &sig)
 {
-    QString sig_str = sig.toString();
+    ObjectSignatureKey key(sig);
 
+    QHash<ObjectSignatureKey, int>::const_iterator it;
     if ( ! sig.object_name.isEmpty())
     {
-        if (named_object_registry.count(sig_str) > 0)
-            return library->getRoot()->findInIndex(
-                named_object_registry[sig_str]);
+        it = named_object_registry.find(key);
+        if (it != named_object_registry.end())
+            return library->getRoot()->findInIndex(it.value());
         return NULL;
     }
 
-    if (anon_object_registry.count(sig_str) > 0)
-        return library->getRoot()->findInIndex(anon_object_registry[sig_str]);
+    it = anon_object_registry.find(key);
+    if (it != anon_object_registry.end())
+        return library->getRoot()->findInIndex(it.value());
 
     return NULL;
 }
@@ -105,20 +107,19 @@ FWObject* ObjectMaker::findMatchingObject(const ObjectSignature &sig)
 void ObjectMaker::registerNamedObject(const ObjectSignature &sig,
                                       FWObject* obj)
 {
-    ObjectSignature anon_sig = sig;
-    anon_sig.object_name = "";
-    QString as = anon_sig.toString();
-    if (anon_object_registry.count(as) > 0) anon_object_registry.remove(as);
+    ObjectSignatureKey key(sig);
+    named_object_registry[key] = (obj!=NULL) ? obj->getId() : -1;
 
-    named_object_registry[sig.toString()] = (obj!=NULL) ? obj->getId() : -1;
+    key.object_name = "";
+    anon_object_registry.remove(key);
 }
 
 void ObjectMaker::registerAnonymousObject(const ObjectSignature &sig,
                                           FWObject* obj)
 {
-    ObjectSignature anon_sig = sig;
-    anon_sig.object_name = "";
-    anon_object_registry[anon_sig.toString()] = (obj!=NULL) ? obj->getId() : -1;
+    ObjectSignatureKey key(sig);
+    key.object_name = "";
+    anon_object_registry[key] = (obj!=NULL) ? obj->getId() : -1;
 }
 
 /*
@@ -33,6 +33,7 @@
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QPair>
 
 
@@ -107,8 +108,8 @@ protected:
     libfwbuilder::Library *library;
     libfwbuilder::FWObject *last_created;
 
-    QMap<QString, int> named_object_registry;
-    QMap<QString, int> anon_object_registry;
+    QHash<ObjectSignatureKey, int> named_object_registry;
+    QHash<ObjectSignatureKey, int> anon_object_registry;
 
     libfwbuilder::FWObject* findMatchingObject(const ObjectSignature &sig);
     void registerNamedObject(const ObjectSignature &sig,
@@ -797,6 +797,189 @@ QString ObjectSignature::toString() const
     return sig.join("||");
 }
 
+ObjectSignatureKey::ObjectSignatureKey(const ObjectSignature &sig)
+{
+    type_name = sig.type_name;
+    object_name = sig.object_name;
+
+    protocol = 0;
+    bool_flags = 0;
+    icmp_type = 0;
+    icmp_code = 0;
+    src_port_range_start = 0;
+    src_port_range_end = 0;
+    dst_port_range_start = 0;
+    dst_port_range_end = 0;
+
+    if (type_name == IPv4::TYPENAME || type_name == IPv6::TYPENAME ||
+        type_name == Network::TYPENAME || type_name == NetworkIPv6::TYPENAME ||
+        type_name == Address::TYPENAME)
+    {
+        address = sig.address;
+        netmask = sig.netmask;
+        return;
+    }
+
+    if (type_name == AddressRange::TYPENAME)
+    {
+        address_range_start = sig.address_range_start;
+        address_range_end = sig.address_range_end;
+        return;
+    }
+
+    if (type_name == AttachedNetworks::TYPENAME)
+    {
+        parent_interface_name = sig.parent_interface_name;
+        return;
+    }
+
+    if (type_name == DNSName::TYPENAME)
+    {
+        dns_name = sig.dns_name;
+        return;
+    }
+
+    if (type_name == AddressTable::TYPENAME)
+    {
+        address_table_name = sig.address_table_name;
+        return;
+    }
+
+    if (type_name == CustomService::TYPENAME)
+    {
+        platform = sig.platform;
+        code = sig.code;
+        protocol_name = sig.protocol_name;
+        return;
+    }
+
+    if (type_name == ICMPService::TYPENAME || type_name == ICMP6Service::TYPENAME)
+    {
+        icmp_type = sig.icmp_type;
+        icmp_code = sig.icmp_code;
+        return;
+    }
+
+    if (type_name == IPService::TYPENAME)
+    {
+        protocol = sig.protocol;
+        dscp = sig.dscp;
+        tos = sig.tos;
+        bool flags[] = { sig.fragments, sig.short_fragments, sig.any_opt,
+                         sig.lsrr, sig.ssrr, sig.rr, sig.ts,
+                         sig.rtralt, sig.rtralt_value };
+        for (unsigned int i=0; i<sizeof(flags)/sizeof(bool); ++i)
+            if (flags[i]) bool_flags |= (1 << i);
+        return;
+    }
+
+    if (type_name == TCPService::TYPENAME || type_name == UDPService::TYPENAME)
+    {
+        src_port_range_start = sig.src_port_range_start;
+        src_port_range_end = sig.src_port_range_end;
+        dst_port_range_start = sig.dst_port_range_start;
+        dst_port_range_end = sig.dst_port_range_end;
+        if (type_name == TCPService::TYPENAME)
+        {
+            if (sig.established) bool_flags = 1;
+            flags_mask = sig.flags_mask;
+            flags_comp = sig.flags_comp;
+        }
+        return;
+    }
+
+    if (type_name == TagService::TYPENAME)
+    {
+        tag = sig.tag;
+        return;
+    }
+
+    if (type_name == ServiceGroup::TYPENAME ||
+        type_name == ObjectGroup::TYPENAME)
+    {
+        group_children_ids = sig.group_children_ids;
+        return;
+    }
+
+    if (type_name == UserService::TYPENAME)
+    {
+        protocol_name = sig.protocol_name;
+        user_id = sig.user_id;
+        return;
+    }
+}
+
+bool ObjectSignatureKey::operator==(const ObjectSignatureKey &other) const
+{
+    return (protocol == other.protocol &&
+            bool_flags == other.bool_flags &&
+            icmp_type == other.icmp_type &&
+            icmp_code == other.icmp_code &&
+            src_port_range_start == other.src_port_range_start &&
+            src_port_range_end == other.src_port_range_end &&
+            dst_port_range_start == other.dst_port_range_start &&
+            dst_port_range_end == other.dst_port_range_end &&
+            type_name == other.type_name &&
+            object_name == other.object_name &&
+            address == other.address &&
+            netmask == other.netmask &&
+            address_range_start == other.address_range_start &&
+            address_range_end == other.address_range_end &&
+            dns_name == other.dns_name &&
+            address_table_name == other.address_table_name &&
+            parent_interface_name == other.parent_interface_name &&
+            dscp == other.dscp &&
+            tos == other.tos &&
+            flags_mask == other.flags_mask &&
+            flags_comp == other.flags_comp &&
+            platform == other.platform &&
+            protocol_name == other.protocol_name &&
+            code == other.code &&
+            tag == other.tag &&
+            user_id == other.user_id &&
+            group_children_ids == other.group_children_ids);
+}
+
+static inline void hashCombine(uint &h, uint v)
+{
+    h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+}
+
+uint qHash(const ObjectSignatureKey &key)
+{
+    uint h = qHash(key.type_name);
+    hashCombine(h, qHash(key.object_name));
+
+    hashCombine(h, qHash(key.address));
+    hashCombine(h, qHash(key.netmask));
+    hashCombine(h, qHash(key.address_range_start));
+    hashCombine(h, qHash(key.address_range_end));
+    hashCombine(h, qHash(key.dns_name));
+    hashCombine(h, qHash(key.address_table_name));
+    hashCombine(h, qHash(key.parent_interface_name));
+
+    hashCombine(h, key.protocol);
+    hashCombine(h, key.bool_flags);
+    hashCombine(h, key.icmp_type);
+    hashCombine(h, key.icmp_code);
+    hashCombine(h, key.src_port_range_start);
+    hashCombine(h, key.src_port_range_end);
+    hashCombine(h, key.dst_port_range_start);
+    hashCombine(h, key.dst_port_range_end);
+
+    foreach (int f, key.flags_mask) hashCombine(h, f);
+    foreach (int f, key.flags_comp) hashCombine(h, f);
+    foreach (int id, key.group_children_ids) hashCombine(h, id);
+
+    hashCombine(h, qHash(key.platform));
+    hashCombine(h, qHash(key.protocol_name));
+    hashCombine(h, qHash(key.code));
+    hashCombine(h, qHash(key.tag));
+    hashCombine(h, qHash(key.user_id));
+
+    return h;
+}
+
 void* ObjectSignature::dispatch(Network *obj, void*)
 {
     object_name = QString::fromUtf8(obj->getName().c_str());
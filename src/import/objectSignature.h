@@ -31,6 +31,7 @@
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QPair>
 
 
@@ -202,4 +203,60 @@ public:
     
 };
 
+/*
+ * Key used by ObjectMaker to find objects that match a signature.
+ * Only attributes that matter for the object type are copied from
+ * the signature, the rest keep default values, so two keys are equal
+ * if toString() of their signatures returns the same string. Unlike
+ * toString(), building the key does not convert numbers to strings
+ * and does not concatenate anything, and keys are looked up in a hash
+ * rather than compared as strings. Importer does this for every
+ * address and service it finds in the configuration.
+ */
+class ObjectSignatureKey
+{
+public:
+    QString type_name;
+    QString object_name;
+
+    QString address;
+    QString netmask;
+    QString address_range_start;
+    QString address_range_end;
+    QString dns_name;
+    QString address_table_name;
+    QString parent_interface_name;
+
+    int protocol;
+    QString dscp;
+    QString tos;
+    // fragments, short_fragments, any_opt, lsrr, ssrr, rr, ts, rtralt,
+    // rtralt_value and established packed one per bit
+    unsigned int bool_flags;
+
+    int icmp_type;
+    int icmp_code;
+
+    int src_port_range_start;
+    int src_port_range_end;
+    int dst_port_range_start;
+    int dst_port_range_end;
+    QList<int> flags_mask;
+    QList<int> flags_comp;
+
+    QString platform;
+    QString protocol_name;
+    QString code;
+    QString tag;
+    QString user_id;
+
+    QList<int> group_children_ids;
+
+    ObjectSignatureKey(const ObjectSignature &sig);
+
+    bool operator==(const ObjectSignatureKey &other) const;
+};
+
+uint qHash(const ObjectSignatureKey &key);
+
 #endif
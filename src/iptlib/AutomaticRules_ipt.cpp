@@ -104,12 +104,12 @@ void AutomaticRules_ipt::addConntrackRule()
 
     try
     {
-        InetAddr(addr);
+        InetAddr conntrack_addr(addr);
     } catch (FWException &ex)
     {
         try
         {
-            InetAddr(AF_INET6, addr);
+            InetAddr conntrack_addr(AF_INET6, addr);
         } catch (FWException &ex)
         {
             throw FWException(string("Invalid IP address for conntrack: ") + addr);
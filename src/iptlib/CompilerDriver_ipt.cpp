@@ -29,6 +29,8 @@
 #include "CompilerDriver_ipt.h"
 #include "PolicyCompiler_ipt.h"
 #include "PolicyCompiler_secuwall.h"
+#include "RuleHitSimulator_ipt.h"
+#include "ipt_utils.h"
 
 #include "fwbuilder/Address.h"
 #include "fwbuilder/FWException.h"
@@ -60,6 +62,7 @@ CompilerDriver_ipt::CompilerDriver_ipt(FWObjectDatabase *db) :
 {
     have_connmark = false;
     have_connmark_in_output = false;
+    rule_hit_simulator = NULL;
 }
 
 CompilerDriver_ipt::~CompilerDriver_ipt()
@@ -74,6 +77,25 @@ CompilerDriver* CompilerDriver_ipt::clone()
     return new_cd;
 }
 
+bool CompilerDriver_ipt::simulateRules(int policy_af)
+{
+    return (rule_hit_simulator != NULL &&
+            rule_hit_simulator->getSimulator().getModel().addressFamily() ==
+            policy_af);
+}
+
+/*
+ * secuwall writes additional files with interface and host
+ * configuration that are not covered by file_names
+ */
+bool CompilerDriver_ipt::isMemberSpecializationSupported(Cluster*,
+                                                         Firewall *compiled_fw,
+                                                         Firewall *fw)
+{
+    return (compiled_fw->getStr("host_OS") != "secuwall" &&
+            fw->getStr("host_OS") != "secuwall");
+}
+
 void CompilerDriver_ipt::assignRuleSetChain(RuleSet *ruleset)
 {
     string branch_name = ruleset->getName();
@@ -84,7 +106,7 @@ void CompilerDriver_ipt::assignRuleSetChain(RuleSet *ruleset)
         if (rule->isDisabled()) continue;
 
         if (!ruleset->isTop())
-            rule->setStr("ipt_chain", branch_name);
+            rule->setStr(ipt_chain, branch_name);
 // ???
 //        rule->setUniqueId( FWObjectDatabase::getStringId(rule->getId()) );
     }
@@ -142,20 +164,19 @@ void CompilerDriver_ipt::findBranchesInMangleTable(Firewall *fw,
  * Also will need either special configlets for the single-rule
  * compile or more if-then-else in configlet code.
  */
-string CompilerDriver_ipt::dumpScript(Firewall *fw,
-                                      const string& automatic_rules_script,
-                                      const string& automatic_mangle_script,
-                                      const string& nat_script,
-                                      const string& mangle_script,
-                                      const string& filter_script,
-                                      bool ipv6_policy)
+void CompilerDriver_ipt::dumpScript(Firewall *fw,
+                                    ChunkedOutput &res,
+                                    ChunkedOutput &automatic_rules_script,
+                                    ChunkedOutput &automatic_mangle_script,
+                                    ChunkedOutput &nat_script,
+                                    ChunkedOutput &mangle_script,
+                                    ChunkedOutput &filter_script,
+                                    bool ipv6_policy)
 {
 
     // cerr << "nat script" << endl;
-    // cerr << "\"" << nat_script << "\"" << endl;
+    // cerr << "\"" << nat_script.str() << "\"" << endl;
 
-    ostringstream res;
-    ostringstream script;
     string prolog_place = fw->getOptionsObject()->getStr("prolog_place");
 
     Configlet *conf = NULL;
@@ -168,7 +189,14 @@ string CompilerDriver_ipt::dumpScript(Firewall *fw,
         conf->collapseEmptyStrings(true);
     } else
     {
-        if (fw->getOptionsObject()->getBool("use_iptables_restore"))
+        if (fw->getOptionsObject()->getBool("use_nftables"))
+        {
+            conf = new Configlet(fw, "linux24", "script_body_nftables");
+            conf->removeComments();
+            conf->setVariable("nft_family", (ipv6_policy) ? "ip6" : "ip");
+            conf->setVariable("iptables",
+                              (ipv6_policy) ? "$IP6TABLES" : "$IPTABLES");
+        } else if (fw->getOptionsObject()->getBool("use_iptables_restore"))
         {
             conf = new Configlet(fw, "linux24", "script_body_iptables_restore");
         } else
@@ -182,16 +210,16 @@ string CompilerDriver_ipt::dumpScript(Firewall *fw,
 
     conf->setVariable("filter", !filter_script.empty());
     conf->setVariable("filter_or_auto", have_auto || !filter_script.empty());
-    conf->setVariable("filter_auto_script", automatic_rules_script.c_str());
-    conf->setVariable("filter_script", filter_script.c_str());
+    conf->setVariable("filter_auto_script", &automatic_rules_script);
+    conf->setVariable("filter_script", &filter_script);
 
     conf->setVariable("mangle", !mangle_script.empty());
     conf->setVariable("mangle_or_auto", !mangle_script.empty() || !automatic_mangle_script.empty());
-    conf->setVariable("mangle_auto_script", automatic_mangle_script.c_str());
-    conf->setVariable("mangle_script", mangle_script.c_str());
+    conf->setVariable("mangle_auto_script", &automatic_mangle_script);
+    conf->setVariable("mangle_script", &mangle_script);
 
     conf->setVariable("nat", !nat_script.empty());
-    conf->setVariable("nat_script", nat_script.c_str());
+    conf->setVariable("nat_script", &nat_script);
 
     bool have_script = (have_auto ||
                         !filter_script.empty() ||
@@ -202,10 +230,9 @@ string CompilerDriver_ipt::dumpScript(Firewall *fw,
     conf->setVariable("ipv4", !ipv6_policy);
     conf->setVariable("ipv6",  ipv6_policy);
 
-    res << conf->expand().toStdString();
+    // text of the streams is added to res without copying
+    conf->expand(res);
     delete conf;
-
-    return res.str();
 }
 
 std::auto_ptr<PolicyCompiler_ipt> CompilerDriver_ipt::createPolicyCompiler(
@@ -31,6 +31,8 @@
 #include "PolicyCompiler_ipt.h"
 #include "OSConfigurator_linux24.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
 #include <string>
 #include <sstream>
 #include <map>
@@ -54,6 +56,7 @@ namespace libfwbuilder
 
 namespace fwcompiler
 {
+    class RuleHitSimulator_ipt;
 
     class CompilerDriver_ipt : public CompilerDriver
     {
@@ -80,6 +83,14 @@ namespace fwcompiler
         bool have_connmark;
         bool have_connmark_in_output;
 
+        RuleHitSimulator_ipt *rule_hit_simulator;
+        bool simulateRules(int policy_af);
+
+        virtual bool isMemberSpecializationSupported(
+            libfwbuilder::Cluster *cluster,
+            libfwbuilder::Firewall *compiled_fw,
+            libfwbuilder::Firewall *fw);
+
 public:
 
         CompilerDriver_ipt(libfwbuilder::FWObjectDatabase *db);
@@ -92,26 +103,38 @@ public:
                             const std::string &firewall_id,
                             const std::string &single_rule_id);
 
+        /**
+         * Rules produced by the policy, mangle and NAT compilers for
+         * the address family of the simulator's model are loaded into
+         * the simulator as they are compiled. They belong to the
+         * driver's copy of the object database, the driver must
+         * exist while the simulator is used. Members of a cluster are
+         * compiled by copies of the driver and are not loaded.
+         */
+        void setRuleHitSimulator(RuleHitSimulator_ipt *sim)
+        { rule_hit_simulator = sim; }
+
         void assignRuleSetChain(libfwbuilder::RuleSet *ruleset);
         void findBranchesInMangleTable(libfwbuilder::Firewall*,
                                        std::list<libfwbuilder::FWObject*> &all_policies);
 
-        std::string dumpScript(libfwbuilder::Firewall *fw,
-                               const std::string& automatic_rules_script,
-                               const std::string& automatic_mangle_script,
-                               const std::string& nat_script,
-                               const std::string& mangle_script,
-                               const std::string& filter_script,
-                               bool ipv6_policy);
+        void dumpScript(libfwbuilder::Firewall *fw,
+                        ChunkedOutput &res,
+                        ChunkedOutput &automatic_rules_script,
+                        ChunkedOutput &automatic_mangle_script,
+                        ChunkedOutput &nat_script,
+                        ChunkedOutput &mangle_script,
+                        ChunkedOutput &filter_script,
+                        bool ipv6_policy);
 
         bool processPolicyRuleSet(
             libfwbuilder::Firewall *fw,
             libfwbuilder::FWObject *ruleset,
             const std::string &single_rule_id,
-            std::ostringstream &filter_table_stream,
-            std::ostringstream &mangle_table_stream,
-            std::ostringstream &automatic_rules_stream,
-            std::ostringstream &automatic_mangle_stream,
+            ChunkedOutput &filter_table_stream,
+            ChunkedOutput &mangle_table_stream,
+            ChunkedOutput &automatic_rules_stream,
+            ChunkedOutput &automatic_mangle_stream,
             fwcompiler::OSConfigurator_linux24 *oscnf,
             int policy_af,
             std::map<const std::string, bool> &minus_n_commands_filter,
@@ -121,7 +144,7 @@ public:
             libfwbuilder::Firewall *fw,
             libfwbuilder::FWObject *ruleset,
             const std::string &single_rule_id,
-            std::ostringstream &nat_stream,
+            ChunkedOutput &nat_stream,
             fwcompiler::OSConfigurator_linux24 *oscnf,
             int policy_af,
             std::map<const std::string, bool> &minus_n_commands_nat);
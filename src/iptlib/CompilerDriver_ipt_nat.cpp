@@ -27,6 +27,7 @@
 
 #include "CompilerDriver_ipt.h"
 #include "NATCompiler_ipt.h"
+#include "RuleHitSimulator_ipt.h"
 #include "OSConfigurator_linux24.h"
 
 #include "fwbuilder/FWObjectDatabase.h"
@@ -50,7 +51,7 @@ bool CompilerDriver_ipt::processNatRuleSet(
     Firewall *fw,
     FWObject *ruleset,
     const std::string &single_rule_id,
-    std::ostringstream &nat_rules_stream,
+    ChunkedOutput &nat_rules_stream,
     fwcompiler::OSConfigurator_linux24 *oscnf,
     int policy_af,
     std::map<const std::string, bool> &minus_n_commands_nat)
@@ -93,9 +94,13 @@ bool CompilerDriver_ipt::processNatRuleSet(
 
     nat_compiler->setRulesetToChainMapping(&branch_ruleset_to_chain_mapping);
 
+    if (simulateRules(policy_af)) nat_compiler->setKeepCompiledRules(true);
+
     if ( (nat_rules_count=nat_compiler->prolog()) > 0 )
     {
         nat_compiler->compile();
+        if (simulateRules(policy_af))
+            rule_hit_simulator->addCompiledRules("nat", nat_compiler.get());
         nat_compiler->epilog();
     }
 
@@ -116,7 +121,7 @@ bool CompilerDriver_ipt::processNatRuleSet(
             nat_rules_stream << nat_compiler->printAutomaticRules();
         }
 
-        nat_rules_stream << nat_compiler->getCompiledScript();
+        nat_compiler->appendCompiledScript(nat_rules_stream);
         nat_rules_stream << "\n";
         empty_output = false;
 
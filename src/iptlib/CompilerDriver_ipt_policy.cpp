@@ -29,6 +29,7 @@
 #include "MangleTableCompiler_ipt.h"
 #include "PolicyCompiler_ipt.h"
 #include "PolicyCompiler_secuwall.h"
+#include "RuleHitSimulator_ipt.h"
 #include "OSConfigurator_linux24.h"
 
 #include "Configlet.h"
@@ -56,10 +57,10 @@ bool CompilerDriver_ipt::processPolicyRuleSet(
     Firewall *fw,
     FWObject *ruleset,
     const string &single_rule_id,
-    ostringstream &filter_rules_stream,
-    ostringstream &mangle_rules_stream,
-    ostringstream &automatic_rules_stream,
-    ostringstream &automatic_mangle_stream,
+    ChunkedOutput &filter_rules_stream,
+    ChunkedOutput &mangle_rules_stream,
+    ChunkedOutput &automatic_rules_stream,
+    ChunkedOutput &automatic_mangle_stream,
     OSConfigurator_linux24 *oscnf,
     int policy_af,
     std::map<const std::string, bool> &minus_n_commands_filter,
@@ -107,9 +108,13 @@ bool CompilerDriver_ipt::processPolicyRuleSet(
     if (inTestMode()) mangle_compiler->setTestMode();
     if (inEmbeddedMode()) mangle_compiler->setEmbeddedMode();
 
+    if (simulateRules(policy_af)) mangle_compiler->setKeepCompiledRules(true);
+
     if ( (mangle_rules_count = mangle_compiler->prolog()) > 0 )
     {
         mangle_compiler->compile();
+        if (simulateRules(policy_af))
+            rule_hit_simulator->addCompiledRules("mangle", mangle_compiler.get());
         mangle_compiler->epilog();
 
         // We need to generate automatic rules in mangle
@@ -130,18 +135,18 @@ bool CompilerDriver_ipt::processPolicyRuleSet(
 
         if (mangle_compiler->getCompiledScriptLength() > 0)
         {
-            ostringstream tmp;
+            ChunkedOutput tmp;
 
-            tmp << mangle_compiler->getCompiledScript();
+            mangle_compiler->appendCompiledScript(tmp);
 
-            if (tmp.tellp() > 0)
+            if (!tmp.empty())
             {
                 if (!single_rule_compile_on)
                 {
                     mangle_rules_stream << "# ================ Table 'mangle', ";
                     mangle_rules_stream << "rule set " << branch_name << "\n";
                 }
-                mangle_rules_stream << tmp.str();
+                mangle_rules_stream.append(tmp);
             }
         }
 
@@ -175,18 +180,22 @@ bool CompilerDriver_ipt::processPolicyRuleSet(
     policy_compiler->setRuleSetName(branch_name);
     policy_compiler->setPersistentObjects(persistent_objects);
 
+    if (simulateRules(policy_af)) policy_compiler->setKeepCompiledRules(true);
+
     if ( (policy_rules_count=policy_compiler->prolog()) > 0 )
     {
         policy_compiler->compile();
+        if (simulateRules(policy_af))
+            rule_hit_simulator->addCompiledRules("filter", policy_compiler.get());
         policy_compiler->epilog();
 
         if (policy_compiler->getCompiledScriptLength() > 0)
         {
-            ostringstream tmp;
+            ChunkedOutput tmp;
 
-            tmp << policy_compiler->getCompiledScript();
+            policy_compiler->appendCompiledScript(tmp);
 
-            if (tmp.tellp() > 0)
+            if (!tmp.empty())
             {
                 empty_output = false;
                 if (!single_rule_compile_on)
@@ -194,7 +203,7 @@ bool CompilerDriver_ipt::processPolicyRuleSet(
                     filter_rules_stream << "# ================ Table 'filter', ";
                     filter_rules_stream << "rule set " << branch_name << "\n";
                 }
-                filter_rules_stream << tmp.str();
+                filter_rules_stream.append(tmp);
             }
         }
 
@@ -117,7 +117,7 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
 
     getFirewallAndClusterObjects(cluster_id, firewall_id, &cluster, &fw);
 
-    string generated_script;
+    ChunkedOutput generated_script;
 
     try
     {
@@ -186,6 +186,14 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
                 new OSConfigurator_ipcop(objdb , fw, false));
         }
 
+        if (fw->getOptionsObject()->getBool("use_nftables"))
+        {
+            // rules of the filter table are loaded with "nft -f", other
+            // tables are configured with iptables commands in the shell
+            // script format
+            fw->getOptionsObject()->setBool("use_iptables_restore", false);
+        }
+
         if (os_family == "linux24" ||
             os_family == "openwrt" ||
             os_family == "dd-wrt-nvram" ||
@@ -319,11 +327,11 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
                 delete prep;
             }
 
-            ostringstream automaitc_rules_stream;
-            ostringstream automaitc_mangle_stream;
-            ostringstream filter_rules_stream;
-            ostringstream mangle_rules_stream;
-            ostringstream nat_rules_stream;
+            ChunkedOutput automaitc_rules_stream;
+            ChunkedOutput automaitc_mangle_stream;
+            ChunkedOutput filter_rules_stream;
+            ChunkedOutput mangle_rules_stream;
+            ChunkedOutput nat_rules_stream;
 
             bool empty_output = true;
 
@@ -392,27 +400,28 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
                 if (ipv6_policy)
                 {
                     have_ipv6 = true;
-                    generated_script += "\n\n";
-                    generated_script += "# ================ IPv6\n";
-                    generated_script += "\n\n";
+                    generated_script << "\n\n";
+                    generated_script << "# ================ IPv6\n";
+                    generated_script << "\n\n";
                 } else
                 {
                     have_ipv4 = true;
-                    generated_script += "\n\n";
-                    generated_script += "# ================ IPv4\n";
-                    generated_script += "\n\n";
+                    generated_script << "\n\n";
+                    generated_script << "# ================ IPv4\n";
+                    generated_script << "\n\n";
                 }
             }
 
-            generated_script += dumpScript(fw,
-                                           automaitc_rules_stream.str(),
-                                           automaitc_mangle_stream.str(),
-                                           nat_rules_stream.str(),
-                                           mangle_rules_stream.str(),
-                                           filter_rules_stream.str(),
-                                           ipv6_policy);
+            dumpScript(fw,
+                       generated_script,
+                       automaitc_rules_stream,
+                       automaitc_mangle_stream,
+                       nat_rules_stream,
+                       mangle_rules_stream,
+                       filter_rules_stream,
+                       ipv6_policy);
             if (single_rule_compile_on)
-                generated_script += "\n\n";
+                generated_script << "\n\n";
         }
 
         std::auto_ptr<RoutingCompiler_ipt> routing_compiler(
@@ -459,7 +468,7 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
             return formSingleRuleCompileOutput(
                 QString::fromUtf8(
                     (getErrors("") + 
-                     generated_script +
+                     generated_script.str() +
                      routing_compiler->getCompiledScript()).c_str()));
         }
 
@@ -528,9 +537,19 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
                                     oscnf->printPathForAllTools(os_variant).c_str());
         script_skeleton.setVariable("shell_functions",
                                     oscnf->printShellFunctions(have_ipv6).c_str());
+        string run_time_address_tables = oscnf->printRunTimeAddressTablesCode();
+        if (oscnf->haveGroupIpSets())
+            run_time_address_tables += "\n" + oscnf->printGroupIpSetsCode();
         script_skeleton.setVariable("run_time_address_tables",
-                                    oscnf->printRunTimeAddressTablesCode().c_str());
+                                    run_time_address_tables.c_str());
         script_skeleton.setVariable("using_ipset", oscnf->usingIpSetModule());
+        script_skeleton.setVariable("using_ipset_restore",
+                                    oscnf->usingIpSetRestore());
+        script_skeleton.setVariable("using_ipset_legacy",
+                                    oscnf->usingIpSetModule() &&
+                                    !oscnf->usingIpSetRestore());
+        script_skeleton.setVariable("have_group_ipsets",
+                                    oscnf->haveGroupIpSets());
 
         if (supports_prolog_epilog)
         {
@@ -643,18 +662,16 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
             all_errors.push_back(oscnf->getErrors("").c_str());
         }
 
-        // convert from UTF8 to make sure localized comments are shown correctly
-        // script << oscnf->getCompiledScript().c_str();
-        // script << generated_script.c_str();
-        // script << routing_compiler->getCompiledScript().c_str();
+        // Generated code can be many megabytes. It stays in the
+        // chunks compilers wrote it to and goes to the file from
+        // there, it is not converted to QString and back to UTF-8
+        ChunkedOutput script_body;
+        oscnf->appendCompiledScript(script_body);
+        script_body.append(generated_script);
+        routing_compiler->appendCompiledScript(script_body);
+        script_body << endl;
 
-        script << QString::fromUtf8(oscnf->getCompiledScript().c_str());
-        script << QString::fromUtf8(generated_script.c_str());
-        script << QString::fromUtf8(routing_compiler->getCompiledScript().c_str());
-
-        script << endl;
-
-        script_skeleton.setVariable("script_body", indent(4, script_buffer));
+        script_skeleton.setVariable("script_body", &script_body, 4);
 
         script_skeleton.setVariable("timestamp", timestr);
         script_skeleton.setVariable("tz", tzname[stm->tm_isdst]);
@@ -690,8 +707,17 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
         {
             std::auto_ptr<PolicyCompiler_ipt> policy_compiler =
                 createPolicyCompiler(fw, false, NULL,  NULL);
-            PolicyCompiler_ipt::PrintRule* print_rule =
-                policy_compiler->createPrintRuleProcessor();
+            PolicyCompiler_ipt::PrintRule* print_rule = NULL;
+            // block_action uses iptables commands even if the policy
+            // is activated with nftables because the nftables table
+            // is deleted by reset_all
+            if (policy_compiler->usingNftables())
+            {
+                print_rule = new PolicyCompiler_ipt::PrintRule(
+                    "generate shell script");
+                print_rule->initialize();
+            } else
+                print_rule = policy_compiler->createPrintRuleProcessor();
             print_rule->setContext(policy_compiler.get());
             print_rule->_printBackupSSHAccessRules(&block_action);
         } else
@@ -772,26 +798,14 @@ QString CompilerDriver_ipt::run(const std::string &cluster_id,
 
         info("Output file name: " + file_names[FW_FILE].toStdString());
 
-        QFile fw_file(file_names[FW_FILE]);
-        if (fw_file.open(QIODevice::WriteOnly))
-        {
-            QTextStream fw_str(&fw_file);
-            fw_str << script_skeleton.expand();
-            fw_file.close();
-            fw_file.setPermissions(QFile::ReadOwner | QFile::WriteOwner |
-                                   QFile::ReadGroup | QFile::ReadOther |
-                                   QFile::ExeOwner | 
-                                   QFile::ExeGroup |
-                                   QFile::ExeOther );
+        ChunkedOutput fw_script;
+        script_skeleton.expand(fw_script);
 
+        QString err = writeOutputFile(file_names[FW_FILE], fw_script, true);
+        if (err.isEmpty())
             info(" Compiled successfully");
-
-        } else
-        {
-            QString err(" Failed to open file %1 for writing: %2; Current dir: %3");
-            abort(err.arg(fw_file.fileName())
-                  .arg(fw_file.error()).arg(QDir::current().path()).toStdString());
-        }
+        else
+            abort(" " + err.toStdString());
 
         free(timestr);
 
@@ -27,6 +27,7 @@
 
 #include "MangleTableCompiler_ipt.h"
 #include "OSConfigurator_linux24.h"
+#include "ipt_utils.h"
 
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/Firewall.h"
@@ -81,7 +82,7 @@ bool MangleTableCompiler_ipt::keepMangleTableRules::processNext()
                 r= compiler->dbcopy->createPolicyRule();
                 compiler->temp_ruleset->add(r);
                 r->duplicate(rule);
-                r->setStr("ipt_chain","PREROUTING");
+                r->setStr(ipt_chain,"PREROUTING");
                 tmp_queue.push_back(r);
             }
 
@@ -92,7 +93,7 @@ bool MangleTableCompiler_ipt::keepMangleTableRules::processNext()
                 r= compiler->dbcopy->createPolicyRule();
                 compiler->temp_ruleset->add(r);
                 r->duplicate(rule);
-                r->setStr("ipt_chain","POSTROUTING");
+                r->setStr(ipt_chain,"POSTROUTING");
                 tmp_queue.push_back(r);
             }
 
@@ -117,7 +118,7 @@ bool MangleTableCompiler_ipt::keepMangleTableRules::processNext()
             r= compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
             r->duplicate(rule);
-            r->setStr("ipt_chain","FORWARD");
+            r->setStr(ipt_chain,"FORWARD");
             tmp_queue.push_back(r);
 
             // tmp_queue.push_back(rule);
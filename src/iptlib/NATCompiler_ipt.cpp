@@ -177,8 +177,8 @@ string NATCompiler_ipt::debugPrintRule(Rule *r)
     NATRule *rule = NATRule::cast(r);
 
     return NATCompiler::debugPrintRule(rule)+
-        " c=" + rule->getStr("ipt_chain") +
-        " t=" + rule->getStr("ipt_target") +
+        " c=" + rule->getStr(ipt_chain) +
+        " t=" + rule->getStr(ipt_target) +
         " (type="+rule->getRuleTypeAsString()+")";
 
 }
@@ -690,7 +690,7 @@ bool NATCompiler_ipt::VerifyRules3::processNext()
         return true;
     }
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(ipt_chain);
 
     if (chain == "OUTPUT" && ! itf_i_re->isAny())
     {
@@ -1230,12 +1230,12 @@ bool NATCompiler_ipt::splitMultiSrcAndDst::processNext()
         compiler->temp_ruleset->add(r);
         r->duplicate(rule); 
 // move existing rule onto new chain
-        rule->setStr("ipt_chain", new_chain);
+        rule->setStr(ipt_chain, new_chain);
 // we've already tested for interface ....
         rule->setStr(".iface_in", "nil");
         rule->setStr(".iface_out", "nil");
 // new rule points to new chain, continues if no match
-        r->setStr("ipt_target", new_chain);
+        r->setStr(ipt_target, new_chain);
 
 // Now decide which way round would be best ...
         if (nosrc < nodst) 
@@ -1317,8 +1317,8 @@ bool NATCompiler_ipt::dynamicInterfaceInTSrc::processNext()
         } else
         {
             rule->setRuleType(NATRule::Masq);
-            if (rule->getStr("ipt_target")=="" || rule->getStr("ipt_target")=="SNAT")
-                rule->setStr("ipt_target", "MASQUERADE");
+            if (rule->getStr(ipt_target)=="" || rule->getStr(ipt_target)=="SNAT")
+                rule->setStr(ipt_target, "MASQUERADE");
         }
     }
     return true;
@@ -1522,7 +1522,7 @@ bool NATCompiler_ipt::doOSrcNegation::processNext()
 //	ntsrc=r->getTSrc();  ntsrc->clearChildren();  ntsrc->setAnyElement();
 //	ntdst=r->getTDst();  ntdst->clearChildren();  ntdst->setAnyElement();
 //	r->setRuleType(NATRule::Continue);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
 //	r->setBool("rule_added_for_osrc_neg",true);
 	tmp_queue.push_back(r);
 
@@ -1538,8 +1538,8 @@ bool NATCompiler_ipt::doOSrcNegation::processNext()
 	ndst->setNeg(false);
 	nsrv->setNeg(false);
 	r->setRuleType(NATRule::Return);
-	r->setStr("ipt_target","RETURN");
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_target,"RETURN");
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1555,7 +1555,7 @@ bool NATCompiler_ipt::doOSrcNegation::processNext()
 	nsrv=r->getOSrv();
 	ndst->setNeg(false);
 	nsrv->setNeg(false);
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1604,7 +1604,7 @@ bool NATCompiler_ipt::doODstNegation::processNext()
 //	ntsrc=r->getTSrc();  ntsrc->clearChildren();  ntsrc->setAnyElement();
 //	ntdst=r->getTDst();  ntdst->clearChildren();  ntdst->setAnyElement();
 //	r->setRuleType(NATRule::Continue);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
 	r->setBool("rule_added_for_odst_neg",true);
 	tmp_queue.push_back(r);
 
@@ -1620,8 +1620,8 @@ bool NATCompiler_ipt::doODstNegation::processNext()
 	nsrc->setNeg(false);
 	nsrv->setNeg(false);
 	r->setRuleType(NATRule::Return);
-	r->setStr("ipt_target","RETURN");
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_target,"RETURN");
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1637,7 +1637,7 @@ bool NATCompiler_ipt::doODstNegation::processNext()
 	nsrv=r->getOSrv();
 	nsrc->setNeg(false);
 	nsrv->setNeg(false);
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1685,7 +1685,7 @@ bool NATCompiler_ipt::doOSrvNegation::processNext()
 //	ntsrc=r->getTSrc();  ntsrc->clearChildren();  ntsrc->setAnyElement();
 //	ntdst=r->getTDst();  ntdst->clearChildren();  ntdst->setAnyElement();
 //	r->setRuleType(NATRule::Continue);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
 	r->setBool("rule_added_for_osrv_neg",true);
 	tmp_queue.push_back(r);
 
@@ -1700,8 +1700,8 @@ bool NATCompiler_ipt::doOSrvNegation::processNext()
 	nsrc->setNeg(false);
 	ndst->setNeg(false);
 	r->setRuleType(NATRule::Return);
-	r->setStr("ipt_target","RETURN");
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_target,"RETURN");
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1717,7 +1717,7 @@ bool NATCompiler_ipt::doOSrvNegation::processNext()
 	nsrv=r->getOSrv();  nsrv->clearChildren();  nsrv->setAnyElement();
 	nsrc->setNeg(false);
 	ndst->setNeg(false);
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(ipt_chain,new_chain);
         r->setStr(".iface_in", "nil");
         r->setStr(".iface_out", "nil");
 	//r->setInterfaceStr("nil");
@@ -1734,7 +1734,7 @@ bool NATCompiler_ipt::splitNONATRule::processNext()
 {
     NATRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( rule->getStr("ipt_chain").empty() && rule->getRuleType()==NATRule::NONAT)
+    if ( rule->getStr(ipt_chain).empty() && rule->getRuleType()==NATRule::NONAT)
     {
         Address *osrc=compiler->getFirstOSrc(rule);
         bool osrcfw= compiler->complexMatch(osrc,compiler->fw);
@@ -1749,12 +1749,12 @@ bool NATCompiler_ipt::splitNONATRule::processNext()
         NATRule *r= compiler->dbcopy->createNATRule();
         compiler->temp_ruleset->add(r);
         r->duplicate(rule);
-        r->setStr("ipt_chain","POSTROUTING");  
+        r->setStr(ipt_chain,"POSTROUTING");  
         tmp_queue.push_back(r);
 
         if (osrcfw)
         {
-            rule->setStr("ipt_chain","OUTPUT");
+            rule->setStr(ipt_chain,"OUTPUT");
             if (osrc->getId()==compiler->fw->getId())
             {
                 RuleElementOSrc *src;
@@ -1762,7 +1762,7 @@ bool NATCompiler_ipt::splitNONATRule::processNext()
                 src->clearChildren();
                 src->setAnyElement();
             }
-        } else          rule->setStr("ipt_chain","PREROUTING");  
+        } else          rule->setStr(ipt_chain,"PREROUTING");  
 
         tmp_queue.push_back(rule);
 
@@ -1819,8 +1819,8 @@ bool NATCompiler_ipt::splitNATBranchRule::processNext()
                             NATRule *r = compiler->dbcopy->createNATRule();
                             compiler->temp_ruleset->add(r);
                             r->duplicate(rule);
-                            r->setStr("ipt_chain", my_chain);
-                            r->setStr("ipt_target", *it);
+                            r->setStr(ipt_chain, my_chain);
+                            r->setStr(ipt_target, *it);
                             tmp_queue.push_back(r);
                         }
 
@@ -1854,8 +1854,8 @@ bool NATCompiler_ipt::splitNATBranchRule::processNext()
 
                    ipt_comp->registerRuleSetChain(new_chain);
                    ipt_comp->registerRuleSetChain(tgt_chain);
-                   r->setStr("ipt_chain", new_chain);
-                   r->setStr("ipt_target", tgt_chain);
+                   r->setStr(ipt_chain, new_chain);
+                   r->setStr(ipt_target, tgt_chain);
                    tmp_queue.push_back(r);
                 }
             }
@@ -1871,8 +1871,8 @@ bool NATCompiler_ipt::splitNATBranchRule::processNext()
             // and are needed only to make the compiler continue and
             // produce some output, which will be shown to the user
             // together with the error in single-rule compile mode
-            rule->setStr("ipt_chain", "PREROUTING");
-            rule->setStr("ipt_target", "UNDEFINED");
+            rule->setStr(ipt_chain, "PREROUTING");
+            rule->setStr(ipt_target, "UNDEFINED");
             tmp_queue.push_back(rule);
         }
     } else
@@ -1885,7 +1885,7 @@ bool NATCompiler_ipt::localNATRule::processNext()
 {
     NATRule *rule=getNext(); if (rule==NULL) return false;
 
-//    if ( rule->getStr("ipt_chain").empty())
+//    if ( rule->getStr(ipt_chain).empty())
 //    {
 
     Address *osrc = compiler->getFirstOSrc(rule);
@@ -1904,7 +1904,7 @@ bool NATCompiler_ipt::localNATRule::processNext()
  *
  * Can use OUTPUT chain only for DNAT rules and a like
  */
-        if (osrcfw) rule->setStr("ipt_chain", "OUTPUT");
+        if (osrcfw) rule->setStr(ipt_chain, "OUTPUT");
         if (osrcfw && osrc->getId()==compiler->fw->getId())
         {
             RuleElementOSrc *src;
@@ -1977,7 +1977,7 @@ bool NATCompiler_ipt::DNATforFW::processNext()
         Address *osrc=compiler->getFirstOSrc(rule);
         if ( compiler->complexMatch(osrc,compiler->fw) ) 
         {
-            rule->setStr("ipt_chain","OUTPUT");  
+            rule->setStr(ipt_chain,"OUTPUT");  
             if (osrc->getId()==compiler->fw->getId())  
             {
                 rule->getOSrc()->clearChildren();
@@ -2015,22 +2015,22 @@ bool NATCompiler_ipt::decideOnChain::processNext()
     default: ;
     }
 
-    if (!rule->getStr("ipt_chain").empty())
+    if (!rule->getStr(ipt_chain).empty())
     {
         if (!compiler->getSourceRuleSet()->isTop() &&
-            ipt_comp->getRuleSetName() == rule->getStr("ipt_chain"))
+            ipt_comp->getRuleSetName() == rule->getStr(ipt_chain))
         {
             // this is a NAT branch. Need to rename the chain to add
             // information about the chain that would have been used
             // if this was top ruleset
             string new_chain = compiler->getRuleSetName() + "_" + chain;
             ipt_comp->registerRuleSetChain(new_chain);
-            rule->setStr("ipt_chain", new_chain);
+            rule->setStr(ipt_chain, new_chain);
         }
         return true; // already defined
     }
 
-    if (!chain.empty()) rule->setStr("ipt_chain", chain);
+    if (!chain.empty()) rule->setStr(ipt_chain, chain);
     return true;
 }
 
@@ -2041,18 +2041,18 @@ bool NATCompiler_ipt::decideOnTarget::processNext()
 
     tmp_queue.push_back(rule);
 
-    if ( ! rule->getStr("ipt_target").empty() ) return true; // already defined
+    if ( ! rule->getStr(ipt_target).empty() ) return true; // already defined
 
     switch (rule->getRuleType())
     {
-    case NATRule::NONAT:    rule->setStr("ipt_target","ACCEPT");   break;
-    case NATRule::SNAT:     rule->setStr("ipt_target","SNAT");     break;
-    case NATRule::SNetnat:  rule->setStr("ipt_target","NETMAP");   break;
-    case NATRule::DNAT:     rule->setStr("ipt_target","DNAT");     break;
-    case NATRule::DNetnat:  rule->setStr("ipt_target","NETMAP");   break;
-    case NATRule::Masq:     rule->setStr("ipt_target","MASQUERADE"); break;
-    case NATRule::Redirect: rule->setStr("ipt_target","REDIRECT"); break;
-    case NATRule::Return:   rule->setStr("ipt_target","RETURN");   break;
+    case NATRule::NONAT:    rule->setStr(ipt_target,"ACCEPT");   break;
+    case NATRule::SNAT:     rule->setStr(ipt_target,"SNAT");     break;
+    case NATRule::SNetnat:  rule->setStr(ipt_target,"NETMAP");   break;
+    case NATRule::DNAT:     rule->setStr(ipt_target,"DNAT");     break;
+    case NATRule::DNetnat:  rule->setStr(ipt_target,"NETMAP");   break;
+    case NATRule::Masq:     rule->setStr(ipt_target,"MASQUERADE"); break;
+    case NATRule::Redirect: rule->setStr(ipt_target,"REDIRECT"); break;
+    case NATRule::Return:   rule->setStr(ipt_target,"RETURN");   break;
     case NATRule::NATBranch:
         // this case has been taken care for in splitNATBranchRule()
         break;
@@ -2247,7 +2247,7 @@ bool NATCompiler_ipt::verifyRuleWithMAC::processNext()
         return true;
     }
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(ipt_chain);
 
     if (chain!="PREROUTING" && chain!="FORWARD" && chain!="INPUT" )
     {
@@ -2317,6 +2317,7 @@ bool NATCompiler_ipt::processMultiAddressObjectsInRE::processNext()
 {
     NATRule *rule=getNext(); if (rule==NULL) return false;
 
+    NATCompiler_ipt *ipt_comp = dynamic_cast<NATCompiler_ipt*>(compiler);
     OSConfigurator_linux24 *osconf = 
         dynamic_cast<OSConfigurator_linux24*>(compiler->osconfigurator);
 
@@ -2340,7 +2341,7 @@ bool NATCompiler_ipt::processMultiAddressObjectsInRE::processNext()
                     return true;
                 }
                 rule->setStr("address_table_file", path);
-                osconf->registerMultiAddressObject(atrt);
+                osconf->registerMultiAddressObject(atrt, ipt_comp->ipv6);
             }
             if (atrt->getSubstitutionTypeName()==DNSName::TYPENAME)
             {
@@ -2384,7 +2385,7 @@ bool NATCompiler_ipt::processMultiAddressObjectsInRE::processNext()
             }
             r->setStr("address_table_file", path);
 
-            osconf->registerMultiAddressObject(atrt);
+            osconf->registerMultiAddressObject(atrt, ipt_comp->ipv6);
             tmp_queue.push_back(r);
 
             ore->removeRef( *i );
@@ -2405,7 +2406,7 @@ bool NATCompiler_ipt::countChainUsage::processNext()
     for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k) 
     {
         NATRule *rule = NATRule::cast( *k );
-        ipt_comp->chain_usage_counter[rule->getStr("ipt_target")] += 1;
+        ipt_comp->chain_usage_counter[rule->getStr(ipt_target)] += 1;
     }
 
     return true;
@@ -81,6 +81,8 @@ OSConfigurator_linux24::OSConfigurator_linux24(FWObjectDatabase *_db,
     string version = fw->getStr("version");
     using_ipset = (XMLTools::version_compare(version, "1.4.1.1") >= 0 &&
                           fwopt->getBool("use_m_set"));
+    using_ipset_restore = (using_ipset &&
+                           XMLTools::version_compare(version, "1.4.4") >= 0);
 }
 
 OSConfigurator_linux24::~OSConfigurator_linux24()
@@ -289,10 +291,13 @@ string OSConfigurator_linux24::normalizeSetName(const string &txt)
     return table_name.toStdString();
 }
 
-void OSConfigurator_linux24::registerMultiAddressObject(MultiAddressRunTime *at)
+void OSConfigurator_linux24::registerMultiAddressObject(MultiAddressRunTime *at,
+                                                        bool ipv6)
 {
+    string set_name = normalizeSetName(at->getName());
     // std::map<std::string,std::string>
-    address_table_objects[normalizeSetName(at->getName())] = at->getSourceName();
+    address_table_objects[set_name] = at->getSourceName();
+    address_table_families[set_name].insert((ipv6) ? AF_INET6 : AF_INET);
 }
 
 int  OSConfigurator_linux24::prolog()
@@ -353,6 +358,8 @@ string OSConfigurator_linux24::printShellFunctions(bool have_ipv6)
     configlet.setVariable("need_ip6tables_restore",
                           have_ipv6 && options->getBool("use_iptables_restore"));
 
+    configlet.setVariable("need_nft", options->getBool("use_nftables"));
+
     output.push_back(configlet.expand());
 
     /*
@@ -364,6 +371,8 @@ string OSConfigurator_linux24::printShellFunctions(bool have_ipv6)
         reset_iptables.setVariable("opt_wait", "-w");
     else
         reset_iptables.setVariable("opt_wait", "");
+    reset_iptables.setVariable("use_nftables",
+                               options->getBool("use_nftables"));
 
     output.push_back(reset_iptables.expand());
 
@@ -395,6 +404,8 @@ string OSConfigurator_linux24::printRunTimeAddressTablesCode()
 {
     Configlet conf(fw, "linux24", "run_time_address_tables");
     conf.setVariable("using_ipset", using_ipset);
+    conf.setVariable("using_ipset_restore", using_ipset_restore);
+    conf.setVariable("using_ipset_legacy", using_ipset && !using_ipset_restore);
 
     ostringstream check_ostr;
     ostringstream load_ostr;
@@ -412,7 +423,21 @@ string OSConfigurator_linux24::printRunTimeAddressTablesCode()
             check_ostr << "check_file \"" + at_name +
                 "\" \"" + at_file + "\"" << endl;
             load_ostr << "reload_address_table \"" + at_name +
-                "\" \"" + at_file + "\"" << endl;
+                "\" \"" + at_file + "\"";
+            /*
+             * hash:net set holds addresses of one family. Tables
+             * used only in ipv6 rules get an inet6 set, all others
+             * get an inet set. Legacy iphash/nethash sets are always
+             * ipv4.
+             */
+            if (using_ipset_restore)
+            {
+                set<int> &families = address_table_families[at_name];
+                bool ipv6_only = (families.size() == 1 &&
+                                  families.count(AF_INET6) > 0);
+                load_ostr << ((ipv6_only) ? " inet6" : " inet");
+            }
+            load_ostr << endl;
         }
     }
 
@@ -422,6 +447,63 @@ string OSConfigurator_linux24::printRunTimeAddressTablesCode()
     return conf.expand().toStdString();
 }
 
+string OSConfigurator_linux24::registerGroupIpSet(const string &name_hint,
+                                                  bool ipv6,
+                                                  const list<string> &elements)
+{
+    ostringstream key;
+    key << ((ipv6) ? "inet6" : "inet");
+    for (list<string>::const_iterator i=elements.begin(); i!=elements.end(); ++i)
+        key << " " << *i;
+
+    if (group_ipset_names.count(key.str()) > 0)
+        return group_ipset_names[key.str()];
+
+    string set_name = normalizeSetName(name_hint);
+    while (group_ipset_elements.count(set_name) > 0) set_name += "x";
+
+    group_ipset_names[key.str()] = set_name;
+    group_ipset_ipv6[set_name] = ipv6;
+    group_ipset_elements[set_name] = elements;
+    return set_name;
+}
+
+/*
+ * Sets are filled under temporary names and then swapped into place
+ * so that rules that reference them continue to work while the
+ * script reloads the policy.
+ */
+string OSConfigurator_linux24::printGroupIpSetsCode()
+{
+    if (group_ipset_elements.empty()) return "";
+
+    ostringstream restore;
+    map<string, list<string> >::iterator i;
+    for (i=group_ipset_elements.begin(); i!=group_ipset_elements.end(); ++i)
+    {
+        string set_name = i->first;
+        string tmp_name = set_name + "_t";
+        list<string> &elements = i->second;
+
+        ostringstream params;
+        params << "hash:net family "
+               << ((group_ipset_ipv6[set_name]) ? "inet6" : "inet");
+        if (elements.size() > 65536) params << " maxelem " << elements.size();
+
+        restore << "create " << tmp_name << " " << params.str() << endl;
+        restore << "flush " << tmp_name << endl;
+        for (list<string>::iterator j=elements.begin(); j!=elements.end(); ++j)
+            restore << "add " << tmp_name << " " << *j << endl;
+        restore << "create " << set_name << " " << params.str() << endl;
+        restore << "swap " << tmp_name << " " << set_name << endl;
+        restore << "destroy " << tmp_name << endl;
+    }
+
+    Configlet conf(fw, "linux24", "group_ipsets");
+    conf.setVariable("restore_commands", restore.str().c_str());
+    return conf.expand().toStdString();
+}
+
 string OSConfigurator_linux24::getPathForATool(const std::string &os_variant, OSData::tools tool_name)
 {
     FWOptions* options = fw->getOptionsObject();
@@ -450,6 +532,13 @@ string  OSConfigurator_linux24::printPathForAllTools(const string &os)
             << getPathForATool(os, OSData::tools(*i))
             << "\""
             << endl;
+
+    if (fw->getOptionsObject()->getBool("use_nftables"))
+        res << os_data.getVariableName(OSData::NFT)
+            << "=\""
+            << getPathForATool(os, OSData::NFT)
+            << "\""
+            << endl;
     return res.str();
 }
 
@@ -31,6 +31,10 @@
 #include "fwcompiler/OSConfigurator.h"
 
 #include "OSData.h"
+
+#include <map>
+#include <set>
+#include <list>
  
 class QString;
 class QStringList;
@@ -49,8 +53,19 @@ namespace fwcompiler {
         OSData os_data;
         Configlet *command_wrappers;
         bool using_ipset;
+        bool using_ipset_restore;
         
         std::map<std::string,std::string> address_table_objects;
+        // address families of rule sets each run-time address table
+        // is used in
+        std::map<std::string, std::set<int> > address_table_families;
+
+        // ipsets generated by the compiler for large groups of
+        // addresses. Sets are shared between rules, rule sets and
+        // address families if their contents are the same.
+        std::map<std::string, std::string> group_ipset_names;
+        std::map<std::string, bool> group_ipset_ipv6;
+        std::map<std::string, std::list<std::string> > group_ipset_elements;
 
         // this vector is used to avoid duplication of virtual addresses for nat
         std::vector<libfwbuilder::InetAddr> virtual_addresses;
@@ -89,6 +104,13 @@ public:
         virtual void epilog();
 
         bool usingIpSetModule() { return using_ipset; }
+        /*
+         * true if run-time address tables are loaded into hash:net
+         * sets with "ipset restore" (ipset 6 and later, iptables
+         * 1.4.4 and later), false if legacy iphash/nethash sets are
+         * used
+         */
+        bool usingIpSetRestore() { return using_ipset_restore; }
         /*
          * Try to find conflicts in subinterface types and unsupported
          * interface configurations.
@@ -101,7 +123,8 @@ public:
 	virtual void addVirtualAddressForNAT(const libfwbuilder::Address *addr);
 	virtual void addVirtualAddressForNAT(const libfwbuilder::Network *nw);
 
-        virtual void registerMultiAddressObject(libfwbuilder::MultiAddressRunTime *at);
+        virtual void registerMultiAddressObject(libfwbuilder::MultiAddressRunTime *at,
+                                                bool ipv6=false);
         virtual std::string printShellFunctions(bool have_ipv6);
         virtual std::string printPathForAllTools(const std::string &os);
         virtual std::string printIPForwardingCommands();
@@ -122,6 +145,18 @@ public:
 
         virtual std::string printRunTimeAddressTablesCode();
 
+        /*
+         * Register ipset generated by the compiler for a large group
+         * of addresses. Returns the name of the set, which can differ
+         * from @name_hint if a set with the same contents has already
+         * been registered or the name is taken.
+         */
+        std::string registerGroupIpSet(const std::string &name_hint,
+                                       bool ipv6,
+                                       const std::list<std::string> &elements);
+        bool haveGroupIpSets() { return !group_ipset_elements.empty(); }
+        virtual std::string printGroupIpSetsCode();
+
         virtual std::map<std::string, std::string> getGeneratedFiles() const;
 
         std::string normalizeSetName(const std::string &txt);
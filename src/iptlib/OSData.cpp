@@ -44,6 +44,7 @@ OSData::OSData(const std::string &ho)
     attribute_names[IFENSLAVE] = "path_ifenslave";
     attribute_names[IPSET] = "path_ipset";
     attribute_names[LOGGER] = "path_logger";
+    attribute_names[NFT] = "path_nft";
 
     variable_names[LSMOD] = "LSMOD";
     variable_names[MODPROBE] = "MODPROBE";
@@ -58,6 +59,7 @@ OSData::OSData(const std::string &ho)
     variable_names[IFENSLAVE] = "IFENSLAVE";
     variable_names[IPSET] = "IPSET";
     variable_names[LOGGER] = "LOGGER";
+    variable_names[NFT] = "NFT";
 
     all_tools.push_back(LSMOD);
     all_tools.push_back(MODPROBE);
@@ -72,5 +74,7 @@ OSData::OSData(const std::string &ho)
     all_tools.push_back(IFENSLAVE);
     all_tools.push_back(IPSET);
     all_tools.push_back(LOGGER);
+    // NFT is not in all_tools, it is only needed when the policy is
+    // generated for nftables. See OSConfigurator_linux24::printPathForAllTools()
 }
 
@@ -55,7 +55,8 @@ class OSData {
                    BRCTL,
                    IFENSLAVE,
                    IPSET,
-                   LOGGER } tools;
+                   LOGGER,
+                   NFT } tools;
 
     std::string getVariableName(tools t) { return variable_names[t]; }
     const std::list<int>& getAllTools() { return all_tools; }
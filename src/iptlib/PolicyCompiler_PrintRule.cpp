@@ -55,6 +55,7 @@
 #include "combinedAddress.h"
 
 #include "Configlet.h"
+#include "ipt_utils.h"
 
 #include <QStringList>
 #include <QRegExp>
@@ -231,7 +232,7 @@ string PolicyCompiler_ipt::PrintRule::_printRuleLabel(PolicyRule *rule)
  */
 string PolicyCompiler_ipt::PrintRule::_printChain(PolicyRule *rule)
 {
-    string s = rule->getStr("ipt_chain");
+    string s = rule->getStr(ipt_chain);
     if (s.empty()) s = "UNKNOWN";
     // check chain name length per bug report #2507239
     if (s.length() > 30)
@@ -249,7 +250,7 @@ string PolicyCompiler_ipt::PrintRule::_printModules(PolicyRule *rule)
 {
     std::ostringstream ostr;
 
-    string target=rule->getStr("ipt_target");
+    string target=rule->getStr(ipt_target);
     if (target.empty()) target="UNKNOWN";
 
     FWOptions *ruleopt =rule->getOptionsObject();
@@ -383,7 +384,7 @@ string PolicyCompiler_ipt::PrintRule::_printTarget(PolicyRule *rule)
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     std::ostringstream ostr;
 
-    string target=rule->getStr("ipt_target");
+    string target=rule->getStr(ipt_target);
     if (target.empty()) target="UNKNOWN";
 
     FWOptions *ruleopt =rule->getOptionsObject();
@@ -690,7 +691,7 @@ string PolicyCompiler_ipt::PrintRule::_printLogPrefix(PolicyRule *rule,
     return _printLogPrefix(s1.str(),
                            action.toStdString(),
                            rule_iface_name,
-                           rule->getStr("ipt_chain"),
+                           rule->getStr(ipt_chain),
                            ruleset->getName(),
                            rule->getLabel(),
                            prefix);
@@ -1528,15 +1529,15 @@ bool  PolicyCompiler_ipt::PrintRule::processNext()
     PolicyRule         *rule    =getNext(); 
     if (rule==NULL) return false;
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(ipt_chain);
     if (ipt_comp->chain_usage_counter[chain] > 0)
     {
         tmp_queue.push_back(rule);
 
         compiler->output << _printRuleLabel(rule);
-        compiler->output << _createChain(rule->getStr("ipt_chain"));
+        compiler->output << _createChain(rule->getStr(ipt_chain));
 
-        string target = rule->getStr("ipt_target");
+        string target = rule->getStr(ipt_target);
         if (target[0] != '.') compiler->output << _createChain(target);
 
         compiler->output 
@@ -0,0 +1,1455 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2002 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@vk.crocodile.org
+
+  $Id$
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "PolicyCompiler_ipt.h"
+#include "OSConfigurator_linux24.h"
+#include "combinedAddress.h"
+
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/IPService.h"
+#include "fwbuilder/ICMPService.h"
+#include "fwbuilder/ICMP6Service.h"
+#include "fwbuilder/TCPService.h"
+#include "fwbuilder/UDPService.h"
+#include "fwbuilder/CustomService.h"
+#include "fwbuilder/TagService.h"
+#include "fwbuilder/UserService.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Resources.h"
+#include "fwbuilder/Interval.h"
+#include "fwbuilder/MultiAddress.h"
+#include "fwbuilder/physAddress.h"
+#include "fwbuilder/InetAddrMask.h"
+#include "fwbuilder/Inet6AddrMask.h"
+
+#include "Configlet.h"
+#include "ipt_utils.h"
+
+#include <QStringList>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+
+#include <assert.h>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+/*
+ * Interval map used to check whether addresses that we are about to
+ * put into the same set or verdict map overlap. Intervals in the map
+ * never overlap, adjacent and overlapping intervals are coalesced
+ * when added.
+ */
+typedef map<InetAddr, InetAddr> IntervalMap;
+
+static bool overlaps(const IntervalMap &m,
+                     const PolicyCompiler_ipt::PrintRuleNft::nftElement &e)
+{
+    IntervalMap::const_iterator it = m.upper_bound(e.first);
+    if (it != m.end() && !(e.last < it->first)) return true;
+    if (it != m.begin())
+    {
+        --it;
+        if (!(it->second < e.first)) return true;
+    }
+    return false;
+}
+
+static void addInterval(IntervalMap &m,
+                        const PolicyCompiler_ipt::PrintRuleNft::nftElement &e)
+{
+    InetAddr f = e.first;
+    InetAddr l = e.last;
+    IntervalMap::iterator it = m.upper_bound(f);
+    if (it != m.begin())
+    {
+        IntervalMap::iterator prev = it;
+        --prev;
+        if (!(prev->second < f))
+        {
+            f = prev->first;
+            if (l < prev->second) l = prev->second;
+            m.erase(prev);
+        }
+    }
+    while (it != m.end() && !(l < it->first))
+    {
+        if (l < it->second) l = it->second;
+        m.erase(it++);
+    }
+    m[f] = l;
+}
+
+static bool disjoint(
+    const vector<PolicyCompiler_ipt::PrintRuleNft::nftElement> &a,
+    const vector<PolicyCompiler_ipt::PrintRuleNft::nftElement> &b)
+{
+    IntervalMap m;
+    for (unsigned int i=0; i<a.size(); ++i) addInterval(m, a[i]);
+    for (unsigned int i=0; i<b.size(); ++i)
+        if (overlaps(m, b[i])) return false;
+    return true;
+}
+
+static bool sameElements(
+    const vector<PolicyCompiler_ipt::PrintRuleNft::nftElement> &a,
+    const vector<PolicyCompiler_ipt::PrintRuleNft::nftElement> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (unsigned int i=0; i<a.size(); ++i)
+        if (a[i].text != b[i].text) return false;
+    return true;
+}
+
+/*
+ * rules can be merged only if everything but addresses is the same
+ * and none of them uses negation
+ */
+static bool sameMatchAndAction(
+    const PolicyCompiler_ipt::PrintRuleNft::nftRule &a,
+    const PolicyCompiler_ipt::PrintRuleNft::nftRule &b)
+{
+    return (a.chain == b.chain &&
+            a.head == b.head &&
+            a.tail == b.tail &&
+            a.src_expr == b.src_expr &&
+            a.dst_expr == b.dst_expr &&
+            !a.src_neg && !b.src_neg &&
+            !a.dst_neg && !b.dst_neg &&
+            a.pairs.empty() && b.pairs.empty() &&
+            a.vmap.empty() && b.vmap.empty());
+}
+
+static string sanitizeSetName(const string &name)
+{
+    string res;
+    for (string::const_iterator i=name.begin(); i!=name.end(); ++i)
+    {
+        if (isalnum(*i) || *i=='_') res.push_back(*i);
+        else res.push_back('_');
+    }
+    if (res.empty() || isdigit(res[0])) res = "s_" + res;
+    return res;
+}
+
+
+/**
+ *-----------------------------------------------------------------------
+ *                    Methods for printing
+ */
+
+PolicyCompiler_ipt::PrintRuleNft::PrintRuleNft(const std::string &name) :
+    PrintRule(name)
+{
+    set_counter = 0;
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_family()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    return (ipt_comp->ipv6) ? "ip6" : "ip";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_addrType()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    return (ipt_comp->ipv6) ? "ipv6_addr" : "ipv4_addr";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_addrMatch(bool src)
+{
+    return _family() + ((src) ? " saddr " : " daddr ");
+}
+
+/*
+ *  check and create new chain if needed
+ */
+string PolicyCompiler_ipt::PrintRuleNft::_createChain(const string &chain)
+{
+    string res;
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    if (!minus_n_tracker_initialized) initializeMinusNTracker();
+
+    if ( ipt_comp->minus_n_commands->count(chain)==0 )
+    {
+        if ( ! compiler->inSingleRuleCompileMode())
+            res = "echo \"add chain " + _family() + " fwbuilder " +
+                chain + "\"\n";
+	(*(ipt_comp->minus_n_commands))[chain] = true;
+    }
+    return res;
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_startRuleLine()
+{
+    return "echo \"add rule " + _family() + " fwbuilder ";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_endRuleLine()
+{
+    return string("\"\n");
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_declareTable()
+{
+    return "";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_commit()
+{
+    return "";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_quote(const string &s)
+{
+    return "\\\"" + s + "\\\"";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printPorts(int rs,int re)
+{
+    std::ostringstream  str;
+
+    compiler->normalizePortRange(rs,re);
+
+    if (rs>0 || re>0) {
+	if (rs==re)  str << rs;
+	else         str << rs << "-" << re;
+    }
+    return str.str();
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printDirectionAndInterface(
+    PolicyRule *rule)
+{
+    if (rule->getStr(".iface") == "nil") return "";
+
+    RuleElementItf *itfrel = rule->getItf();
+    if (itfrel->isAny()) return "";
+
+    FWObject *rule_iface_obj = FWObjectReference::getObject(itfrel->front());
+    Interface *rule_iface = Interface::cast(rule_iface_obj);
+
+    if (rule_iface && rule_iface->isBridgePort())
+    {
+        compiler->abort(rule,
+                        "Bridge port interfaces are not supported "
+                        "with nftables");
+        return "";
+    }
+
+    string neg = (itfrel->getBool("single_object_negation")) ? "!= " : "";
+    string name = _quote(rule_iface_obj->getName());
+
+    if (rule->getDirection()==PolicyRule::Inbound)
+        return "iifname " + neg + name;
+
+    if (rule->getDirection()==PolicyRule::Outbound)
+        return "oifname " + neg + name;
+
+    return "";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printTimeInterval(PolicyRule *r)
+{
+    std::ostringstream  ostr;
+
+    RuleElementInterval* ri=r->getWhen();
+    if (ri==NULL || ri->isAny()) return "";
+
+    std::map<int,std::string>  daysofweek;
+
+    daysofweek[0]="Sunday";
+    daysofweek[1]="Monday";
+    daysofweek[2]="Tuesday";
+    daysofweek[3]="Wednesday";
+    daysofweek[4]="Thursday";
+    daysofweek[5]="Friday";
+    daysofweek[6]="Saturday";
+    daysofweek[7]="Sunday";
+
+    int smin, shour, sday, smonth, syear, sdayofweek;
+    int emin, ehour, eday, emonth, eyear, edayofweek;
+    string days_of_week;
+
+    Interval *interval = compiler->getFirstWhen(r);
+    assert(interval!=NULL);
+
+    interval->getStartTime( &smin, &shour, &sday, &smonth, &syear, &sdayofweek);
+    interval->getEndTime(   &emin, &ehour, &eday, &emonth, &eyear, &edayofweek);
+    days_of_week = interval->getDaysOfWeek();
+
+    if (shour<0) shour=0;
+    if (smin<0)  smin=0;
+
+    if (ehour<0) ehour=23;
+    if (emin<0)  emin=59;
+
+    bool have_dates = (sday>0 && smonth>0 && syear>0) ||
+        (eday>0 && emonth>0 && eyear>0);
+
+    if (have_dates)
+    {
+        std::ostringstream start, stop;
+
+        if (sday>0 && smonth>0 && syear>0)
+            start << setw(4) << setfill('0') << syear << "-"
+                  << setw(2) << setfill('0') << smonth << "-"
+                  << setw(2) << setfill('0') << sday << " ";
+        else
+            start << "1970-01-01 ";
+        start << setw(2) << setfill('0') << shour << ":"
+              << setw(2) << setfill('0') << smin << ":00";
+
+        if (eday>0 && emonth>0 && eyear>0)
+            stop << setw(4) << setfill('0') << eyear << "-"
+                 << setw(2) << setfill('0') << emonth << "-"
+                 << setw(2) << setfill('0') << eday << " ";
+        else
+            stop << "2038-01-19 ";
+        stop << setw(2) << setfill('0') << ehour << ":"
+             << setw(2) << setfill('0') << emin << ":00";
+
+        ostr << " meta time " << _quote(start.str())
+             << "-" << _quote(stop.str());
+    } else
+    {
+        std::ostringstream start, stop;
+        start << setw(2) << setfill('0') << shour << ":"
+              << setw(2) << setfill('0') << smin;
+        stop << setw(2) << setfill('0') << ehour << ":"
+             << setw(2) << setfill('0') << emin;
+
+        ostr << " meta hour " << _quote(start.str())
+             << "-" << _quote(stop.str());
+    }
+
+    if (!days_of_week.empty() && days_of_week != "0,1,2,3,4,5,6")
+    {
+        QStringList days;
+        istringstream istr(days_of_week);
+        while (!istr.eof())
+        {
+            int d;
+            istr >> d;
+            days << _quote(daysofweek[d]).c_str();
+            char sep;
+            istr >> sep;
+        }
+        ostr << " meta day { " << days.join(", ").toStdString() << " }";
+    }
+
+    return ostr.str();
+}
+
+/*
+ * Returns false if the object does not translate into an address
+ * match (for example "any" or an interface of a regular type, whose
+ * addresses have been substituted earlier).
+ */
+bool PolicyCompiler_ipt::PrintRuleNft::_makeElement(PolicyRule *rule,
+                                                    Address *o,
+                                                    nftElement &e)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    if (MultiAddressRunTime::cast(o)!=NULL)
+    {
+        compiler->abort(rule,
+                        "Address tables and DNS names resolved at run time "
+                        "are not supported with nftables");
+        return false;
+    }
+
+    if (Interface::cast(o)!=NULL)
+    {
+        if (Interface::cast(o)->isDyn())
+            compiler->abort(rule,
+                            "Addresses of dynamic interfaces are not "
+                            "supported with nftables");
+        return false;
+    }
+
+    if (AddressRange::cast(o)!=NULL)
+    {
+        AddressRange *ar = AddressRange::cast(o);
+        e.first = ar->getRangeStart();
+        e.last = ar->getRangeEnd();
+        if (e.first == e.last) e.text = e.first.toString();
+        else e.text = e.first.toString() + "-" + e.last.toString();
+        return true;
+    }
+
+    const InetAddr *addr = o->getAddressPtr();
+    const InetAddr *mask = o->getNetmaskPtr();
+
+    if (addr==NULL)
+    {
+        compiler->warning(
+            string("Empty inet address in object ") +
+            o->getName() + "(" +
+            FWObjectDatabase::getStringId(o->getId())
+            + ")");
+        return false;
+    }
+
+    if (addr->isAny() && (mask==NULL || mask->isAny())) return false;
+
+    InetAddr a(*addr);
+
+    if (o->dimension() > 1 && mask!=NULL && !mask->isHostMask())
+    {
+        InetAddr m(*mask);
+        e.first = a & m;
+        e.last = a | ~m;
+        ostringstream str;
+        str << e.first.toString() << "/" << mask->getLength();
+        e.text = str.str();
+    } else
+    {
+        e.first = a;
+        e.last = a;
+        e.text = a.toString();
+    }
+
+    /*
+     * Addresses of the wrong family should have been removed by now.
+     * Returning false here would have dropped the match and made the
+     * rule match any address.
+     */
+    if (e.first.isV6() != ipt_comp->ipv6)
+    {
+        compiler->abort(rule,
+                        string("Address ") + e.text + " of object " +
+                        o->getName() + " does not match address family "
+                        "of the rule");
+        return false;
+    }
+
+    return true;
+}
+
+void PolicyCompiler_ipt::PrintRuleNft::_printAddress(PolicyRule *rule,
+                                                     RuleElement *rel,
+                                                     bool src,
+                                                     nftRule &nr)
+{
+    FWObject *ref = rel->front();
+    Address *o = Address::cast(FWReference::cast(ref)->getPointer());
+    if (o==NULL)
+    {
+        compiler->abort(rule, string("Broken ") + ((src) ? "SRC" : "DST") +
+                        " in " + rule->getLabel());
+        return;
+    }
+
+    if (o->isAny()) return;
+
+    bool neg = rel->getBool("single_object_negation");
+
+    if (src && (physAddress::isA(o) || combinedAddress::isA(o)))
+    {
+        string physaddress;
+
+        if (physAddress::isA(o))
+        {
+            physaddress = physAddress::cast(o)->getPhysAddress();
+            if (physaddress.empty())
+            {
+                compiler->warning(rule, "Empty MAC address in rule");
+                physaddress = "00:00:00:00:00:00";
+            }
+        }
+
+        if (combinedAddress::isA(o))
+            physaddress = combinedAddress::cast(o)->getPhysAddress();
+
+        if (!physaddress.empty())
+        {
+            nr.src_expr = string("ether saddr ") + ((neg) ? "!= " : "") +
+                physaddress;
+            nr.src_neg = neg;
+        }
+
+        if (!o->hasInetAddress() || o->getAddressPtr()->isAny()) return;
+    }
+
+    nftElement e;
+    if (!_makeElement(rule, o, e)) return;
+
+    if (src)
+    {
+        nr.src.push_back(e);
+        nr.src_neg = neg;
+    } else
+    {
+        nr.dst.push_back(e);
+        nr.dst_neg = neg;
+    }
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftTCPFlags(TCPService *srv)
+{
+    if (!srv->inspectFlags()) return "";
+
+    const char *names[] = { "fin", "syn", "rst", "psh", "ack", "urg" };
+    TCPService::TCPFlag flags[] = { TCPService::FIN,
+                                    TCPService::SYN,
+                                    TCPService::RST,
+                                    TCPService::PSH,
+                                    TCPService::ACK,
+                                    TCPService::URG };
+    QStringList mask;
+    QStringList set;
+
+    for (int i=0; i<6; ++i)
+    {
+        if (srv->getTCPFlagMask(flags[i])) mask << names[i];
+        if (srv->getTCPFlag(flags[i])) set << names[i];
+    }
+
+    if (mask.isEmpty()) return "";
+
+    string res = "tcp flags & (" + mask.join("|").toStdString() + ") == ";
+    if (set.isEmpty()) res += "0x0";
+    else res += set.join("|").toStdString();
+    return res;
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftIP(IPService *srv,
+                                                     PolicyRule *rule)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    QStringList res;
+
+    if (srv->getBool("fragm") || srv->getBool("short_fragm"))
+    {
+        if (ipt_comp->ipv6) res << "frag more-fragments 1";
+        else res << "ip frag-off & 0x1fff != 0";
+    }
+
+    string dscp_match = (ipt_comp->ipv6) ? "ip6 dscp " : "ip dscp ";
+    string tos = srv->getTOSCode();
+    string dscp = srv->getDSCPCode();
+    if (!tos.empty())
+    {
+        // nftables does not have a match for the whole TOS byte, the
+        // six most significant bits of it are the DSCP field
+        ostringstream str;
+        str << dscp_match << (strtol(tos.c_str(), NULL, 0) >> 2);
+        res << str.str().c_str();
+    } else
+        if (!dscp.empty())
+        {
+            QString d = QString(dscp.c_str()).toLower();
+            if (d == "be") d = "cs0";
+            res << (dscp_match + d.toStdString()).c_str();
+        }
+
+    if (srv->hasIpOptions())
+    {
+        if (ipt_comp->ipv6)
+        {
+            compiler->abort(rule,
+                            "IP options match is not supported for IPv6.");
+            return "";
+        }
+
+        if (srv->getBool("any_opt") || srv->getBool("ts"))
+        {
+            compiler->abort(rule,
+                            "Matching any IP option or option timestamp "
+                            "is not supported with nftables");
+            return "";
+        }
+
+        if (srv->getBool("lsrr")) res << "ip option lsrr exists";
+        if (srv->getBool("ssrr")) res << "ip option ssrr exists";
+        if (srv->getBool("rr")) res << "ip option rr exists";
+        if (srv->getBool("rtralt")) res << "ip option ra exists";
+    }
+
+    return res.join(" ").toStdString();
+}
+
+/*
+ * we made sure that all services in the rule represent the same
+ * protocol. Unlike multiport module, nftables sets do not limit the
+ * number of ports
+ */
+string PolicyCompiler_ipt::PrintRuleNft::_printNftServices(PolicyRule *rule)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    RuleElementSrv *rel = rule->getSrv();
+    Service *srv = compiler->getFirstSrv(rule);
+
+    if (srv==NULL)
+    {
+        compiler->abort(rule, string("Broken SRV in ") + rule->getLabel());
+        return "";
+    }
+
+    if (srv->isAny()) return "";
+
+    bool neg = rel->getBool("single_object_negation");
+    string neg_str = (neg) ? "!= " : "";
+    QStringList res;
+
+    if (CustomService::isA(srv))
+    {
+        compiler->abort(rule,
+                        "Custom services are not supported with nftables");
+        return "";
+    }
+
+    if (ipt_comp->ipv6 && ICMPService::isA(srv))
+    {
+        compiler->abort(rule,
+                        "Can not use ICMPService in ipv6 rule; "
+                        "use ICMP6Service object instead");
+        return "";
+    }
+
+    if (!ipt_comp->ipv6 && ICMP6Service::isA(srv))
+    {
+        compiler->abort(rule,
+                        "Can not use ICMP6Service in ipv4 rule; "
+                        "use ICMPService object instead");
+        return "";
+    }
+
+    if (TCPService::isA(srv) || UDPService::isA(srv))
+    {
+        string proto = srv->getProtocolName();
+        QStringList sports;
+        QStringList dports;
+
+        for (FWObject::iterator i=rel->begin(); i!=rel->end(); i++)
+        {
+            FWObject *o = FWReference::getObject(*i);
+            Service *s = Service::cast(o);
+            assert(s);
+
+            string p = _printSrcPorts(s);
+            if (!p.empty()) sports << p.c_str();
+            p = _printDstPorts(s);
+            if (!p.empty()) dports << p.c_str();
+        }
+
+        string flags;
+        if (rel->size()==1 && TCPService::isA(srv))
+            flags = _printNftTCPFlags(TCPService::cast(srv));
+
+        if (neg && (!sports.isEmpty() + !dports.isEmpty() + !flags.empty()) > 1)
+        {
+            compiler->abort(rule,
+                            "Negation of a service that matches more than "
+                            "one of source port, destination port and tcp "
+                            "flags is not supported with nftables");
+            return "";
+        }
+
+        if (!sports.isEmpty())
+        {
+            string ports = (sports.size()==1) ? sports.front().toStdString() :
+                "{ " + sports.join(", ").toStdString() + " }";
+            res << (proto + " sport " + neg_str + ports).c_str();
+        }
+
+        if (!dports.isEmpty())
+        {
+            string ports = (dports.size()==1) ? dports.front().toStdString() :
+                "{ " + dports.join(", ").toStdString() + " }";
+            res << (proto + " dport " + neg_str + ports).c_str();
+        }
+
+        if (!flags.empty())
+        {
+            if (neg) flags.replace(flags.find("=="), 2, "!=");
+            res << flags.c_str();
+        }
+
+        if (res.isEmpty())
+            res << ("meta l4proto " + neg_str + proto).c_str();
+
+        return res.join(" ").toStdString();
+    }
+
+    if (ICMPService::isA(srv) || ICMP6Service::isA(srv))
+    {
+        string icmp = (ipt_comp->ipv6) ? "icmpv6" : "icmp";
+        if (srv->getInt("type")==-1)
+            return "meta l4proto " + neg_str +
+                ((ipt_comp->ipv6) ? "ipv6-icmp" : "icmp");
+
+        if (neg && srv->getInt("code")!=-1)
+        {
+            compiler->abort(rule,
+                            "Negation of ICMP service with both type and "
+                            "code is not supported with nftables");
+            return "";
+        }
+
+        string res = icmp + " type " + neg_str + srv->getStr("type");
+        if (srv->getInt("code")!=-1)
+            res += " " + icmp + " code " + srv->getStr("code");
+        return res;
+    }
+
+    if (IPService::isA(srv))
+    {
+        int proto = srv->getProtocolNumber();
+        string ip = _printNftIP(IPService::cast(srv), rule);
+
+        if (neg && !ip.empty())
+        {
+            compiler->abort(rule,
+                            "Negation of IP service with fragment, TOS, DSCP "
+                            "or option match is not supported with nftables");
+            return "";
+        }
+
+        if (proto!=0)
+        {
+            ostringstream str;
+            str << "meta l4proto " << neg_str << proto;
+            res << str.str().c_str();
+        }
+        if (!ip.empty()) res << ip.c_str();
+        return res.join(" ").toStdString();
+    }
+
+    if (TagService::isA(srv))
+        return "meta mark " + neg_str + TagService::constcast(srv)->getCode();
+
+    if (UserService::isA(srv))
+        return "meta skuid " + neg_str + UserService::cast(srv)->getUserId();
+
+    return "";
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftLimit(PolicyRule *rule)
+{
+    std::ostringstream ostr;
+
+    string target = rule->getStr(ipt_target);
+    FWOptions *ruleopt = rule->getOptionsObject();
+    FWOptions *opt = ruleopt;
+    int lim = 0;
+    bool neg = false;
+
+    /*
+     * see comment in PrintRule::_printModules(): limit set globally
+     * applies only to logging, limit set in the rule options applies
+     * to the rule's target
+     */
+    if (target=="LOG") opt = compiler->getCachedFwOpt();
+    else if (ruleopt!=NULL) neg = ruleopt->getBool("limit_value_not");
+
+    if (opt!=NULL && (lim=opt->getInt("limit_value"))>0)
+    {
+        string ls = opt->getStr("limit_suffix");
+        if (ls.empty()) ls = "/second";
+
+        ostr << "limit rate " << ((neg) ? "over " : "") << lim << ls;
+
+        int lb = opt->getInt("limit_burst");
+        if (lb>0) ostr << " burst " << lb << " packets";
+    }
+
+    if (ruleopt!=NULL && ruleopt->getInt("connlimit_value")>0)
+        compiler->abort(rule,
+                        "Option connlimit is not supported with nftables");
+
+    if (ruleopt!=NULL && ruleopt->getInt("hashlimit_value")>0)
+        compiler->abort(rule,
+                        "Option hashlimit is not supported with nftables");
+
+    return ostr.str();
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftLogParameters(
+    PolicyRule *rule)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    FWOptions *compopt = compiler->getCachedFwOpt();
+    FWOptions *ruleopt = rule->getOptionsObject();
+    std::ostringstream str;
+    string s;
+
+    str << "log";
+
+    // ULOG is replaced with nflog, which is what "log group" uses
+    bool use_ulog = (!ipt_comp->ipv6 && compopt->getBool("use_ULOG"));
+
+    if (use_ulog)
+    {
+        s = ruleopt->getStr("ulog_nlgroup");
+        if (s.empty())  s = compopt->getStr("ulog_nlgroup");
+        if (s.empty())  s = "0";
+        str << " group " << s;
+    }
+
+    s = ruleopt->getStr("log_prefix");
+    if (s.empty())  s = compopt->getStr("log_prefix");
+    if (!s.empty())
+        str << " prefix " << _printLogPrefix(rule, s);
+
+    if (!use_ulog)
+    {
+        s = ruleopt->getStr("log_level");
+        if (s.empty())  s = compopt->getStr("log_level");
+        if (!s.empty())
+        {
+            if (s=="error")   s = "err";
+            if (s=="warning") s = "warn";
+            str << " level " << s;
+        }
+
+        QStringList tcp_flags;
+        if (ruleopt->getBool("log_tcp_seq") || compopt->getBool("log_tcp_seq"))
+            tcp_flags << "sequence";
+        if (ruleopt->getBool("log_tcp_opt") || compopt->getBool("log_tcp_opt"))
+            tcp_flags << "options";
+        if (!tcp_flags.isEmpty())
+            str << " flags tcp " << tcp_flags.join(",").toStdString();
+        if (ruleopt->getBool("log_ip_opt") || compopt->getBool("log_ip_opt"))
+            str << " flags ip options";
+    }
+
+    return str.str();
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftReject(PolicyRule *rule)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    string s = ipt_comp->getActionOnReject(rule);
+    if (s.empty()) return "reject";
+
+    if (ipt_comp->isActionOnRejectTCPRST(rule))
+        return "reject with tcp reset";
+
+    if (s.find("ICMP")!=string::npos)
+    {
+        if (ipt_comp->ipv6)
+        {
+            if (s.find("unreachable")!=string::npos)
+            {
+                if (s.find("net")!=string::npos ||
+                    s.find("host")!=string::npos)
+                    return "reject with icmpv6 type addr-unreachable";
+                if (s.find("port")!=string::npos ||
+                    s.find("proto")!=string::npos)
+                    return "reject with icmpv6 type port-unreachable";
+            }
+            if (s.find("prohibited")!=string::npos)
+                return "reject with icmpv6 type admin-prohibited";
+        } else
+        {
+            if (s.find("unreachable")!=string::npos)
+            {
+                if (s.find("net")!=string::npos)
+                    return "reject with icmp type net-unreachable";
+                if (s.find("host")!=string::npos)
+                    return "reject with icmp type host-unreachable";
+                if (s.find("port")!=string::npos)
+                    return "reject with icmp type port-unreachable";
+                if (s.find("proto")!=string::npos)
+                    return "reject with icmp type prot-unreachable";
+            }
+            if (s.find("prohibited")!=string::npos)
+            {
+                if (s.find("net")!=string::npos)
+                    return "reject with icmp type net-prohibited";
+                if (s.find("host")!=string::npos)
+                    return "reject with icmp type host-prohibited";
+                if (s.find("admin")!=string::npos)
+                    return "reject with icmp type admin-prohibited";
+            }
+        }
+    }
+    return "reject";
+}
+
+/*
+ * pure_verdict is set for actions that can be used as a value in a
+ * verdict map. terminating is set for actions that stop evaluation
+ * of the chain, rules with these actions can be merged even if their
+ * addresses overlap because only the first match has an effect.
+ */
+string PolicyCompiler_ipt::PrintRuleNft::_printNftAction(PolicyRule *rule,
+                                                         bool &pure_verdict,
+                                                         bool &terminating)
+{
+    string target = rule->getStr(ipt_target);
+    if (target.empty()) target = "UNKNOWN";
+
+    pure_verdict = false;
+    terminating = false;
+
+    if (rule->getTagging() || rule->getClassification() || rule->getRouting())
+    {
+        compiler->abort(rule,
+                        "Options Tag, Classify and Route are not supported "
+                        "in the filter table with nftables");
+        return "";
+    }
+
+    if (target==".CUSTOM" || target=="CONNMARK" || target=="MARK" ||
+        target=="CLASSIFY" || target=="ROUTE")
+    {
+        compiler->abort(rule,
+                        "Target " + target + " is not supported with nftables");
+        return "";
+    }
+
+    if (target==".CONTINUE") return "";
+
+    if (target=="ACCEPT" || target=="DROP" || target=="RETURN")
+    {
+        pure_verdict = true;
+        terminating = true;
+        return QString(target.c_str()).toLower().toStdString();
+    }
+
+    if (target=="REJECT")
+    {
+        terminating = true;
+        return _printNftReject(rule);
+    }
+
+    if (target=="QUEUE")
+    {
+        terminating = true;
+        return "queue";
+    }
+
+    if (target=="LOG") return _printNftLogParameters(rule);
+
+    pure_verdict = true;
+    return "jump " + target;
+}
+
+void PolicyCompiler_ipt::PrintRuleNft::_convertRule(PolicyRule *rule,
+                                                    nftRule &nr)
+{
+    FWOptions *ruleopt = rule->getOptionsObject();
+
+    nr.rules.push_back(rule);
+    nr.chain = rule->getStr(ipt_chain);
+    nr.head = _printDirectionAndInterface(rule);
+
+    _printAddress(rule, rule->getSrc(), true, nr);
+    _printAddress(rule, rule->getDst(), false, nr);
+
+    QStringList tail;
+    string s = _printNftServices(rule);
+    if (!s.empty()) tail << s.c_str();
+
+    if (!ruleopt->getBool("stateless") || rule->getBool("force_state_check"))
+        tail << "ct state new";
+
+    s = _printTimeInterval(rule);
+    if (!s.empty()) tail << QString(s.c_str()).trimmed();
+
+    s = _printNftLimit(rule);
+    if (!s.empty()) tail << s.c_str();
+
+    nr.tail = tail.join(" ").toStdString();
+    nr.action = _printNftAction(rule, nr.pure_verdict, nr.terminating);
+}
+
+/*
+ * Merge adjacent rules that differ only in source (on_src==true) or
+ * destination address. Rules with actions that do not terminate
+ * evaluation of the chain are merged only if their addresses do not
+ * overlap, otherwise a packet that used to match two rules would
+ * match only one.
+ */
+bool PolicyCompiler_ipt::PrintRuleNft::_mergeAddressSets(
+    vector<nftRule> &rules, bool on_src)
+{
+    vector<nftRule> res;
+    bool changed = false;
+
+    for (vector<nftRule>::iterator it=rules.begin(); it!=rules.end(); ++it)
+    {
+        if (!res.empty())
+        {
+            nftRule &prev = res.back();
+            vector<nftElement> &prev_elements = (on_src) ? prev.src : prev.dst;
+            vector<nftElement> &elements = (on_src) ? it->src : it->dst;
+            vector<nftElement> &prev_other = (on_src) ? prev.dst : prev.src;
+            vector<nftElement> &other = (on_src) ? it->dst : it->src;
+
+            if (sameMatchAndAction(prev, *it) &&
+                prev.action == it->action &&
+                !prev_elements.empty() && !elements.empty() &&
+                sameElements(prev_other, other) &&
+                (prev.terminating || disjoint(prev_elements, elements)))
+            {
+                prev_elements.insert(prev_elements.end(),
+                                     elements.begin(), elements.end());
+                prev.rules.insert(prev.rules.end(),
+                                  it->rules.begin(), it->rules.end());
+                changed = true;
+                continue;
+            }
+        }
+        res.push_back(*it);
+    }
+
+    rules.swap(res);
+    return changed;
+}
+
+/*
+ * Merge adjacent rules that match single host in both source and
+ * destination and differ in both. Result is a set of concatenated
+ * "saddr . daddr" keys. Only rules with terminating actions are
+ * merged.
+ */
+void PolicyCompiler_ipt::PrintRuleNft::_mergeConcatenatedSets(
+    vector<nftRule> &rules)
+{
+    vector<nftRule> res;
+
+    for (vector<nftRule>::iterator it=rules.begin(); it!=rules.end(); ++it)
+    {
+        bool candidate = (it->terminating &&
+                          it->src.size()==1 && it->src.front().isHost() &&
+                          it->dst.size()==1 && it->dst.front().isHost());
+
+        if (candidate && !res.empty())
+        {
+            nftRule &prev = res.back();
+            nftRule tmp = prev;
+            tmp.pairs.clear();
+
+            bool prev_candidate =
+                prev.terminating &&
+                ((!prev.pairs.empty() && prev.src.empty() && prev.dst.empty()) ||
+                 (prev.src.size()==1 && prev.src.front().isHost() &&
+                  prev.dst.size()==1 && prev.dst.front().isHost()));
+
+            if (prev_candidate &&
+                sameMatchAndAction(tmp, *it) &&
+                prev.action == it->action)
+            {
+                if (prev.pairs.empty())
+                {
+                    prev.pairs.push_back(
+                        make_pair(prev.src.front(), prev.dst.front()));
+                    prev.src.clear();
+                    prev.dst.clear();
+                }
+                prev.pairs.push_back(
+                    make_pair(it->src.front(), it->dst.front()));
+                prev.rules.insert(prev.rules.end(),
+                                  it->rules.begin(), it->rules.end());
+                continue;
+            }
+        }
+        res.push_back(*it);
+    }
+
+    rules.swap(res);
+}
+
+/*
+ * Merge adjacent rules that differ in source (on_src==true) or
+ * destination address and action into one rule with verdict map.
+ * Keys of the map must not overlap since map lookup does not
+ * preserve order of the original rules.
+ */
+void PolicyCompiler_ipt::PrintRuleNft::_mergeVerdictMaps(
+    vector<nftRule> &rules, bool on_src)
+{
+    vector<nftRule> res;
+    IntervalMap keys;
+
+    for (vector<nftRule>::iterator it=rules.begin(); it!=rules.end(); ++it)
+    {
+        vector<nftElement> &elements = (on_src) ? it->src : it->dst;
+
+        if (!res.empty() && it->pure_verdict && !elements.empty())
+        {
+            nftRule &prev = res.back();
+            vector<nftElement> &prev_elements = (on_src) ? prev.src : prev.dst;
+            vector<nftElement> &prev_other = (on_src) ? prev.dst : prev.src;
+            vector<nftElement> &other = (on_src) ? it->dst : it->src;
+
+            nftRule tmp = prev;
+            tmp.vmap.clear();
+
+            bool prev_candidate =
+                (!prev.vmap.empty() && prev.vmap_on_src==on_src) ||
+                (prev.vmap.empty() && prev.pure_verdict &&
+                 !prev_elements.empty());
+
+            if (prev_candidate &&
+                sameMatchAndAction(tmp, *it) &&
+                sameElements(prev_other, other))
+            {
+                IntervalMap new_keys;
+                bool ok = true;
+
+                if (prev.vmap.empty())
+                {
+                    for (unsigned int i=0; ok && i<prev_elements.size(); ++i)
+                    {
+                        if (overlaps(new_keys, prev_elements[i])) ok = false;
+                        else addInterval(new_keys, prev_elements[i]);
+                    }
+                } else
+                    new_keys = keys;
+
+                for (unsigned int i=0; ok && i<elements.size(); ++i)
+                {
+                    if (overlaps(new_keys, elements[i])) ok = false;
+                    else addInterval(new_keys, elements[i]);
+                }
+
+                if (ok)
+                {
+                    if (prev.vmap.empty())
+                    {
+                        for (unsigned int i=0; i<prev_elements.size(); ++i)
+                            prev.vmap.push_back(
+                                make_pair(prev_elements[i], prev.action));
+                        prev_elements.clear();
+                        prev.action = "";
+                        prev.vmap_on_src = on_src;
+                    }
+                    for (unsigned int i=0; i<elements.size(); ++i)
+                        prev.vmap.push_back(
+                            make_pair(elements[i], it->action));
+                    prev.rules.insert(prev.rules.end(),
+                                      it->rules.begin(), it->rules.end());
+                    keys = new_keys;
+                    continue;
+                }
+            }
+        }
+        res.push_back(*it);
+    }
+
+    rules.swap(res);
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printElements(
+    const vector<nftElement> &elements, bool &interval)
+{
+    QStringList res;
+    interval = false;
+    for (vector<nftElement>::const_iterator i=elements.begin();
+         i!=elements.end(); ++i)
+    {
+        res << i->text.c_str();
+        if (!i->isHost()) interval = true;
+    }
+    return res.join(", ").toStdString();
+}
+
+/*
+ * Named sets and maps are declared right before the rule that uses
+ * them. Identical sets used by several rules are declared only once.
+ */
+string PolicyCompiler_ipt::PrintRuleNft::_declareSet(const string &key_type,
+                                                     bool interval,
+                                                     const string &elements,
+                                                     bool map,
+                                                     string &decl)
+{
+    string key = key_type + ((map) ? " : verdict" : "") + "|" + elements;
+    if (named_sets.count(key) > 0) return named_sets[key];
+
+    ostringstream name;
+    name << sanitizeSetName(compiler->getRuleSetName()) << "_" << ++set_counter;
+    named_sets[key] = name.str();
+
+    ostringstream str;
+    str << "echo \"add " << ((map) ? "map " : "set ") << _family()
+        << " fwbuilder " << name.str()
+        << " { type " << key_type << ((map) ? " : verdict" : "") << ";";
+    if (interval)
+    {
+        str << " flags interval;";
+        if (!map) str << " auto-merge;";
+    }
+    str << " }\"" << endl;
+    str << "echo \"add element " << _family() << " fwbuilder " << name.str()
+        << " { " << elements << " }\"" << endl;
+
+    decl += str.str();
+    return name.str();
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printAddrSet(
+    const vector<nftElement> &elements, bool neg, bool src, string &decl)
+{
+    string res = _addrMatch(src) + ((neg) ? "!= " : "");
+    if (elements.size()==1) return res + elements.front().text;
+
+    bool interval;
+    string el = _printElements(elements, interval);
+    return res + "@" + _declareSet(_addrType(), interval, el, false, decl);
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printNftRule(nftRule &nr)
+{
+    string decl;
+    QStringList cmd;
+
+    cmd << nr.chain.c_str();
+    if (!nr.head.empty()) cmd << nr.head.c_str();
+    if (!nr.src_expr.empty()) cmd << nr.src_expr.c_str();
+
+    if (!nr.pairs.empty())
+    {
+        QStringList el;
+        for (unsigned int i=0; i<nr.pairs.size(); ++i)
+            el << (nr.pairs[i].first.text + " . " +
+                   nr.pairs[i].second.text).c_str();
+        string name = _declareSet(_addrType() + " . " + _addrType(), false,
+                                  el.join(", ").toStdString(), false, decl);
+        cmd << (_addrMatch(true) + ". " + _addrMatch(false) +
+                "@" + name).c_str();
+    } else
+    {
+        if (!nr.src.empty())
+            cmd << _printAddrSet(nr.src, nr.src_neg, true, decl).c_str();
+        if (!nr.dst_expr.empty()) cmd << nr.dst_expr.c_str();
+        if (!nr.dst.empty())
+            cmd << _printAddrSet(nr.dst, nr.dst_neg, false, decl).c_str();
+    }
+
+    if (!nr.tail.empty()) cmd << nr.tail.c_str();
+
+    if (!nr.vmap.empty())
+    {
+        QStringList el;
+        bool interval = false;
+        for (unsigned int i=0; i<nr.vmap.size(); ++i)
+        {
+            el << (nr.vmap[i].first.text + " : " + nr.vmap[i].second).c_str();
+            if (!nr.vmap[i].first.isHost()) interval = true;
+        }
+        string name = _declareSet(_addrType(), interval,
+                                  el.join(", ").toStdString(), true, decl);
+        cmd << (_addrMatch(nr.vmap_on_src) + "vmap @" + name).c_str();
+    } else
+        if (!nr.action.empty()) cmd << nr.action.c_str();
+
+    return decl + _startRuleLine() + cmd.join(" ").toStdString() +
+        _endRuleLine();
+}
+
+/*
+ * This processor works on the whole rule set: merging of the rules
+ * requires looking at their neighbours.
+ */
+bool PolicyCompiler_ipt::PrintRuleNft::processNext()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    slurp();
+    if (tmp_queue.size()==0) return false;
+
+    vector<nftRule> rules;
+    deque<Rule*> printed;
+
+    for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k)
+    {
+        PolicyRule *rule = PolicyRule::cast( *k );
+        if (ipt_comp->chain_usage_counter[rule->getStr(ipt_chain)] == 0)
+            continue;
+        printed.push_back(rule);
+        nftRule nr;
+        _convertRule(rule, nr);
+        rules.push_back(nr);
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = _mergeAddressSets(rules, true);
+        changed = _mergeAddressSets(rules, false) || changed;
+    }
+
+    _mergeConcatenatedSets(rules);
+    _mergeVerdictMaps(rules, true);
+    _mergeVerdictMaps(rules, false);
+
+    for (vector<nftRule>::iterator it=rules.begin(); it!=rules.end(); ++it)
+    {
+        for (list<PolicyRule*>::iterator r=it->rules.begin();
+             r!=it->rules.end(); ++r)
+        {
+            compiler->output << _printRuleLabel(*r);
+            compiler->output << _createChain((*r)->getStr(ipt_chain));
+
+            string target = (*r)->getStr(ipt_target);
+            if (target[0] != '.') compiler->output << _createChain(target);
+        }
+        compiler->output << _printNftRule(*it);
+    }
+
+    tmp_queue.swap(printed);
+    return true;
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_clampTcpToMssRule()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    ostringstream res;
+
+    if ( compiler->getCachedFwOpt()->getBool("clamp_mss_to_mtu"))
+    {
+        string s = compiler->getCachedFwOpt()->getStr(
+            (ipt_comp->ipv6) ? "linux24_ipv6_forward" : "linux24_ip_forward");
+        bool ipforw = (s.empty() || s=="1" || s=="On" || s=="on");
+
+        if (ipforw)
+        {
+            res << _startRuleLine()
+                << "FORWARD tcp flags & (syn|rst) == syn "
+                << "tcp option maxseg size set rt mtu"
+                << _endRuleLine();
+            res << endl;
+        }
+    }
+    return res.str();
+}
+
+string PolicyCompiler_ipt::PrintRuleNft::_printOptionalGlobalRules()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    FWOptions *compopt = compiler->getCachedFwOpt();
+    bool isIPv6 = ipt_comp->ipv6;
+
+    string s = compopt->getStr("linux24_ip_forward");
+    bool ipforward= (s.empty() || s=="1" || s=="On" || s=="on");
+    s = compopt->getStr("linux24_ipv6_forward");
+    bool ip6forward= (s.empty() || s=="1" || s=="On" || s=="on");
+    bool ipforw = ((!isIPv6 && ipforward) || (isIPv6 && ip6forward));
+
+    Configlet configlet(compiler->fw, "linux24", "automatic_rules_nft");
+    configlet.removeComments();
+    configlet.collapseEmptyStrings(true);
+
+    configlet.setVariable("begin_rule", _startRuleLine().c_str());
+    configlet.setVariable("end_rule", _endRuleLine().c_str());
+    configlet.setVariable("addr_family", _family().c_str());
+
+    configlet.setVariable("ipforw", ipforw);
+    configlet.setVariable("accept_established",
+                          compopt->getBool("accept_established") &&
+                          ipt_comp->my_table=="filter");
+
+    list<FWObject*> ll = compiler->fw->getByTypeDeep(Interface::TYPENAME);
+    for (FWObject::iterator i=ll.begin(); i!=ll.end(); i++)
+    {
+        Interface *intf = Interface::cast( *i );
+        if (intf->isManagement())
+        {
+            configlet.setVariable("management_interface",
+                                  intf->getName().c_str());
+            break;
+        }
+    }
+
+    _printBackupSSHAccessRules(&configlet);
+
+    // nft does not accept netmask in dotted notation, print prefix length
+    if (compopt->getBool("mgmt_ssh") && !compopt->getStr("mgmt_addr").empty())
+    {
+        try
+        {
+            InetAddrMask *inet_addr = (isIPv6) ?
+                new Inet6AddrMask(compopt->getStr("mgmt_addr")) :
+                new InetAddrMask(compopt->getStr("mgmt_addr"));
+            ostringstream str;
+            str << inet_addr->getAddressPtr()->toString();
+            if (!inet_addr->getNetmaskPtr()->isHostMask())
+                str << "/" << inet_addr->getNetmaskPtr()->getLength();
+            configlet.setVariable("ssh_management_address", str.str().c_str());
+            delete inet_addr;
+        } catch(const FWException &ex)  {
+            // _printBackupSSHAccessRules() has issued warning already
+        }
+    }
+
+    configlet.setVariable(
+        "drop_new_tcp_with_no_syn",
+        ! compopt->getBool("accept_new_tcp_with_no_syn"));
+
+    configlet.setVariable("bridging_firewall", compopt->getBool("bridging_fw"));
+
+    configlet.setVariable(
+        "add_rules_for_ipv6_neighbor_discovery",
+        isIPv6 && compopt->getBool("add_rules_for_ipv6_neighbor_discovery"));
+
+    configlet.setVariable("drop_invalid",
+                          compopt->getBool("drop_invalid") &&
+                          !compopt->getBool("log_invalid"));
+
+    configlet.setVariable("drop_invalid_and_log",
+                          compopt->getBool("drop_invalid") &&
+                          compopt->getBool("log_invalid"));
+
+    configlet.setVariable("create_drop_invalid_chain",
+                          _createChain("drop_invalid").c_str());
+
+    if (compopt->getBool("log_invalid") && !isIPv6 &&
+        compopt->getBool("use_ULOG"))
+    {
+        configlet.setVariable("use_ulog", 1);
+        string s = compopt->getStr("ulog_nlgroup");
+        configlet.setVariable("nlgroup", (s.empty()) ? "0" : s.c_str());
+    } else
+        configlet.setVariable("not_use_ulog", 1);
+
+    configlet.setVariable("invalid_match_log_prefix",
+                          _printLogPrefix("-1",
+                                          "DENY",
+                                          "global",
+                                          "drop_invalid",
+                                          "Policy",
+                                          "BLOCK INVALID",
+                                          "INVALID state -- DENY ").c_str());
+
+    return configlet.expand().toStdString();
+}
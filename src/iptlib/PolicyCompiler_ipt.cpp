@@ -58,6 +58,8 @@
 
 #include "combinedAddress.h"
 
+#include "fwcompiler/PortRangeSet.h"
+
 #include <stack>
 #include <iomanip>
 #include <fstream>
@@ -157,8 +159,8 @@ string PolicyCompiler_ipt::findUpstreamChain(const string &chain_name)
 
 void PolicyCompiler_ipt::setChain(PolicyRule *rule, const string &chain_name)
 {
-    rule->setStr("ipt_chain", chain_name);
-    string target = rule->getStr("ipt_target");
+    rule->setStr(ipt_chain, chain_name);
+    string target = rule->getStr(ipt_target);
     if (!target.empty())
     {
         registerChain(target);
@@ -168,7 +170,7 @@ void PolicyCompiler_ipt::setChain(PolicyRule *rule, const string &chain_name)
 
 string PolicyCompiler_ipt::printChains(PolicyRule *rule)
 {
-    string chain_name = rule->getStr("ipt_chain");
+    string chain_name = rule->getStr(ipt_chain);
     map<string, chain_list*>::iterator i = chains.find(chain_name);
     if (i==chains.end() || i->second->size()==0) return chain_name;
     ostringstream res;
@@ -296,7 +298,7 @@ string PolicyCompiler_ipt::getNewChainName(PolicyRule *rule,
     else // special case: position == -1
         str << "000";
 
-    string suffix = rule->getStr("subrule_suffix");
+    string suffix = rule->getStr(subrule_suffix);
     if (!suffix.empty()) str << "_" << suffix;
 
     string chain_name = str.str();
@@ -479,6 +481,20 @@ int PolicyCompiler_ipt::prolog()
                           fwopt->getBool("use_m_set"));
     actually_used_module_set = false;
 
+    // ipsets for large groups are loaded with ipset restore (ipset 6
+    // syntax, hash:net) and matched with --match-set, so this requires
+    // the same iptables version as ipset restore for run-time address
+    // tables. The nftables backend builds its own sets.
+    OSConfigurator_linux24 *linux_osconf =
+        dynamic_cast<OSConfigurator_linux24*>(osconfigurator);
+    using_ipset_for_groups = (using_ipset &&
+                              linux_osconf != NULL &&
+                              linux_osconf->usingIpSetRestore() &&
+                              fwopt->getBool("use_m_set_for_groups") &&
+                              !usingNftables());
+    ipset_group_threshold = fwopt->getInt("m_set_group_threshold");
+    if (ipset_group_threshold < 2) ipset_group_threshold = 100;
+
     build_interface_groups(dbcopy, persistent_objects, fw, ipv6, regular_interfaces);
 
     // count bridge interfaces. We need this later in
@@ -510,8 +526,8 @@ bool  PolicyCompiler_ipt::SkipActionContinueWithNoLogging::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_target").empty() &&
-         rule->getStr("ipt_target") == ".CONTINUE" &&
+    if ( ! rule->getStr(ipt_target).empty() &&
+         rule->getStr(ipt_target) == ".CONTINUE" &&
          ! rule->getLogging() &&
          ! rule->getTagging() &&
          ! rule->getClassification() &&
@@ -528,7 +544,7 @@ bool  PolicyCompiler_ipt::SkipActionContinueWithNoLogging::processNext()
 bool  PolicyCompiler_ipt::dropTerminatingTargets::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
-    string tgt = rule->getStr("ipt_target");
+    string tgt = rule->getStr(ipt_target);
 
     if (tgt=="CLASSIFY" || tgt=="MARK") tmp_queue.push_back(rule);
     return true;
@@ -610,7 +626,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
         Q_UNUSED(r);
         Q_UNUSED(r2);
 
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(ipt_chain);
         string new_chain  = this_chain;
 
         nsrc = rule->getSrc();
@@ -627,8 +643,8 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             r = compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
             r->duplicate(rule);
-            r->setStr("subrule_suffix", "ntt");
-            r->setStr("ipt_target", new_chain);
+            r->setStr(subrule_suffix, "ntt");
+            r->setStr(ipt_target, new_chain);
             r->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
@@ -657,8 +673,8 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             r->setClassification(false);
             r->setRouting(false);
             rule->setTagging(false);
-            r->setStr("ipt_chain", new_chain);
-            r->setStr("upstream_rule_chain", this_chain);
+            r->setStr(ipt_chain, new_chain);
+            r->setStr(upstream_rule_chain, this_chain);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
         }
@@ -671,8 +687,8 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             rule->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
-            r->setStr("ipt_chain", new_chain);
-            r->setStr("upstream_rule_chain", this_chain);
+            r->setStr(ipt_chain, new_chain);
+            r->setStr(upstream_rule_chain, this_chain);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
         }
@@ -688,8 +704,8 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
         {
             rule->setClassification(false);
             rule->setTagging(false);
-            rule->setStr("ipt_chain", new_chain);
-            rule->setStr("upstream_rule_chain", this_chain);
+            rule->setStr(ipt_chain, new_chain);
+            rule->setStr(upstream_rule_chain, this_chain);
             tmp_queue.push_back(rule);
         }
         
@@ -723,7 +739,7 @@ bool PolicyCompiler_ipt::InterfacePolicyRulesWithOptimization::processNext()
         PolicyRule *r = compiler->dbcopy->createPolicyRule();
         compiler->temp_ruleset->add(r);
         r->duplicate(rule);
-        r->setStr("subrule_suffix", "i1");
+        r->setStr(subrule_suffix, "i1");
         //r->setInterfaceId(o->getId());
         RuleElementItf *nitfre = r->getItf();
         nitfre->reset(); nitfre->addRef(o);
@@ -936,7 +952,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
               ! rule->getClassification() &&
               ! rule->getRouting()))
         {
-            rule->setStr("ipt_target", "LOG");
+            rule->setStr(ipt_target, "LOG");
             tmp_queue.push_back(rule);
             return true;
         }
@@ -944,7 +960,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
 /* 
  * chain could have been assigned if we split this rule before
  */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(ipt_chain);
 	string new_chain  = ipt_comp->getNewChainName(rule, NULL); //rule_iface);
 
 	PolicyRule *r;
@@ -976,7 +992,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
             compiler->temp_ruleset->add(r);
             r->duplicate(rule);
             ruleopt =r->getOptionsObject();
-            r->setStr("ipt_target",new_chain);
+            r->setStr(ipt_target,new_chain);
             r->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
@@ -1006,12 +1022,12 @@ bool PolicyCompiler_ipt::Logging2::processNext()
 	nsrv=r->getSrv();      nsrv->reset();
         nitfre=r->getItf();    nitfre->reset();
 	if ( (nint=r->getWhen())!=NULL )  nint->reset();
-	r->setStr("ipt_chain",new_chain);
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	r->setStr("ipt_target","LOG");
+	r->setStr(ipt_target,"LOG");
         r->setAction(PolicyRule::Continue);    // ###
 	r->setDirection( PolicyRule::Both );
 	r->setLogging(false);
@@ -1050,8 +1066,8 @@ bool PolicyCompiler_ipt::Logging2::processNext()
             nsrv->reset();
         }
 
-	r->setStr("ipt_chain",new_chain);
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -1175,7 +1191,7 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain  = rule->getStr("ipt_chain");
+        string this_chain  = rule->getStr(ipt_chain);
 	string new_chain   = ipt_comp->getNewTmpChainName(rule);
 	srcrel->setNeg(false);
 
@@ -1185,13 +1201,13 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","1");
+        r->setStr(subrule_suffix,"1");
 	nsrc=r->getSrc();  nsrc->reset();
         r->setClassification(false);
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1204,7 +1220,7 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","2");
+        r->setStr(subrule_suffix,"2");
 
         if (!shadowing_mode)
         {
@@ -1219,9 +1235,9 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
- 	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
-        r->setStr("upstream_rule_chain",this_chain);
+ 	r->setStr(ipt_chain,new_chain);
+	r->setStr(ipt_target,"");
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -1237,7 +1253,7 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","3");
+        r->setStr(subrule_suffix,"3");
 
         nsrc=r->getSrc();   nsrc->reset();
 
@@ -1263,13 +1279,13 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(ipt_target).empty() )
+	    r->setStr(ipt_target,rule->getStr(ipt_target));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1305,7 +1321,7 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain  = rule->getStr("ipt_chain");
+        string this_chain  = rule->getStr(ipt_chain);
 	string new_chain   = ipt_comp->getNewTmpChainName(rule);
 	dstrel->setNeg(false);
 
@@ -1315,13 +1331,13 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","1");
+        r->setStr(subrule_suffix,"1");
 	ndst=r->getDst();  ndst->reset();
         r->setClassification(false);
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1334,7 +1350,7 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","2");
+        r->setStr(subrule_suffix,"2");
 
         if (!shadowing_mode)
         {
@@ -1349,9 +1365,9 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+	r->setStr(ipt_target,"");
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -1369,7 +1385,7 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","3");
+        r->setStr(subrule_suffix,"3");
 
         ndst=r->getDst();   ndst->reset();
 
@@ -1395,14 +1411,14 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+	r->setStr(ipt_target,"");
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(ipt_target).empty() )
+	    r->setStr(ipt_target,rule->getStr(ipt_target));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1439,7 +1455,7 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(ipt_chain);
 	string new_chain  = ipt_comp->getNewTmpChainName(rule);
 	srvrel->setNeg(false);
 
@@ -1448,13 +1464,13 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","1");
+        r->setStr(subrule_suffix,"1");
 	nsrv=r->getSrv();  nsrv->reset();
         r->setClassification(false);
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1466,7 +1482,7 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","2");
+        r->setStr(subrule_suffix,"2");
 
         if (!shadowing_mode)
         {
@@ -1481,9 +1497,9 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+	r->setStr(ipt_target,"");
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -1501,7 +1517,7 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","3");
+        r->setStr(subrule_suffix,"3");
 
         nsrv=r->getSrv();   nsrv->reset();
 
@@ -1513,14 +1529,14 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
             if ( (nint=r->getWhen())!=NULL )  nint->reset();
         }
 
-	r->setStr("ipt_chain",new_chain);
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
         r->setBool("upstream_rule_neg",true);
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(ipt_target).empty() )
+	    r->setStr(ipt_target,rule->getStr(ipt_target));
         
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1557,7 +1573,7 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
         FWOptions           *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(ipt_chain);
 	string new_chain  = ipt_comp->getNewTmpChainName(rule);
 	intrel->setNeg(false);
 
@@ -1567,13 +1583,13 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","1");
+        r->setStr(subrule_suffix,"1");
 	if ( (nint=r->getWhen())!=NULL )  nint->reset();
         r->setClassification(false);
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(ipt_target,new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1586,7 +1602,7 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","2");
+        r->setStr(subrule_suffix,"2");
 
         if (!shadowing_mode)
         {
@@ -1601,9 +1617,9 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+	r->setStr(ipt_target,"");
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -1621,7 +1637,7 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
 	r= compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r);
 	r->duplicate(rule);
-        r->setStr("subrule_suffix","3");
+        r->setStr(subrule_suffix,"3");
 
         if ( (nint=r->getWhen())!=NULL )  nint->reset();
 
@@ -1648,13 +1664,13 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
-        r->setStr("upstream_rule_chain",this_chain);
+	r->setStr(ipt_chain,new_chain);
+        r->setStr(upstream_rule_chain,this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(ipt_target).empty() )
+	    r->setStr(ipt_target,rule->getStr(ipt_target));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1745,7 +1761,7 @@ bool PolicyCompiler_ipt::setChainPreroutingForTag::processNext()
     RuleElementItf *itf_re = rule->getItf(); assert(itf_re!=NULL);
 
     if ( (rule->getTagging() || rule->getBool("originated_from_a_rule_with_tagging")) &&
-          rule->getStr("ipt_chain").empty() &&
+          rule->getStr(ipt_chain).empty() &&
          (rule->getDirection()==PolicyRule::Both ||
           rule->getDirection()==PolicyRule::Inbound) &&
          itf_re->isAny())
@@ -1765,7 +1781,7 @@ bool PolicyCompiler_ipt::setChainPostroutingForTag::processNext()
     RuleElementItf *itf_re = rule->getItf(); assert(itf_re!=NULL);
 
     if ( (rule->getTagging()  || rule->getBool("originated_from_a_rule_with_tagging")) &&
-          rule->getStr("ipt_chain").empty() &&
+          rule->getStr(ipt_chain).empty() &&
          (rule->getDirection()==PolicyRule::Both ||
           rule->getDirection()==PolicyRule::Outbound) &&
          itf_re->isAny())
@@ -1783,7 +1799,7 @@ bool PolicyCompiler_ipt::checkForRestoreMarkInOutput::processNext()
 
     if ( (rule->getTagging()  || rule->getBool("originated_from_a_rule_with_tagging")) &&
          ruleopt->getBool("ipt_mark_connections") &&
-         rule->getStr("ipt_chain")=="OUTPUT")
+         rule->getStr(ipt_chain)=="OUTPUT")
         ipt_comp->have_connmark_in_output = true;
 
     tmp_queue.push_back(rule);
@@ -1796,7 +1812,7 @@ bool PolicyCompiler_ipt::setChainForMangle::processNext()
     PolicyCompiler_ipt *ipt_comp=dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if (ipt_comp->my_table=="mangle" && rule->getStr("ipt_chain").empty())
+    if (ipt_comp->my_table=="mangle" && rule->getStr(ipt_chain).empty())
     {
         if (rule->getDirection()==PolicyRule::Inbound)
             ipt_comp->setChain(rule, "PREROUTING");
@@ -1834,7 +1850,7 @@ bool PolicyCompiler_ipt::splitIfTagAndConnmark::processNext()
 	PolicyRule *r1 = compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r1);
 	r1->duplicate(rule);
-	r1->setStr("ipt_target", "CONNMARK");
+	r1->setStr(ipt_target, "CONNMARK");
         r1->setAction(PolicyRule::Continue);    // ###
         r1->setClassification(false);
         r1->setRouting(false);
@@ -1865,7 +1881,7 @@ bool PolicyCompiler_ipt::splitIfIfaceAndDirectionBoth::processNext()
 
         // If this rule has been assigned to chain POSTROUTING,
         // direction 'inbound' does not make sense for it.
-        if (rule->getStr("ipt_chain") != "POSTROUTING")
+        if (rule->getStr(ipt_chain) != "POSTROUTING")
         {
             r = compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
@@ -1876,7 +1892,7 @@ bool PolicyCompiler_ipt::splitIfIfaceAndDirectionBoth::processNext()
 
         // If this rule has been assigned to chain PREROUTING,
         // direction 'Outbound' does not make sense for it.
-        if (rule->getStr("ipt_chain") != "PREROUTING")
+        if (rule->getStr(ipt_chain) != "PREROUTING")
         {
             r= compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
@@ -1965,7 +1981,7 @@ bool PolicyCompiler_ipt::bridgingFw::processNext()
 //    Address        *src=compiler->getFirstSrc(rule);
     Address *dst = compiler->getFirstDst(rule);
 
-    if ( rule->getStr("ipt_chain")=="INPUT" )
+    if ( rule->getStr(ipt_chain)=="INPUT" )
     {
         if ( checkForMatchingBroadcastAndMulticast(dst) )
         {
@@ -2011,7 +2027,7 @@ bool PolicyCompiler_ipt::splitIfSrcNegAndFw::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(ipt_chain).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2066,7 +2082,7 @@ bool PolicyCompiler_ipt::splitIfSrcNegAndFw::processNext()
                 nsrc->addRef(*m);
             tmp_queue.push_back(r);
 
-//            rule->setStr("ipt_chain","FORWARD");
+//            rule->setStr(ipt_chain,"FORWARD");
             nsrc=rule->getSrc();
             nsrc->reset();   // resets negation flag
             for (list<FWObject*>::iterator m=notFwLikes.begin(); m!=notFwLikes.end(); ++m) 
@@ -2089,7 +2105,7 @@ bool PolicyCompiler_ipt::splitIfDstNegAndFw::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(ipt_chain).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2147,7 +2163,7 @@ bool PolicyCompiler_ipt::splitIfDstNegAndFw::processNext()
             // the second rule goes into FORWARD chain, but if source
             // is (or contains) firewall, we may also need OUTPUT chain
 
-//            rule->setStr("ipt_chain","FORWARD");
+//            rule->setStr(ipt_chain,"FORWARD");
             ndst=rule->getDst();
             ndst->reset();   // resets negation flag
             for (list<FWObject*>::iterator m=notFwLikes.begin(); m!=notFwLikes.end(); ++m) 
@@ -2199,7 +2215,7 @@ bool PolicyCompiler_ipt::splitIfSrcAny::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(ipt_chain).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2268,7 +2284,7 @@ bool PolicyCompiler_ipt::splitIfDstAny::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(ipt_chain).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2538,7 +2554,7 @@ bool PolicyCompiler_ipt::splitIfSrcFWNetwork::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() || srcrel->isAny() ) 
+    if ( ! rule->getStr(ipt_chain).empty() || srcrel->isAny() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2611,7 +2627,7 @@ bool PolicyCompiler_ipt::splitIfDstFWNetwork::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() || dstrel->isAny() ) 
+    if ( ! rule->getStr(ipt_chain).empty() || dstrel->isAny() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2757,7 +2773,7 @@ bool PolicyCompiler_ipt::specialCaseWithFWInDstAndOutbound::processNext()
     RuleElementSrc *srcrel = rule->getSrc();
     Address *src =compiler->getFirstSrc(rule);
     Address *dst =compiler->getFirstDst(rule);
-    string chain  = rule->getStr("ipt_chain");
+    string chain  = rule->getStr(ipt_chain);
 
     if (rule->getDirection()== PolicyRule::Outbound &&
         itf!=NULL && itf->isChildOf(compiler->fw) &&
@@ -2928,7 +2944,7 @@ bool PolicyCompiler_ipt::specialCaseWithUnnumberedInterface::processNext()
         keep_rule=dropUnnumberedInterface( rule->getSrc() );
         break;
     case PolicyRule::Outbound:
-        if ( rule->getStr("ipt_chain")=="OUTPUT" ) 
+        if ( rule->getStr(ipt_chain)=="OUTPUT" ) 
             keep_rule=dropUnnumberedInterface( rule->getDst() );
         else
             keep_rule=dropUnnumberedInterface( rule->getSrc() );
@@ -3073,7 +3089,7 @@ bool PolicyCompiler_ipt::decideOnChainIfSrcFW::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() || rule->getClassification())
+    if ( ! rule->getStr(ipt_chain).empty() || rule->getClassification())
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3174,7 +3190,7 @@ bool PolicyCompiler_ipt::decideOnChainIfDstFW::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() || rule->getClassification())
+    if ( ! rule->getStr(ipt_chain).empty() || rule->getClassification())
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3317,7 +3333,7 @@ bool PolicyCompiler_ipt::decideOnChainIfLoopback::processNext()
     RuleElementDst *dstrel=rule->getDst();
 
     if (srcrel->isAny() && dstrel->isAny() && 
-        rule->getStr("ipt_chain").empty()  &&
+        rule->getStr(ipt_chain).empty()  &&
         rule_iface!=NULL &&
         rule_iface->isLoopback() )
     {
@@ -3349,7 +3365,7 @@ bool PolicyCompiler_ipt::decideOnChainForClassify::processNext()
 	return true;
     }
 
-    if (rule->getStr("ipt_chain").empty())
+    if (rule->getStr(ipt_chain).empty())
     {
         if (rule->getTagging())
         {
@@ -3378,7 +3394,7 @@ bool PolicyCompiler_ipt::finalizeChain::processNext()
 
 //    tmp_queue.push_back(rule);
 
-    if ( ! rule->getStr("ipt_chain").empty() )
+    if ( ! rule->getStr(ipt_chain).empty() )
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3487,7 +3503,7 @@ bool PolicyCompiler_ipt::finalizeChain::processNext()
          ip_forward_option=="Off" ||
          ip_forward_option=="off")) ipforw = false;
 
-    if (rule->getStr("ipt_chain")=="FORWARD" && !ipforw) return true;
+    if (rule->getStr(ipt_chain)=="FORWARD" && !ipforw) return true;
 
     tmp_queue.push_back(rule);
     return true;
@@ -3499,22 +3515,22 @@ bool PolicyCompiler_ipt::decideOnTarget::processNext()
 
     tmp_queue.push_back(rule);
 
-    if ( ! rule->getStr("ipt_target").empty() ) return true; // already defined
+    if ( ! rule->getStr(ipt_target).empty() ) return true; // already defined
 
     // note that we use pseudo-target for action Continue
     switch (rule->getAction())
     {
-    case PolicyRule::Accept:   rule->setStr("ipt_target", "ACCEPT");    break;
-    case PolicyRule::Deny:     rule->setStr("ipt_target", "DROP");      break;
-    case PolicyRule::Reject:   rule->setStr("ipt_target", "REJECT");    break;
-    case PolicyRule::Return:   rule->setStr("ipt_target", "RETURN");    break;
-//    case PolicyRule::Tag:      rule->setStr("ipt_target", "MARK");      break;
-    case PolicyRule::Pipe:     rule->setStr("ipt_target", "QUEUE");     break;
-//    case PolicyRule::Classify: rule->setStr("ipt_target", "CLASSIFY");  break;
-//    case PolicyRule::Route:    rule->setStr("ipt_target", "ROUTE");     break;
+    case PolicyRule::Accept:   rule->setStr(ipt_target, "ACCEPT");    break;
+    case PolicyRule::Deny:     rule->setStr(ipt_target, "DROP");      break;
+    case PolicyRule::Reject:   rule->setStr(ipt_target, "REJECT");    break;
+    case PolicyRule::Return:   rule->setStr(ipt_target, "RETURN");    break;
+//    case PolicyRule::Tag:      rule->setStr(ipt_target, "MARK");      break;
+    case PolicyRule::Pipe:     rule->setStr(ipt_target, "QUEUE");     break;
+//    case PolicyRule::Classify: rule->setStr(ipt_target, "CLASSIFY");  break;
+//    case PolicyRule::Route:    rule->setStr(ipt_target, "ROUTE");     break;
 
-    case PolicyRule::Continue: rule->setStr("ipt_target", ".CONTINUE"); break;
-    case PolicyRule::Custom:   rule->setStr("ipt_target", ".CUSTOM");   break;
+    case PolicyRule::Continue: rule->setStr(ipt_target, ".CONTINUE"); break;
+    case PolicyRule::Custom:   rule->setStr(ipt_target, ".CUSTOM");   break;
 
     case PolicyRule::Branch:
     {
@@ -3525,7 +3541,7 @@ bool PolicyCompiler_ipt::decideOnTarget::processNext()
                 string("Branching rule ") + rule->getLabel() +
                 " refers ruleset that does not exist");
         else
-            rule->setStr("ipt_target", ruleset->getName());
+            rule->setStr(ipt_target, ruleset->getName());
         break;
     }
     default: ;
@@ -3579,7 +3595,7 @@ bool PolicyCompiler_ipt::removeFW::processNext()
             return true;
         }
 
-        string chain = rule->getStr("ipt_chain");
+        string chain = rule->getStr(ipt_chain);
 
         if (( chain=="INPUT" || 
               ipt_comp->isChainDescendantOfInput(chain)) &&
@@ -3604,7 +3620,7 @@ bool PolicyCompiler_ipt::checkMACinOUTPUTChain::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( rule->getStr("ipt_chain")=="OUTPUT" )
+    if ( rule->getStr(ipt_chain)=="OUTPUT" )
     {
 //        RuleElementSrc *srcrel=rule->getSrc();
         Address *src = compiler->getFirstSrc(rule);
@@ -3637,7 +3653,7 @@ bool PolicyCompiler_ipt::checkUserServiceInWrongChains::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
     Service *srv = compiler->getFirstSrv(rule);  assert(srv);
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(ipt_chain);
 
     if (UserService::cast(srv) != NULL &&
         chain != "OUTPUT" &&
@@ -3799,7 +3815,7 @@ bool PolicyCompiler_ipt::splitServicesIfRejectWithTCPReset::processNext()
             nsrv->addRef( (*j) );
 
         r->getOptionsObject()->setStr("action_on_reject","");
-        r->setStr("subrule_suffix","1");
+        r->setStr(subrule_suffix,"1");
         tmp_queue.push_back(r);
 
         r= compiler->dbcopy->createPolicyRule();
@@ -3811,7 +3827,7 @@ bool PolicyCompiler_ipt::splitServicesIfRejectWithTCPReset::processNext()
         for (list<Service*>::iterator j=tcp.begin(); j!=tcp.end(); j++)
             nsrv->addRef( (*j) );
 
-        r->setStr("subrule_suffix","2");
+        r->setStr(subrule_suffix,"2");
         tmp_queue.push_back(r);
         return true;
     }
@@ -3864,8 +3880,10 @@ bool PolicyCompiler_ipt::prepareForMultiport::processNext()
     if (TCPService::isA(srv) || UDPService::isA(srv)) 
     {
         rule->setBool("ipt_multiport",true);
-/* make sure we have no more than 15 ports */
-        if (rel->size()>15) 
+/* make sure we have no more than 15 ports. Sets used with nftables
+ * have no such limit */
+        PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+        if (rel->size()>15 && !ipt_comp->usingNftables()) 
         {
             int n=0;
             PolicyRule *r;
@@ -3898,6 +3916,110 @@ bool PolicyCompiler_ipt::prepareForMultiport::processNext()
     return true;
 }
 
+Service* PolicyCompiler_ipt::packMultiportServices::getPortService(
+    Service *proto, int first, int last)
+{
+    ostringstream key;
+    key << proto->getTypeName() << ":" << first << ":" << last;
+    map<string, Service*>::iterator i = port_services.find(key.str());
+    if (i != port_services.end()) return i->second;
+
+    TCPUDPService *s = TCPUDPService::cast(
+        compiler->dbcopy->create(proto->getTypeName()));
+    assert(s!=NULL);
+    ostringstream name;
+    name << "%" << proto->getProtocolName() << " " << first;
+    if (first != last) name << ":" << last;
+    name << "%";
+    s->setName(name.str());
+    s->setDstRangeStart(first);
+    s->setDstRangeEnd(last);
+    compiler->persistent_objects->add(s, false);
+    port_services[key.str()] = s;
+    return s;
+}
+
+bool PolicyCompiler_ipt::packMultiportServices::processNext()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    PolicyRule *rule = getNext(); if (rule==NULL) return false;
+
+    RuleElementSrv *rel = rule->getSrv();
+    Service *srv = compiler->getFirstSrv(rule);
+
+    if (rel->size()==1 || !(TCPService::isA(srv) || UDPService::isA(srv)))
+    {
+        tmp_queue.push_back(rule);
+        return true;
+    }
+
+    PortRangeSet ports;
+    map<pair<int,int>, Service*> originals;
+    list<Service*> separate;
+
+    for (FWObject::iterator i=rel->begin(); i!=rel->end(); i++)
+    {
+        FWObject *o = *i;
+        if (FWReference::cast(o)!=NULL) o = FWReference::cast(o)->getPointer();
+        TCPUDPService *s = TCPUDPService::cast(o);
+        assert(s!=NULL);
+
+        int srs = s->getSrcRangeStart();
+        int sre = s->getSrcRangeEnd();
+        int drs = s->getDstRangeStart();
+        int dre = s->getDstRangeEnd();
+        compiler->normalizePortRange(srs, sre);
+        compiler->normalizePortRange(drs, dre);
+
+        TCPService *tcp = TCPService::cast(s);
+        if (srs!=0 || sre!=0 || (drs==0 && dre==0) ||
+            (tcp && tcp->inspectFlags()))
+        {
+            separate.push_back(s);
+            continue;
+        }
+
+        ports.addRange(drs, dre);
+        originals[make_pair(drs, dre)] = s;
+    }
+
+    for (list<Service*>::iterator i=separate.begin(); i!=separate.end(); ++i)
+    {
+        PolicyRule *r = compiler->dbcopy->createPolicyRule();
+        compiler->temp_ruleset->add(r);
+        r->duplicate(rule);
+        RuleElementSrv *nsrv = r->getSrv();
+        nsrv->clearChildren();
+        nsrv->addRef(*i);
+        tmp_queue.push_back(r);
+    }
+
+    // sets used with nftables have no limit on the number of ports
+    vector<PortRangeSet> chunks =
+        ports.split(ipt_comp->usingNftables() ? 0 : 15);
+
+    for (vector<PortRangeSet>::iterator c=chunks.begin(); c!=chunks.end(); ++c)
+    {
+        PolicyRule *r = compiler->dbcopy->createPolicyRule();
+        compiler->temp_ruleset->add(r);
+        r->duplicate(rule);
+        RuleElementSrv *nsrv = r->getSrv();
+        nsrv->clearChildren();
+
+        const vector<PortRangeSet::Range> &ranges = c->getRanges();
+        for (vector<PortRangeSet::Range>::const_iterator j=ranges.begin();
+             j!=ranges.end(); ++j)
+        {
+            map<pair<int,int>, Service*>::iterator k = originals.find(*j);
+            if (k != originals.end()) nsrv->addRef(k->second);
+            else nsrv->addRef(getPortService(srv, j->first, j->second));
+        }
+        tmp_queue.push_back(r);
+    }
+
+    return true;
+}
+
 /*
  *  processor groupServicesByProtocol should have been called before, it makes sure
  *  all objects in Service are of the same type.
@@ -4009,6 +4131,7 @@ bool PolicyCompiler_ipt::processMultiAddressObjectsInRE::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     OSConfigurator_linux24 *osconf = 
         dynamic_cast<OSConfigurator_linux24*>(compiler->osconfigurator);
 
@@ -4031,7 +4154,7 @@ bool PolicyCompiler_ipt::processMultiAddressObjectsInRE::processNext()
                     return true;
                 }
                 rule->setStr("address_table_file", path);
-                osconf->registerMultiAddressObject(atrt);
+                osconf->registerMultiAddressObject(atrt, ipt_comp->ipv6);
             }
             if (atrt->getSubstitutionTypeName()==DNSName::TYPENAME)
             {
@@ -4079,7 +4202,7 @@ bool PolicyCompiler_ipt::processMultiAddressObjectsInRE::processNext()
         }
         r->setStr("address_table_file", path);
 
-        osconf->registerMultiAddressObject(atrt);
+        osconf->registerMultiAddressObject(atrt, ipt_comp->ipv6);
         tmp_queue.push_back(r);
 
         ore->removeRef( *i );
@@ -4093,6 +4216,100 @@ bool PolicyCompiler_ipt::processMultiAddressObjectsInRE::processNext()
     return true;
 }
 
+bool PolicyCompiler_ipt::convertLargeGroupsToIpSets::processNext()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    PolicyRule *rule = getNext(); if (rule==NULL) return false;
+
+    if (ipt_comp->using_ipset_for_groups)
+    {
+        convertRE(rule, rule->getSrc());
+        convertRE(rule, rule->getDst());
+    }
+
+    tmp_queue.push_back(rule);
+    return true;
+}
+
+void PolicyCompiler_ipt::convertLargeGroupsToIpSets::convertRE(
+    PolicyRule *rule, RuleElement *re)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    OSConfigurator_linux24 *osconf = 
+        dynamic_cast<OSConfigurator_linux24*>(compiler->osconfigurator);
+
+    if (re->getNeg() || re->getBool("single_object_negation")) return;
+
+    list<FWObject*> set_objects;
+    set<string> elements;
+
+    for (FWObject::iterator i=re->begin(); i!=re->end(); i++)
+    {
+        Address *addr = Address::cast(FWReference::getObject(*i));
+        if (addr==NULL) continue;
+
+        // hash:net sets can only hold hosts and networks with
+        // non-zero prefix length
+        if (!IPv4::isA(addr) && !IPv6::isA(addr) &&
+            !Network::isA(addr) && !NetworkIPv6::isA(addr) &&
+            !(AddressRange::isA(addr) && addr->dimension()==1)) continue;
+
+        const InetAddr *inet_addr = addr->getAddressPtr();
+        const InetAddr *netmask = addr->getNetmaskPtr();
+        if (inet_addr==NULL || inet_addr->isV6()!=ipt_comp->ipv6) continue;
+
+        string element = inet_addr->toString();
+        if (!IPv4::isA(addr) && !IPv6::isA(addr) && !AddressRange::isA(addr))
+        {
+            if (netmask==NULL || netmask->getLength()==0) continue;
+            if (!netmask->isHostMask())
+            {
+                ostringstream str;
+                str << element << "/" << netmask->getLength();
+                element = str.str();
+            }
+        }
+
+        set_objects.push_back(addr);
+        elements.insert(element);
+    }
+
+    if (int(elements.size()) < ipt_comp->ipset_group_threshold) return;
+
+    ostringstream name_hint;
+    name_hint << ((ipt_comp->ipv6) ? "fwb6_r" : "fwb_r")
+              << ((rule->getPosition()>0) ? rule->getPosition() : 0)
+              << ((RuleElementSrc::isA(re)) ? "_s" : "_d");
+
+    string set_name = osconf->registerGroupIpSet(
+        name_hint.str(), ipt_comp->ipv6,
+        list<string>(elements.begin(), elements.end()));
+
+    // Objects with the same id are shared by all rules that use the
+    // same set, the same way run-time address tables are.
+    AddressTable at;
+    at.setName(set_name);
+    at.setRunTime(true);
+    at.setSourceName("");
+
+    int mart_id = FWObjectDatabase::registerStringId("ipset_" + set_name);
+    MultiAddressRunTime *mart = MultiAddressRunTime::cast(
+        compiler->dbcopy->findInIndex(mart_id));
+    if (mart==NULL)
+    {
+        mart = new MultiAddressRunTime(&at);
+        mart->setId(mart_id);
+        compiler->dbcopy->addToIndex(mart);
+        compiler->persistent_objects->add(mart);
+    }
+
+    for (list<FWObject*>::iterator i=set_objects.begin(); i!=set_objects.end(); ++i)
+        re->removeRef(*i);
+    re->addRef(mart);
+
+    ipt_comp->actually_used_module_set = true;
+}
+
 /*
  * iptables does not have target that would do nothing and would not
  * terminate processing of the packet (like NOP), so we create a new
@@ -4109,9 +4326,9 @@ bool PolicyCompiler_ipt::accounting::processNext()
     FWOptions  *ruleopt = rule->getOptionsObject();
 
     if (rule->getAction()==PolicyRule::Accounting &&
-        rule->getStr("ipt_target").empty())
+        rule->getStr(ipt_target).empty())
     {
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(ipt_chain);
 	string new_chain  = ipt_comp->getNewChainName(rule, rule_iface);
         string rule_name_accounting = ruleopt->getStr("rule_name_accounting");
         if (!rule_name_accounting.empty())
@@ -4119,7 +4336,7 @@ bool PolicyCompiler_ipt::accounting::processNext()
 
         if (new_chain==this_chain)
         {
-            rule->setStr("ipt_target", "RETURN");
+            rule->setStr(ipt_target, "RETURN");
             rule->setAction(PolicyRule::Continue);
         } else
         {
@@ -4138,17 +4355,17 @@ bool PolicyCompiler_ipt::accounting::processNext()
             nsrc=r->getSrc();  nsrc->reset();
             ndst=r->getDst();  ndst->reset();
             nsrv=r->getSrv();  nsrv->reset();
-            r->setStr("ipt_chain",new_chain);
-            r->setStr("upstream_rule_chain",this_chain);
+            r->setStr(ipt_chain,new_chain);
+            r->setStr(upstream_rule_chain,this_chain);
             ipt_comp->registerChain(new_chain);
             ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-            r->setStr("ipt_target", "RETURN");
+            r->setStr(ipt_target, "RETURN");
             r->setLogging(false);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
 
-            rule->setStr("ipt_target", new_chain);
+            rule->setStr(ipt_target, new_chain);
             rule->setLogging(false);
             ruleopt = rule->getOptionsObject();
             ruleopt->setInt("limit_value",-1);
@@ -4170,7 +4387,7 @@ bool PolicyCompiler_ipt::countChainUsage::processNext()
     for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k) 
     {
         PolicyRule *rule = PolicyRule::cast( *k );
-        ipt_comp->chain_usage_counter[rule->getStr("ipt_target")] += 1;
+        ipt_comp->chain_usage_counter[rule->getStr(ipt_target)] += 1;
     }
 
     // second pass: if chain the rule belongs to has never been used as a target
@@ -4178,8 +4395,8 @@ bool PolicyCompiler_ipt::countChainUsage::processNext()
     for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k) 
     {
         PolicyRule *rule = PolicyRule::cast( *k );
-        if (ipt_comp->chain_usage_counter[rule->getStr("ipt_chain")] == 0)
-            ipt_comp->chain_usage_counter[rule->getStr("ipt_target")] = 0;
+        if (ipt_comp->chain_usage_counter[rule->getStr(ipt_chain)] == 0)
+            ipt_comp->chain_usage_counter[rule->getStr(ipt_target)] = 0;
     }
 
     return true;
@@ -4622,6 +4839,9 @@ void PolicyCompiler_ipt::compile()
     add( new specialCaseWithUnnumberedInterface(
              "check for a special cases with unnumbered interface"));
 
+    add( new simplifyAddressSetsInSrc("simplify address sets in Src"));
+    add( new simplifyAddressSetsInDst("simplify address sets in Dst"));
+
 //        add( new groupServicesByProtocol("split on services"));
 //        add( new prepareForMultiport("prepare for multiport"));
 
@@ -4636,7 +4856,12 @@ void PolicyCompiler_ipt::compile()
     add( new verifyCustomServices("verify custom services"));
     add( new specialCasesWithCustomServices(
              "scpecial cases with some custom services"));
-    add( new separatePortRanges("separate port ranges"));
+    if (fwopt->getBool("ipt_pack_multiport_services") &&
+        (version.empty() || XMLTools::version_compare(version, "1.3.0")>=0))
+        add( new packMultiportServices(
+                 "pack TCP and UDP ports for multiport"));
+    else
+        add( new separatePortRanges("separate port ranges"));
     add( new separateUserServices("separate user services"));
     add( new separateSrcPort("split on TCP and UDP with source ports"));
     add( new checkForStatefulICMP6Rules(
@@ -4648,6 +4873,9 @@ void PolicyCompiler_ipt::compile()
 
     add( new prepareForMultiport("prepare for multiport") );
 
+    add( new convertLargeGroupsToIpSets(
+             "replace large groups of addresses with ipsets") );
+
     add( new ConvertToAtomicForAddresses(
              "convert to atomic rules by address elements") );
 
@@ -4669,6 +4897,8 @@ void PolicyCompiler_ipt::compile()
 
     add( new optimizeForMinusIOPlus("optimize for '-i +' / '-o +'") );
 
+    add( new buildDecisionTree("build decision tree of chains") );
+
     add( new checkForObjectsWithErrors(
              "check if we have objects with errors in rule elements"));
     add( new countChainUsage("Count chain usage"));
@@ -4806,7 +5036,7 @@ string PolicyCompiler_ipt::debugPrintRule(Rule *r)
 
     str << " c=" << printChains(rule);
 
-    str << " t=" << rule->getStr("ipt_target");
+    str << " t=" << rule->getStr(ipt_target);
 
     if ( ! rule->getStr(".iface").empty())
         str << " .iface=" << rule->getStr(".iface");
@@ -4851,7 +5081,10 @@ void PolicyCompiler_ipt::epilog()
 PolicyCompiler_ipt::PrintRule* PolicyCompiler_ipt::createPrintRuleProcessor()
 {
     PolicyCompiler_ipt::PrintRule* print_rule = NULL;
-    if (fw->getOptionsObject()->getBool("use_iptables_restore"))
+    if (usingNftables())
+    {
+        print_rule = new PrintRuleNft("generate nftables commands");
+    } else if (fw->getOptionsObject()->getBool("use_iptables_restore"))
     {
         // bug #1812295: we should use PrintRuleIptRstEcho not only
         // when we have dynamic interfaces, but also when we have
@@ -4913,6 +5146,12 @@ bool PolicyCompiler_ipt::newIptables(const string &version)
             XMLTools::version_compare(version, "1.2.6")>0);
 }
 
+bool PolicyCompiler_ipt::usingNftables()
+{
+    return (my_table=="filter" &&
+            fw->getOptionsObject()->getBool("use_nftables"));
+}
+
 list<string> PolicyCompiler_ipt::getUsedChains()
 {
     list<string> res;
@@ -30,15 +30,25 @@
 
 #include "fwcompiler/PolicyCompiler.h"
 #include "fwbuilder/RuleElement.h"
+#include "fwbuilder/InetAddr.h"
 #include "config.h"
 #include "Configlet.h"
 
 #include <QMap>
 #include <QString>
 
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <deque>
+
+#include <limits.h>
+
 
 namespace libfwbuilder
 {
+    class Address;
     class Interface;
     class IPService;
     class ICMPService;
@@ -72,6 +82,8 @@ protected:
         bool                           have_connmark_in_output;
         bool                           using_ipset;
         bool                           actually_used_module_set;
+        bool                           using_ipset_for_groups;
+        int                            ipset_group_threshold;
         std::string                    my_table;
 
         std::map<std::string, int>     tmp_chain_no;
@@ -632,6 +644,24 @@ protected:
                 processMultiAddressObjectsInRE(n,libfwbuilder::RuleElementDst::TYPENAME) {}
         };
 
+        /**
+         * Replaces large sets of addresses left in Src or Dst after
+         * groups have been expanded with a single ipset generated by
+         * the compiler. Only plain addresses and networks are moved
+         * to the set, everything else stays in the rule element and
+         * is converted to atomic rules as usual.
+         */
+        class convertLargeGroupsToIpSets : public PolicyRuleProcessor
+        {
+            void convertRE(libfwbuilder::PolicyRule *rule,
+                           libfwbuilder::RuleElement *re);
+            public:
+            convertLargeGroupsToIpSets(const std::string &name) :
+                PolicyRuleProcessor(name) {}
+            virtual bool processNext();
+        };
+        friend class PolicyCompiler_ipt::convertLargeGroupsToIpSets;
+
 	/**
 	 * splits rule if firewall is in src and dst
 	 */
@@ -911,6 +941,90 @@ protected:
         };
         friend class PolicyCompiler_ipt::optimize3;
 
+        /**
+         * Replaces long runs of ACCEPT/DROP/REJECT rules in a chain
+         * with a tree of user-defined chains. Each level of the tree
+         * dispatches on interface, protocol or destination address
+         * prefix. Rules that can match packets going into more than
+         * one branch are copied into each of them, keeping their
+         * relative order, so the first match semantics of the
+         * original run of rules is preserved. Runs that would grow
+         * too much because of copying are left in linear order.
+         */
+        class buildDecisionTree : public PolicyRuleProcessor
+        {
+            enum SplitKind { SPLIT_ITF, SPLIT_PROTO, SPLIT_DST };
+
+            struct Branch
+            {
+                libfwbuilder::FWObject *obj;
+                int direction;
+                libfwbuilder::InetAddr net;
+                libfwbuilder::InetAddr netmask;
+                std::deque<libfwbuilder::PolicyRule*> rules;
+                Branch() { obj = NULL; direction = 0; }
+            };
+
+            struct Split
+            {
+                SplitKind kind;
+                std::list<Branch> branches;
+                std::deque<libfwbuilder::PolicyRule*> rest;
+                int cost;
+                Split() { kind = SPLIT_ITF; cost = INT_MAX; }
+            };
+
+            struct TreeStats
+            {
+                int chains;
+                int depth;
+                int cost;
+                TreeStats() { chains = 0; depth = 0; cost = 0; }
+            };
+
+            std::set<libfwbuilder::PolicyRule*> placed_rules;
+            libfwbuilder::PolicyRule *block_head;
+
+            bool isEligible(libfwbuilder::PolicyRule *rule);
+            bool getDstInterval(libfwbuilder::PolicyRule *rule,
+                                libfwbuilder::InetAddr &first,
+                                libfwbuilder::InetAddr &last);
+            void distribute(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                const std::vector<int> &keys,
+                Split &split);
+            void splitByInterface(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                Split &split);
+            void splitByProtocol(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                Split &split);
+            void splitByDestination(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                Split &split);
+            void chooseSplit(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                int depth, Split &best);
+            int countTreeRules(
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                int depth, int limit);
+            libfwbuilder::PolicyRule* placeRule(libfwbuilder::PolicyRule *rule,
+                                                const std::string &chain);
+            libfwbuilder::PolicyRule* createDispatchRule(
+                SplitKind kind, const Branch &branch,
+                const std::string &chain, const std::string &target);
+            TreeStats buildTree(
+                const std::string &chain,
+                const std::deque<libfwbuilder::PolicyRule*> &rules,
+                int depth, std::deque<libfwbuilder::Rule*> &out);
+
+            public:
+            buildDecisionTree(const std::string &name) :
+                PolicyRuleProcessor(name) { block_head = NULL; }
+            virtual bool processNext();
+        };
+        friend class PolicyCompiler_ipt::buildDecisionTree;
+
 	/**
 	 * Optimize rules by dropping "-i +" or "-o +" if chain is
          * INPUT or OUTPUT respectively.
@@ -922,6 +1036,30 @@ protected:
 	 */
         DECLARE_POLICY_RULE_PROCESSOR(prepareForMultiport);
 
+	/**
+	 * Used instead of separatePortRanges when option
+	 * "ipt_pack_multiport_services" is on. Merges destination
+	 * ports and port ranges of TCP or UDP services of the rule
+	 * into one set, overlapping and adjacent ranges are combined,
+	 * and splits the set into as few rules as possible so that
+	 * each fits into one "-m multiport" command (15 ports, a range
+	 * counts as two). Services with source ports and "any tcp" /
+	 * "any udp" go into rules of their own like separatePortRanges
+	 * does. Requires iptables 1.3.0 or later for port ranges in
+	 * multiport.
+	 */
+        class packMultiportServices : public PolicyRuleProcessor
+        {
+            std::map<std::string, libfwbuilder::Service*> port_services;
+            libfwbuilder::Service* getPortService(
+                libfwbuilder::Service *proto, int first, int last);
+            public:
+            packMultiportServices(const std::string &name) :
+                PolicyRuleProcessor(name) {}
+            virtual bool processNext();
+        };
+        friend class PolicyCompiler_ipt::packMultiportServices;
+
         /**
          *  eliminates duplicate objects in SRC. Uses default comparison
          *  in eliminateDuplicatesInRE which compares IDs
@@ -1055,6 +1193,14 @@ public:
         
         PolicyCompiler_ipt::PrintRule* createPrintRuleProcessor();
 
+        /**
+         * returns true if rules of this compiler are printed as
+         * nftables commands (option "use_nftables"). Only filter
+         * table is generated for nftables, NAT and mangle still use
+         * iptables.
+         */
+        bool usingNftables();
+
 	/**
 	 *  prints single policy rule, assuming all groups have been
 	 *  expanded, so source, destination and service hold exactly
@@ -1193,6 +1339,119 @@ public:
         };
         friend class PolicyCompiler_ipt::PrintRuleIptRstEcho;
 
+	/**
+	 *  prints policy rules as nftables commands that are fed to
+	 *  "nft -f" in one transaction. Unlike other PrintRule
+	 *  processors, this one slurps all rules first and merges
+	 *  adjacent atomic rules back together: rules that differ only
+	 *  in source or destination become a single rule matching a
+	 *  named set, rules that differ in both become a set with
+	 *  concatenated "saddr . daddr" keys and rules that differ
+	 *  only in the verdict become a verdict map.
+	 */
+        class PrintRuleNft : public PrintRule
+        {
+            public:
+
+            struct nftElement
+            {
+                std::string text;
+                libfwbuilder::InetAddr first;
+                libfwbuilder::InetAddr last;
+                bool isHost() const { return first == last; }
+            };
+
+            struct nftRule
+            {
+                std::list<libfwbuilder::PolicyRule*> rules;
+                std::string chain;
+                std::string head;
+                std::string tail;
+                std::string action;
+                bool pure_verdict;
+                bool terminating;
+
+                // src and dst hold addresses that can be put in a set;
+                // objects that can not (MAC addresses) are printed
+                // into src_expr / dst_expr
+                std::vector<nftElement> src;
+                std::vector<nftElement> dst;
+                std::string src_expr;
+                std::string dst_expr;
+                bool src_neg;
+                bool dst_neg;
+
+                std::vector<std::pair<nftElement, nftElement> > pairs;
+                std::vector<std::pair<nftElement, std::string> > vmap;
+                bool vmap_on_src;
+
+                nftRule() : pure_verdict(false), terminating(false),
+                            src_neg(false), dst_neg(false),
+                            vmap_on_src(false) {}
+            };
+
+            protected:
+
+            int set_counter;
+            std::map<std::string, std::string> named_sets;
+
+            std::string _family();
+            std::string _addrMatch(bool src);
+            std::string _addrType();
+            bool _makeElement(libfwbuilder::PolicyRule *rule,
+                              libfwbuilder::Address *o, nftElement &e);
+            void _printAddress(libfwbuilder::PolicyRule *rule,
+                               libfwbuilder::RuleElement *rel,
+                               bool src, nftRule &nr);
+            std::string _printNftServices(libfwbuilder::PolicyRule *rule);
+            std::string _printNftTCPFlags(libfwbuilder::TCPService *srv);
+            std::string _printNftIP(libfwbuilder::IPService *srv,
+                                    libfwbuilder::PolicyRule *rule);
+            std::string _printNftAction(libfwbuilder::PolicyRule *rule,
+                                        bool &pure_verdict, bool &terminating);
+            std::string _printNftReject(libfwbuilder::PolicyRule *rule);
+            std::string _printNftLogParameters(libfwbuilder::PolicyRule *rule);
+            std::string _printNftLimit(libfwbuilder::PolicyRule *rule);
+
+            void _convertRule(libfwbuilder::PolicyRule *rule, nftRule &nr);
+
+            bool _mergeAddressSets(std::vector<nftRule> &rules, bool on_src);
+            void _mergeConcatenatedSets(std::vector<nftRule> &rules);
+            void _mergeVerdictMaps(std::vector<nftRule> &rules, bool on_src);
+
+            std::string _declareSet(const std::string &key_type,
+                                    bool interval,
+                                    const std::string &elements,
+                                    bool map,
+                                    std::string &decl);
+            std::string _printElements(const std::vector<nftElement> &elements,
+                                       bool &interval);
+            std::string _printAddrSet(const std::vector<nftElement> &elements,
+                                      bool neg, bool src, std::string &decl);
+            std::string _printNftRule(nftRule &nr);
+
+            virtual std::string _createChain(const std::string &chain);
+            virtual std::string _printPorts(int rs,int re);
+            virtual std::string _printDirectionAndInterface(
+                libfwbuilder::PolicyRule *r);
+            virtual std::string _printTimeInterval(libfwbuilder::PolicyRule *r);
+
+            public:
+            PrintRuleNft(const std::string &name);
+
+            virtual std::string _printOptionalGlobalRules();
+            virtual std::string _clampTcpToMssRule();
+            virtual std::string _declareTable();
+            virtual std::string _commit();
+            virtual std::string _quote(const std::string &s);
+
+            virtual std::string _startRuleLine();
+            virtual std::string _endRuleLine();
+
+            virtual bool processNext();
+        };
+        friend class PolicyCompiler_ipt::PrintRuleNft;
+
     };
 
 
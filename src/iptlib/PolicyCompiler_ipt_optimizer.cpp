@@ -33,8 +33,17 @@
 #include "fwbuilder/UDPService.h"
 #include "fwbuilder/Policy.h"
 #include "fwbuilder/Firewall.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/NetworkIPv6.h"
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/Library.h"
 
 #include "combinedAddress.h"
+#include "ipt_utils.h"
 
 #include <limits.h>
 
@@ -68,7 +77,7 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
     PolicyCompiler_ipt *ipt_comp=dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule     *r;
 
-    string this_chain = rule->getStr("ipt_chain");
+    string this_chain = rule->getStr(ipt_chain);
     string new_chain  = ipt_comp->getNewTmpChainName(rule);
 
     r= compiler->dbcopy->createPolicyRule();
@@ -122,7 +131,7 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
             }      
         }
     }
-    r->setStr("ipt_target",new_chain);
+    r->setStr(ipt_target,new_chain);
 
     r->setClassification(false);
     r->setRouting(false);
@@ -135,9 +144,9 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
     ruleopt->setInt("limit_value",-1);
     ruleopt->setInt("connlimit_value",-1);
     ruleopt->setInt("hashlimit_value",-1);
-    rule->setStr("ipt_chain",new_chain);
+    rule->setStr(ipt_chain,new_chain);
     rule->setBool("force_state_check",false);
-    rule->setStr("upstream_rule_chain", this_chain);
+    rule->setStr(upstream_rule_chain, this_chain);
     ipt_comp->registerChain(new_chain);
     ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
@@ -329,7 +338,7 @@ bool PolicyCompiler_ipt::optimizeForMinusIOPlus::processNext()
         return true;
     }
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(ipt_chain);
 
     if (iface_name == "*" && (chain == "INPUT" || chain == "OUTPUT"))
         itf_re->reset();
@@ -339,3 +348,637 @@ bool PolicyCompiler_ipt::optimizeForMinusIOPlus::processNext()
     return true;
 }
 
+
+/*
+ * Decision tree of chains.
+ *
+ * Long runs of rules with terminating targets are evaluated by
+ * iptables one rule at a time. This processor replaces such runs with
+ * a tree of user-defined chains: each level dispatches packets to a
+ * branch chain by inbound or outbound interface, by protocol or by
+ * one half of the destination address prefix that covers all rules
+ * in the run. Predicates of branches on the same level are mutually
+ * exclusive. A rule that can match packets going into more than one
+ * branch is copied into all of them, and rules that do not depend on
+ * the dispatch predicate are also placed after the dispatch rules in
+ * the parent chain. Relative order of rules is never changed. Packet
+ * that falls through a branch chain returns to the parent chain where
+ * the only rules it can still hit are those it has already been
+ * checked against in the branch, therefore the first match semantics
+ * of the original run is preserved.
+ *
+ * Rules that have side effects or match nondeterministically (limit,
+ * connlimit and hashlimit modules, time intervals, logging,
+ * marking, classification and routing) and rules with negation are
+ * never moved. They break runs of rules so the tree does not cross
+ * them.
+ *
+ * Rules that match many branches are copied into each of them, so for
+ * some policies the tree can be much bigger than the original run.
+ * The size of the tree is computed before it is built; if it would
+ * have more than DECISION_TREE_MAX_GROWTH times as many rules as the
+ * run, the run is left as it is and iptables checks it linearly.
+ */
+
+#define DECISION_TREE_MIN_RULES  8
+#define DECISION_TREE_LEAF_RULES 4
+#define DECISION_TREE_MAX_DEPTH  8
+#define DECISION_TREE_MAX_GROWTH 4
+
+bool PolicyCompiler_ipt::buildDecisionTree::isEligible(PolicyRule *rule)
+{
+    string target = rule->getStr(ipt_target);
+    if (target != "ACCEPT" && target != "DROP" && target != "REJECT")
+        return false;
+
+    if (rule->getLogging() || rule->getTagging() ||
+        rule->getClassification() || rule->getRouting()) return false;
+
+    FWOptions *ruleopt = rule->getOptionsObject();
+    if (ruleopt->getInt("limit_value") > 0 ||
+        ruleopt->getInt("connlimit_value") > 0 ||
+        ruleopt->getInt("hashlimit_value") > 0) return false;
+
+    RuleElementInterval *intrel = rule->getWhen();
+    if (intrel != NULL && !intrel->isAny()) return false;
+
+    for (FWObject::iterator i=rule->begin(); i!=rule->end(); ++i)
+    {
+        RuleElement *re = RuleElement::cast(*i);
+        if (re == NULL) continue;
+        if (re->getNeg() || re->getBool("single_object_negation"))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Returns true and fills first and last address matched by the
+ * destination of the rule if destination is a single static address,
+ * network or address range.
+ */
+bool PolicyCompiler_ipt::buildDecisionTree::getDstInterval(
+    PolicyRule *rule, InetAddr &first, InetAddr &last)
+{
+    RuleElementDst *dstrel = rule->getDst();
+    if (dstrel->isAny() || dstrel->size() != 1) return false;
+
+    FWObject *o = FWReference::getObject(dstrel->front());
+
+    if (AddressRange::isA(o))
+    {
+        first = AddressRange::cast(o)->getRangeStart();
+        last = AddressRange::cast(o)->getRangeEnd();
+    } else
+    {
+        if (IPv4::isA(o) || IPv6::isA(o))
+        {
+            first = *(Address::cast(o)->getAddressPtr());
+            last = first;
+        } else
+        {
+            if (Network::isA(o) || NetworkIPv6::isA(o))
+            {
+                InetAddr mask = *(Address::cast(o)->getNetmaskPtr());
+                first = *(Address::cast(o)->getAddressPtr()) & mask;
+                last = first | (~mask);
+            } else
+                return false;
+        }
+    }
+
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    return (first.isV6() == ipt_comp->ipv6 && last.isV6() == ipt_comp->ipv6);
+}
+
+/*
+ * Distributes rules between branches of the split. Value in keys is
+ * the index of the branch the rule belongs to, -1 if the rule can
+ * match packets in any branch and outside of all of them, -2 if it
+ * can match packets in any branch but never outside of them.
+ */
+void PolicyCompiler_ipt::buildDecisionTree::distribute(
+    const deque<PolicyRule*> &rules, const vector<int> &keys, Split &split)
+{
+    vector<Branch*> branch_index;
+    for (list<Branch>::iterator b=split.branches.begin();
+         b!=split.branches.end(); ++b)
+        branch_index.push_back(&(*b));
+
+    for (unsigned int n=0; n<rules.size(); ++n)
+    {
+        int k = keys[n];
+        if (k >= 0)
+        {
+            branch_index[k]->rules.push_back(rules[n]);
+            continue;
+        }
+        for (vector<Branch*>::iterator b=branch_index.begin();
+             b!=branch_index.end(); ++b)
+            (*b)->rules.push_back(rules[n]);
+        if (k == -1) split.rest.push_back(rules[n]);
+    }
+
+    /*
+     * Estimated number of rules a packet goes through: all
+     * dispatch rules plus the largest branch or the rules left in
+     * the parent chain.
+     */
+    unsigned int largest = split.rest.size();
+    for (list<Branch>::iterator b=split.branches.begin();
+         b!=split.branches.end(); ++b)
+        if (b->rules.size() > largest) largest = b->rules.size();
+
+    split.cost = split.branches.size() + largest;
+}
+
+void PolicyCompiler_ipt::buildDecisionTree::splitByInterface(
+    const deque<PolicyRule*> &rules, Split &split)
+{
+    vector<string> names;
+    vector<int> directions;
+    vector<FWObject*> interfaces;
+    int inbound = 0;
+    int outbound = 0;
+
+    split.kind = SPLIT_ITF;
+
+    for (deque<PolicyRule*>::const_iterator k=rules.begin();
+         k!=rules.end(); ++k)
+    {
+        PolicyRule *rule = *k;
+        RuleElementItf *itfrel = rule->getItf();
+        PolicyRule::Direction dir = rule->getDirection();
+        Interface *iface = NULL;
+
+        if (!itfrel->isAny() && itfrel->size() == 1 &&
+            rule->getStr(".iface") != "nil" &&
+            (dir == PolicyRule::Inbound || dir == PolicyRule::Outbound))
+            iface = Interface::cast(FWReference::getObject(itfrel->front()));
+
+        string name;
+        if (iface != NULL && !iface->isBridgePort()) name = iface->getName();
+        if (name.empty() || name[name.length()-1] == '*')
+        {
+            iface = NULL;
+            name = "";
+        }
+
+        if (iface != NULL)
+        {
+            if (dir == PolicyRule::Inbound) inbound++;
+            else outbound++;
+        }
+
+        names.push_back(name);
+        directions.push_back(dir);
+        interfaces.push_back(iface);
+    }
+
+    if (inbound + outbound == 0) return;
+
+    int direction = (inbound >= outbound) ?
+        PolicyRule::Inbound : PolicyRule::Outbound;
+
+    map<string, int> branch_no;
+    vector<int> keys;
+    for (unsigned int n=0; n<rules.size(); ++n)
+    {
+        if (interfaces[n] == NULL || directions[n] != direction)
+        {
+            keys.push_back(-1);
+            continue;
+        }
+
+        if (branch_no.count(names[n]) == 0)
+        {
+            branch_no[names[n]] = split.branches.size();
+            Branch b;
+            b.obj = interfaces[n];
+            b.direction = direction;
+            split.branches.push_back(b);
+        }
+        keys.push_back(branch_no[names[n]]);
+    }
+
+    distribute(rules, keys, split);
+}
+
+void PolicyCompiler_ipt::buildDecisionTree::splitByProtocol(
+    const deque<PolicyRule*> &rules, Split &split)
+{
+    map<string, int> branch_no;
+    vector<int> keys;
+
+    split.kind = SPLIT_PROTO;
+
+    for (deque<PolicyRule*>::const_iterator k=rules.begin();
+         k!=rules.end(); ++k)
+    {
+        PolicyRule *rule = *k;
+        RuleElementSrv *srvrel = rule->getSrv();
+        string proto;
+
+        if (!srvrel->isAny())
+        {
+            for (FWObject::iterator i=srvrel->begin(); i!=srvrel->end(); ++i)
+            {
+                FWObject *o = FWReference::getObject(*i);
+                string p;
+                if (TCPService::isA(o)) p = ANY_TCP_OBJ_ID;
+                if (UDPService::isA(o)) p = ANY_UDP_OBJ_ID;
+                if (p.empty() || (!proto.empty() && p != proto))
+                {
+                    proto = "";
+                    break;
+                }
+                proto = p;
+            }
+        }
+
+        if (proto.empty())
+        {
+            keys.push_back(-1);
+            continue;
+        }
+
+        if (branch_no.count(proto) == 0)
+        {
+            branch_no[proto] = split.branches.size();
+            Branch b;
+            b.obj = compiler->dbcopy->findInIndex(
+                FWObjectDatabase::getIntId(proto));
+            split.branches.push_back(b);
+        }
+        keys.push_back(branch_no[proto]);
+    }
+
+    if (split.branches.size() == 0) return;
+
+    distribute(rules, keys, split);
+}
+
+void PolicyCompiler_ipt::buildDecisionTree::splitByDestination(
+    const deque<PolicyRule*> &rules, Split &split)
+{
+    vector<InetAddr> firsts;
+    vector<InetAddr> lasts;
+    vector<bool> keyed;
+    int nkeyed = 0;
+
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    split.kind = SPLIT_DST;
+
+    for (deque<PolicyRule*>::const_iterator k=rules.begin();
+         k!=rules.end(); ++k)
+    {
+        InetAddr first;
+        InetAddr last;
+        bool res = getDstInterval(*k, first, last);
+        if (res) nkeyed++;
+        keyed.push_back(res);
+        firsts.push_back(first);
+        lasts.push_back(last);
+    }
+
+    if (nkeyed < 2) return;
+
+    int af = (ipt_comp->ipv6) ? AF_INET6 : AF_INET;
+    int bits = (ipt_comp->ipv6) ? 128 : 32;
+
+    /*
+     * find the longest prefix that covers destinations of all rules
+     * that have one. Packets with destination outside of this prefix
+     * can only match rules that do not check destination.
+     */
+    InetAddr base;
+    int len = 0;
+    for ( ; len < bits; ++len)
+    {
+        InetAddr mask(af, len + 1);
+        InetAddr b;
+        bool first_keyed = true;
+        bool common = true;
+        for (unsigned int n=0; n<rules.size() && common; ++n)
+        {
+            if (!keyed[n]) continue;
+            if (first_keyed)
+            {
+                b = firsts[n] & mask;
+                first_keyed = false;
+            }
+            common = ((firsts[n] & mask) == b && (lasts[n] & mask) == b);
+        }
+        if (!common) break;
+    }
+
+    // all rules match the same single address
+    if (len >= bits) return;
+
+    InetAddr prefix_mask(af, len);
+    InetAddr half_mask(af, len + 1);
+    for (unsigned int n=0; n<rules.size(); ++n)
+    {
+        if (keyed[n])
+        {
+            base = firsts[n] & prefix_mask;
+            break;
+        }
+    }
+
+    Branch b0;
+    b0.net = base;
+    b0.netmask = half_mask;
+    Branch b1;
+    b1.net = base | (half_mask & (~prefix_mask));
+    b1.netmask = half_mask;
+    split.branches.push_back(b0);
+    split.branches.push_back(b1);
+
+    vector<int> keys;
+    for (unsigned int n=0; n<rules.size(); ++n)
+    {
+        if (!keyed[n])
+        {
+            keys.push_back(-1);
+            continue;
+        }
+        InetAddr f = firsts[n] & half_mask;
+        InetAddr l = lasts[n] & half_mask;
+        if (f == l && f == b0.net) keys.push_back(0);
+        else
+        {
+            if (f == l && f == b1.net) keys.push_back(1);
+            else keys.push_back(-2);
+        }
+    }
+
+    distribute(rules, keys, split);
+}
+
+PolicyRule* PolicyCompiler_ipt::buildDecisionTree::placeRule(
+    PolicyRule *rule, const string &chain)
+{
+    PolicyRule *r = rule;
+    if (placed_rules.count(rule) != 0)
+    {
+        r = compiler->dbcopy->createPolicyRule();
+        compiler->temp_ruleset->add(r);
+        r->duplicate(rule);
+    }
+    placed_rules.insert(rule);
+
+    if (r->getStr(ipt_chain) != chain)
+    {
+        r->setStr(upstream_rule_chain, rule->getStr(ipt_chain));
+        r->setStr(ipt_chain, chain);
+    }
+    return r;
+}
+
+PolicyRule* PolicyCompiler_ipt::buildDecisionTree::createDispatchRule(
+    SplitKind kind, const Branch &branch,
+    const string &chain, const string &target)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    PolicyRule *r = compiler->dbcopy->createPolicyRule();
+    compiler->temp_ruleset->add(r);
+    r->duplicate(block_head);
+
+    for (FWObject::iterator i=r->begin(); i!=r->end(); ++i)
+    {
+        RuleElement *re = RuleElement::cast(*i);
+        if (re != NULL) re->reset();
+    }
+
+    r->setStr(ipt_chain, chain);
+    r->setStr(ipt_target, target);
+    r->setStr(".iface", "");
+    r->setBool("ipt_multiport", false);
+    r->setBool("force_state_check", false);
+    r->setDirection(PolicyRule::Both);
+    r->setLogging(false);
+
+    FWOptions *ruleopt = r->getOptionsObject();
+    ruleopt->setBool("stateless", true);
+    ruleopt->setInt("limit_value", -1);
+    ruleopt->setInt("connlimit_value", -1);
+    ruleopt->setInt("hashlimit_value", -1);
+
+    switch (kind)
+    {
+    case SPLIT_ITF:
+        r->getItf()->clearChildren();
+        r->getItf()->addRef(branch.obj);
+        r->setDirection(PolicyRule::Direction(branch.direction));
+        break;
+
+    case SPLIT_PROTO:
+        r->getSrv()->clearChildren();
+        r->getSrv()->addRef(branch.obj);
+        break;
+
+    case SPLIT_DST:
+    {
+        Address *net = Address::cast(compiler->dbcopy->create(
+            (ipt_comp->ipv6) ? NetworkIPv6::TYPENAME : Network::TYPENAME));
+        net->setName(string("%") + branch.net.toString() + "/" +
+                     branch.netmask.toString() + "%");
+        net->setAddress(branch.net);
+        net->setNetmask(branch.netmask);
+        compiler->persistent_objects->add(net, false);
+        r->getDst()->clearChildren();
+        r->getDst()->addRef(net);
+        break;
+    }
+    }
+
+    return r;
+}
+
+void PolicyCompiler_ipt::buildDecisionTree::chooseSplit(
+    const deque<PolicyRule*> &rules, int depth, Split &best)
+{
+    if (rules.size() <= DECISION_TREE_LEAF_RULES ||
+        depth >= DECISION_TREE_MAX_DEPTH) return;
+
+    Split by_itf;
+    Split by_proto;
+    Split by_dst;
+    splitByInterface(rules, by_itf);
+    splitByProtocol(rules, by_proto);
+    splitByDestination(rules, by_dst);
+    if (by_itf.cost < best.cost) best = by_itf;
+    if (by_proto.cost < best.cost) best = by_proto;
+    if (by_dst.cost < best.cost) best = by_dst;
+}
+
+/*
+ * Counts rules buildTree would generate for the given rules,
+ * including dispatch rules, without creating anything. Stops as soon
+ * as the count exceeds the limit.
+ */
+int PolicyCompiler_ipt::buildDecisionTree::countTreeRules(
+    const deque<PolicyRule*> &rules, int depth, int limit)
+{
+    Split best;
+    chooseSplit(rules, depth, best);
+
+    if (best.cost >= int(rules.size())) return rules.size();
+
+    int count = best.branches.size();
+    for (list<Branch>::iterator b=best.branches.begin();
+         b!=best.branches.end() && count <= limit; ++b)
+        count += countTreeRules(b->rules, depth + 1, limit - count);
+
+    if (count <= limit)
+        count += countTreeRules(best.rest, depth, limit - count);
+
+    return count;
+}
+
+PolicyCompiler_ipt::buildDecisionTree::TreeStats
+PolicyCompiler_ipt::buildDecisionTree::buildTree(
+    const string &chain, const deque<PolicyRule*> &rules,
+    int depth, deque<Rule*> &out)
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+    TreeStats stats;
+    stats.depth = depth;
+
+    Split best;
+    chooseSplit(rules, depth, best);
+
+    if (best.cost >= int(rules.size()))
+    {
+        for (deque<PolicyRule*>::const_iterator k=rules.begin();
+             k!=rules.end(); ++k)
+            out.push_back(placeRule(*k, chain));
+        stats.cost = rules.size();
+        return stats;
+    }
+
+    int largest_branch = 0;
+    for (list<Branch>::iterator b=best.branches.begin();
+         b!=best.branches.end(); ++b)
+    {
+        string new_chain = ipt_comp->getNewTmpChainName(block_head);
+        out.push_back(createDispatchRule(best.kind, *b, chain, new_chain));
+        ipt_comp->registerChain(new_chain);
+        ipt_comp->insertUpstreamChain(chain, new_chain);
+
+        TreeStats bs = buildTree(new_chain, b->rules, depth + 1, out);
+        stats.chains += bs.chains + 1;
+        if (bs.depth > stats.depth) stats.depth = bs.depth;
+        if (bs.cost > largest_branch) largest_branch = bs.cost;
+    }
+
+    TreeStats rs = buildTree(chain, best.rest, depth, out);
+    stats.chains += rs.chains;
+    if (rs.depth > stats.depth) stats.depth = rs.depth;
+    stats.cost = best.branches.size() + largest_branch + rs.cost;
+
+    return stats;
+}
+
+bool PolicyCompiler_ipt::buildDecisionTree::processNext()
+{
+    PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
+
+    slurp();
+    if (tmp_queue.size()==0) return false;
+
+    if (!compiler->getCachedFwOpt()->getBool("ipt_decision_tree_chains") ||
+        ipt_comp->my_table != "filter" || ipt_comp->usingNftables())
+        return true;
+
+    /*
+     * find runs of eligible rules. Rules of different chains can be
+     * interleaved in the queue, so runs are tracked per chain.
+     */
+    map<string, deque<PolicyRule*> > runs;
+    vector<deque<PolicyRule*> > blocks;
+    map<PolicyRule*, int> rule_block;
+
+    for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k)
+    {
+        PolicyRule *rule = PolicyRule::cast( *k );
+        string chain = rule->getStr(ipt_chain);
+        deque<PolicyRule*> &run = runs[chain];
+
+        if (isEligible(rule))
+        {
+            run.push_back(rule);
+            continue;
+        }
+
+        if (run.size() >= DECISION_TREE_MIN_RULES)
+        {
+            for (deque<PolicyRule*>::iterator r=run.begin(); r!=run.end(); ++r)
+                rule_block[*r] = blocks.size();
+            blocks.push_back(run);
+        }
+        run.clear();
+    }
+
+    for (map<string, deque<PolicyRule*> >::iterator i=runs.begin();
+         i!=runs.end(); ++i)
+    {
+        deque<PolicyRule*> &run = i->second;
+        if (run.size() >= DECISION_TREE_MIN_RULES)
+        {
+            for (deque<PolicyRule*>::iterator r=run.begin(); r!=run.end(); ++r)
+                rule_block[*r] = blocks.size();
+            blocks.push_back(run);
+        }
+    }
+
+    if (blocks.size() == 0) return true;
+
+    deque<Rule*> out;
+    for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k)
+    {
+        PolicyRule *rule = PolicyRule::cast( *k );
+        if (rule_block.count(rule) == 0)
+        {
+            out.push_back(rule);
+            continue;
+        }
+
+        deque<PolicyRule*> &block = blocks[rule_block[rule]];
+        if (block.front() != rule) continue;
+
+        block_head = rule;
+        string chain = rule->getStr(ipt_chain);
+
+        int limit = DECISION_TREE_MAX_GROWTH * block.size();
+        if (countTreeRules(block, 0, limit) > limit)
+        {
+            ostringstream str;
+            str << "Decision tree for " << block.size()
+                << " rules in chain " << chain
+                << " would need more than " << limit
+                << " rules, keeping them in linear order";
+            compiler->info(str.str());
+            out.insert(out.end(), block.begin(), block.end());
+            continue;
+        }
+
+        TreeStats stats = buildTree(chain, block, 0, out);
+
+        if (stats.chains > 0)
+        {
+            ostringstream str;
+            str << "Decision tree for " << block.size()
+                << " rules in chain " << chain << ": "
+                << stats.chains << " chains, depth " << stats.depth
+                << ", at most " << stats.cost
+                << " rules checked per packet";
+            compiler->info(str.str());
+        }
+    }
+
+    tmp_queue = out;
+    return true;
+}
@@ -243,6 +243,8 @@ void RoutingCompiler_ipt::compile()
     add(new ConvertToAtomicForDST(
             "Convert to atomic rules by dst address elements"));
 
+    add(new aggregateRoutes("Aggregate routes"));
+
     add(new createSortedDstIdsLabel(
             "Create label with a sorted dst-id-list for 'classifyRoutingRules'"));
     add(new classifyRoutingRules(
@@ -0,0 +1,227 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "RuleHitSimulator_ipt.h"
+#include "CompilerDriver_ipt.h"
+#include "ipt_utils.h"
+
+#include "fwcompiler/Compiler.h"
+
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+
+#include <QStringList>
+
+#include <sstream>
+
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+namespace
+{
+    // targets that do something to the packet and let it continue
+    bool isNonTerminating(const string &target)
+    {
+        return (target.empty() || target == ".CONTINUE" ||
+                target == "LOG" || target == "ULOG" || target == "NFLOG" ||
+                target == "MARK" || target == "CONNMARK" ||
+                target == "CLASSIFY" || target == "TCPMSS");
+    }
+
+    // targets whose decision is made outside of the rules
+    bool isUnknown(const string &target)
+    {
+        return (target == "QUEUE" || target == "NFQUEUE" ||
+                target == "ROUTE" || target == ".CUSTOM" ||
+                target == "UNDEFINED");
+    }
+
+    bool isTranslation(const string &target)
+    {
+        return (target == "SNAT" || target == "DNAT" ||
+                target == "MASQUERADE" || target == "NETMAP" ||
+                target == "REDIRECT");
+    }
+
+    bool sameMatch(const PolicyModel::Term &a, const PolicyModel::Term &b)
+    {
+        for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+            if (!(a.field[d] == b.field[d])) return false;
+        return true;
+    }
+}
+
+RuleHitSimulator_ipt::RuleHitSimulator_ipt(RuleHitSimulator &sim) :
+    simulator(sim)
+{
+}
+
+RuleHitSimulator_ipt::~RuleHitSimulator_ipt()
+{
+}
+
+string RuleHitSimulator_ipt::chainName(const string &table, const string &chain)
+{
+    return table + "/" + chain;
+}
+
+void RuleHitSimulator_ipt::warning(Rule *rule, const string &msg)
+{
+    ostringstream str;
+    if (rule->getParent()) str << rule->getParent()->getName() << " ";
+    str << "rule " << rule->getPosition() << ": " << msg;
+    warnings.push_back(str.str());
+}
+
+/*
+ * PolicyModel converts interface element of the rule according to
+ * its direction, but iptables compiler prints -i / -o only for rules
+ * with direction Inbound or Outbound and never for rules marked with
+ * ".iface" "nil" (NAT: ".iface_in" / ".iface_out"). Interfaces the
+ * compiler does not print match anything.
+ */
+void RuleHitSimulator_ipt::buildTerms(Rule *rule, vector<PolicyModel::Term> &terms)
+{
+    PolicyModel &model = simulator.getModel();
+    vector<PolicyModel::Term> all;
+    model.buildTerms(rule, all);
+
+    bool any_in = false;
+    bool any_out = false;
+
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    if (policy_rule)
+    {
+        PolicyRule::Direction dir = policy_rule->getDirection();
+        bool printed = (rule->getStr(".iface") != "nil" &&
+                        !policy_rule->getItf()->isAny());
+        any_in = !(printed && dir == PolicyRule::Inbound);
+        any_out = !(printed && dir == PolicyRule::Outbound);
+    }
+
+    NATRule *nat_rule = NATRule::cast(rule);
+    if (nat_rule)
+    {
+        any_in = (rule->getStr(".iface_in") == "nil");
+        any_out = (rule->getStr(".iface_out") == "nil");
+    }
+
+    for (vector<PolicyModel::Term>::iterator t=all.begin(); t!=all.end(); ++t)
+    {
+        if (any_in) t->field[PolicyModel::IN_ITF] =
+                        model.getDomain(PolicyModel::IN_ITF);
+        if (any_out) t->field[PolicyModel::OUT_ITF] =
+                         model.getDomain(PolicyModel::OUT_ITF);
+        model.finishTerm(*t);
+
+        // rules with direction Both produce a term for each
+        // direction, they become the same once interfaces are dropped
+        bool duplicate = false;
+        for (vector<PolicyModel::Term>::iterator r=terms.begin();
+             r!=terms.end() && !duplicate; ++r)
+            duplicate = sameMatch(*r, *t);
+        if (!duplicate) terms.push_back(*t);
+    }
+}
+
+int RuleHitSimulator_ipt::addCompiledRules(const string &table, Compiler *compiler)
+{
+    int count = 0;
+    const list<Rule*> &rules = compiler->getCompiledRules();
+    for (list<Rule*>::const_iterator i=rules.begin(); i!=rules.end(); ++i)
+    {
+        Rule *rule = *i;
+        string chain = rule->getStr(ipt_chain);
+        string target = rule->getStr(ipt_target);
+        if (chain.empty())
+        {
+            warning(rule, "rule has no chain");
+            continue;
+        }
+
+        PolicyModel::Decision decision = PolicyModel::NO_DECISION;
+        bool returns = false;
+        string jump;
+
+        if (target == "ACCEPT")
+            decision = (NATRule::cast(rule)) ?
+                PolicyModel::NO_TRANSLATION : PolicyModel::ACCEPT;
+        else if (target == "DROP")
+            decision = PolicyModel::DENY;
+        else if (target == "REJECT")
+            decision = PolicyModel::REJECT;
+        else if (target == "RETURN")
+            returns = true;
+        else if (isTranslation(target))
+            decision = PolicyModel::TRANSLATE;
+        else if (isUnknown(target))
+            warning(rule, "target " + target + " is not modelled");
+        else if (!isNonTerminating(target))
+            jump = chainName(table, target);
+
+        vector<PolicyModel::Term> terms;
+        buildTerms(rule, terms);
+        simulator.addRule(chainName(table, chain), rule, terms,
+                          decision, returns, jump);
+        count++;
+    }
+    return count;
+}
+
+void RuleHitSimulator_ipt::compile(Firewall *fw)
+{
+    if (driver.get() != NULL)
+        throw FWException("Compiled rules have already been loaded");
+
+    driver = std::auto_ptr<CompilerDriver_ipt>(
+        new CompilerDriver_ipt(fw->getRoot()));
+    driver->setEmbeddedMode();
+    driver->setRuleHitSimulator(this);
+
+    QStringList args;
+    args << QString::fromUtf8(fw->getName().c_str());
+    if (!driver->prepare(args))
+        throw FWException("Can not compile firewall " + fw->getName());
+    driver->compile();
+    if (driver->getStatus() == BaseCompiler::FWCOMPILER_ERROR)
+        throw FWException("Compiler failed for firewall " + fw->getName());
+}
+
+bool RuleHitSimulator_ipt::compare(Firewall *fw,
+                                   const RuleHitSimulator_ipt &a,
+                                   const RuleHitSimulator_ipt &b,
+                                   const string &chain,
+                                   vector<PolicyDecisionMap::Difference> &diffs,
+                                   int max_differences)
+{
+    PolicyModel model_a(fw, a.simulator.getModel().addressFamily());
+    PolicyModel model_b(fw, b.simulator.getModel().addressFamily());
+    a.simulator.buildModel(chain, model_a);
+    b.simulator.buildModel(chain, model_b);
+    return PolicyDecisionMap::compare(model_a, model_b, diffs, max_differences);
+}
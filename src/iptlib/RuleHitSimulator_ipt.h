@@ -0,0 +1,128 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __RULEHITSIMULATOR_IPT_HH__
+#define __RULEHITSIMULATOR_IPT_HH__
+
+#include "fwcompiler/PolicyDecisionMap.h"
+#include "fwcompiler/RuleHitSimulator.h"
+
+#include <list>
+#include <memory>
+#include <string>
+
+
+namespace libfwbuilder
+{
+    class Firewall;
+    class Rule;
+};
+
+namespace fwcompiler
+{
+    class Compiler;
+    class CompilerDriver_ipt;
+
+    /**
+     * Loads rules produced by iptables policy and NAT compilers into
+     * RuleHitSimulator, laid out in chains the way they are printed:
+     * chain and target come from the ipt_chain and ipt_target
+     * annotations, interfaces are matched only where the compiler
+     * prints -i / -o. Built-in targets decide, RETURN goes back to
+     * the calling chain, LOG, MARK and other non-terminating targets
+     * let the packet continue and any other target is a jump to the
+     * user chain of this name.
+     *
+     * Chains are named "<table>/<chain>", for example
+     * "filter/FORWARD" or "nat/POSTROUTING". Automatic rules the
+     * compilers print as text (conntrack, loopback, default policy)
+     * are not rule objects and are not loaded; matches the model does
+     * not represent, such as module state, are ignored.
+     *
+     * Two compiles of the same firewall, for example with and
+     * without an optimization, are compared with compile() and
+     * compare(): the chains are flattened into policy models and
+     * compared with PolicyDecisionMap, so the chain and jump layout
+     * the compiler produced is checked, not only the rule set.
+     */
+    class RuleHitSimulator_ipt
+    {
+        RuleHitSimulator &simulator;
+        std::auto_ptr<CompilerDriver_ipt> driver;
+        std::list<std::string> warnings;
+
+        void warning(libfwbuilder::Rule *rule, const std::string &msg);
+        void buildTerms(libfwbuilder::Rule *rule,
+                        std::vector<PolicyModel::Term> &terms);
+
+        public:
+
+        RuleHitSimulator_ipt(RuleHitSimulator &simulator);
+        ~RuleHitSimulator_ipt();
+
+        static std::string chainName(const std::string &table,
+                                     const std::string &chain);
+
+        /**
+         * adds rules the compiler produced in its last run of rule
+         * processors, the compiler must have been set up with
+         * setKeepCompiledRules(true) before compile(). Rules belong to
+         * the object database the compiler works with and must
+         * outlive the simulator. Returns number of rules added.
+         */
+        int addCompiledRules(const std::string &table, Compiler *compiler);
+
+        /**
+         * compiles firewall fw with CompilerDriver_ipt and adds the
+         * rules it produces. The driver and its copy of the objects
+         * are kept by the adapter, so this can be done once per
+         * adapter. The script is generated as usual. Throws
+         * FWException if the compiler fails.
+         */
+        void compile(libfwbuilder::Firewall *fw);
+
+        /**
+         * compares decisions of the chain, including the chains it
+         * jumps to, in two compiles of firewall fw. See
+         * PolicyDecisionMap::compare(); rule numbers of the
+         * differences are not meaningful outside of this function.
+         */
+        static bool compare(libfwbuilder::Firewall *fw,
+                            const RuleHitSimulator_ipt &a,
+                            const RuleHitSimulator_ipt &b,
+                            const std::string &chain,
+                            std::vector<PolicyDecisionMap::Difference> &diffs,
+                            int max_differences=10);
+
+        RuleHitSimulator& getSimulator() { return simulator; }
+
+        /**
+         * targets the adapter does not know what to do with, the
+         * packet continues with the next rule
+         */
+        const std::list<std::string>& getWarnings() const { return warnings; }
+    };
+
+};
+
+#endif
@@ -43,6 +43,15 @@ using namespace fwcompiler;
 using namespace std;
 
 
+const RuleAnnotationKey fwcompiler::ipt_chain(
+    "ipt_chain", RuleAnnotationKey::String);
+const RuleAnnotationKey fwcompiler::ipt_target(
+    "ipt_target", RuleAnnotationKey::String);
+const RuleAnnotationKey fwcompiler::upstream_rule_chain(
+    "upstream_rule_chain", RuleAnnotationKey::String);
+const RuleAnnotationKey fwcompiler::subrule_suffix(
+    "subrule_suffix", RuleAnnotationKey::String);
+
 void build_interface_groups(
     FWObjectDatabase *dbcopy, Library *persistent_objects, Firewall *fw, bool ipv6,
     QMap<QString, libfwbuilder::FWObject*> &regular_interfaces)
@@ -22,6 +22,8 @@
 */
 
 
+#include "fwbuilder/RuleAnnotation.h"
+
 #include <QMap>
 #include <QString>
 
@@ -38,6 +40,17 @@ namespace libfwbuilder
 namespace fwcompiler
 {
     class Compiler;
+
+    /*
+     * Annotations rule processors of iptables compilers attach to
+     * rules: chain and target of the rule, chain of the rule that
+     * jumps to it and suffix added to the names of chains created for
+     * it.
+     */
+    extern const libfwbuilder::RuleAnnotationKey ipt_chain;
+    extern const libfwbuilder::RuleAnnotationKey ipt_target;
+    extern const libfwbuilder::RuleAnnotationKey upstream_rule_chain;
+    extern const libfwbuilder::RuleAnnotationKey subrule_suffix;
 };
 
 
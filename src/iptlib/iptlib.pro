@@ -22,12 +22,14 @@ SOURCES	 =  CompilerDriver_ipt.cpp \
 			PolicyCompiler_PrintRule.cpp \
 			PolicyCompiler_PrintRuleIptRst.cpp \
 			PolicyCompiler_PrintRuleIptRstEcho.cpp \
+			PolicyCompiler_PrintRuleNft.cpp \
 			PolicyCompiler_ipt.cpp \
 			PolicyCompiler_ipt_optimizer.cpp \
 			PolicyCompiler_secuwall.cpp \
 			RoutingCompiler_ipt.cpp \
 			RoutingCompiler_ipt_writers.cpp \
 			Preprocessor_ipt.cpp \
+			RuleHitSimulator_ipt.cpp \
 			combinedAddress.cpp \
 			AutomaticRules_ipt.cpp \
 			ipt_utils.cpp
@@ -44,6 +46,7 @@ HEADERS	 = ../../config.h \
 			PolicyCompiler_secuwall.h \
 			RoutingCompiler_ipt.h \
 			Preprocessor_ipt.h \
+			RuleHitSimulator_ipt.h \
 			combinedAddress.h \
 			AutomaticRules_ipt.h \
 			ipt_utils.h
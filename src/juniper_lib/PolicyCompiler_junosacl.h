@@ -271,14 +271,14 @@ namespace fwcompiler {
             struct printRulesForACL : public std::unary_function<libfwbuilder::Rule*, void>
             {
                 ciscoACL *acl;
-                std::stringstream *output;
+                std::ostream *output;
                 PolicyCompiler_junosacl *iosacl_comp;
                 PolicyCompiler_junosacl::PrintCompleteACLs *print_acl_p;
 
                 printRulesForACL(PolicyCompiler_junosacl *_comp,
                                  PolicyCompiler_junosacl::PrintCompleteACLs *pp,
                                  ciscoACL* _acl,
-                                 std::stringstream *_out)
+                                 std::ostream *_out)
                 { iosacl_comp = _comp; print_acl_p = pp; acl = _acl; output = _out; }
 
                 // print rule if it belongs to ACL <acl>
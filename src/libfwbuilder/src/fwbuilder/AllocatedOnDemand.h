@@ -0,0 +1,91 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __ALLOCATEDONDEMAND_HH_FLAG__
+#define __ALLOCATEDONDEMAND_HH_FLAG__
+
+#include <stdlib.h>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Holds a value of type T that is allocated only when it is
+ * modified for the first time. Until then get() returns reference to
+ * a shared empty value. Used for members of FWObject that stay empty
+ * in almost all objects, holder of an unallocated value is the size
+ * of a pointer.
+ */
+template <class T> class AllocatedOnDemand
+{
+    T *value;
+
+    static const T& emptyValue()
+    {
+        static T empty_value;
+        return empty_value;
+    }
+
+public:
+
+    AllocatedOnDemand() : value(NULL) {}
+    AllocatedOnDemand(const AllocatedOnDemand<T> &other) : value(NULL)
+    {
+        if (other.value) value = new T(*other.value);
+    }
+    ~AllocatedOnDemand() { delete value; }
+
+    AllocatedOnDemand<T>& operator=(const AllocatedOnDemand<T> &other)
+    {
+        if (this == &other) return *this;
+        if (other.value == NULL) reset();
+        else if (value) *value = *other.value;
+        else value = new T(*other.value);
+        return *this;
+    }
+
+    const T& get() const { return (value) ? *value : emptyValue(); }
+
+    /**
+     * returns reference to the value, allocates it if needed
+     */
+    T& edit()
+    {
+        if (value == NULL) value = new T();
+        return *value;
+    }
+
+    /**
+     * frees the value, get() returns empty value after this
+     */
+    void reset()
+    {
+        delete value;
+        value = NULL;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/AttributeMap.h"
+
+#include <algorithm>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+class AttributeNameLess
+{
+public:
+    bool operator()(const AttributeMap::value_type &a, const string &b) const
+    { return a.first.str() < b; }
+};
+
+AttributeMap::iterator AttributeMap::lowerBound(const string &name)
+{
+    return lower_bound(attributes.begin(), attributes.end(), name,
+                       AttributeNameLess());
+}
+
+AttributeMap::const_iterator AttributeMap::lowerBound(const string &name) const
+{
+    return lower_bound(attributes.begin(), attributes.end(), name,
+                       AttributeNameLess());
+}
+
+AttributeMap::iterator AttributeMap::find(const string &name)
+{
+    iterator it = lowerBound(name);
+    if (it != attributes.end() && it->first.str() == name) return it;
+    return attributes.end();
+}
+
+AttributeMap::const_iterator AttributeMap::find(const string &name) const
+{
+    const_iterator it = lowerBound(name);
+    if (it != attributes.end() && it->first.str() == name) return it;
+    return attributes.end();
+}
+
+/*
+ * Objects are created and their attributes set one by one while the
+ * data file is loaded, default growth of std::vector would leave
+ * most of them with unused capacity. Grow by a quarter instead.
+ */
+string& AttributeMap::operator[](const string &name)
+{
+    iterator it = lowerBound(name);
+    if (it != attributes.end() && it->first.str() == name) return it->second;
+
+    // name can refer to a value stored in this map, make the new
+    // pair before the values move
+    value_type attr(name, string());
+    if (attributes.size() == attributes.capacity())
+    {
+        size_type pos = it - attributes.begin();
+        attributes.reserve(attributes.size() + attributes.size() / 4 + 2);
+        it = attributes.begin() + pos;
+    }
+    return attributes.insert(it, attr)->second;
+}
+
+AttributeMap::size_type AttributeMap::erase(const string &name)
+{
+    iterator it = find(name);
+    if (it == attributes.end()) return 0;
+    attributes.erase(it);
+    return 1;
+}
+
+bool AttributeMap::operator==(const AttributeMap &other) const
+{
+    if (attributes.size() != other.attributes.size()) return false;
+    for (size_type i=0; i<attributes.size(); ++i)
+    {
+        if (attributes[i].first != other.attributes[i].first ||
+            attributes[i].second != other.attributes[i].second) return false;
+    }
+    return true;
+}
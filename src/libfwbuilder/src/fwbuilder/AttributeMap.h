@@ -0,0 +1,97 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __ATTRIBUTEMAP_HH_FLAG__
+#define __ATTRIBUTEMAP_HH_FLAG__
+
+#include "fwbuilder/InternedString.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Attributes of an object: pairs name - value kept in a vector
+ * sorted by name. Most objects have only a few attributes, a sorted
+ * vector takes much less memory than std::map that allocates a node
+ * for every pair. Names are interned since the same few dozen names
+ * are used by all objects in the tree.
+ *
+ * Interface follows std::map<std::string, std::string>, iteration
+ * order is the same. Unlike std::map, inserting or removing an
+ * attribute invalidates iterators and references to values of all
+ * attributes.
+ */
+class AttributeMap
+{
+public:
+
+    typedef std::pair<InternedString, std::string> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef std::vector<value_type>::size_type size_type;
+
+private:
+
+    std::vector<value_type> attributes;
+
+    iterator lowerBound(const std::string &name);
+    const_iterator lowerBound(const std::string &name) const;
+
+public:
+
+    iterator begin() { return attributes.begin(); }
+    iterator end() { return attributes.end(); }
+    const_iterator begin() const { return attributes.begin(); }
+    const_iterator end() const { return attributes.end(); }
+
+    size_type size() const { return attributes.size(); }
+    bool empty() const { return attributes.empty(); }
+
+    iterator find(const std::string &name);
+    const_iterator find(const std::string &name) const;
+    size_type count(const std::string &name) const
+    { return (find(name) == end()) ? 0 : 1; }
+
+    /**
+     * returns reference to the value of attribute name, adds
+     * attribute with empty value if it does not exist
+     */
+    std::string& operator[](const std::string &name);
+
+    void erase(iterator it) { attributes.erase(it); }
+    size_type erase(const std::string &name);
+    void clear() { std::vector<value_type>().swap(attributes); }
+
+    bool operator==(const AttributeMap &other) const;
+    bool operator!=(const AttributeMap &other) const
+    { return !(*this == other); }
+};
+
+}
+
+#endif
@@ -54,17 +54,17 @@ bool ClusterGroup::validateChild(FWObject *o)
              otype == FWObjectReference::TYPENAME));
 }
 
-void ClusterGroup::replaceReferenceInternal(int old_id, int new_id, int &counter)
+void ClusterGroup::replaceReferencesInternal(const map<int,int> &map_ids,
+                                             int &counter)
 {
-    if (old_id == new_id) return;
-
-    FWObject::replaceReferenceInternal(old_id, new_id, counter);
+    FWObject::replaceReferencesInternal(map_ids, counter);
 
     string master_iface_id = getStr("master_iface");
     if (!master_iface_id.empty())
     {
         int master_iface_id_int = FWObjectDatabase::getIntId(master_iface_id);
-        if (master_iface_id_int == old_id)
+        int new_id;
+        if (mapReferenceId(map_ids, master_iface_id_int, new_id))
         {
             setStr("master_iface", FWObjectDatabase::getStringId(new_id));
             counter++;
@@ -0,0 +1,207 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/DNSCache.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#ifndef _WIN32
+#  include <sys/socket.h>
+#else
+#  include <winsock2.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * File format: one line per name and address family
+ *
+ *    name 4|6 expiration_time address address ...
+ *
+ * expiration_time is in seconds since the epoch. Lines that start
+ * with '#' are comments.
+ */
+
+bool DNSCache::lookup(const string &name, int type,
+                      list<InetAddr> &addresses, string &error)
+{
+    mutex.lock();
+    map<pair<string, int>, Entry>::iterator it =
+        entries.find(pair<string, int>(name, type));
+    if (it == entries.end() ||
+        (it->second.error.empty() && it->second.expires <= time(NULL)))
+    {
+        mutex.unlock();
+        return false;
+    }
+    addresses = it->second.addresses;
+    error = it->second.error;
+    mutex.unlock();
+    return true;
+}
+
+void DNSCache::store(const string &name, int type,
+                     const list<InetAddr> &addresses, unsigned int ttl)
+{
+    Entry e;
+    e.addresses = addresses;
+    e.expires = time(NULL) + ttl;
+    mutex.lock();
+    entries[pair<string, int>(name, type)] = e;
+    mutex.unlock();
+}
+
+void DNSCache::storeError(const string &name, int type, const string &error)
+{
+    Entry e;
+    e.error = error;
+    e.expires = 0;
+    mutex.lock();
+    entries[pair<string, int>(name, type)] = e;
+    mutex.unlock();
+}
+
+void DNSCache::clearErrors()
+{
+    mutex.lock();
+    map<pair<string, int>, Entry>::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+        if (!it->second.error.empty()) entries.erase(it++);
+        else ++it;
+    }
+    mutex.unlock();
+}
+
+void DNSCache::clear()
+{
+    mutex.lock();
+    entries.clear();
+    mutex.unlock();
+}
+
+int DNSCache::size()
+{
+    mutex.lock();
+    int n = entries.size();
+    mutex.unlock();
+    return n;
+}
+
+void DNSCache::load(const string &file_name) throw(FWException)
+{
+    ifstream in(file_name.c_str());
+    if (!in) return;
+
+    time_t now = time(NULL);
+    string line;
+    int line_no = 0;
+    while (getline(in, line))
+    {
+        line_no++;
+        if (line.empty() || line[0] == '#') continue;
+
+        istringstream str(line);
+        string name;
+        int family = 0;
+        long expires = 0;
+        if (!(str >> name >> family >> expires) || (family != 4 && family != 6))
+        {
+            ostringstream err;
+            err << "Invalid DNS cache file " << file_name
+                << " at line " << line_no;
+            throw FWException(err.str());
+        }
+        if (expires <= now) continue;
+
+        int type = (family == 4) ? AF_INET : AF_INET6;
+        Entry e;
+        e.expires = expires;
+        string addr;
+        while (str >> addr)
+        {
+            try
+            {
+                e.addresses.push_back(InetAddr(type, addr));
+            } catch (FWException &ex)
+            {
+                ostringstream err;
+                err << "Invalid DNS cache file " << file_name
+                    << " at line " << line_no << ": " << ex.toString();
+                throw FWException(err.str());
+            }
+        }
+
+        mutex.lock();
+        entries[pair<string, int>(name, type)] = e;
+        mutex.unlock();
+    }
+}
+
+void DNSCache::save(const string &file_name) throw(FWException)
+{
+    string tmp_file_name = file_name + ".tmp";
+    ofstream out(tmp_file_name.c_str());
+    if (!out)
+        throw FWException("Can not open DNS cache file " + tmp_file_name +
+                          " for writing: " + strerror(errno));
+
+    time_t now = time(NULL);
+    out << "# Firewall Builder DNS cache" << endl;
+
+    mutex.lock();
+    for (map<pair<string, int>, Entry>::iterator it=entries.begin();
+         it!=entries.end(); ++it)
+    {
+        if (!it->second.error.empty() || it->second.expires <= now) continue;
+        out << it->first.first << " "
+            << ((it->first.second == AF_INET) ? 4 : 6) << " "
+            << (long)(it->second.expires);
+        for (list<InetAddr>::iterator i=it->second.addresses.begin();
+             i!=it->second.addresses.end(); ++i)
+            out << " " << i->toString();
+        out << endl;
+    }
+    mutex.unlock();
+
+    out.close();
+    if (!out)
+        throw FWException("Error writing DNS cache file " + tmp_file_name);
+
+#ifdef _WIN32
+    remove(file_name.c_str());
+#endif
+    if (rename(tmp_file_name.c_str(), file_name.c_str()) != 0)
+        throw FWException("Can not rename " + tmp_file_name + " to " +
+                          file_name + ": " + strerror(errno));
+}
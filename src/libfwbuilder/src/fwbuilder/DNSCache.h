@@ -0,0 +1,97 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __DNSCACHE_HH_FLAG__
+#define __DNSCACHE_HH_FLAG__
+
+#include "fwbuilder/InetAddr.h"
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/ThreadTools.h"
+
+#include <time.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace libfwbuilder
+{
+
+/**
+ * Results of DNS queries keyed by the name and address family. Each
+ * successful result expires after the TTL given when it was
+ * stored. Failed queries are remembered until clearErrors() is
+ * called, they are never written to the file. All methods are
+ * thread safe.
+ */
+class DNSCache
+{
+    class Entry
+    {
+        public:
+        std::list<InetAddr> addresses;
+        std::string         error;
+        time_t              expires;
+    };
+
+    std::map<std::pair<std::string, int>, Entry> entries;
+    Mutex mutex;
+
+    public:
+
+    DNSCache() {}
+
+    /**
+     * Returns true if the cache has a result for the name. If the
+     * query failed, error holds the error message and addresses is
+     * empty.
+     */
+    bool lookup(const std::string &name, int type,
+                std::list<InetAddr> &addresses, std::string &error);
+
+    void store(const std::string &name, int type,
+               const std::list<InetAddr> &addresses, unsigned int ttl);
+    void storeError(const std::string &name, int type,
+                    const std::string &error);
+
+    void clearErrors();
+    void clear();
+    int size();
+
+    /**
+     * Reads entries from the file, entries that have expired are
+     * skipped. Missing file is not an error.
+     */
+    void load(const std::string &file_name) throw(FWException);
+
+    /**
+     * Writes entries that have not expired yet to the file. The file
+     * is replaced atomically so that compilers running in parallel
+     * never read partially written file.
+     */
+    void save(const std::string &file_name) throw(FWException);
+};
+
+}
+
+#endif
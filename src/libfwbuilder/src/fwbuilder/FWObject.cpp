@@ -95,8 +95,9 @@ void FWObject::fromXML(xmlNodePtr root) throw(FWException)
 
     n = FROMXMLCAST(xmlGetProp(root, TOXMLCAST("keywords")));
     if (n != 0) {
-        keywords = stringToSet(n);
-        dbroot->keywords.insert(keywords.begin(), keywords.end());
+        keywords.edit() = stringToSet(n);
+        dbroot->keywords.edit().insert(keywords.get().begin(),
+                                       keywords.get().end());
         FREEXMLBUFF(n);
     }
 
@@ -172,12 +173,12 @@ xmlNodePtr FWObject::toXML(xmlNodePtr parent, bool process_children)
             STRTOXMLCAST(s_id));
     }
 
-    if (!keywords.empty()) {
+    if (!keywords.get().empty()) {
         xmlNewProp(me, TOXMLCAST("keywords"),
-                   STRTOXMLCAST(setToString(keywords)));
+                   STRTOXMLCAST(setToString(keywords.get())));
     }
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i) 
+    for(AttributeMap::const_iterator i=data.begin(); i!=data.end(); ++i) 
     {
         const string &name  = (*i).first;
         const string &value = (*i).second;
@@ -247,7 +248,7 @@ FWObject::~FWObject()
     busy = true;  // ignore read-only
     if (size() > 0) destroyChildren();
     data.clear();
-    private_data.clear();
+    private_data.reset();
 }
 
 void FWObject::init(FWObjectDatabase *root)
@@ -257,13 +258,14 @@ void FWObject::init(FWObjectDatabase *root)
 
 void FWObject::setPrivateData(const string &key, void *data)
 {
-    private_data[key] = data;
+    private_data.edit()[key] = data;
 }
 
 void* FWObject::getPrivateData(const string &key) const
 {
-    map<string, void*>::const_iterator it = private_data.find(key);
-    if(it == private_data.end())
+    const map<string, void*> &pd = private_data.get();
+    map<string, void*>::const_iterator it = pd.find(key);
+    if(it == pd.end())
         return NULL;
     else
         return it->second;
@@ -271,7 +273,7 @@ void* FWObject::getPrivateData(const string &key) const
 
 map<string, void*> &FWObject::getAllPrivateData()
 {
-    return private_data;
+    return private_data.edit();
 }
 
 void FWObject::updateNonStandardObjectReferences()
@@ -353,20 +355,10 @@ bool FWObject::cmp(const FWObject *obj, bool recursive) throw(FWException)
     if (getTypeName() != obj->getTypeName() || name != obj->name || comment != obj->comment || ro != obj->ro)
         return false;
 
-    if (data.size() != obj->data.size())
+    if (data != obj->data)
         return false;
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i) 
-    {
-        const string &name  = (*i).first;
-        const string &value = (*i).second;
-// 10/21/2008 --vk
-        map<string,string>::const_iterator j=obj->data.find(name);
-        if (j==obj->data.end()) return false;
-        if (j->second!=value) return false;
-    }
-
-    if (keywords.empty() != obj->keywords.empty() || keywords != obj->keywords)
+    if (keywords.get() != obj->keywords.get())
         return false;
 
     if (recursive)
@@ -473,10 +465,9 @@ FWObject& FWObject::shallowDuplicate(const FWObject *x, bool preserve_id)
     private_data = x->private_data;
 
     keywords = x->keywords;
-    set<string>::const_iterator iter;
-    for (iter = keywords.begin(); iter != keywords.end(); ++iter) {
-        dbroot->keywords.insert(*iter);
-    }
+    if (!keywords.get().empty())
+        dbroot->keywords.edit().insert(keywords.get().begin(),
+                                       keywords.get().end());
 
     setReadOnly(false);
 
@@ -638,7 +629,7 @@ bool FWObject::exists(const string &name) const
 
 const string &FWObject::getStr(const string &name) const
 {
-    map<string,string>::const_iterator i=data.find(name);
+    AttributeMap::const_iterator i=data.find(name);
     if (i==data.end())
         return NOT_FOUND;
     else
@@ -648,7 +639,7 @@ const string &FWObject::getStr(const string &name) const
 void FWObject::remStr(const string &name)
 {
     checkReadOnly();
-    map<string, string>::iterator m=data.find(name);
+    AttributeMap::iterator m=data.find(name);
     if(m != data.end()) 
     {
         data.erase(m);
@@ -659,10 +650,24 @@ void FWObject::remStr(const string &name)
 void FWObject::setStr(const string &name, const string &val)
 {
     if (name[0]!='.' && name != "folder") checkReadOnly();
-    string old_val = data[name];
+    AttributeMap::iterator it = data.find(name);
+    if (it == data.end())
+    {
+        // val may be a reference to another attribute of this
+        // object, returned by getStr(). Adding new attribute can move
+        // the values, copy it first
+        string new_val = val;
+        // new attribute starts out empty, so setting it to an empty
+        // string does not change the stored value
+        bool changed = !new_val.empty();
+        data[name].swap(new_val);
+        if (name[0]!='.' && changed) setDirty(true);
+        return;
+    }
+    string &old_val = it->second;
     if (old_val != val)
     {
-        data[name] = val;
+        old_val = val;
         // attribute with name that starts with "." is considered "hidden"
         // or "internal". Such attribute is not saved to the data file and
         // should not trigger "dirty" flag.
@@ -776,11 +781,11 @@ void FWObject::dump(std::ostream &f,bool recursive,bool brief,int offset) const
 	  << "  name=" << n << endl;
 	f << string(offset,' ') << "Root:   " << getRoot() << endl;
 
-	map<string, string>::const_iterator d;
+	AttributeMap::const_iterator d;
 	for (d=data.begin(); d!=data.end(); ++d)
         {
 	    f << string(offset,' ');
-	    f << (*d).first << ": " << (*d).second << endl;
+	    f << (*d).first.str() << ": " << (*d).second << endl;
 	}
 	if (recursive)
         {
@@ -1587,24 +1592,46 @@ FWObject::tree_iterator FWObject::tree_end()
  * the new one.
  */
 int FWObject::replaceRef(int old_id, int new_id)
+{
+    if (old_id == new_id) return 0;
+    map<int,int> map_ids;
+    map_ids[old_id] = new_id;
+    return replaceRefs(map_ids);
+}
+
+int FWObject::replaceRefs(const map<int,int> &map_ids)
 {
     int ref_replacement_counter = 0;
-    replaceReferenceInternal(old_id, new_id, ref_replacement_counter);
+    if (!map_ids.empty())
+        replaceReferencesInternal(map_ids, ref_replacement_counter);
     return ref_replacement_counter;
 }
 
-void FWObject::replaceReferenceInternal(int old_id, int new_id, int &counter)
+/*
+ * Looks up id in map_ids, returns true and sets new_id if it should
+ * be replaced. Used by replaceReferencesInternal() in this class and
+ * in the classes that keep references in attributes.
+ */
+bool FWObject::mapReferenceId(const map<int,int> &map_ids, int id, int &new_id)
 {
-    if (old_id == new_id) return;
+    map<int,int>::const_iterator it = map_ids.find(id);
+    if (it == map_ids.end() || it->second == id) return false;
+    new_id = it->second;
+    return true;
+}
 
+void FWObject::replaceReferencesInternal(const map<int,int> &map_ids,
+                                         int &counter)
+{
     FWReference *ref = FWReference::cast(this);
     if (ref==NULL)
     {
         for (FWObject::iterator j1=begin(); j1!=end(); ++j1)
-            (*j1)->replaceReferenceInternal(old_id, new_id, counter);
+            (*j1)->replaceReferencesInternal(map_ids, counter);
     } else
     { 
-        if (ref->getPointerId()==old_id)
+        int new_id;
+        if (mapReferenceId(map_ids, ref->getPointerId(), new_id))
         {
             ref->setPointerId(new_id);
             counter++;
@@ -1651,23 +1678,25 @@ bool FWObject::isPrimaryObject() const { return false; }
 
 const set<string> &FWObject::getAllKeywords()
 {
-    return dbroot->keywords;
+    return dbroot->keywords.get();
 }
 
 void FWObject::addKeyword(const string &keyword)
 {
-    keywords.insert(keyword);
-    dbroot->keywords.insert(keyword);
+    keywords.edit().insert(keyword);
+    dbroot->keywords.edit().insert(keyword);
 }
 
 void FWObject::removeKeyword(const string &keyword)
 {
-    keywords.erase(keyword);
+    if (keywords.get().empty()) return;
+    keywords.edit().erase(keyword);
+    if (keywords.get().empty()) keywords.reset();
 }
 
 void FWObject::clearKeywords()
 {
-    keywords.clear();
+    keywords.reset();
 }
 
 FWObjectNameCmpPredicate::FWObjectNameCmpPredicate(bool follow_refs)
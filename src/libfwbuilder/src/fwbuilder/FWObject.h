@@ -43,7 +43,10 @@
 #include <fstream>
 #include <cstdlib>
 
+#include "fwbuilder/AllocatedOnDemand.h"
+#include "fwbuilder/AttributeMap.h"
 #include "fwbuilder/FWException.h"
+#include "fwbuilder/InternedString.h"
 #include "fwbuilder/ObjectMatcher.h"
 #include "fwbuilder/Dispatch.h"
 
@@ -121,18 +124,18 @@ private:
     static std::string NOT_FOUND;
 
     time_t creation_time;
-    std::set<std::string> keywords;
+    AllocatedOnDemand<std::set<std::string> > keywords;
 
     static std::string dataDir;
 
 protected:
 
-    std::string xml_name;
+    InternedString xml_name;
     bool busy;
     bool dirty;
     
-    std::map<std::string, std::string> data;
-    std::map<std::string, void*> private_data;
+    AttributeMap data;
+    AllocatedOnDemand<std::map<std::string, void*> > private_data;
 
     void clearRefCounter() { ref_counter=0; }
 
@@ -145,7 +148,10 @@ protected:
 
     void setRO(bool f) { ro = f; }
 
-    virtual void replaceReferenceInternal(int oldfw_id, int newfw_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &map_ids,
+                                           int &counter);
+    static bool mapReferenceId(const std::map<int,int> &map_ids,
+                               int id, int &new_id);
 
     /**
      * Finds direct child of this object with given name.
@@ -305,6 +311,11 @@ public:
 
     void remStr(const std::string &name);
 
+    /**
+     * returned reference is valid until an attribute is added to or
+     * removed from the object. setStr() accepts values returned by
+     * getStr() of the same object.
+     */
     const std::string &getStr(const std::string& name) const;
     void setStr(const std::string &name, const std::string &val);
 
@@ -535,6 +546,15 @@ public:
      */
     virtual int replaceRef(int oldfw_id, int newfw_id);
 
+    /**
+     * replace IDs of all references in the tree rooted at this
+     * object according to map_ids which maps old IDs to the new
+     * ones. Walks the tree once, each reference is changed at most
+     * once, that is mapping is not applied to the IDs it produces.
+     * Returns the number of replaced references.
+     */
+    int replaceRefs(const std::map<int,int> &map_ids);
+
     /**
      * recursively find all FWReference objects that are children of
      * this and generate list of pointers to the objects these
@@ -566,12 +586,12 @@ public:
     virtual bool isPrimaryObject() const;
 
     // Attributes iterator
-    std::map<std::string, std::string>::const_iterator dataBegin()
+    AttributeMap::const_iterator dataBegin() const
     { return data.begin(); }
-    std::map<std::string, std::string>::const_iterator dataEnd()
+    AttributeMap::const_iterator dataEnd() const
     { return data.end();   }
 
-    const std::set<std::string> &getKeywords() { return keywords; }
+    const std::set<std::string> &getKeywords() { return keywords.get(); }
     const std::set<std::string> &getAllKeywords();
     void addKeyword(const std::string &keyword);
     void removeKeyword(const std::string &keyword);
@@ -507,11 +507,14 @@ FWObject* FWObjectDatabase::recursivelyCopySubtree(FWObject *target,
     fixReferences(nobj, id_map);
 
     // one more pass to fix references in other firewalls and groups
-    // we might have copied.
+    // we might have copied. Those inside of nobj have been fixed
+    // already.
     for (map<int,int>::const_iterator i=id_map.begin(); i!=id_map.end(); ++i)
     {
         int new_id = i->second;   // new id
         FWObject *new_obj = findInIndex(new_id);
+        if (new_obj == NULL || new_obj == nobj || new_obj->isChildOf(nobj))
+            continue;
         if (Firewall::cast(new_obj) || Group::cast(new_obj))
             fixReferences(new_obj, id_map);
 
@@ -523,13 +526,12 @@ FWObject* FWObjectDatabase::recursivelyCopySubtree(FWObject *target,
 /*
  * fix references in children of obj according to the map_ids which
  * maps old IDs to the new ones. Return the number of fixed references.
+ * This walks the tree once and looks up ID of each reference in
+ * map_ids rather than walking it for every pair of IDs.
  */
 int FWObjectDatabase::fixReferences(FWObject *obj, const map<int,int> &map_ids)
 {
-    int total_counter = 0;
-    for (map<int,int>::const_iterator it=map_ids.begin(); it!=map_ids.end(); ++it)
-        total_counter += obj->replaceRef(it->first, it->second);
-    return total_counter;
+    return obj->replaceRefs(map_ids);
 }
 
 FWObject* FWObjectDatabase::_recursively_copy_subtree(
@@ -588,9 +590,10 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
             FWObject *n_ptr_obj = NULL;
 
             // check if we have seen old_ptr_obj already.
-            if (id_map.count(old_ptr_obj->getId()) > 0)
+            map<int,int>::iterator seen = id_map.find(old_ptr_obj->getId());
+            if (seen != id_map.end())
             {
-                n_ptr_obj = findInIndex(id_map[old_ptr_obj->getId()]);
+                n_ptr_obj = findInIndex(seen->second);
                 nobj->addRef(n_ptr_obj);
                 continue;
             }
@@ -659,9 +662,12 @@ void FWObjectDatabase::_copy_foreign_obj_aux(
         // Copy of obj is either new_parent, or one of its
         // children. In the process of making this copy,
         // its ID should have been added to id_map.
-        assert(id_map.count(source->getId()) > 0);
+        map<int,int>::iterator copy = id_map.find(source->getId());
+        assert(copy != id_map.end());
 
-        FWObject *n_ptr_obj = new_parent->getById(id_map[source->getId()], true);
+        // use index rather than search in the tree under new_parent,
+        // which can be a firewall with lots of rules
+        FWObject *n_ptr_obj = findInIndex(copy->second);
         target->addRef(n_ptr_obj);
     }
 
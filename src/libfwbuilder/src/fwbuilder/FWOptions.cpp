@@ -78,7 +78,7 @@ xmlNodePtr FWOptions::toXML(xmlNodePtr root) throw(FWException)
         xml_name.empty() ? STRTOXMLCAST(getTypeName()) : STRTOXMLCAST(xml_name),
         NULL);
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i)
+    for(AttributeMap::const_iterator i=data.begin(); i!=data.end(); ++i)
     {
         const string &name  = (*i).first;
         const string &value = (*i).second;
@@ -317,13 +317,7 @@ FWObject& Firewall::duplicate(const FWObject *obj,
     addCopyOf(o,preserve_id);
 
     // replace references to old objects in rules
-    map<int, int>::iterator it;
-    for (it=id_mapping_for_duplicate.begin(); it!=id_mapping_for_duplicate.end(); ++it)
-    {
-        int old_id = it->first;
-        int new_id = it->second;
-        replaceRef(old_id,  new_id);
-    }
+    replaceRefs(id_mapping_for_duplicate);
 
     setDirty(true);
     if (xro)  setReadOnly(true);
@@ -29,6 +29,7 @@
 
 
 #include "fwbuilder/InetAddrMask.h"
+#include "fwbuilder/InetAddrValue.h"
 
 #include <stdio.h>
 #include <iostream>
@@ -236,10 +237,70 @@ vector<InetAddrMask> libfwbuilder::convertAddressRange(const InetAddr &start,
 
 
 
+/*
+ * The same algorithm as _convert_range_to_networks below, for IPv4
+ * only. Produces the same networks in the same order but works with
+ * plain 32 bit numbers and does not recurse. Each step takes the
+ * largest network that starts at the start of the remainder of the
+ * range and fits in it.
+ */
+static void _convert_ipv4_range_to_networks(const InetAddr &start_addr,
+                                            const InetAddr &end_addr,
+                                            vector<InetAddrMask> &res)
+{
+    InetAddrValue start(start_addr);
+    InetAddrValue end(end_addr);
+    InetAddr host_mask(InetAddr::getAllOnes(AF_INET));
+
+    while (true)
+    {
+        if (end < start) return;
+        if (start == end)
+        {
+            res.push_back(InetAddrMask(start.toInetAddr(), host_mask));
+            return;
+        }
+
+        if (start.lo == 0 && end.lo == 0xffffffff)
+        {
+            res.push_back(InetAddrMask());
+            return;
+        }
+
+        uint32_t size = uint32_t(end.lo - start.lo) + 1;
+
+        if (size == 2)
+        {
+            res.push_back(InetAddrMask(start.toInetAddr(), host_mask));
+            res.push_back(InetAddrMask(end.toInetAddr(), host_mask));
+            return;
+        }
+
+        int host_bits = 0;
+        while ((size >> host_bits) > 1) host_bits++;
+        while (host_bits > 0 && (start.lo & ((uint64_t(1) << host_bits) - 1)))
+            host_bits--;
+
+        InetAddrValue netmask = InetAddrValue::netmask(AF_INET, 32 - host_bits);
+        InetAddrValue nend = start | ~netmask;
+
+        res.push_back(InetAddrMask(start.toInetAddr(), netmask.toInetAddr()));
+
+        if (nend == end) return;
+        start = nend.next();
+    }
+}
+
 bool libfwbuilder::_convert_range_to_networks(const InetAddr &start,
                                               const InetAddr &end,
                                               vector<InetAddrMask> &res)
 {
+    if (start.isV4() && end.isV4())
+    {
+        _convert_ipv4_range_to_networks(start, end, res);
+        return false;
+    }
+
     if (end < start) return false;
     if (start == end)
     {
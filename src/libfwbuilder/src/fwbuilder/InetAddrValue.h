@@ -0,0 +1,232 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __INETADDRVALUE_HH_FLAG__
+#define __INETADDRVALUE_HH_FLAG__
+
+#include "fwbuilder/InetAddr.h"
+
+#include <stdint.h>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Compact value type for IPv4 and IPv6 addresses, used where
+ * addresses are compared many times such as rule shadowing checks,
+ * object matching and address range expansion.
+ *
+ * Unlike InetAddr this class has no virtual methods and keeps the
+ * address only once, as a 128 bit number in host byte order split in
+ * two 64 bit words. IPv4 address is stored in the lower 32 bits of
+ * lo. Objects are trivially copyable, comparison operators do not
+ * convert addresses and do not branch. Addresses of different
+ * address families are never equal and neither is less than the
+ * other, same as with InetAddr.
+ */
+class InetAddrValue
+{
+public:
+
+    uint64_t hi;
+    uint64_t lo;
+    int af;
+
+    InetAddrValue() : hi(0), lo(0), af(AF_INET) {}
+
+    InetAddrValue(int _af, uint64_t _hi, uint64_t _lo) :
+        hi(_hi), lo(_lo), af(_af) {}
+
+    explicit InetAddrValue(const InetAddr &a)
+    {
+        af = a.addressFamily();
+        if (af == AF_INET)
+        {
+            hi = 0;
+            lo = ntohl(a.getV4()->s_addr);
+        } else
+        {
+            const uint32_t *w = (const uint32_t*)(a.getV6());
+            hi = (uint64_t(ntohl(w[0])) << 32) | ntohl(w[1]);
+            lo = (uint64_t(ntohl(w[2])) << 32) | ntohl(w[3]);
+        }
+    }
+
+    InetAddr toInetAddr() const
+    {
+        if (af == AF_INET)
+        {
+            struct in_addr a;
+            a.s_addr = htonl(uint32_t(lo));
+            return InetAddr(&a);
+        }
+        struct in6_addr a6;
+        uint32_t *w = (uint32_t*)(&a6);
+        w[0] = htonl(uint32_t(hi >> 32));
+        w[1] = htonl(uint32_t(hi));
+        w[2] = htonl(uint32_t(lo >> 32));
+        w[3] = htonl(uint32_t(lo));
+        return InetAddr(&a6);
+    }
+
+    /**
+     * bits of hi and lo used by addresses of the address family
+     */
+    static inline uint64_t hiMask(int af)
+    {
+        return uint64_t(0) - uint64_t(af != AF_INET);
+    }
+
+    static inline uint64_t loMask(int af)
+    {
+        return uint64_t(0xffffffff) | hiMask(af);
+    }
+
+    inline int addressLengthBits() const { return (af == AF_INET) ? 32 : 128; }
+
+    /**
+     * creates netmask with @length bits set
+     */
+    static InetAddrValue netmask(int af, int length)
+    {
+        int host_bits = ((af == AF_INET) ? 32 : 128) - length;
+        uint64_t host_hi = 0;
+        uint64_t host_lo = 0;
+        if (host_bits >= 128)
+        {
+            host_hi = ~uint64_t(0);
+            host_lo = ~uint64_t(0);
+        } else if (host_bits >= 64)
+        {
+            host_hi = (uint64_t(1) << (host_bits - 64)) - 1;
+            host_lo = ~uint64_t(0);
+        } else if (host_bits > 0)
+            host_lo = (uint64_t(1) << host_bits) - 1;
+
+        return InetAddrValue(af, ~host_hi & hiMask(af), ~host_lo & loMask(af));
+    }
+
+    inline InetAddrValue operator&(const InetAddrValue &o) const
+    {
+        return InetAddrValue(af, hi & o.hi, lo & o.lo);
+    }
+
+    inline InetAddrValue operator|(const InetAddrValue &o) const
+    {
+        return InetAddrValue(af, hi | o.hi, lo | o.lo);
+    }
+
+    inline InetAddrValue operator~() const
+    {
+        return InetAddrValue(af, ~hi & hiMask(af), ~lo & loMask(af));
+    }
+
+    /**
+     * next and previous address, wrap around at the end of the
+     * address space of the address family
+     */
+    inline InetAddrValue next() const
+    {
+        uint64_t nlo = (lo + 1) & loMask(af);
+        return InetAddrValue(af, hi + uint64_t(nlo == 0 && af != AF_INET), nlo);
+    }
+
+    inline InetAddrValue prev() const
+    {
+        uint64_t nlo = (lo - 1) & loMask(af);
+        return InetAddrValue(af, hi - uint64_t(lo == 0 && af != AF_INET), nlo);
+    }
+
+    inline friend bool operator==(const InetAddrValue &a,
+                                  const InetAddrValue &b)
+    {
+        return ((a.hi ^ b.hi) | (a.lo ^ b.lo) | uint64_t(a.af ^ b.af)) == 0;
+    }
+
+    inline friend bool operator!=(const InetAddrValue &a,
+                                  const InetAddrValue &b)
+    {
+        return !(a == b);
+    }
+
+    inline friend bool operator<(const InetAddrValue &a,
+                                 const InetAddrValue &b)
+    {
+        return (a.af == b.af) &
+            ((a.hi < b.hi) | ((a.hi == b.hi) & (a.lo < b.lo)));
+    }
+
+    inline friend bool operator<=(const InetAddrValue &a,
+                                  const InetAddrValue &b)
+    {
+        return (a.af == b.af) &
+            ((a.hi < b.hi) | ((a.hi == b.hi) & (a.lo <= b.lo)));
+    }
+};
+
+/**
+ * Inclusive range of addresses [first, last] of the same address
+ * family. Represents networks as well as address ranges.
+ */
+class InetRangeValue
+{
+public:
+
+    InetAddrValue first;
+    InetAddrValue last;
+
+    InetRangeValue() {}
+
+    InetRangeValue(const InetAddrValue &f, const InetAddrValue &l) :
+        first(f), last(l) {}
+
+    /**
+     * network and broadcast addresses of the subnet defined by
+     * address and netmask, the same as InetAddrMask(addr, netmask)
+     * calculates. This includes special case of IPv4 netmasks /31 and
+     * /32 that have no directed broadcast address (see #2670)
+     */
+    static InetRangeValue fromSubnet(const InetAddrValue &addr,
+                                     const InetAddrValue &netmask)
+    {
+        InetAddrValue network = addr & netmask;
+        if (netmask.af == AF_INET && (netmask.lo | 1) == 0xffffffff)
+            return InetRangeValue(network, InetAddrValue(AF_INET, 0, 0xffffffff));
+        return InetRangeValue(network, network | ~netmask);
+    }
+
+    inline bool contains(const InetAddrValue &a) const
+    {
+        return (first <= a) & (a <= last);
+    }
+
+    inline bool contains(const InetRangeValue &r) const
+    {
+        return (first <= r.first) & (r.last <= last);
+    }
+};
+
+}
+
+#endif
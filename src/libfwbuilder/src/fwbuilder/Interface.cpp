@@ -500,17 +500,17 @@ bool Interface::isFailoverInterface() const
     return getFirstByType(FailoverClusterGroup::TYPENAME) != NULL;
 }
 
-void Interface::replaceReferenceInternal(int old_id, int new_id, int &counter)
+void Interface::replaceReferencesInternal(const map<int,int> &map_ids,
+                                          int &counter)
 {
-    if (old_id == new_id) return;
-
-    FWObject::replaceReferenceInternal(old_id, new_id, counter);
+    FWObject::replaceReferencesInternal(map_ids, counter);
 
     string nzid = getStr("network_zone");
     if (!nzid.empty())
     {
         int nzid_int = FWObjectDatabase::getIntId(nzid);
-        if (nzid_int == old_id)
+        int new_id;
+        if (mapReferenceId(map_ids, nzid_int, new_id))
         {
             setStr("network_zone", FWObjectDatabase::getStringId(new_id));
             counter++;
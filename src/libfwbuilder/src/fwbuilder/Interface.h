@@ -67,7 +67,8 @@ private:
 
 protected:
 
-    virtual void replaceReferenceInternal(int oldfw_id, int newfw_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &map_ids,
+                                           int &counter);
         
 public:
     
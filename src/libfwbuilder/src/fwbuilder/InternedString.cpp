@@ -0,0 +1,75 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/InternedString.h"
+#include "fwbuilder/ThreadTools.h"
+
+#include <set>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+/*
+ * Interned strings are created by static objects of other modules,
+ * so the pool is created on first use. std::set never moves its
+ * elements, pointers to them stay valid.
+ */
+static set<string>& pool()
+{
+    static set<string> *strings = new set<string>();
+    return *strings;
+}
+
+static Mutex& poolMutex()
+{
+    static Mutex *mutex = new Mutex();
+    return *mutex;
+}
+
+const string* InternedString::intern(const string &s)
+{
+    Mutex &mutex = poolMutex();
+    mutex.lock();
+    const string *res = &(*(pool().insert(s).first));
+    mutex.unlock();
+    return res;
+}
+
+InternedString::InternedString()
+{
+    static const string *empty_string = intern("");
+    pooled = empty_string;
+}
+
+int InternedString::poolSize()
+{
+    Mutex &mutex = poolMutex();
+    mutex.lock();
+    int res = pool().size();
+    mutex.unlock();
+    return res;
+}
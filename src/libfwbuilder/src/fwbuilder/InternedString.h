@@ -0,0 +1,79 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __INTERNEDSTRING_HH_FLAG__
+#define __INTERNEDSTRING_HH_FLAG__
+
+#include <string>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * String stored once in a process-wide pool. Copies of InternedString
+ * share the same pooled std::string, the object itself is just a
+ * pointer. Used for strings that repeat in many objects: names of
+ * attributes and XML element names. Pooled strings are never freed.
+ *
+ * Two interned strings are equal if and only if they point to the
+ * same pooled string. Ordering compares string contents so that
+ * containers keyed by interned strings iterate in the same order as
+ * containers keyed by std::string.
+ */
+class InternedString
+{
+    const std::string *pooled;
+
+    static const std::string* intern(const std::string &s);
+
+public:
+
+    InternedString();
+    InternedString(const std::string &s) : pooled(intern(s)) {}
+    InternedString(const char *s) : pooled(intern(std::string(s))) {}
+
+    const std::string& str() const { return *pooled; }
+    operator const std::string&() const { return *pooled; }
+
+    const char* c_str() const { return pooled->c_str(); }
+    bool empty() const { return pooled->empty(); }
+    std::string::size_type size() const { return pooled->size(); }
+    char operator[](std::string::size_type n) const { return (*pooled)[n]; }
+
+    bool operator==(const InternedString &o) const
+    { return pooled == o.pooled; }
+    bool operator!=(const InternedString &o) const
+    { return pooled != o.pooled; }
+    bool operator<(const InternedString &o) const
+    { return pooled != o.pooled && *pooled < *o.pooled; }
+
+    /**
+     * number of distinct strings in the pool
+     */
+    static int poolSize();
+};
+
+}
+
+#endif
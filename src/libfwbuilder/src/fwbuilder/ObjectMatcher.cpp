@@ -47,6 +47,7 @@
 #include "fwbuilder/ObjectMatcher.h"
 
 #include "fwbuilder/InetAddr.h"
+#include "fwbuilder/InetAddrValue.h"
 #include "fwbuilder/InetAddrMask.h"
 #include "fwbuilder/AddressRange.h"
 #include "fwbuilder/RuleElement.h"
@@ -99,6 +100,14 @@ bool ObjectMatcher::complexMatch(Address *obj1, Address *obj2)
     return (res != NULL);
 }
 
+static inline int compareAddresses(const InetAddrValue &a,
+                                   const InetAddrValue &b)
+{
+    if (a == b) return 0;
+    if (a < b) return -1;
+    return 1;
+}
+
 /**
  * Compare single InetAddr to an address defined by Address
  * object. The right hand side Address object should be a "primary"
@@ -131,9 +140,11 @@ int ObjectMatcher::matchRHS(const InetAddr *inet_addr_obj, Address *rhs_obj)
  * broadcast packets (sent to 192.168.1.1255 for the same net)
  *
  */
-            InetAddrMask n(*addr, *netm);
-            int f1 = matchInetAddrRHS(inet_addr_obj, n.getNetworkAddressPtr());
-            int f2 = matchInetAddrRHS(inet_addr_obj, n.getBroadcastAddressPtr());
+            InetAddrValue a(*inet_addr_obj);
+            InetRangeValue n = InetRangeValue::fromSubnet(InetAddrValue(*addr),
+                                                          InetAddrValue(*netm));
+            int f1 = compareAddresses(a, n.first);
+            int f2 = compareAddresses(a, n.last);
             if (f1 == 0 || f2 == 0) return 0;
             if (f2 > 0) return 1;
         }
@@ -151,9 +162,8 @@ int ObjectMatcher::matchRHS(const InetAddr *inet_addr_obj, Address *rhs_obj)
 int ObjectMatcher::matchInetAddrRHS(const InetAddr *inet_addr_obj,
                                     const InetAddr *rhs_obj_addr)
 {
-    if ((*inet_addr_obj) == (*rhs_obj_addr)) return 0;
-    if ((*inet_addr_obj) < (*rhs_obj_addr)) return -1;
-    return 1;
+    return compareAddresses(InetAddrValue(*inet_addr_obj),
+                            InetAddrValue(*rhs_obj_addr));
 }
 
 /**
@@ -162,14 +172,19 @@ int ObjectMatcher::matchInetAddrRHS(const InetAddr *inet_addr_obj,
  *  0 if inet address belongs to the subnet,
  * -1 if inet address is less than the beginning of the subnet
  *  1 if inet address is greater than the end of the subnet
+ *
+ * Network and broadcast addresses are calculated the same way
+ * InetAddrMask does it, but without creating InetAddrMask object.
  */
 int ObjectMatcher::matchSubnetRHS(const InetAddr *inet_addr_obj,
                                   const InetAddr *rhs_obj_addr,
                                   const InetAddr *rhs_obj_netm)
 {
-    InetAddrMask n(*rhs_obj_addr, *rhs_obj_netm);
-    int f1 = matchInetAddrRHS(inet_addr_obj, n.getNetworkAddressPtr());
-    int f2 = matchInetAddrRHS(inet_addr_obj, n.getBroadcastAddressPtr());
+    InetAddrValue a(*inet_addr_obj);
+    InetRangeValue n = InetRangeValue::fromSubnet(InetAddrValue(*rhs_obj_addr),
+                                                  InetAddrValue(*rhs_obj_netm));
+    int f1 = compareAddresses(a, n.first);
+    int f2 = compareAddresses(a, n.last);
     if (f1 >= 0 && f2 <= 0) return 0;
     if (f1 < 0) return -1;
     if (f2 > 0) return 1;
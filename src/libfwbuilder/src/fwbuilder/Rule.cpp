@@ -96,6 +96,7 @@ FWObject& Rule::shallowDuplicate(const FWObject *x,
     unique_id = rx->unique_id;
     abs_rule_number = rx->abs_rule_number;
     compiler_message = rx->compiler_message;
+    annotations = rx->annotations;
     return  FWObject::shallowDuplicate(x,preserve_id);
 }
 
@@ -105,7 +106,8 @@ bool Rule::cmp(const FWObject *x, bool recursive) throw(FWException)
     if (fallback != rx->fallback ||
         hidden != rx->hidden ||
         label != rx->label ||
-        unique_id != rx->unique_id) return false;
+        unique_id != rx->unique_id ||
+        annotations != rx->annotations) return false;
 
     return  FWObject::cmp(x, recursive);
 }
@@ -628,17 +630,17 @@ void PolicyRule::removeRef(FWObject *obj)
     FWObject::removeRef(obj);
 }
 
-void PolicyRule::replaceReferenceInternal(int old_id, int new_id, int &counter)
+void PolicyRule::replaceReferencesInternal(const map<int,int> &map_ids,
+                                           int &counter)
 {
-    if (old_id == new_id) return;
-
-    FWObject::replaceReferenceInternal(old_id, new_id, counter);
+    FWObject::replaceReferencesInternal(map_ids, counter);
 
     string branch_id = getOptionsObject()->getStr("branch_id");
     if (!branch_id.empty())
     {
         int branch_id_int = FWObjectDatabase::getIntId(branch_id);
-        if (branch_id_int == old_id)
+        int new_id;
+        if (mapReferenceId(map_ids, branch_id_int, new_id))
         {
             getOptionsObject()->setStr("branch_id",
                                        FWObjectDatabase::getStringId(new_id));
@@ -31,6 +31,7 @@
 #define __RULE_HH_FLAG__
 
 #include "fwbuilder/Group.h"
+#include "fwbuilder/RuleAnnotation.h"
 
 namespace libfwbuilder
 {
@@ -67,6 +68,10 @@ class Rule : public Group
     /* compilers store warnings and errors associated with this rule here.
      */
     std::string compiler_message;
+
+    /* typed state rule processors attach to the rule, see RuleAnnotationKey
+     */
+    RuleAnnotations annotations;
     
     public:
 
@@ -110,6 +115,41 @@ class Rule : public Group
     int  getAbsRuleNumber() const { return abs_rule_number; }
     void setAbsRuleNumber(int rn) { abs_rule_number=rn; }
 
+    /*
+     * Accessors for annotations. These overload accessors for string
+     * attributes FWObject provides, rule processors use
+     * getStr(ipt_chain) where key ipt_chain is registered instead of
+     * getStr("ipt_chain").
+     */
+    using FWObject::getStr;
+    using FWObject::setStr;
+    using FWObject::getInt;
+    using FWObject::setInt;
+    using FWObject::getBool;
+    using FWObject::setBool;
+
+    const std::string& getStr(const RuleAnnotationKey &key) const
+    { return annotations.getStr(key); }
+    void setStr(const RuleAnnotationKey &key, const std::string &val)
+    { annotations.setStr(key, val); }
+
+    int getInt(const RuleAnnotationKey &key) const
+    { return annotations.getInt(key); }
+    void setInt(const RuleAnnotationKey &key, int val)
+    { annotations.setInt(key, val); }
+
+    bool getBool(const RuleAnnotationKey &key) const
+    { return annotations.getBool(key); }
+    void setBool(const RuleAnnotationKey &key, bool val)
+    { annotations.setBool(key, val); }
+
+    void* getPtr(const RuleAnnotationKey &key) const
+    { return annotations.getPtr(key); }
+    void setPtr(const RuleAnnotationKey &key, void *val)
+    { annotations.setPtr(key, val); }
+
+    const RuleAnnotations& getAnnotations() const { return annotations; }
+
     virtual bool isEmpty();
     virtual bool isDummyRule();
 
@@ -246,7 +286,8 @@ public:
      * these references point to. This overloaded method also replaces
      * references to branch rulesets.
      */
-    virtual void replaceReferenceInternal(int old_id, int new_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &map_ids,
+                                           int &counter);
 
     libfwbuilder::RuleElementSrc*  getSrc() ;
     libfwbuilder::RuleElementDst*  getDst() ;
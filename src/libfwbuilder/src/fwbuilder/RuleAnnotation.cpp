@@ -0,0 +1,214 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/RuleAnnotation.h"
+
+#include <assert.h>
+
+#include <map>
+#include <sstream>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+/*
+ * Bool and Int values are stored in the same vector and share slot
+ * numbers.
+ */
+enum { INT_STORAGE, STRING_STORAGE, POINTER_STORAGE, NUM_STORAGES };
+
+static int storageOf(RuleAnnotationKey::Type type)
+{
+    switch (type)
+    {
+    case RuleAnnotationKey::Bool:
+    case RuleAnnotationKey::Int:    return INT_STORAGE;
+    case RuleAnnotationKey::String: return STRING_STORAGE;
+    default:                        return POINTER_STORAGE;
+    }
+}
+
+/*
+ * Keys are static objects that may be created before any other static
+ * object of this module, so the registry is created on first use.
+ */
+class RuleAnnotationRegistry
+{
+public:
+    map<string, const RuleAnnotationKey*> by_name;
+    vector<const RuleAnnotationKey*> by_slot[NUM_STORAGES];
+};
+
+static RuleAnnotationRegistry& registry()
+{
+    static RuleAnnotationRegistry r;
+    return r;
+}
+
+RuleAnnotationKey::RuleAnnotationKey(const string &_name, Type _type) :
+    name(_name), type(_type)
+{
+    RuleAnnotationRegistry &reg = registry();
+    assert(reg.by_name.count(name) == 0);
+    vector<const RuleAnnotationKey*> &slots = reg.by_slot[storageOf(type)];
+    slot = slots.size();
+    slots.push_back(this);
+    reg.by_name[name] = this;
+}
+
+const RuleAnnotationKey* RuleAnnotationKey::find(const string &name)
+{
+    RuleAnnotationRegistry &reg = registry();
+    map<string, const RuleAnnotationKey*>::iterator it = reg.by_name.find(name);
+    if (it == reg.by_name.end()) return NULL;
+    return it->second;
+}
+
+/*
+ * Vectors grow only when a value is set, slots past the end hold
+ * default values. The value can be a reference to an element of the
+ * same vector (annotation copied from one key to another), so it is
+ * copied before the vector is resized.
+ */
+template <class T> static inline T getSlot(const vector<T> &v, int slot,
+                                           const T &default_value)
+{
+    return (slot < int(v.size())) ? v[slot] : default_value;
+}
+
+template <class T> static inline void setSlot(vector<T> &v, int slot,
+                                              const T &val,
+                                              const T &default_value)
+{
+    if (slot >= int(v.size()))
+    {
+        if (val == default_value) return;
+        T copy = val;
+        v.resize(slot + 1, default_value);
+        v[slot] = copy;
+        return;
+    }
+    v[slot] = val;
+}
+
+template <class T> static bool sameSlots(const vector<T> &v1,
+                                         const vector<T> &v2,
+                                         const T &default_value)
+{
+    unsigned int n = (v1.size() > v2.size()) ? v1.size() : v2.size();
+    for (unsigned int i=0; i<n; ++i)
+    {
+        if (getSlot(v1, i, default_value) != getSlot(v2, i, default_value))
+            return false;
+    }
+    return true;
+}
+
+bool RuleAnnotations::getBool(const RuleAnnotationKey &key) const
+{
+    assert(key.getType() == RuleAnnotationKey::Bool);
+    return getSlot(ints, key.getSlot(), 0) != 0;
+}
+
+void RuleAnnotations::setBool(const RuleAnnotationKey &key, bool val)
+{
+    assert(key.getType() == RuleAnnotationKey::Bool);
+    setSlot(ints, key.getSlot(), int(val), 0);
+}
+
+int RuleAnnotations::getInt(const RuleAnnotationKey &key) const
+{
+    assert(key.getType() == RuleAnnotationKey::Int);
+    return getSlot(ints, key.getSlot(), 0);
+}
+
+void RuleAnnotations::setInt(const RuleAnnotationKey &key, int val)
+{
+    assert(key.getType() == RuleAnnotationKey::Int);
+    setSlot(ints, key.getSlot(), val, 0);
+}
+
+const string& RuleAnnotations::getStr(const RuleAnnotationKey &key) const
+{
+    static const string empty_string;
+    assert(key.getType() == RuleAnnotationKey::String);
+    if (key.getSlot() < int(strings.size())) return strings[key.getSlot()];
+    return empty_string;
+}
+
+void RuleAnnotations::setStr(const RuleAnnotationKey &key, const string &val)
+{
+    assert(key.getType() == RuleAnnotationKey::String);
+    setSlot(strings, key.getSlot(), val, string());
+}
+
+void* RuleAnnotations::getPtr(const RuleAnnotationKey &key) const
+{
+    assert(key.getType() == RuleAnnotationKey::Pointer);
+    return getSlot(pointers, key.getSlot(), (void*)NULL);
+}
+
+void RuleAnnotations::setPtr(const RuleAnnotationKey &key, void *val)
+{
+    assert(key.getType() == RuleAnnotationKey::Pointer);
+    setSlot(pointers, key.getSlot(), val, (void*)NULL);
+}
+
+bool RuleAnnotations::operator==(const RuleAnnotations &other) const
+{
+    return (sameSlots(ints, other.ints, 0) &&
+            sameSlots(strings, other.strings, string()) &&
+            sameSlots(pointers, other.pointers, (void*)NULL));
+}
+
+string RuleAnnotations::toString() const
+{
+    RuleAnnotationRegistry &reg = registry();
+    ostringstream str;
+    for (unsigned int i=0; i<ints.size(); ++i)
+    {
+        if (ints[i] == 0) continue;
+        const RuleAnnotationKey *key = reg.by_slot[INT_STORAGE][i];
+        str << key->getName() << "=";
+        if (key->getType() == RuleAnnotationKey::Bool) str << "True";
+        else str << ints[i];
+        str << " ";
+    }
+    for (unsigned int i=0; i<strings.size(); ++i)
+    {
+        if (strings[i].empty()) continue;
+        str << reg.by_slot[STRING_STORAGE][i]->getName() << "="
+            << strings[i] << " ";
+    }
+    for (unsigned int i=0; i<pointers.size(); ++i)
+    {
+        if (pointers[i] == NULL) continue;
+        str << reg.by_slot[POINTER_STORAGE][i]->getName() << "="
+            << pointers[i] << " ";
+    }
+    return str.str();
+}
@@ -0,0 +1,116 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __RULEANNOTATION_HH_FLAG__
+#define __RULEANNOTATION_HH_FLAG__
+
+#include <string>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Key of a typed annotation that rule processors attach to rules to
+ * pass compiler-private state to each other (chain and target of an
+ * iptables rule, a flag that tells pf compiler to skip the check for
+ * duplicates and so on).
+ *
+ * Keys are created once, as static objects, and register themselves
+ * by name. Each key gets a fixed slot in the storage for values of
+ * its type, so reading or writing an annotation is an index into a
+ * vector rather than lookup in the string map FWObject uses for its
+ * attributes, and int and bool values are stored as such rather than
+ * converted to and from strings.
+ *
+ * Annotations are not saved in the data file. Rule::shallowDuplicate
+ * copies them and Rule::cmp compares them, the same as it does with
+ * the attributes they replace.
+ */
+class RuleAnnotationKey
+{
+public:
+
+    typedef enum { Bool, Int, String, Pointer } Type;
+
+    RuleAnnotationKey(const std::string &name, Type type);
+
+    const std::string& getName() const { return name; }
+    Type getType() const { return type; }
+    int getSlot() const { return slot; }
+
+    /**
+     * returns key registered with given name or NULL
+     */
+    static const RuleAnnotationKey* find(const std::string &name);
+
+private:
+
+    std::string name;
+    Type type;
+    int slot;
+
+    RuleAnnotationKey(const RuleAnnotationKey&);
+    RuleAnnotationKey& operator=(const RuleAnnotationKey&);
+};
+
+/**
+ * Values of annotations of one rule. Annotations that have not been
+ * set read as false, 0, empty string or NULL.
+ */
+class RuleAnnotations
+{
+    // values of Bool and Int keys share the same vector
+    std::vector<int> ints;
+    std::vector<std::string> strings;
+    std::vector<void*> pointers;
+
+public:
+
+    bool getBool(const RuleAnnotationKey &key) const;
+    void setBool(const RuleAnnotationKey &key, bool val);
+
+    int getInt(const RuleAnnotationKey &key) const;
+    void setInt(const RuleAnnotationKey &key, int val);
+
+    const std::string& getStr(const RuleAnnotationKey &key) const;
+    void setStr(const RuleAnnotationKey &key, const std::string &val);
+
+    void* getPtr(const RuleAnnotationKey &key) const;
+    void setPtr(const RuleAnnotationKey &key, void *val);
+
+    bool operator==(const RuleAnnotations &other) const;
+    bool operator!=(const RuleAnnotations &other) const
+    { return !(*this == other); }
+
+    /**
+     * returns annotations that have been set as "name=value" pairs
+     * separated by spaces, for debugging
+     */
+    std::string toString() const;
+};
+
+}
+
+#endif
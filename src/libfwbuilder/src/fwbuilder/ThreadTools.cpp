@@ -84,6 +84,15 @@ bool Cond::wait(const Mutex &m) const
     return true;
 }
 
+bool Cond::timedWait(const Mutex &m, time_t deadline) const
+{
+    struct timespec ts;
+    ts.tv_sec = deadline;
+    ts.tv_nsec = 0;
+    return pthread_cond_timedwait((pthread_cond_t*)&cond,
+                                  (pthread_mutex_t*)&m.mutex, &ts) == 0;
+}
+
 void Cond::signal() const
 {
     pthread_cond_signal( (pthread_cond_t*)&cond );
@@ -87,6 +87,13 @@ class Cond
     virtual ~Cond();
 
     bool wait(const Mutex &mutex) const;
+
+    /**
+     * Same as wait() but returns false if the condition has not
+     * been signalled by the time deadline (absolute time in seconds
+     * since the epoch).
+     */
+    bool timedWait(const Mutex &mutex, time_t deadline) const;
     void signal   () const;
     void broadcast() const;
 
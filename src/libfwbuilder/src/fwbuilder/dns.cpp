@@ -48,6 +48,7 @@
 #include <pthread.h>
 
 #include <memory>
+#include <set>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
@@ -62,12 +63,26 @@ using namespace libfwbuilder;
 
 Mutex *DNS::gethostbyname_mutex = NULL;
 Mutex *DNS::gethostbyaddr_mutex = NULL;
+DNSCache *DNS::cache = NULL;
+DNSResolverFunction DNS::resolver = NULL;
 
 // use this function for delayed initialization
 void DNS::init()
 {
     if (gethostbyname_mutex==NULL) gethostbyname_mutex = new Mutex();
     if (gethostbyaddr_mutex==NULL) gethostbyaddr_mutex = new Mutex();
+    if (cache==NULL) cache = new DNSCache();
+}
+
+DNSCache* DNS::getCache()
+{
+    DNS::init();
+    return cache;
+}
+
+void DNS::setResolver(DNSResolverFunction f)
+{
+    resolver = f;
 }
 
 /*
@@ -119,6 +134,28 @@ list<InetAddr> DNS::getHostByName(const string &name, int type)
 {
     DNS::init();
 
+    list<InetAddr> v;
+    string error;
+    if (cache->lookup(name, type, v, error))
+    {
+        if (!error.empty()) throw FWException(error);
+        return v;
+    }
+
+    if (resolver != NULL)
+    {
+        v = resolver(name, type);
+        v.sort();
+        v.unique();
+        return v;
+    }
+
+    return getAddrInfo(name, type);
+}
+
+list<InetAddr> DNS::getAddrInfo(const string &name, int type)
+    throw(FWException)
+{
     list<InetAddr> v;
     
     struct addrinfo *aiList = NULL;
@@ -197,3 +234,186 @@ list<InetAddr> DNS::getHostByName(const string &name, int type)
 }
 
 
+/*
+ * State shared by resolveNames() and its worker threads. Map running
+ * holds names that are being resolved and the time their queries
+ * started. Workers that are still waiting for a reply when their
+ * query times out or resolveNames() returns keep running; the last
+ * one to finish deletes the job.
+ */
+class ResolverJob
+{
+    public:
+
+    Mutex mutex;
+    Cond done;
+    queue<string> pending;
+    map<string, time_t> running;
+    map<string, list<InetAddr> > results;
+    map<string, string> errors;
+    set<string> timed_out;
+    int type;
+    int references;
+    bool cancelled;
+    DNSResolverFunction resolver;
+};
+
+void* DNS::resolverThread(void *arg)
+{
+    ResolverJob *job = (ResolverJob*)arg;
+
+    job->mutex.lock();
+    while (!job->cancelled && !job->pending.empty())
+    {
+        string name = job->pending.front();
+        job->pending.pop();
+        job->running[name] = time(NULL);
+        DNSResolverFunction f = job->resolver;
+        job->mutex.unlock();
+
+        list<InetAddr> v;
+        string error;
+        try
+        {
+            if (f != NULL)
+            {
+                v = f(name, job->type);
+                v.sort();
+                v.unique();
+            } else
+                v = getAddrInfo(name, job->type);
+        } catch (const FWException &ex)
+        {
+            error = ex.toString();
+        }
+
+        job->mutex.lock();
+        // another thread has taken over the queue if the query timed out
+        if (job->running.erase(name) == 0) break;
+        if (error.empty()) job->results[name] = v;
+        else job->errors[name] = error;
+        job->done.signal();
+    }
+    bool last = (--job->references == 0);
+    job->mutex.unlock();
+
+    if (last) delete job;
+    return NULL;
+}
+
+/*
+ * Must be called with job mutex locked.
+ */
+bool DNS::startResolverThread(void *arg)
+{
+    ResolverJob *job = (ResolverJob*)arg;
+
+    pthread_attr_t tattr;
+    pthread_attr_init(&tattr);
+    pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+
+    pthread_t tid;
+    job->references++;
+    bool res = (pthread_create(&tid, &tattr, resolverThread, job) == 0);
+    if (!res) job->references--;
+
+    pthread_attr_destroy(&tattr);
+    return res;
+}
+
+void DNS::resolveNames(const list<string> &names, int type,
+                       int max_parallel, unsigned int timeout,
+                       unsigned int ttl)
+{
+    DNS::init();
+
+    ResolverJob *job = new ResolverJob();
+    job->type = type;
+    job->cancelled = false;
+    job->resolver = resolver;
+    job->references = 1;
+
+    set<string> queued;
+    for (list<string>::const_iterator it=names.begin(); it!=names.end(); ++it)
+    {
+        list<InetAddr> v;
+        string error;
+        if (queued.count(*it) > 0 || cache->lookup(*it, type, v, error))
+            continue;
+        queued.insert(*it);
+        job->pending.push(*it);
+    }
+
+    int n_names = queued.size();
+    if (n_names == 0)
+    {
+        delete job;
+        return;
+    }
+
+    if (max_parallel < 1) max_parallel = 1;
+    int n_threads = (n_names < max_parallel) ? n_names : max_parallel;
+
+    job->mutex.lock();
+    for (int i=0; i<n_threads; ++i)
+    {
+        if (!startResolverThread(job)) break;
+    }
+
+    /*
+     * Each query gets timeout seconds from the moment a worker picks
+     * it up, names waiting in the queue do not time out. Worker stuck
+     * with a query that timed out is replaced with a new one so the
+     * rest of the queue keeps moving.
+     */
+    while ((int)(job->results.size() + job->errors.size() +
+                 job->timed_out.size()) < n_names)
+    {
+        if (job->references == 1)
+        {
+            // could not create any threads, resolve here
+            job->mutex.unlock();
+            job->references++;
+            resolverThread(job);
+            job->mutex.lock();
+            continue;
+        }
+
+        time_t now = time(NULL);
+        time_t deadline = now + timeout;
+        map<string, time_t>::iterator it = job->running.begin();
+        while (it != job->running.end())
+        {
+            if (it->second + (time_t)timeout <= now)
+            {
+                job->timed_out.insert(it->first);
+                job->running.erase(it++);
+                if (!job->pending.empty()) startResolverThread(job);
+                continue;
+            }
+            if (it->second + (time_t)timeout < deadline)
+                deadline = it->second + timeout;
+            ++it;
+        }
+        if ((int)(job->results.size() + job->errors.size() +
+                  job->timed_out.size()) >= n_names) break;
+
+        job->done.timedWait(job->mutex, deadline);
+    }
+    job->cancelled = true;
+
+    for (map<string, list<InetAddr> >::iterator it=job->results.begin();
+         it!=job->results.end(); ++it)
+        cache->store(it->first, type, it->second, ttl);
+
+    for (map<string, string>::iterator it=job->errors.begin();
+         it!=job->errors.end(); ++it)
+        cache->storeError(it->first, type, it->second);
+
+    // names that timed out are not stored in the cache,
+    // getHostByName() resolves them when they are needed
+
+    bool last = (--job->references == 0);
+    job->mutex.unlock();
+    if (last) delete job;
+}
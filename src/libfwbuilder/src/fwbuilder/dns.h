@@ -56,6 +56,7 @@
 #include "fwbuilder/FWException.h"
 #include "fwbuilder/BackgroundOp.h"
 #include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/DNSCache.h"
 
 #include <vector>
 #include <map>
@@ -76,6 +77,14 @@ class HostEnt
     std::set<std::string> aliases ;
 };
 
+/**
+ * Function that resolves host name, used in place of getaddrinfo(3)
+ * when set with DNS::setResolver(). Should throw FWException if the
+ * name can not be resolved.
+ */
+typedef std::list<InetAddr> (*DNSResolverFunction)(const std::string &name,
+                                                   int type);
+
 /**
  * This is abstract class
  */
@@ -99,6 +108,33 @@ class DNS
     static std::list<InetAddr> getHostByName(const std::string &name,
                                              int type=AF_INET) throw(FWException);
 
+    /**
+     * Resolves all names concurrently, running no more than
+     * max_parallel queries at a time. Results are stored in the
+     * cache (see getCache()) where getHostByName() finds them;
+     * addresses are kept there for ttl seconds. A query that has
+     * not finished within timeout seconds from the moment it was
+     * sent is abandoned and its name is not stored in the cache, so
+     * getHostByName() resolves it again when it is needed. Names
+     * that are in the cache already are not queried again.
+     */
+    static void resolveNames(const std::list<std::string> &names,
+                             int type,
+                             int max_parallel,
+                             unsigned int timeout,
+                             unsigned int ttl);
+
+    /**
+     * Cache consulted by getHostByName() before it runs a query.
+     */
+    static DNSCache* getCache();
+
+    /**
+     * Replaces getaddrinfo(3) with a different resolver, used in
+     * tests. Passing NULL restores the default.
+     */
+    static void setResolver(DNSResolverFunction resolver);
+
     /**
      * Find all host names of host with given IP.
      * This operation does not run in backgound.
@@ -108,6 +144,15 @@ class DNS
 
     private:
 
+    static std::list<InetAddr> getAddrInfo(const std::string &name,
+                                           int type) throw(FWException);
+
+    static void* resolverThread(void *arg);
+    static bool startResolverThread(void *job);
+
+    static DNSCache *cache;
+    static DNSResolverFunction resolver;
+
     static Mutex *gethostbyname_mutex;
     static Mutex *gethostbyaddr_mutex;
     
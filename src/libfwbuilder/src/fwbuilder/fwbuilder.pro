@@ -18,6 +18,7 @@ SOURCES  = 	InetAddr.cpp \
 			Constants.cpp \
 			CustomService.cpp \
 			dns.cpp \
+			DNSCache.cpp \
 			Firewall.cpp \
 			Cluster.cpp \
 			ClusterGroup.cpp \
@@ -62,6 +63,9 @@ SOURCES  = 	InetAddr.cpp \
 			Resources.cpp \
 			Routing.cpp \
 			Rule.cpp \
+			RuleAnnotation.cpp \
+			InternedString.cpp \
+			AttributeMap.cpp \
 			RuleElement.cpp \
 			RuleSet.cpp \
 			SecuwallMgmtFile.cpp \
@@ -86,6 +90,7 @@ HEADERS  = 	inet_net.h \
 			uint128.h \
 			InetAddr.h \
 			InetAddrMask.h \
+			InetAddrValue.h \
 			Inet6AddrMask.h \
 			Dispatch.h \
 			IPRoute.h \
@@ -95,6 +100,7 @@ HEADERS  = 	inet_net.h \
 			Constants.h \
 			CustomService.h \
 			dns.h \
+			DNSCache.h \
 			Firewall.h \
 			Cluster.h \
 			ClusterGroup.h \
@@ -140,6 +146,10 @@ HEADERS  = 	inet_net.h \
 			Routing.h \
 			RuleElement.h \
 			Rule.h \
+			RuleAnnotation.h \
+			InternedString.h \
+			AttributeMap.h \
+			AllocatedOnDemand.h \
 			RuleSet.h \
 			SecuwallMgmtFile.h \
 			ServiceGroup.h \
@@ -32,6 +32,10 @@
 #include <fcntl.h>
 #include <time.h>
 
+#ifndef _WIN32
+#  include <sys/time.h>
+#endif
+
 #include "fwbuilder/physAddress.h"
 #include "fwbuilder/InetAddrMask.h"
 #include "fwbuilder/Inet6AddrMask.h"
@@ -910,18 +914,29 @@ const string& SNMPQuery::getLocation()
 // -----------------------------------------------
 
 bool SNMPConnection::lib_initialized = false;
+Mutex SNMPConnection::lib_init_mutex;
 
 SNMPConnection::SNMPConnection(const string &p, const string &c)
 {
     connected    = false;
+    session      = NULL;
     session_data = NULL;
     peer         = p;
     community    = c;
+    request_interval  = 0;
+    last_request_time = 0;
+    initLibrary();
+}
+
+void SNMPConnection::initLibrary()
+{
+    lib_init_mutex.lock();
     if(!lib_initialized)
     {
         init_snmp("fwbuilder");
         lib_initialized = true;
     }
+    lib_init_mutex.unlock();
 }
 
 SNMPConnection::~SNMPConnection()
@@ -944,7 +959,7 @@ void SNMPConnection::connect(int retries, long timeout) throw(FWException)
     session_data->retries       = retries;
     session_data->timeout       = timeout;
     
-    session = snmp_open(session_data);
+    session = snmp_sess_open(session_data);
     if(!session)
         throw FWException("SNMPSession: error while establishing connection.");
         
@@ -956,7 +971,8 @@ void SNMPConnection::disconnect() throw(FWException)
     if(!connected)
         throw FWException("SNMPSession: already disconnected");
 
-    snmp_close(session);
+    snmp_sess_close(session);
+    session = NULL;
 
     delete session_data->peername;
     delete session_data->community;
@@ -965,6 +981,45 @@ void SNMPConnection::disconnect() throw(FWException)
     connected    = false;
 }
 
+static long long currentTimeMs()
+{
+#ifdef _WIN32
+    return GetTickCount();
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (long long)(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+/*
+ * Sleep until at least request_interval milliseconds have passed
+ * since the previous request to the same peer.
+ */
+void SNMPConnection::waitForRequestSlot()
+{
+    if (request_interval > 0 && last_request_time > 0)
+    {
+        long long wait = last_request_time + request_interval - currentTimeMs();
+        if (wait > 0)
+        {
+#ifdef _WIN32
+            Sleep(wait);
+#else
+            usleep(wait * 1000);
+#endif
+        }
+    }
+    last_request_time = currentTimeMs();
+}
+
+int SNMPConnection::synchResponse(struct snmp_pdu *pdu,
+                                  struct snmp_pdu **response)
+{
+    waitForRequestSlot();
+    return snmp_sess_synch_response(session, pdu, response);
+}
+
 multimap<string, SNMPVariable* > SNMPConnection::walk(const string &variable) throw(FWException)
 {
     multimap<string, SNMPVariable*> res;
@@ -993,7 +1048,7 @@ multimap<string, SNMPVariable* > SNMPConnection::walk(const string &variable) th
         
         /* do the request */
         struct snmp_pdu *response = NULL;
-        int status = snmp_synch_response(session, pdu, &response);
+        int status = synchResponse(pdu, &response);
         if(status == STAT_SUCCESS)
         {
             if(response->errstat == SNMP_ERR_NOERROR)
@@ -1060,7 +1115,7 @@ multimap<string, SNMPVariable* > SNMPConnection::walk(const string &variable) th
                 str << status;
                 int liberr,syserr;
                 char *errstr = (char*)("");
-                snmp_error(session, &liberr, &syserr, &errstr);
+                snmp_sess_error(session, &liberr, &syserr, &errstr);
                 str << " " << errstr;
                 throw FWException(str.str());
             }
@@ -1083,7 +1138,7 @@ vector<SNMPVariable*> SNMPConnection::get(const string &variable)
     read_objid(variable.c_str(), anOID, &anOID_len); //TODO: error check
     snmp_add_null_var(pdu, anOID, anOID_len);
     struct snmp_pdu *response;
-    int status = snmp_synch_response(session, pdu, &response);
+    int status = synchResponse(pdu, &response);
     if(status == STAT_SUCCESS && response->errstat == SNMP_ERR_NOERROR) 
     {
         vector<SNMPVariable*> res;
@@ -1314,6 +1369,8 @@ void SNMPCrawler::init(const InetAddr &_seed,
     dns_threads  = _dns_threads;
     dns_retries  = _dns_retries;
     dns_timeout  = _dns_timeout;
+    snmp_threads = 16;
+    snmp_request_interval = 0;
 
     queue.clear();
     found.clear();
@@ -1420,382 +1477,557 @@ bool SNMPCrawler::special(const InetAddrMask &n) const
         n.getAddressPtr()->isAny();
 }
 
-//TODO: multiple threads (via pool).
-void SNMPCrawler::run_impl(Logger *logger,
-                           SyncFlag *stop_program) throw(FWException)
+/*
+ * Everything the crawler learned about one host. Worker thread fills
+ * it in, crawler thread merges it into the results and deletes it.
+ */
+namespace libfwbuilder
 {
-    if (snmp_tmp_db==NULL)
-        snmp_tmp_db = new FWObjectDatabase();
 
-    std::ostringstream str;
-    time_t now=time(NULL);
-    str << "SNMPCrawler started at " << asctime(localtime(&now))
-        << ". Seed host: " << (*(queue.begin())).first.toString() << "\n";
-    *logger << str;
+class SNMPCrawlerJob
+{
+    public:
 
-    snmp_tmp_db->destroyChildren();
+    InetAddr addr;
+    string phys_addr;
+    SyncFlag *stop_program;
 
     SNMP_discover_query q;
-    do {
-        CHECK_STOP_AND_RETURN;
+    QueueLogger log;
 
-        map<InetAddr,string>::iterator i=queue.begin();
-        if(i==queue.end())
-        {
-            break;
-        }
-        InetAddr task = (*i).first;
-        string task_phys_address = (*i).second;
-        queue.erase(i);
-        
-        str << "\nProcessing " << task.toString() << "\n";
+    bool arp_ok;
+    bool interfaces_ok;
+    bool sysinfo_ok;
+    bool routes_ok;
 
-        *logger << str;
-        
+    SNMPCrawlerJob(const InetAddr &a, const string &pa, SyncFlag *stop) :
+        addr(a), phys_addr(pa)
+    {
+        stop_program = stop;
+        arp_ok = interfaces_ok = sysinfo_ok = routes_ok = false;
+    }
+};
+
+}
+
+void SNMPCrawler::setConcurrency(unsigned int max_hosts, long request_interval)
+{
+    snmp_threads = (max_hosts > 0) ? max_hosts : 1;
+    snmp_request_interval = request_interval;
+}
+
+void SNMPCrawler::hostProcessed(const InetAddr&, const CrawlerFind&)
+{
+}
+
+void* SNMPCrawler::workerThread(void *arg)
+{
+    SNMPCrawler *crawler = (SNMPCrawler*)arg;
+    crawler->jobs_mutex.lock();
+    while (true)
+    {
+        while (crawler->pending_jobs.empty() && !crawler->workers_stop)
+            crawler->jobs_cond.wait(crawler->jobs_mutex);
+        if (crawler->workers_stop) break;
+
+        SNMPCrawlerJob *job = crawler->pending_jobs.front();
+        crawler->pending_jobs.pop_front();
+        crawler->jobs_mutex.unlock();
+
+        crawler->queryHost(job);
+
+        crawler->jobs_mutex.lock();
+        crawler->finished_jobs.push_back(job);
+        crawler->finished_cond.signal();
+    }
+    crawler->jobs_mutex.unlock();
+    return NULL;
+}
+
+/*
+ * Runs in a worker thread. All queries go to the host over the same
+ * session. This method only touches the job object, results are merged
+ * by mergeResults() in the thread that runs the crawler.
+ */
+void SNMPCrawler::queryHost(SNMPCrawlerJob *job)
+{
+    Logger *logger = &(job->log);
+    SyncFlag *stop_program = job->stop_program;
+    SNMP_discover_query &q = job->q;
+    std::ostringstream str;
+
+    str << "\nProcessing " << job->addr.toString() << "\n";
+    *logger << str;
+
+    try
+    {
+        SNMPConnection c(job->addr.toString(), community);
+        c.setRequestInterval(snmp_request_interval);
+        c.connect(snmp_retries, snmp_timeout);
 
-        // Now in task we have element to probe
-        
-        q.init(task.toString(), // fake host - IP in dotted notation
-               community,
-               snmp_retries,  
-               snmp_timeout
-        );
-        
-        CrawlerFind *res = new CrawlerFind();
-        found[task] = *res; delete res;
-        found[task].found_phys_addr = task_phys_address;
         try
         {
-            q.fetchArpTable(logger,stop_program);
-            found[task].have_snmpd = true;
+            q.fetchArpTable(logger, stop_program, &c);
+            job->arp_ok = true;
         } catch(const FWException &ex)
         {
             // fetch failed
             str << ex.toString() << "\n";
-            str << "Failed to fetch ARP table from " << task.toString();
+            str << "Failed to fetch ARP table from " << job->addr.toString();
             if (!ex.toString().empty()) str << " : " << ex.toString();
             str << "\n";
             *logger << str;
-            
-            continue;
+            return;
         } catch (std::string s)
         {
             str << s << "\n";
-            str << "Failed to fetch ARP table from " << task.toString();
+            str << "Failed to fetch ARP table from " << job->addr.toString();
             str << " : " << s;
             str << "\n";
             *logger << str;
-            
-            continue;
+            return;
         }
 
-        map<InetAddr, string>* at = q.getArpTable();    
-        str << "Got " << long(at->size()) << " entries\n";
-        *logger << str;
-        
-        int qplus=0, rplus=0, dplus=0;
-        for(map<InetAddr, string>::iterator j=at->begin();j!=at->end();++j)
+        try
         {
-            CHECK_STOP_AND_RETURN;
-
-            InetAddr  c = (*j).first;
-            string    pa = (*j).second;
-            if (included(c) && !alreadyseen(c) && !special(c))
-            {
-                if(recursive)
-                {
-                    qplus++;
-                    queue[c]=pa;
-                } else
-                {
-                    rplus++;
-                    found[c]=CrawlerFind();
-                    found[c].found_phys_addr=pa;
-                }
-            } else
-                dplus++;
-        }
-        if (qplus)
+            q.fetchInterfaces(logger, stop_program, &c);
+            job->interfaces_ok = true;
+        } catch(FWException &ex)
         {
-            str << "Adding "   << qplus << " hosts to queue\n";
+            // fetch failed
+            str << ex.toString() << "\n";
+            str << "Failed to fetch list of interfaces from "
+                << job->addr.toString() << "\n";
             *logger << str;
         }
-        if (rplus)
+
+        try
         {
-            str << "Adding "   << rplus << " hosts to results\n";
+            q.fetchSysInfo(logger, stop_program, &c);
+            job->sysinfo_ok = true;
+        } catch (const FWException &ex)
+        {
+            // fetch failed
+            str << ex.toString() << "\n";
+            str << "Failed to fetch sysinfo from "
+                << job->addr.toString() << "\n";
             *logger << str;
         }
-        if (dplus)
+
+        try
         {
-            str << "Skipping " << dplus
-                << " hosts as duplicate, excluded or virtual\n";
+            q.fetchRoutingTable(logger, stop_program, &c);
+            job->routes_ok = true;
+        } catch(const FWException &ex)
+        {
+            // fetch failed
+            str << ex.toString() << "\n";
+            str << "Failed to fetch routing table from "
+                << job->addr.toString() << "\n";
             *logger << str;
         }
+        catch (...)
+        {
+            *logger << "Unsupported exception\n";
+        }
+    } catch(const FWException &ex)
+    {
+        // could not open session
+        str << "Failed to fetch ARP table from " << job->addr.toString()
+            << " : " << ex.toString() << "\n";
+        *logger << str;
+    }
+}
+
+/*
+ * Runs in the thread that runs the crawler. Adds addresses and
+ * networks learned from the host to the results and new hosts to the
+ * queue.
+ */
+void SNMPCrawler::mergeResults(SNMPCrawlerJob *job, Logger *logger,
+                               SyncFlag *stop_program)
+{
+    std::ostringstream str;
+    InetAddr task = job->addr;
+    SNMP_discover_query &q = job->q;
 
-        set<InetAddr> interface_broadcasts;
+    while (job->log.ready()) *logger << job->log.getLine();
 
-        try
+    if (!job->arp_ok) return;
+
+    found[task].have_snmpd = true;
+
+    map<InetAddr, string>* at = q.getArpTable();    
+    str << "Got " << long(at->size()) << " entries\n";
+    *logger << str;
+        
+    int qplus=0, rplus=0, dplus=0;
+    for(map<InetAddr, string>::iterator j=at->begin();j!=at->end();++j)
+    {
+        CHECK_STOP_AND_RETURN;
+
+        InetAddr  c = (*j).first;
+        string    pa = (*j).second;
+        if (included(c) && !alreadyseen(c) && !special(c))
         {
-            q.fetchInterfaces(logger,stop_program);
-            found[task].have_snmpd = true;
+            if(recursive)
+            {
+                qplus++;
+                queue[c]=pa;
+            } else
+            {
+                rplus++;
+                found[c]=CrawlerFind();
+                found[c].found_phys_addr=pa;
+            }
+        } else
+            dplus++;
+    }
+    if (qplus)
+    {
+        str << "Adding "   << qplus << " hosts to queue\n";
+        *logger << str;
+    }
+    if (rplus)
+    {
+        str << "Adding "   << rplus << " hosts to results\n";
+        *logger << str;
+    }
+    if (dplus)
+    {
+        str << "Skipping " << dplus
+            << " hosts as duplicate, excluded or virtual\n";
+        *logger << str;
+    }
 
-            //cerr << "Copying list of interfaces" << endl;
-            //map<int, InterfaceData> intf = q.getInterfaces();
-            //cerr << "Done" << endl;
+    set<InetAddr> interface_broadcasts;
 
-            map<int, InterfaceData>* intf = q.getInterfaces();
-            map<int, InterfaceData>::iterator j;
-            for (j=intf->begin(); j!=intf->end(); ++j)
+    if (job->interfaces_ok)
+    {
+        map<int, InterfaceData>* intf = q.getInterfaces();
+        map<int, InterfaceData>::iterator j;
+        for (j=intf->begin(); j!=intf->end(); ++j)
+        {
+            // If interface is down or does not have ip address, it
+            // will be ignored.
+            if (!j->second.ostatus) continue;
+            if (j->second.addr_mask.size()==0) continue;
+
+            list<InetAddrMask*>::iterator n;
+            for (n=j->second.addr_mask.begin();
+                 n!=j->second.addr_mask.end(); ++n)
             {
-                // If interface is down or does not have ip address, it
-                // will be ignored.
-                if (!j->second.ostatus) continue;
-                if (j->second.addr_mask.size()==0) continue;
-
-                list<InetAddrMask*>::iterator n;
-                for (n=j->second.addr_mask.begin();
-                     n!=j->second.addr_mask.end(); ++n)
+                InetAddrMask *net = *n;
+                const InetAddr *addr = net->getAddressPtr();
+                if (addr==NULL) continue;
+
+                interface_broadcasts.insert(
+                    *(net->getBroadcastAddressPtr()));
+
+                if (!special(*net) &&
+                    included(*(net->getAddressPtr())) &&
+                    !point2point(*net, j->second))
                 {
-                    InetAddrMask *net = *n;
-                    const InetAddr *addr = net->getAddressPtr();
-                    const InetAddr *netm = net->getNetmaskPtr();
-                    (void)netm; //UNUSED
-                    if (addr==NULL) continue;
-
-                    //InetAddrMask net(*addr, *netm);
-                    interface_broadcasts.insert(
-                        *(net->getBroadcastAddressPtr()));
-
-                    if (!special(*net) &&
-                        included(*(net->getAddressPtr())) &&
-                        !point2point(*net, j->second))
-                    {
-                        str << "Network " << net->toString() << "\n";
-                        *logger << str;
+                    str << "Network " << net->toString() << "\n";
+                    *logger << str;
 
-                        // NOTE: net is a pointer to InetAddrMask object
-                        // created in fetchInterfaces when we filled
-                        // map interfaces with InterfaceData objects.
-                        // This object is destroyed when all InterfaceData
-                        // objects are destroyed. Create a copy.
+                    // NOTE: net is a pointer to InetAddrMask object
+                    // created in fetchInterfaces when we filled
+                    // map interfaces with InterfaceData objects.
+                    // This object is destroyed when all InterfaceData
+                    // objects are destroyed. Create a copy.
 
-                        networks.insert(*net);
-                    }
+                    networks.insert(*net);
                 }
             }
-        } catch(FWException &ex)
-        {
-            // fetch failed
-            str << ex.toString() << "\n";
-            str << "Failed to fetch list of interfaces from "
-                << task.toString() << "\n";
-            *logger << str;
         }
+    }
 
-        try
-        {
-            q.fetchSysInfo(logger,stop_program);
-            found[task].have_snmpd = true;
+    if (job->sysinfo_ok)
+    {
+        found[task].sysname  = q.getSysname  ();
+        found[task].descr    = q.getDescr    ();
+        found[task].contact  = q.getContact  ();
+        found[task].location = q.getLocation ();
+    }
 
-            found[task].sysname  = q.getSysname  ();
-            found[task].descr    = q.getDescr    ();
-            found[task].contact  = q.getContact  ();
-            found[task].location = q.getLocation ();
-        } catch (const FWException &ex)
-        {
-            // fetch failed
-            str << ex.toString() << "\n";
-            str << "Failed to fetch sysinfo from " << task.toString() << "\n";
-            *logger << str;
+    if (job->routes_ok)
+    {
+        vector<IPRoute>* routes = q.getRoutes();
             
-        }
+        qplus=0; rplus=0; dplus=0; 
+        int nplus=0;
 
-        try
+        for (vector<IPRoute>::iterator j=routes->begin();
+             j!=routes->end(); ++j)
         {
-            q.fetchRoutingTable(logger,stop_program);
-            found[task].have_snmpd = true;
-            
-            vector<IPRoute>* routes = q.getRoutes();
-            
-            qplus=0; rplus=0; dplus=0; 
-            int nplus=0;
-
-            for (vector<IPRoute>::iterator j=routes->begin();
-                 j!=routes->end(); ++j)
-            {
-                InterfaceData intf;
-                bool have_intf;
+            InterfaceData intf;
+            bool have_intf;
                 
-                const InterfaceData& real_i = j->getInterface();
-                intf      = real_i;
-                have_intf = !intf.name.empty();
+            const InterfaceData& real_i = j->getInterface();
+            intf      = real_i;
+            have_intf = !intf.name.empty();
                 
-                InetAddrMask net(j->getDestination(),
-                                 j->getNetmask());
+            InetAddrMask net(j->getDestination(),
+                             j->getNetmask());
                 
-                if (!have_intf)
-                {
-                    // No interface reported for this route by SNMP 
-                    // we can try to guess it by route information.
-                    // Since interface is used.
-                    list<InterfaceData> gi =
-                        guessInterface(*j, *(q.getInterfaces()));
+            if (!have_intf)
+            {
+                // No interface reported for this route by SNMP 
+                // we can try to guess it by route information.
+                // Since interface is used.
+                list<InterfaceData> gi =
+                    guessInterface(*j, *(q.getInterfaces()));
                     
-                    // From all resulting interfaces we select one
-                    // using following rules:
-                    //
-                    // 1. If all interfaces are down we select any of them
-                    // since this route will be ignored because of it.
-                    //
-                    // 2. From interfaces which are UP, we select first one
-                    // with Point-to-Point attribute enabled.
-                    //
-                    list<InterfaceData>::const_iterator k;
-                    for(k=gi.begin(); k!=gi.end(); ++k)
+                // From all resulting interfaces we select one
+                // using following rules:
+                //
+                // 1. If all interfaces are down we select any of them
+                // since this route will be ignored because of it.
+                //
+                // 2. From interfaces which are UP, we select first one
+                // with Point-to-Point attribute enabled.
+                //
+                list<InterfaceData>::const_iterator k;
+                for(k=gi.begin(); k!=gi.end(); ++k)
+                {
+                    if(!have_intf)
+                    {
+                        // first interface ever found
+                        intf=*k;
+                        have_intf = true;
+                    } else 
                     {
-                        if(!have_intf)
+                        if ((*k).ostatus)
                         {
-                            // first interface ever found
-                            intf=*k;
+                            // Candidate is up
+                            // Store it.
+                            intf = *k;
                             have_intf = true;
-                        } else 
+                        } else
                         {
-                            if ((*k).ostatus)
-                            {
-                                // Candidate is up
-                                // Store it.
+                            // Candidate is down.
+                            // We take it into account only
+                            // if everything found so far is down.
+                            if (!intf.ostatus)
                                 intf = *k;
-                                have_intf = true;
-                            } else
-                            {
-                                // Candidate is down.
-                                // We take it into account only
-                                // if everything found so far is down.
-                                if (!intf.ostatus)
-                                    intf = *k;
-                            }
                         }
-                        if(have_intf && intf.ostatus && point2point(intf))
-                            break;
                     }
-                    if (have_intf)
-                        str << "Guessed that network " << net.toString()
-                            << " is using interface " << intf.name << "\n";
-                    *logger << str;
-                    
+                    if(have_intf && intf.ostatus && point2point(intf))
+                        break;
                 }
+                if (have_intf)
+                    str << "Guessed that network " << net.toString()
+                        << " is using interface " << intf.name << "\n";
+                *logger << str;
+                    
+            }
 
-                // If route is associated with an interface which is down,
-                // ignore it.
-                if (have_intf && !intf.ostatus)
-                {
-                    str << "Skipping route for network " << net.toString()
-                        << " which is associated with interface which is"
-                        << " currently down.";
-                    *logger << str;
-                    continue; 
-                }
+            // If route is associated with an interface which is down,
+            // ignore it.
+            if (have_intf && !intf.ostatus)
+            {
+                str << "Skipping route for network " << net.toString()
+                    << " which is associated with interface which is"
+                    << " currently down.";
+                *logger << str;
+                continue; 
+            }
 
-                if (!special(net) && included(*(net.getAddressPtr())) )
+            if (!special(net) && included(*(net.getAddressPtr())) )
+            {
+                if (point2point(net, intf))
                 {
-                    if (point2point(net, intf))
-                    {
-                        const InetAddr *c = net.getAddressPtr();
+                    const InetAddr *c = net.getAddressPtr();
 
-                        // For all addresses found in the routing table
-                        // we must check if they are broadcast addresses
-                        // for some of our interfaces, and if yes, ignore them.
-                        // (see task #36520).
+                    // For all addresses found in the routing table
+                    // we must check if they are broadcast addresses
+                    // for some of our interfaces, and if yes, ignore them.
+                    // (see task #36520).
 
-                        if (included(*c) && !alreadyseen(*c) && !special(*c) && 
-                            !interface_broadcasts.count(*c))
+                    if (included(*c) && !alreadyseen(*c) && !special(*c) && 
+                        !interface_broadcasts.count(*c))
+                    {
+                        if(recursive && follow_ptp)
                         {
-                            if(recursive && follow_ptp)
-                            {
-                                qplus++;
-                                queue[*c]="";
-                            } else
-                            {
-                                rplus++;
-                                found[*c] = CrawlerFind();
-                            }
+                            qplus++;
+                            queue[*c]="";
                         } else
                         {
-                            dplus++;
+                            rplus++;
+                            found[*c] = CrawlerFind();
                         }
                     } else
                     {
-                        str << "Network " << net.toString()
-                            << " found (via "
-                            << string(((*j).isDirect())?"direct":"indirect") 
-                            << " route).\n";
-                        *logger << str;
-
-                        networks.insert(
-                            InetAddrMask(j->getDestination(), j->getNetmask()));
-                        
-                        nplus++;
+                        dplus++;
                     }
-                }
-
-                InetAddr gw((*j).getGateway());
-                if (included(gw) && !alreadyseen(gw) && 
-                    !special(gw) && !interface_broadcasts.count(gw))
+                } else
                 {
-                    bool isptp=point2point(net, intf);
-                    if(recursive && (!isptp || (isptp && follow_ptp)))
-                    {
-                        qplus++;
-                        queue[gw]="";
-                    } else
-                    {
-                        rplus++;
-                        found[gw]=CrawlerFind();
-                    }
+                    str << "Network " << net.toString()
+                        << " found (via "
+                        << string(((*j).isDirect())?"direct":"indirect") 
+                        << " route).\n";
+                    *logger << str;
+
+                    networks.insert(
+                        InetAddrMask(j->getDestination(), j->getNetmask()));
+                        
+                    nplus++;
                 }
             }
 
-            if (qplus)
-            {
-                str << "Adding "   << qplus << " hosts to queue\n";
-                *logger << str;
-            }
-            if (nplus)
-            {
-                str << "Adding "   << nplus << " networks to results\n";
-                *logger << str;
-            }
-            if (rplus)
-            {
-                str << "Adding "   << rplus << " hosts to results\n";
-                *logger << str;
-            }
-            if (dplus)
+            InetAddr gw((*j).getGateway());
+            if (included(gw) && !alreadyseen(gw) && 
+                !special(gw) && !interface_broadcasts.count(gw))
             {
-                str << "Skipping " << dplus
-                    << " hosts as duplicate, excluded or virtual\n";
-                *logger << str;
+                bool isptp=point2point(net, intf);
+                if(recursive && (!isptp || (isptp && follow_ptp)))
+                {
+                    qplus++;
+                    queue[gw]="";
+                } else
+                {
+                    rplus++;
+                    found[gw]=CrawlerFind();
+                }
             }
+        }
 
-        } catch(const FWException &ex)
+        if (qplus)
         {
-            // fetch failed
-            str << ex.toString() << "\n";
-            str << "Failed to fetch routing table from "
-                << task.toString() << "\n";
+            str << "Adding "   << qplus << " hosts to queue\n";
             *logger << str;
         }
-        catch (...)
+        if (nplus)
         {
-            *logger << "Unsupported exception\n";
+            str << "Adding "   << nplus << " networks to results\n";
+            *logger << str;
+        }
+        if (rplus)
+        {
+            str << "Adding "   << rplus << " hosts to results\n";
+            *logger << str;
+        }
+        if (dplus)
+        {
+            str << "Skipping " << dplus
+                << " hosts as duplicate, excluded or virtual\n";
+            *logger << str;
         }
+    }
 
-        // We add interfaces _after_ fetching routing table,
-        // since it's updates 'ext' attribute based on rounting
-        // table.
-        found[task].interfaces = *(q.getInterfaces());
-        
-    } while(recursive);
+    // We add interfaces _after_ fetching routing table,
+    // since it's updates 'ext' attribute based on rounting
+    // table.
+    found[task].interfaces = *(q.getInterfaces());
+}
+
+/*
+ * Hosts are taken from the queue and handed over to a pool of
+ * snmp_threads worker threads, so up to snmp_threads hosts are queried
+ * at the same time. Results are merged in this thread as soon as each
+ * host is done; merging may add more hosts to the queue which are
+ * dispatched right away. The crawler finishes when the queue is empty
+ * and no queries are outstanding.
+ */
+void SNMPCrawler::run_impl(Logger *logger,
+                           SyncFlag *stop_program) throw(FWException)
+{
+    if (snmp_tmp_db==NULL)
+        snmp_tmp_db = new FWObjectDatabase();
+
+    std::ostringstream str;
+    time_t now=time(NULL);
+    str << "SNMPCrawler started at " << asctime(localtime(&now))
+        << ". Seed host: " << (*(queue.begin())).first.toString() << "\n";
+    *logger << str;
+
+    snmp_tmp_db->destroyChildren();
+
+    SNMPConnection::initLibrary();
+
+    workers_stop = false;
+    vector<pthread_t> workers;
+    for (unsigned int n=0; n<snmp_threads; ++n)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, workerThread, this) != 0) break;
+        workers.push_back(tid);
+    }
+    if (workers.empty())
+    {
+        *logger << "Could not create worker threads\n";
+        return;
+    }
+
+    unsigned int outstanding = 0;
+    bool stopped = false;
+    while (true)
+    {
+        stop_program->lock();
+        stopped = stop_program->peek();
+        stop_program->unlock();
+        if (stopped) break;
+
+        while (!queue.empty() && outstanding < workers.size())
+        {
+            map<InetAddr,string>::iterator i = queue.begin();
+            SNMPCrawlerJob *job = new SNMPCrawlerJob(i->first, i->second,
+                                                     stop_program);
+            queue.erase(i);
+
+            // Now in task we have element to probe
+            job->q.init(job->addr.toString(), // fake host - IP in dotted notation
+                        community,
+                        snmp_retries,  
+                        snmp_timeout
+            );
+
+            found[job->addr] = CrawlerFind();
+            found[job->addr].found_phys_addr = job->phys_addr;
+
+            jobs_mutex.lock();
+            pending_jobs.push_back(job);
+            jobs_cond.signal();
+            jobs_mutex.unlock();
+            outstanding++;
+        }
+
+        if (outstanding == 0) break;
+
+        list<SNMPCrawlerJob*> done;
+        jobs_mutex.lock();
+        if (finished_jobs.empty())
+            finished_cond.timedWait(jobs_mutex, time(NULL) + 1);
+        done.swap(finished_jobs);
+        jobs_mutex.unlock();
+
+        for (list<SNMPCrawlerJob*>::iterator j=done.begin(); j!=done.end(); ++j)
+        {
+            SNMPCrawlerJob *job = *j;
+            outstanding--;
+            mergeResults(job, logger, stop_program);
+            hostProcessed(job->addr, found[job->addr]);
+            delete job;
+        }
+    }
+
+    jobs_mutex.lock();
+    workers_stop = true;
+    jobs_cond.broadcast();
+    jobs_mutex.unlock();
+
+    for (vector<pthread_t>::iterator t=workers.begin(); t!=workers.end(); ++t)
+        pthread_join(*t, NULL);
+
+    for (list<SNMPCrawlerJob*>::iterator j=pending_jobs.begin();
+         j!=pending_jobs.end(); ++j) delete *j;
+    for (list<SNMPCrawlerJob*>::iterator j=finished_jobs.begin();
+         j!=finished_jobs.end(); ++j) delete *j;
+    pending_jobs.clear();
+    finished_jobs.clear();
+
+    if (stopped) return;
 
     if(do_dns)
         bacresolve_results(logger,stop_program);
@@ -30,6 +30,7 @@
 
 #ifdef HAVE_LIBSNMP
 
+#include <list>
 #include <vector>
 
 #include "fwbuilder/FWObjectDatabase.h"
@@ -258,13 +259,39 @@ class SNMPConnection
     std::vector<SNMPVariable*> get(const std::string &variable) throw(FWException);
     std::multimap<std::string, SNMPVariable*> walk(const std::string &variable) throw(FWException);
 
+    /**
+     * Minimal interval between two requests sent to the peer, in
+     * milliseconds. Default is 0 (no limit).
+     */
+    void setRequestInterval(long interval) { request_interval = interval; }
+
+    /**
+     * Initializes net-snmp library. Called by the constructor, but
+     * should be called before any threads that use SNMP are started.
+     */
+    static void initLibrary();
+
     private:
 
     std::string peer;
     std::string community;
     bool connected;
-    struct snmp_session *session, *session_data;
+    long request_interval;
+    long long last_request_time;
+
+    /*
+     * Connection uses single session API of net-snmp which, unlike
+     * the traditional API, is safe to use from several threads as
+     * long as each thread uses its own session.
+     */
+    void *session;
+    struct snmp_session *session_data;
+
     static bool lib_initialized;
+    static Mutex lib_init_mutex;
+
+    void waitForRequestSlot();
+    int synchResponse(struct snmp_pdu *pdu, struct snmp_pdu **response);
 };
 
 class SNMPQuery : public BackgroundOp
@@ -446,6 +473,8 @@ class CrawlerFind: public HostEnt
     bool dns_ok       ;
 };
 
+class SNMPCrawlerJob;
+
 class SNMPCrawler : public BackgroundOp
 {
     private:
@@ -467,9 +496,29 @@ class SNMPCrawler : public BackgroundOp
     unsigned int                 dns_threads  ;
     int                          dns_retries  ;
     int                          dns_timeout  ;
+    unsigned int                 snmp_threads ;
+    long                         snmp_request_interval ;
+
+    /*
+     * Hosts are queried by a pool of worker threads. Jobs waiting for
+     * a worker are in pending_jobs, jobs that have been processed but
+     * whose results have not been merged yet are in finished_jobs.
+     * Both lists and flag workers_stop are guarded by jobs_mutex.
+     */
+    Mutex                        jobs_mutex   ;
+    Cond                         jobs_cond    ;
+    Cond                         finished_cond;
+    std::list<SNMPCrawlerJob*>   pending_jobs ;
+    std::list<SNMPCrawlerJob*>   finished_jobs;
+    bool                         workers_stop ;
 
     static const int  PTP_INTERFACE_TYPES[];
 
+    static void* workerThread(void *crawler);
+    void queryHost(SNMPCrawlerJob *job);
+    void mergeResults(SNMPCrawlerJob *job, Logger *logger,
+                      SyncFlag *stop_program);
+
     protected:
 
     bool included    (const InetAddr &) const ;
@@ -482,6 +531,14 @@ class SNMPCrawler : public BackgroundOp
     std::list<InterfaceData> guessInterface(
         const IPRoute &r, const std::map<int, InterfaceData> &intf) const;
 
+    /**
+     * Called in the thread that runs the crawler every time results
+     * of queries sent to a host have been added to the list of
+     * discovered addresses and networks. Derived classes can
+     * override it to show results while the crawler is still running.
+     */
+    virtual void hostProcessed(const InetAddr &addr, const CrawlerFind &host);
+
     public:
 
     SNMPCrawler();
@@ -510,6 +567,13 @@ class SNMPCrawler : public BackgroundOp
 	      int  _dns_timeout=RES_TIMEOUT,
 	      const std::vector<InetAddrMask> *include=NULL);
 
+    /**
+     * Sets the number of hosts queried in parallel and the minimal
+     * interval in milliseconds between two requests sent to the
+     * same host. Defaults are 16 hosts and no limit.
+     */
+    void setConcurrency(unsigned int max_hosts, long request_interval=0);
+
     std::map<InetAddr, CrawlerFind>  getAllIPs();
     std::set<InetAddrMask> getNetworks();
         
@@ -0,0 +1,311 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "AddressRangeSet.h"
+
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/NetworkIPv6.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+static int trailingZeros(const InetAddrValue &a)
+{
+    int bits = a.addressLengthBits();
+    uint64_t w = a.lo;
+    int n = 0;
+    if (w == 0)
+    {
+        if (bits == 32 || a.hi == 0) return bits;
+        w = a.hi;
+        n = 64;
+    }
+    while ((w & 1) == 0)
+    {
+        w >>= 1;
+        n++;
+    }
+    return n;
+}
+
+/*
+ * ranges are sorted and disjoint, adding r at the end merges it with
+ * the last range if they overlap or touch. r must not start before
+ * the last range does.
+ */
+static void appendRange(vector<InetRangeValue> &ranges, const InetRangeValue &r)
+{
+    if (!ranges.empty())
+    {
+        InetRangeValue &back = ranges.back();
+        InetAddrValue max = InetAddrValue(back.last.af,
+                                          InetAddrValue::hiMask(back.last.af),
+                                          InetAddrValue::loMask(back.last.af));
+        if (back.last == max || r.first <= back.last.next())
+        {
+            if (back.last < r.last) back.last = r.last;
+            return;
+        }
+    }
+    ranges.push_back(r);
+}
+
+class rangeEndsBefore
+{
+    public:
+    bool operator()(const InetRangeValue &r, const InetAddrValue &a) const
+    { return r.last < a; }
+};
+
+class rangeStartsAfter
+{
+    public:
+    bool operator()(const InetAddrValue &a, const InetRangeValue &r) const
+    { return a < r.first; }
+};
+
+InetAddrValue AddressRangeSet::minAddress() const
+{
+    return InetAddrValue(af, 0, 0);
+}
+
+InetAddrValue AddressRangeSet::maxAddress() const
+{
+    return InetAddrValue(af, InetAddrValue::hiMask(af),
+                         InetAddrValue::loMask(af));
+}
+
+void AddressRangeSet::addRange(const InetAddrValue &first,
+                               const InetAddrValue &last)
+{
+    assert(first.af == af && last.af == af);
+    if (last < first) return;
+
+    // first range that ends at or after first-1
+    vector<InetRangeValue>::iterator i = lower_bound(
+        ranges.begin(), ranges.end(), first, rangeEndsBefore());
+    if (i != ranges.begin() && (i-1)->last.next() == first) --i;
+
+    InetAddrValue max = maxAddress();
+    InetRangeValue merged(first, last);
+    vector<InetRangeValue>::iterator j = i;
+    while (j != ranges.end() &&
+           (j->first <= last || (last != max && j->first == last.next())))
+    {
+        if (j->first < merged.first) merged.first = j->first;
+        if (merged.last < j->last) merged.last = j->last;
+        ++j;
+    }
+
+    i = ranges.erase(i, j);
+    ranges.insert(i, merged);
+}
+
+void AddressRangeSet::addPrefix(const InetAddrValue &address, int length)
+{
+    InetAddrValue netmask = InetAddrValue::netmask(af, length);
+    InetAddrValue network = address & netmask;
+    addRange(network, network | ~netmask);
+}
+
+bool AddressRangeSet::addObject(FWObject *obj)
+{
+    AddressRange *ar = AddressRange::cast(obj);
+    if (ar)
+    {
+        InetAddrValue first(ar->getRangeStart());
+        InetAddrValue last(ar->getRangeEnd());
+        if (first.af != af || last.af != af || last < first) return false;
+        addRange(first, last);
+        return true;
+    }
+
+    if (!IPv4::isA(obj) && !IPv6::isA(obj) &&
+        !Network::isA(obj) && !NetworkIPv6::isA(obj)) return false;
+
+    Address *addr = Address::cast(obj);
+    const InetAddr *a = addr->getAddressPtr();
+    if (a == NULL || a->addressFamily() != af) return false;
+    InetAddrValue v(*a);
+
+    // IPv4 and IPv6 objects match single address, their netmask
+    // only describes the subnet they belong to
+    if (IPv4::isA(obj) || IPv6::isA(obj))
+    {
+        addRange(v, v);
+        return true;
+    }
+
+    const InetAddr *nm = addr->getNetmaskPtr();
+    if (nm == NULL) return false;
+    int length = nm->getLength();
+    // non-contiguous netmasks can not be represented by a range
+    if (InetAddrValue::netmask(af, length) != InetAddrValue(*nm)) return false;
+    addPrefix(v, length);
+    return true;
+}
+
+bool AddressRangeSet::contains(const InetAddrValue &a) const
+{
+    if (a.af != af) return false;
+    vector<InetRangeValue>::const_iterator i = upper_bound(
+        ranges.begin(), ranges.end(), a, rangeStartsAfter());
+    if (i == ranges.begin()) return false;
+    return (i-1)->contains(a);
+}
+
+bool AddressRangeSet::contains(const AddressRangeSet &other) const
+{
+    return other.subtract(*this).empty();
+}
+
+AddressRangeSet AddressRangeSet::unite(const AddressRangeSet &other) const
+{
+    assert(other.af == af);
+    AddressRangeSet res(af);
+    vector<InetRangeValue>::const_iterator i = ranges.begin();
+    vector<InetRangeValue>::const_iterator j = other.ranges.begin();
+    while (i != ranges.end() || j != other.ranges.end())
+    {
+        if (j == other.ranges.end() ||
+            (i != ranges.end() && i->first < j->first))
+            appendRange(res.ranges, *i++);
+        else
+            appendRange(res.ranges, *j++);
+    }
+    return res;
+}
+
+AddressRangeSet AddressRangeSet::intersect(const AddressRangeSet &other) const
+{
+    assert(other.af == af);
+    AddressRangeSet res(af);
+    vector<InetRangeValue>::const_iterator i = ranges.begin();
+    vector<InetRangeValue>::const_iterator j = other.ranges.begin();
+    while (i != ranges.end() && j != other.ranges.end())
+    {
+        InetAddrValue first = (i->first < j->first) ? j->first : i->first;
+        InetAddrValue last = (i->last < j->last) ? i->last : j->last;
+        if (first <= last) res.ranges.push_back(InetRangeValue(first, last));
+        if (i->last < j->last) ++i;
+        else ++j;
+    }
+    return res;
+}
+
+AddressRangeSet AddressRangeSet::subtract(const AddressRangeSet &other) const
+{
+    return intersect(other.complement());
+}
+
+AddressRangeSet AddressRangeSet::complement() const
+{
+    AddressRangeSet res(af);
+    InetAddrValue max = maxAddress();
+    InetAddrValue cur = minAddress();
+    for (vector<InetRangeValue>::const_iterator i=ranges.begin();
+         i!=ranges.end(); ++i)
+    {
+        if (cur < i->first)
+            res.ranges.push_back(InetRangeValue(cur, i->first.prev()));
+        if (i->last == max) return res;
+        cur = i->last.next();
+    }
+    res.ranges.push_back(InetRangeValue(cur, max));
+    return res;
+}
+
+/*
+ * Prefixes of the minimal cover can not span the gap between two
+ * ranges, so the cover of the set is the covers of its ranges put
+ * together. Each range is covered greedily: the largest prefix that
+ * starts at the first address not covered yet and does not go past
+ * the end of the range.
+ */
+vector<AddressRangeSet::Prefix> AddressRangeSet::toPrefixes() const
+{
+    vector<Prefix> res;
+    for (vector<InetRangeValue>::const_iterator i=ranges.begin();
+         i!=ranges.end(); ++i)
+    {
+        int bits = i->first.addressLengthBits();
+        InetAddrValue cur = i->first;
+        for (;;)
+        {
+            int length = bits - trailingZeros(cur);
+            InetAddrValue host = ~InetAddrValue::netmask(af, length);
+            while (!((cur | host) <= i->last))
+            {
+                length++;
+                host = ~InetAddrValue::netmask(af, length);
+            }
+            res.push_back(Prefix(cur, length));
+            InetAddrValue end = cur | host;
+            if (end == i->last) break;
+            cur = end.next();
+        }
+    }
+    return res;
+}
+
+int AddressRangeSet::countPrefixes() const
+{
+    return toPrefixes().size();
+}
+
+bool AddressRangeSet::operator==(const AddressRangeSet &other) const
+{
+    if (af != other.af || ranges.size() != other.ranges.size()) return false;
+    for (unsigned int n=0; n<ranges.size(); ++n)
+    {
+        if (ranges[n].first != other.ranges[n].first ||
+            ranges[n].last != other.ranges[n].last) return false;
+    }
+    return true;
+}
+
+string AddressRangeSet::toString() const
+{
+    ostringstream str;
+    for (vector<InetRangeValue>::const_iterator i=ranges.begin();
+         i!=ranges.end(); ++i)
+    {
+        if (i != ranges.begin()) str << " ";
+        str << i->first.toInetAddr().toString();
+        if (i->first != i->last)
+            str << "-" << i->last.toInetAddr().toString();
+    }
+    return str.str();
+}
@@ -0,0 +1,133 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __ADDRESS_RANGE_SET_HH__
+#define __ADDRESS_RANGE_SET_HH__
+
+#include "fwbuilder/InetAddrValue.h"
+
+#include <string>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+    class FWObject;
+};
+
+namespace fwcompiler
+{
+
+    /**
+     * Set of addresses of one address family, kept as a sorted list
+     * of disjoint inclusive ranges. Ranges never overlap or touch, so
+     * two sets hold the same addresses if and only if their lists are
+     * equal. Supports union, intersection, difference and complement
+     * and converts the set to the minimal list of CIDR prefixes that
+     * covers exactly the same addresses.
+     */
+    class AddressRangeSet
+    {
+        public:
+
+        class Prefix
+        {
+            public:
+            libfwbuilder::InetAddrValue address;
+            int length;
+
+            Prefix(const libfwbuilder::InetAddrValue &a, int len)
+            {
+                address = a;
+                length = len;
+            }
+        };
+
+        private:
+
+        int af;
+        std::vector<libfwbuilder::InetRangeValue> ranges;
+
+        libfwbuilder::InetAddrValue minAddress() const;
+        libfwbuilder::InetAddrValue maxAddress() const;
+
+        public:
+
+        explicit AddressRangeSet(int address_family=AF_INET)
+        { af = address_family; }
+
+        int addressFamily() const { return af; }
+        bool empty() const { return ranges.empty(); }
+        const std::vector<libfwbuilder::InetRangeValue>& getRanges() const
+        { return ranges; }
+
+        /**
+         * adds all addresses from first to last inclusive. Both
+         * addresses must belong to the address family of the set
+         */
+        void addRange(const libfwbuilder::InetAddrValue &first,
+                      const libfwbuilder::InetAddrValue &last);
+
+        /**
+         * adds subnet address/length. Host bits of the address are
+         * ignored, like the firewall does when it matches the subnet
+         */
+        void addPrefix(const libfwbuilder::InetAddrValue &address, int length);
+
+        /**
+         * adds addresses matched by an IPv4, IPv6, Network,
+         * NetworkIPv6 or AddressRange object. Returns false and leaves
+         * the set unchanged if the object is not one of these or
+         * belongs to the other address family.
+         */
+        bool addObject(libfwbuilder::FWObject *obj);
+
+        bool contains(const libfwbuilder::InetAddrValue &a) const;
+        bool contains(const AddressRangeSet &other) const;
+
+        AddressRangeSet unite(const AddressRangeSet &other) const;
+        AddressRangeSet intersect(const AddressRangeSet &other) const;
+        AddressRangeSet subtract(const AddressRangeSet &other) const;
+        AddressRangeSet complement() const;
+
+        /**
+         * returns the shortest list of prefixes that together match
+         * exactly the addresses of the set, sorted by address
+         */
+        std::vector<Prefix> toPrefixes() const;
+
+        /**
+         * number of prefixes toPrefixes() would return
+         */
+        int countPrefixes() const;
+
+        bool operator==(const AddressRangeSet &other) const;
+        bool operator!=(const AddressRangeSet &other) const
+        { return !(*this == other); }
+
+        std::string toString() const;
+    };
+
+};
+
+#endif
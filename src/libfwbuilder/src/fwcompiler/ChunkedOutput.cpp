@@ -0,0 +1,475 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "ChunkedOutput.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifndef _WIN32
+#  include <sys/uio.h>
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include <algorithm>
+
+using namespace fwcompiler;
+using namespace std;
+
+#ifndef IOV_MAX
+#  define IOV_MAX 1024
+#endif
+
+#ifndef _WIN32
+
+typedef struct iovec IoPiece;
+
+static ssize_t writePieces(int fd, IoPiece *pieces, size_t count)
+{
+    return writev(fd, pieces, count);
+}
+
+#else
+
+/*
+ * There is no writev() on windows, write the pieces one by one. Returns
+ * the number of bytes written, like writev() it may stop in the middle
+ * of a piece.
+ */
+typedef struct
+{
+    void *iov_base;
+    size_t iov_len;
+} IoPiece;
+
+static ssize_t writePieces(int fd, IoPiece *pieces, size_t count)
+{
+    ssize_t total = 0;
+    for (size_t i=0; i<count; ++i)
+    {
+        int n = write(fd, pieces[i].iov_base, pieces[i].iov_len);
+        if (n < 0) return (total > 0) ? total : -1;
+        total += n;
+        if (size_t(n) < pieces[i].iov_len) break;
+    }
+    return total;
+}
+
+#endif
+
+/*
+ * First chunk is small because many compilers produce only a few
+ * lines, chunks grow up to MAX_CHUNK_SIZE for large outputs.
+ */
+static const size_t FIRST_CHUNK_SIZE = 1024;
+static const size_t MAX_CHUNK_SIZE = 64 * 1024;
+
+static const char spaces[] = "                                ";
+static const int spaces_len = sizeof(spaces) - 1;
+
+
+/*
+ * Receives pieces of text in the order they appear in the output.
+ */
+class PieceEmitter
+{
+public:
+    virtual ~PieceEmitter() {}
+    virtual void emit(const char *data, size_t len) = 0;
+};
+
+class StringEmitter : public PieceEmitter
+{
+    string &res;
+public:
+    StringEmitter(string &r) : res(r) {}
+    virtual void emit(const char *data, size_t len) { res.append(data, len); }
+};
+
+/*
+ * Collects pieces in an array and writes them with one writev() call
+ * when the array is full. Remembers errno of the first failed write and ignores the
+ * rest of the text after that.
+ */
+class FileEmitter : public PieceEmitter
+{
+    int fd;
+    vector<IoPiece> iov;
+
+public:
+    int error;
+
+    FileEmitter(int f) : fd(f), error(0) { iov.reserve(IOV_MAX); }
+
+    virtual void emit(const char *data, size_t len)
+    {
+        if (len == 0 || error) return;
+        IoPiece v;
+        v.iov_base = (void*)data;
+        v.iov_len = len;
+        iov.push_back(v);
+        if (iov.size() == size_t(IOV_MAX)) flush();
+    }
+
+    void flush()
+    {
+        size_t first = 0;
+        while (first < iov.size() && error == 0)
+        {
+            ssize_t n = writePieces(fd, &iov[first], iov.size() - first);
+            if (n < 0)
+            {
+                if (errno != EINTR) error = errno;
+                continue;
+            }
+            // skip what was written, writev may stop in the middle
+            // of a piece
+            while (first < iov.size() && size_t(n) >= iov[first].iov_len)
+            {
+                n -= iov[first].iov_len;
+                first++;
+            }
+            if (first < iov.size())
+            {
+                iov[first].iov_base = (char*)iov[first].iov_base + n;
+                iov[first].iov_len -= n;
+            }
+        }
+        iov.clear();
+    }
+};
+
+static void emitIndent(PieceEmitter &out, int indent)
+{
+    for (; indent > spaces_len; indent -= spaces_len) out.emit(spaces, spaces_len);
+    out.emit(spaces, indent);
+}
+
+/*
+ * Passes text of the segments to the emitter, adding indentation to
+ * indented segments. Indentation is added only in front of non-empty
+ * lines, the same way CompilerDriver::indent() does it.
+ */
+static void emitSegments(const vector<ChunkedOutputBuf::Segment> &segments,
+                         PieceEmitter &out)
+{
+    bool at_line_start = true;
+    for (vector<ChunkedOutputBuf::Segment>::const_iterator it=segments.begin();
+         it!=segments.end(); ++it)
+    {
+        const char *data = it->chunk->data;
+        size_t pos = it->begin;
+
+        if (it->indent == 0 && it->first_line_indent == 0 &&
+            it->mid_line_indent == 0)
+        {
+            out.emit(data + pos, it->end - pos);
+            if (it->end > pos) at_line_start = (data[it->end - 1] == '\n');
+            continue;
+        }
+
+        int first_indent = (at_line_start) ?
+            it->first_line_indent : it->mid_line_indent;
+        bool first_line = true;
+        while (pos < it->end)
+        {
+            if (data[pos] != '\n')
+            {
+                if (first_line) emitIndent(out, first_indent);
+                else if (at_line_start) emitIndent(out, it->indent);
+            }
+            const char *nl = (const char*)memchr(data + pos, '\n', it->end - pos);
+            size_t line_end = (nl) ? nl - data + 1 : it->end;
+            out.emit(data + pos, line_end - pos);
+            at_line_start = (nl != NULL);
+            first_line = false;
+            pos = line_end;
+        }
+    }
+}
+
+
+ChunkedOutputBuf::ChunkedOutputBuf()
+{
+    current = NULL;
+    open_begin = 0;
+    committed = 0;
+    next_chunk_size = FIRST_CHUNK_SIZE;
+}
+
+ChunkedOutputBuf::~ChunkedOutputBuf()
+{
+    reset();
+}
+
+void ChunkedOutputBuf::release(Chunk *chunk)
+{
+    if (chunk && --(chunk->refs) == 0)
+    {
+        delete[] chunk->data;
+        delete chunk;
+    }
+}
+
+void ChunkedOutputBuf::reset()
+{
+    for (vector<Segment>::iterator it=segments.begin(); it!=segments.end(); ++it)
+        release(it->chunk);
+    vector<Segment>().swap(segments);
+    release(current);
+    current = NULL;
+    open_begin = 0;
+    committed = 0;
+    next_chunk_size = FIRST_CHUNK_SIZE;
+    setp(NULL, NULL);
+}
+
+void ChunkedOutputBuf::pushSegment(const Segment &seg)
+{
+    if (seg.end == seg.begin) return;
+    committed += seg.end - seg.begin;
+    if (!segments.empty())
+    {
+        Segment &last = segments.back();
+        if (last.chunk == seg.chunk && last.end == seg.begin &&
+            last.indent == seg.indent &&
+            seg.first_line_indent == seg.indent && seg.mid_line_indent == 0)
+        {
+            last.end = seg.end;
+            return;
+        }
+    }
+    seg.chunk->refs++;
+    segments.push_back(seg);
+}
+
+/*
+ * Text written since the last call is kept in the "open" segment
+ * that is not in the list yet. Move it to the list.
+ */
+void ChunkedOutputBuf::closeSegment()
+{
+    if (current == NULL) return;
+    Segment seg;
+    seg.chunk = current;
+    seg.begin = open_begin;
+    seg.end = pptr() - pbase();
+    seg.indent = 0;
+    seg.first_line_indent = 0;
+    seg.mid_line_indent = 0;
+    pushSegment(seg);
+    open_begin = seg.end;
+}
+
+void ChunkedOutputBuf::newChunk()
+{
+    closeSegment();
+    release(current);
+
+    current = new Chunk();
+    current->data = new char[next_chunk_size];
+    current->capacity = next_chunk_size;
+    current->refs = 1;
+    open_begin = 0;
+    setp(current->data, current->data + current->capacity);
+
+    next_chunk_size = min(next_chunk_size * 2, MAX_CHUNK_SIZE);
+}
+
+ChunkedOutputBuf::int_type ChunkedOutputBuf::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    newChunk();
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+streamsize ChunkedOutputBuf::xsputn(const char *s, streamsize n)
+{
+    streamsize done = 0;
+    while (done < n)
+    {
+        if (pptr() == epptr()) newChunk();
+        streamsize len = min(n - done, streamsize(epptr() - pptr()));
+        memcpy(pptr(), s + done, len);
+        pbump(len);
+        done += len;
+    }
+    return n;
+}
+
+/*
+ * Only supports tellp(), code that used std::stringstream relies on
+ * it to find out how much text has been written.
+ */
+ChunkedOutputBuf::pos_type ChunkedOutputBuf::seekoff(
+    off_type off, ios_base::seekdir way, ios_base::openmode which)
+{
+    if (off == 0 && way == ios_base::cur && (which & ios_base::out))
+        return pos_type(off_type(size()));
+    return pos_type(off_type(-1));
+}
+
+size_t ChunkedOutputBuf::size() const
+{
+    if (current == NULL) return committed;
+    return committed + (pptr() - pbase()) - open_begin;
+}
+
+void ChunkedOutputBuf::getSegments(vector<Segment> &res) const
+{
+    res = segments;
+    if (current != NULL && size_t(pptr() - pbase()) > open_begin)
+    {
+        Segment seg;
+        seg.chunk = current;
+        seg.begin = open_begin;
+        seg.end = pptr() - pbase();
+        seg.indent = 0;
+        seg.first_line_indent = 0;
+        seg.mid_line_indent = 0;
+        res.push_back(seg);
+    }
+}
+
+static bool isSpace(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+            c == '\v' || c == '\f');
+}
+
+void ChunkedOutputBuf::append(ChunkedOutputBuf &src, int indent, bool trim)
+{
+    if (&src == this) return;
+    closeSegment();
+    src.closeSegment();
+
+    vector<Segment> segs = src.segments;
+
+    if (trim)
+    {
+        // white space at the ends can span several segments
+        while (!segs.empty())
+        {
+            Segment &first = segs.front();
+            while (first.begin < first.end && isSpace(first.chunk->data[first.begin]))
+                first.begin++;
+            if (first.begin < first.end) break;
+            segs.erase(segs.begin());
+        }
+        while (!segs.empty())
+        {
+            Segment &last = segs.back();
+            while (last.end > last.begin && isSpace(last.chunk->data[last.end - 1]))
+                last.end--;
+            if (last.end > last.begin) break;
+            segs.pop_back();
+        }
+    }
+
+    /*
+     * Text of src starts at the beginning of a line, so its first line
+     * has already got first_line_indent spaces in src. append() keeps
+     * them wherever the text goes and adds its own indentation,
+     * appendTrimmed() drops both with the rest of leading white space.
+     */
+    for (vector<Segment>::iterator it=segs.begin(); it!=segs.end(); ++it)
+    {
+        Segment seg = *it;
+        seg.indent += indent;
+        if (it != segs.begin())
+            seg.first_line_indent += indent;
+        else if (trim)
+        {
+            seg.first_line_indent = 0;
+            seg.mid_line_indent = 0;
+        } else
+        {
+            seg.first_line_indent += indent;
+            seg.mid_line_indent = seg.first_line_indent;
+        }
+        pushSegment(seg);
+    }
+}
+
+void ChunkedOutputBuf::copyTo(string &res) const
+{
+    vector<Segment> segs;
+    getSegments(segs);
+    res.clear();
+    res.reserve(size());
+    StringEmitter out(res);
+    emitSegments(segs, out);
+}
+
+bool ChunkedOutputBuf::writeTo(int fd) const
+{
+    vector<Segment> segs;
+    getSegments(segs);
+    FileEmitter out(fd);
+    emitSegments(segs, out);
+    out.flush();
+    if (out.error)
+    {
+        errno = out.error;
+        return false;
+    }
+    return true;
+}
+
+
+string ChunkedOutput::str() const
+{
+    string res;
+    buf.copyTo(res);
+    return res;
+}
+
+void ChunkedOutput::str(const string &s)
+{
+    buf.reset();
+    clear();
+    write(s.data(), s.size());
+}
+
+void ChunkedOutput::append(ChunkedOutput &src, int indent)
+{
+    flush();
+    src.flush();
+    buf.append(src.buf, indent, false);
+}
+
+void ChunkedOutput::appendTrimmed(ChunkedOutput &src, int indent)
+{
+    flush();
+    src.flush();
+    buf.append(src.buf, indent, true);
+}
@@ -0,0 +1,169 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __CHUNKED_OUTPUT_HH__
+#define __CHUNKED_OUTPUT_HH__
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+namespace fwcompiler
+{
+
+    /**
+     * Stream buffer that keeps written text in a list of chunks.
+     * Unlike std::stringbuf it never reallocates and copies the text
+     * it already holds, and text of one buffer can be appended to
+     * another without copying: both share the chunks. Chunks are
+     * reference counted and freed when the last buffer that uses
+     * them is destroyed or reset.
+     */
+    class ChunkedOutputBuf : public std::streambuf
+    {
+        public:
+
+        class Chunk
+        {
+            public:
+            char *data;
+            size_t capacity;
+            int refs;
+        };
+
+        /**
+         * Part of the text in a chunk. Every non-empty line of the
+         * segment except the first one is written with indent spaces
+         * in front of it. The first line gets first_line_indent
+         * spaces if the text before the segment ends with a newline
+         * and mid_line_indent spaces otherwise. These differ from
+         * indent for the first segment of an appended stream: its
+         * first line is always indented by append() and never by
+         * appendTrimmed(), while indentation added to the stream it
+         * was appended to applies only at the beginning of a line.
+         */
+        class Segment
+        {
+            public:
+            Chunk *chunk;
+            size_t begin;
+            size_t end;
+            int indent;
+            int first_line_indent;
+            int mid_line_indent;
+        };
+
+        private:
+
+        std::vector<Segment> segments;
+        Chunk *current;
+        size_t open_begin;
+        size_t committed;
+        size_t next_chunk_size;
+
+        ChunkedOutputBuf(const ChunkedOutputBuf&);
+        ChunkedOutputBuf& operator=(const ChunkedOutputBuf&);
+
+        static void release(Chunk *chunk);
+        void newChunk();
+        void closeSegment();
+        void pushSegment(const Segment &seg);
+        void getSegments(std::vector<Segment> &res) const;
+
+        protected:
+
+        virtual int_type overflow(int_type c);
+        virtual std::streamsize xsputn(const char *s, std::streamsize n);
+        virtual pos_type seekoff(off_type off, std::ios_base::seekdir way,
+                                 std::ios_base::openmode which);
+
+        public:
+
+        ChunkedOutputBuf();
+        virtual ~ChunkedOutputBuf();
+
+        size_t size() const;
+        void reset();
+        void append(ChunkedOutputBuf &src, int indent, bool trim);
+        void copyTo(std::string &res) const;
+        bool writeTo(int fd) const;
+    };
+
+    /**
+     * Output stream for generated configuration. Compilers and
+     * drivers write to it as to any std::ostream, text of one stream
+     * can be added to another without copying and the result is
+     * written to a file with vectored I/O, so the whole generated
+     * script never has to exist in memory as one string.
+     */
+    class ChunkedOutput : public std::ostream
+    {
+        ChunkedOutputBuf buf;
+
+        public:
+
+        ChunkedOutput() : std::ostream(NULL) { rdbuf(&buf); }
+
+        size_t size() const { return buf.size(); }
+        bool empty() const { return buf.size() == 0; }
+
+        /**
+         * returns copy of the text
+         */
+        std::string str() const;
+
+        /**
+         * replaces text with s, the same as std::stringstream::str(s)
+         */
+        void str(const std::string &s);
+
+        /**
+         * adds text of src at the end of this stream without copying
+         * it. If indent is not zero, each non-empty line of src is
+         * prefixed with this many spaces when the stream is written
+         * out. src can be used after this, text added to it later
+         * does not appear here.
+         */
+        void append(ChunkedOutput &src, int indent=0);
+
+        /**
+         * the same as append() but drops white space at the beginning
+         * and the end of src and does not indent its first line. This
+         * is what Configlet does to values of variables: the text is
+         * trimmed and placed after the indentation of the line in the
+         * template where the variable is used.
+         */
+        void appendTrimmed(ChunkedOutput &src, int indent=0);
+
+        /**
+         * writes text to file descriptor fd. Returns false if write
+         * fails, errno is set in this case.
+         */
+        bool writeTo(int fd) const { return buf.writeTo(fd); }
+    };
+
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include <assert.h>
 
 #include "Compiler.h"
+#include "AddressRangeSet.h"
 
 #include "fwbuilder/AddressRange.h"
 #include "fwbuilder/Cluster.h"
@@ -61,6 +62,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <functional>
+#include <set>
 #include <fstream>
 #include <string>
 
@@ -114,7 +116,7 @@ void Compiler::warning(FWObject *rule, const string &errstr)
 
 int Compiler::getCompiledScriptLength()
 {
-    return int(output.tellp());
+    return int(output.size());
 }
 
 string Compiler::getCompiledScript() 
@@ -134,13 +136,23 @@ string Compiler::getCompiledScript()
     return res;
 }
 
+void Compiler::appendCompiledScript(ChunkedOutput &dest)
+{
+    dest.append(output);
+    output.str("");
+}
+
 void Compiler::_init(FWObjectDatabase *_db, Firewall *_fw)
 { 
     initialized = false;
     _cntr_ = 1; 
     group_registry = NULL;
+    group_expansion_generation = 0;
+    group_expansion_cache_hits = 0;
+    group_expansion_cache_misses = 0;
 
     temp_ruleset = NULL; 
+    keep_compiled_rules = false;
 
     debug = 0;
     debug_rule = -1;
@@ -207,9 +219,13 @@ Compiler::Compiler(FWObjectDatabase*, bool ipv6_policy)
     ipv6 = ipv6_policy;
     initialized = false;
     _cntr_ = 1; 
+    group_expansion_generation = 0;
+    group_expansion_cache_hits = 0;
+    group_expansion_cache_misses = 0;
     persistent_objects = NULL;
     fw = NULL; 
     temp_ruleset = NULL; 
+    keep_compiled_rules = false;
     debug = 0;
     debug_rule = -1;
     rule_debug_on = false;
@@ -276,6 +292,33 @@ void Compiler::compile()
     assert(fw);
 }
 
+/*
+ * special case: MultiAddress. This class inherits ObjectGroup, but
+ * should not be expanded if it is expanded at run time
+ *
+ * This is now redundant since we use class MultiAddressRunTime for
+ * run-time address tables
+ */
+bool Compiler::_is_expandable_group(FWObject *o)
+{
+    MultiAddress *adt = MultiAddress::cast(o);
+    return ((Group::cast(o)!=NULL && adt==NULL) ||
+            (adt!=NULL && adt->isCompileTime()));
+}
+
+/*
+ * Objects that are not groups end up in the rule element unless they
+ * are addresses of the wrong address family
+ */
+bool Compiler::_is_group_member_used(FWObject *o)
+{
+    if (o->getId() == FWObjectDatabase::ANY_ADDRESS_ID) return true;
+    Address *oaddr = Address::cast(o);
+    if (oaddr && oaddr->hasInetAddress()) return MatchesAddressFamily(o);
+    // not an address object at all
+    return true;
+}
+
 void Compiler::_expand_group_recursive(FWObject *o, list<FWObject*> &ol)
 {
 /*
@@ -285,48 +328,124 @@ void Compiler::_expand_group_recursive(FWObject *o, list<FWObject*> &ol)
  */
     if (FWOptions::cast(o)) return;
 
-/* special case: MultiAddress. This class inherits ObjectGroup, but
- * should not be expanded if it is expanded at run time
+    if (_is_expandable_group(o))
+    {
+        const list<FWObject*> &members = getExpandedGroupMembers(o);
+        for (list<FWObject*>::const_iterator i=members.begin();
+             i!=members.end(); ++i)
+        {
+            (*i)->ref();
+            ol.push_back(*i);
+        }
+    } else
+    {
+        if (_is_group_member_used(o))
+        {
+            o->ref();
+            ol.push_back(o);
+        }
+    }
+}
+
+/*
+ * The same group is often used in many rules, and each rule element
+ * referencing it used to walk its whole membership tree again. The
+ * flattened list is now built once per group; nested groups are
+ * cached too, so a group shared by several parents is walked only
+ * once as well.
  *
- * This is now redundant since we use class MultiAddressRunTime for
- * run-time address tables
+ * Compilers add and remove objects while rules are processed, so a
+ * cached list is used only if the group still has the same direct
+ * children and every nested group it includes is still the same
+ * version. Checking this looks at the direct children of each group
+ * only, which is much cheaper than building the list again.
  */
-    MultiAddress *adt = MultiAddress::cast(o);
+int Compiler::_group_child_id(FWObject *o)
+{
+    FWReference *ref = FWReference::cast(o);
+    if (ref) return ref->getPointerIdDirect();
+    return o->getId();
+}
 
-    if ((Group::cast(o)!=NULL && adt==NULL) ||
-        (adt!=NULL && adt->isCompileTime()))
+bool Compiler::_is_group_expansion_valid(FWObject *grp,
+                                         const GroupExpansion &exp)
+{
+    if (grp->size() != exp.children.size()) return false;
+
+    vector<int>::const_iterator c = exp.children.begin();
+    for (FWObject::iterator i=grp->begin(); i!=grp->end(); ++i, ++c)
     {
-	for (FWObject::iterator i2=o->begin(); i2!=o->end(); ++i2)
-        {
-            FWObject *o1 = FWReference::getObject(*i2);
-	    assert(o1);
+        if (_group_child_id(*i) != *c) return false;
+    }
 
-	    _expand_group_recursive(o1, ol);
-	}
-    } else
+    for (list<pair<FWObject*, int> >::const_iterator g=exp.subgroups.begin();
+         g!=exp.subgroups.end(); ++g)
+    {
+        map<int, GroupExpansion>::iterator it =
+            group_expansion_cache.find(g->first->getId());
+        if (it == group_expansion_cache.end()) return false;
+        if (it->second.generation != g->second) return false;
+        if (!_is_group_expansion_valid(g->first, it->second)) return false;
+    }
+    return true;
+}
+
+const list<FWObject*>& Compiler::getExpandedGroupMembers(FWObject *grp)
+{
+    map<int, GroupExpansion>::iterator it =
+        group_expansion_cache.find(grp->getId());
+    if (it != group_expansion_cache.end() &&
+        _is_group_expansion_valid(grp, it->second))
     {
-        if (o->getId() == FWObjectDatabase::ANY_ADDRESS_ID)
+        group_expansion_cache_hits++;
+        return it->second.members;
+    }
+    group_expansion_cache_misses++;
+
+    vector<int> children;
+    list<pair<FWObject*, int> > subgroups;
+    list<FWObject*> members;
+    for (FWObject::iterator i=grp->begin(); i!=grp->end(); ++i)
+    {
+        children.push_back(_group_child_id(*i));
+
+        FWObject *o = FWReference::getObject(*i);
+        assert(o);
+
+        if (FWOptions::cast(o)) continue;
+
+        if (_is_expandable_group(o))
         {
-            o->ref();
-            ol.push_back( o );
+            const list<FWObject*> &sub = getExpandedGroupMembers(o);
+            members.insert(members.end(), sub.begin(), sub.end());
+            subgroups.push_back(
+                make_pair(o, group_expansion_cache[o->getId()].generation));
         } else
         {
-            Address *oaddr = Address::cast(o);
-            if (oaddr && oaddr->hasInetAddress())
-            {
-                if (MatchesAddressFamily(o))
-                {
-                    o->ref();
-                    ol.push_back( o );
-                }
-            } else
-            {
-                // not an address object at all
-                o->ref();
-                ol.push_back( o );
-            }
+            if (_is_group_member_used(o)) members.push_back(o);
         }
     }
+
+    // sort is stable, objects with the same name keep the order in
+    // which they appear in the group
+    members.sort(FWObjectNameCmpPredicate());
+
+    GroupExpansion &exp = group_expansion_cache[grp->getId()];
+    exp.generation = ++group_expansion_generation;
+    exp.children.swap(children);
+    exp.subgroups.swap(subgroups);
+    exp.members.clear();
+    set<int> seen;
+    for (list<FWObject*>::iterator i=members.begin(); i!=members.end(); ++i)
+    {
+        if (seen.insert((*i)->getId()).second) exp.members.push_back(*i);
+    }
+    return exp.members;
+}
+
+void Compiler::resetGroupExpansionCache()
+{
+    group_expansion_cache.clear();
 }
 
 /*
@@ -706,6 +825,25 @@ void Compiler::runRuleProcessors()
     }
 
     while ((*j)->processNext()) ;
+
+    if (keep_compiled_rules)
+    {
+        compiled_rules.clear();
+        Rule *rule;
+        while ((rule = (*j)->getNextRule()) != NULL)
+            compiled_rules.push_back(rule);
+    }
+
+    if (verbose && group_expansion_cache_hits + group_expansion_cache_misses > 0)
+    {
+        ostringstream str;
+        str << " group expansion cache: "
+            << group_expansion_cache_hits << " hits, "
+            << group_expansion_cache_misses << " misses";
+        info(str.str());
+        group_expansion_cache_hits = 0;
+        group_expansion_cache_misses = 0;
+    }
 }
 
 void Compiler::deleteRuleProcessors()
@@ -1396,6 +1534,103 @@ bool Compiler::swapMultiAddressObjectsInRE::processNext()
     return true;
 }
 
+/*
+ * Objects of each address family are simplified separately. Objects
+ * that can not be simplified stay in the rule element in their
+ * original order, new networks and addresses follow them sorted by
+ * address. Prefix /0 is not generated, such sets are left as they
+ * are; some compilers treat network 0.0.0.0/0 in a special way.
+ */
+bool Compiler::simplifyAddressSetsInRE::processNext()
+{
+    Rule *rule = prev_processor->getNextRule(); if (rule==NULL) return false;
+    tmp_queue.push_back(rule);
+
+    FWOptions *fwopt = compiler->getCachedFwOpt();
+    if (fwopt == NULL || !fwopt->getBool("simplify_address_sets") ||
+        compiler->group_registry != NULL)
+        return true;
+
+    RuleElement *re = RuleElement::cast(rule->getFirstByType(re_type));
+    if (re == NULL || re->isAny()) return true;
+
+    int families[2] = { AF_INET, AF_INET6 };
+    AddressRangeSet sets[2] = {
+        AddressRangeSet(AF_INET), AddressRangeSet(AF_INET6) };
+    list<FWObject*> objects[2];
+
+    for (FWObject::iterator i=re->begin(); i!=re->end(); ++i)
+    {
+        FWObject *o = FWReference::getObject(*i);
+        if (Interface::cast(o->getParent()) != NULL) continue;
+        for (int n=0; n<2; ++n)
+        {
+            if (sets[n].addObject(o))
+            {
+                objects[n].push_back(o);
+                break;
+            }
+        }
+    }
+
+    set<FWObject*> replaced;
+    list<FWObject*> new_objects;
+    for (int n=0; n<2; ++n)
+    {
+        if (objects[n].empty()) continue;
+
+        vector<AddressRangeSet::Prefix> prefixes = sets[n].toPrefixes();
+        bool has_zero_prefix = false;
+        for (unsigned int k=0; k<prefixes.size(); ++k)
+            if (prefixes[k].length == 0) has_zero_prefix = true;
+
+        if (has_zero_prefix || prefixes.size() >= objects[n].size()) continue;
+
+        replaced.insert(objects[n].begin(), objects[n].end());
+
+        for (unsigned int k=0; k<prefixes.size(); ++k)
+        {
+            InetAddr addr = prefixes[k].address.toInetAddr();
+            int length = prefixes[k].length;
+            Address *obj;
+            if (length == prefixes[k].address.addressLengthBits())
+            {
+                if (families[n] == AF_INET) obj = compiler->dbcopy->createIPv4();
+                else obj = compiler->dbcopy->createIPv6();
+            } else
+            {
+                if (families[n] == AF_INET) obj = compiler->dbcopy->createNetwork();
+                else obj = compiler->dbcopy->createNetworkIPv6();
+            }
+            obj->setAddress(addr);
+            obj->setNetmask(InetAddr(families[n], length));
+            ostringstream name;
+            name << addr.toString() << "/" << length;
+            obj->setName(name.str());
+            compiler->persistent_objects->add(obj, false);
+            new_objects.push_back(obj);
+        }
+    }
+
+    if (replaced.empty()) return true;
+
+    list<FWObject*> kept;
+    for (FWObject::iterator i=re->begin(); i!=re->end(); ++i)
+    {
+        FWObject *o = FWReference::getObject(*i);
+        if (replaced.count(o) == 0) kept.push_back(o);
+    }
+
+    re->clearChildren();
+    for (list<FWObject*>::iterator i=kept.begin(); i!=kept.end(); ++i)
+        re->addRef(*i);
+    for (list<FWObject*>::iterator i=new_objects.begin();
+         i!=new_objects.end(); ++i)
+        re->addRef(*i);
+
+    return true;
+}
+
 bool Compiler::expandMultipleAddressesInRE::processNext()
 {
     Rule *rule = prev_processor->getNextRule(); if (rule==NULL) return false;
@@ -32,6 +32,7 @@
 #include "fwbuilder/FWException.h"
 
 #include "fwcompiler/BaseCompiler.h"
+#include "fwcompiler/ChunkedOutput.h"
 #include "fwcompiler/RuleProcessor.h"
 #include "fwcompiler/exceptions.h"
 #include "fwcompiler/GroupRegistry.h"
@@ -129,6 +130,9 @@ namespace fwcompiler {
         virtual void _expand_group_recursive(libfwbuilder::FWObject *o,
                                              std::list<libfwbuilder::FWObject*> &ol);
 
+        bool _is_expandable_group(libfwbuilder::FWObject *o);
+        bool _is_group_member_used(libfwbuilder::FWObject *o);
+
         virtual void _expand_addr_recursive(libfwbuilder::Rule *rule,
                                             libfwbuilder::FWObject *s,
                                             std::list<libfwbuilder::FWObject*> &ol,
@@ -154,9 +158,36 @@ protected:
         bool ipv6;
         std::map<int, bool> object_comparison_cache;
         std::map<int, threeTuple*> rule_elements_cache;
+
+        /*
+         * flattened, deduplicated and sorted members of a group along
+         * with what it was built from: ids of the direct children of
+         * the group and generations of the nested groups it includes.
+         * See getExpandedGroupMembers()
+         */
+        class GroupExpansion
+        {
+            public:
+            int generation;
+            std::vector<int> children;
+            std::list<std::pair<libfwbuilder::FWObject*, int> > subgroups;
+            std::list<libfwbuilder::FWObject*> members;
+        };
+
+        std::map<int, GroupExpansion> group_expansion_cache;
+        int group_expansion_generation;
+        int group_expansion_cache_hits;
+        int group_expansion_cache_misses;
+
+        static int _group_child_id(libfwbuilder::FWObject *o);
+        bool _is_group_expansion_valid(libfwbuilder::FWObject *grp,
+                                       const GroupExpansion &exp);
         
         std::list<BasicRuleProcessor*> rule_processors;
 
+        bool keep_compiled_rules;
+        std::list<libfwbuilder::Rule*> compiled_rules;
+
         /**
          * if object <o> is Address, check if it matches address family
          * (i.e. if it is IPv6 or IPv4). If it is service, always return true.
@@ -242,7 +273,7 @@ public:
 
         libfwbuilder::Group *temp;
 
-	std::stringstream output;
+	ChunkedOutput output;
 
         void registerGroupObject(libfwbuilder::RuleElement *re,
                                  libfwbuilder::ObjectGroup *grp);
@@ -280,6 +311,23 @@ public:
                                const libfwbuilder::Service &o2);
         void resetObjectComparisonCache() { object_comparison_cache.clear(); }
 
+        /**
+         * returns all objects group <grp> expands to, with nested
+         * groups expanded recursively, duplicates removed and sorted
+         * by name. The result is computed once per group and shared
+         * by all rule elements that use it, so the list must not be
+         * modified. It is built again if the group or any group nested
+         * in it has changed since, so the reference is valid only
+         * until the next call.
+         */
+        const std::list<libfwbuilder::FWObject*>& getExpandedGroupMembers(
+            libfwbuilder::FWObject *grp);
+
+        /**
+         * drops cached group expansions.
+         */
+        void resetGroupExpansionCache();
+
 	/**
 	 *   a method to check for unnumbered interface in a rule
 	 *   element (one can not use unnumbered interfaces in rules).
@@ -494,6 +542,27 @@ public:
             virtual bool processNext();
         };
 
+        /**
+         * Replaces addresses, networks and address ranges in rule
+         * element 're_type' with the smallest set of networks and
+         * addresses that matches the same addresses, see class
+         * AddressRangeSet. Objects that belong to interfaces of
+         * hosts and firewalls are left alone, so are all objects of
+         * an address family if the result would not be shorter.
+         * Active only if firewall option "simplify_address_sets" is
+         * on and the compiler does not use group registry. Call after
+         * groups, ranges and multiple addresses have been expanded.
+         */
+        class simplifyAddressSetsInRE : public BasicRuleProcessor
+        {
+            std::string re_type;
+            public:
+            simplifyAddressSetsInRE(const std::string &name,
+                                    const std::string &t) :
+                BasicRuleProcessor(name) { re_type=t; }
+            virtual bool processNext();
+        };
+
         /**
          *  this inspector replaces references to hosts and firewalls
          *  in rule element with references to their interfaces
@@ -1039,7 +1108,26 @@ public:
 	std::string getCompiledScript();
         int getCompiledScriptLength();
 
+        /**
+         * adds generated code to the end of dest without copying it
+         * and clears it in the compiler, like getCompiledScript()
+         */
+        void appendCompiledScript(ChunkedOutput &dest);
+
         void setGroupRegistry(GroupRegistry *gr) { group_registry = gr; }
+
+        /**
+         * If set, runRuleProcessors() keeps rules that come out of
+         * the last rule processor so that tools can look at the rules
+         * the way they were printed, for example with chain and
+         * target assigned by iptables compiler. Only the last run of
+         * rule processors is kept. Rules belong to the compiler's
+         * working copy of the object database and stay valid as long
+         * as it exists.
+         */
+        void setKeepCompiledRules(bool f) { keep_compiled_rules = f; }
+        const std::list<libfwbuilder::Rule*>& getCompiledRules() const
+        { return compiled_rules; }
         
         void expandGroup(libfwbuilder::FWObject *grp,
                          std::list<libfwbuilder::FWObject*> &ol);
@@ -33,6 +33,7 @@
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Network.h"
 #include "fwbuilder/AddressRange.h"
+#include "fwbuilder/InetAddrValue.h"
 #include "fwbuilder/IPService.h"
 #include "fwbuilder/ICMPService.h"
 #include "fwbuilder/TCPUDPService.h"
@@ -568,9 +569,9 @@ bool Compiler::checkForShadowing(const Address &o1,const Address &o2)
     if (o1.isAny() && !o2.isAny()) RETURN(false);
     if (!o1.isAny() && o2.isAny()) RETURN(true);
 
-    bool res = ( ((*o2b) < (*o1b) || (*o1b) == (*o2b)) &&
-                 ((*o1e) < (*o2e) || (*o1e) == (*o2e)) );
-    RETURN(res);
+    InetRangeValue r1 = InetRangeValue(InetAddrValue(*o1b), InetAddrValue(*o1e));
+    InetRangeValue r2 = InetRangeValue(InetAddrValue(*o2b), InetAddrValue(*o2e));
+    RETURN(r2.contains(r1));
 }
 
 bool Compiler::intersect(PolicyRule &r1, PolicyRule &r2)
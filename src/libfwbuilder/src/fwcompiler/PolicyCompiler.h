@@ -539,6 +539,24 @@ namespace fwcompiler {
                 swapMultiAddressObjectsInRE(n,libfwbuilder::RuleElementDst::TYPENAME) {}
         };
 
+        /**
+         * rule processors that replace addresses in Src and Dst with
+         * the minimal equivalent set of networks
+         */
+        class simplifyAddressSetsInSrc : public Compiler::simplifyAddressSetsInRE
+        {
+            public:
+            simplifyAddressSetsInSrc(const std::string &n) :
+                simplifyAddressSetsInRE(n,libfwbuilder::RuleElementSrc::TYPENAME) {}
+        };
+
+        class simplifyAddressSetsInDst : public Compiler::simplifyAddressSetsInRE
+        {
+            public:
+            simplifyAddressSetsInDst(const std::string &n) :
+                simplifyAddressSetsInRE(n,libfwbuilder::RuleElementDst::TYPENAME) {}
+        };
+
         class RegisterGroupsAndTablesInSrc : public RegisterGroupsAndTablesInRE
         {
             public:
@@ -0,0 +1,309 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "PolicyDecisionMap.h"
+
+#include "fwbuilder/FWException.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+namespace
+{
+
+    class Boundary
+    {
+        public:
+        InetAddrValue pos;
+        int model;
+        int index;
+        bool start;
+
+        Boundary(const InetAddrValue &p, int m, int i, bool s) :
+            pos(p), model(m), index(i), start(s) {}
+
+        bool operator<(const Boundary &o) const { return pos < o.pos; }
+    };
+
+    /*
+     * Walks the decision map of one or two models at once. Lists of
+     * candidate terms are kept separately for each model, a leaf is
+     * reached when the first candidate of each model matches
+     * anything in the remaining fields.
+     */
+    class MapWalker
+    {
+        public:
+
+        const PolicyModel &model;
+        const vector<PolicyModel::Term> *terms[2];
+        int n_models;
+        AddressRangeSet path[PolicyModel::DIMENSIONS];
+        bool stopped;
+
+        MapWalker(const PolicyModel &m) : model(m)
+        {
+            terms[0] = terms[1] = NULL;
+            n_models = 0;
+            stopped = false;
+        }
+        virtual ~MapWalker() {}
+
+        virtual void leaf(int term_a, int term_b) = 0;
+
+        void start();
+        void walk(int d, const vector<int> *lists);
+    };
+
+};
+
+
+void MapWalker::start()
+{
+    vector<int> lists[2];
+    for (int m=0; m<n_models; ++m)
+    {
+        for (unsigned n=0; n<terms[m]->size(); ++n)
+        {
+            lists[m].push_back(n);
+            if ((*terms[m])[n].any_from == 0) break;
+        }
+    }
+    walk(0, lists);
+}
+
+void MapWalker::walk(int d, const vector<int> *lists)
+{
+    if (stopped) return;
+
+    bool decided = true;
+    int first[2] = { -1, -1 };
+    for (int m=0; m<n_models; ++m)
+    {
+        if (lists[m].empty()) continue;
+        first[m] = lists[m].front();
+        if ((*terms[m])[first[m]].any_from > d) decided = false;
+    }
+    if (decided)
+    {
+        for (int k=d; k<PolicyModel::DIMENSIONS; ++k)
+            path[k] = model.getDomain(PolicyModel::Dimension(k));
+        leaf(first[0], first[1]);
+        return;
+    }
+
+    const vector<InetRangeValue> &dom =
+        model.getDomain(PolicyModel::Dimension(d)).getRanges();
+    InetAddrValue dom_first = dom.front().first;
+    InetAddrValue dom_last = dom.back().last;
+
+    vector<Boundary> boundaries;
+    for (int m=0; m<n_models; ++m)
+    {
+        for (unsigned n=0; n<lists[m].size(); ++n)
+        {
+            const vector<InetRangeValue> &ranges =
+                (*terms[m])[lists[m][n]].field[d].getRanges();
+            for (vector<InetRangeValue>::const_iterator r=ranges.begin();
+                 r!=ranges.end(); ++r)
+            {
+                boundaries.push_back(Boundary(r->first, m, n, true));
+                if (r->last != dom_last)
+                    boundaries.push_back(Boundary(r->last.next(), m, n, false));
+            }
+        }
+    }
+    stable_sort(boundaries.begin(), boundaries.end());
+
+    // candidate lists for each elementary interval, intervals with
+    // the same lists are merged into one group
+    typedef pair<vector<int>, vector<int> > Key;
+    map<Key, int> group_index;
+    vector<Key> groups;
+    vector<AddressRangeSet> group_sets;
+
+    set<int> active[2];
+    InetAddrValue pos = dom_first;
+    vector<Boundary>::iterator b = boundaries.begin();
+    for (;;)
+    {
+        while (b != boundaries.end() && b->pos == pos)
+        {
+            if (b->start) active[b->model].insert(b->index);
+            else active[b->model].erase(b->index);
+            ++b;
+        }
+
+        InetAddrValue last = (b == boundaries.end()) ? dom_last : b->pos.prev();
+
+        Key key;
+        vector<int> *sub[2] = { &key.first, &key.second };
+        for (int m=0; m<n_models; ++m)
+        {
+            for (set<int>::iterator i=active[m].begin(); i!=active[m].end(); ++i)
+            {
+                int t = lists[m][*i];
+                sub[m]->push_back(t);
+                if ((*terms[m])[t].any_from <= d + 1) break;
+            }
+        }
+
+        map<Key, int>::iterator g = group_index.find(key);
+        int n;
+        if (g == group_index.end())
+        {
+            n = groups.size();
+            group_index[key] = n;
+            groups.push_back(key);
+            group_sets.push_back(AddressRangeSet(dom_first.af));
+        } else
+            n = g->second;
+        group_sets[n].addRange(pos, last);
+
+        if (b == boundaries.end()) break;
+        pos = b->pos;
+    }
+
+    for (unsigned n=0; n<groups.size() && !stopped; ++n)
+    {
+        vector<int> sub[2];
+        sub[0] = groups[n].first;
+        sub[1] = groups[n].second;
+        path[d] = group_sets[n];
+        walk(d + 1, sub);
+    }
+}
+
+
+namespace
+{
+
+    class MapBuilder : public MapWalker
+    {
+        public:
+        vector<PolicyDecisionMap::Region> &res;
+
+        MapBuilder(const PolicyModel &m, vector<PolicyDecisionMap::Region> &r) :
+            MapWalker(m), res(r)
+        {
+            terms[0] = &m.getTerms();
+            n_models = 1;
+        }
+
+        virtual void leaf(int term_a, int)
+        {
+            PolicyDecisionMap::Region region;
+            for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+                region.field[d] = path[d];
+            region.decision = PolicyModel::NO_DECISION;
+            region.rule = -1;
+            if (term_a >= 0)
+            {
+                region.decision = (*terms[0])[term_a].decision;
+                region.rule = (*terms[0])[term_a].rule;
+            }
+            res.push_back(region);
+        }
+    };
+
+    class MapComparator : public MapWalker
+    {
+        public:
+        vector<PolicyDecisionMap::Difference> &diffs;
+        int max_differences;
+        bool equal;
+
+        MapComparator(const PolicyModel &a, const PolicyModel &b,
+                      vector<PolicyDecisionMap::Difference> &d, int max_diff) :
+            MapWalker(a), diffs(d)
+        {
+            terms[0] = &a.getTerms();
+            terms[1] = &b.getTerms();
+            n_models = 2;
+            max_differences = max_diff;
+            equal = true;
+        }
+
+        virtual void leaf(int term_a, int term_b)
+        {
+            PolicyModel::Decision da = PolicyModel::NO_DECISION;
+            PolicyModel::Decision db = PolicyModel::NO_DECISION;
+            if (term_a >= 0) da = (*terms[0])[term_a].decision;
+            if (term_b >= 0) db = (*terms[1])[term_b].decision;
+            if (da == db) return;
+
+            equal = false;
+            if (int(diffs.size()) >= max_differences)
+            {
+                stopped = true;
+                return;
+            }
+
+            PolicyModel::Packet p(model.addressFamily());
+            for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+                p.value[d] = path[d].getRanges().front().first;
+
+            PolicyDecisionMap::Difference diff(p);
+            diff.decision_a = da;
+            diff.decision_b = db;
+            diff.rule_a = (term_a >= 0) ? (*terms[0])[term_a].rule : -1;
+            diff.rule_b = (term_b >= 0) ? (*terms[1])[term_b].rule : -1;
+            diffs.push_back(diff);
+            if (int(diffs.size()) >= max_differences) stopped = true;
+        }
+    };
+
+};
+
+
+void PolicyDecisionMap::build(const PolicyModel &model, vector<Region> &res)
+{
+    MapBuilder builder(model, res);
+    builder.start();
+}
+
+bool PolicyDecisionMap::compare(const PolicyModel &a, const PolicyModel &b,
+                                vector<Difference> &diffs, int max_differences)
+{
+    if (a.addressFamily() != b.addressFamily())
+        throw FWException("Can not compare policy models of different "
+                          "address families");
+    bool same_interfaces = (a.countInterfaces() == b.countInterfaces());
+    for (int n=1; n<=a.countInterfaces() && same_interfaces; ++n)
+        same_interfaces = (a.getInterfaceName(n) == b.getInterfaceName(n));
+    if (!same_interfaces)
+        throw FWException("Can not compare policy models of firewalls "
+                          "with different interfaces");
+
+    MapComparator comparator(a, b, diffs, max_differences);
+    comparator.start();
+    return comparator.equal;
+}
@@ -0,0 +1,95 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __POLICY_DECISION_MAP_HH__
+#define __POLICY_DECISION_MAP_HH__
+
+#include "fwcompiler/PolicyModel.h"
+
+#include <vector>
+
+
+namespace fwcompiler
+{
+
+    /**
+     * Decision map of a policy model: the packet header space cut
+     * into regions, each region is decided by one rule or falls
+     * through the policy. Two models are equivalent if their maps
+     * give the same decision everywhere.
+     *
+     * The map is built one header field at a time. Boundaries of the
+     * terms in the field cut it into elementary intervals; intervals
+     * matched by the same list of terms are merged and the next
+     * field is split only for the terms in that list. A term that
+     * matches anything in all remaining fields shadows the terms
+     * after it, so they are dropped from the list. This keeps the
+     * number of regions close to the number of rules for typical
+     * policies and lets the check scale to tens of thousands of rules.
+     */
+    class PolicyDecisionMap
+    {
+        public:
+
+        class Region
+        {
+            public:
+            AddressRangeSet field[PolicyModel::DIMENSIONS];
+            PolicyModel::Decision decision;
+            // number of the deciding rule in the model, -1 if none
+            int rule;
+        };
+
+        class Difference
+        {
+            public:
+            PolicyModel::Packet packet;
+            PolicyModel::Decision decision_a;
+            PolicyModel::Decision decision_b;
+            int rule_a;
+            int rule_b;
+
+            Difference(const PolicyModel::Packet &p) : packet(p) {}
+        };
+
+        /**
+         * builds the decision map of the model
+         */
+        static void build(const PolicyModel &model, std::vector<Region> &res);
+
+        /**
+         * compares two models built for the same firewall and address
+         * family. Returns true if they give the same decision for
+         * every packet. Otherwise adds up to max_differences sample
+         * packets from the regions where the decisions differ to
+         * diffs. Throws FWException if models have different address
+         * family or interfaces.
+         */
+        static bool compare(const PolicyModel &a, const PolicyModel &b,
+                            std::vector<Difference> &diffs,
+                            int max_differences=10);
+    };
+
+};
+
+#endif
@@ -0,0 +1,692 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "PolicyModel.h"
+
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Group.h"
+#include "fwbuilder/Host.h"
+#include "fwbuilder/ICMP6Service.h"
+#include "fwbuilder/ICMPService.h"
+#include "fwbuilder/IPService.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/MultiAddress.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/NetworkIPv6.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/RuleSet.h"
+#include "fwbuilder/TCPService.h"
+#include "fwbuilder/UDPService.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+static AddressRangeSet scalarRange(int first, int last)
+{
+    AddressRangeSet s(AF_INET);
+    if (first <= last)
+        s.addRange(InetAddrValue(AF_INET, 0, first),
+                   InetAddrValue(AF_INET, 0, last));
+    return s;
+}
+
+/*
+ * Ports as TCPService and UDPService keep them: 0,0 means any port,
+ * start with end 0 means single port
+ */
+static AddressRangeSet portRange(int rs, int re)
+{
+    if (rs < 0) rs = 0;
+    if (re < 0) re = 0;
+    if (rs == 0 && re == 0) return scalarRange(0, 65535);
+    if (re == 0) re = rs;
+    return scalarRange(rs, re);
+}
+
+/*
+ * Element without children prints as no match at all, which is the
+ * same as any
+ */
+static bool matchesAny(RuleElement *re)
+{
+    return (re == NULL || re->isAny() || re->getChildrenCount() == 0);
+}
+
+
+
+/*
+ * Adds a - b to res. a is cut into at most one box per field: the
+ * part of a that differs from b in this field and agrees with b in
+ * all fields before it.
+ */
+void PolicyModel::subtractTerm(const Term &a, const Term &b, vector<Term> &res)
+{
+    Term prefix = a;
+    for (int d=0; d<DIMENSIONS; ++d)
+    {
+        AddressRangeSet diff = prefix.field[d].subtract(b.field[d]);
+        if (!diff.empty())
+        {
+            Term piece = prefix;
+            piece.field[d] = diff;
+            res.push_back(piece);
+        }
+        prefix.field[d] = prefix.field[d].intersect(b.field[d]);
+        if (prefix.field[d].empty()) return;
+    }
+}
+
+void PolicyModel::intersectTerms(const vector<Term> &a, const vector<Term> &b,
+                                 vector<Term> &res)
+{
+    for (vector<Term>::const_iterator t=a.begin(); t!=a.end(); ++t)
+    {
+        for (vector<Term>::const_iterator c=b.begin(); c!=b.end(); ++c)
+        {
+            Term r = *t;
+            bool empty = false;
+            for (int d=0; d<DIMENSIONS && !empty; ++d)
+            {
+                r.field[d] = r.field[d].intersect(c->field[d]);
+                empty = r.field[d].empty();
+            }
+            if (!empty) res.push_back(r);
+        }
+    }
+}
+
+PolicyModel::Packet::Packet(int address_family)
+{
+    for (int d=0; d<DIMENSIONS; ++d)
+        value[d] = InetAddrValue(AF_INET, 0, 0);
+    value[SRC] = InetAddrValue(address_family, 0, 0);
+    value[DST] = InetAddrValue(address_family, 0, 0);
+}
+
+void PolicyModel::Packet::set(Dimension d, int v)
+{
+    value[d] = InetAddrValue(AF_INET, 0, v);
+}
+
+bool PolicyModel::Term::contains(const Packet &p) const
+{
+    for (int d=0; d<any_from; ++d)
+        if (!field[d].contains(p.value[d])) return false;
+    return true;
+}
+
+PolicyModel::PolicyModel(Firewall *fw, int address_family)
+{
+    af = address_family;
+
+    list<FWObject*> all_interfaces = fw->getByTypeDeep(Interface::TYPENAME);
+    for (list<FWObject*>::iterator i=all_interfaces.begin();
+         i!=all_interfaces.end(); ++i)
+        interfaces.push_back((*i)->getName());
+    sort(interfaces.begin(), interfaces.end());
+    interfaces.erase(unique(interfaces.begin(), interfaces.end()),
+                     interfaces.end());
+    for (unsigned n=0; n<interfaces.size(); ++n)
+        interface_index[interfaces[n]] = n + 1;
+
+    domain[IN_ITF] = scalarRange(0, interfaces.size());
+    domain[OUT_ITF] = domain[IN_ITF];
+    domain[PROTO] = scalarRange(0, 255);
+    domain[SRC] = AddressRangeSet(af).complement();
+    domain[DST] = domain[SRC];
+    domain[SRC_PORT] = scalarRange(0, 65535);
+    domain[DST_PORT] = domain[SRC_PORT];
+}
+
+int PolicyModel::getInterfaceIndex(const string &name) const
+{
+    map<string, int>::const_iterator i = interface_index.find(name);
+    return (i == interface_index.end()) ? 0 : i->second;
+}
+
+string PolicyModel::getInterfaceName(int n) const
+{
+    if (n < 1 || n > int(interfaces.size())) return "-";
+    return interfaces[n - 1];
+}
+
+string PolicyModel::getRuleLabel(int n) const
+{
+    if (n < 0 || n >= int(rules.size())) return "default";
+    Rule *rule = rules[n];
+    ostringstream str;
+    if (rule->getParent()) str << rule->getParent()->getName() << " ";
+    str << "rule " << rule->getPosition();
+    return str.str();
+}
+
+void PolicyModel::warning(Rule *rule, const string &msg)
+{
+    ostringstream str;
+    if (rule->getParent()) str << rule->getParent()->getName() << " ";
+    str << "rule " << rule->getPosition() << ": " << msg;
+    warnings.push_back(str.str());
+}
+
+void PolicyModel::finishTerm(Term &t)
+{
+    t.any_from = DIMENSIONS;
+    while (t.any_from > 0 && t.field[t.any_from - 1] == domain[t.any_from - 1])
+        t.any_from--;
+}
+
+void PolicyModel::expandAddress(Rule *rule, FWObject *obj,
+                                AddressRangeSet &res)
+{
+    FWObject *o = FWReference::getObject(obj);
+
+    if (res.addObject(o)) return;
+
+    int obj_af = -1;
+    if (IPv4::isA(o) || Network::isA(o)) obj_af = AF_INET;
+    if (IPv6::isA(o) || NetworkIPv6::isA(o)) obj_af = AF_INET6;
+    if (AddressRange::isA(o))
+        obj_af = AddressRange::cast(o)->getRangeStart().addressFamily();
+    if (obj_af != -1)
+    {
+        // objects of the other address family match nothing
+        if (obj_af == af)
+            warning(rule, "address of object '" + o->getName() +
+                    "' can not be represented as a range");
+        return;
+    }
+
+    MultiAddress *ma = MultiAddress::cast(o);
+    if (ma && ma->isRunTime())
+    {
+        warning(rule, "run time object '" + o->getName() + "' is not modelled");
+        return;
+    }
+
+    if (Group::cast(o))
+    {
+        for (FWObject::iterator i=o->begin(); i!=o->end(); ++i)
+            expandAddress(rule, *i, res);
+        return;
+    }
+
+    if (Host::cast(o) || Interface::cast(o))
+    {
+        list<FWObject*> itfs = o->getByTypeDeep(Interface::TYPENAME);
+        if (Interface::cast(o)) itfs.push_back(o);
+        for (list<FWObject*>::iterator i=itfs.begin(); i!=itfs.end(); ++i)
+        {
+            Interface *itf = Interface::cast(*i);
+            if (itf->isDyn())
+                warning(rule, "dynamic interface '" + itf->getName() +
+                        "' is not modelled");
+        }
+
+        list<FWObject*> addrs = o->getByTypeDeep(IPv4::TYPENAME);
+        list<FWObject*> addrs6 = o->getByTypeDeep(IPv6::TYPENAME);
+        addrs.splice(addrs.end(), addrs6);
+        for (list<FWObject*>::iterator i=addrs.begin(); i!=addrs.end(); ++i)
+            res.addObject(*i);
+        return;
+    }
+
+    warning(rule, "object '" + o->getName() + "' of type " +
+            o->getTypeName() + " is not modelled");
+}
+
+void PolicyModel::expandInterface(Rule *rule, FWObject *obj,
+                                  AddressRangeSet &res)
+{
+    FWObject *o = FWReference::getObject(obj);
+
+    if (Interface::cast(o))
+    {
+        int n = getInterfaceIndex(o->getName());
+        if (n == 0)
+            warning(rule, "interface '" + o->getName() +
+                    "' does not belong to the firewall");
+        else
+            res = res.unite(scalarRange(n, n));
+        return;
+    }
+
+    if (Group::cast(o))
+    {
+        for (FWObject::iterator i=o->begin(); i!=o->end(); ++i)
+            expandInterface(rule, *i, res);
+        return;
+    }
+
+    warning(rule, "object '" + o->getName() + "' of type " +
+            o->getTypeName() + " in interface element is not modelled");
+}
+
+void PolicyModel::expandService(Rule *rule, FWObject *obj,
+                                vector<Term> &res)
+{
+    FWObject *o = FWReference::getObject(obj);
+
+    if (Group::cast(o))
+    {
+        for (FWObject::iterator i=o->begin(); i!=o->end(); ++i)
+            expandService(rule, *i, res);
+        return;
+    }
+
+    Term t;
+    for (int d=0; d<DIMENSIONS; ++d) t.field[d] = domain[d];
+
+    if (TCPService::isA(o) || UDPService::isA(o))
+    {
+        TCPUDPService *s = TCPUDPService::cast(o);
+        int proto = TCPService::isA(o) ? 6 : 17;
+        t.field[PROTO] = scalarRange(proto, proto);
+        t.field[SRC_PORT] = portRange(s->getSrcRangeStart(),
+                                      s->getSrcRangeEnd());
+        t.field[DST_PORT] = portRange(s->getDstRangeStart(),
+                                      s->getDstRangeEnd());
+        TCPService *tcp = TCPService::cast(o);
+        if (tcp && (tcp->inspectFlags() || tcp->getEstablished()))
+            warning(rule, "tcp flags of service '" + o->getName() +
+                    "' are not modelled");
+        res.push_back(t);
+        return;
+    }
+
+    if (ICMPService::isA(o) || ICMP6Service::isA(o))
+    {
+        int proto = ICMPService::isA(o) ? 1 : 58;
+        int type = o->getInt("type");
+        int code = o->getInt("code");
+        t.field[PROTO] = scalarRange(proto, proto);
+        if (type >= 0) t.field[SRC_PORT] = scalarRange(type, type);
+        if (code >= 0) t.field[DST_PORT] = scalarRange(code, code);
+        res.push_back(t);
+        return;
+    }
+
+    if (IPService::isA(o))
+    {
+        IPService *s = IPService::cast(o);
+        int proto = s->getProtocolNumber();
+        if (proto != 0) t.field[PROTO] = scalarRange(proto, proto);
+        if (s->hasIpOptions() || !s->getTOSCode().empty() ||
+            !s->getDSCPCode().empty())
+            warning(rule, "ip options of service '" + o->getName() +
+                    "' are not modelled");
+        res.push_back(t);
+        return;
+    }
+
+    warning(rule, "service '" + o->getName() + "' of type " +
+            o->getTypeName() + " is not modelled");
+}
+
+AddressRangeSet PolicyModel::expandInterfaceElement(Rule *rule, FWObject *re)
+{
+    AddressRangeSet all_itf = scalarRange(1, interfaces.size());
+    RuleElement *itf_re = RuleElement::cast(re);
+    if (matchesAny(itf_re)) return all_itf;
+
+    AddressRangeSet itf(AF_INET);
+    for (FWObject::iterator i=re->begin(); i!=re->end(); ++i)
+        expandInterface(rule, *i, itf);
+    if (itf_re->getNeg()) itf = all_itf.subtract(itf);
+    return itf;
+}
+
+void PolicyModel::buildTerms(Rule *rule, vector<Term> &res)
+{
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    NATRule *nat_rule = NATRule::cast(rule);
+    if (policy_rule == NULL && nat_rule == NULL)
+    {
+        warning(rule, "rule of type " + rule->getTypeName() + " is not modelled");
+        return;
+    }
+
+    // pairs of inbound and outbound interface sets
+    vector<pair<AddressRangeSet, AddressRangeSet> > itf_pairs;
+    RuleElement *addr_re[2];
+    RuleElement *srv_re;
+    RuleElement *when;
+
+    if (policy_rule)
+    {
+        RuleElementItf *itf_re = policy_rule->getItf();
+        AddressRangeSet itf = expandInterfaceElement(rule, itf_re);
+        PolicyRule::Direction dir = policy_rule->getDirection();
+        if (dir == PolicyRule::Inbound)
+            itf_pairs.push_back(make_pair(itf, domain[OUT_ITF]));
+        else if (dir == PolicyRule::Outbound)
+            itf_pairs.push_back(make_pair(domain[IN_ITF], itf));
+        else if (matchesAny(itf_re))
+            itf_pairs.push_back(make_pair(domain[IN_ITF], domain[OUT_ITF]));
+        else
+        {
+            itf_pairs.push_back(make_pair(itf, domain[OUT_ITF]));
+            itf_pairs.push_back(make_pair(domain[IN_ITF], itf));
+        }
+        addr_re[0] = policy_rule->getSrc();
+        addr_re[1] = policy_rule->getDst();
+        srv_re = policy_rule->getSrv();
+        when = policy_rule->getWhen();
+    } else
+    {
+        // NAT rules match packets before routing decision is made,
+        // interface elements that are "any" do not restrict anything
+        RuleElement *inb = nat_rule->getItfInb();
+        RuleElement *outb = nat_rule->getItfOutb();
+        itf_pairs.push_back(make_pair(
+            matchesAny(inb) ? domain[IN_ITF] : expandInterfaceElement(rule, inb),
+            matchesAny(outb) ? domain[OUT_ITF] : expandInterfaceElement(rule, outb)));
+        addr_re[0] = nat_rule->getOSrc();
+        addr_re[1] = nat_rule->getODst();
+        srv_re = nat_rule->getOSrv();
+        when = nat_rule->getWhen();
+    }
+
+    AddressRangeSet addr[2];
+    for (int n=0; n<2; ++n)
+    {
+        addr[n] = domain[SRC];
+        if (matchesAny(addr_re[n])) continue;
+        addr[n] = AddressRangeSet(af);
+        for (FWObject::iterator i=addr_re[n]->begin(); i!=addr_re[n]->end(); ++i)
+            expandAddress(rule, *i, addr[n]);
+        if (addr_re[n]->getNeg()) addr[n] = addr[n].complement();
+    }
+
+    if (!matchesAny(when))
+        warning(rule, "time interval is not modelled");
+
+    Term any;
+    for (int d=0; d<DIMENSIONS; ++d) any.field[d] = domain[d];
+
+    vector<Term> services;
+    if (matchesAny(srv_re))
+        services.push_back(any);
+    else
+    {
+        for (FWObject::iterator i=srv_re->begin(); i!=srv_re->end(); ++i)
+            expandService(rule, *i, services);
+        if (srv_re->getNeg())
+        {
+            vector<Term> rest;
+            rest.push_back(any);
+            for (vector<Term>::iterator s=services.begin(); s!=services.end(); ++s)
+            {
+                vector<Term> next;
+                for (vector<Term>::iterator r=rest.begin(); r!=rest.end(); ++r)
+                    subtractTerm(*r, *s, next);
+                rest.swap(next);
+            }
+            services.swap(rest);
+        }
+    }
+
+    if (addr[0].empty() || addr[1].empty()) return;
+
+    for (unsigned p=0; p<itf_pairs.size(); ++p)
+    {
+        if (itf_pairs[p].first.empty() || itf_pairs[p].second.empty()) continue;
+        for (vector<Term>::iterator s=services.begin(); s!=services.end(); ++s)
+        {
+            Term t = *s;
+            t.field[IN_ITF] = itf_pairs[p].first;
+            t.field[OUT_ITF] = itf_pairs[p].second;
+            t.field[SRC] = addr[0];
+            t.field[DST] = addr[1];
+            t.rule = -1;
+            t.decision = NO_DECISION;
+            finishTerm(t);
+            res.push_back(t);
+        }
+    }
+}
+
+PolicyModel::Decision PolicyModel::getDecision(Rule *rule, bool &known)
+{
+    known = true;
+
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    if (policy_rule)
+    {
+        switch (policy_rule->getAction())
+        {
+        case PolicyRule::Accept: return ACCEPT;
+        case PolicyRule::Deny:   return DENY;
+        case PolicyRule::Reject: return REJECT;
+        case PolicyRule::Branch:
+        case PolicyRule::Return:
+        case PolicyRule::Continue:
+        case PolicyRule::Accounting:
+        case PolicyRule::Modify:
+            return NO_DECISION;
+        default:
+            known = false;
+            return NO_DECISION;
+        }
+    }
+
+    NATRule *nat_rule = NATRule::cast(rule);
+    if (nat_rule)
+    {
+        switch (nat_rule->getRuleType())
+        {
+        case NATRule::NONAT:
+            return NO_TRANSLATION;
+        case NATRule::NATBranch:
+        case NATRule::Return:
+        case NATRule::Continue:
+            return NO_DECISION;
+        case NATRule::Skip:
+            known = false;
+            return NO_DECISION;
+        case NATRule::Unknown:
+            // rule that has not been through the compiler yet
+            if (nat_rule->getAction() == NATRule::Branch) return NO_DECISION;
+            if (matchesAny(nat_rule->getTSrc()) &&
+                matchesAny(nat_rule->getTDst()) &&
+                matchesAny(nat_rule->getTSrv()))
+                return NO_TRANSLATION;
+            return TRANSLATE;
+        default:
+            return TRANSLATE;
+        }
+    }
+
+    known = false;
+    return NO_DECISION;
+}
+
+static bool isBranch(Rule *rule)
+{
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    if (policy_rule) return policy_rule->getAction() == PolicyRule::Branch;
+    NATRule *nat_rule = NATRule::cast(rule);
+    if (nat_rule)
+        return nat_rule->getAction() == NATRule::Branch ||
+            nat_rule->getRuleType() == NATRule::NATBranch;
+    return false;
+}
+
+static bool isReturn(Rule *rule)
+{
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    if (policy_rule) return policy_rule->getAction() == PolicyRule::Return;
+    NATRule *nat_rule = NATRule::cast(rule);
+    return (nat_rule && nat_rule->getRuleType() == NATRule::Return);
+}
+
+static string actionName(Rule *rule)
+{
+    PolicyRule *policy_rule = PolicyRule::cast(rule);
+    if (policy_rule) return policy_rule->getActionAsString();
+    NATRule *nat_rule = NATRule::cast(rule);
+    if (nat_rule) return nat_rule->getRuleTypeAsString();
+    return rule->getTypeName();
+}
+
+void PolicyModel::addRule(Rule *rule)
+{
+    addRule(rule, vector<Term>(), 0);
+}
+
+void PolicyModel::addTerms(Rule *rule, const vector<Term> &rule_terms,
+                           Decision decision)
+{
+    rules.push_back(rule);
+    for (vector<Term>::const_iterator t=rule_terms.begin();
+         t!=rule_terms.end(); ++t)
+    {
+        Term term = *t;
+        term.rule = rules.size() - 1;
+        term.decision = decision;
+        finishTerm(term);
+        terms.push_back(term);
+    }
+}
+
+void PolicyModel::addRuleSet(RuleSet *ruleset)
+{
+    for (FWObject::iterator i=ruleset->begin(); i!=ruleset->end(); ++i)
+    {
+        Rule *rule = Rule::cast(*i);
+        if (rule) addRule(rule);
+    }
+}
+
+/*
+ * ctx is the list of terms of the branching rule when rule belongs
+ * to a branch rule set. The rule can only match packets that get to
+ * the branch.
+ */
+void PolicyModel::addRule(Rule *rule, const vector<Term> &ctx, int depth)
+{
+    if (rule->isDisabled()) return;
+
+    rules.push_back(rule);
+    int n = rules.size() - 1;
+
+    bool known;
+    Decision decision = getDecision(rule, known);
+    bool branch = isBranch(rule);
+    if (!known || isReturn(rule))
+    {
+        warning(rule, "action " + actionName(rule) + " is not modelled");
+        return;
+    }
+    if (decision == NO_DECISION && !branch) return;
+
+    vector<Term> own;
+    buildTerms(rule, own);
+
+    if (depth > 0)
+    {
+        vector<Term> restricted;
+        intersectTerms(own, ctx, restricted);
+        own.swap(restricted);
+    }
+
+    if (branch)
+    {
+        RuleSet *branch_rs = rule->getBranch();
+        if (branch_rs == NULL)
+        {
+            warning(rule, "branch rule set is missing");
+            return;
+        }
+        if (depth >= 16)
+        {
+            warning(rule, "branch rule sets are nested too deep");
+            return;
+        }
+        for (FWObject::iterator i=branch_rs->begin(); i!=branch_rs->end(); ++i)
+        {
+            Rule *r = Rule::cast(*i);
+            if (r) addRule(r, own, depth + 1);
+        }
+        return;
+    }
+
+    for (vector<Term>::iterator t=own.begin(); t!=own.end(); ++t)
+    {
+        t->rule = n;
+        t->decision = decision;
+        finishTerm(*t);
+        terms.push_back(*t);
+    }
+}
+
+PolicyModel::Decision PolicyModel::evaluate(const Packet &p, int *rule) const
+{
+    for (vector<Term>::const_iterator t=terms.begin(); t!=terms.end(); ++t)
+    {
+        if (t->contains(p))
+        {
+            if (rule) *rule = t->rule;
+            return t->decision;
+        }
+    }
+    if (rule) *rule = -1;
+    return NO_DECISION;
+}
+
+string PolicyModel::decisionName(Decision d)
+{
+    switch (d)
+    {
+    case ACCEPT:         return "accept";
+    case DENY:           return "deny";
+    case REJECT:         return "reject";
+    case TRANSLATE:      return "translate";
+    case NO_TRANSLATION: return "no translation";
+    default:     return "no decision";
+    }
+}
+
+string PolicyModel::toString(const Packet &p) const
+{
+    ostringstream str;
+    str << "in=" << getInterfaceName(p.get(IN_ITF))
+        << " out=" << getInterfaceName(p.get(OUT_ITF))
+        << " proto=" << p.get(PROTO)
+        << " src=" << p.value[SRC].toInetAddr().toString()
+        << " dst=" << p.value[DST].toInetAddr().toString()
+        << " sport=" << p.get(SRC_PORT)
+        << " dport=" << p.get(DST_PORT);
+    return str.str();
+}
@@ -0,0 +1,235 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __POLICY_MODEL_HH__
+#define __POLICY_MODEL_HH__
+
+#include "fwcompiler/AddressRangeSet.h"
+
+#include "fwbuilder/InetAddrValue.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+    class FWObject;
+    class Firewall;
+    class Rule;
+    class RuleSet;
+};
+
+namespace fwcompiler
+{
+
+    /**
+     * Model of what a policy or NAT rule set does with a packet. Each rule
+     * is converted to one or more terms, a term is a box in the
+     * packet header space that is the product of one set of
+     * intervals per header field. The rule matches a packet if one
+     * of its terms contains it. Rules are evaluated in order, the
+     * first rule with terminating action decides. For NAT rules the
+     * decision is whether the packet is translated; terms are built
+     * from the original source, destination and service and the
+     * inbound and outbound interface elements.
+     *
+     * Header fields are the inbound and outbound interface, protocol,
+     * source and destination address and source and destination
+     * port. Interfaces are numbered 1..N in the order of their names,
+     * 0 stands for "no interface" (packets sent or received by the
+     * firewall itself). For ICMP the port fields hold icmp type and
+     * code. All fields other than addresses are stored in AF_INET
+     * range sets, their values are small integers.
+     *
+     * Objects and services the model can not represent, such as run
+     * time address tables or tcp flags, are reported as warnings and
+     * ignored; isExact() returns false in this case.
+     */
+    class PolicyModel
+    {
+        public:
+
+        typedef enum { IN_ITF,
+                       OUT_ITF,
+                       PROTO,
+                       SRC,
+                       DST,
+                       SRC_PORT,
+                       DST_PORT,
+                       DIMENSIONS } Dimension;
+
+        typedef enum { NO_DECISION,
+                       ACCEPT,
+                       DENY,
+                       REJECT,
+                       TRANSLATE,
+                       NO_TRANSLATION } Decision;
+
+        class Packet
+        {
+            public:
+            libfwbuilder::InetAddrValue value[DIMENSIONS];
+
+            explicit Packet(int address_family=AF_INET);
+            void set(Dimension d, int v);
+            int get(Dimension d) const { return int(value[d].lo); }
+        };
+
+        class Term
+        {
+            public:
+            int rule;
+            Decision decision;
+            AddressRangeSet field[DIMENSIONS];
+            // all fields starting with this one match anything
+            int any_from;
+
+            bool contains(const Packet &p) const;
+        };
+
+        private:
+
+        int af;
+        std::vector<std::string> interfaces;
+        std::map<std::string, int> interface_index;
+        AddressRangeSet domain[DIMENSIONS];
+        std::vector<libfwbuilder::Rule*> rules;
+        std::vector<Term> terms;
+        std::list<std::string> warnings;
+
+        void warning(libfwbuilder::Rule *rule, const std::string &msg);
+        void expandAddress(libfwbuilder::Rule *rule,
+                           libfwbuilder::FWObject *obj, AddressRangeSet &res);
+        void expandInterface(libfwbuilder::Rule *rule,
+                             libfwbuilder::FWObject *obj, AddressRangeSet &res);
+        AddressRangeSet expandInterfaceElement(libfwbuilder::Rule *rule,
+                                               libfwbuilder::FWObject *re);
+        void expandService(libfwbuilder::Rule *rule,
+                           libfwbuilder::FWObject *obj, std::vector<Term> &res);
+        void addRule(libfwbuilder::Rule *rule, const std::vector<Term> &ctx,
+                     int depth);
+
+        public:
+
+        /**
+         * Creates empty model for rules of firewall fw that match
+         * packets of the given address family. fw provides the list
+         * of interfaces, models of two compiles of the same firewall
+         * number interfaces the same way.
+         */
+        PolicyModel(libfwbuilder::Firewall *fw, int address_family=AF_INET);
+
+        int addressFamily() const { return af; }
+
+        /**
+         * adds policy or NAT rule at the bottom of the model. Disabled
+         * rules and rules with non-terminating actions do not match
+         * anything. Rules with action Branch are replaced with the
+         * rules of the branch rule set restricted to packets the rule
+         * matches.
+         */
+        void addRule(libfwbuilder::Rule *rule);
+
+        /**
+         * adds all rules of the rule set in order
+         */
+        void addRuleSet(libfwbuilder::RuleSet *ruleset);
+
+        /**
+         * adds rule at the bottom of the model with the match and
+         * the decision given by the caller, for rules whose match is
+         * computed elsewhere, such as rules laid out in chains by a
+         * compiler
+         */
+        void addTerms(libfwbuilder::Rule *rule, const std::vector<Term> &terms,
+                      Decision decision);
+
+        /**
+         * converts match part of the rule to terms, ignoring its
+         * action. Adds nothing if the rule can not match any packet.
+         */
+        void buildTerms(libfwbuilder::Rule *rule, std::vector<Term> &res);
+
+        /**
+         * Decision made by the action of the rule. Returns
+         * NO_DECISION for actions that let the packet continue, such
+         * as Continue or Accounting, and for Branch and Return, which
+         * depend on other rules. Sets known to false if the model
+         * does not know what the action does.
+         */
+        static Decision getDecision(libfwbuilder::Rule *rule, bool &known);
+
+        /**
+         * updates any_from of the term, must be called after fields
+         * of a term made by buildTerms() are changed
+         */
+        void finishTerm(Term &t);
+
+        /**
+         * adds a - b to res as a list of boxes, at most one per field
+         */
+        static void subtractTerm(const Term &a, const Term &b,
+                                 std::vector<Term> &res);
+
+        /**
+         * adds intersection of every term of a with every term of b
+         * to res, empty intersections are skipped
+         */
+        static void intersectTerms(const std::vector<Term> &a,
+                                   const std::vector<Term> &b,
+                                   std::vector<Term> &res);
+
+        /**
+         * finds the first term that contains the packet, linear
+         * search. Returns NO_DECISION if none does. If rule is not
+         * NULL, it is set to the number of the deciding rule or -1.
+         */
+        Decision evaluate(const Packet &p, int *rule=NULL) const;
+
+        const std::vector<Term>& getTerms() const { return terms; }
+        const AddressRangeSet& getDomain(Dimension d) const { return domain[d]; }
+
+        int countRules() const { return rules.size(); }
+        libfwbuilder::Rule* getRule(int n) const { return rules[n]; }
+        std::string getRuleLabel(int n) const;
+
+        int countInterfaces() const { return interfaces.size(); }
+        /**
+         * 0 if there is no interface with this name
+         */
+        int getInterfaceIndex(const std::string &name) const;
+        std::string getInterfaceName(int n) const;
+
+        const std::list<std::string>& getWarnings() const { return warnings; }
+        bool isExact() const { return warnings.empty(); }
+
+        std::string toString(const Packet &p) const;
+        static std::string decisionName(Decision d);
+    };
+
+};
+
+#endif
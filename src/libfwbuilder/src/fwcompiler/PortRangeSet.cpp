@@ -0,0 +1,151 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "PortRangeSet.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace fwcompiler;
+using namespace std;
+
+
+void PortRangeSet::addRange(int first, int last)
+{
+    if (first < 0) first = 0;
+    if (last > 65535) last = 65535;
+    if (first > last) return;
+
+    vector<Range> res;
+    vector<Range>::iterator i = ranges.begin();
+    for ( ; i!=ranges.end() && i->second + 1 < first; ++i) res.push_back(*i);
+    for ( ; i!=ranges.end() && i->first <= last + 1; ++i)
+    {
+        first = min(first, i->first);
+        last = max(last, i->second);
+    }
+    res.push_back(Range(first, last));
+    for ( ; i!=ranges.end(); ++i) res.push_back(*i);
+    ranges.swap(res);
+}
+
+bool PortRangeSet::contains(int port) const
+{
+    vector<Range>::const_iterator i =
+        upper_bound(ranges.begin(), ranges.end(), Range(port, 65536));
+    if (i == ranges.begin()) return false;
+    --i;
+    return port >= i->first && port <= i->second;
+}
+
+int PortRangeSet::countPorts() const
+{
+    int n = 0;
+    for (vector<Range>::const_iterator i=ranges.begin(); i!=ranges.end(); ++i)
+        n += i->second - i->first + 1;
+    return n;
+}
+
+int PortRangeSet::cost() const
+{
+    int n = 0;
+    for (vector<Range>::const_iterator i=ranges.begin(); i!=ranges.end(); ++i)
+        n += (i->first == i->second) ? 1 : 2;
+    return n;
+}
+
+/*
+ * A chunk holds at most max_cost/2 ranges, singles can fill any slot
+ * left over. The smallest number of chunks is therefore the larger
+ * of the number needed to hold all ranges and the number needed to
+ * hold the total cost. Ranges are packed first, max_cost/2 per chunk,
+ * then singles fill what is left. Both are taken in port order so
+ * neighbouring ports tend to end up in the same chunk.
+ */
+vector<PortRangeSet> PortRangeSet::split(int max_cost) const
+{
+    vector<PortRangeSet> res;
+    if (ranges.empty()) return res;
+
+    if (max_cost <= 0 || cost() <= max_cost)
+    {
+        res.push_back(*this);
+        return res;
+    }
+
+    if (max_cost < 2) max_cost = 2;
+    int ranges_per_chunk = max_cost / 2;
+
+    vector<Range> multi;
+    vector<Range> singles;
+    for (vector<Range>::const_iterator i=ranges.begin(); i!=ranges.end(); ++i)
+    {
+        if (i->first == i->second) singles.push_back(*i);
+        else multi.push_back(*i);
+    }
+
+    int n_multi = multi.size();
+    int total = 2 * n_multi + singles.size();
+    int n_chunks = max((n_multi + ranges_per_chunk - 1) / ranges_per_chunk,
+                       (total + max_cost - 1) / max_cost);
+
+    res.resize(n_chunks);
+    vector<int> used(n_chunks, 0);
+
+    int c = 0;
+    for (vector<Range>::iterator i=multi.begin(); i!=multi.end(); ++i)
+    {
+        if (used[c] + 2 > max_cost) c++;
+        res[c].ranges.push_back(*i);
+        used[c] += 2;
+    }
+
+    c = 0;
+    for (vector<Range>::iterator i=singles.begin(); i!=singles.end(); ++i)
+    {
+        while (used[c] + 1 > max_cost) c++;
+        res[c].ranges.push_back(*i);
+        used[c] += 1;
+    }
+
+    // ranges and singles were appended separately; they never overlap
+    // or touch each other because they came from one merged set
+    for (vector<PortRangeSet>::iterator i=res.begin(); i!=res.end(); ++i)
+        sort(i->ranges.begin(), i->ranges.end());
+
+    return res;
+}
+
+string PortRangeSet::toString() const
+{
+    ostringstream str;
+    for (vector<Range>::const_iterator i=ranges.begin(); i!=ranges.end(); ++i)
+    {
+        if (i != ranges.begin()) str << ",";
+        str << i->first;
+        if (i->first != i->second) str << ":" << i->second;
+    }
+    return str.str();
+}
@@ -0,0 +1,97 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __PORT_RANGE_SET_HH__
+#define __PORT_RANGE_SET_HH__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace fwcompiler
+{
+
+    /**
+     * Set of TCP or UDP port numbers kept as a sorted list of
+     * disjoint inclusive ranges. Overlapping and adjacent ranges are
+     * merged as they are added, so the list is always the shortest
+     * one that describes the set.
+     */
+    class PortRangeSet
+    {
+        public:
+
+        typedef std::pair<int,int> Range;
+
+        private:
+
+        std::vector<Range> ranges;
+
+        public:
+
+        PortRangeSet() {}
+
+        bool empty() const { return ranges.empty(); }
+        const std::vector<Range>& getRanges() const { return ranges; }
+
+        /**
+         * adds all ports from first to last inclusive. Ports outside
+         * of 0-65535 are clipped, empty ranges are ignored.
+         */
+        void addRange(int first, int last);
+        void addPort(int port) { addRange(port, port); }
+
+        bool contains(int port) const;
+
+        /**
+         * number of ports in the set
+         */
+        int countPorts() const;
+
+        /**
+         * Splits the set into the smallest number of chunks so that
+         * each chunk costs no more than max_cost, where a single port
+         * costs 1 and a range costs 2. With max_cost 15 this is the
+         * limit iptables module multiport puts on its port list. Ranges
+         * in each chunk are sorted. max_cost <= 0 means no limit,
+         * everything goes into one chunk.
+         */
+        std::vector<PortRangeSet> split(int max_cost) const;
+
+        /**
+         * cost of the set as defined in split()
+         */
+        int cost() const;
+
+        bool operator==(const PortRangeSet &other) const
+        { return ranges == other.ranges; }
+        bool operator!=(const PortRangeSet &other) const
+        { return ranges != other.ranges; }
+
+        std::string toString() const;
+    };
+
+};
+
+#endif
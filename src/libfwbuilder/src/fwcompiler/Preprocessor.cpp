@@ -26,7 +26,9 @@
 
 #include "Preprocessor.h"
 
+#include "fwbuilder/DNSName.h"
 #include "fwbuilder/MultiAddress.h"
+#include "fwbuilder/dns.h"
 #include "fwbuilder/Rule.h"
 #include "fwbuilder/RuleElement.h"
 #include "fwbuilder/Firewall.h"
@@ -82,6 +84,76 @@ int  Preprocessor::prolog()
     return 0;
 }
 
+/*
+ * Collect source names of compile time DNSName objects used in rules
+ * so they can be resolved all at once before the objects are
+ * converted. Walks the same objects findMultiAddressObjectsUsedInRules()
+ * does, except for members of dynamic groups which are not known
+ * until the group is loaded; these are resolved one by one later.
+ */
+void Preprocessor::findDNSNamesUsedInRules(FWObject *top,
+                                           list<string> &names)
+{
+    if (top->getInt(".dns_recursion_breaker") == infinite_recursion_breaker)
+        return;
+    top->setInt(".dns_recursion_breaker", infinite_recursion_breaker);
+
+    for (FWObject::iterator i=top->begin(); i!=top->end(); ++i)
+    {
+        FWObject *obj = *i;
+        PolicyRule *rule = PolicyRule::cast(obj);
+        if (rule && rule->getAction() == PolicyRule::Branch)
+        {
+            RuleSet *branch_ruleset = rule->getBranch();
+            if (branch_ruleset) findDNSNamesUsedInRules(branch_ruleset, names);
+        }
+
+        FWReference *ref = FWReference::cast(obj);
+        if (ref == NULL)
+            findDNSNamesUsedInRules(obj, names);
+        else
+        {
+            FWObject *obj_ptr = FWReference::getObject(obj);
+            DNSName *dnsname = DNSName::cast(obj_ptr);
+            if (dnsname && dnsname->isCompileTime())
+                names.push_back(dnsname->getSourceName());
+            else if (Group::cast(obj_ptr) && !MultiAddress::cast(obj_ptr))
+                findDNSNamesUsedInRules(obj_ptr, names);
+        }
+    }
+}
+
+/*
+ * Resolve all DNSName objects concurrently. Results go to the cache
+ * DNS::getHostByName() consults, so DNSName::loadFromSource() called
+ * later from convertObject() does not run queries one by one.
+ * Firewall options:
+ *
+ * dns_parallel_queries  max number of queries running at once (16)
+ * dns_timeout           time limit for each query, sec (30)
+ * dns_cache_ttl         how long results stay in the cache file, sec (3600)
+ *
+ * The cache lives for one run of the compiler driver, results are
+ * carried over to the next run only through the cache file (-xd).
+ */
+void Preprocessor::resolveDNSNames(FWObject *top)
+{
+    list<string> names;
+    findDNSNamesUsedInRules(top, names);
+    if (names.empty()) return;
+
+    FWOptions *opt = getCachedFwOpt();
+    int max_parallel = (opt) ? opt->getInt("dns_parallel_queries") : -1;
+    int timeout = (opt) ? opt->getInt("dns_timeout") : -1;
+    int ttl = (opt) ? opt->getInt("dns_cache_ttl") : -1;
+    if (max_parallel <= 0) max_parallel = 16;
+    if (timeout <= 0) timeout = 30;
+    if (ttl < 0) ttl = 3600;
+
+    DNS::resolveNames(names, (ipv6) ? AF_INET6 : AF_INET,
+                      max_parallel, timeout, ttl);
+}
+
 void Preprocessor::findMultiAddressObjectsUsedInRules(FWObject *top)
 {
     if (top->getInt(".recursion_breaker") == infinite_recursion_breaker)
@@ -137,12 +209,17 @@ void Preprocessor::compile()
     if (single_rule_mode)
     {
         rule_copy = dbcopy->findInIndex(single_rule_compile_rule->getId());
+        resolveDNSNames(rule_copy);
         findMultiAddressObjectsUsedInRules(rule_copy);
     } else
     {
         FWObject *fwcopy = dbcopy->findInIndex(fw->getId());
+        resolveDNSNames(fwcopy);
         findMultiAddressObjectsUsedInRules(fwcopy);
     }
+
+    // failed queries are not kept beyond this compiler run
+    DNS::getCache()->clearErrors();
 /* resolving MultiAddress objects */
 //    convertObjectsRecursively(dbcopy);
 }
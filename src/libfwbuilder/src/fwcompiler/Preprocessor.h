@@ -39,6 +39,7 @@
 #include "fwcompiler/Compiler.h"
 #include "fwbuilder/FWObjectDatabase.h"
 
+#include <list>
 #include <string>
 
 namespace fwcompiler {
@@ -46,6 +47,9 @@ namespace fwcompiler {
     class Preprocessor : public Compiler {
 
         void findMultiAddressObjectsUsedInRules(libfwbuilder::FWObject *top);
+        void findDNSNamesUsedInRules(libfwbuilder::FWObject *top,
+                                     std::list<std::string> &names);
+        void resolveDNSNames(libfwbuilder::FWObject *top);
 
 public:
 	virtual std::string myPlatformName();
@@ -0,0 +1,379 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "RouteAggregator.h"
+
+#include <string.h>
+
+#include <map>
+#include <sstream>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+static int addressBytes(const InetAddr &addr, unsigned char *bytes)
+{
+    if (addr.isV4())
+    {
+        memcpy(bytes, addr.getV4(), 4);
+        return 4;
+    }
+    memcpy(bytes, addr.getV6(), 16);
+    return 16;
+}
+
+static InetAddr bytesToAddress(int af, const unsigned char *bytes)
+{
+    if (af == AF_INET)
+    {
+        struct in_addr a;
+        memcpy(&a, bytes, 4);
+        return InetAddr(&a);
+    }
+    struct in6_addr a6;
+    memcpy(&a6, bytes, 16);
+    return InetAddr(&a6);
+}
+
+static inline int getBit(const unsigned char *bytes, int n)
+{
+    return (bytes[n / 8] >> (7 - n % 8)) & 1;
+}
+
+static inline void setBit(unsigned char *bytes, int n, int v)
+{
+    if (v) bytes[n / 8] |= (1 << (7 - n % 8));
+    else bytes[n / 8] &= ~(1 << (7 - n % 8));
+}
+
+/*
+ * Routes indexed by prefix length and masked address. Used to find
+ * the longest matching prefix without scanning all routes.
+ */
+class RouteLookupTable
+{
+    // key: address family and prefix length, value: map masked
+    // address -> next hop
+    map<pair<int, int>, map<string, int> > prefixes;
+
+    static string maskedKey(const unsigned char *bytes, int size, int length)
+    {
+        unsigned char masked[16];
+        memset(masked, 0, sizeof(masked));
+        for (int i=0; i<length; ++i) setBit(masked, i, getBit(bytes, i));
+        return string((const char*)masked, size);
+    }
+
+    public:
+
+    RouteLookupTable(const vector<RouteAggregator::Route> &routes)
+    {
+        for (vector<RouteAggregator::Route>::const_iterator it=routes.begin();
+             it!=routes.end(); ++it)
+        {
+            unsigned char bytes[16];
+            int size = addressBytes(it->address, bytes);
+            map<string, int> &m = prefixes[
+                pair<int, int>(it->address.addressFamily(), it->length)];
+            string key = maskedKey(bytes, size, it->length);
+            map<string, int>::iterator i = m.find(key);
+            if (i == m.end()) m[key] = it->nexthop;
+            else if (i->second != it->nexthop) i->second = -2;
+        }
+    }
+
+    int lookup(const InetAddr &addr)
+    {
+        unsigned char bytes[16];
+        int size = addressBytes(addr, bytes);
+        int af = addr.addressFamily();
+        for (int len=size * 8; len>=0; --len)
+        {
+            map<pair<int, int>, map<string, int> >::iterator it =
+                prefixes.find(pair<int, int>(af, len));
+            if (it == prefixes.end()) continue;
+            map<string, int>::iterator i =
+                it->second.find(maskedKey(bytes, size, len));
+            if (i != it->second.end()) return i->second;
+        }
+        return -1;
+    }
+};
+
+/*
+ * Value of the route in the node used to compare it with other
+ * routes: next hop, -1 if there is no route or a unique negative
+ * number if this route must not be merged with anything.
+ */
+int RouteAggregator::value(int n)
+{
+    if (nodes[n].nexthops.empty()) return -1;
+    if (nodes[n].pinned || nodes[n].nexthops.size() > 1) return -2 - n;
+    return *(nodes[n].nexthops.begin());
+}
+
+int RouteAggregator::insert(int root, const Route &route)
+{
+    unsigned char bytes[16];
+    addressBytes(route.address, bytes);
+    int n = root;
+    for (int i=0; i<route.length; ++i)
+    {
+        int bit = getBit(bytes, i);
+        if (nodes[n].child[bit] < 0)
+        {
+            int c = nodes.size();
+            nodes.push_back(Node());
+            nodes[n].child[bit] = c;
+        }
+        n = nodes[n].child[bit];
+    }
+    return n;
+}
+
+void RouteAggregator::addRoute(const InetAddr &address, int length,
+                               int nexthop, bool pinned)
+{
+    Route route(address, length, nexthop);
+    int n = insert((address.isV4()) ? 0 : 1, route);
+    nodes[n].nexthops.insert(nexthop);
+    nodes[n].inputs.push_back(routes.size());
+    if (pinned) nodes[n].pinned = true;
+    routes.push_back(route);
+}
+
+/*
+ * Route is redundant if the closest route that covers it has the
+ * same next hop. Addresses that matched it match that route
+ * instead.
+ */
+void RouteAggregator::dropRedundant(int n, int inherited_value,
+                                    int absorbing_node)
+{
+    int v = value(n);
+    if (v >= 0 && v == inherited_value)
+    {
+        Node &a = nodes[absorbing_node];
+        a.inputs.insert(a.inputs.end(),
+                        nodes[n].inputs.begin(), nodes[n].inputs.end());
+        nodes[n].inputs.clear();
+        nodes[n].nexthops.clear();
+    } else if (v != -1)
+    {
+        inherited_value = v;
+        absorbing_node = n;
+    }
+
+    for (int bit=0; bit<2; ++bit)
+        if (nodes[n].child[bit] >= 0)
+            dropRedundant(nodes[n].child[bit], inherited_value, absorbing_node);
+}
+
+/*
+ * Two halves of a prefix that have the same next hop cover all of it,
+ * so they can be replaced with a route for the prefix as long as
+ * there is no route for this prefix already. Routes inside of the
+ * halves are longer and still win. Never creates default route.
+ */
+void RouteAggregator::mergeSiblings(int n, int depth)
+{
+    for (int bit=0; bit<2; ++bit)
+        if (nodes[n].child[bit] >= 0)
+            mergeSiblings(nodes[n].child[bit], depth + 1);
+
+    if (depth == 0 || !nodes[n].nexthops.empty()) return;
+
+    int c0 = nodes[n].child[0];
+    int c1 = nodes[n].child[1];
+    if (c0 < 0 || c1 < 0) return;
+
+    int v = value(c0);
+    if (v < 0 || v != value(c1)) return;
+
+    nodes[n].nexthops.insert(v);
+    for (int bit=0; bit<2; ++bit)
+    {
+        Node &c = nodes[nodes[n].child[bit]];
+        nodes[n].inputs.insert(nodes[n].inputs.end(),
+                               c.inputs.begin(), c.inputs.end());
+        c.inputs.clear();
+        c.nexthops.clear();
+    }
+}
+
+void RouteAggregator::collect(int n, int af, int depth, unsigned char *prefix,
+                              vector<Route> &result, vector<int> &replaced_by)
+{
+    if (!nodes[n].nexthops.empty())
+    {
+        InetAddr addr = bytesToAddress(af, prefix);
+        for (set<int>::iterator it=nodes[n].nexthops.begin();
+             it!=nodes[n].nexthops.end(); ++it)
+        {
+            int idx = result.size();
+            result.push_back(Route(addr, depth, *it));
+            for (vector<int>::iterator i=nodes[n].inputs.begin();
+                 i!=nodes[n].inputs.end(); ++i)
+                if (routes[*i].nexthop == *it) replaced_by[*i] = idx;
+        }
+    }
+
+    for (int bit=0; bit<2; ++bit)
+    {
+        if (nodes[n].child[bit] < 0) continue;
+        setBit(prefix, depth, bit);
+        collect(nodes[n].child[bit], af, depth + 1, prefix, result, replaced_by);
+        setBit(prefix, depth, 0);
+    }
+}
+
+void RouteAggregator::aggregate(vector<Route> &result, vector<int> &replaced_by)
+{
+    for (int root=0; root<2; ++root)
+    {
+        dropRedundant(root, -1, -1);
+        mergeSiblings(root, 0);
+        dropRedundant(root, -1, -1);
+    }
+
+    result.clear();
+    replaced_by.assign(routes.size(), -1);
+
+    unsigned char prefix[16];
+    memset(prefix, 0, sizeof(prefix));
+    collect(0, AF_INET, 0, prefix, result, replaced_by);
+    memset(prefix, 0, sizeof(prefix));
+    collect(1, AF_INET6, 0, prefix, result, replaced_by);
+}
+
+int RouteAggregator::lookup(const vector<Route> &routes, const InetAddr &address)
+{
+    RouteLookupTable table(routes);
+    return table.lookup(address);
+}
+
+static unsigned int nextRandom(unsigned int &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/*
+ * Adds the first, the last and a random address of the route's prefix
+ * and addresses right before and after it.
+ */
+static void addSamples(const RouteAggregator::Route &route,
+                       unsigned int &state, vector<InetAddr> &samples)
+{
+    unsigned char first[16], last[16], rnd[16];
+    int size = addressBytes(route.address, first);
+    int af = route.address.addressFamily();
+    int bits = size * 8;
+
+    for (int i=route.length; i<bits; ++i) setBit(first, i, 0);
+    memcpy(last, first, size);
+    memcpy(rnd, first, size);
+    for (int i=route.length; i<bits; ++i)
+    {
+        setBit(last, i, 1);
+        setBit(rnd, i, nextRandom(state) & 1);
+    }
+
+    samples.push_back(bytesToAddress(af, first));
+    samples.push_back(bytesToAddress(af, last));
+    samples.push_back(bytesToAddress(af, rnd));
+
+    unsigned char before[16], after[16];
+    memcpy(before, first, size);
+    memcpy(after, last, size);
+    int i = size - 1;
+    while (i >= 0 && before[i] == 0) before[i--] = 0xff;
+    if (i >= 0)
+    {
+        before[i]--;
+        samples.push_back(bytesToAddress(af, before));
+    }
+    i = size - 1;
+    while (i >= 0 && after[i] == 0xff) after[i--] = 0;
+    if (i >= 0)
+    {
+        after[i]++;
+        samples.push_back(bytesToAddress(af, after));
+    }
+}
+
+bool RouteAggregator::verify(const vector<Route> &original,
+                             const vector<Route> &aggregated,
+                             int random_samples, unsigned int seed,
+                             string &error)
+{
+    unsigned int state = (seed) ? seed : 1;
+    vector<InetAddr> samples;
+    bool have_af[2] = { false, false };
+
+    for (vector<Route>::const_iterator it=original.begin();
+         it!=original.end(); ++it)
+    {
+        addSamples(*it, state, samples);
+        have_af[(it->address.isV4()) ? 0 : 1] = true;
+    }
+    for (vector<Route>::const_iterator it=aggregated.begin();
+         it!=aggregated.end(); ++it)
+    {
+        addSamples(*it, state, samples);
+        have_af[(it->address.isV4()) ? 0 : 1] = true;
+    }
+
+    for (int n=0; n<random_samples; ++n)
+    {
+        unsigned char bytes[16];
+        for (int i=0; i<16; ++i) bytes[i] = nextRandom(state) & 0xff;
+        if (have_af[0]) samples.push_back(bytesToAddress(AF_INET, bytes));
+        if (have_af[1]) samples.push_back(bytesToAddress(AF_INET6, bytes));
+    }
+
+    RouteLookupTable original_table(original);
+    RouteLookupTable aggregated_table(aggregated);
+
+    for (vector<InetAddr>::iterator it=samples.begin(); it!=samples.end(); ++it)
+    {
+        int nh1 = original_table.lookup(*it);
+        int nh2 = aggregated_table.lookup(*it);
+        if (nh1 != nh2)
+        {
+            ostringstream str;
+            str << "Address " << it->toString()
+                << " matches route with next hop " << nh1
+                << " before aggregation and " << nh2 << " after";
+            error = str.str();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,137 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __ROUTE_AGGREGATOR_HH__
+#define __ROUTE_AGGREGATOR_HH__
+
+#include "fwbuilder/InetAddr.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+
+namespace fwcompiler
+{
+
+    /**
+     * Merges routes into the smallest set of prefixes that gives the
+     * same result of the longest prefix match for every address.
+     *
+     * Routes are identified by destination prefix and a "next hop"
+     * number, routes with the same next hop are interchangeable
+     * (same gateway, interface, metric and so on). The caller assigns
+     * these numbers. Two sibling prefixes with the same next hop are
+     * replaced with their parent prefix, a route that has the same
+     * next hop as the closest route that covers it is dropped.
+     * Prefixes that have several routes with different next hops
+     * (multipath) and pinned routes are never changed.
+     */
+    class RouteAggregator
+    {
+        public:
+
+        class Route
+        {
+            public:
+            libfwbuilder::InetAddr address;
+            int length;
+            int nexthop;
+
+            Route(const libfwbuilder::InetAddr &a, int len, int nh)
+            {
+                address = a;
+                length = len;
+                nexthop = nh;
+            }
+        };
+
+        private:
+
+        class Node
+        {
+            public:
+            int child[2];
+            std::set<int> nexthops;
+            std::vector<int> inputs;
+            bool pinned;
+
+            Node() { child[0] = child[1] = -1; pinned = false; }
+        };
+
+        std::vector<Route> routes;
+        std::vector<Node> nodes;
+
+        int value(int node);
+        int insert(int root, const Route &route);
+        void dropRedundant(int node, int inherited_value, int absorbing_node);
+        void mergeSiblings(int node, int depth);
+        void collect(int node, int af, int depth, unsigned char *prefix,
+                     std::vector<Route> &result,
+                     std::vector<int> &replaced_by);
+
+        public:
+
+        RouteAggregator() { nodes.resize(2); }
+
+        /**
+         * Adds route. Pinned routes stay in the result as they are
+         * and do not make other routes redundant. Use this for
+         * default routes and other routes that must be kept.
+         */
+        void addRoute(const libfwbuilder::InetAddr &address, int length,
+                      int nexthop, bool pinned=false);
+
+        /**
+         * Calculates aggregated routes. For every route added by
+         * addRoute (in the same order) replaced_by holds index of the
+         * route in result that replaces it. Call this method only once.
+         */
+        void aggregate(std::vector<Route> &result,
+                       std::vector<int> &replaced_by);
+
+        /**
+         * Returns next hop of the route that matches address or -1
+         * if there is no matching route. If the longest matching
+         * prefix has several routes with different next hops,
+         * returns -2.
+         */
+        static int lookup(const std::vector<Route> &routes,
+                          const libfwbuilder::InetAddr &address);
+
+        /**
+         * Compares results of the longest prefix match for two sets
+         * of routes. Checks the first, the last and a random address
+         * of each prefix, addresses right outside of each prefix and
+         * random_samples random addresses of each address family.
+         * Returns false and sets error if results differ.
+         */
+        static bool verify(const std::vector<Route> &original,
+                           const std::vector<Route> &aggregated,
+                           int random_samples, unsigned int seed,
+                           std::string &error);
+    };
+
+};
+
+#endif
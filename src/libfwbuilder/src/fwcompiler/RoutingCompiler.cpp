@@ -31,11 +31,13 @@
 #include <assert.h>
 
 #include "RoutingCompiler.h"
+#include "RouteAggregator.h"
 
 #include "fwbuilder/AddressTable.h"
 #include "fwbuilder/AddressRange.h"
 #include "fwbuilder/RuleElement.h"
 #include "fwbuilder/Network.h"
+#include "fwbuilder/NetworkIPv6.h"
 #include "fwbuilder/IPService.h"
 #include "fwbuilder/ICMPService.h"
 #include "fwbuilder/TCPService.h"
@@ -49,6 +51,7 @@
 #include "fwbuilder/InetAddr.h"
 #include "fwbuilder/IPRoute.h"
 #include "fwbuilder/Interface.h"
+#include "fwbuilder/Library.h"
 #include "fwbuilder/IPv4.h"
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/XMLTools.h"
@@ -204,6 +207,123 @@ bool RoutingCompiler::ConvertToAtomicForDST::processNext()
 }
 
 
+/*
+ * If destination of some rule is not an address or network (run-time
+ * object, interface that compilers for Cisco keep in RDst), we do not
+ * know which addresses it matches and leave all rules as they are.
+ * Default route is never merged with anything.
+ */
+bool RoutingCompiler::aggregateRoutes::processNext()
+{
+    slurp();
+    if (tmp_queue.size()==0) return false;
+
+    if (!compiler->fw->getOptionsObject()->getBool("aggregate_routes"))
+        return true;
+
+    RouteAggregator aggregator;
+    vector<RouteAggregator::Route> original;
+    vector<RoutingRule*> rules;
+    map<string, int> nexthops;
+
+    for (deque<Rule*>::iterator it=tmp_queue.begin(); it!=tmp_queue.end(); ++it)
+    {
+        RoutingRule *rule = RoutingRule::cast(*it);
+        Address *dst = Address::cast(
+            FWReference::getObject(rule->getRDst()->front()));
+        if (dst==NULL || MultiAddressRunTime::cast(dst)!=NULL ||
+            Interface::cast(dst)!=NULL ||
+            dst->getAddressPtr()==NULL || dst->getNetmaskPtr()==NULL)
+            return true;
+
+        const InetAddr *addr = dst->getAddressPtr();
+        int length = dst->getNetmaskPtr()->getLength();
+        if (dst->dimension()==1) length = addr->addressLengthBits();
+        bool pinned = (dst->isAny() || length==0);
+
+        FWObject *gtw = FWReference::getObject(rule->getRGtw()->front());
+        FWObject *itf = FWReference::getObject(rule->getRItf()->front());
+        ostringstream key;
+        key << gtw->getId() << "_" << itf->getId() << "_"
+            << rule->getMetricAsString() << "_"
+            << rule->getOptionsObject()->getBool("no_fail");
+        if (pinned) key << "_" << rules.size();
+
+        int nexthop;
+        map<string, int>::iterator i = nexthops.find(key.str());
+        if (i == nexthops.end())
+        {
+            nexthop = nexthops.size();
+            nexthops[key.str()] = nexthop;
+        } else
+            nexthop = i->second;
+
+        aggregator.addRoute(*addr, length, nexthop, pinned);
+        original.push_back(RouteAggregator::Route(*addr, length, nexthop));
+        rules.push_back(rule);
+    }
+
+    vector<RouteAggregator::Route> aggregated;
+    vector<int> replaced_by;
+    aggregator.aggregate(aggregated, replaced_by);
+
+    string err;
+    if (!RouteAggregator::verify(original, aggregated, 1000, 1, err))
+    {
+        compiler->warning("Aggregated routes do not match original ones, "
+                          "routes are not aggregated: " + err);
+        return true;
+    }
+
+    if (compiler->verbose)
+    {
+        ostringstream str;
+        str << " Aggregated " << original.size() << " routes into "
+            << aggregated.size();
+        compiler->info(str.str());
+    }
+
+    // aggregated route takes place of the first rule it replaces
+    tmp_queue.clear();
+    vector<bool> done(aggregated.size(), false);
+    for (unsigned int n=0; n<rules.size(); ++n)
+    {
+        int idx = replaced_by[n];
+        if (done[idx]) continue;
+        done[idx] = true;
+
+        RouteAggregator::Route &route = aggregated[idx];
+        if (route.length == original[n].length)
+        {
+            tmp_queue.push_back(rules[n]);
+            continue;
+        }
+
+        Address *net;
+        if (route.address.isV4()) net = compiler->dbcopy->createNetwork();
+        else net = compiler->dbcopy->createNetworkIPv6();
+        net->setAddress(route.address);
+        net->setNetmask(InetAddr(route.address.addressFamily(), route.length));
+        ostringstream name;
+        name << route.address.toString() << "/" << route.length;
+        net->setName(name.str());
+        compiler->persistent_objects->add(net);
+
+        RoutingRule *r = compiler->dbcopy->createRoutingRule();
+        compiler->temp_ruleset->add(r);
+        r->duplicate(rules[n]);
+
+        RuleElementRDst *dstrel = r->getRDst();
+        dstrel->clearChildren();
+        dstrel->addRef(net);
+
+        tmp_queue.push_back(r);
+    }
+
+    return true;
+}
+
+
 bool RoutingCompiler::ExpandGroups::processNext()
 {
     RoutingRule *rule=getNext(); if (rule==NULL) return false;
@@ -206,6 +206,17 @@ namespace fwcompiler
          */
         DECLARE_ROUTING_RULE_PROCESSOR(ConvertToAtomicForDST);
         
+        /**
+         * merges routes for adjacent and nested destinations that
+         * have the same gateway, interface and metric into the
+         * smallest set of routes that gives the same result of the
+         * longest prefix match. Verifies the result on sample
+         * addresses before using it. Active only if firewall option
+         * "aggregate_routes" is on. Needs slurp(), call after
+         * ConvertToAtomicForDST.
+         */
+        DECLARE_ROUTING_RULE_PROCESSOR(aggregateRoutes);
+
         /**
 	 * this class expands groups in dst. It creates
 	 * references to new objects "in place" (that is, it does not
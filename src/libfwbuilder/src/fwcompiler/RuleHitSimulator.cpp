@@ -0,0 +1,451 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "RuleHitSimulator.h"
+
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleSet.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <sys/time.h>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+// chains that jump to each other are cut off at this depth
+#define MAX_JUMP_DEPTH 64
+
+namespace
+{
+    /*
+     * xorshift generator, traces must not depend on the state of
+     * rand() or on the C library
+     */
+    class Random
+    {
+        uint64_t state;
+
+        public:
+
+        Random(unsigned seed)
+        {
+            state = 0x9e3779b97f4a7c15ULL ^ seed;
+            if (state == 0) state = 1;
+        }
+
+        uint64_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        // uniform in [first, last]
+        uint64_t next(uint64_t first, uint64_t last)
+        {
+            uint64_t span = last - first + 1;
+            if (span == 0) return next();
+            return first + next() % span;
+        }
+
+        double nextDouble()
+        {
+            return double(next() >> 11) / double(1ULL << 53);
+        }
+    };
+
+    InetAddrValue pickValue(Random &rnd, const AddressRangeSet &set)
+    {
+        const vector<InetRangeValue> &ranges = set.getRanges();
+        const InetRangeValue &r = ranges[rnd.next(0, ranges.size() - 1)];
+        InetAddrValue v = r.first;
+        if (r.first.hi == r.last.hi)
+        {
+            v.lo = rnd.next(r.first.lo, r.last.lo);
+            return v;
+        }
+        v.hi = rnd.next(r.first.hi, r.last.hi);
+        v.lo = rnd.next();
+        if (v < r.first) v = r.first;
+        if (r.last < v) v = r.last;
+        return v;
+    }
+
+    bool isReturn(Rule *rule)
+    {
+        PolicyRule *policy_rule = PolicyRule::cast(rule);
+        if (policy_rule) return policy_rule->getAction() == PolicyRule::Return;
+        NATRule *nat_rule = NATRule::cast(rule);
+        return (nat_rule && nat_rule->getRuleType() == NATRule::Return);
+    }
+
+    bool isBranch(Rule *rule)
+    {
+        PolicyRule *policy_rule = PolicyRule::cast(rule);
+        if (policy_rule) return policy_rule->getAction() == PolicyRule::Branch;
+        NATRule *nat_rule = NATRule::cast(rule);
+        return (nat_rule && nat_rule->getAction() == NATRule::Branch);
+    }
+
+    bool hitsGreater(const pair<long, int> &a, const pair<long, int> &b)
+    {
+        if (a.first != b.first) return a.first > b.first;
+        return a.second < b.second;
+    }
+}
+
+RuleHitSimulator::RuleHitSimulator(PolicyModel &m) : model(m)
+{
+    reset();
+}
+
+int RuleHitSimulator::getChain(const string &name)
+{
+    map<string, int>::iterator i = chain_index.find(name);
+    if (i != chain_index.end()) return i->second;
+    chains.push_back(Chain());
+    chains.back().name = name;
+    chain_index[name] = chains.size() - 1;
+    return chains.size() - 1;
+}
+
+int RuleHitSimulator::addEntry(int chain, Rule *rule,
+                               const vector<PolicyModel::Term> &terms,
+                               PolicyModel::Decision decision, int jump,
+                               bool returns)
+{
+    Entry e;
+    e.rule = rules.size();
+    e.jump = jump;
+    e.returns = returns;
+    e.decision = (jump < 0) ? decision : PolicyModel::NO_DECISION;
+    e.terms = terms;
+
+    ostringstream str;
+    str << chains[chain].name << " rule " << rule->getPosition();
+
+    rules.push_back(rule);
+    labels.push_back(str.str());
+    hits.push_back(0);
+    chains[chain].entries.push_back(e);
+    return e.rule;
+}
+
+int RuleHitSimulator::addRule(int chain, Rule *rule, int jump)
+{
+    if (rule->isDisabled()) return -1;
+
+    vector<PolicyModel::Term> terms;
+    model.buildTerms(rule, terms);
+    bool known;
+    return addEntry(chain, rule, terms, PolicyModel::getDecision(rule, known),
+                    jump, isReturn(rule));
+}
+
+int RuleHitSimulator::addRule(const string &chain, Rule *rule,
+                              const string &jump)
+{
+    int c = getChain(chain);
+    int j = jump.empty() ? -1 : getChain(jump);
+    return addRule(c, rule, j);
+}
+
+int RuleHitSimulator::addRule(const string &chain, Rule *rule,
+                              const vector<PolicyModel::Term> &terms,
+                              PolicyModel::Decision decision, bool returns,
+                              const string &jump)
+{
+    int c = getChain(chain);
+    int j = jump.empty() ? -1 : getChain(jump);
+    return addEntry(c, rule, terms, decision, j, returns);
+}
+
+int RuleHitSimulator::loadRuleSet(RuleSet *ruleset)
+{
+    map<RuleSet*, int>::iterator i = loaded_rulesets.find(ruleset);
+    if (i != loaded_rulesets.end()) return i->second;
+
+    int chain = getChain(ruleset->getName());
+    // register before loading rules so a branch back to this rule
+    // set does not load it again
+    loaded_rulesets[ruleset] = chain;
+
+    for (FWObject::iterator it=ruleset->begin(); it!=ruleset->end(); ++it)
+    {
+        Rule *rule = Rule::cast(*it);
+        if (rule == NULL) continue;
+        int jump = -1;
+        if (isBranch(rule) && !rule->isDisabled())
+        {
+            RuleSet *branch = rule->getBranch();
+            if (branch) jump = loadRuleSet(branch);
+        }
+        addRule(chain, rule, jump);
+    }
+    return chain;
+}
+
+int RuleHitSimulator::addRuleSet(RuleSet *ruleset)
+{
+    return loadRuleSet(ruleset);
+}
+
+/*
+ * Returns the decision or NO_DECISION if the packet falls off the
+ * end of the chain or hits a rule with action Return; the caller
+ * then continues with its next rule.
+ */
+PolicyModel::Decision RuleHitSimulator::classify(int chain,
+                                                 const PolicyModel::Packet &p,
+                                                 int depth, long *hit_counts,
+                                                 long &checked, int &rule) const
+{
+    if (depth > MAX_JUMP_DEPTH) return PolicyModel::NO_DECISION;
+
+    const vector<Entry> &entries = chains[chain].entries;
+    for (vector<Entry>::const_iterator e=entries.begin(); e!=entries.end(); ++e)
+    {
+        checked++;
+        bool match = false;
+        for (vector<PolicyModel::Term>::const_iterator t=e->terms.begin();
+             t!=e->terms.end() && !match; ++t)
+            match = t->contains(p);
+        if (!match) continue;
+
+        if (hit_counts) hit_counts[e->rule]++;
+
+        if (e->jump >= 0)
+        {
+            PolicyModel::Decision d = classify(e->jump, p, depth + 1,
+                                               hit_counts, checked, rule);
+            if (d != PolicyModel::NO_DECISION) return d;
+            continue;
+        }
+        if (e->returns) return PolicyModel::NO_DECISION;
+        if (e->decision != PolicyModel::NO_DECISION)
+        {
+            rule = e->rule;
+            return e->decision;
+        }
+    }
+    return PolicyModel::NO_DECISION;
+}
+
+/*
+ * ctx is the part of the header space that reaches the chain and has
+ * not been returned from it so far
+ */
+void RuleHitSimulator::flattenChain(int chain, vector<PolicyModel::Term> ctx,
+                                    int depth, PolicyModel &res) const
+{
+    if (depth > MAX_JUMP_DEPTH) return;
+
+    const vector<Entry> &entries = chains[chain].entries;
+    for (vector<Entry>::const_iterator e=entries.begin();
+         e!=entries.end() && !ctx.empty(); ++e)
+    {
+        vector<PolicyModel::Term> own;
+        PolicyModel::intersectTerms(e->terms, ctx, own);
+        if (own.empty()) continue;
+
+        if (e->jump >= 0)
+            flattenChain(e->jump, own, depth + 1, res);
+        else if (e->returns)
+        {
+            for (vector<PolicyModel::Term>::iterator t=own.begin();
+                 t!=own.end(); ++t)
+            {
+                vector<PolicyModel::Term> rest;
+                for (vector<PolicyModel::Term>::iterator c=ctx.begin();
+                     c!=ctx.end(); ++c)
+                    PolicyModel::subtractTerm(*c, *t, rest);
+                ctx.swap(rest);
+            }
+        } else if (e->decision != PolicyModel::NO_DECISION)
+            res.addTerms(rules[e->rule], own, e->decision);
+    }
+}
+
+void RuleHitSimulator::buildModel(const string &chain, PolicyModel &res) const
+{
+    map<string, int>::const_iterator ci = chain_index.find(chain);
+    if (ci == chain_index.end()) return;
+
+    vector<PolicyModel::Term> ctx(1);
+    for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+        ctx[0].field[d] = model.getDomain(PolicyModel::Dimension(d));
+    flattenChain(ci->second, ctx, 0, res);
+}
+
+void RuleHitSimulator::generateTrace(int n, unsigned seed,
+                                     vector<PolicyModel::Packet> &trace,
+                                     double background) const
+{
+    vector<const Entry*> targets;
+    for (vector<Chain>::const_iterator c=chains.begin(); c!=chains.end(); ++c)
+        for (vector<Entry>::const_iterator e=c->entries.begin();
+             e!=c->entries.end(); ++e)
+            if (!e->terms.empty()) targets.push_back(&(*e));
+
+    Random rnd(seed);
+    for (int i=0; i<n; ++i)
+    {
+        PolicyModel::Packet p(model.addressFamily());
+        if (targets.empty() || rnd.nextDouble() < background)
+        {
+            for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+                p.value[d] = pickValue(
+                    rnd, model.getDomain(PolicyModel::Dimension(d)));
+        } else
+        {
+            const Entry *e = targets[rnd.next(0, targets.size() - 1)];
+            const PolicyModel::Term &t = e->terms[rnd.next(0, e->terms.size() - 1)];
+            for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+                p.value[d] = pickValue(rnd, t.field[d]);
+        }
+        trace.push_back(p);
+    }
+}
+
+void RuleHitSimulator::run(const vector<PolicyModel::Packet> &trace,
+                           const string &chain)
+{
+    map<string, int>::const_iterator ci = chain_index.find(chain);
+    if (ci == chain_index.end() || trace.empty()) return;
+
+    // counted locally so that bookkeeping outside of the classifier
+    // does not get into the time
+    vector<long> run_decisions(PolicyModel::NO_TRANSLATION + 1, 0);
+    long checked = 0;
+    long *hit_counts = (hits.empty()) ? NULL : &hits[0];
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    for (vector<PolicyModel::Packet>::const_iterator p=trace.begin();
+         p!=trace.end(); ++p)
+    {
+        int rule = -1;
+        run_decisions[classify(ci->second, *p, 0, hit_counts, checked, rule)]++;
+    }
+    gettimeofday(&end, NULL);
+
+    seconds += (end.tv_sec - start.tv_sec) +
+        (end.tv_usec - start.tv_usec) / 1000000.0;
+    packets += trace.size();
+    evaluated += checked;
+    for (unsigned d=0; d<run_decisions.size(); ++d)
+        if (run_decisions[d]) decisions[PolicyModel::Decision(d)] += run_decisions[d];
+}
+
+PolicyModel::Decision RuleHitSimulator::evaluate(const PolicyModel::Packet &p,
+                                                 const string &chain,
+                                                 int *rule) const
+{
+    int r = -1;
+    long checked = 0;
+    PolicyModel::Decision d = PolicyModel::NO_DECISION;
+    map<string, int>::const_iterator ci = chain_index.find(chain);
+    if (ci != chain_index.end())
+        d = classify(ci->second, p, 0, NULL, checked, r);
+    if (rule) *rule = r;
+    return d;
+}
+
+void RuleHitSimulator::reset()
+{
+    fill(hits.begin(), hits.end(), 0);
+    decisions.clear();
+    packets = 0;
+    evaluated = 0;
+    seconds = 0;
+}
+
+string RuleHitSimulator::getRuleLabel(int n) const
+{
+    if (n < 0 || n >= int(labels.size())) return "default";
+    return labels[n];
+}
+
+long RuleHitSimulator::getDecisionCount(PolicyModel::Decision d) const
+{
+    map<PolicyModel::Decision, long>::const_iterator i = decisions.find(d);
+    return (i == decisions.end()) ? 0 : i->second;
+}
+
+double RuleHitSimulator::getAverageRulesEvaluated() const
+{
+    if (packets == 0) return 0;
+    return double(evaluated) / packets;
+}
+
+double RuleHitSimulator::getPacketsPerSecond() const
+{
+    if (seconds <= 0) return 0;
+    return packets / seconds;
+}
+
+vector<int> RuleHitSimulator::getDeadRules() const
+{
+    vector<int> res;
+    for (unsigned n=0; n<hits.size(); ++n)
+        if (hits[n] == 0) res.push_back(n);
+    return res;
+}
+
+vector<int> RuleHitSimulator::getHotRules(int n) const
+{
+    vector<pair<long, int> > by_hits;
+    for (unsigned r=0; r<hits.size(); ++r)
+        if (hits[r] > 0) by_hits.push_back(make_pair(hits[r], int(r)));
+    sort(by_hits.begin(), by_hits.end(), hitsGreater);
+
+    vector<int> res;
+    for (unsigned r=0; r<by_hits.size() && int(r)<n; ++r)
+        res.push_back(by_hits[r].second);
+    return res;
+}
+
+string RuleHitSimulator::toString() const
+{
+    ostringstream str;
+    str << "packets: " << packets << endl;
+    str << "rules evaluated per packet: " << getAverageRulesEvaluated() << endl;
+    str << "packets per second: " << long(getPacketsPerSecond()) << endl;
+    for (map<PolicyModel::Decision, long>::const_iterator i=decisions.begin();
+         i!=decisions.end(); ++i)
+        str << PolicyModel::decisionName(i->first) << ": " << i->second << endl;
+    for (unsigned n=0; n<hits.size(); ++n)
+    {
+        str << labels[n] << ": " << hits[n];
+        if (hits[n] == 0) str << " (dead)";
+        str << endl;
+    }
+    return str.str();
+}
@@ -0,0 +1,229 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __RULE_HIT_SIMULATOR_HH__
+#define __RULE_HIT_SIMULATOR_HH__
+
+#include "fwcompiler/PolicyModel.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+    class Rule;
+    class RuleSet;
+};
+
+namespace fwcompiler
+{
+
+    /**
+     * Classifier that replays packet traces through rules laid out
+     * in chains the way the firewall evaluates them: rules of a chain
+     * are checked in order, a rule that jumps to another chain
+     * evaluates that chain and continues with the next rule if the
+     * packet comes back, the first rule with terminating action
+     * decides. Counts hits of every rule, rules evaluated per packet
+     * and the rate at which the classifier processes packets, so the
+     * effect of rule layout can be measured without loading rules
+     * into the kernel.
+     *
+     * Rules can be added from rule sets, with Branch rules jumping
+     * to the chain of the branch rule set, or one by one with chain
+     * and jump target names, which is how compilers lay out rules
+     * after processing (for example iptables chain and target). Match
+     * part of the rules is converted by the PolicyModel the
+     * simulator is created with, warnings about things the model can
+     * not represent are collected there.
+     */
+    class RuleHitSimulator
+    {
+        public:
+
+        class Entry
+        {
+            public:
+            // number of the rule in the simulator
+            int rule;
+            std::vector<PolicyModel::Term> terms;
+            PolicyModel::Decision decision;
+            // chain the rule jumps to, -1 if none
+            int jump;
+            bool returns;
+        };
+
+        class Chain
+        {
+            public:
+            std::string name;
+            std::vector<Entry> entries;
+        };
+
+        private:
+
+        PolicyModel &model;
+        std::vector<Chain> chains;
+        std::map<std::string, int> chain_index;
+        std::map<libfwbuilder::RuleSet*, int> loaded_rulesets;
+
+        std::vector<libfwbuilder::Rule*> rules;
+        std::vector<std::string> labels;
+        std::vector<long> hits;
+        std::map<PolicyModel::Decision, long> decisions;
+        long packets;
+        long evaluated;
+        double seconds;
+
+        int addRule(int chain, libfwbuilder::Rule *rule, int jump);
+        int addEntry(int chain, libfwbuilder::Rule *rule,
+                     const std::vector<PolicyModel::Term> &terms,
+                     PolicyModel::Decision decision, int jump, bool returns);
+        int loadRuleSet(libfwbuilder::RuleSet *ruleset);
+        PolicyModel::Decision classify(int chain, const PolicyModel::Packet &p,
+                                       int depth, long *hit_counts,
+                                       long &checked, int &rule) const;
+        void flattenChain(int chain, std::vector<PolicyModel::Term> ctx,
+                          int depth, PolicyModel &res) const;
+
+        public:
+
+        RuleHitSimulator(PolicyModel &model);
+
+        /**
+         * returns index of the chain with this name, creating empty
+         * chain if there is none
+         */
+        int getChain(const std::string &name);
+        const std::vector<Chain>& getChains() const { return chains; }
+        PolicyModel& getModel() { return model; }
+
+        /**
+         * adds rule at the bottom of the chain. If jump is not empty,
+         * packets that match the rule are sent to the chain with this
+         * name, otherwise the action of the rule decides. Returns
+         * number of the rule or -1 if the rule is disabled.
+         */
+        int addRule(const std::string &chain, libfwbuilder::Rule *rule,
+                    const std::string &jump="");
+
+        /**
+         * adds rule at the bottom of the chain with the match and
+         * the decision given by the caller rather than taken from the
+         * rule. This is how rules that went through a compiler are
+         * added: the compiler decides what the rule does (for example
+         * iptables target), the rule only provides the label. If
+         * returns is true, packets that match go back to the calling
+         * chain. Returns number of the rule.
+         */
+        int addRule(const std::string &chain, libfwbuilder::Rule *rule,
+                    const std::vector<PolicyModel::Term> &terms,
+                    PolicyModel::Decision decision, bool returns,
+                    const std::string &jump="");
+
+        /**
+         * adds all rules of the rule set to the chain named after the
+         * rule set. Rules with action Branch jump to the chain of the
+         * branch rule set, which is loaded as well. Returns index of
+         * the chain.
+         */
+        int addRuleSet(libfwbuilder::RuleSet *ruleset);
+
+        /**
+         * makes a trace of n packets. Share of packets equal to
+         * background are picked uniformly from the whole header
+         * space, the rest are picked inside the match of a randomly
+         * chosen rule so that rules matching a tiny part of the
+         * header space get traffic too. The same seed produces the
+         * same trace.
+         */
+        void generateTrace(int n, unsigned seed,
+                           std::vector<PolicyModel::Packet> &trace,
+                           double background=0.1) const;
+
+        /**
+         * classifies every packet of the trace starting with the
+         * chain and adds results to the counters
+         */
+        void run(const std::vector<PolicyModel::Packet> &trace,
+                 const std::string &chain);
+
+        /**
+         * decision for one packet, does not change counters. If rule
+         * is not NULL, it is set to the number of the deciding rule
+         * or -1.
+         */
+        PolicyModel::Decision evaluate(const PolicyModel::Packet &p,
+                                       const std::string &chain,
+                                       int *rule=NULL) const;
+
+        /**
+         * Adds rules of the chain and of the chains it jumps to to
+         * res as one first-match list: rules of a chain a rule jumps
+         * to are restricted to packets the rule matches, rules after
+         * a returning rule are restricted to packets it does not
+         * match. res must be an empty model of the same firewall, it
+         * can then be compared with PolicyDecisionMap, which this way
+         * covers the chain layout as well.
+         */
+        void buildModel(const std::string &chain, PolicyModel &res) const;
+
+        /**
+         * clears hit counters and totals, rules stay
+         */
+        void reset();
+
+        int countRules() const { return rules.size(); }
+        libfwbuilder::Rule* getRule(int n) const { return rules[n]; }
+        /**
+         * "<chain> rule <position>"
+         */
+        std::string getRuleLabel(int n) const;
+
+        long getPackets() const { return packets; }
+        long getHits(int n) const { return hits[n]; }
+        long getDecisionCount(PolicyModel::Decision d) const;
+        double getAverageRulesEvaluated() const;
+        double getPacketsPerSecond() const;
+
+        /**
+         * rules that matched no packet of the traces run so far
+         */
+        std::vector<int> getDeadRules() const;
+
+        /**
+         * up to n rules with most hits, most hit first
+         */
+        std::vector<int> getHotRules(int n) const;
+
+        /**
+         * text report with totals and hits per rule
+         */
+        std::string toString() const;
+    };
+
+};
+
+#endif
@@ -19,6 +19,13 @@ SOURCES  = 	BaseCompiler.cpp \
 			PolicyCompiler.cpp \
 			ServiceRuleProcessors.cpp \
 			RoutingCompiler.cpp \
+			RouteAggregator.cpp \
+			AddressRangeSet.cpp \
+			PortRangeSet.cpp \
+			PolicyModel.cpp \
+			PolicyDecisionMap.cpp \
+			RuleHitSimulator.cpp \
+			ChunkedOutput.cpp \
 			GroupRegistry.cpp
 
 HEADERS  = 	BaseCompiler.h \
@@ -29,6 +36,13 @@ HEADERS  = 	BaseCompiler.h \
 			PolicyCompiler.h \
 			RuleProcessor.h \
 			RoutingCompiler.h \
+			RouteAggregator.h \
+			AddressRangeSet.h \
+			PortRangeSet.h \
+			PolicyModel.h \
+			PolicyDecisionMap.h \
+			RuleHitSimulator.h \
+			ChunkedOutput.h \
 			exceptions.h \
 			GroupRegistry.h
 
@@ -297,6 +297,7 @@ void PrintingController::printRuleSet(FWObject *fw,
         ruleView->setMaximumHeight(pr->getPageHeight());
 
         ruleView->restoreCollapsedGroups();
+        ruleView->calculateAllSizes();
 
         if (fwbdebug)
             qDebug("Viewport: %dx%d",
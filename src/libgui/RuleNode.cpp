@@ -30,7 +30,8 @@ RuleNode::RuleNode(Type type, const QString &str )
     this->type = type;
     this->name = str;
     parent = 0;
-
+    rule = 0;
+    resetSizes();
 }
 
 RuleNode::~RuleNode()
@@ -120,7 +121,10 @@ void RuleNode::resetSizes()
     for(int i=0;i<MAX_COLUMNS;i++)
     {
         sizes[i]=QSize();
+        displayData[i]=QVariant();
+        displayDataValid[i]=false;
     }
+    rowHeight = -1;
 }
 
 void RuleNode::resetAllSizes()
@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QSize>
+#include <QVariant>
 
 #define MAX_COLUMNS 20
 
@@ -50,6 +51,21 @@ public:
     libfwbuilder::Rule* rule;
     QSize sizes[MAX_COLUMNS];
 
+    /*
+     * Render cache. RuleSetModel keeps data returned for
+     * Qt::DisplayRole here so that it does not have to be rebuilt from
+     * the rule and its options every time the view repaints or
+     * measures a cell. Column 0 (rule number) is not cached since it
+     * changes whenever rules are added or moved above this one. Height
+     * of the row is cached separately because it can be calculated
+     * without measuring text, which lets the view lay out rows that
+     * have not been measured yet. Both are dropped by resetSizes()
+     * together with the cell sizes.
+     */
+    QVariant displayData[MAX_COLUMNS];
+    bool displayDataValid[MAX_COLUMNS];
+    int rowHeight;
+
     void prepend(RuleNode * node);
     void add(RuleNode* );
     void insert(int pos, RuleNode* node);
@@ -62,6 +78,7 @@ public:
     QString nameOfPredecessorGroup();
     void resetSizes();
     void resetAllSizes();
+    bool hasSizes() const { return sizes[0].isValid(); }
 
     bool operator==(const RuleNode &rn) const;
 };
@@ -52,7 +52,11 @@ void RuleSetDiffDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
 QSize RuleSetDiffDelegate::sizeHint(const QStyleOptionViewItem &option,
                                           const QModelIndex &index) const
 {
-    return RuleSetViewDelegate::sizeHint(option, m_model->mapToSource(index));
+    // diff dialog does not do background measuring like RuleSetView,
+    // measure the whole row right away
+    QModelIndex src = m_model->mapToSource(index);
+    calculateSizesForRow(option, src.sibling(src.row(), 0));
+    return RuleSetViewDelegate::sizeHint(option, src);
 }
 
 QString RuleSetDiffDelegate::getRuleColor(RuleNode *node) const
@@ -34,6 +34,7 @@
 
 #include <QtDebug>
 #include <QHash>
+#include <QSet>
 #include <QRegExp>
 #include <QMessageBox>
 #include <QTime>
@@ -283,7 +284,22 @@ QVariant RuleSetModel::getDataForDisplayRole(const QModelIndex &index) const {
     if (node->type == RuleNode::Group) {
         return getGroupDataForDisplayRole(index,node);
     } else if (node->type == RuleNode::Rule) {
-        return getRuleDataForDisplayRole(index,node);
+        int col = index.column();
+        // column 0 shows position of the rule, which changes when
+        // rules are inserted, removed or moved above it. It is cheap
+        // to build and is not cached.
+        if (col <= 0 || col >= MAX_COLUMNS)
+            return getRuleDataForDisplayRole(index,node);
+
+        // see RuleNode::displayData. The cache is dropped by
+        // RuleNode::resetSizes() which is called from rowChanged(),
+        // objectChanged() and resetAllSizes()
+        if (!node->displayDataValid[col])
+        {
+            node->displayData[col] = getRuleDataForDisplayRole(index,node);
+            node->displayDataValid[col] = true;
+        }
+        return node->displayData[col];
     }
 
     return QVariant();
@@ -1271,7 +1287,6 @@ int RuleSetModel::getRulePosition(QModelIndex index)
 
 void RuleSetModel::objectChanged(FWObject* object)
 {
-    Q_UNUSED(object)
 /*
  * See #2373
  *
@@ -1292,9 +1307,56 @@ void RuleSetModel::objectChanged(FWObject* object)
         emit dataChanged(index, index);
     }
 */
+
+    // Rows that show this object keep cached display data and sizes
+    // calculated for its old name, icon and so on. Drop the cache
+    // only for these rows so that the rest of the rule set does not
+    // have to be measured again.
+    QSet<RuleNode*> changed_nodes;
+    foreach(QModelIndex index, findObject(object))
+    {
+        RuleNode *node = nodeFromIndex(index);
+        if (node && !changed_nodes.contains(node))
+        {
+            node->resetSizes();
+            changed_nodes.insert(node);
+        }
+    }
+
+    if (fwbdebug)
+        qDebug() << "RuleSetModel::objectChanged"
+                 << "object=" << object->getName().c_str()
+                 << "rows affected:" << changed_nodes.size();
+
     emit layoutChanged();
 }
 
+QList<QModelIndex> RuleSetModel::getRowsWithoutSizes(int max_rows)
+{
+    QList<QModelIndex> list;
+    int row = 0;
+    foreach(RuleNode *node, root->children)
+    {
+        if (node->type == RuleNode::Rule)
+        {
+            if (!node->hasSizes()) list.append(createIndex(row, 0, node));
+        } else if (node->type == RuleNode::Group)
+        {
+            int group_row = 0;
+            foreach(RuleNode *child, node->children)
+            {
+                if (child->type == RuleNode::Rule && !child->hasSizes())
+                    list.append(createIndex(group_row, 0, child));
+                if (list.size() >= max_rows) return list;
+                group_row++;
+            }
+        }
+        if (list.size() >= max_rows) return list;
+        row++;
+    }
+    return list;
+}
+
 QModelIndexList RuleSetModel::findObject(FWObject* object)
 {
     QModelIndexList list;
@@ -173,6 +173,13 @@ public:
     void restoreRule(libfwbuilder::Rule* rule);
     void objectChanged(libfwbuilder::FWObject* object);
 
+    /**
+     * returns up to max_rows indexes (column 0) of rules whose cell
+     * sizes have not been calculated yet. Used by RuleSetView to
+     * measure rows in the background in small batches.
+     */
+    QList<QModelIndex> getRowsWithoutSizes(int max_rows);
+
 protected:
     libfwbuilder::RuleElement *getRuleElementByRole(libfwbuilder::Rule* r, std::string roleName) const;
 
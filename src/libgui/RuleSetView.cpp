@@ -72,6 +72,7 @@
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QTime>
+#include <QTimer>
 
 using namespace libfwbuilder;
 using namespace std;
@@ -123,6 +124,11 @@ RuleSetView::RuleSetView(ProjectPanel *project, QWidget *parent):QTreeView(paren
     this->setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
     this->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
     this->header()->setStretchLastSection(false);
+
+    size_calculation_timer = new QTimer(this);
+    size_calculation_timer->setInterval(0);
+    connect (size_calculation_timer, SIGNAL(timeout()),
+             this, SLOT(calculateSizesInBackground()));
 }
 
 RuleSetView::~RuleSetView()
@@ -2844,6 +2850,78 @@ bool RuleSetView::event( QEvent * event )
 
 void RuleSetView::resizeColumns()
 {
+    /*
+     * Cells are measured lazily (see RuleSetViewDelegate::sizeHint),
+     * only rows that are visible now are measured synchronously so
+     * that opening or updating a large rule set does not block. The
+     * rest are measured in small batches from the event loop by
+     * calculateSizesInBackground(), which resizes columns again once
+     * all rows have been measured.
+     */
+    calculateSizesForVisibleRows();
+    header()->resizeSections(QHeaderView::ResizeToContents);
+    if (!size_calculation_timer->isActive()) size_calculation_timer->start();
+}
+
+void RuleSetView::calculateSizesForVisibleRows()
+{
+    RuleSetViewDelegate *dlgt =
+        dynamic_cast<RuleSetViewDelegate*>(itemDelegate());
+    if (dlgt == NULL || model() == NULL) return;
+
+    QStyleOptionViewItem opt = viewOptions();
+    QModelIndex index = indexAt(viewport()->rect().topLeft());
+    int viewport_bottom = viewport()->rect().bottom();
+
+    while (index.isValid())
+    {
+        dlgt->calculateSizesForRow(opt, index.sibling(index.row(), 0));
+        if (visualRect(index).top() > viewport_bottom) break;
+        index = indexBelow(index);
+    }
+}
+
+void RuleSetView::calculateSizesInBackground()
+{
+    RuleSetViewDelegate *dlgt =
+        dynamic_cast<RuleSetViewDelegate*>(itemDelegate());
+    RuleSetModel* md = dynamic_cast<RuleSetModel*>(model());
+    if (dlgt == NULL || md == NULL)
+    {
+        size_calculation_timer->stop();
+        return;
+    }
+
+    QList<QModelIndex> rows = md->getRowsWithoutSizes(SIZE_CALCULATION_BATCH);
+
+    QStyleOptionViewItem opt = viewOptions();
+    foreach(QModelIndex index, rows)
+        dlgt->calculateSizesForRow(opt, index);
+
+    if (rows.size() < SIZE_CALCULATION_BATCH)
+    {
+        // all rows have been measured, now column widths can be
+        // calculated from real sizes of all cells
+        size_calculation_timer->stop();
+        header()->resizeSections(QHeaderView::ResizeToContents);
+    }
+}
+
+void RuleSetView::calculateAllSizes()
+{
+    RuleSetViewDelegate *dlgt =
+        dynamic_cast<RuleSetViewDelegate*>(itemDelegate());
+    RuleSetModel* md = dynamic_cast<RuleSetModel*>(model());
+    if (dlgt == NULL || md == NULL) return;
+
+    QStyleOptionViewItem opt = viewOptions();
+    QList<QModelIndex> rows;
+    while ( (rows = md->getRowsWithoutSizes(SIZE_CALCULATION_BATCH)).size() > 0)
+    {
+        foreach(QModelIndex index, rows)
+            dlgt->calculateSizesForRow(opt, index);
+    }
+    size_calculation_timer->stop();
     header()->resizeSections(QHeaderView::ResizeToContents);
 }
 
@@ -60,6 +60,7 @@ namespace libfwbuilder {
     class RoutingRule;
 }
 
+class QTimer;
 class ProjectPanel;
 class FWObjectSelectionModel;
 class RuleNode;
@@ -136,6 +137,13 @@ public:
     void addGenericMenuItemsToContextMenu(QMenu *menu) const;
 
     int selectedRulesCount() const  { return getSelectedRows().size(); }
+
+    /**
+     * measures all rows synchronously and resizes columns. Normally
+     * rows are measured in the background, this is for callers that
+     * need final column widths right away (e.g. printing).
+     */
+    void calculateAllSizes();
     
 public slots:
 
@@ -213,6 +221,8 @@ public slots:
     
     void updateObject(libfwbuilder::FWObject* object);
 
+    void calculateSizesInBackground();
+
     void compileCurrentRule();
     void updateSelectionSensitiveActions();
 
@@ -285,6 +295,11 @@ private:
 
     QMenu *popup_menu;
 
+    // number of rows measured by one run of calculateSizesInBackground()
+    static const int SIZE_CALCULATION_BATCH = 100;
+    QTimer *size_calculation_timer;
+    void calculateSizesForVisibleRows();
+
     libfwbuilder::FWObject *getObject(const QPoint &pos, const QModelIndex &index);
     libfwbuilder::FWObject *getObject(int number, const QModelIndex &index);
     int getObjectNumber(libfwbuilder::FWObject *object, const QModelIndex &index);
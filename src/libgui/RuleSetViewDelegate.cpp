@@ -474,24 +474,17 @@ QSize RuleSetViewDelegate::sizeHint(const QStyleOptionViewItem & option,
             return node->sizes[index.column()];
         }
 
-        res = calculateCellSizeForRule(newOpt, index, node) + QSize(1,1);
-        node->sizes[index.column()] = res;
-
-        // make sure cell height is equal to max height of all cells
-        // in the same row. See #2665
-        QSize tallest_cell = QSize(0, 0);
-        for (int c=0; c<=index.column(); ++c)
-        {
-            QSize cell_size = node->sizes[c];
-            if (cell_size.isValid())
-            {
-                int max_height = qMax(tallest_cell.height(), cell_size.height());
-                tallest_cell.setHeight(max_height);
-                node->sizes[c].setHeight(max_height);
-            }
-        }
-
-        return res;
+        /*
+         * The row has not been measured yet. QTreeView asks for size
+         * hints of all rows to calculate the height of the whole
+         * tree, measuring text of every cell of a large rule set here
+         * takes a lot of time. Row height does not depend on the
+         * width of the text, so return the height we can calculate
+         * cheaply and let RuleSetView measure rows that are visible
+         * (synchronously) and the rest (in the background) using
+         * calculateSizesForRow().
+         */
+        return QSize(0, calculateRowHeight(index, node));
     }
 
     //Fix for older Qt versions where width of spanned column is taken into accoun
@@ -500,6 +493,77 @@ QSize RuleSetViewDelegate::sizeHint(const QStyleOptionViewItem & option,
     return res;
 }
 
+void RuleSetViewDelegate::calculateSizesForRow(const QStyleOptionViewItem &option,
+                                               const QModelIndex &index) const
+{
+    if (!index.isValid()) return;
+    RuleNode *node = static_cast<RuleNode *>(index.internalPointer());
+    if (node == NULL || node->type != RuleNode::Rule) return;
+    if (node->hasSizes()) return;
+
+    QStyleOptionViewItem newOpt = option;
+    newOpt.font = st->getRulesFont();
+
+    int columns = qMin(index.model()->columnCount(index.parent()), MAX_COLUMNS);
+
+    // make sure cell height is equal to max height of all cells
+    // in the same row. See #2665
+    int row_height = calculateRowHeight(index, node);
+
+    for (int c=0; c<columns; ++c)
+    {
+        QModelIndex cell = index.sibling(index.row(), c);
+        QSize cell_size = calculateCellSizeForRule(newOpt, cell, node) + QSize(1,1);
+        cell_size.setHeight(row_height);
+        node->sizes[c] = cell_size;
+    }
+}
+
+int RuleSetViewDelegate::calculateRowHeight(const QModelIndex &index,
+                                            RuleNode *node) const
+{
+    if (node->rowHeight >= 0) return node->rowHeight;
+
+    int itemHeight = getItemHeight();
+    int h = itemHeight;
+
+    int columns = qMin(index.model()->columnCount(index.parent()), MAX_COLUMNS);
+
+    for (int c=1; c<columns; ++c)
+    {
+        QModelIndex cell = index.sibling(index.row(), c);
+        ColDesc colDesc = cell.data(Qt::UserRole).value<ColDesc>();
+
+        switch (colDesc.type)
+        {
+        case ColDesc::Object :
+        case ColDesc::Time :
+        {
+            // fast path: one line per object, no need to look at the text
+            RuleElement *re = (RuleElement *)cell.data(Qt::DisplayRole).value<void *>();
+            if (re == NULL) break;
+            int n = 0;
+            for (FWObject::iterator j=re->begin(); j!=re->end(); j++)
+                if (FWReference::getObject(*j) != NULL) n++;
+            h = qMax(h, n * itemHeight);
+            break;
+        }
+        case ColDesc::Options :
+            h = qMax(h, cell.data(Qt::DisplayRole).value<QStringList>().size() * itemHeight);
+            break;
+        case ColDesc::Comment :
+            h = qMax(h, calculateCellSizeForComment(cell).height());
+            break;
+        default :
+            // single line of text and an icon, never taller than itemHeight
+            break;
+        }
+    }
+
+    node->rowHeight = h + 1;
+    return node->rowHeight;
+}
+
 int RuleSetViewDelegate::getItemHeight(QString s, int flag, bool text)
 {
     QSize iconSize = getIconSize();
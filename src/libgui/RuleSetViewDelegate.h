@@ -62,6 +62,14 @@ public:
     QSize sizeHint (const QStyleOptionViewItem &, const QModelIndex & ) const;
 
     void setStandardHighlightColor(const QColor &c) { standard_highlight = c; }
+
+    /**
+     * measures all cells of the rule the index belongs to and stores
+     * results in RuleNode::sizes. Until this is done, sizeHint()
+     * returns only the height of the row (see calculateRowHeight())
+     */
+    void calculateSizesForRow(const QStyleOptionViewItem &option,
+                              const QModelIndex &index) const;
     
     static const int RULE_ITEM_GAP = 4;
 
@@ -83,6 +91,7 @@ private:
 
     DrawingContext initContext(QRect rect, bool useEnireSpace = false) const;
 
+    int calculateRowHeight(const QModelIndex &index, RuleNode *node) const;
     QSize calculateCellSizeForRule(const QStyleOptionViewItem & option, const QModelIndex & index, RuleNode * node ) const;
     QSize calculateCellSizeForObject(const QModelIndex & index) const;
     QSize calculateCellSizeForComment(const QModelIndex & index) const;    
@@ -52,7 +52,7 @@ void IC_FirewallNamePage::initializePage()
         dynamic_cast<ImportFirewallConfigurationWizard*>(wizard())-> platform;
 
     QStringList *buf = 
-        &(dynamic_cast<ImportFirewallConfigurationWizard*>(wizard())->buffer);
+        &(dynamic_cast<ImportFirewallConfigurationWizard*>(wizard())->preview);
 
     qDebug() << "platform=" << platform;
 
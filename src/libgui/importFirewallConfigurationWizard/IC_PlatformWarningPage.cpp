@@ -41,6 +41,7 @@
 
 using namespace std;
 
+#define PREVIEW_LINES 1000
 
 IC_PlatformWarningPage::IC_PlatformWarningPage(QWidget *parent) : QWizardPage(parent)
 {
@@ -85,17 +86,31 @@ void IC_PlatformWarningPage::initializePage()
         m_dialog->configFileBrowser->clear();
         m_dialog->platform->setText(tr("Unknown"));
 
-        QStringList *buf = &(wz->buffer);
+        /*
+         * Only the beginning of the file is loaded to show it and to
+         * recognize the platform, importer reads the file itself.
+         */
+        QStringList *buf = &(wz->preview);
         buf->clear();
 
         QTextStream stream(&cf);
+        bool truncated = false;
         while (true)
         {
-            QString line = stream.readLine().trimmed();
+            QString line = stream.readLine();
             if (line.isNull()) break;
+            if (buf->size() >= PREVIEW_LINES)
+            {
+                truncated = true;
+                break;
+            }
+            line = line.trimmed();
             m_dialog->configFileBrowser->append(line);
             *buf << line;
         }
+        if (truncated)
+            m_dialog->configFileBrowser->append(
+                tr("... (only the first %1 lines are shown)").arg(PREVIEW_LINES));
 
         QTextCursor cursor = m_dialog->configFileBrowser->textCursor();
         cursor.setPosition(0, QTextCursor::MoveAnchor);
@@ -110,6 +125,24 @@ void IC_PlatformWarningPage::initializePage()
         PreImport pi(buf);
         pi.scan();
 
+        /*
+         * Check for PF rules without "quick" needs all rules. pf.conf
+         * files are small, read the whole file in this case.
+         */
+        QStringList pf_buf;
+        if (truncated && pi.getPlatform() == PreImport::PF)
+        {
+            stream.seek(0);
+            while (true)
+            {
+                QString line = stream.readLine();
+                if (line.isNull()) break;
+                pf_buf << line.trimmed();
+            }
+            pi = PreImport(&pf_buf);
+            pi.scan();
+        }
+
         switch (pi.getPlatform())
         {
         case PreImport::UNKNOWN:
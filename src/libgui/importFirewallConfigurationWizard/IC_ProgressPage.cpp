@@ -142,13 +142,12 @@ void IC_ProgressPage::initializePage()
     QString firewallName = field("firewallName").toString();
     bool deduplicate = field("deduplicate").toBool();
 
-    QStringList *buffer = &(wz->buffer);
     QString fileName = field("fileName").toString();
 
     Library *lib = wz->currentLib();
     importer = new ImporterThread(this,
                                   lib,
-                                  *buffer, platform, firewallName, fileName,
+                                  platform, firewallName, fileName,
                                   deduplicate);
 
     // lists host_os_list and version_list are used-chosen host os and version.
@@ -49,7 +49,7 @@ class ImportFirewallConfigurationWizard : public QWizard
     QString platform;
     QList<QString> host_os_list;
     QList<QString> version_list;
-    QStringList buffer;
+    QStringList preview;  // first lines of the file
     libfwbuilder::Firewall *fw;
     libfwbuilder::FWObjectDatabase *db_orig;
     libfwbuilder::FWObjectDatabase *db_copy;
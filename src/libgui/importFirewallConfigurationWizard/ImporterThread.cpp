@@ -32,10 +32,12 @@
 #include "PIXImporter.h"
 #include "PFImporter.h"
 #include "objectMaker.h"
+#include "LineFilterStream.h"
 
 #include <QWidget>
 #include <QtDebug>
 
+#include <fstream>
 #include <sstream>
 
 
@@ -49,9 +51,30 @@ Logger& operator<<(Logger &logger, const QString &str)
     return logger;
 }
 
+/*
+ * The wizard scans and shows lines of the file with leading and
+ * trailing white space removed, importer should see the same text
+ * when it reads the file directly.
+ */
+class TrimLineFilter : public LineFilter
+{
+public:
+    virtual void filter(string &line)
+    {
+        const char *ws = " \t\r\n\v\f";
+        string::size_type first = line.find_first_not_of(ws);
+        if (first == string::npos)
+        {
+            line.clear();
+            return;
+        }
+        string::size_type last = line.find_last_not_of(ws);
+        line = line.substr(first, last - first + 1);
+    }
+};
+
 ImporterThread::ImporterThread(QWidget *ui,
                                FWObject *lib,
-                               const QStringList &buffer,
                                const QString &platform,
                                const QString &firewallName,
                                const QString &fileName,
@@ -59,12 +82,12 @@ ImporterThread::ImporterThread(QWidget *ui,
 {
     this->lib = lib;
     this->ui = ui;
-    this->buffer = buffer;
     this->platform = platform;
     this->firewallName = firewallName;
     this->fileName = fileName;
     this->deduplicate = deduplicate;
     importer = NULL;
+    fw = NULL;
     stopFlag = false;
     addStandardComments = false;
 }
@@ -96,10 +119,24 @@ void ImporterThread::run()
             this->ui, SLOT(logLine(QString)),
             Qt::QueuedConnection);
 
-    std::istringstream instream(buffer.join("\n").toStdString());
+    /*
+     * Importers read configuration from the file as the parser goes
+     * instead of making a copy of the whole file.
+     */
+    std::ifstream file_stream(fileName.toLocal8Bit().constData());
+    TrimLineFilter trim_filter;
+    LineFilterStream instream(file_stream, &trim_filter);
 
     importer = NULL;
 
+    if ( ! file_stream)
+    {
+        *logger << "Can not open file " << fileName << "\n";
+        if ( ! stopFlag) emit finished();
+        deleteLater();
+        return;
+    }
+
     if (platform == "iosacl") importer = new IOSImporter(
         lib, instream, logger, firewallName.toUtf8().constData());
 
@@ -144,7 +181,7 @@ void ImporterThread::run()
 
     if ( ! stopFlag)
     {
-        fw = importer->finalize();
+        if (importer) fw = importer->finalize();
         emit finished();
     }
 
@@ -47,7 +47,6 @@ class ImporterThread : public QThread
     libfwbuilder::FWObject *lib;
     Importer *importer;
     QString fileName;
-    QStringList buffer;
     QString firewallName;
     QString platform;
     bool deduplicate;
@@ -61,7 +60,6 @@ class ImporterThread : public QThread
 public:
     ImporterThread(QWidget *ui,
                    libfwbuilder::FWObject *lib,
-                   const QStringList &buffer,
                    const QString &platform,
                    const QString &firewallName,
                    const QString &fileName,
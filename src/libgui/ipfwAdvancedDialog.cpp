@@ -99,6 +99,10 @@ ipfwAdvancedDialog::ipfwAdvancedDialog(QWidget *parent,FWObject *o)
                          "check_shading");
     data.registerOption( m_dialog->ipfw_ignore_empty_groups, fwopt,
                          "ignore_empty_groups" );
+    data.registerOption( m_dialog->ipfw_use_tables, fwopt,
+                         "ipfw_use_tables" );
+    data.registerOption( m_dialog->ipfw_table_threshold, fwopt,
+                         "ipfw_table_threshold" );
     data.registerOption( m_dialog->ipfw_fw_dir, fwopt, "firewall_dir");
     data.registerOption( m_dialog->ipfw_user, fwopt, "admUser");
     data.registerOption( m_dialog->altAddress, fwopt, "altAddress");
@@ -138,7 +138,15 @@ iptAdvancedDialog::iptAdvancedDialog(QWidget *parent,FWObject *o)
                          fwoptions,"action_on_reject", slm);
 
     data.registerOption(m_dialog->useModuleSet, fwoptions, "use_m_set");
+    data.registerOption(m_dialog->useModuleSetForGroups, fwoptions,
+                        "use_m_set_for_groups");
+    data.registerOption(m_dialog->moduleSetGroupThreshold, fwoptions,
+                        "m_set_group_threshold");
     data.registerOption(m_dialog->useKernelTz, fwoptions, "use_kerneltz");
+    data.registerOption(m_dialog->useDecisionTree, fwoptions,
+                        "ipt_decision_tree_chains");
+    data.registerOption(m_dialog->packMultiportServices, fwoptions,
+                        "ipt_pack_multiport_services");
 
 
     data.registerOption(m_dialog->mgmt_ssh, fwoptions, "mgmt_ssh");
@@ -164,6 +172,8 @@ iptAdvancedDialog::iptAdvancedDialog(QWidget *parent,FWObject *o)
     data.registerOption(m_dialog->loadModules, fwoptions, "load_modules");
     data.registerOption(m_dialog->iptablesRestoreActivation,
                         fwoptions, "use_iptables_restore");
+    data.registerOption(m_dialog->nftablesActivation,
+                        fwoptions, "use_nftables");
     data.registerOption(m_dialog->ipt_fw_dir, fwoptions, "firewall_dir");
     data.registerOption(m_dialog->ipt_user, fwoptions, "admUser");
     data.registerOption(m_dialog->altAddress, fwoptions, "altAddress");
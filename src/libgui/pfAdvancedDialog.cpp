@@ -228,6 +228,8 @@ pfAdvancedDialog::pfAdvancedDialog(QWidget *parent,FWObject *o)
                          "preserve_group_names");
     data.registerOption( m_dialog->pf_ignore_empty_groups,fwopt,
                          "ignore_empty_groups");
+    data.registerOption( m_dialog->pf_optimize_skip_steps, fwopt,
+                         "pf_optimize_skip_steps");
 //    data.registerOption( pf_use_tables, fwopt, "use_tables");
     data.registerOption( m_dialog->pf_accept_new_tcp_with_no_syn,fwopt, "accept_new_tcp_with_no_syn");
     data.registerOption( m_dialog->pf_modulate_state,fwopt, "pf_modulate_state");
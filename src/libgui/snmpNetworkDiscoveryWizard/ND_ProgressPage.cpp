@@ -58,6 +58,8 @@ ND_ProgressPage::ND_ProgressPage(QWidget *parent) : QWizardPage(parent)
 
 #ifdef HAVE_LIBSNMP
     crawler = NULL;
+    hosts_processed = 0;
+    hosts_with_snmpd = 0;
 
     connect(m_dialog->discoveryStopButton, SIGNAL(clicked()), this, SLOT(stop()));
     connect(m_dialog->logSaveButton, SIGNAL(clicked()), this, SLOT(saveLog()));
@@ -157,6 +159,8 @@ void ND_ProgressPage::initializePage()
     QString snmpCommunity = field("snmpCommunity").toString();
     int snmpRetries = field("snmpRetries").toInt();
     int snmpTimeoutSec = field("snmpTimeout").toInt();
+    int snmpConcurrency = field("snmpConcurrency").toInt();
+    int snmpRequestInterval = field("snmpRequestInterval").toInt();
 
     QString seedHostAddress = getAddrByName(seedHostName, AF_INET);
     InetAddr seedHostInetAddr = InetAddr( seedHostAddress.toLatin1().constData() );
@@ -195,6 +199,11 @@ void ND_ProgressPage::initializePage()
     objects->clear();
     networks->clear();
 
+    hosts_processed = 0;
+    hosts_with_snmpd = 0;
+    added_addresses.clear();
+    m_dialog->discoveryStatus->setText("");
+
     emit completeChanged();
 
     // note that crawler deletes itself using call to deleteLater() after
@@ -206,12 +215,17 @@ void ND_ProgressPage::initializePage()
                                     snmpFollowP2P,
                                     snmpRetries,
                                     snmpTimeoutSec,
+                                    snmpConcurrency,
+                                    snmpRequestInterval,
                                     &include_networks);
 
     connect(crawler, SIGNAL(destroyed(QObject*)),
             this, SLOT(crawlerDestroyed(QObject*)));
     connect(crawler, SIGNAL(finished()),
             this, SLOT(crawlerFinished()));
+    connect(crawler, SIGNAL(hostProcessed(QString, QString, bool)),
+            this, SLOT(crawlerHostProcessed(QString, QString, bool)),
+            Qt::QueuedConnection);
 
     crawler->start();
 }
@@ -234,6 +248,35 @@ void ND_ProgressPage::stop()
     }
 }
 
+/*
+ * Crawler queries many hosts in parallel, this slot is called as soon
+ * as it is done with each one of them. Objects for the hosts are
+ * added to the list right away so they do not have to wait for the
+ * whole scan to finish.
+ */
+void ND_ProgressPage::crawlerHostProcessed(QString address, QString sysname,
+                                           bool have_snmpd)
+{
+    if (crawler != NULL)
+    {
+        map<InetAddr, CrawlerFind> hosts = crawler->takeProcessedHosts();
+        for (map<InetAddr, CrawlerFind>::iterator j=hosts.begin();
+             j!=hosts.end(); ++j)
+            addDiscoveredAddress(j->first, j->second);
+    }
+
+    hosts_processed++;
+    if (have_snmpd)
+    {
+        hosts_with_snmpd++;
+        logLine(tr("Host %1 (%2) responded to SNMP queries")
+                .arg(address).arg(sysname));
+    }
+    m_dialog->discoveryStatus->setText(
+        tr("Queried %1 hosts, %2 responded")
+        .arg(hosts_processed).arg(hosts_with_snmpd));
+}
+
 /*
  * SNMPCrawlerThread emits signal finished() that should be connected
  * to this slot. We collect all the data here.
@@ -245,15 +288,10 @@ void ND_ProgressPage::crawlerFinished()
     ObjectDescriptorList *networks = 
         dynamic_cast<SNMPNetworkDiscoveryWizard*>(wizard())->getNetworks();
 
-    ObjectDescriptorList *objects = 
-        dynamic_cast<SNMPNetworkDiscoveryWizard*>(wizard())->getObjects();
-
 
     logLine("\n");
     logLine(tr("Network crawler stopped"));
 
-    bool snmpDoDNS = field("snmpDoDNS").toBool();
-
     if (crawler==NULL) return;
 
     set<InetAddrMask>::iterator m;
@@ -291,45 +329,59 @@ void ND_ProgressPage::crawlerFinished()
 
     logLine(tr("Discovered %1 addresses").arg(discovered_addresses.size()));
 
-    int cntr = 0;
+    // hosts that have been queried are already in the list, here we
+    // only add addresses the crawler found but did not query
     map<InetAddr, CrawlerFind>::iterator j;
-    for(j = discovered_addresses.begin(); j!=discovered_addresses.end(); ++j,++cntr)
+    for(j = discovered_addresses.begin(); j!=discovered_addresses.end(); ++j)
     {
-        ObjectDescriptor od( &(j->second) );
-        od.addr = j->first;
-        od.type = (od.interfaces.size()>1) ? (Host::TYPENAME) : (IPv4::TYPENAME);
+        if (added_addresses.count(j->first) == 0)
+            addDiscoveredAddress(j->first, j->second);
+    }
 
-        od.isSelected = false;
+    emit completeChanged();
+}
 
-        if (od.sysname.empty())
-        {
-            od.sysname = string("h-") + od.addr.toString();
+void ND_ProgressPage::addDiscoveredAddress(const InetAddr &addr,
+                                           const CrawlerFind &host)
+{
+    ObjectDescriptorList *objects = 
+        dynamic_cast<SNMPNetworkDiscoveryWizard*>(wizard())->getObjects();
 
-            if (snmpDoDNS)
-            {
-                QString hostName = getNameByAddr( od.addr.toString().c_str() );
-                if (!hostName.isEmpty())
-                    od.sysname = hostName.toUtf8().constData();
-            }
+    bool snmpDoDNS = field("snmpDoDNS").toBool();
 
-            logLine(
-                QString(od.addr.toString().c_str()) + " : " + od.sysname.c_str());
-        }
+    added_addresses.insert(addr);
+
+    ObjectDescriptor od( &host );
+    od.addr = addr;
+    od.type = (od.interfaces.size()>1) ? (Host::TYPENAME) : (IPv4::TYPENAME);
+
+    od.isSelected = false;
 
-        if (snmpDoDNS && od.dns_info.aliases.size() > 0)
+    if (od.sysname.empty())
+    {
+        od.sysname = string("h-") + od.addr.toString();
+
+        if (snmpDoDNS)
         {
-            set<string>::iterator si;
-            for(si=od.dns_info.aliases.begin(); si!=od.dns_info.aliases.end(); ++si)
-            {
-                od.sysname = (*si);
-                objects->push_back(od);;
-            }
-        } else
-            objects->push_back(od);
+            QString hostName = getNameByAddr( od.addr.toString().c_str() );
+            if (!hostName.isEmpty())
+                od.sysname = hostName.toUtf8().constData();
+        }
 
+        logLine(
+            QString(od.addr.toString().c_str()) + " : " + od.sysname.c_str());
     }
 
-    emit completeChanged();
+    if (snmpDoDNS && od.dns_info.aliases.size() > 0)
+    {
+        set<string>::iterator si;
+        for(si=od.dns_info.aliases.begin(); si!=od.dns_info.aliases.end(); ++si)
+        {
+            od.sysname = (*si);
+            objects->push_back(od);;
+        }
+    } else
+        objects->push_back(od);
 }
 
 void ND_ProgressPage::logLine(const QString &buf)
@@ -32,8 +32,15 @@
 
 #include <QTextCharFormat>
 
+#include <set>
+
 class SNMPCrawlerThread;
 
+namespace libfwbuilder
+{
+    class CrawlerFind;
+};
+
 
 class ND_ProgressPage : public QWizardPage
 {
@@ -54,6 +61,12 @@ public:
 
 private:
     SNMPCrawlerThread *crawler;
+    int hosts_processed;
+    int hosts_with_snmpd;
+    std::set<libfwbuilder::InetAddr> added_addresses;
+
+    void addDiscoveredAddress(const libfwbuilder::InetAddr &addr,
+                              const libfwbuilder::CrawlerFind &host);
 
     virtual void initializePage();
     virtual void cleanupPage();
@@ -67,6 +80,7 @@ public slots:
     void logLine(const QString &line);
     void crawlerDestroyed(QObject*);
     void crawlerFinished();
+    void crawlerHostProcessed(QString address, QString sysname, bool have_snmpd);
 #endif
 };
 
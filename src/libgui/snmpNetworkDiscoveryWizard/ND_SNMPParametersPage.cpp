@@ -39,6 +39,8 @@ using namespace std;
 #define DISCOVERY_DRUID_SNMPCOMMUNITY "SNMPCommunity"
 #define DISCOVERY_DRUID_SNMPRETRIES "SNMPRetries"
 #define DISCOVERY_DRUID_SNMPTIMEOUT "SNMPTimeout"
+#define DISCOVERY_DRUID_SNMPCONCURRENCY "SNMPConcurrency"
+#define DISCOVERY_DRUID_SNMPREQUESTINTERVAL "SNMPRequestInterval"
 
 
 ND_SNMPParametersPage::ND_SNMPParametersPage(QWidget *parent) : QWizardPage(parent)
@@ -58,9 +60,19 @@ ND_SNMPParametersPage::ND_SNMPParametersPage(QWidget *parent) : QWizardPage(pare
         QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPTIMEOUT);
     m_dialog->snmpTimeout->setValue((i)?i:2);
 
+    i = st->getInt(
+        QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPCONCURRENCY);
+    m_dialog->snmpConcurrency->setValue((i)?i:16);
+
+    i = st->getInt(
+        QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPREQUESTINTERVAL);
+    m_dialog->snmpRequestInterval->setValue(i);
+
     registerField("snmpCommunity", m_dialog->snmpCommunity);
     registerField("snmpRetries", m_dialog->snmpRetries);
     registerField("snmpTimeout", m_dialog->snmpTimeout);
+    registerField("snmpConcurrency", m_dialog->snmpConcurrency);
+    registerField("snmpRequestInterval", m_dialog->snmpRequestInterval);
 }
 
 void ND_SNMPParametersPage::initializePage()
@@ -80,6 +92,12 @@ bool ND_SNMPParametersPage::validatePage()
     st->setInt(
             QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPTIMEOUT,
             m_dialog->snmpTimeout->value());
+    st->setInt(
+            QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPCONCURRENCY,
+            m_dialog->snmpConcurrency->value());
+    st->setInt(
+            QString(DISCOVERY_DRUID_PREFIX) + DISCOVERY_DRUID_SNMPREQUESTINTERVAL,
+            m_dialog->snmpRequestInterval->value());
 
     return true;
 }
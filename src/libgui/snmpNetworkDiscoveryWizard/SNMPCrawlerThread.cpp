@@ -41,6 +41,25 @@ using namespace std;
 using namespace libfwbuilder;
 
 
+/*
+ * Passes results for each host to the GUI as soon as the crawler has
+ * them, rather than at the end of the scan
+ */
+class StreamingSNMPCrawler : public SNMPCrawler
+{
+    SNMPCrawlerThread *thread;
+
+public:
+    StreamingSNMPCrawler(SNMPCrawlerThread *t) : SNMPCrawler() { thread = t; }
+
+protected:
+    virtual void hostProcessed(const InetAddr &addr, const CrawlerFind &host)
+    {
+        thread->reportHost(addr, host);
+    }
+};
+
+
 SNMPCrawlerThread::SNMPCrawlerThread(QWidget *ui,
                                      const QString &seedHostName,
                                      const QString &community,
@@ -48,16 +67,19 @@ SNMPCrawlerThread::SNMPCrawlerThread(QWidget *ui,
                                      bool followP2P,
                                      int snmpRetries,
                                      int snmpTimeout,
+                                     int snmpConcurrency,
+                                     int snmpRequestInterval,
                                      const std::vector<InetAddrMask> *include_net)
 {
     this->ui = ui;
 
     stop_flag = new SyncFlag();
+    processed_hosts = new map<InetAddr, CrawlerFind>();
 
     QString seedHostAddress = getAddrByName(seedHostName, AF_INET);
     InetAddr seedHostInetAddr = InetAddr( seedHostAddress.toLatin1().constData());
 
-    q = new SNMPCrawler();
+    q = new StreamingSNMPCrawler(this);
     q->init(seedHostInetAddr,
             community.toLatin1().constData(),
             recursive,
@@ -69,7 +91,7 @@ SNMPCrawlerThread::SNMPCrawlerThread(QWidget *ui,
             0,
             0,
             (include_net->size() > 0) ? include_net : NULL);
-
+    q->setConcurrency(snmpConcurrency, snmpRequestInterval);
 }
 
 SNMPCrawlerThread::~SNMPCrawlerThread()
@@ -77,6 +99,7 @@ SNMPCrawlerThread::~SNMPCrawlerThread()
     if (fwbdebug) qDebug() << "SNMPCrawlerThread::~SNMPCrawlerThread()";
     delete q;
     delete stop_flag;
+    delete processed_hosts;
 }
 
 void SNMPCrawlerThread::run()
@@ -107,4 +130,25 @@ set<InetAddrMask> SNMPCrawlerThread::getNetworks()
     return q->getNetworks();
 }
 
+map<InetAddr, CrawlerFind> SNMPCrawlerThread::takeProcessedHosts()
+{
+    map<InetAddr, CrawlerFind> res;
+    processed_hosts_mutex.lock();
+    res.swap(*processed_hosts);
+    processed_hosts_mutex.unlock();
+    return res;
+}
+
+void SNMPCrawlerThread::reportHost(const InetAddr &addr,
+                                   const CrawlerFind &host)
+{
+    processed_hosts_mutex.lock();
+    (*processed_hosts)[addr] = host;
+    processed_hosts_mutex.unlock();
+
+    emit hostProcessed(addr.toString().c_str(),
+                       QString::fromUtf8(host.sysname.c_str()),
+                       host.have_snmpd);
+}
+
 #endif
@@ -55,6 +55,14 @@ class SNMPCrawlerThread : public QThread
     libfwbuilder::SNMPCrawler *q;
     libfwbuilder::SyncFlag *stop_flag;
 
+    /*
+     * Hosts the crawler is done with that have not been picked up by
+     * the GUI yet. Guarded by processed_hosts_mutex since it is
+     * filled in the crawler thread.
+     */
+    std::map<libfwbuilder::InetAddr, libfwbuilder::CrawlerFind> *processed_hosts;
+    libfwbuilder::Mutex processed_hosts_mutex;
+
     QWidget *ui;
     
 public:
@@ -65,6 +73,8 @@ public:
                       bool followP2P,
                       int snmpRetries,
                       int snmpTimeout,
+                      int snmpConcurrency,
+                      int snmpRequestInterval,
                       const std::vector<libfwbuilder::InetAddrMask> *include);
     virtual ~SNMPCrawlerThread();
 
@@ -73,9 +83,24 @@ public:
 
     std::map<libfwbuilder::InetAddr, libfwbuilder::CrawlerFind>  getAllIPs();
     std::set<libfwbuilder::InetAddrMask> getNetworks();
+
+    /**
+     * Returns hosts processed since the last call and removes them
+     * from the queue. Called by the GUI in response to signal
+     * hostProcessed()
+     */
+    std::map<libfwbuilder::InetAddr, libfwbuilder::CrawlerFind> takeProcessedHosts();
+
+    /**
+     * Called by the crawler in this thread every time it is done
+     * with a host. Queues the host and emits signal hostProcessed()
+     */
+    void reportHost(const libfwbuilder::InetAddr &addr,
+                    const libfwbuilder::CrawlerFind &host);
     
 signals:
     void finished();
+    void hostProcessed(QString address, QString sysname, bool have_snmpd);
 };
 
 #endif
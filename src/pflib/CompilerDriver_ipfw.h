@@ -51,6 +51,7 @@ namespace fwcompiler {
     class CompilerDriver_ipfw : public CompilerDriver_pf
     {
         QStringList activation_commands;
+        QString table_swap_commands;
 
 protected:
         virtual QString assembleManifest(libfwbuilder::Cluster *cluster,
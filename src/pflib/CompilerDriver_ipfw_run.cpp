@@ -39,6 +39,7 @@
 #include "CompilerDriver_ipfw.h"
 #include "PolicyCompiler_ipfw.h"
 #include "AutomaticRules_pf.h"
+#include "TableFactory_ipfw.h"
 
 #include "OSConfigurator_freebsd.h"
 #include "OSConfigurator_macosx.h"
@@ -102,6 +103,8 @@ QString CompilerDriver_ipfw::assembleFwScript(Cluster *cluster,
     assembleFwScriptInternal(
         cluster, fw, cluster_member, oscnf,
         &script_skeleton, &top_comment, "#", true);
+    script_skeleton.setVariable("have_tables", !table_swap_commands.isEmpty());
+    script_skeleton.setVariable("table_swap_commands", table_swap_commands);
     return script_skeleton.expand();
 }
 
@@ -164,6 +167,9 @@ QString CompilerDriver_ipfw::run(const std::string &cluster_id,
         int policy_rules_count  = 0;
         int ipfw_rule_number = 0;
 
+        // tables are shared by all rule sets and both address families
+        TableFactory_ipfw ipfw_tables;
+
         findImportedRuleSets(fw, all_policies);
 
         try
@@ -247,6 +253,7 @@ QString CompilerDriver_ipfw::run(const std::string &cluster_id,
 
                 PolicyCompiler_ipfw c(objdb, fw, ipv6_policy, oscnf.get());
                 c.setIPFWNumber(ipfw_rule_number);
+                c.setTableFactory(&ipfw_tables);
                 c.setSourceRuleSet( policy );
                 c.setRuleSetName(branch_name);
                 c.setPersistentObjects(persistent_objects);
@@ -311,6 +318,11 @@ QString CompilerDriver_ipfw::run(const std::string &cluster_id,
             all_errors.push_front(getErrors("").c_str());
         }
 
+        // tables must be created before rules that use them
+        generated_script = ipfw_tables.PrintTables() + generated_script;
+        table_swap_commands =
+            QString::fromUtf8(ipfw_tables.PrintTableSwap().c_str());
+
         if (single_rule_compile_on)
         {
             return formSingleRuleCompileOutput(
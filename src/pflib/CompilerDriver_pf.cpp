@@ -68,6 +68,20 @@ CompilerDriver* CompilerDriver_pf::clone()
     return new_cd;
 }
 
+/*
+ * CARP advskew of the master member differs from that of other
+ * members, so the master is always compiled on its own. Drivers for
+ * ipfilter and ipfw inherit this class but have not been verified
+ * with member specialization.
+ */
+bool CompilerDriver_pf::isMemberSpecializationSupported(Cluster *cluster,
+                                                        Firewall *compiled_fw,
+                                                        Firewall *fw)
+{
+    return (compiled_fw->getStr("platform") == "pf" &&
+            haveSameClusterRoles(cluster, compiled_fw, fw));
+}
+
 /*
  * Generate file name for the ruleset .conf file using general conf
  * file name as a prototype.
@@ -32,6 +32,8 @@
 #include "OSData.h"
 #include "Configlet.h"
 
+#include "fwcompiler/ChunkedOutput.h"
+
 #include <string>
 #include <sstream>
 #include <memory>
@@ -50,11 +52,11 @@ namespace libfwbuilder {
 };
 
 
-class MapOstringStream : public std::map<QString, std::ostringstream*>
+class MapChunkedOutput : public std::map<QString, fwcompiler::ChunkedOutput*>
 {
   public:
-    MapOstringStream() {}
-    ~MapOstringStream();
+    MapChunkedOutput() {}
+    ~MapChunkedOutput();
     void clear();
 };
 
@@ -88,8 +90,8 @@ namespace fwcompiler
 //        std::map<QString, QString> remote_conf_files;
 
 // map ruleset_name -> generated script
-//    std::map<std::string, std::ostringstream*> generated_scripts;
-        MapOstringStream generated_scripts;
+//    std::map<std::string, fwcompiler::ChunkedOutput*> generated_scripts;
+        MapChunkedOutput generated_scripts;
     
 // map ruleset_name -> TableFactory*
 //    std::map<std::string, fwcompiler::TableFactory*> table_factories;
@@ -140,6 +142,11 @@ protected:
                                          libfwbuilder::Firewall* fw,
                                          bool cluster_member);
 
+        virtual bool isMemberSpecializationSupported(
+            libfwbuilder::Cluster *cluster,
+            libfwbuilder::Firewall *compiled_fw,
+            libfwbuilder::Firewall *fw);
+
 public:
 
         CompilerDriver_pf(libfwbuilder::FWObjectDatabase *db);
@@ -423,7 +423,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
             if (ipv4_run) ipv4_6_runs.push_back(AF_INET);
         }
 
-        ostringstream* main_str = new ostringstream();
+        ChunkedOutput* main_str = new ChunkedOutput();
         list<NATCompiler_pf::redirectRuleInfo> redirect_rules_info;
 
         for (vector<int>::iterator i=ipv4_6_runs.begin();
@@ -497,7 +497,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
                 } else
                 {
                     if (generated_scripts.count(ruleset_name) == 0)
-                        generated_scripts[ruleset_name] = new ostringstream();
+                        generated_scripts[ruleset_name] = new ChunkedOutput();
                 }
 
                 if (n.getCompiledScriptLength() > 0)
@@ -514,7 +514,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
                             *(generated_scripts[ruleset_name]) << n.getErrors("# ");
                         }
                     }
-                    *(generated_scripts[ruleset_name]) << n.getCompiledScript();
+                    n.appendCompiledScript(*(generated_scripts[ruleset_name]));
                     *(generated_scripts[ruleset_name]) << endl;
                 }
 
@@ -585,7 +585,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
                 } else
                 {
                     if (generated_scripts.count(ruleset_name) == 0)
-                        generated_scripts[ruleset_name] = new ostringstream();
+                        generated_scripts[ruleset_name] = new ChunkedOutput();
                 }
 
                 if (c.getCompiledScriptLength() > 0)
@@ -600,7 +600,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
                             *(generated_scripts[ruleset_name]) << c.getErrors("# ");
                         }
                     }
-                    *(generated_scripts[ruleset_name]) << c.getCompiledScript();
+                    c.appendCompiledScript(*(generated_scripts[ruleset_name]));
                     *(generated_scripts[ruleset_name]) << endl;
                 }
 
@@ -670,11 +670,11 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
             QString buffer;
             QTextStream pf_str(&buffer);
 
-            for (map<QString, ostringstream*>::iterator fi=generated_scripts.begin();
+            for (MapChunkedOutput::iterator fi=generated_scripts.begin();
                  fi!=generated_scripts.end(); fi++)
             {
                 QString ruleset_name = fi->first;
-                ostringstream *strm = fi->second;
+                ChunkedOutput *strm = fi->second;
                 pf_str << table_factories[ruleset_name]->PrintTables();
                 pf_str << QString::fromUtf8(strm->str().c_str());
                 pf_str << QString::fromUtf8(routing_script.c_str());
@@ -695,7 +695,7 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
             QString ruleset_name = it.key();
             if (ruleset_name == "__main__") continue;
             QString remote_file_name = it.value();
-            ostringstream *ostr = generated_scripts["__main__"];
+            ChunkedOutput *ostr = generated_scripts["__main__"];
             // note that ostr can be NULL if the firewall we are
             // trying to compile has no top-level rule sets
             if (ostr == NULL) continue;
@@ -710,12 +710,12 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
          */
 
         idx = CONF1_FILE;
-        for (map<QString, ostringstream*>::iterator fi=generated_scripts.begin();
+        for (MapChunkedOutput::iterator fi=generated_scripts.begin();
              fi!=generated_scripts.end(); fi++)
         {
             QString ruleset_name = fi->first;
             QString file_name = rulesets_to_file_names[ruleset_name]; // file_names[idx];
-            ostringstream *strm = fi->second;
+            ChunkedOutput *strm = fi->second;
 
             if (strm==NULL) continue;
 
@@ -724,41 +724,43 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
             file_name = getAbsOutputFileName(file_name);
 
             info("Output file name: " + file_name.toStdString());
-            QFile pf_file(file_name);
-            if (pf_file.open(QIODevice::WriteOnly))
+
+            // options and tables are small and are assembled in a
+            // string, generated rules are written from the chunks
+            // compilers put them in
+            QString header_buffer;
+            QTextStream pf_str(&header_buffer, QIODevice::WriteOnly);
+
+            if (ruleset_name == "__main__")
             {
-                QTextStream pf_str(&pf_file);
+                printStaticOptions(pf_str, fw);
 
-                if (ruleset_name == "__main__")
-                {
-                    printStaticOptions(pf_str, fw);
+                // attach persistent_tables subtree inside TableFactory object
+                // to the object tree
+                table_factories[ruleset_name]->init(objdb);
 
-                    // attach persistent_tables subtree inside TableFactory object
-                    // to the object tree
-                    table_factories[ruleset_name]->init(objdb);
+                pf_str << table_factories[ruleset_name]->PrintTables();
 
-                    pf_str << table_factories[ruleset_name]->PrintTables();
+                if (prolog_place == "pf_file_after_tables")
+                    printProlog(pf_str, pre_hook);
+            } else 
+            {
+                pf_str << table_factories[ruleset_name]->PrintTables();
+            }
+            pf_str.flush();
 
-                    if (prolog_place == "pf_file_after_tables")
-                        printProlog(pf_str, pre_hook);
-                } else 
-                {
-                    pf_str << table_factories[ruleset_name]->PrintTables();
-                }
+            ChunkedOutput conf;
+            conf << header_buffer.toUtf8().constData();
+            conf.append(*strm);
 
-                pf_str << QString::fromUtf8(strm->str().c_str());
-                pf_file.close();
-            } else
+            QString err = writeOutputFile(file_name, conf);
+            if (!err.isEmpty())
             {
                 // clear() calls destructors of all elements in the container
                 table_factories.clear();
                 generated_scripts.clear();
 
-                QString err("Failed to open file %1 for writing: %2; "
-                            "Current dir: %3");
-                abort(err.arg(pf_file.fileName())
-                      .arg(pf_file.error())
-                      .arg(QDir::current().path()).toStdString());
+                abort(err.toStdString());
             }
 
             idx++;
@@ -810,17 +812,17 @@ QString CompilerDriver_pf::run(const std::string &cluster_id,
     return "";
 }
 
-MapOstringStream::~MapOstringStream()
+MapChunkedOutput::~MapChunkedOutput()
 {
     clear();
 }
 
-void MapOstringStream::clear()
+void MapChunkedOutput::clear()
 {
-    std::map<QString, std::ostringstream*>::iterator it;
+    std::map<QString, fwcompiler::ChunkedOutput*>::iterator it;
     for (it=begin(); it!=end(); ++it)
         delete it->second;
-    std::map<QString, std::ostringstream*>::clear();
+    std::map<QString, fwcompiler::ChunkedOutput*>::clear();
 }
 
 MapTableFactory::~MapTableFactory()
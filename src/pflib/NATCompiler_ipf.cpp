@@ -209,8 +209,8 @@ bool NATCompiler_ipf::AssignInterface::processNext()
             tmp_queue.push_back( rule );
             return true;
         }
-/* slip into Redirect case to assign rule to all interfaces */
     }
+/* fall through - slip into Redirect case to assign rule to all interfaces */
 
     case NATRule::Redirect: 
     case NATRule::DNAT:
@@ -134,8 +134,8 @@ bool PolicyCompiler_ipf::doSrcNegation::processNext()
 	r->setLogging(false);
         nsrc=r->getSrc();
         nsrc->setNeg(false);
-	r->setBool("quick",false);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,false);
+        r->setBool(pf_skip_check_for_duplicates,true);
         ruleopt = r->getOptionsObject();
         ruleopt->setBool("stateless", true);
 	tmp_queue.push_back(r);
@@ -147,8 +147,8 @@ bool PolicyCompiler_ipf::doSrcNegation::processNext()
         nsrc->setNeg(false);
 	nsrc->clearChildren();
 	nsrc->setAnyElement();
-	r->setBool("quick",true);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,true);
+        r->setBool(pf_skip_check_for_duplicates,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -175,8 +175,8 @@ bool PolicyCompiler_ipf::doDstNegation::processNext()
 	r->setLogging(false);
         ndst=r->getDst();
         ndst->setNeg(false);
-	r->setBool("quick",false);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,false);
+        r->setBool(pf_skip_check_for_duplicates,true);
         ruleopt = r->getOptionsObject();
         ruleopt->setBool("stateless", true);
 	tmp_queue.push_back(r);
@@ -188,8 +188,8 @@ bool PolicyCompiler_ipf::doDstNegation::processNext()
         ndst->setNeg(false);
 	ndst->clearChildren();
 	ndst->setAnyElement();
-	r->setBool("quick",true);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,true);
+        r->setBool(pf_skip_check_for_duplicates,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -295,7 +295,7 @@ bool PolicyCompiler_ipf::calculateSkip::processNext()
         if (r->getAction()==PolicyRule::Continue) 
         {
             r->setAction(PolicyRule::Skip);
-            r->setBool("quick",false);
+            r->setBool(pf_quick,false);
             
             deque<Rule*>::iterator j=k;
             ++j;
@@ -341,12 +341,12 @@ bool PolicyCompiler_ipf::eliminateDuplicateRules::processNext()
     Interface *intf_rule = compiler->getFirstItf(rule);
     int intf_id_rule = (intf_rule) ? intf_rule->getId() : -1;
 
-    if ( ! rule->getBool("skip_check_for_duplicates"))
+    if ( ! rule->getBool(pf_skip_check_for_duplicates))
     {
         for (deque<PolicyRule*>::iterator i=rules_seen_so_far.begin(); i!=rules_seen_so_far.end(); ++i)
         {
             PolicyRule *r=(*i);
-            if (r->getBool("skip_check_for_duplicates") ) continue;
+            if (r->getBool(pf_skip_check_for_duplicates) ) continue;
             if (r->getAction()==PolicyRule::Continue ||
                 r->getAction()==PolicyRule::Skip) continue;
 
@@ -594,7 +594,7 @@ string PolicyCompiler_ipf::debugPrintRule(Rule *r)
 
     s << " ";
 
-    if (r->getBool("skip_check_for_duplicates")) s << "skip_check_for_duplicates ";
+    if (r->getBool(pf_skip_check_for_duplicates)) s << "skip_check_for_duplicates ";
     if (r->getStr("skip_label")!="")             s << "skip_label: " << r->getStr("skip_label") << " ";
     if (r->getStr("skip_to")!="")                s << "skip_to: "    << r->getStr("skip_to")    << " ";
     if (r->getInt("no_to_skip")!=-1)             s << "no_to_skip: " << r->getInt("no_to_skip");
@@ -81,7 +81,7 @@ void PolicyCompiler_ipf::optimize1::optimizeForRuleElement(PolicyRule *rule,
         }
     }
     r->setAction(PolicyRule::Skip);
-    r->setBool("quick",false);
+    r->setBool(pf_quick,false);
     r->setStr("skip_to",skip_target);
     tmp_queue.push_back(r);
 
@@ -102,7 +102,7 @@ void PolicyCompiler_ipf::optimize1::optimizeForRuleElement(PolicyRule *rule,
 
 /* rules that we have inserted above 'rule' will skip over it. We should
  * not drop them when we eliminate duplicates */
-    rule->setBool("skip_check_for_duplicates",true);
+    rule->setBool(pf_skip_check_for_duplicates,true);
     tmp_queue.push_back(rule);
 }
 
@@ -351,7 +351,7 @@ bool PolicyCompiler_ipf::PrintRule::processNext()
         compiler->output << " ";
     }
 
-    if ( rule->getBool("quick") ) compiler->output << "quick ";
+    if ( rule->getBool(pf_quick) ) compiler->output << "quick ";
     _printInterface(rule);
 
     _printRouteOptions(rule);
@@ -35,12 +35,14 @@
 #include "fwbuilder/IPService.h"
 #include "fwbuilder/Interface.h"
 #include "fwbuilder/Library.h"
+#include "fwbuilder/MultiAddress.h"
 #include "fwbuilder/Policy.h"
 #include "fwbuilder/RuleElement.h"
 #include "fwbuilder/TCPService.h"
 #include "fwbuilder/UDPService.h"
 
 #include <iostream>
+#include <sstream>
 
 #include <assert.h>
 
@@ -166,8 +168,8 @@ bool PolicyCompiler_ipfw::doSrcNegation::processNext()
 	r->setLogging(false);
         nsrc=r->getSrc();
         nsrc->setNeg(false);
-	r->setBool("quick",false);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,false);
+        r->setBool(pf_skip_check_for_duplicates,true);
         ruleopt = r->getOptionsObject();
         ruleopt->setBool("stateless", true);
 	tmp_queue.push_back(r);
@@ -179,8 +181,8 @@ bool PolicyCompiler_ipfw::doSrcNegation::processNext()
         nsrc->setNeg(false);
 	nsrc->clearChildren();
 	nsrc->setAnyElement();
-	r->setBool("quick",true);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,true);
+        r->setBool(pf_skip_check_for_duplicates,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -207,8 +209,8 @@ bool PolicyCompiler_ipfw::doDstNegation::processNext()
 	r->setLogging(false);
         ndst=r->getDst();
         ndst->setNeg(false);
-	r->setBool("quick",false);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,false);
+        r->setBool(pf_skip_check_for_duplicates,true);
         ruleopt = r->getOptionsObject();
         ruleopt->setBool("stateless", true);
 	tmp_queue.push_back(r);
@@ -220,8 +222,8 @@ bool PolicyCompiler_ipfw::doDstNegation::processNext()
         ndst->setNeg(false);
 	ndst->clearChildren();
 	ndst->setAnyElement();
-	r->setBool("quick",true);
-        r->setBool("skip_check_for_duplicates",true);
+	r->setBool(pf_quick,true);
+        r->setBool(pf_skip_check_for_duplicates,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -472,20 +474,19 @@ bool PolicyCompiler_ipfw::eliminateDuplicateRules::processNext()
     Interface *intf_rule = compiler->getFirstItf(rule);
     int intf_id_rule = (intf_rule) ? intf_rule->getId() : -1;
 
-    if ( ! rule->getBool("skip_check_for_duplicates"))
+    ostringstream key;
+    key << intf_id_rule << " " << int(rule->getAction()) << " "
+        << rule->getLogging();
+    deque<PolicyRule*> &seen = rules_seen_so_far[key.str()];
+
+    if ( ! rule->getBool(pf_skip_check_for_duplicates))
     {
-        for (deque<PolicyRule*>::iterator i=rules_seen_so_far.begin(); i!=rules_seen_so_far.end(); ++i)
+        for (deque<PolicyRule*>::iterator i=seen.begin(); i!=seen.end(); ++i)
         {
             PolicyRule *r=(*i);
-            if ( r->getBool("skip_check_for_duplicates") ) continue;
-
-            Interface *intf_r = compiler->getFirstItf(r);
-            int intf_id_r = (intf_r) ? intf_r->getId() : -1;
+            if ( r->getBool(pf_skip_check_for_duplicates) ) continue;
 
-            if (intf_id_r==intf_id_rule &&
-                r->getAction()==rule->getAction()   &&
-                r->getLogging()==rule->getLogging() &&
-                pcomp->cmpRules(*r,*rule) )
+            if (pcomp->cmpRules(*r,*rule) )
             {
 //                cout << "---------------------------------------" << endl;
 //                cout << pcomp->debugPrintRule(r) << endl;
@@ -495,7 +496,7 @@ bool PolicyCompiler_ipfw::eliminateDuplicateRules::processNext()
         }
     }
     tmp_queue.push_back(rule);
-    rules_seen_so_far.push_back(rule);
+    seen.push_back(rule);
 
     return true;
 }
@@ -525,6 +526,104 @@ bool PolicyCompiler_ipfw::processMultiAddressObjectsInRE::processNext()
 }
 
 
+/*
+ * Format of the address should be the same as the one produced by
+ * PrintRule::_printAddr()
+ */
+string PolicyCompiler_ipfw::tableEntry(FWObject *o)
+{
+    if (o->getId()==fw->getId()) return "";
+    if (MultiAddressRunTime::cast(o)!=NULL) return "";
+
+    Address *addr_obj = Address::cast(o);
+    if (addr_obj==NULL) return "";
+
+    const InetAddr *addr = addr_obj->getAddressPtr();
+    const InetAddr *netm = addr_obj->getNetmaskPtr();
+    if (addr==NULL || netm==NULL) return "";
+
+    InetAddr mask = *netm;
+    if (Interface::cast(o)!=NULL || addr_obj->dimension()==1)
+        mask = InetAddr(InetAddr::getAllOnes());
+
+    if (addr->isAny() && mask.isAny()) return "";
+
+    ostringstream str;
+    str << addr->toString();
+    if (!mask.isHostMask()) str << "/" << mask.getLength();
+    return str.str();
+}
+
+/*
+ * Need to make sure the same table is represented by the same object
+ * in all rule sets, see swapMultiAddressObjectsInRE for the same trick
+ */
+FWObject* PolicyCompiler_ipfw::getTableObject(int table_num)
+{
+    map<int, FWObject*>::iterator it = ipfw_table_objects.find(table_num);
+    if (it != ipfw_table_objects.end()) return it->second;
+
+    ostringstream str_id;
+    str_id << "__ipfw_table_" << table_num << "__";
+    int tbl_id = FWObjectDatabase::registerStringId(str_id.str());
+
+    FWObject *tbl = dbcopy->findInIndex(tbl_id);
+    if (tbl==NULL)
+    {
+        ostringstream name;
+        name << "table(" << table_num << ")";
+        tbl = new MultiAddressRunTime();
+        tbl->setName(name.str());
+        tbl->setBool("ipfw_table", true);
+        tbl->setInt("ipfw_table_num", table_num);
+        tbl->setId(tbl_id);
+        dbcopy->addToIndex(tbl);
+        persistent_objects->add(tbl);
+    }
+    ipfw_table_objects[table_num] = tbl;
+    return tbl;
+}
+
+bool PolicyCompiler_ipfw::createTablesForRE::processNext()
+{
+    PolicyCompiler_ipfw *ipfw_comp=dynamic_cast<PolicyCompiler_ipfw*>(compiler);
+    PolicyRule *rule=getNext(); if (rule==NULL) return false;
+    tmp_queue.push_back(rule);
+
+    FWOptions *options = compiler->fw->getOptionsObject();
+    if (ipfw_comp->ipfw_tables==NULL || !options->getBool("ipfw_use_tables"))
+        return true;
+
+    int threshold = options->getInt("ipfw_table_threshold");
+    if (threshold < 2) threshold = 8;
+
+    RuleElement *re=RuleElement::cast( rule->getFirstByType(re_type) );
+    if (re->isAny() || re->getNeg()) return true;
+
+    list<FWObject*> table_objects;
+    list<string> entries;
+    for (FWObject::iterator i=re->begin(); i!=re->end(); i++)
+    {
+        FWObject *o = FWReference::getObject(*i);
+        string entry = ipfw_comp->tableEntry(o);
+        if (entry.empty()) continue;
+        table_objects.push_back(o);
+        entries.push_back(entry);
+    }
+
+    if ((int)table_objects.size() < threshold) return true;
+
+    int table_num = ipfw_comp->ipfw_tables->registerTable(entries);
+
+    for (list<FWObject*>::iterator i=table_objects.begin();
+         i!=table_objects.end(); ++i)
+        re->removeRef(*i);
+    re->addRef(ipfw_comp->getTableObject(table_num));
+
+    return true;
+}
+
+
 void PolicyCompiler_ipfw::compile()
 {
     string banner = " Compiling " + fw->getName();
@@ -644,6 +743,8 @@ void PolicyCompiler_ipfw::compile()
              "verify custom services for this platform"));
     add( new SpecialServices("check for special services"));
 //        add( new expandAnyService("expand ANY service for stateful rules"));
+    add( new createTablesForSrc("create tables for addresses in Src"));
+    add( new createTablesForDst("create tables for addresses in Dst"));
     add( new ConvertToAtomicForAddresses(
              "convert to atomic rules in SRC and DST"));
     add( new checkForZeroAddr("check for zero addresses"));
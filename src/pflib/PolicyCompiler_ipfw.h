@@ -28,6 +28,9 @@
 
 #include <fwbuilder/libfwbuilder-config.h>
 #include "PolicyCompiler_pf.h"
+#include "TableFactory_ipfw.h"
+
+#include <map>
 
 
 namespace libfwbuilder {
@@ -55,6 +58,23 @@ namespace fwcompiler {
 	libfwbuilder::ICMPService  *anyicmp;
         int ipfw_num;
 
+        TableFactory_ipfw *ipfw_tables;
+        std::map<int, libfwbuilder::FWObject*> ipfw_table_objects;
+
+        /**
+         * returns address in the format used for the entries of ipfw
+         * tables or empty string if the object can not be placed in a
+         * table (firewall itself, dynamic interface, run-time object
+         * or "any")
+         */
+        std::string tableEntry(libfwbuilder::FWObject *o);
+
+        /**
+         * returns object that stands for the table with given number
+         * in rule elements
+         */
+        libfwbuilder::FWObject* getTableObject(int table_num);
+
 	virtual std::string myPlatformName();
 
 	virtual void _expand_addr(libfwbuilder::Rule *rule,
@@ -162,12 +182,14 @@ namespace fwcompiler {
         };
 
 	/**
-	 *  eliminates duplicate atomic rules
+	 *  eliminates duplicate atomic rules. Rules are compared only
+	 *  with those that have the same interface, action and logging
 	 */
         class eliminateDuplicateRules : public PolicyRuleProcessor
         {
             private:
-            std::deque<libfwbuilder::PolicyRule*> rules_seen_so_far;
+            std::map<std::string, std::deque<libfwbuilder::PolicyRule*> >
+                rules_seen_so_far;
             public:
             eliminateDuplicateRules(const std::string &n) :
             PolicyRuleProcessor(n) {}
@@ -208,6 +230,37 @@ namespace fwcompiler {
                     n, libfwbuilder::RuleElementDst::TYPENAME) {}
         };
 
+        /**
+         * Replaces addresses in the rule element with a reference to
+         * an ipfw table if there are at least as many of them as set
+         * by the option "ipfw_table_threshold". This way the rule
+         * does not have to be split into one ipfw rule per address.
+         * Active only if option "ipfw_use_tables" is on.
+         */
+        class createTablesForRE : public PolicyRuleProcessor
+        {
+            std::string re_type;
+            public:
+            createTablesForRE(const std::string &name,
+                              const std::string &t) : PolicyRuleProcessor(name)
+            { re_type=t; }
+            virtual bool processNext();
+        };
+
+        class createTablesForSrc : public createTablesForRE
+        {
+            public:
+            createTablesForSrc(const std::string &n) :
+                createTablesForRE(n, libfwbuilder::RuleElementSrc::TYPENAME) {}
+        };
+
+        class createTablesForDst : public createTablesForRE
+        {
+            public:
+            createTablesForDst(const std::string &n) :
+                createTablesForRE(n, libfwbuilder::RuleElementDst::TYPENAME) {}
+        };
+
 	/**
 	 *   prints single policy rule, assuming all groups have been
 	 *   expanded, so source, destination and service hold exactly
@@ -250,6 +303,7 @@ namespace fwcompiler {
         PolicyCompiler_pf(_db, fw, ipv6_policy, _oscnf, NULL)
         {
             ipfw_num = 0;
+            ipfw_tables = NULL;
         }
 
 	virtual int  prolog();
@@ -260,6 +314,8 @@ namespace fwcompiler {
 
         int getIPFWNumber() { return ipfw_num; }
         void setIPFWNumber(int n) { ipfw_num = n; }
+
+        void setTableFactory(TableFactory_ipfw *tf) { ipfw_tables = tf; }
     };
 
 
@@ -261,6 +261,13 @@ void PolicyCompiler_ipfw::PrintRule::_printAddr(FWObject *o, bool neg)
     Address *addr_obj = Address::cast(o);
     assert(addr_obj!=NULL);
 
+    if (o->getBool("ipfw_table"))
+    {
+        if (neg) compiler->output << "not ";
+        compiler->output << "table(" << o->getInt("ipfw_table_num") << ") ";
+        return;
+    }
+
     MultiAddressRunTime *atrt = MultiAddressRunTime::cast(o);
     if (atrt!=NULL)
     {
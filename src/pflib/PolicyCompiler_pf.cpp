@@ -58,6 +58,12 @@ using namespace libfwbuilder;
 using namespace fwcompiler;
 using namespace std;
 
+
+const RuleAnnotationKey fwcompiler::pf_quick(
+    "quick", RuleAnnotationKey::Bool);
+const RuleAnnotationKey fwcompiler::pf_skip_check_for_duplicates(
+    "skip_check_for_duplicates", RuleAnnotationKey::Bool);
+
 string PolicyCompiler_pf::myPlatformName() { return "pf"; }
 
 int PolicyCompiler_pf::prolog()
@@ -519,7 +525,7 @@ bool PolicyCompiler_pf::setQuickFlag::processNext()
         break;
 
     default:
-        rule->setBool("quick", true);
+        rule->setBool(pf_quick, true);
         break;
     }
 
@@ -554,7 +560,7 @@ bool PolicyCompiler_pf::doSrcNegation::processNext()
             r->setAction(PolicyRule::Accept);
         nsrc=r->getSrc();
         nsrc->setNeg(false);
-	r->setBool("quick",true);
+	r->setBool(pf_quick,true);
         r->setLogging(false);
 	tmp_queue.push_back(r);
 
@@ -565,7 +571,7 @@ bool PolicyCompiler_pf::doSrcNegation::processNext()
         nsrc->setNeg(false);
 	nsrc->clearChildren();
 	nsrc->setAnyElement();
-	r->setBool("quick",true);
+	r->setBool(pf_quick,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -593,7 +599,7 @@ bool PolicyCompiler_pf::doDstNegation::processNext()
             r->setAction(PolicyRule::Accept);
         ndst=r->getDst();
         ndst->setNeg(false);
-	r->setBool("quick",true);
+	r->setBool(pf_quick,true);
         r->setLogging(false);
 	tmp_queue.push_back(r);
 
@@ -604,7 +610,7 @@ bool PolicyCompiler_pf::doDstNegation::processNext()
         ndst->setNeg(false);
 	ndst->clearChildren();
 	ndst->setAnyElement();
-	r->setBool("quick",true);
+	r->setBool(pf_quick,true);
 	tmp_queue.push_back(r);
 
 	return true;
@@ -1002,6 +1008,10 @@ void PolicyCompiler_pf::compile()
     add(new createTables("create tables"));
 //        add(new PrintTables("print tables"));
 
+    if (fw->getOptionsObject()->getBool("pf_optimize_skip_steps") &&
+        !inSingleRuleCompileMode())
+        add(new optimizeForSkipSteps("reorder rules for pf skip steps"));
+
     add(new PrintRule("generate pf code"));
     add(new simplePrintProgress());
 
@@ -1023,7 +1033,7 @@ void PolicyCompiler_pf::epilog()
 bool PolicyCompiler_pf::checkForShadowingPlatformSpecific(PolicyRule *,
                                                           PolicyRule *r2)
 {
-    bool quick = r2->getBool("quick");
+    bool quick = r2->getBool(pf_quick);
     // if quick == false, the rule is non-terminating
     if (!quick) return false;
 
@@ -27,6 +27,7 @@
 #define __POLICYCOMPILER_PF_HH
 
 #include <fwbuilder/libfwbuilder-config.h>
+#include "fwbuilder/RuleAnnotation.h"
 #include "fwcompiler/PolicyCompiler.h"
 
 #include "NATCompiler_pf.h"
@@ -53,6 +54,14 @@ namespace libfwbuilder
 namespace fwcompiler
 {
 
+    /*
+     * Annotations rule processors of pf, ipf and ipfw compilers attach
+     * to rules: rule is terminating ("quick") and rule should not be
+     * compared with other rules when compiler looks for duplicates.
+     */
+    extern const libfwbuilder::RuleAnnotationKey pf_quick;
+    extern const libfwbuilder::RuleAnnotationKey pf_skip_check_for_duplicates;
+
     class PolicyCompiler_pf : public PolicyCompiler
     {
 	protected:
@@ -306,6 +315,23 @@ namespace fwcompiler
         };
         friend class PolicyCompiler_pf::createTables;
 
+        /**
+         * reorders consecutive rules created from the same policy
+         * rule so that rules with the same interface, direction,
+         * protocol, addresses and ports follow each other. This
+         * helps pf to skip over rules that can not match. Also
+         * reports how many rule parameters adjacent rules share
+         * before and after reordering.
+         */
+        class optimizeForSkipSteps : public PolicyRuleProcessor
+        {
+            public:
+            optimizeForSkipSteps(const std::string &n) :
+                PolicyRuleProcessor(n) {}
+            virtual bool processNext();
+        };
+        friend class PolicyCompiler_pf::optimizeForSkipSteps;
+
         /**
          *  eliminates duplicate objects in SRC. Uses default comparison
          *  in eliminateDuplicatesInRE which compares IDs
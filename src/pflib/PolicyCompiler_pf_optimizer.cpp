@@ -0,0 +1,218 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "PolicyCompiler_pf.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TCPUDPService.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+/*
+ * pf computes skip steps for these rule parameters, in this order:
+ * interface, direction, address family, protocol, source address,
+ * source port, destination address, destination port. Address family
+ * is the same for all rules the compiler generates in one pass, so it
+ * is not used here.
+ */
+enum { SKIP_IFP, SKIP_DIR, SKIP_PROTO, SKIP_SRC_ADDR, SKIP_SRC_PORT,
+       SKIP_DST_ADDR, SKIP_DST_PORT, SKIP_COUNT };
+
+typedef vector<string> SkipStepKey;
+
+static string addressListKey(RuleElement *re)
+{
+    if (re->isAny()) return "";
+    set<string> ids;
+    for (FWObject::iterator i=re->begin(); i!=re->end(); ++i)
+    {
+        FWObject *o = FWReference::getObject(*i);
+        ids.insert(FWObjectDatabase::getStringId(o->getId()));
+    }
+    ostringstream str;
+    if (re->getNeg()) str << "!";
+    for (set<string>::iterator i=ids.begin(); i!=ids.end(); ++i)
+        str << *i << " ";
+    return str.str();
+}
+
+static string portListKey(RuleElementSrv *srv, bool src)
+{
+    set<string> ports;
+    for (FWObject::iterator i=srv->begin(); i!=srv->end(); ++i)
+    {
+        TCPUDPService *s = TCPUDPService::cast(FWReference::getObject(*i));
+        if (s==NULL) continue;
+        ostringstream str;
+        if (src)
+            str << s->getSrcRangeStart() << ":" << s->getSrcRangeEnd();
+        else
+            str << s->getDstRangeStart() << ":" << s->getDstRangeEnd();
+        ports.insert(str.str());
+    }
+    ostringstream str;
+    for (set<string>::iterator i=ports.begin(); i!=ports.end(); ++i)
+        str << *i << " ";
+    return str.str();
+}
+
+static SkipStepKey skipStepKey(Compiler *compiler, PolicyRule *rule)
+{
+    SkipStepKey key(SKIP_COUNT);
+
+    key[SKIP_IFP] = addressListKey(rule->getItf());
+    key[SKIP_DIR] = rule->getDirectionAsString();
+
+    Service *srv = compiler->getFirstSrv(rule);
+    ostringstream proto;
+    if (srv && !srv->isAny()) proto << srv->getProtocolNumber();
+    key[SKIP_PROTO] = proto.str();
+
+    key[SKIP_SRC_ADDR] = addressListKey(rule->getSrc());
+    key[SKIP_SRC_PORT] = portListKey(rule->getSrv(), true);
+    key[SKIP_DST_ADDR] = addressListKey(rule->getDst());
+    key[SKIP_DST_PORT] = portListKey(rule->getSrv(), false);
+
+    return key;
+}
+
+/*
+ * Returns number of pairs of adjacent rules that have the same value
+ * of a parameter, summed up over all parameters. Each such pair lets
+ * pf skip over the second rule when the first one does not match
+ * because of this parameter. This is only an estimate since pfctl
+ * expands lists in braces into separate rules.
+ */
+static int countSkipSteps(const vector<SkipStepKey> &keys)
+{
+    int n = 0;
+    for (unsigned int i=1; i<keys.size(); ++i)
+    {
+        for (int f=0; f<SKIP_COUNT; ++f)
+            if (keys[i][f] == keys[i-1][f]) n++;
+    }
+    return n;
+}
+
+/*
+ * Two consecutive rules can trade places if they were created from
+ * the same policy rule and differ only in the parameters used to
+ * match packets. A packet that matches both gets the same treatment
+ * regardless of which one matches first (quick) or last. Rules that
+ * call anchors or set tags are never moved because other rules may
+ * depend on the order in which they are evaluated.
+ */
+static bool canReorder(PolicyRule *r1, PolicyRule *r2)
+{
+    if (r1->getAction()==PolicyRule::Branch || r1->getTagging()) return false;
+
+    return (r1->getLabel()==r2->getLabel() &&
+            r1->getAction()==r2->getAction() &&
+            r1->getLogging()==r2->getLogging() &&
+            r1->getBool(pf_quick)==r2->getBool(pf_quick) &&
+            r1->getOptionsObject()->cmp(r2->getOptionsObject()));
+}
+
+class compareSkipStepKeys
+{
+    const vector<SkipStepKey> &keys;
+    public:
+    compareSkipStepKeys(const vector<SkipStepKey> &k) : keys(k) {}
+    bool operator()(int a, int b) const { return keys[a] < keys[b]; }
+};
+
+bool PolicyCompiler_pf::optimizeForSkipSteps::processNext()
+{
+    slurp();
+    if (tmp_queue.size()==0) return false;
+
+    vector<PolicyRule*> rules;
+    vector<SkipStepKey> keys;
+    for (deque<Rule*>::iterator i=tmp_queue.begin(); i!=tmp_queue.end(); ++i)
+    {
+        PolicyRule *rule = PolicyRule::cast(*i);
+        rules.push_back(rule);
+        keys.push_back(skipStepKey(compiler, rule));
+    }
+
+    int before = countSkipSteps(keys);
+
+    /*
+     * sort each block of rules that can be reordered by their
+     * parameters in the order pf uses to calculate skip steps. Sort
+     * is stable, rules with the same parameters keep their order.
+     */
+    vector<int> order;
+    unsigned int block_start = 0;
+    while (block_start < rules.size())
+    {
+        unsigned int block_end = block_start + 1;
+        while (block_end < rules.size() &&
+               canReorder(rules[block_start], rules[block_end]))
+            block_end++;
+
+        vector<int> block;
+        for (unsigned int i=block_start; i<block_end; ++i) block.push_back(i);
+        stable_sort(block.begin(), block.end(), compareSkipStepKeys(keys));
+        order.insert(order.end(), block.begin(), block.end());
+
+        block_start = block_end;
+    }
+
+    tmp_queue.clear();
+    vector<SkipStepKey> new_keys;
+    for (vector<int>::iterator i=order.begin(); i!=order.end(); ++i)
+    {
+        tmp_queue.push_back(rules[*i]);
+        new_keys.push_back(keys[*i]);
+    }
+
+    int after = countSkipSteps(new_keys);
+    int total = (rules.size() - 1) * SKIP_COUNT;
+    if (total > 0)
+    {
+        ostringstream str;
+        str << " Skip steps: " << rules.size() << " rules, "
+            << "adjacent rules share "
+            << setprecision(3) << 100.0 * before / total << "% of parameters "
+            << "before and "
+            << setprecision(3) << 100.0 * after / total << "% after reordering";
+        compiler->info(str.str());
+    }
+
+    return true;
+}
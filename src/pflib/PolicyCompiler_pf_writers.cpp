@@ -941,7 +941,7 @@ bool PolicyCompiler_pf::PrintRule::processNext()
     _printDirection(rule);
     _printLogging(rule);
 
-    if ( rule->getBool("quick") ) compiler->output << " quick ";
+    if ( rule->getBool(pf_quick) ) compiler->output << " quick ";
 
     _printInterface(rule);
 
@@ -224,6 +224,8 @@ void RoutingCompiler_openbsd::compile()
     add(new ConvertToAtomicForDST(
             "Convert to atomic rules by dst address elements"));
 
+    add(new aggregateRoutes("Aggregate routes"));
+
     add(new sameDestinationDifferentGateways(
             "detect rules with the same destination but different gateways. We do not "
             "support ECMP at this time"));
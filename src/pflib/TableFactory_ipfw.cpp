@@ -0,0 +1,116 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+
+#include "TableFactory_ipfw.h"
+
+#include <sstream>
+
+using namespace fwcompiler;
+using namespace std;
+
+
+TableFactory_ipfw::TableFactory_ipfw(int first_table_num)
+{
+    next_table_num = first_table_num;
+}
+
+int TableFactory_ipfw::registerTable(const list<string> &entries)
+{
+    list<string> sorted_entries = entries;
+    sorted_entries.sort();
+    sorted_entries.unique();
+
+    string key;
+    for (list<string>::iterator i=sorted_entries.begin();
+         i!=sorted_entries.end(); ++i)
+        key += *i + " ";
+
+    map<string, int>::iterator it = table_numbers.find(key);
+    if (it != table_numbers.end()) return it->second;
+
+    int table_num = next_table_num++;
+    table_numbers[key] = table_num;
+    table_entries[table_num] = sorted_entries;
+    return table_num;
+}
+
+/*
+ * Tables may already exist and be used by the rules in set 0 that are
+ * still active while the new rules are loaded into set 1. New contents
+ * are loaded into temporary tables and swapped with the tables the
+ * rules use right before the rule sets are swapped (see
+ * PrintTableSwap()), so active rules never see an empty or partially
+ * filled table. "table create" fails if the table exists, this is not
+ * an error.
+ */
+string TableFactory_ipfw::tempTableName(int table_num)
+{
+    ostringstream str;
+    str << "fwb_new_" << table_num;
+    return str.str();
+}
+
+string TableFactory_ipfw::PrintTables()
+{
+    if (table_entries.size() == 0) return "";
+
+    ostringstream output;
+    output << endl;
+    output << "# Tables: (" << table_entries.size() << ")" << endl;
+
+    for (map<int, list<string> >::iterator it=table_entries.begin();
+         it!=table_entries.end(); ++it)
+    {
+        int n = it->first;
+        string tmp = tempTableName(n);
+        output << "\"$IPFW\" table " << n
+               << " create type addr >/dev/null 2>&1" << endl;
+        output << "\"$IPFW\" table " << tmp
+               << " destroy >/dev/null 2>&1" << endl;
+        output << "\"$IPFW\" table " << tmp
+               << " create type addr || exit 1" << endl;
+        for (list<string>::iterator i=it->second.begin();
+             i!=it->second.end(); ++i)
+            output << "\"$IPFW\" table " << tmp << " add " << *i
+                   << " || exit 1" << endl;
+    }
+    output << endl;
+    return output.str();
+}
+
+string TableFactory_ipfw::PrintTableSwap()
+{
+    ostringstream output;
+    for (map<int, list<string> >::iterator it=table_entries.begin();
+         it!=table_entries.end(); ++it)
+    {
+        int n = it->first;
+        string tmp = tempTableName(n);
+        output << "\"$IPFW\" table " << n << " swap " << tmp
+               << " || exit 1" << endl;
+        output << "\"$IPFW\" table " << tmp << " destroy" << endl;
+    }
+    return output.str();
+}
@@ -0,0 +1,79 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef __TABLEFACTORY_IPFW_HH
+#define __TABLEFACTORY_IPFW_HH
+
+#include <list>
+#include <map>
+#include <string>
+
+
+namespace fwcompiler
+{
+
+    /**
+     * Keeps ipfw lookup tables created by all policy compilers that
+     * run for the same firewall. Tables are identified by numbers,
+     * the same set of addresses always maps to the same table no
+     * matter how many rules or rule sets use it.
+     */
+    class TableFactory_ipfw
+    {
+        int next_table_num;
+        std::map<std::string, int> table_numbers;
+        std::map<int, std::list<std::string> > table_entries;
+
+        std::string tempTableName(int table_num);
+
+public:
+        TableFactory_ipfw(int first_table_num=1);
+
+        /**
+         * Returns number of the table that holds given addresses,
+         * creating new table if needed. Entries are strings in the
+         * format ipfw accepts in "table N add", that is address or
+         * address/prefix length.
+         */
+        int registerTable(const std::list<std::string> &entries);
+
+        int size() { return table_entries.size(); }
+
+        /**
+         * Generates commands that create all tables and load their
+         * addresses into temporary tables. These must run before
+         * rules that refer to the tables are loaded.
+         */
+        std::string PrintTables();
+
+        /**
+         * Generates commands that swap temporary tables with the
+         * tables rules use. These run right before the new rule set
+         * is swapped in.
+         */
+        std::string PrintTableSwap();
+    };
+};
+
+
+#endif
@@ -5,6 +5,7 @@ include(../../qmake.inc)
 TEMPLATE = lib
 #
 SOURCES	 =  TableFactory.cpp \
+			TableFactory_ipfw.cpp \
 			Preprocessor_pf.cpp \
 		    NATCompiler_ipf.cpp \
 			NATCompiler_ipfw.cpp \
@@ -26,6 +27,7 @@ SOURCES	 =  TableFactory.cpp \
 			PolicyCompiler_ipf_writers.cpp \
 			PolicyCompiler_ipfw_writers.cpp \
 			PolicyCompiler_pf.cpp \
+			PolicyCompiler_pf_optimizer.cpp \
 			PolicyCompiler_pf_writers.cpp \
 			CompilerDriver_pf.cpp \
 			CompilerDriver_pf_run.cpp \
@@ -42,6 +44,7 @@ SOURCES	 =  TableFactory.cpp \
 HEADERS	 = ../../config.h \
 			OSData.h \
 		    TableFactory.h \
+			TableFactory_ipfw.h \
 			Preprocessor_pf.h \
 			NATCompiler_ipf.h \
 			NATCompiler_ipfw.h \
@@ -0,0 +1,296 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "AddressRangeSetTest.h"
+
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/Network.h"
+
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+/*
+ * Builds set from a string "a1-a2 a3 ...", all addresses of the same
+ * address family
+ */
+AddressRangeSet AddressRangeSetTest::makeSet(const string &ranges)
+{
+    int af = (ranges.find(':') != string::npos) ? AF_INET6 : AF_INET;
+    AddressRangeSet s(af);
+    istringstream str(ranges);
+    string r;
+    while (str >> r)
+    {
+        string::size_type n = r.find('-');
+        string first = r.substr(0, n);
+        string last = (n == string::npos) ? first : r.substr(n + 1);
+        s.addRange(InetAddrValue(InetAddr(af, first)),
+                   InetAddrValue(InetAddr(af, last)));
+    }
+    return s;
+}
+
+string AddressRangeSetTest::prefixes(const AddressRangeSet &s)
+{
+    vector<AddressRangeSet::Prefix> res = s.toPrefixes();
+    CPPUNIT_ASSERT(int(res.size()) == s.countPrefixes());
+
+    // prefixes must give back the same set
+    AddressRangeSet check(s.addressFamily());
+    ostringstream str;
+    for (unsigned int i=0; i<res.size(); ++i)
+    {
+        check.addPrefix(res[i].address, res[i].length);
+        if (i) str << " ";
+        str << res[i].address.toInetAddr().toString() << "/" << res[i].length;
+    }
+    CPPUNIT_ASSERT(check == s);
+    return str.str();
+}
+
+void AddressRangeSetTest::testAddRange()
+{
+    // overlapping and adjacent ranges are merged
+    CPPUNIT_ASSERT_EQUAL(
+        makeSet("10.0.0.5-10.0.0.10 10.0.0.1-10.0.0.4").toString(),
+        string("10.0.0.1-10.0.0.10"));
+    CPPUNIT_ASSERT_EQUAL(
+        makeSet("10.0.0.20 10.0.0.1-10.0.0.4 10.0.0.3-10.0.0.21").toString(),
+        string("10.0.0.1-10.0.0.21"));
+    CPPUNIT_ASSERT_EQUAL(
+        makeSet("10.0.0.20 10.0.0.1 10.0.0.10").toString(),
+        string("10.0.0.1 10.0.0.10 10.0.0.20"));
+    CPPUNIT_ASSERT_EQUAL(
+        makeSet("10.0.0.1-10.0.0.2 10.0.0.8 10.0.0.0-10.0.0.9").toString(),
+        string("10.0.0.0-10.0.0.9"));
+    CPPUNIT_ASSERT_EQUAL(
+        makeSet("255.255.255.255 0.0.0.0 255.255.255.254").toString(),
+        string("0.0.0.0 255.255.255.254-255.255.255.255"));
+
+    AddressRangeSet s = makeSet("10.0.0.0-10.0.0.255 192.168.1.1");
+    CPPUNIT_ASSERT(s.contains(InetAddrValue(InetAddr("10.0.0.0"))));
+    CPPUNIT_ASSERT(s.contains(InetAddrValue(InetAddr("10.0.0.255"))));
+    CPPUNIT_ASSERT(s.contains(InetAddrValue(InetAddr("192.168.1.1"))));
+    CPPUNIT_ASSERT(!s.contains(InetAddrValue(InetAddr("10.0.1.0"))));
+    CPPUNIT_ASSERT(!s.contains(InetAddrValue(InetAddr("192.168.1.0"))));
+    CPPUNIT_ASSERT(!s.contains(InetAddrValue(InetAddr("9.255.255.255"))));
+}
+
+void AddressRangeSetTest::testOperations()
+{
+    AddressRangeSet a = makeSet("10.0.0.0-10.0.0.99 10.0.0.200-10.0.0.255");
+    AddressRangeSet b = makeSet("10.0.0.50-10.0.0.210");
+
+    CPPUNIT_ASSERT_EQUAL(a.unite(b).toString(),
+                         string("10.0.0.0-10.0.0.255"));
+    CPPUNIT_ASSERT_EQUAL(a.intersect(b).toString(),
+                         string("10.0.0.50-10.0.0.99 10.0.0.200-10.0.0.210"));
+    CPPUNIT_ASSERT_EQUAL(a.subtract(b).toString(),
+                         string("10.0.0.0-10.0.0.49 10.0.0.211-10.0.0.255"));
+    CPPUNIT_ASSERT_EQUAL(b.subtract(a).toString(),
+                         string("10.0.0.100-10.0.0.199"));
+    CPPUNIT_ASSERT_EQUAL(a.complement().toString(),
+        string("0.0.0.0-9.255.255.255 10.0.0.100-10.0.0.199 "
+               "10.0.1.0-255.255.255.255"));
+
+    CPPUNIT_ASSERT(a.unite(b).contains(a));
+    CPPUNIT_ASSERT(!a.contains(b));
+    CPPUNIT_ASSERT(a.complement().complement() == a);
+
+    AddressRangeSet empty(AF_INET);
+    CPPUNIT_ASSERT_EQUAL(empty.complement().toString(),
+                         string("0.0.0.0-255.255.255.255"));
+    CPPUNIT_ASSERT(empty.complement().complement().empty());
+    CPPUNIT_ASSERT(a.intersect(empty).empty());
+    CPPUNIT_ASSERT(a.unite(empty) == a);
+    CPPUNIT_ASSERT(a.contains(empty));
+}
+
+void AddressRangeSetTest::testPrefixes()
+{
+    CPPUNIT_ASSERT_EQUAL(prefixes(makeSet("10.0.0.0-10.0.0.255")),
+                         string("10.0.0.0/24"));
+    CPPUNIT_ASSERT_EQUAL(prefixes(makeSet("10.0.0.1")),
+                         string("10.0.0.1/32"));
+    CPPUNIT_ASSERT_EQUAL(prefixes(makeSet("10.0.0.1-10.0.0.6")),
+                         string("10.0.0.1/32 10.0.0.2/31 10.0.0.4/31 10.0.0.6/32"));
+    // two adjacent networks become one
+    CPPUNIT_ASSERT_EQUAL(
+        prefixes(makeSet("192.168.0.0-192.168.0.255 192.168.1.0-192.168.1.255")),
+        string("192.168.0.0/23"));
+    CPPUNIT_ASSERT_EQUAL(prefixes(makeSet("0.0.0.0-255.255.255.255")),
+                         string("0.0.0.0/0"));
+    CPPUNIT_ASSERT_EQUAL(prefixes(makeSet("128.0.0.0-255.255.255.255")),
+                         string("128.0.0.0/1"));
+    // 0.0.0.0/1, 128.0.0.0/2 ... 255.255.255.254/32
+    CPPUNIT_ASSERT(makeSet("0.0.0.0-255.255.255.254").countPrefixes() == 32);
+    CPPUNIT_ASSERT(AddressRangeSet(AF_INET).countPrefixes() == 0);
+}
+
+void AddressRangeSetTest::testIPv6()
+{
+    AddressRangeSet s = makeSet("2001:db8::-2001:db8::ffff:ffff:ffff:ffff");
+    CPPUNIT_ASSERT_EQUAL(prefixes(s), string("2001:db8::/64"));
+
+    // range crosses the boundary between the two 64 bit words
+    AddressRangeSet c = makeSet("::ffff:ffff:ffff:ffff-::1:0:0:0:0");
+    CPPUNIT_ASSERT_EQUAL(prefixes(c),
+                         string("::ffff:ffff:ffff:ffff/128 0:0:0:1::/128"));
+
+    AddressRangeSet a = makeSet("fe80::1-fe80::ff");
+    AddressRangeSet b = makeSet("fe80::80-fe80::1ff");
+    CPPUNIT_ASSERT_EQUAL(a.unite(b).toString(), string("fe80::1-fe80::1ff"));
+    CPPUNIT_ASSERT_EQUAL(a.intersect(b).toString(), string("fe80::80-fe80::ff"));
+    CPPUNIT_ASSERT_EQUAL(a.subtract(b).toString(), string("fe80::1-fe80::7f"));
+
+    AddressRangeSet all = AddressRangeSet(AF_INET6).complement();
+    CPPUNIT_ASSERT_EQUAL(prefixes(all), string("::/0"));
+    CPPUNIT_ASSERT(all.contains(a));
+    CPPUNIT_ASSERT(all.subtract(a).complement() == a);
+}
+
+void AddressRangeSetTest::testObjects()
+{
+    FWObjectDatabase db;
+
+    IPv4 *h = db.createIPv4();
+    h->setAddress(InetAddr("10.0.0.5"));
+    h->setNetmask(InetAddr("255.255.255.0"));
+
+    Network *n = db.createNetwork();
+    n->setAddress(InetAddr("10.0.1.7"));
+    n->setNetmask(InetAddr("255.255.255.0"));
+
+    AddressRange *r = db.createAddressRange();
+    r->setRangeStart(InetAddr("10.0.0.6"));
+    r->setRangeEnd(InetAddr("10.0.0.255"));
+
+    IPv6 *h6 = db.createIPv6();
+    h6->setAddress(InetAddr(AF_INET6, "fe80::1"));
+
+    AddressRangeSet s(AF_INET);
+    CPPUNIT_ASSERT(s.addObject(h));
+    CPPUNIT_ASSERT(s.addObject(n));
+    CPPUNIT_ASSERT(s.addObject(r));
+    CPPUNIT_ASSERT(!s.addObject(h6));
+
+    // IPv4 object matches only its address, host bits of the network
+    // are ignored
+    CPPUNIT_ASSERT_EQUAL(prefixes(s),
+                         string("10.0.0.5/32 10.0.0.6/31 10.0.0.8/29 "
+                                "10.0.0.16/28 10.0.0.32/27 10.0.0.64/26 "
+                                "10.0.0.128/25 10.0.1.0/24"));
+
+    AddressRangeSet s6(AF_INET6);
+    CPPUNIT_ASSERT(s6.addObject(h6));
+    CPPUNIT_ASSERT(!s6.addObject(h));
+    CPPUNIT_ASSERT_EQUAL(s6.toString(), string("fe80::1"));
+}
+
+/*
+ * Minimal number of prefixes that covers the set within subnet
+ * base/length: the subnet itself if the set covers all of it,
+ * otherwise the sum of minimal covers of its two halves
+ */
+static int minimalCover(const vector<bool> &bits, int first, int size)
+{
+    int count = 0;
+    for (int i=first; i<first+size; ++i) if (bits[i]) count++;
+    if (count == 0) return 0;
+    if (count == size) return 1;
+    return minimalCover(bits, first, size / 2) +
+        minimalCover(bits, first + size / 2, size / 2);
+}
+
+/*
+ * Compares results of operations with a bitmap of addresses of the
+ * subnet 10.0.0.0/24
+ */
+void AddressRangeSetTest::testRandom()
+{
+    srand(1);
+    InetAddrValue base(InetAddr("10.0.0.0"));
+    InetAddrValue outside[2] = {
+        InetAddrValue(InetAddr("9.255.255.255")),
+        InetAddrValue(InetAddr("10.0.1.0")) };
+
+    for (int iter=0; iter<500; ++iter)
+    {
+        AddressRangeSet sets[2] = {
+            AddressRangeSet(AF_INET), AddressRangeSet(AF_INET) };
+        vector<bool> bits[2];
+        for (int n=0; n<2; ++n)
+        {
+            bits[n].resize(256, false);
+            int cnt = rand() % 8;
+            for (int k=0; k<cnt; ++k)
+            {
+                int f = rand() % 256;
+                int l = f + rand() % (rand() % 2 ? 4 : 64);
+                if (l > 255) l = 255;
+                sets[n].addRange(InetAddrValue(AF_INET, 0, base.lo + f),
+                                 InetAddrValue(AF_INET, 0, base.lo + l));
+                for (int i=f; i<=l; ++i) bits[n][i] = true;
+            }
+        }
+
+        AddressRangeSet u = sets[0].unite(sets[1]);
+        AddressRangeSet x = sets[0].intersect(sets[1]);
+        AddressRangeSet d = sets[0].subtract(sets[1]);
+        AddressRangeSet c = sets[0].complement();
+
+        vector<bool> ubits(256);
+        for (int i=0; i<256; ++i)
+        {
+            InetAddrValue a(AF_INET, 0, base.lo + i);
+            ubits[i] = bits[0][i] || bits[1][i];
+            CPPUNIT_ASSERT(sets[0].contains(a) == bits[0][i]);
+            CPPUNIT_ASSERT(u.contains(a) == ubits[i]);
+            CPPUNIT_ASSERT(x.contains(a) == (bits[0][i] && bits[1][i]));
+            CPPUNIT_ASSERT(d.contains(a) == (bits[0][i] && !bits[1][i]));
+            CPPUNIT_ASSERT(c.contains(a) == !bits[0][i]);
+        }
+        for (int k=0; k<2; ++k)
+        {
+            CPPUNIT_ASSERT(!u.contains(outside[k]));
+            CPPUNIT_ASSERT(c.contains(outside[k]));
+        }
+
+        CPPUNIT_ASSERT(u.unite(c) == AddressRangeSet(AF_INET).complement());
+        CPPUNIT_ASSERT(u.contains(x));
+        CPPUNIT_ASSERT(d.intersect(sets[1]).empty());
+
+        prefixes(u);
+        CPPUNIT_ASSERT(u.countPrefixes() == minimalCover(ubits, 0, 256));
+    }
+}
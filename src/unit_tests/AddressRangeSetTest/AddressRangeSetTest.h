@@ -0,0 +1,59 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef ADDRESSRANGESETTEST_H
+#define ADDRESSRANGESETTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwcompiler/AddressRangeSet.h"
+
+#include <string>
+
+
+class AddressRangeSetTest : public CppUnit::TestFixture
+{
+    fwcompiler::AddressRangeSet makeSet(const std::string &ranges);
+    std::string prefixes(const fwcompiler::AddressRangeSet &s);
+
+public:
+    void testAddRange();
+    void testOperations();
+    void testPrefixes();
+    void testIPv6();
+    void testObjects();
+    void testRandom();
+
+    CPPUNIT_TEST_SUITE(AddressRangeSetTest);
+
+    CPPUNIT_TEST(testAddRange);
+    CPPUNIT_TEST(testOperations);
+    CPPUNIT_TEST(testPrefixes);
+    CPPUNIT_TEST(testIPv6);
+    CPPUNIT_TEST(testObjects);
+    CPPUNIT_TEST(testRandom);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // ADDRESSRANGESETTEST_H
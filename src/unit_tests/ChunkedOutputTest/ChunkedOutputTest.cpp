@@ -0,0 +1,209 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+#include "ChunkedOutputTest.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+using namespace fwcompiler;
+using namespace std;
+
+
+string ChunkedOutputTest::writeToFile(const ChunkedOutput &out)
+{
+    string file_name = "chunked_output_test.txt";
+    int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CPPUNIT_ASSERT(fd >= 0);
+    CPPUNIT_ASSERT(out.writeTo(fd));
+    close(fd);
+
+    ifstream in(file_name.c_str());
+    ostringstream res;
+    res << in.rdbuf();
+    unlink(file_name.c_str());
+    return res.str();
+}
+
+void ChunkedOutputTest::testWrite()
+{
+    ChunkedOutput out;
+    CPPUNIT_ASSERT(out.empty());
+    CPPUNIT_ASSERT(out.tellp() == streampos(0));
+
+    out << "abc " << 10 << endl;
+    CPPUNIT_ASSERT_EQUAL(string("abc 10\n"), out.str());
+    CPPUNIT_ASSERT(out.tellp() == streampos(7));
+
+    // text longer than one chunk
+    string long_line(100000, 'x');
+    out << long_line;
+    CPPUNIT_ASSERT_EQUAL(size_t(7 + 100000), out.size());
+    CPPUNIT_ASSERT_EQUAL("abc 10\n" + long_line, out.str());
+
+    out.str("new");
+    CPPUNIT_ASSERT_EQUAL(string("new"), out.str());
+
+    out.str("");
+    CPPUNIT_ASSERT(out.empty());
+}
+
+void ChunkedOutputTest::testAppend()
+{
+    ChunkedOutput a;
+    ChunkedOutput b;
+
+    a << "line 1\n";
+    b << "line 2\n";
+    a.append(b);
+    a << "line 3\n";
+    CPPUNIT_ASSERT_EQUAL(string("line 1\nline 2\nline 3\n"), a.str());
+
+    // text added to src later does not appear in dest and text
+    // added to dest does not overwrite src
+    b << "line 4\n";
+    CPPUNIT_ASSERT_EQUAL(string("line 1\nline 2\nline 3\n"), a.str());
+    CPPUNIT_ASSERT_EQUAL(string("line 2\nline 4\n"), b.str());
+
+    // dest keeps the text after src has been cleared or destroyed
+    b.str("");
+    CPPUNIT_ASSERT_EQUAL(string("line 1\nline 2\nline 3\n"), a.str());
+
+    ChunkedOutput *c = new ChunkedOutput();
+    *c << "line 5\n";
+    a.append(*c);
+    delete c;
+    CPPUNIT_ASSERT_EQUAL(string("line 1\nline 2\nline 3\nline 5\n"), a.str());
+
+    // the same stream can be appended twice
+    ChunkedOutput d;
+    d.append(a);
+    d.append(a);
+    CPPUNIT_ASSERT_EQUAL(a.str() + a.str(), d.str());
+}
+
+void ChunkedOutputTest::testIndent()
+{
+    ChunkedOutput body;
+    body << "a\n\n  b\nc\n";
+
+    ChunkedOutput out;
+    out << "f() {\n";
+    out.append(body, 4);
+    out << "}\n";
+    CPPUNIT_ASSERT_EQUAL(string("f() {\n    a\n\n      b\n    c\n}\n"),
+                         out.str());
+
+    // indentation of nested streams adds up
+    ChunkedOutput outer;
+    outer << "g() {\n";
+    outer.append(out, 2);
+    outer << "}\n";
+    CPPUNIT_ASSERT_EQUAL(
+        string("g() {\n  f() {\n      a\n\n        b\n      c\n  }\n}\n"),
+        outer.str());
+
+    // indented stream starts on a new line even if the text before
+    // it does not end with a newline
+    ChunkedOutput partial;
+    partial << "x";
+    partial.append(body, 1);
+    CPPUNIT_ASSERT_EQUAL(string("x a\n\n   b\n c\n"), partial.str());
+
+    // first line of a trimmed value is not indented by appendTrimmed()
+    // but gets indentation of the stream it ends up in
+    ChunkedOutput value;
+    value << "\n# rules\nr1\n";
+    ChunkedOutput script;
+    script << "# header\n";
+    script.appendTrimmed(value);
+    script << "\n";
+    ChunkedOutput function;
+    function << "f() {\n";
+    function.append(script, 4);
+    function << "}\n";
+    CPPUNIT_ASSERT_EQUAL(
+        string("f() {\n    # header\n    # rules\n    r1\n}\n"),
+        function.str());
+}
+
+void ChunkedOutputTest::testTrim()
+{
+    ChunkedOutput body;
+    body << "\n  \n  a\n\nb  \n \n";
+
+    ChunkedOutput out;
+    out << "    ";
+    out.appendTrimmed(body, 4);
+    out << "\n";
+    CPPUNIT_ASSERT_EQUAL(string("    a\n\n    b\n"), out.str());
+
+    // white space spans several segments
+    ChunkedOutput spaces1;
+    ChunkedOutput spaces2;
+    ChunkedOutput parts;
+    spaces1 << "  \n";
+    spaces2 << "\n  ";
+    parts.append(spaces1);
+    parts.append(body);
+    parts.append(spaces2);
+
+    ChunkedOutput res;
+    res << "[";
+    res.appendTrimmed(parts);
+    res << "]";
+    CPPUNIT_ASSERT_EQUAL(string("[a\n\nb]"), res.str());
+
+    ChunkedOutput empty;
+    ChunkedOutput only_spaces;
+    only_spaces << " \n\t ";
+    res.str("[");
+    res.appendTrimmed(empty);
+    res.appendTrimmed(only_spaces);
+    res << "]";
+    CPPUNIT_ASSERT_EQUAL(string("[]"), res.str());
+}
+
+/*
+ * Writes enough segments to need several calls to writev()
+ */
+void ChunkedOutputTest::testWriteTo()
+{
+    ChunkedOutput out;
+    ChunkedOutput line;
+    ostringstream expected;
+
+    for (int i=0; i<5000; ++i)
+    {
+        line.str("");
+        line << "line " << i << "\n";
+        out.append(line, i % 3);
+        expected << string(i % 3, ' ') << "line " << i << "\n";
+    }
+
+    CPPUNIT_ASSERT_EQUAL(expected.str(), out.str());
+    CPPUNIT_ASSERT_EQUAL(expected.str(), writeToFile(out));
+}
@@ -0,0 +1,55 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+#ifndef CHUNKEDOUTPUTTEST_H
+#define CHUNKEDOUTPUTTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwcompiler/ChunkedOutput.h"
+
+#include <string>
+
+
+class ChunkedOutputTest : public CppUnit::TestFixture
+{
+    std::string writeToFile(const fwcompiler::ChunkedOutput &out);
+
+public:
+    void testWrite();
+    void testAppend();
+    void testIndent();
+    void testTrim();
+    void testWriteTo();
+
+    CPPUNIT_TEST_SUITE(ChunkedOutputTest);
+
+    CPPUNIT_TEST(testWrite);
+    CPPUNIT_TEST(testAppend);
+    CPPUNIT_TEST(testIndent);
+    CPPUNIT_TEST(testTrim);
+    CPPUNIT_TEST(testWriteTo);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // CHUNKEDOUTPUTTEST_H
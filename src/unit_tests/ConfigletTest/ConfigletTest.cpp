@@ -0,0 +1,403 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "ConfigletTest.h"
+
+#include "Configlet.h"
+#include "ConfigletTemplate.h"
+
+#include "fwbuilder/Constants.h"
+#include "fwcompiler/ChunkedOutput.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+
+#include <iostream>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+void ConfigletTest::tearDown()
+{
+    Configlet::setPrecompiledTemplates(true);
+    ConfigletTemplate::clearCache();
+}
+
+QString ConfigletTest::writeConfiglet(const QString &file_name,
+                                      const QString &text)
+{
+    QString file_path = QDir::current().absoluteFilePath(file_name);
+    QFile file(file_path);
+    CPPUNIT_ASSERT(file.open(QFile::WriteOnly | QFile::Truncate));
+    QTextStream ts(&file);
+    ts << text;
+    return file_path;
+}
+
+QString ConfigletTest::expandLegacy(Configlet &c)
+{
+    Configlet::setPrecompiledTemplates(false);
+    QString res = c.expand();
+    Configlet::setPrecompiledTemplates(true);
+    return res;
+}
+
+/*
+ * Expands configlet using precompiled template and checks that the
+ * result is the same as the one produced by regular expressions
+ */
+QString ConfigletTest::expand(const QString &file_path,
+                              const QMap<QString, QString> &vars)
+{
+    Configlet c("", file_path);
+    foreach(QString var, vars.keys()) c.setVariable(var, vars[var]);
+    QString res = c.expand();
+    CPPUNIT_ASSERT_EQUAL(expandLegacy(c).toStdString(), res.toStdString());
+    return res;
+}
+
+void ConfigletTest::testVariables()
+{
+    QString path = writeConfiglet(
+        "configlet_test_variables",
+        "a={{$a}} b={{$b}}\n"
+        "undefined={{$c}} empty={{$}}\n"
+        "{{$a}}{{$a}}{{{$b}}}\n");
+
+    QMap<QString, QString> vars;
+    vars["a"] = "1";
+    vars["b"] = "foo";
+
+    CPPUNIT_ASSERT_EQUAL(
+        string("a=1 b=foo\nundefined={{c}} empty={{}}\n11{foo}"),
+        expand(path, vars).toStdString());
+}
+
+void ConfigletTest::testIf()
+{
+    QString path = writeConfiglet(
+        "configlet_test_if",
+        "{{if one}}one{{endif}}\n"
+        "{{if zero}}zero{{endif}}\n"
+        "{{if text}}text{{endif}}\n"
+        "{{if undefined}}undefined{{endif}}\n"
+        "{{if  one}}space{{endif}}\n"
+        "{{if one}}\n"
+        "multiline {{$text}}\n"
+        "{{endif}}\n");
+
+    QMap<QString, QString> vars;
+    vars["one"] = "1";
+    vars["zero"] = "0";
+    vars["text"] = "yes";
+
+    CPPUNIT_ASSERT_EQUAL(
+        string("one\n\n\n\n\n\nmultiline yes\n"),
+        expand(path, vars).toStdString());
+}
+
+void ConfigletTest::testNestedIf()
+{
+    QString path = writeConfiglet(
+        "configlet_test_nested_if",
+        "{{if a}}a{{if b}}b{{if a}}ab{{endif}}{{endif}}-{{if c}}c{{endif}}"
+        "{{endif}}|{{if c}}x{{if a}}y{{endif}}z{{endif}}");
+
+    QMap<QString, QString> vars;
+    vars["a"] = "1";
+    vars["b"] = "2";
+    vars["c"] = "0";
+    CPPUNIT_ASSERT_EQUAL(string("abab-|"), expand(path, vars).toStdString());
+
+    vars["c"] = "1";
+    CPPUNIT_ASSERT_EQUAL(string("abab-c|xyz"),
+                         expand(path, vars).toStdString());
+
+    vars["b"] = "0";
+    CPPUNIT_ASSERT_EQUAL(string("a-c|xyz"), expand(path, vars).toStdString());
+}
+
+void ConfigletTest::testUnmatchedIf()
+{
+    QMap<QString, QString> vars;
+    vars["a"] = "1";
+    vars["b"] = "0";
+
+    QString path = writeConfiglet(
+        "configlet_test_unmatched_if",
+        "x {{if a}} y {{if b}} z {{endif}} w");
+    CPPUNIT_ASSERT_EQUAL(string("x {{if a}} y  w"),
+                         expand(path, vars).toStdString());
+
+    path = writeConfiglet(
+        "configlet_test_stray_endif",
+        "{{endif}}{{if a}}x{{endif}}{{endif}}{{if }}{{if b}");
+    CPPUNIT_ASSERT_EQUAL(string("{{endif}}x{{endif}}{{if }}{{if b}"),
+                         expand(path, vars).toStdString());
+}
+
+void ConfigletTest::testComments()
+{
+    QString path = writeConfiglet(
+        "configlet_test_comments",
+        "## comment {{if a}}\n"
+        "# shell comment {{$a}}\n"
+        "line\n");
+
+    QMap<QString, QString> vars;
+    vars["a"] = "1";
+    CPPUNIT_ASSERT_EQUAL(string("# shell comment 1\nline"),
+                         expand(path, vars).toStdString());
+
+    Configlet c("", path);
+    c.setVariable("a", 1);
+    c.removeComments("#");
+    CPPUNIT_ASSERT_EQUAL(string("line"), c.expand().toStdString());
+    CPPUNIT_ASSERT_EQUAL(string("line"), expandLegacy(c).toStdString());
+}
+
+void ConfigletTest::testMacroInValue()
+{
+    QString path = writeConfiglet(
+        "configlet_test_macro_in_value",
+        "{{$a}}");
+
+    QMap<QString, QString> vars;
+    vars["a"] = "{{if b}}{{$c}}{{endif}}";
+    vars["b"] = "1";
+    vars["c"] = "c";
+    CPPUNIT_ASSERT_EQUAL(string("c"), expand(path, vars).toStdString());
+}
+
+void ConfigletTest::testFileChanged()
+{
+    QMap<QString, QString> vars;
+    vars["a"] = "1";
+
+    QString path = writeConfiglet("configlet_test_file_changed", "{{$a}}");
+    CPPUNIT_ASSERT_EQUAL(string("1"), expand(path, vars).toStdString());
+
+    writeConfiglet("configlet_test_file_changed", "new {{$a}}");
+    CPPUNIT_ASSERT_EQUAL(string("new 1"), expand(path, vars).toStdString());
+}
+
+class ConfigletExpansionThread : public QThread
+{
+    QString path;
+
+public:
+    int failures;
+
+    ConfigletExpansionThread(const QString &_path) : path(_path)
+    { failures = 0; }
+
+    virtual void run()
+    {
+        for (int i=0; i<500; ++i)
+        {
+            Configlet c("", path);
+            c.setVariable("a", i);
+            c.setVariable("cond", i % 2);
+            QString expected = QString("value %1\n%2").arg(i)
+                .arg((i % 2) ? "yes" : "");
+            if (c.expand() != expected) failures++;
+        }
+    }
+};
+
+/*
+ * Compilers running in parallel threads share the cache of configlet
+ * templates, expansion must not be affected by the cache being
+ * cleared or refilled by another thread.
+ */
+void ConfigletTest::testThreads()
+{
+    QString path = writeConfiglet(
+        "configlet_test_threads",
+        "value {{$a}}\n{{if cond}}yes{{endif}}");
+
+    QList<ConfigletExpansionThread*> threads;
+    for (int i=0; i<4; ++i)
+    {
+        ConfigletExpansionThread *t = new ConfigletExpansionThread(path);
+        threads.push_back(t);
+        t->start();
+    }
+
+    for (int i=0; i<200; ++i) ConfigletTemplate::clearCache();
+
+    int failures = 0;
+    foreach(ConfigletExpansionThread *t, threads)
+    {
+        t->wait();
+        failures += t->failures;
+        delete t;
+    }
+    CPPUNIT_ASSERT_EQUAL(0, failures);
+}
+
+/*
+ * Value of a stream variable should appear in the generated text the
+ * same way as the value of a string variable with each line indented
+ * by CompilerDriver::indent()
+ */
+void ConfigletTest::testStreamVariables()
+{
+    QString path = writeConfiglet(
+        "configlet_test_stream_variables",
+        "f() {\n"
+        "    {{$body}}\n"
+        "}\n"
+        "{{if a}}a{{endif}}\n"
+        "{{$body}}\n");
+
+    fwcompiler::ChunkedOutput body;
+    body << "\n  line1\n\nline2\n  line3  \n\n";
+
+    Configlet c("", path);
+    c.setVariable("a", 1);
+    c.setVariable("body", &body, 4);
+
+    Configlet s("", path);
+    s.setVariable("a", 1);
+    s.setVariable("body", "\n      line1\n\n    line2\n      line3  \n\n");
+
+    string expected = s.expand().toStdString();
+    CPPUNIT_ASSERT(expected.find("f() {\n    line1\n\n    line2\n"
+                                 "      line3\n}\na\nline1\n") == 0);
+
+    CPPUNIT_ASSERT_EQUAL(expected, c.expand().toStdString());
+
+    fwcompiler::ChunkedOutput out;
+    out << "# ";
+    c.expand(out);
+    CPPUNIT_ASSERT_EQUAL("# " + expected, out.str());
+
+    // text added to the stream after expansion does not change it
+    body << "line4\n";
+    CPPUNIT_ASSERT_EQUAL("# " + expected, out.str());
+}
+
+/*
+ * Expands every configlet in the resources directory with all
+ * variables used in {{if}} statements set to 1 and then to 0,
+ * compares results and prints time it took to expand them with
+ * regular expressions and precompiled templates. Configlet objects
+ * are created for each expansion, the same way compilers do it.
+ */
+void ConfigletTest::testAllConfiglets()
+{
+    const int iterations = 20;
+
+    QDir configlets_dir(
+        QString(Constants::getResourcesDirectory().c_str()) + "/configlets");
+    CPPUNIT_ASSERT(configlets_dir.exists());
+
+    QStringList files;
+    foreach(QString dir_name,
+            configlets_dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        QDir dir(configlets_dir.absoluteFilePath(dir_name));
+        foreach(QFileInfo fi, dir.entryInfoList(QDir::Files))
+            files.push_back(fi.absoluteFilePath());
+    }
+    CPPUNIT_ASSERT(files.size() > 0);
+
+    QRegExp var_re("\\{\\{\\$([^}]*)\\}\\}");
+    QRegExp if_re("\\{\\{if ([^}]+)\\}\\}");
+    var_re.setMinimal(true);
+    if_re.setMinimal(true);
+
+    int legacy_ms = 0;
+    int precompiled_ms = 0;
+
+    foreach(QString file_path, files)
+    {
+        QFile file(file_path);
+        CPPUNIT_ASSERT(file.open(QFile::ReadOnly));
+        QString text = QTextStream(&file).readAll();
+
+        QSet<QString> var_names;
+        QSet<QString> if_names;
+        int pos = 0;
+        while ((pos = var_re.indexIn(text, pos)) != -1)
+        {
+            var_names.insert(var_re.cap(1));
+            pos += var_re.matchedLength();
+        }
+        pos = 0;
+        while ((pos = if_re.indexIn(text, pos)) != -1)
+        {
+            if_names.insert(if_re.cap(1));
+            pos += if_re.matchedLength();
+        }
+
+        for (int cond=0; cond<2; ++cond)
+        {
+            QString legacy_res;
+            QString precompiled_res;
+            QTime t;
+
+            t.start();
+            for (int i=0; i<iterations; ++i)
+            {
+                ConfigletTemplate::clearCache();
+                Configlet c("", file_path);
+                foreach(QString var, var_names) c.setVariable(var, "v_" + var);
+                foreach(QString var, if_names) c.setVariable(var, cond);
+                legacy_res = expandLegacy(c);
+            }
+            legacy_ms += t.elapsed();
+
+            t.start();
+            for (int i=0; i<iterations; ++i)
+            {
+                Configlet c("", file_path);
+                foreach(QString var, var_names) c.setVariable(var, "v_" + var);
+                foreach(QString var, if_names) c.setVariable(var, cond);
+                precompiled_res = c.expand();
+            }
+            precompiled_ms += t.elapsed();
+
+            if (legacy_res != precompiled_res)
+                CPPUNIT_FAIL(
+                    QString("Configlet %1 expands differently with "
+                            "precompiled template").arg(file_path)
+                    .toStdString());
+        }
+    }
+
+    cout << endl
+         << files.size() << " configlets, "
+         << iterations << " expansions each: "
+         << "regular expressions " << legacy_ms << " ms, "
+         << "precompiled templates " << precompiled_ms << " ms"
+         << endl;
+}
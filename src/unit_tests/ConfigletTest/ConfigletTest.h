@@ -0,0 +1,72 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef CONFIGLETTEST_H
+#define CONFIGLETTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <QMap>
+#include <QString>
+
+class Configlet;
+
+
+class ConfigletTest : public CppUnit::TestFixture
+{
+    QString writeConfiglet(const QString &file_name, const QString &text);
+    QString expand(const QString &file_path,
+                   const QMap<QString, QString> &vars);
+    QString expandLegacy(Configlet &c);
+
+public:
+    void tearDown();
+
+    void testVariables();
+    void testIf();
+    void testNestedIf();
+    void testUnmatchedIf();
+    void testComments();
+    void testMacroInValue();
+    void testFileChanged();
+    void testThreads();
+    void testStreamVariables();
+    void testAllConfiglets();
+
+    CPPUNIT_TEST_SUITE(ConfigletTest);
+
+    CPPUNIT_TEST(testVariables);
+    CPPUNIT_TEST(testIf);
+    CPPUNIT_TEST(testNestedIf);
+    CPPUNIT_TEST(testUnmatchedIf);
+    CPPUNIT_TEST(testComments);
+    CPPUNIT_TEST(testMacroInValue);
+    CPPUNIT_TEST(testFileChanged);
+    CPPUNIT_TEST(testThreads);
+    CPPUNIT_TEST(testStreamVariables);
+    CPPUNIT_TEST(testAllConfiglets);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // CONFIGLETTEST_H
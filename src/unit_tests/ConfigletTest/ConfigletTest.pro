@@ -0,0 +1,9 @@
+include(../tests_common.pri)
+
+TARGET = ConfigletTest
+SOURCES = ConfigletTest.cpp main.cpp
+HEADERS = ConfigletTest.h
+
+run_tests.commands = echo "Running tests..." && \
+    rm -f configlet_test_* && \
+    ./${TARGET}
@@ -37,7 +37,17 @@
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Library.h"
 #include "fwbuilder/DNSName.h"
+#include "fwbuilder/dns.h"
+#include "fwbuilder/ThreadTools.h"
+
 #include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
 
 using namespace libfwbuilder;
 using namespace std;
@@ -121,3 +131,203 @@ void DNSTest::runTest()
 
     CPPUNIT_ASSERT(testDNSNameObject(objdb, root, test3[0], &(test3[1])));
 }
+
+/*
+ * Stub resolver that looks names up in a hosts file instead of
+ * running DNS queries. Every query takes one second, names that start
+ * with "slow" take much longer than that. Keeps track of the number
+ * of queries and of the number of queries running at the same time.
+ */
+static map<string, list<string> > hosts;
+static Mutex stub_mutex;
+static int stub_queries = 0;
+static int stub_running = 0;
+static int stub_max_running = 0;
+
+static void loadHostsFile(const string &file_name)
+{
+    hosts.clear();
+    ifstream in(file_name.c_str());
+    string line;
+    while (getline(in, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream str(line);
+        string addr, name;
+        str >> addr;
+        while (str >> name) hosts[name].push_back(addr);
+    }
+}
+
+static list<InetAddr> stubResolver(const string &name, int type)
+{
+    stub_mutex.lock();
+    stub_queries++;
+    stub_running++;
+    if (stub_running > stub_max_running) stub_max_running = stub_running;
+    stub_mutex.unlock();
+
+    sleep((name.find("slow") == 0) ? 20 : 1);
+
+    stub_mutex.lock();
+    stub_running--;
+    stub_mutex.unlock();
+
+    list<InetAddr> res;
+    map<string, list<string> >::iterator it = hosts.find(name);
+    if (it != hosts.end())
+    {
+        for (list<string>::iterator i=it->second.begin(); i!=it->second.end(); ++i)
+        {
+            int af = (i->find(':') == string::npos) ? AF_INET : AF_INET6;
+            if (af == type) res.push_back(InetAddr(af, *i));
+        }
+    }
+    if (res.empty())
+        throw FWException("Host or network '" + name + "' not found");
+    return res;
+}
+
+static void writeHostsFile(const string &file_name)
+{
+    ofstream out(file_name.c_str());
+    out << "# test hosts file" << endl;
+    for (int i=0; i<8; ++i)
+        out << "192.0.2." << (i + 1) << " host" << i << ".test" << endl;
+    out << "198.51.100.1 multi.test" << endl;
+    out << "198.51.100.2 multi.test" << endl;
+    out << "2001:db8::10 multi.test" << endl;
+    out << "203.0.113.1 slow.test" << endl;
+}
+
+void DNSTest::parallelResolverTest()
+{
+    writeHostsFile("/tmp/fwb_dns_test_hosts");
+    loadHostsFile("/tmp/fwb_dns_test_hosts");
+    DNS::setResolver(stubResolver);
+    DNS::getCache()->clear();
+
+    list<string> names;
+    for (int i=0; i<8; ++i)
+    {
+        ostringstream str;
+        str << "host" << i << ".test";
+        names.push_back(str.str());
+    }
+    names.push_back("multi.test");
+    names.push_back("host0.test");   // duplicate is queried once
+    names.push_back("missing.test");
+
+    stub_queries = 0;
+    stub_max_running = 0;
+    time_t start = time(NULL);
+    DNS::resolveNames(names, AF_INET, 4, 10, 3600);
+    time_t elapsed = time(NULL) - start;
+
+    // 10 queries, 4 at a time, one second each
+    CPPUNIT_ASSERT(stub_queries == 10);
+    CPPUNIT_ASSERT(stub_max_running <= 4);
+    CPPUNIT_ASSERT(stub_max_running > 1);
+    CPPUNIT_ASSERT(elapsed < 8);
+
+    // results come from the cache now
+    list<InetAddr> res = DNS::getHostByName("multi.test", AF_INET);
+    CPPUNIT_ASSERT(res.size() == 2);
+    CPPUNIT_ASSERT(res.front().toString() == "198.51.100.1");
+    CPPUNIT_ASSERT(DNS::getHostByName("host7.test", AF_INET).front().toString() ==
+                   "192.0.2.8");
+    CPPUNIT_ASSERT_THROW(DNS::getHostByName("missing.test", AF_INET),
+                         FWException);
+    CPPUNIT_ASSERT(stub_queries == 10);
+
+    // names in the cache are not queried again
+    DNS::resolveNames(names, AF_INET, 4, 10, 3600);
+    CPPUNIT_ASSERT(stub_queries == 10);
+
+    // failed queries are forgotten
+    DNS::getCache()->clearErrors();
+    CPPUNIT_ASSERT_THROW(DNS::getHostByName("missing.test", AF_INET),
+                         FWException);
+    CPPUNIT_ASSERT(stub_queries == 11);
+
+    // IPv6 results are kept separately
+    res = DNS::getHostByName("multi.test", AF_INET6);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res.front().toString() == "2001:db8::10");
+
+    // timeout applies to each query rather than to all of them,
+    // names waiting in the queue do not time out
+    DNS::getCache()->clear();
+    stub_queries = 0;
+    DNS::resolveNames(names, AF_INET, 2, 3, 3600);
+    CPPUNIT_ASSERT(stub_queries == 10);
+    list<InetAddr> addrs;
+    string error;
+    CPPUNIT_ASSERT(DNS::getCache()->lookup("host7.test", AF_INET, addrs, error));
+    CPPUNIT_ASSERT(error.empty() && addrs.size() == 1);
+
+    // query that does not finish in time does not hold up the rest
+    // and its name is left out of the cache
+    names.clear();
+    names.push_back("slow.test");
+    names.push_back("host0.test");
+    DNS::getCache()->clear();
+    start = time(NULL);
+    DNS::resolveNames(names, AF_INET, 1, 3, 3600);
+    CPPUNIT_ASSERT(time(NULL) - start < 6);
+    CPPUNIT_ASSERT(DNS::getHostByName("host0.test", AF_INET).size() == 1);
+    CPPUNIT_ASSERT(!DNS::getCache()->lookup("slow.test", AF_INET, addrs, error));
+
+    DNS::getCache()->clear();
+    DNS::setResolver(NULL);
+}
+
+void DNSTest::cacheFileTest()
+{
+    string cache_file = "/tmp/fwb_dns_test_cache";
+    remove(cache_file.c_str());
+
+    DNSCache *cache = DNS::getCache();
+    cache->clear();
+
+    list<InetAddr> addrs;
+    addrs.push_back(InetAddr("192.0.2.1"));
+    addrs.push_back(InetAddr("192.0.2.2"));
+    cache->store("a.test", AF_INET, addrs, 3600);
+    addrs.clear();
+    addrs.push_back(InetAddr(AF_INET6, "2001:db8::1"));
+    cache->store("a.test", AF_INET6, addrs, 3600);
+    cache->store("expired.test", AF_INET, addrs, 0);
+    cache->storeError("bad.test", AF_INET, "not found");
+    cache->save(cache_file);
+
+    cache->clear();
+    CPPUNIT_ASSERT(cache->size() == 0);
+    cache->load(cache_file);
+    CPPUNIT_ASSERT(cache->size() == 2);
+
+    string error;
+    CPPUNIT_ASSERT(cache->lookup("a.test", AF_INET, addrs, error));
+    CPPUNIT_ASSERT(error.empty());
+    CPPUNIT_ASSERT(addrs.size() == 2);
+    CPPUNIT_ASSERT(addrs.back().toString() == "192.0.2.2");
+    CPPUNIT_ASSERT(cache->lookup("a.test", AF_INET6, addrs, error));
+    CPPUNIT_ASSERT(addrs.front().toString() == "2001:db8::1");
+    CPPUNIT_ASSERT(!cache->lookup("expired.test", AF_INET, addrs, error));
+    CPPUNIT_ASSERT(!cache->lookup("bad.test", AF_INET, addrs, error));
+
+    // loaded results are used without running queries
+    DNS::setResolver(stubResolver);
+    stub_queries = 0;
+    CPPUNIT_ASSERT(DNS::getHostByName("a.test", AF_INET).size() == 2);
+    CPPUNIT_ASSERT(stub_queries == 0);
+    DNS::setResolver(NULL);
+
+    ofstream out(cache_file.c_str());
+    out << "a.test 5 0" << endl;
+    out.close();
+    CPPUNIT_ASSERT_THROW(cache->load(cache_file), FWException);
+
+    cache->clear();
+    remove(cache_file.c_str());
+}
@@ -44,11 +44,15 @@ class DNSTest : public CppUnit::TestCase
                            char* results[]);
 public:
     void runTest();
+    void parallelResolverTest();
+    void cacheFileTest();
 
     static CppUnit::Test *suite()
     {
       CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ObjectMatcherTest" );
       suiteOfTests->addTest( new CppUnit::TestCaller<DNSTest>( "runTest", &DNSTest::runTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DNSTest>( "parallelResolverTest", &DNSTest::parallelResolverTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DNSTest>( "cacheFileTest", &DNSTest::cacheFileTest ) );
       return suiteOfTests;
     }
 };
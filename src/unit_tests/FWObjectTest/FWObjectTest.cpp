@@ -39,6 +39,20 @@
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Firewall.h"
 #include "fwbuilder/Group.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/FWReference.h"
+
+#include <time.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
 
 using namespace libfwbuilder;
 using namespace std;
@@ -86,3 +100,312 @@ void FWObjectTest::cmpTest()
 
     CPPUNIT_ASSERT(obj1->cmp(obj2, true) == true);
 }
+
+void FWObjectTest::replaceRefsTest()
+{
+    FWObjectDatabase db;
+    Library *lib = db.createLibrary();
+    db.add(lib);
+
+    FWObject *h1 = db.createHost();
+    FWObject *h2 = db.createHost();
+    FWObject *h3 = db.createHost();
+    lib->add(h1);
+    lib->add(h2);
+    lib->add(h3);
+
+    FWObject *grp = db.createObjectGroup();
+    lib->add(grp);
+    grp->addRef(h1);
+    grp->addRef(h2);
+
+    Firewall *fw = db.createFirewall();
+    lib->add(fw);
+    FWObject *itf = db.createInterface();
+    fw->add(itf);
+    itf->setStr("network_zone", FWObjectDatabase::getStringId(h1->getId()));
+
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    RuleSet *branch1 = db.createPolicy();
+    RuleSet *branch2 = db.createPolicy();
+    fw->add(branch1);
+    fw->add(branch2);
+    PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+    rule->getSrc()->addRef(h1);
+    rule->getDst()->addRef(h2);
+    rule->setAction(PolicyRule::Branch);
+    rule->getOptionsObject()->setStr(
+        "branch_id", FWObjectDatabase::getStringId(branch1->getId()));
+
+    CPPUNIT_ASSERT(lib->replaceRef(h1->getId(), h1->getId()) == 0);
+
+    // mapping is not transitive: references to h1 point to h2, not h3
+    map<int,int> map_ids;
+    map_ids[h1->getId()] = h2->getId();
+    map_ids[h2->getId()] = h3->getId();
+    map_ids[branch1->getId()] = branch2->getId();
+    CPPUNIT_ASSERT(lib->replaceRefs(map_ids) == 6);
+
+    list<FWObject*>::iterator it = grp->begin();
+    CPPUNIT_ASSERT(FWReference::cast(*it)->getPointerId() == h2->getId());
+    ++it;
+    CPPUNIT_ASSERT(FWReference::cast(*it)->getPointerId() == h3->getId());
+
+    CPPUNIT_ASSERT(FWReference::cast(rule->getSrc()->front())->getPointerId() ==
+                   h2->getId());
+    CPPUNIT_ASSERT(FWReference::cast(rule->getDst()->front())->getPointerId() ==
+                   h3->getId());
+    CPPUNIT_ASSERT(rule->getOptionsObject()->getStr("branch_id") ==
+                   FWObjectDatabase::getStringId(branch2->getId()));
+    CPPUNIT_ASSERT(itf->getStr("network_zone") ==
+                   FWObjectDatabase::getStringId(h2->getId()));
+
+    CPPUNIT_ASSERT(db.fixReferences(grp, map_ids) == 1);
+}
+
+static Firewall* createFirewallWithRules(FWObjectDatabase *db, FWObject *lib,
+                                         FWObject *addresses, int num_rules)
+{
+    Firewall *fw = db->createFirewall();
+    lib->add(fw);
+    FWObject *itf = db->createInterface();
+    fw->add(itf);
+
+    vector<FWObject*> addr;
+    for (FWObjectTypedChildIterator it = addresses->findByType(Host::TYPENAME);
+         it != it.end(); ++it)
+        addr.push_back(*it);
+
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    for (int i=0; i<num_rules; ++i)
+    {
+        PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+        rule->getSrc()->addRef(addr[i % addr.size()]);
+        rule->getDst()->addRef(fw);
+        rule->getItf()->addRef(itf);
+    }
+    return fw;
+}
+
+/*
+ * Copies firewall with lots of rules into another library. Rules
+ * refer to the firewall and its interface, these references must
+ * point to the copies. Prints time it took to copy and, for
+ * comparison, time of replacing references one ID at a time in a
+ * smaller firewall.
+ */
+void FWObjectTest::copySubtreeTest()
+{
+    FWObjectDatabase db;
+    Library *lib1 = db.createLibrary();
+    Library *lib2 = db.createLibrary();
+    db.add(lib1);
+    db.add(lib2);
+
+    FWObject *addresses = db.createObjectGroup();
+    lib1->add(addresses);
+    for (int i=0; i<1000; ++i) addresses->add(db.createHost());
+
+    Firewall *fw = createFirewallWithRules(&db, lib1, addresses, 5000);
+
+    map<int,int> map_ids;
+    clock_t start = clock();
+    FWObject *copy = db.recursivelyCopySubtree(lib2, fw, map_ids);
+    clock_t copy_time = clock() - start;
+
+    CPPUNIT_ASSERT(Firewall::cast(copy) != NULL);
+    CPPUNIT_ASSERT(copy->getParent() == lib2);
+
+    FWObject *itf_copy = copy->getFirstByType(Interface::TYPENAME);
+    RuleSet *policy = RuleSet::cast(copy->getFirstByType(Policy::TYPENAME));
+    int num_rules = 0;
+    for (FWObject::iterator it=policy->begin(); it!=policy->end(); ++it)
+    {
+        PolicyRule *rule = PolicyRule::cast(*it);
+        if (rule == NULL) continue;
+        num_rules++;
+        FWObject *src = FWReference::getObject(rule->getSrc()->front());
+        CPPUNIT_ASSERT(src->getParent() == addresses);
+        CPPUNIT_ASSERT(FWReference::getObject(rule->getDst()->front()) == copy);
+        CPPUNIT_ASSERT(FWReference::getObject(rule->getItf()->front()) ==
+                       itf_copy);
+    }
+    CPPUNIT_ASSERT(num_rules == 5000);
+
+    // the same tree as above but with one tenth of the rules, IDs
+    // replaced one at a time
+    Firewall *small_fw = createFirewallWithRules(&db, lib1, addresses, 500);
+    map<int,int> small_map_ids;
+    FWObject *small_copy = db.recursivelyCopySubtree(lib2, small_fw,
+                                                     small_map_ids);
+    map<int,int> reverse_map_ids;
+    for (map<int,int>::iterator it=small_map_ids.begin();
+         it!=small_map_ids.end(); ++it)
+        reverse_map_ids[it->second] = it->first;
+
+    start = clock();
+    int counter = 0;
+    for (map<int,int>::iterator it=reverse_map_ids.begin();
+         it!=reverse_map_ids.end(); ++it)
+        counter += small_copy->replaceRef(it->first, it->second);
+    clock_t one_by_one_time = clock() - start;
+    CPPUNIT_ASSERT(counter == 1000);
+
+    cout << endl
+         << "Copy of firewall with 5000 rules: "
+         << 1000 * copy_time / CLOCKS_PER_SEC << " ms, "
+         << map_ids.size() << " IDs; "
+         << "replacing " << reverse_map_ids.size()
+         << " IDs one at a time in firewall with 500 rules: "
+         << 1000 * one_by_one_time / CLOCKS_PER_SEC << " ms"
+         << endl;
+}
+
+void FWObjectTest::attributesTest()
+{
+    FWObjectDatabase db;
+    FWObject *obj1 = db.create(Host::TYPENAME);
+
+    obj1->setStr("zzz", "3");
+    obj1->setStr("aaa", "1");
+    obj1->setStr("mmm", "2");
+    obj1->setInt("int_attr", 10);
+    obj1->setBool("bool_attr", true);
+
+    CPPUNIT_ASSERT(obj1->getStr("aaa") == "1");
+    CPPUNIT_ASSERT(obj1->getStr("mmm") == "2");
+    CPPUNIT_ASSERT(obj1->getStr("zzz") == "3");
+    CPPUNIT_ASSERT(obj1->getInt("int_attr") == 10);
+    CPPUNIT_ASSERT(obj1->getBool("bool_attr") == true);
+    CPPUNIT_ASSERT(obj1->exists("aaa"));
+    CPPUNIT_ASSERT(!obj1->exists("bbb"));
+    CPPUNIT_ASSERT(obj1->getStr("bbb").empty());
+
+    // attributes are iterated in the order of their names, this
+    // determines order of attributes in the data file
+    map<string, string> expected(obj1->dataBegin(), obj1->dataEnd());
+    CPPUNIT_ASSERT(expected.size() == 5);
+    map<string, string>::iterator e = expected.begin();
+    for (AttributeMap::const_iterator it=obj1->dataBegin();
+         it!=obj1->dataEnd(); ++it, ++e)
+    {
+        CPPUNIT_ASSERT(it->first.str() == e->first);
+        CPPUNIT_ASSERT(it->second == e->second);
+    }
+
+    obj1->setStr("mmm", "22");
+    CPPUNIT_ASSERT(obj1->getStr("mmm") == "22");
+    obj1->remStr("mmm");
+    CPPUNIT_ASSERT(!obj1->exists("mmm"));
+    CPPUNIT_ASSERT(obj1->getStr("aaa") == "1");
+    CPPUNIT_ASSERT(obj1->getStr("zzz") == "3");
+
+    FWObject *obj2 = db.create(Host::TYPENAME);
+    obj2->duplicate(obj1);
+    CPPUNIT_ASSERT(obj1->cmp(obj2) == true);
+    CPPUNIT_ASSERT(obj2->getStr("zzz") == "3");
+    obj2->setStr("zzz", "4");
+    CPPUNIT_ASSERT(obj1->cmp(obj2) == false);
+    CPPUNIT_ASSERT(obj1->getStr("zzz") == "3");
+}
+
+/*
+ * Compiler drivers copy options from one attribute to another of the
+ * same object, as in setStr("prolog_script", getStr("pix_prolog_script")).
+ * Adding the new attribute must not leave the value pointing at moved
+ * memory, whatever the number of attributes the object already has.
+ */
+void FWObjectTest::setStrFromOwnAttributeTest()
+{
+    FWObjectDatabase db;
+    string long_value(200, 'x');
+    long_value += "end";
+
+    for (int n=0; n<40; ++n)
+    {
+        FWObject *obj = db.create(Host::TYPENAME);
+        for (int i=0; i<n; ++i)
+        {
+            ostringstream str;
+            str << "attr" << i;
+            obj->setStr(str.str(), str.str());
+        }
+        obj->setStr("pix_prolog_script", long_value);
+        obj->setStr("prolog_script", obj->getStr("pix_prolog_script"));
+        CPPUNIT_ASSERT(obj->getStr("prolog_script") == long_value);
+        CPPUNIT_ASSERT(obj->getStr("pix_prolog_script") == long_value);
+
+        // existing attribute, same value
+        obj->setStr("prolog_script", obj->getStr("prolog_script"));
+        CPPUNIT_ASSERT(obj->getStr("prolog_script") == long_value);
+        delete obj;
+    }
+}
+
+/*
+ * setStr() marks the object tree dirty only when the stored value
+ * changes. A missing attribute reads as an empty string, so adding it
+ * with an empty value is not a change.
+ */
+void FWObjectTest::setStrDirtyTest()
+{
+    FWObjectDatabase db;
+    FWObject *obj = db.create(Host::TYPENAME);
+
+    db.setDirty(false);
+    obj->setStr("comment", "");
+    CPPUNIT_ASSERT(!obj->isDirty());
+
+    obj->setStr("comment", "text");
+    CPPUNIT_ASSERT(obj->isDirty());
+
+    db.setDirty(false);
+    obj->setStr("comment", "text");
+    CPPUNIT_ASSERT(!obj->isDirty());
+
+    obj->setStr("comment", "");
+    CPPUNIT_ASSERT(obj->isDirty());
+
+    db.setDirty(false);
+    obj->setStr(".hidden", "value");
+    CPPUNIT_ASSERT(!obj->isDirty());
+
+    delete obj;
+}
+
+void FWObjectTest::keywordsTest()
+{
+    FWObjectDatabase db;
+    FWObject *obj1 = db.create(Host::TYPENAME);
+    FWObject *obj2 = db.create(Host::TYPENAME);
+
+    CPPUNIT_ASSERT(obj1->getKeywords().empty());
+    CPPUNIT_ASSERT(obj1->getPrivateData("data") == NULL);
+
+    obj1->addKeyword("foo");
+    obj1->addKeyword("bar");
+    CPPUNIT_ASSERT(obj1->getKeywords().size() == 2);
+    CPPUNIT_ASSERT(obj2->getKeywords().empty());
+    CPPUNIT_ASSERT(obj1->getAllKeywords().count("foo") == 1);
+    CPPUNIT_ASSERT(obj1->cmp(obj2) == false);
+
+    obj2->duplicate(obj1);
+    CPPUNIT_ASSERT(obj2->getKeywords().size() == 2);
+    CPPUNIT_ASSERT(obj1->cmp(obj2) == true);
+
+    obj2->removeKeyword("foo");
+    CPPUNIT_ASSERT(obj2->getKeywords().size() == 1);
+    CPPUNIT_ASSERT(obj1->getKeywords().size() == 2);
+    obj2->removeKeyword("bar");
+    obj1->clearKeywords();
+    CPPUNIT_ASSERT(obj1->getKeywords().empty());
+    CPPUNIT_ASSERT(obj1->cmp(obj2) == true);
+    CPPUNIT_ASSERT(obj1->getAllKeywords().count("foo") == 1);
+
+    int value = 1;
+    obj1->setPrivateData("data", &value);
+    CPPUNIT_ASSERT(obj1->getPrivateData("data") == &value);
+    CPPUNIT_ASSERT(obj2->getPrivateData("data") == NULL);
+    obj2->duplicate(obj1);
+    CPPUNIT_ASSERT(obj2->getPrivateData("data") == &value);
+}
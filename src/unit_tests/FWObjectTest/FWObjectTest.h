@@ -35,6 +35,12 @@ class FWObjectTest : public CppUnit::TestCase
 {
 public:
     void cmpTest();
+    void replaceRefsTest();
+    void copySubtreeTest();
+    void attributesTest();
+    void keywordsTest();
+    void setStrFromOwnAttributeTest();
+    void setStrDirtyTest();
 
     static CppUnit::Test *suite()
     {
@@ -42,6 +48,24 @@ public:
       suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
                                    "cmpTest",
                                    &FWObjectTest::cmpTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "replaceRefsTest",
+                                   &FWObjectTest::replaceRefsTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "copySubtreeTest",
+                                   &FWObjectTest::copySubtreeTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "attributesTest",
+                                   &FWObjectTest::attributesTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "keywordsTest",
+                                   &FWObjectTest::keywordsTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "setStrFromOwnAttributeTest",
+                                   &FWObjectTest::setStrFromOwnAttributeTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "setStrDirtyTest",
+                                   &FWObjectTest::setStrDirtyTest ) );
       return suiteOfTests;
     }
 };
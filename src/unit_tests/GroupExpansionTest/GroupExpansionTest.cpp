@@ -0,0 +1,225 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "GroupExpansionTest.h"
+
+#include "fwcompiler/Compiler.h"
+
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/InetAddr.h"
+#include "fwbuilder/ObjectGroup.h"
+
+#include <list>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+void GroupExpansionTest::setUp()
+{
+    db = new FWObjectDatabase();
+    lib = db->createLibrary();
+    lib->setName("User");
+    db->add(lib);
+    fw = db->createFirewall();
+    fw->setName("fw");
+    lib->add(fw);
+}
+
+void GroupExpansionTest::tearDown()
+{
+    delete db;
+}
+
+FWObject* GroupExpansionTest::addIPv4(const string &name, const string &addr)
+{
+    IPv4 *obj = db->createIPv4();
+    obj->setName(name);
+    obj->setAddress(InetAddr(addr));
+    lib->add(obj);
+    return obj;
+}
+
+FWObject* GroupExpansionTest::addIPv6(const string &name, const string &addr)
+{
+    IPv6 *obj = db->createIPv6();
+    obj->setName(name);
+    obj->setAddress(InetAddr(AF_INET6, addr));
+    lib->add(obj);
+    return obj;
+}
+
+FWObject* GroupExpansionTest::addGroup(const string &name)
+{
+    ObjectGroup *grp = db->createObjectGroup();
+    grp->setName(name);
+    lib->add(grp);
+    return grp;
+}
+
+void GroupExpansionTest::testFlatten()
+{
+    FWObject *a = addIPv4("a", "10.0.0.1");
+    FWObject *b = addIPv4("b", "10.0.0.2");
+    FWObject *c = addIPv4("c", "10.0.0.3");
+
+    FWObject *inner = addGroup("inner");
+    inner->addRef(c);
+    inner->addRef(a);
+
+    FWObject *outer = addGroup("outer");
+    outer->addRef(b);
+    outer->addRef(inner);
+    outer->addRef(a);
+
+    Compiler compiler(db, fw, false);
+    const list<FWObject*> &members = compiler.getExpandedGroupMembers(outer);
+
+    // nested group is flattened, "a" appears only once and the list
+    // is sorted by name
+    CPPUNIT_ASSERT(members.size() == 3);
+    list<FWObject*>::const_iterator i = members.begin();
+    CPPUNIT_ASSERT(*i++ == a);
+    CPPUNIT_ASSERT(*i++ == b);
+    CPPUNIT_ASSERT(*i++ == c);
+
+    // expandGroup() expands children of the object it is given, such
+    // as a rule element, using the same cached lists
+    FWObject *holder = addGroup("holder");
+    holder->addRef(outer);
+    list<FWObject*> ol;
+    compiler.expandGroup(holder, ol);
+    CPPUNIT_ASSERT(ol == members);
+}
+
+void GroupExpansionTest::testShared()
+{
+    FWObject *a = addIPv4("a", "10.0.0.1");
+    FWObject *b = addIPv4("b", "10.0.0.2");
+
+    FWObject *inner = addGroup("inner");
+    inner->addRef(a);
+    inner->addRef(b);
+
+    FWObject *outer1 = addGroup("outer1");
+    outer1->addRef(inner);
+    FWObject *outer2 = addGroup("outer2");
+    outer2->addRef(inner);
+
+    Compiler compiler(db, fw, false);
+    const list<FWObject*> &m1 = compiler.getExpandedGroupMembers(inner);
+    const list<FWObject*> &m2 = compiler.getExpandedGroupMembers(inner);
+
+    // the second request returns the same list rather than a copy
+    CPPUNIT_ASSERT(&m1 == &m2);
+
+    // outer groups reuse the cached expansion of the inner one
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(outer1).size() == 2);
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(outer2).size() == 2);
+}
+
+void GroupExpansionTest::testAddressFamily()
+{
+    FWObject *a = addIPv4("a", "10.0.0.1");
+    FWObject *a6 = addIPv6("a6", "fe80::1");
+
+    FWObject *grp = addGroup("mixed");
+    grp->addRef(a);
+    grp->addRef(a6);
+
+    Compiler compiler4(db, fw, false);
+    const list<FWObject*> &m4 = compiler4.getExpandedGroupMembers(grp);
+    CPPUNIT_ASSERT(m4.size() == 1);
+    CPPUNIT_ASSERT(m4.front() == a);
+
+    Compiler compiler6(db, fw, true);
+    const list<FWObject*> &m6 = compiler6.getExpandedGroupMembers(grp);
+    CPPUNIT_ASSERT(m6.size() == 1);
+    CPPUNIT_ASSERT(m6.front() == a6);
+}
+
+void GroupExpansionTest::testReset()
+{
+    FWObject *a = addIPv4("a", "10.0.0.1");
+    FWObject *b = addIPv4("b", "10.0.0.2");
+
+    FWObject *grp = addGroup("grp");
+    grp->addRef(a);
+
+    Compiler compiler(db, fw, false);
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(grp).size() == 1);
+
+    // membership changes are seen without resetting the cache
+    grp->addRef(b);
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(grp).size() == 2);
+
+    grp->removeRef(a);
+    const list<FWObject*> &members = compiler.getExpandedGroupMembers(grp);
+    CPPUNIT_ASSERT(members.size() == 1);
+    CPPUNIT_ASSERT(members.front() == b);
+
+    compiler.resetGroupExpansionCache();
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(grp).size() == 1);
+}
+
+void GroupExpansionTest::testNestedChange()
+{
+    FWObject *a = addIPv4("a", "10.0.0.1");
+    FWObject *b = addIPv4("b", "10.0.0.2");
+    FWObject *c = addIPv4("c", "10.0.0.3");
+
+    FWObject *inner = addGroup("inner");
+    inner->addRef(a);
+
+    FWObject *outer1 = addGroup("outer1");
+    outer1->addRef(inner);
+    FWObject *outer2 = addGroup("outer2");
+    outer2->addRef(inner);
+    outer2->addRef(c);
+
+    FWObject *holder = addGroup("holder");
+    holder->addRef(outer1);
+
+    Compiler compiler(db, fw, false);
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(outer1).size() == 1);
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(outer2).size() == 2);
+
+    // group nested in the one that has been expanded changes
+    inner->addRef(b);
+    const list<FWObject*> &m1 = compiler.getExpandedGroupMembers(outer1);
+    CPPUNIT_ASSERT(m1.size() == 2);
+    CPPUNIT_ASSERT(m1.back() == b);
+
+    // inner has been rebuilt while expanding outer1, outer2 still
+    // has the old expansion of inner and must not use it
+    CPPUNIT_ASSERT(compiler.getExpandedGroupMembers(outer2).size() == 3);
+
+    // the same through expandGroup() used by rule processors
+    inner->removeRef(a);
+    list<FWObject*> ol;
+    compiler.expandGroup(holder, ol);
+    CPPUNIT_ASSERT(ol.size() == 1);
+    CPPUNIT_ASSERT(ol.front() == b);
+}
@@ -0,0 +1,67 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef GROUPEXPANSIONTEST_H
+#define GROUPEXPANSIONTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Library.h"
+
+
+class GroupExpansionTest : public CppUnit::TestFixture
+{
+    libfwbuilder::FWObjectDatabase *db;
+    libfwbuilder::Library *lib;
+    libfwbuilder::Firewall *fw;
+
+    libfwbuilder::FWObject* addIPv4(const std::string &name,
+                                    const std::string &addr);
+    libfwbuilder::FWObject* addIPv6(const std::string &name,
+                                    const std::string &addr);
+    libfwbuilder::FWObject* addGroup(const std::string &name);
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testFlatten();
+    void testShared();
+    void testAddressFamily();
+    void testReset();
+    void testNestedChange();
+
+    CPPUNIT_TEST_SUITE(GroupExpansionTest);
+
+    CPPUNIT_TEST(testFlatten);
+    CPPUNIT_TEST(testShared);
+    CPPUNIT_TEST(testAddressFamily);
+    CPPUNIT_TEST(testReset);
+    CPPUNIT_TEST(testNestedChange);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // GROUPEXPANSIONTEST_H
@@ -33,6 +33,8 @@
 #include <stdexcept>
 
 #include <assert.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 #include "Importer.h"
 #include "IOSImporter.h"
@@ -49,6 +51,7 @@
 #include <QStringList>
 #include <QString>
 #include <QRegExp>
+#include <QTime>
 
 
 using namespace std;
@@ -337,3 +340,87 @@ void ImporterTest::IPTImporterParseVersionsTest()
                        QString("%1.output").arg(file_name));
     }
 }
+
+/*
+ * Benchmark: generate large iptables-save file with rules in the
+ * standard and user-defined chains, many of them use multiport and
+ * negation so they go through preprocessing, and import it reading
+ * directly from the file. Prints time and peak memory usage.
+ */
+void ImporterTest::IPTImporterLargeConfigTest()
+{
+    platform = "iptables";
+
+    const int n_rules = 20000;
+    const int n_chains = 10;
+
+    QString file_name = "ipt-large.test";
+    {
+        ofstream ofs(file_name.toStdString().c_str());
+        ofs << "# Generated by iptables-save v1.4.10 on Mon Apr 11 15:50:58 2011"
+            << endl;
+        ofs << "*filter" << endl;
+        ofs << ":INPUT DROP [0:0]" << endl;
+        ofs << ":FORWARD DROP [0:0]" << endl;
+        ofs << ":OUTPUT ACCEPT [0:0]" << endl;
+        for (int c=0; c<n_chains; ++c)
+            ofs << ":user_chain_" << c << " - [0:0]" << endl;
+
+        for (int i=0; i<n_rules; ++i)
+        {
+            int a = (i >> 8) & 0xff;
+            int b = i & 0xff;
+            switch (i % 4)
+            {
+            case 0:
+                ofs << "-A INPUT -i eth0 -s 10." << a << "." << b << ".1"
+                    << " -p tcp -m tcp --dport " << 1024 + i % 30000
+                    << " -m state --state NEW -j ACCEPT" << endl;
+                break;
+            case 1:
+                ofs << "-A FORWARD -s ! 10." << a << "." << b << ".0/24"
+                    << " -d 192.168." << a << ".0/24"
+                    << " -p tcp -m multiport --dports 80,443,"
+                    << 1024 + i % 30000
+                    << " -j user_chain_" << i % n_chains << endl;
+                break;
+            case 2:
+                ofs << "-A user_chain_" << i % n_chains
+                    << " -d 172.16." << a << "." << b
+                    << " -p udp -m udp --sport 53 -j ACCEPT" << endl;
+                break;
+            case 3:
+                ofs << "-A OUTPUT -o eth1 -d 10." << a << "." << b << ".2"
+                    << " -p tcp -m tcp ! --dport 22 -j DROP" << endl;
+                break;
+            }
+        }
+        ofs << "COMMIT" << endl;
+        ofs << "# Completed on Mon Apr 11 15:50:58 2011" << endl;
+    }
+
+    ifstream instream(file_name.toStdString().c_str());
+    CPPUNIT_ASSERT(instream);
+
+    QTime timer;
+    timer.start();
+
+    Importer* imp = new IPTImporter(lib, instream, logger, "test_fw");
+    CPPUNIT_ASSERT_NO_THROW( imp->run() );
+    imp->finalize();
+
+    int elapsed = timer.elapsed();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    cerr << endl
+         << "Imported " << n_rules << " iptables rules in "
+         << elapsed << " ms, "
+         << "peak RSS " << usage.ru_maxrss << " kB"
+         << endl;
+
+    CPPUNIT_ASSERT(imp->countRules() >= n_rules);
+
+    while (logger->ready()) logger->getLine();
+}
@@ -57,12 +57,14 @@ public:
     void IPTImporterTest();
     void IPTImporterNoNatTest();
     void IPTImporterParseVersionsTest();
+    void IPTImporterLargeConfigTest();
     
     CPPUNIT_TEST_SUITE(ImporterTest);
     CPPUNIT_TEST(IOSImporterTest);
     CPPUNIT_TEST(IPTImporterTest);
     CPPUNIT_TEST(IPTImporterNoNatTest);
     CPPUNIT_TEST(IPTImporterParseVersionsTest);
+    CPPUNIT_TEST(IPTImporterLargeConfigTest);
     
     CPPUNIT_TEST_SUITE_END();
 
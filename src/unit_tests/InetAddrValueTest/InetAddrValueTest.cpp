@@ -0,0 +1,338 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "InetAddrValueTest.h"
+
+#include "fwbuilder/InetAddrMask.h"
+#include "fwbuilder/InetAddrValue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+InetAddr InetAddrValueTest::randomAddress(int af)
+{
+    if (af == AF_INET)
+    {
+        struct in_addr a;
+        a.s_addr = htonl((uint32_t(rand() & 0xffff) << 16) | (rand() & 0xffff));
+        return InetAddr(&a);
+    }
+    struct in6_addr a6;
+    unsigned char *bytes = (unsigned char*)(&a6);
+    for (int i=0; i<16; ++i) bytes[i] = rand() & 0xff;
+    // make some addresses share the upper half
+    if (rand() % 2) memset(bytes, 0, 8);
+    return InetAddr(&a6);
+}
+
+/*
+ * Returns networks as a string "addr/len addr/len ..."
+ */
+string InetAddrValueTest::convertRange(const string &start, const string &end)
+{
+    vector<InetAddrMask> res = convertAddressRange(InetAddr(start),
+                                                   InetAddr(end));
+    ostringstream str;
+    for (vector<InetAddrMask>::iterator it=res.begin(); it!=res.end(); ++it)
+    {
+        if (it!=res.begin()) str << " ";
+        str << it->getAddressPtr()->toString() << "/"
+            << it->getNetmaskPtr()->getLength();
+    }
+    return str.str();
+}
+
+void InetAddrValueTest::testConversion()
+{
+    srand(1);
+    for (int i=0; i<10000; ++i)
+    {
+        InetAddr a = randomAddress((i % 2) ? AF_INET6 : AF_INET);
+        InetAddrValue v(a);
+        CPPUNIT_ASSERT(v.af == a.addressFamily());
+        CPPUNIT_ASSERT(v.toInetAddr() == a);
+        CPPUNIT_ASSERT(v.toInetAddr().toString() == a.toString());
+    }
+
+    InetAddrValue v4(InetAddr("10.1.2.3"));
+    CPPUNIT_ASSERT(v4.hi == 0);
+    CPPUNIT_ASSERT(v4.lo == 0x0a010203);
+
+    InetAddrValue v6(InetAddr(AF_INET6, "fe80::1:2"));
+    CPPUNIT_ASSERT(v6.hi == 0xfe80000000000000ULL);
+    CPPUNIT_ASSERT(v6.lo == 0x0000000000010002ULL);
+}
+
+void InetAddrValueTest::testComparison()
+{
+    srand(2);
+    for (int i=0; i<20000; ++i)
+    {
+        int af = (i % 2) ? AF_INET6 : AF_INET;
+        InetAddr a = randomAddress(af);
+        InetAddr b = (i % 5 == 0) ? a : randomAddress(af);
+        // addresses that differ only in the last bits
+        if (i % 7 == 0) b = a + 1;
+
+        InetAddrValue va(a);
+        InetAddrValue vb(b);
+        CPPUNIT_ASSERT((va == vb) == (a == b));
+        CPPUNIT_ASSERT((va != vb) == (a != b));
+        CPPUNIT_ASSERT((va < vb) == (a < b));
+        CPPUNIT_ASSERT((vb < va) == (b < a));
+        CPPUNIT_ASSERT((va <= vb) == (a < b || a == b));
+    }
+
+    // addresses of different address families are not equal and
+    // are not less than each other
+    InetAddrValue v4(InetAddr("0.0.0.1"));
+    InetAddrValue v6(InetAddr(AF_INET6, "::1"));
+    CPPUNIT_ASSERT(!(v4 == v6));
+    CPPUNIT_ASSERT(!(v4 < v6));
+    CPPUNIT_ASSERT(!(v6 < v4));
+    CPPUNIT_ASSERT(!(v4 <= v6));
+}
+
+void InetAddrValueTest::testBitOps()
+{
+    srand(3);
+    for (int i=0; i<10000; ++i)
+    {
+        int af = (i % 2) ? AF_INET6 : AF_INET;
+        InetAddr a = randomAddress(af);
+        InetAddr b = randomAddress(af);
+        InetAddrValue va(a);
+        InetAddrValue vb(b);
+
+        CPPUNIT_ASSERT((va & vb).toInetAddr() == (a & b));
+        CPPUNIT_ASSERT((va | vb).toInetAddr() == (a | b));
+        CPPUNIT_ASSERT((~va).toInetAddr() == ~a);
+        CPPUNIT_ASSERT(va.next().toInetAddr() == a + 1);
+        CPPUNIT_ASSERT(va.prev().toInetAddr() == a - 1);
+    }
+
+    // carry between the words of IPv6 address
+    InetAddrValue v6(InetAddr(AF_INET6, "::ffff:ffff:ffff:ffff"));
+    CPPUNIT_ASSERT(v6.next().toInetAddr().toString() == "0:0:0:1::");
+    CPPUNIT_ASSERT(v6.next().prev() == v6);
+
+    InetAddrValue v4(InetAddr("255.255.255.255"));
+    CPPUNIT_ASSERT(v4.next().toInetAddr().toString() == "0.0.0.0");
+    CPPUNIT_ASSERT(v4.next().hi == 0);
+}
+
+void InetAddrValueTest::testNetmask()
+{
+    for (int len=0; len<=32; ++len)
+    {
+        CPPUNIT_ASSERT(InetAddrValue::netmask(AF_INET, len).toInetAddr() ==
+                       InetAddr(AF_INET, len));
+    }
+    for (int len=0; len<=128; ++len)
+    {
+        CPPUNIT_ASSERT(InetAddrValue::netmask(AF_INET6, len).toInetAddr() ==
+                       InetAddr(AF_INET6, len));
+    }
+}
+
+void InetAddrValueTest::testSubnetRange()
+{
+    srand(4);
+    for (int i=0; i<10000; ++i)
+    {
+        int af = (i % 2) ? AF_INET6 : AF_INET;
+        int len = rand() % ((af == AF_INET) ? 33 : 129);
+        InetAddr a = randomAddress(af);
+        InetAddr nm(af, len);
+
+        InetAddrMask n(a, nm);
+        InetRangeValue r = InetRangeValue::fromSubnet(InetAddrValue(a),
+                                                      InetAddrValue(nm));
+        CPPUNIT_ASSERT(r.first.toInetAddr() == *(n.getNetworkAddressPtr()));
+        CPPUNIT_ASSERT(r.last.toInetAddr() == *(n.getBroadcastAddressPtr()));
+        CPPUNIT_ASSERT(r.contains(InetAddrValue(a)));
+        CPPUNIT_ASSERT(r.contains(r));
+    }
+
+    InetRangeValue r = InetRangeValue::fromSubnet(
+        InetAddrValue(InetAddr("192.168.1.10")),
+        InetAddrValue(InetAddr("255.255.255.0")));
+    CPPUNIT_ASSERT(r.first.toInetAddr().toString() == "192.168.1.0");
+    CPPUNIT_ASSERT(r.last.toInetAddr().toString() == "192.168.1.255");
+    CPPUNIT_ASSERT(!r.contains(InetAddrValue(InetAddr("192.168.2.0"))));
+    CPPUNIT_ASSERT(!r.contains(InetAddrValue(InetAddr(AF_INET6, "::1"))));
+}
+
+void InetAddrValueTest::testRangeToNetworks()
+{
+    CPPUNIT_ASSERT(convertRange("10.0.0.1", "10.0.0.1") == "10.0.0.1/32");
+    CPPUNIT_ASSERT(convertRange("10.0.0.1", "10.0.0.2") ==
+                   "10.0.0.1/32 10.0.0.2/32");
+    CPPUNIT_ASSERT(convertRange("10.0.0.0", "10.0.0.255") == "10.0.0.0/24");
+    CPPUNIT_ASSERT(convertRange("10.0.0.1", "10.0.0.10") ==
+                   "10.0.0.1/32 10.0.0.2/31 10.0.0.4/30 10.0.0.8/31 "
+                   "10.0.0.10/32");
+    CPPUNIT_ASSERT(convertRange("192.168.1.100", "192.168.3.20") ==
+                   "192.168.1.100/30 192.168.1.104/29 192.168.1.112/28 "
+                   "192.168.1.128/25 192.168.2.0/24 192.168.3.0/28 "
+                   "192.168.3.16/30 192.168.3.20/32");
+    CPPUNIT_ASSERT(convertRange("0.0.0.0", "255.255.255.255") == "0.0.0.0/0");
+    CPPUNIT_ASSERT(convertRange("0.0.0.0", "255.255.255.254") ==
+                   "0.0.0.0/1 128.0.0.0/2 192.0.0.0/3 224.0.0.0/4 "
+                   "240.0.0.0/5 248.0.0.0/6 252.0.0.0/7 254.0.0.0/8 "
+                   "255.0.0.0/9 255.128.0.0/10 255.192.0.0/11 "
+                   "255.224.0.0/12 255.240.0.0/13 255.248.0.0/14 "
+                   "255.252.0.0/15 255.254.0.0/16 255.255.0.0/17 "
+                   "255.255.128.0/18 255.255.192.0/19 255.255.224.0/20 "
+                   "255.255.240.0/21 255.255.248.0/22 255.255.252.0/23 "
+                   "255.255.254.0/24 255.255.255.0/25 255.255.255.128/26 "
+                   "255.255.255.192/27 255.255.255.224/28 "
+                   "255.255.255.240/29 255.255.255.248/30 "
+                   "255.255.255.252/31 255.255.255.254/32");
+    CPPUNIT_ASSERT(convertRange("10.0.0.2", "10.0.0.1") == "");
+}
+
+/*
+ * Networks created for a random range must be adjacent, cover the
+ * range exactly and each of them must be the largest network that
+ * starts where the previous one ends and still fits in the range.
+ */
+void InetAddrValueTest::testRandomRangeToNetworks()
+{
+    srand(5);
+    for (int i=0; i<20000; ++i)
+    {
+        uint32_t s = (uint32_t(rand() & 0xffff) << 16) | (rand() & 0xffff);
+        uint32_t size = 1 + rand() % ((i % 2) ? 1000 : 1000000);
+        uint32_t e = s + size - 1;
+        if (e < s) continue;
+
+        InetAddrValue start(AF_INET, 0, s);
+        InetAddrValue end(AF_INET, 0, e);
+        vector<InetAddrMask> res = convertAddressRange(start.toInetAddr(),
+                                                       end.toInetAddr());
+        CPPUNIT_ASSERT(!res.empty());
+
+        InetAddrValue next = start;
+        for (unsigned int n=0; n<res.size(); ++n)
+        {
+            InetAddrValue addr(*(res[n].getAddressPtr()));
+            InetAddrValue netm(*(res[n].getNetmaskPtr()));
+            int len = res[n].getNetmaskPtr()->getLength();
+
+            CPPUNIT_ASSERT(addr == next);
+            CPPUNIT_ASSERT((addr & netm) == addr);
+
+            InetAddrValue last = addr | ~netm;
+            CPPUNIT_ASSERT(last <= end);
+
+            // network with one bit shorter netmask either does not start
+            // at addr or goes beyond the end of the range. The last two
+            // addresses are always converted to two hosts, the same
+            // way the original algorithm did it.
+            if (len > 0 && e - uint32_t(addr.lo) != 1)
+            {
+                InetAddrValue wider = InetAddrValue::netmask(AF_INET, len - 1);
+                CPPUNIT_ASSERT((addr & wider) != addr ||
+                               end < (addr | ~wider));
+            }
+            next = last.next();
+        }
+        CPPUNIT_ASSERT(next == end.next());
+    }
+}
+
+/*
+ * Prints time it takes to compare addresses and check if an address
+ * belongs to a subnet using InetAddr and InetAddrMask objects and
+ * using InetAddrValue.
+ */
+void InetAddrValueTest::testPerformance()
+{
+    srand(6);
+    const int count = 1000;
+    const int rounds = 200;
+    for (int af_n=0; af_n<2; ++af_n)
+    {
+        int af = (af_n) ? AF_INET6 : AF_INET;
+        vector<InetAddr> addrs;
+        vector<InetAddr> masks;
+        vector<InetAddrValue> vaddrs;
+        vector<InetAddrValue> vmasks;
+        for (int i=0; i<count; ++i)
+        {
+            addrs.push_back(randomAddress(af));
+            masks.push_back(InetAddr(af, 8 + rand() % 17));
+            vaddrs.push_back(InetAddrValue(addrs.back()));
+            vmasks.push_back(InetAddrValue(masks.back()));
+        }
+
+        int n1 = 0;
+        clock_t start = clock();
+        for (int r=0; r<rounds; ++r)
+        {
+            for (int i=0; i<count; ++i)
+            {
+                const InetAddr &a = addrs[i];
+                const InetAddr &b = addrs[(i + r) % count];
+                InetAddrMask net(b, masks[i]);
+                if (a < b || a == b) n1++;
+                if (!(a < *(net.getNetworkAddressPtr())) &&
+                    !(*(net.getBroadcastAddressPtr()) < a)) n1++;
+            }
+        }
+        clock_t inet_addr_time = clock() - start;
+
+        int n2 = 0;
+        start = clock();
+        for (int r=0; r<rounds; ++r)
+        {
+            for (int i=0; i<count; ++i)
+            {
+                const InetAddrValue &a = vaddrs[i];
+                const InetAddrValue &b = vaddrs[(i + r) % count];
+                InetRangeValue net = InetRangeValue::fromSubnet(b, vmasks[i]);
+                if (a <= b) n2++;
+                if (net.contains(a)) n2++;
+            }
+        }
+        clock_t value_time = clock() - start;
+
+        CPPUNIT_ASSERT(n1 == n2);
+
+        cout << endl << ((af == AF_INET) ? "IPv4" : "IPv6") << ": "
+             << count * rounds << " comparisons and subnet checks: "
+             << "InetAddr " << 1000 * inet_addr_time / CLOCKS_PER_SEC << " ms, "
+             << "InetAddrValue " << 1000 * value_time / CLOCKS_PER_SEC << " ms"
+             << endl;
+    }
+}
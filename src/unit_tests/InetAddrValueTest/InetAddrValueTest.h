@@ -0,0 +1,63 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef INETADDRVALUETEST_H
+#define INETADDRVALUETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwbuilder/InetAddr.h"
+
+#include <string>
+
+
+class InetAddrValueTest : public CppUnit::TestFixture
+{
+    libfwbuilder::InetAddr randomAddress(int af);
+    std::string convertRange(const std::string &start, const std::string &end);
+
+public:
+    void testConversion();
+    void testComparison();
+    void testBitOps();
+    void testNetmask();
+    void testSubnetRange();
+    void testRangeToNetworks();
+    void testRandomRangeToNetworks();
+    void testPerformance();
+
+    CPPUNIT_TEST_SUITE(InetAddrValueTest);
+
+    CPPUNIT_TEST(testConversion);
+    CPPUNIT_TEST(testComparison);
+    CPPUNIT_TEST(testBitOps);
+    CPPUNIT_TEST(testNetmask);
+    CPPUNIT_TEST(testSubnetRange);
+    CPPUNIT_TEST(testRangeToNetworks);
+    CPPUNIT_TEST(testRandomRangeToNetworks);
+    CPPUNIT_TEST(testPerformance);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // INETADDRVALUETEST_H
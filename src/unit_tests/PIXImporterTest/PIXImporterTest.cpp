@@ -33,6 +33,8 @@
 #include <stdexcept>
 
 #include <assert.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 #include "Importer.h"
 #include "PIXImporter.h"
@@ -48,6 +50,7 @@
 #include <QStringList>
 #include <QString>
 #include <QRegExp>
+#include <QTime>
 
 
 using namespace std;
@@ -392,3 +395,77 @@ void PIXImporterTest::FWSM_4_1_Test()
     compareFwbFiles("test_data/fwsm1.fwb", "fwsm1.fwb");
 }
 
+
+/*
+ * Benchmark: generate large ASA configuration with many names and
+ * access lists that use them and import it reading directly from the
+ * file. Prints time and peak memory usage.
+ */
+void PIXImporterTest::LargeConfigTest()
+{
+    platform = "pix";
+
+    const int n_names = 2000;
+    const int n_rules = 20000;
+
+    QString file_name = "asa-large.test";
+    {
+        ofstream ofs(file_name.toStdString().c_str());
+        ofs << ": Saved" << endl;
+        ofs << ":" << endl;
+        ofs << "ASA Version 8.0(3) " << endl;
+        ofs << "!" << endl;
+        ofs << "hostname asa-large" << endl;
+        ofs << "names" << endl;
+        for (int i=0; i<n_names; ++i)
+            ofs << "name 10." << (i >> 8) << "." << (i & 0xff) << ".0"
+                << " net-" << i << endl;
+        ofs << "!" << endl;
+        ofs << "interface Ethernet0" << endl;
+        ofs << " nameif inside" << endl;
+        ofs << " security-level 100" << endl;
+        ofs << " ip address 192.168.1.1 255.255.255.0 " << endl;
+        ofs << "!" << endl;
+        ofs << "interface Ethernet1" << endl;
+        ofs << " nameif outside" << endl;
+        ofs << " security-level 0" << endl;
+        ofs << " ip address 192.0.2.1 255.255.255.0 " << endl;
+        ofs << "!" << endl;
+
+        for (int i=0; i<n_rules; ++i)
+        {
+            ofs << "access-list inside_in extended permit tcp"
+                << " net-" << i % n_names << " 255.255.255.0"
+                << " host 192.0.2." << i % 250 + 1
+                << " eq " << 1024 + i % 30000 << " " << endl;
+        }
+        ofs << "access-list inside_in extended deny ip any any log " << endl;
+        ofs << "access-group inside_in in interface inside" << endl;
+    }
+
+    ifstream instream(file_name.toStdString().c_str());
+    CPPUNIT_ASSERT(instream);
+
+    QTime timer;
+    timer.start();
+
+    Importer* imp = new PIXImporter(lib, instream, logger, "test_fw");
+    CPPUNIT_ASSERT_NO_THROW( imp->run() );
+    imp->finalize();
+
+    int elapsed = timer.elapsed();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    cerr << endl
+         << "Imported " << n_rules << " access list lines with "
+         << n_names << " names in "
+         << elapsed << " ms, "
+         << "peak RSS " << usage.ru_maxrss << " kB"
+         << endl;
+
+    CPPUNIT_ASSERT(imp->countRules() >= n_rules);
+
+    while (logger->ready()) logger->getLine();
+}
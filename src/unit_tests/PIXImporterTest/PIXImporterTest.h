@@ -68,6 +68,7 @@ public:
     void ACLObjectsAndGroupsTest();
     void ACLTest();
     void NamesTest();
+    void LargeConfigTest();
 
     CPPUNIT_TEST_SUITE(PIXImporterTest);
     CPPUNIT_TEST(PIX_6_Test);
@@ -80,6 +81,7 @@ public:
     CPPUNIT_TEST(ACLTest);
     CPPUNIT_TEST(NamesTest);
     CPPUNIT_TEST(FWSM_4_1_Test);
+    CPPUNIT_TEST(LargeConfigTest);
     
     CPPUNIT_TEST_SUITE_END();
 
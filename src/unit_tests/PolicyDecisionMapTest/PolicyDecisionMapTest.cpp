@@ -0,0 +1,627 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "PolicyDecisionMapTest.h"
+
+#include "fwcompiler/PolicyDecisionMap.h"
+
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/AddressTable.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/InetAddr.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TCPService.h"
+#include "fwbuilder/UDPService.h"
+
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+void PolicyDecisionMapTest::setUp()
+{
+    db = new FWObjectDatabase();
+    lib = db->createLibrary();
+    lib->setName("User");
+    db->add(lib);
+    fw = db->createFirewall();
+    fw->setName("fw");
+    lib->add(fw);
+
+    const char *names[] = { "eth0", "eth1", "eth2" };
+    for (int n=0; n<3; ++n)
+    {
+        Interface *itf = db->createInterface();
+        itf->setName(names[n]);
+        fw->add(itf);
+        IPv4 *addr = db->createIPv4();
+        addr->setName(string("fw:") + names[n]);
+        ostringstream str;
+        str << "192.0.2." << n + 1;
+        addr->setAddress(InetAddr(str.str()));
+        addr->setNetmask(InetAddr("255.255.255.0"));
+        itf->add(addr);
+    }
+}
+
+void PolicyDecisionMapTest::tearDown()
+{
+    delete db;
+}
+
+Policy* PolicyDecisionMapTest::addPolicy(const string &name)
+{
+    Policy *policy = db->createPolicy();
+    policy->setName(name);
+    fw->add(policy);
+    return policy;
+}
+
+/*
+ * addr is "a.b.c.d", "a.b.c.d/len" or "a.b.c.d-e.f.g.h"
+ */
+FWObject* PolicyDecisionMapTest::addAddress(const string &addr)
+{
+    Address *obj;
+    string::size_type n;
+    if ((n = addr.find('-')) != string::npos)
+    {
+        AddressRange *ar = db->createAddressRange();
+        ar->setRangeStart(InetAddr(addr.substr(0, n)));
+        ar->setRangeEnd(InetAddr(addr.substr(n + 1)));
+        obj = ar;
+    } else if ((n = addr.find('/')) != string::npos)
+    {
+        obj = db->createNetwork();
+        obj->setAddress(InetAddr(addr.substr(0, n)));
+        obj->setNetmask(InetAddr(atoi(addr.substr(n + 1).c_str())));
+    } else
+    {
+        obj = db->createIPv4();
+        obj->setAddress(InetAddr(addr));
+    }
+    obj->setName(addr);
+    lib->add(obj);
+    return obj;
+}
+
+FWObject* PolicyDecisionMapTest::addTCP(int first, int last)
+{
+    TCPService *tcp = db->createTCPService();
+    ostringstream str;
+    str << "tcp-" << first << "-" << last;
+    tcp->setName(str.str());
+    tcp->setDstRangeStart(first);
+    tcp->setDstRangeEnd(last);
+    lib->add(tcp);
+    return tcp;
+}
+
+PolicyRule* PolicyDecisionMapTest::addRule(RuleSet *policy,
+                                           PolicyRule::Action action,
+                                           FWObject *src, FWObject *dst,
+                                           FWObject *srv)
+{
+    // appendRuleAtBottom() renumbers all rules every time, too slow
+    // for the large policy. Tests that need rule positions call
+    // renumberRules()
+    PolicyRule *rule = PolicyRule::cast(policy->createRule());
+    policy->add(rule);
+    rule->setAction(action);
+    rule->setDirection(PolicyRule::Both);
+    if (src) rule->getSrc()->addRef(src);
+    if (dst) rule->getDst()->addRef(dst);
+    if (srv) rule->getSrv()->addRef(srv);
+    return rule;
+}
+
+PolicyModel::Packet PolicyDecisionMapTest::packet(const string &src,
+                                                  const string &dst,
+                                                  int proto, int dport)
+{
+    PolicyModel::Packet p;
+    p.value[PolicyModel::SRC] = InetAddrValue(InetAddr(src));
+    p.value[PolicyModel::DST] = InetAddrValue(InetAddr(dst));
+    p.set(PolicyModel::PROTO, proto);
+    p.set(PolicyModel::SRC_PORT, 1024);
+    p.set(PolicyModel::DST_PORT, dport);
+    return p;
+}
+
+/*
+ * compares two rule sets and checks that every reported difference
+ * is real
+ */
+bool PolicyDecisionMapTest::equivalent(RuleSet *a, RuleSet *b)
+{
+    PolicyModel ma(fw);
+    ma.addRuleSet(a);
+    PolicyModel mb(fw);
+    mb.addRuleSet(b);
+
+    vector<PolicyDecisionMap::Difference> diffs;
+    bool res = PolicyDecisionMap::compare(ma, mb, diffs, 5);
+    CPPUNIT_ASSERT(res == diffs.empty());
+    for (vector<PolicyDecisionMap::Difference>::iterator i=diffs.begin();
+         i!=diffs.end(); ++i)
+    {
+        int rule_a, rule_b;
+        CPPUNIT_ASSERT(ma.evaluate(i->packet, &rule_a) == i->decision_a);
+        CPPUNIT_ASSERT(mb.evaluate(i->packet, &rule_b) == i->decision_b);
+        CPPUNIT_ASSERT(rule_a == i->rule_a);
+        CPPUNIT_ASSERT(rule_b == i->rule_b);
+        CPPUNIT_ASSERT(i->decision_a != i->decision_b);
+    }
+    return res;
+}
+
+void PolicyDecisionMapTest::testEvaluate()
+{
+    Policy *policy = addPolicy("policy");
+    addRule(policy, PolicyRule::Deny, addAddress("10.0.0.5"), NULL, NULL);
+    addRule(policy, PolicyRule::Accept, NULL, addAddress("10.1.0.0/24"),
+            addTCP(80));
+    addRule(policy, PolicyRule::Continue, NULL, NULL, NULL);
+    addRule(policy, PolicyRule::Reject, NULL,
+            addAddress("10.1.0.10-10.1.1.10"), addTCP(1000, 2000));
+
+    PolicyModel model(fw);
+    model.addRuleSet(policy);
+    CPPUNIT_ASSERT(model.isExact());
+    CPPUNIT_ASSERT(model.countRules() == 4);
+
+    int rule;
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.5", "10.1.0.1", 6, 80), &rule) ==
+                   PolicyModel::DENY);
+    CPPUNIT_ASSERT(rule == 0);
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.6", "10.1.0.1", 6, 80), &rule) ==
+                   PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(rule == 1);
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.6", "10.1.0.1", 17, 80)) ==
+                   PolicyModel::NO_DECISION);
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.6", "10.1.0.1", 6, 81)) ==
+                   PolicyModel::NO_DECISION);
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.6", "10.1.1.10", 6, 1500), &rule) ==
+                   PolicyModel::REJECT);
+    CPPUNIT_ASSERT(rule == 3);
+    CPPUNIT_ASSERT(model.evaluate(packet("10.0.0.6", "10.1.1.11", 6, 1500), &rule) ==
+                   PolicyModel::NO_DECISION);
+    CPPUNIT_ASSERT(rule == -1);
+
+    // the map covers the whole header space exactly once
+    vector<PolicyDecisionMap::Region> regions;
+    PolicyDecisionMap::build(model, regions);
+    int accept = 0;
+    for (vector<PolicyDecisionMap::Region>::iterator i=regions.begin();
+         i!=regions.end(); ++i)
+        if (i->decision == PolicyModel::ACCEPT) accept++;
+    CPPUNIT_ASSERT(accept >= 1);
+    CPPUNIT_ASSERT(regions.size() < 40);
+}
+
+void PolicyDecisionMapTest::testReorder()
+{
+    FWObject *net1 = addAddress("10.1.0.0/16");
+    FWObject *net2 = addAddress("10.2.0.0/16");
+    FWObject *host = addAddress("10.1.2.3");
+    FWObject *www = addTCP(80);
+    FWObject *ssh = addTCP(22);
+
+    Policy *a = addPolicy("a");
+    addRule(a, PolicyRule::Accept, NULL, net1, www);
+    addRule(a, PolicyRule::Deny, NULL, net2, www);
+    addRule(a, PolicyRule::Accept, NULL, net2, ssh);
+
+    // rules match disjoint packets, order does not matter
+    Policy *b = addPolicy("b");
+    addRule(b, PolicyRule::Accept, NULL, net2, ssh);
+    addRule(b, PolicyRule::Deny, NULL, net2, www);
+    addRule(b, PolicyRule::Accept, NULL, net1, www);
+    CPPUNIT_ASSERT(equivalent(a, b));
+
+    // the host is inside net1, moving the deny rule changes the policy
+    Policy *c = addPolicy("c");
+    addRule(c, PolicyRule::Deny, NULL, host, NULL);
+    addRule(c, PolicyRule::Accept, NULL, net1, www);
+    Policy *d = addPolicy("d");
+    addRule(d, PolicyRule::Accept, NULL, net1, www);
+    addRule(d, PolicyRule::Deny, NULL, host, NULL);
+    CPPUNIT_ASSERT(!equivalent(c, d));
+
+    c->renumberRules();
+    PolicyModel mc(fw);
+    mc.addRuleSet(c);
+    PolicyModel md(fw);
+    md.addRuleSet(d);
+    vector<PolicyDecisionMap::Difference> diffs;
+    CPPUNIT_ASSERT(!PolicyDecisionMap::compare(mc, md, diffs, 1));
+    CPPUNIT_ASSERT(diffs.size() == 1);
+    PolicyModel::Packet &p = diffs[0].packet;
+    CPPUNIT_ASSERT(p.value[PolicyModel::DST] == InetAddrValue(InetAddr("10.1.2.3")));
+    CPPUNIT_ASSERT(p.get(PolicyModel::PROTO) == 6);
+    CPPUNIT_ASSERT(p.get(PolicyModel::DST_PORT) == 80);
+    CPPUNIT_ASSERT(diffs[0].decision_a == PolicyModel::DENY);
+    CPPUNIT_ASSERT(diffs[0].decision_b == PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(diffs[0].rule_a == 0);
+    CPPUNIT_ASSERT(diffs[0].rule_b == 0);
+    CPPUNIT_ASSERT(mc.getRuleLabel(diffs[0].rule_a) == "c rule 0");
+}
+
+void PolicyDecisionMapTest::testShadowedRule()
+{
+    FWObject *net = addAddress("10.1.0.0/16");
+    FWObject *range = addAddress("10.1.5.0-10.1.5.200");
+
+    Policy *a = addPolicy("a");
+    addRule(a, PolicyRule::Accept, NULL, net, addTCP(1, 1024));
+    addRule(a, PolicyRule::Deny, NULL, range, addTCP(22));
+    addRule(a, PolicyRule::Deny, NULL, NULL, NULL);
+
+    Policy *b = addPolicy("b");
+    addRule(b, PolicyRule::Accept, NULL, net, addTCP(1, 1024));
+    addRule(b, PolicyRule::Deny, NULL, NULL, NULL);
+
+    CPPUNIT_ASSERT(equivalent(a, b));
+
+    // last rule is redundant with default policy deny only if the
+    // default is the same; without it the decision falls through
+    Policy *c = addPolicy("c");
+    addRule(c, PolicyRule::Accept, NULL, net, addTCP(1, 1024));
+    CPPUNIT_ASSERT(!equivalent(b, c));
+}
+
+void PolicyDecisionMapTest::testNegation()
+{
+    FWObject *net = addAddress("10.0.0.0/8");
+    FWObject *www = addTCP(80);
+
+    Policy *a = addPolicy("a");
+    PolicyRule *r = addRule(a, PolicyRule::Deny, net, NULL, NULL);
+    r->getSrc()->setNeg(true);
+    addRule(a, PolicyRule::Accept, NULL, NULL, NULL);
+
+    Policy *b = addPolicy("b");
+    addRule(b, PolicyRule::Accept, net, NULL, NULL);
+    addRule(b, PolicyRule::Deny, NULL, NULL, NULL);
+
+    CPPUNIT_ASSERT(equivalent(a, b));
+
+    Policy *c = addPolicy("c");
+    r = addRule(c, PolicyRule::Deny, NULL, NULL, www);
+    r->getSrv()->setNeg(true);
+    addRule(c, PolicyRule::Accept, NULL, NULL, NULL);
+
+    Policy *d = addPolicy("d");
+    addRule(d, PolicyRule::Accept, NULL, NULL, www);
+    addRule(d, PolicyRule::Deny, NULL, NULL, NULL);
+
+    CPPUNIT_ASSERT(equivalent(c, d));
+    CPPUNIT_ASSERT(!equivalent(a, c));
+}
+
+void PolicyDecisionMapTest::testInterfaces()
+{
+    FWObject *eth0 = fw->getFirstByType(Interface::TYPENAME);
+    FWObject *www = addTCP(80);
+
+    PolicyModel model(fw);
+    CPPUNIT_ASSERT(model.countInterfaces() == 3);
+    CPPUNIT_ASSERT(model.getInterfaceIndex("eth0") == 1);
+    CPPUNIT_ASSERT(model.getInterfaceName(3) == "eth2");
+    CPPUNIT_ASSERT(model.getInterfaceName(0) == "-");
+
+    // rule in both directions is the same as two rules, one for each
+    Policy *a = addPolicy("a");
+    PolicyRule *r = addRule(a, PolicyRule::Accept, NULL, NULL, www);
+    r->getItf()->addRef(eth0);
+    r->setDirection(PolicyRule::Both);
+
+    Policy *b = addPolicy("b");
+    r = addRule(b, PolicyRule::Accept, NULL, NULL, www);
+    r->getItf()->addRef(eth0);
+    r->setDirection(PolicyRule::Outbound);
+    r = addRule(b, PolicyRule::Accept, NULL, NULL, www);
+    r->getItf()->addRef(eth0);
+    r->setDirection(PolicyRule::Inbound);
+
+    CPPUNIT_ASSERT(equivalent(a, b));
+
+    // traffic of the firewall itself does not come in through any
+    // interface
+    PolicyModel ma(fw);
+    ma.addRuleSet(a);
+    PolicyModel::Packet p = packet("10.0.0.1", "10.0.0.2", 6, 80);
+    p.set(PolicyModel::OUT_ITF, 2);
+    CPPUNIT_ASSERT(ma.evaluate(p) == PolicyModel::NO_DECISION);
+    p.set(PolicyModel::IN_ITF, 1);
+    CPPUNIT_ASSERT(ma.evaluate(p) == PolicyModel::ACCEPT);
+
+    // negated interface inbound matches other interfaces only
+    Policy *c = addPolicy("c");
+    r = addRule(c, PolicyRule::Deny, NULL, NULL, NULL);
+    r->getItf()->addRef(eth0);
+    r->getItf()->setNeg(true);
+    r->setDirection(PolicyRule::Inbound);
+    PolicyModel mc(fw);
+    mc.addRuleSet(c);
+    p.set(PolicyModel::IN_ITF, 1);
+    CPPUNIT_ASSERT(mc.evaluate(p) == PolicyModel::NO_DECISION);
+    p.set(PolicyModel::IN_ITF, 3);
+    CPPUNIT_ASSERT(mc.evaluate(p) == PolicyModel::DENY);
+    p.set(PolicyModel::IN_ITF, 0);
+    CPPUNIT_ASSERT(mc.evaluate(p) == PolicyModel::NO_DECISION);
+
+    // firewall object matches addresses of all its interfaces
+    Policy *d = addPolicy("d");
+    addRule(d, PolicyRule::Accept, NULL, fw, NULL);
+    PolicyModel md(fw);
+    md.addRuleSet(d);
+    CPPUNIT_ASSERT(md.isExact());
+    CPPUNIT_ASSERT(md.evaluate(packet("10.0.0.1", "192.0.2.3", 6, 80)) ==
+                   PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(md.evaluate(packet("10.0.0.1", "192.0.2.4", 6, 80)) ==
+                   PolicyModel::NO_DECISION);
+}
+
+void PolicyDecisionMapTest::testBranch()
+{
+    FWObject *net = addAddress("10.1.0.0/16");
+    FWObject *host = addAddress("10.1.1.1");
+    FWObject *www = addTCP(80);
+
+    Policy *sub = addPolicy("sub");
+    addRule(sub, PolicyRule::Deny, host, NULL, NULL);
+    addRule(sub, PolicyRule::Accept, NULL, NULL, www);
+
+    Policy *a = addPolicy("a");
+    PolicyRule *r = addRule(a, PolicyRule::Branch, net, NULL, NULL);
+    r->setBranch(sub);
+    addRule(a, PolicyRule::Reject, NULL, NULL, NULL);
+
+    // packets that get no decision in the branch come back
+    Policy *b = addPolicy("b");
+    addRule(b, PolicyRule::Deny, host, NULL, NULL);
+    addRule(b, PolicyRule::Accept, net, NULL, www);
+    addRule(b, PolicyRule::Reject, NULL, NULL, NULL);
+
+    CPPUNIT_ASSERT(equivalent(a, b));
+
+    sub->renumberRules();
+    PolicyModel ma(fw);
+    ma.addRuleSet(a);
+    int rule;
+    CPPUNIT_ASSERT(ma.evaluate(packet("10.1.1.1", "10.9.9.9", 6, 80), &rule) ==
+                   PolicyModel::DENY);
+    CPPUNIT_ASSERT(ma.getRuleLabel(rule) == "sub rule 0");
+    CPPUNIT_ASSERT(ma.evaluate(packet("10.2.1.1", "10.9.9.9", 6, 80)) ==
+                   PolicyModel::REJECT);
+}
+
+void PolicyDecisionMapTest::testWarnings()
+{
+    Policy *a = addPolicy("a");
+    addRule(a, PolicyRule::Accept, addAddress("10.0.0.0/8"), NULL, NULL);
+    PolicyModel ma(fw);
+    ma.addRuleSet(a);
+    CPPUNIT_ASSERT(ma.isExact());
+
+    AddressTable *at = db->createAddressTable();
+    at->setName("table");
+    at->setRunTime(true);
+    lib->add(at);
+    TCPService *syn = db->createTCPService();
+    syn->setName("syn");
+    syn->setTCPFlag(TCPService::SYN, true);
+    syn->setAllTCPFlagMasks();
+    lib->add(syn);
+
+    Policy *b = addPolicy("b");
+    addRule(b, PolicyRule::Accept, at, NULL, NULL);
+    addRule(b, PolicyRule::Accept, NULL, NULL, syn);
+    addRule(b, PolicyRule::Pipe, NULL, NULL, NULL);
+    b->renumberRules();
+    PolicyModel mb(fw);
+    mb.addRuleSet(b);
+    CPPUNIT_ASSERT(!mb.isExact());
+    CPPUNIT_ASSERT(mb.getWarnings().size() == 3);
+    CPPUNIT_ASSERT(mb.getWarnings().front().find("b rule 0: run time") == 0);
+}
+
+/*
+ * Random rules over a small space of addresses and ports so that
+ * they overlap a lot
+ */
+void PolicyDecisionMapTest::randomPolicy(RuleSet *policy, int rules)
+{
+    const char *addrs[] = {
+        "10.0.0.0/8", "10.1.0.0/16", "10.1.1.0/24", "10.1.1.1", "10.2.0.0/15",
+        "10.1.0.100-10.1.2.50", "10.3.3.3", "192.0.2.0/25"
+    };
+    int n_addrs = sizeof(addrs) / sizeof(addrs[0]);
+    PolicyRule::Action actions[] = {
+        PolicyRule::Accept, PolicyRule::Deny, PolicyRule::Reject,
+        PolicyRule::Continue
+    };
+    list<FWObject*> itfs = fw->getByType(Interface::TYPENAME);
+    vector<FWObject*> interfaces(itfs.begin(), itfs.end());
+
+    for (int n=0; n<rules; ++n)
+    {
+        FWObject *src = (rand() % 3 == 0) ? NULL : addAddress(addrs[rand() % n_addrs]);
+        FWObject *dst = (rand() % 3 == 0) ? NULL : addAddress(addrs[rand() % n_addrs]);
+        FWObject *srv = NULL;
+        switch (rand() % 4)
+        {
+        case 0: srv = addTCP(20 + rand() % 10); break;
+        case 1: srv = addTCP(20 + rand() % 10, 25 + rand() % 10); break;
+        case 2:
+        {
+            UDPService *udp = db->createUDPService();
+            udp->setName("udp");
+            udp->setDstRangeStart(20 + rand() % 10);
+            lib->add(udp);
+            srv = udp;
+            break;
+        }
+        default: break;
+        }
+        PolicyRule *rule = addRule(policy, actions[rand() % 4], src, dst, srv);
+        if (src && rand() % 5 == 0) rule->getSrc()->setNeg(true);
+        if (srv && rand() % 5 == 0) rule->getSrv()->setNeg(true);
+        if (rand() % 3 == 0)
+        {
+            rule->getItf()->addRef(interfaces[rand() % interfaces.size()]);
+            rule->setDirection((rand() % 2) ? PolicyRule::Inbound :
+                               PolicyRule::Both);
+        }
+    }
+}
+
+/*
+ * Check decision map and comparison against linear evaluation of
+ * random packets
+ */
+void PolicyDecisionMapTest::testRandomPolicies()
+{
+    const char *addrs[] = {
+        "10.0.0.1", "10.1.0.1", "10.1.1.1", "10.1.1.2", "10.1.0.100",
+        "10.1.2.50", "10.1.2.51", "10.3.3.3", "10.2.0.1", "10.3.255.255",
+        "192.0.2.1", "192.0.2.200", "172.16.0.1"
+    };
+    int n_addrs = sizeof(addrs) / sizeof(addrs[0]);
+
+    srand(1);
+    for (int iter=0; iter<20; ++iter)
+    {
+        Policy *a = addPolicy("a");
+        randomPolicy(a, 20);
+        PolicyModel ma(fw);
+        ma.addRuleSet(a);
+
+        vector<PolicyDecisionMap::Region> regions;
+        PolicyDecisionMap::build(ma, regions);
+
+        // swap two random neighbour rules
+        a->renumberRules();
+        Policy *b = addPolicy("b");
+        b->duplicate(a);
+        b->moveRuleDown(rand() % 19);
+
+        PolicyModel mb(fw);
+        mb.addRuleSet(b);
+        bool equal = equivalent(a, b);
+
+        int mismatch = 0;
+        for (int k=0; k<2000; ++k)
+        {
+            PolicyModel::Packet p = packet(addrs[rand() % n_addrs],
+                                           addrs[rand() % n_addrs],
+                                           (rand() % 2) ? 6 : 17,
+                                           18 + rand() % 20);
+            p.set(PolicyModel::IN_ITF, rand() % 4);
+            p.set(PolicyModel::OUT_ITF, rand() % 4);
+
+            int rule;
+            PolicyModel::Decision d = ma.evaluate(p, &rule);
+            int found = 0;
+            for (vector<PolicyDecisionMap::Region>::iterator i=regions.begin();
+                 i!=regions.end(); ++i)
+            {
+                bool inside = true;
+                for (int f=0; f<PolicyModel::DIMENSIONS && inside; ++f)
+                    inside = i->field[f].contains(p.value[f]);
+                if (!inside) continue;
+                found++;
+                CPPUNIT_ASSERT(i->decision == d);
+                CPPUNIT_ASSERT(i->rule == rule);
+            }
+            CPPUNIT_ASSERT(found == 1);
+
+            if (mb.evaluate(p) != d) mismatch++;
+        }
+        // sampling can miss a difference but can not find one the
+        // map does not see
+        if (equal) CPPUNIT_ASSERT(mismatch == 0);
+
+        fw->remove(a);
+        fw->remove(b);
+    }
+}
+
+/*
+ * 10000 rules for different hosts and ports
+ */
+void PolicyDecisionMapTest::testLargePolicy()
+{
+    Policy *a = addPolicy("a");
+    Policy *b = addPolicy("b");
+    vector<FWObject*> hosts;
+    vector<FWObject*> services;
+    for (int n=0; n<10000; ++n)
+    {
+        ostringstream str;
+        str << "10." << n / 256 << "." << n % 256 << ".1";
+        hosts.push_back(addAddress(str.str()));
+        services.push_back(addTCP(1 + n % 1000));
+    }
+    for (int n=0; n<10000; ++n)
+        addRule(a, (n % 2) ? PolicyRule::Accept : PolicyRule::Deny,
+                NULL, hosts[n], services[n]);
+    for (int n=9999; n>=0; --n)
+        addRule(b, (n % 2) ? PolicyRule::Accept : PolicyRule::Deny,
+                NULL, hosts[n], services[n]);
+    addRule(a, PolicyRule::Deny, NULL, NULL, NULL);
+    addRule(b, PolicyRule::Deny, NULL, NULL, NULL);
+    b->renumberRules();
+
+    PolicyModel ma(fw);
+    ma.addRuleSet(a);
+    PolicyModel mb(fw);
+    mb.addRuleSet(b);
+
+    vector<PolicyDecisionMap::Difference> diffs;
+    CPPUNIT_ASSERT(PolicyDecisionMap::compare(ma, mb, diffs));
+
+    // a broad rule at the top of b shadows half of the accept rules
+    PolicyRule *r = PolicyRule::cast(b->insertRuleAtTop());
+    r->setAction(PolicyRule::Deny);
+    r->getDst()->addRef(addAddress("10.0.0.0/11"));
+    PolicyModel mc(fw);
+    mc.addRuleSet(b);
+    CPPUNIT_ASSERT(!PolicyDecisionMap::compare(ma, mc, diffs, 100));
+    CPPUNIT_ASSERT(diffs.size() == 100);
+    for (vector<PolicyDecisionMap::Difference>::iterator i=diffs.begin();
+         i!=diffs.end(); ++i)
+    {
+        CPPUNIT_ASSERT(i->decision_a == PolicyModel::ACCEPT);
+        CPPUNIT_ASSERT(i->decision_b == PolicyModel::DENY);
+        CPPUNIT_ASSERT(i->rule_b == 0);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef POLICYDECISIONMAPTEST_H
+#define POLICYDECISIONMAPTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+
+#include "fwcompiler/PolicyModel.h"
+
+#include <string>
+
+
+class PolicyDecisionMapTest : public CppUnit::TestFixture
+{
+    libfwbuilder::FWObjectDatabase *db;
+    libfwbuilder::Library *lib;
+    libfwbuilder::Firewall *fw;
+
+    libfwbuilder::Policy* addPolicy(const std::string &name);
+    libfwbuilder::FWObject* addAddress(const std::string &addr);
+    libfwbuilder::FWObject* addTCP(int first, int last=0);
+    libfwbuilder::PolicyRule* addRule(libfwbuilder::RuleSet *policy,
+                                      libfwbuilder::PolicyRule::Action action,
+                                      libfwbuilder::FWObject *src,
+                                      libfwbuilder::FWObject *dst,
+                                      libfwbuilder::FWObject *srv);
+    fwcompiler::PolicyModel::Packet packet(const std::string &src,
+                                           const std::string &dst,
+                                           int proto, int dport);
+    void randomPolicy(libfwbuilder::RuleSet *policy, int rules);
+    bool equivalent(libfwbuilder::RuleSet *a, libfwbuilder::RuleSet *b);
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testEvaluate();
+    void testReorder();
+    void testShadowedRule();
+    void testNegation();
+    void testInterfaces();
+    void testBranch();
+    void testWarnings();
+    void testRandomPolicies();
+    void testLargePolicy();
+
+    CPPUNIT_TEST_SUITE(PolicyDecisionMapTest);
+
+    CPPUNIT_TEST(testEvaluate);
+    CPPUNIT_TEST(testReorder);
+    CPPUNIT_TEST(testShadowedRule);
+    CPPUNIT_TEST(testNegation);
+    CPPUNIT_TEST(testInterfaces);
+    CPPUNIT_TEST(testBranch);
+    CPPUNIT_TEST(testWarnings);
+    CPPUNIT_TEST(testRandomPolicies);
+    CPPUNIT_TEST(testLargePolicy);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // POLICYDECISIONMAPTEST_H
@@ -0,0 +1,176 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "PortRangeSetTest.h"
+
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+using namespace fwcompiler;
+using namespace std;
+
+
+/*
+ * Builds set from a string "p1:p2 p3 ..."
+ */
+PortRangeSet PortRangeSetTest::makeSet(const string &ranges)
+{
+    PortRangeSet s;
+    istringstream str(ranges);
+    string r;
+    while (str >> r)
+    {
+        string::size_type n = r.find(':');
+        int first = atoi(r.substr(0, n).c_str());
+        int last = (n == string::npos) ? first : atoi(r.substr(n + 1).c_str());
+        s.addRange(first, last);
+    }
+    return s;
+}
+
+void PortRangeSetTest::testAddRange()
+{
+    CPPUNIT_ASSERT(makeSet("").empty());
+    CPPUNIT_ASSERT(makeSet("80").toString() == "80");
+    CPPUNIT_ASSERT(makeSet("443 80 22").toString() == "22,80,443");
+
+    // adjacent ports and ranges merge
+    CPPUNIT_ASSERT(makeSet("80 81 82").toString() == "80:82");
+    CPPUNIT_ASSERT(makeSet("1000:1999 2000:2999").toString() == "1000:2999");
+    CPPUNIT_ASSERT(makeSet("2000:2999 1999").toString() == "1999:2999");
+
+    // overlapping ranges merge
+    CPPUNIT_ASSERT(makeSet("1000:2000 1500:2500").toString() == "1000:2500");
+    CPPUNIT_ASSERT(makeSet("10:20 30:40 15:35").toString() == "10:40");
+    CPPUNIT_ASSERT(makeSet("10:20 30:40 50:60 1:100").toString() == "1:100");
+    CPPUNIT_ASSERT(makeSet("10:20 25 30:40").toString() == "10:20,25,30:40");
+
+    // clipping and empty ranges
+    CPPUNIT_ASSERT(makeSet("65000:70000").toString() == "65000:65535");
+    PortRangeSet s;
+    s.addRange(20, 10);
+    CPPUNIT_ASSERT(s.empty());
+
+    CPPUNIT_ASSERT(makeSet("10:20 25").countPorts() == 12);
+    CPPUNIT_ASSERT(makeSet("10:20 25").cost() == 3);
+    CPPUNIT_ASSERT(makeSet("25 10:20") == makeSet("10:19 20 25"));
+}
+
+void PortRangeSetTest::testContains()
+{
+    PortRangeSet s = makeSet("22 80:89 443 8000:8080");
+    CPPUNIT_ASSERT(s.contains(22));
+    CPPUNIT_ASSERT(!s.contains(21));
+    CPPUNIT_ASSERT(!s.contains(23));
+    CPPUNIT_ASSERT(s.contains(80));
+    CPPUNIT_ASSERT(s.contains(85));
+    CPPUNIT_ASSERT(s.contains(89));
+    CPPUNIT_ASSERT(!s.contains(90));
+    CPPUNIT_ASSERT(s.contains(8080));
+    CPPUNIT_ASSERT(!s.contains(8081));
+    CPPUNIT_ASSERT(!s.contains(0));
+    CPPUNIT_ASSERT(!PortRangeSet().contains(80));
+}
+
+void PortRangeSetTest::testSplit()
+{
+    CPPUNIT_ASSERT(PortRangeSet().split(15).empty());
+
+    // fits into one chunk
+    PortRangeSet s = makeSet("1 3 5 7 9 11 13 15 17 19 21 23 25 27 29");
+    vector<PortRangeSet> res = s.split(15);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res[0] == s);
+
+    // 16 singles need two chunks
+    s.addPort(31);
+    res = s.split(15);
+    CPPUNIT_ASSERT(res.size() == 2);
+    CPPUNIT_ASSERT(res[0].cost() == 15);
+    CPPUNIT_ASSERT(res[1].toString() == "31");
+
+    // no limit
+    CPPUNIT_ASSERT(s.split(0).size() == 1);
+
+    // 8 ranges and 1 single cost 17, but only 7 ranges fit in a chunk
+    s = makeSet("10:11 20:21 30:31 40:41 50:51 60:61 70:71 80:81 90");
+    res = s.split(15);
+    CPPUNIT_ASSERT(res.size() == 2);
+    CPPUNIT_ASSERT(res[0].toString() == "10:11,20:21,30:31,40:41,50:51,60:61,70:71,90");
+    CPPUNIT_ASSERT(res[1].toString() == "80:81");
+
+    // 7 ranges and 15 singles cost 29 and fit in two chunks; filling
+    // chunks in port order would need three
+    s = makeSet("1:2 4:5 7:8 10:11 13:14 16:17 19:20 "
+                "30 32 34 36 38 40 42 44 46 48 50 52 54 56 58");
+    CPPUNIT_ASSERT(s.cost() == 29);
+    res = s.split(15);
+    CPPUNIT_ASSERT(res.size() == 2);
+    CPPUNIT_ASSERT(res[0].cost() == 15);
+    CPPUNIT_ASSERT(res[1].cost() == 14);
+}
+
+/*
+ * split() must not lose or add ports, every chunk must fit and the
+ * number of chunks must be the smallest possible
+ */
+void PortRangeSetTest::testRandomSplit()
+{
+    srand(1);
+    for (int iter=0; iter<500; ++iter)
+    {
+        PortRangeSet s;
+        int n = rand() % 60;
+        for (int i=0; i<n; ++i)
+        {
+            int first = rand() % 2000;
+            int len = (rand() % 3 == 0) ? rand() % 10 : 0;
+            s.addRange(first, first + len);
+        }
+
+        int max_cost = 2 + rand() % 20;
+        vector<PortRangeSet> res = s.split(max_cost);
+
+        PortRangeSet check;
+        int n_multi = 0;
+        for (vector<PortRangeSet>::iterator i=res.begin(); i!=res.end(); ++i)
+        {
+            CPPUNIT_ASSERT(!i->empty());
+            CPPUNIT_ASSERT(i->cost() <= max_cost);
+            const vector<PortRangeSet::Range> &r = i->getRanges();
+            for (vector<PortRangeSet::Range>::const_iterator j=r.begin();
+                 j!=r.end(); ++j)
+            {
+                check.addRange(j->first, j->second);
+                if (j->first != j->second) n_multi++;
+            }
+        }
+        CPPUNIT_ASSERT(check == s);
+
+        int lower_bound = max((n_multi + max_cost/2 - 1) / (max_cost/2),
+                              (s.cost() + max_cost - 1) / max_cost);
+        CPPUNIT_ASSERT(int(res.size()) == lower_bound);
+    }
+}
@@ -0,0 +1,207 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "RouteAggregatorTest.h"
+
+#include <stdlib.h>
+
+#include <sstream>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+void RouteAggregatorTest::setUp()
+{
+    original.clear();
+    aggregator = new RouteAggregator();
+}
+
+void RouteAggregatorTest::tearDown()
+{
+    delete aggregator;
+}
+
+void RouteAggregatorTest::addRoute(const string &addr, int length,
+                                   int nexthop, bool pinned)
+{
+    InetAddr a((addr.find(':') != string::npos) ? AF_INET6 : AF_INET, addr);
+    aggregator->addRoute(a, length, nexthop, pinned);
+    original.push_back(RouteAggregator::Route(a, length, nexthop));
+}
+
+/*
+ * Returns aggregated routes as a string "addr/len:nexthop addr/len:nexthop ..."
+ * Also checks that every original route is replaced by some route and
+ * that the result passes verification.
+ */
+string RouteAggregatorTest::aggregate(vector<RouteAggregator::Route> &res,
+                                      vector<int> &replaced_by)
+{
+    aggregator->aggregate(res, replaced_by);
+
+    CPPUNIT_ASSERT(replaced_by.size() == original.size());
+    for (unsigned int i=0; i<replaced_by.size(); ++i)
+    {
+        CPPUNIT_ASSERT(replaced_by[i] >= 0 && replaced_by[i] < int(res.size()));
+        CPPUNIT_ASSERT(res[replaced_by[i]].nexthop == original[i].nexthop);
+    }
+
+    string err;
+    CPPUNIT_ASSERT_MESSAGE(err, RouteAggregator::verify(original, res, 1000, 1, err));
+
+    ostringstream str;
+    for (vector<RouteAggregator::Route>::iterator it=res.begin(); it!=res.end(); ++it)
+    {
+        if (it!=res.begin()) str << " ";
+        str << it->address.toString() << "/" << it->length << ":" << it->nexthop;
+    }
+    return str.str();
+}
+
+void RouteAggregatorTest::testSiblings()
+{
+    addRoute("10.0.0.0", 24, 1);
+    addRoute("10.0.1.0", 24, 1);
+    addRoute("10.0.2.0", 24, 1);
+    addRoute("10.0.3.0", 24, 1);
+    addRoute("10.0.5.0", 24, 1);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    CPPUNIT_ASSERT_EQUAL(string("10.0.0.0/22:1 10.0.5.0/24:1"), s);
+    CPPUNIT_ASSERT(replaced_by[0] == 0 && replaced_by[3] == 0);
+    CPPUNIT_ASSERT(replaced_by[4] == 1);
+}
+
+void RouteAggregatorTest::testContained()
+{
+    addRoute("192.168.1.0", 24, 1);
+    addRoute("192.168.0.0", 16, 1);
+    addRoute("192.168.2.0", 24, 2);
+    addRoute("192.168.2.128", 25, 1);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    // 192.168.2.128/25 is inside of 192.168.2.0/24 that goes via
+    // different next hop and must stay
+    CPPUNIT_ASSERT_EQUAL(
+        string("192.168.0.0/16:1 192.168.2.0/24:2 192.168.2.128/25:1"), s);
+}
+
+void RouteAggregatorTest::testDifferentNextHops()
+{
+    addRoute("10.1.0.0", 24, 1);
+    addRoute("10.1.1.0", 24, 2);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    CPPUNIT_ASSERT_EQUAL(string("10.1.0.0/24:1 10.1.1.0/24:2"), s);
+}
+
+void RouteAggregatorTest::testMultipath()
+{
+    addRoute("10.2.0.0", 24, 1);
+    addRoute("10.2.0.0", 24, 2);
+    addRoute("10.2.1.0", 24, 1);
+    addRoute("10.2.0.0", 25, 1);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    // multipath route is never merged and does not absorb routes inside
+    CPPUNIT_ASSERT_EQUAL(
+        string("10.2.0.0/24:1 10.2.0.0/24:2 10.2.0.0/25:1 10.2.1.0/24:1"), s);
+}
+
+void RouteAggregatorTest::testDefaultRoute()
+{
+    addRoute("0.0.0.0", 0, 1, true);
+    addRoute("0.0.0.0", 1, 1);
+    addRoute("128.0.0.0", 1, 1);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    // pinned default route does not absorb other routes, and two
+    // halves of the address space are not merged into default route
+    CPPUNIT_ASSERT_EQUAL(string("0.0.0.0/0:1 0.0.0.0/1:1 128.0.0.0/1:1"), s);
+}
+
+void RouteAggregatorTest::testIPv6()
+{
+    addRoute("2001:db8::", 64, 1);
+    addRoute("2001:db8:0:1::", 64, 1);
+    addRoute("10.0.0.0", 24, 1);
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    string s = aggregate(res, replaced_by);
+    CPPUNIT_ASSERT_EQUAL(string("10.0.0.0/24:1 2001:db8::/63:1"), s);
+}
+
+void RouteAggregatorTest::testRandomRoutes()
+{
+    srand(1);
+    for (int i=0; i<2000; ++i)
+    {
+        ostringstream addr;
+        addr << "10." << rand() % 4 << "." << rand() % 256 << "."
+             << rand() % 256;
+        int length = 16 + rand() % 17;
+        InetAddr a(addr.str());
+        InetAddr masked = a & InetAddr(length);
+        addRoute(masked.toString(), length, rand() % 3);
+    }
+
+    vector<RouteAggregator::Route> res;
+    vector<int> replaced_by;
+    aggregate(res, replaced_by);
+    CPPUNIT_ASSERT(res.size() < original.size());
+}
+
+void RouteAggregatorTest::testVerifier()
+{
+    vector<RouteAggregator::Route> routes1;
+    vector<RouteAggregator::Route> routes2;
+
+    routes1.push_back(RouteAggregator::Route(InetAddr("10.0.0.0"), 24, 1));
+    routes1.push_back(RouteAggregator::Route(InetAddr("10.0.1.0"), 24, 1));
+    routes2.push_back(RouteAggregator::Route(InetAddr("10.0.0.0"), 23, 1));
+
+    string err;
+    CPPUNIT_ASSERT(RouteAggregator::verify(routes1, routes2, 100, 1, err));
+
+    // 10.0.0.0/22 covers more addresses than the original routes
+    routes2.clear();
+    routes2.push_back(RouteAggregator::Route(InetAddr("10.0.0.0"), 22, 1));
+    CPPUNIT_ASSERT(!RouteAggregator::verify(routes1, routes2, 100, 1, err));
+    CPPUNIT_ASSERT(!err.empty());
+
+    CPPUNIT_ASSERT(RouteAggregator::lookup(routes1, InetAddr("10.0.1.5")) == 1);
+    CPPUNIT_ASSERT(RouteAggregator::lookup(routes1, InetAddr("10.0.2.5")) == -1);
+}
@@ -0,0 +1,72 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef ROUTEAGGREGATORTEST_H
+#define ROUTEAGGREGATORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwcompiler/RouteAggregator.h"
+
+#include <string>
+#include <vector>
+
+
+class RouteAggregatorTest : public CppUnit::TestFixture
+{
+    std::vector<fwcompiler::RouteAggregator::Route> original;
+    fwcompiler::RouteAggregator *aggregator;
+
+    void addRoute(const std::string &addr, int length, int nexthop,
+                  bool pinned=false);
+    std::string aggregate(std::vector<fwcompiler::RouteAggregator::Route> &res,
+                          std::vector<int> &replaced_by);
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testSiblings();
+    void testContained();
+    void testDifferentNextHops();
+    void testMultipath();
+    void testDefaultRoute();
+    void testIPv6();
+    void testRandomRoutes();
+    void testVerifier();
+
+    CPPUNIT_TEST_SUITE(RouteAggregatorTest);
+
+    CPPUNIT_TEST(testSiblings);
+    CPPUNIT_TEST(testContained);
+    CPPUNIT_TEST(testDifferentNextHops);
+    CPPUNIT_TEST(testMultipath);
+    CPPUNIT_TEST(testDefaultRoute);
+    CPPUNIT_TEST(testIPv6);
+    CPPUNIT_TEST(testRandomRoutes);
+    CPPUNIT_TEST(testVerifier);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // ROUTEAGGREGATORTEST_H
@@ -0,0 +1,227 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "RuleAnnotationTest.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleAnnotation.h"
+
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+static const RuleAnnotationKey test_chain("test_chain",
+                                          RuleAnnotationKey::String);
+static const RuleAnnotationKey test_target("test_target",
+                                           RuleAnnotationKey::String);
+static const RuleAnnotationKey test_flag("test_flag", RuleAnnotationKey::Bool);
+static const RuleAnnotationKey test_counter("test_counter",
+                                            RuleAnnotationKey::Int);
+static const RuleAnnotationKey test_pointer("test_pointer",
+                                            RuleAnnotationKey::Pointer);
+
+void RuleAnnotationTest::testDefaults()
+{
+    FWObjectDatabase db;
+    PolicyRule *rule = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+
+    CPPUNIT_ASSERT(rule->getStr(test_chain) == "");
+    CPPUNIT_ASSERT(rule->getBool(test_flag) == false);
+    CPPUNIT_ASSERT(rule->getInt(test_counter) == 0);
+    CPPUNIT_ASSERT(rule->getPtr(test_pointer) == NULL);
+    CPPUNIT_ASSERT(rule->getAnnotations().toString() == "");
+}
+
+void RuleAnnotationTest::testSetGet()
+{
+    FWObjectDatabase db;
+    PolicyRule *rule = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+
+    rule->setStr(test_chain, "INPUT");
+    rule->setStr(test_target, "ACCEPT");
+    rule->setBool(test_flag, true);
+    rule->setInt(test_counter, 42);
+    rule->setPtr(test_pointer, &db);
+
+    CPPUNIT_ASSERT(rule->getStr(test_chain) == "INPUT");
+    CPPUNIT_ASSERT(rule->getStr(test_target) == "ACCEPT");
+    CPPUNIT_ASSERT(rule->getBool(test_flag) == true);
+    CPPUNIT_ASSERT(rule->getInt(test_counter) == 42);
+    CPPUNIT_ASSERT(rule->getPtr(test_pointer) == &db);
+
+    // annotations do not show up among attributes and the other way
+    // around
+    CPPUNIT_ASSERT(!rule->exists("test_chain"));
+    rule->setStr("test_chain", "OUTPUT");
+    CPPUNIT_ASSERT(rule->getStr("test_chain") == "OUTPUT");
+    CPPUNIT_ASSERT(rule->getStr(test_chain) == "INPUT");
+
+    string str = rule->getAnnotations().toString();
+    CPPUNIT_ASSERT(str.find("test_flag=True ") != string::npos);
+    CPPUNIT_ASSERT(str.find("test_counter=42 ") != string::npos);
+    CPPUNIT_ASSERT(str.find("test_chain=INPUT ") != string::npos);
+    CPPUNIT_ASSERT(str.find("test_target=ACCEPT ") != string::npos);
+
+    rule->setBool(test_flag, false);
+    CPPUNIT_ASSERT(rule->getBool(test_flag) == false);
+
+    // value of one annotation copied to another one that has not been
+    // set yet, the storage grows while the value is read from it
+    PolicyRule *rule2 = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+    rule2->setStr(test_chain, "a chain name longer than short string buffer");
+    rule2->setStr(test_target, rule2->getStr(test_chain));
+    CPPUNIT_ASSERT(rule2->getStr(test_target) ==
+                   "a chain name longer than short string buffer");
+}
+
+void RuleAnnotationTest::testRegistry()
+{
+    CPPUNIT_ASSERT(RuleAnnotationKey::find("test_chain") == &test_chain);
+    CPPUNIT_ASSERT(RuleAnnotationKey::find("test_flag") == &test_flag);
+    CPPUNIT_ASSERT(RuleAnnotationKey::find("no_such_annotation") == NULL);
+
+    CPPUNIT_ASSERT(test_chain.getType() == RuleAnnotationKey::String);
+    CPPUNIT_ASSERT(test_chain.getSlot() != test_target.getSlot());
+    // Bool and Int keys share storage and must not share slots
+    CPPUNIT_ASSERT(test_flag.getSlot() != test_counter.getSlot());
+}
+
+void RuleAnnotationTest::testDuplicate()
+{
+    FWObjectDatabase db;
+    PolicyRule *rule1 = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+    PolicyRule *rule2 = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+
+    rule1->setStr(test_chain, "INPUT");
+    rule1->setBool(test_flag, true);
+
+    rule2->duplicate(rule1);
+    CPPUNIT_ASSERT(rule2->getStr(test_chain) == "INPUT");
+    CPPUNIT_ASSERT(rule2->getBool(test_flag) == true);
+    CPPUNIT_ASSERT(rule1->cmp(rule2));
+
+    rule2->setStr(test_chain, "OUTPUT");
+    CPPUNIT_ASSERT(!rule1->cmp(rule2));
+
+    // annotation that has been set to its default value is the same
+    // as annotation that has never been set
+    rule2->setStr(test_chain, "INPUT");
+    rule2->setInt(test_counter, 0);
+    CPPUNIT_ASSERT(rule1->cmp(rule2));
+}
+
+/*
+ * Emulates rule processors that pass chain, target and a flag to each
+ * other: every pass reads them and sets target, then the same is done
+ * while copying every rule, as most rule processors do. Prints time
+ * it takes when these are kept in string attributes and in
+ * annotations.
+ */
+void RuleAnnotationTest::testPerformance()
+{
+    const int num_rules = 2000;
+    const int passes = 20;
+    const char *chains[] = { "INPUT", "OUTPUT", "FORWARD" };
+
+    clock_t access_times[2];
+    clock_t copy_times[2];
+    for (int use_annotations=0; use_annotations<2; ++use_annotations)
+    {
+        FWObjectDatabase db;
+        Policy *policy = Policy::cast(db.create(Policy::TYPENAME));
+        db.add(policy);
+
+        vector<PolicyRule*> rules;
+        for (int i=0; i<num_rules; ++i)
+        {
+            PolicyRule *rule = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+            policy->add(rule);
+            if (use_annotations)
+            {
+                rule->setStr(test_chain, chains[i % 3]);
+                rule->setBool(test_flag, i % 2);
+            } else
+            {
+                rule->setStr("test_chain", chains[i % 3]);
+                rule->setBool("test_flag", i % 2);
+            }
+            rules.push_back(rule);
+        }
+
+        for (int copy=0; copy<2; ++copy)
+        {
+            int n = 0;
+            clock_t start = clock();
+            for (int pass=0; pass<passes; ++pass)
+            {
+                const char *target = (pass % 2) ? "ACCEPT" : "DROP";
+                for (int i=0; i<num_rules; ++i)
+                {
+                    PolicyRule *rule = rules[i];
+                    PolicyRule *r = rule;
+                    if (copy)
+                    {
+                        r = PolicyRule::cast(db.create(PolicyRule::TYPENAME));
+                        r->duplicate(rule);
+                    }
+                    if (use_annotations)
+                    {
+                        if (r->getStr(test_chain) == "INPUT" &&
+                            r->getBool(test_flag)) n++;
+                        r->setStr(test_target, target);
+                        if (r->getStr(test_target) == "ACCEPT") n++;
+                    } else
+                    {
+                        if (r->getStr("test_chain") == "INPUT" &&
+                            r->getBool("test_flag")) n++;
+                        r->setStr("test_target", target);
+                        if (r->getStr("test_target") == "ACCEPT") n++;
+                    }
+                    if (copy) delete r;
+                }
+            }
+            clock_t t = clock() - start;
+            if (copy) copy_times[use_annotations] = t;
+            else access_times[use_annotations] = t;
+            CPPUNIT_ASSERT(n == passes * (num_rules / 6 + num_rules / 2));
+        }
+    }
+
+    cout << endl << num_rules * passes << " rules processed: "
+         << "string attributes "
+         << 1000 * access_times[0] / CLOCKS_PER_SEC << " ms, "
+         << "annotations "
+         << 1000 * access_times[1] / CLOCKS_PER_SEC << " ms; "
+         << "with copying of each rule: string attributes "
+         << 1000 * copy_times[0] / CLOCKS_PER_SEC << " ms, "
+         << "annotations "
+         << 1000 * copy_times[1] / CLOCKS_PER_SEC << " ms"
+         << endl;
+}
@@ -0,0 +1,50 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef RULEANNOTATIONTEST_H
+#define RULEANNOTATIONTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+
+class RuleAnnotationTest : public CppUnit::TestFixture
+{
+public:
+    void testDefaults();
+    void testSetGet();
+    void testRegistry();
+    void testDuplicate();
+    void testPerformance();
+
+    CPPUNIT_TEST_SUITE(RuleAnnotationTest);
+
+    CPPUNIT_TEST(testDefaults);
+    CPPUNIT_TEST(testSetGet);
+    CPPUNIT_TEST(testRegistry);
+    CPPUNIT_TEST(testDuplicate);
+    CPPUNIT_TEST(testPerformance);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // RULEANNOTATIONTEST_H
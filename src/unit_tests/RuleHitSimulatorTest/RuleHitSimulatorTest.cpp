@@ -0,0 +1,578 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "RuleHitSimulatorTest.h"
+
+#include "fwcompiler/PolicyDecisionMap.h"
+#include "fwcompiler/RuleHitSimulator.h"
+
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/InetAddr.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/NAT.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TCPService.h"
+
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace fwcompiler;
+using namespace std;
+
+
+void RuleHitSimulatorTest::setUp()
+{
+    db = new FWObjectDatabase();
+    lib = db->createLibrary();
+    lib->setName("User");
+    db->add(lib);
+    fw = db->createFirewall();
+    fw->setName("fw");
+    lib->add(fw);
+
+    const char *names[] = { "eth0", "eth1" };
+    for (int n=0; n<2; ++n)
+    {
+        Interface *itf = db->createInterface();
+        itf->setName(names[n]);
+        fw->add(itf);
+        IPv4 *addr = db->createIPv4();
+        addr->setName(string("fw:") + names[n]);
+        ostringstream str;
+        str << "192.0.2." << n + 1;
+        addr->setAddress(InetAddr(str.str()));
+        addr->setNetmask(InetAddr("255.255.255.0"));
+        itf->add(addr);
+    }
+}
+
+void RuleHitSimulatorTest::tearDown()
+{
+    delete db;
+}
+
+Policy* RuleHitSimulatorTest::addPolicy(const string &name)
+{
+    Policy *policy = db->createPolicy();
+    policy->setName(name);
+    fw->add(policy);
+    return policy;
+}
+
+/*
+ * addr is "a.b.c.d" or "a.b.c.d/len"
+ */
+FWObject* RuleHitSimulatorTest::addAddress(const string &addr)
+{
+    Address *obj;
+    string::size_type n;
+    if ((n = addr.find('/')) != string::npos)
+    {
+        obj = db->createNetwork();
+        obj->setAddress(InetAddr(addr.substr(0, n)));
+        obj->setNetmask(InetAddr(atoi(addr.substr(n + 1).c_str())));
+    } else
+    {
+        obj = db->createIPv4();
+        obj->setAddress(InetAddr(addr));
+    }
+    obj->setName(addr);
+    lib->add(obj);
+    return obj;
+}
+
+FWObject* RuleHitSimulatorTest::addTCP(int port)
+{
+    TCPService *tcp = db->createTCPService();
+    ostringstream str;
+    str << "tcp-" << port;
+    tcp->setName(str.str());
+    tcp->setDstRangeStart(port);
+    tcp->setDstRangeEnd(port);
+    lib->add(tcp);
+    return tcp;
+}
+
+PolicyRule* RuleHitSimulatorTest::addRule(RuleSet *policy,
+                                          PolicyRule::Action action,
+                                          FWObject *src, FWObject *dst,
+                                          FWObject *srv)
+{
+    PolicyRule *rule = PolicyRule::cast(policy->createRule());
+    policy->add(rule);
+    rule->setAction(action);
+    rule->setDirection(PolicyRule::Both);
+    if (src) rule->getSrc()->addRef(src);
+    if (dst) rule->getDst()->addRef(dst);
+    if (srv) rule->getSrv()->addRef(srv);
+    return rule;
+}
+
+PolicyModel::Packet RuleHitSimulatorTest::packet(const string &src,
+                                                 const string &dst,
+                                                 int dport)
+{
+    PolicyModel::Packet p;
+    p.value[PolicyModel::SRC] = InetAddrValue(InetAddr(src));
+    p.value[PolicyModel::DST] = InetAddrValue(InetAddr(dst));
+    p.set(PolicyModel::PROTO, 6);
+    p.set(PolicyModel::SRC_PORT, 1024);
+    p.set(PolicyModel::DST_PORT, dport);
+    return p;
+}
+
+void RuleHitSimulatorTest::testHits()
+{
+    Policy *policy = addPolicy("policy");
+    addRule(policy, PolicyRule::Deny, addAddress("10.0.0.5"), NULL, NULL);
+    addRule(policy, PolicyRule::Accept, NULL, addAddress("10.1.0.0/24"),
+            addTCP(80));
+    addRule(policy, PolicyRule::Accounting, NULL, NULL, NULL);
+    addRule(policy, PolicyRule::Reject, NULL, NULL, NULL);
+    policy->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    sim.addRuleSet(policy);
+    CPPUNIT_ASSERT(model.isExact());
+    CPPUNIT_ASSERT(sim.countRules() == 4);
+    CPPUNIT_ASSERT(sim.getRuleLabel(1) == "policy rule 1");
+    CPPUNIT_ASSERT(sim.getRuleLabel(-1) == "default");
+
+    vector<PolicyModel::Packet> trace;
+    trace.push_back(packet("10.0.0.5", "10.9.9.9", 22));
+    trace.push_back(packet("10.2.0.1", "10.1.0.7", 80));
+    trace.push_back(packet("10.2.0.1", "10.1.0.8", 80));
+    trace.push_back(packet("10.2.0.1", "10.9.9.9", 80));
+
+    int rule;
+    CPPUNIT_ASSERT(sim.evaluate(trace[1], "policy", &rule) == PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(rule == 1);
+    CPPUNIT_ASSERT(sim.evaluate(trace[3], "policy", &rule) == PolicyModel::REJECT);
+    CPPUNIT_ASSERT(rule == 3);
+    CPPUNIT_ASSERT(sim.getPackets() == 0);
+
+    sim.run(trace, "policy");
+    CPPUNIT_ASSERT(sim.getPackets() == 4);
+    CPPUNIT_ASSERT(sim.getHits(0) == 1);
+    CPPUNIT_ASSERT(sim.getHits(1) == 2);
+    // non-terminating rule counts its hit and lets the packet through
+    CPPUNIT_ASSERT(sim.getHits(2) == 1);
+    CPPUNIT_ASSERT(sim.getHits(3) == 1);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::DENY) == 1);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::ACCEPT) == 2);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::REJECT) == 1);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::NO_DECISION) == 0);
+    // 1 + 2 + 2 + 4 rules evaluated
+    CPPUNIT_ASSERT(sim.getAverageRulesEvaluated() == 9.0 / 4);
+    CPPUNIT_ASSERT(sim.getPacketsPerSecond() >= 0);
+
+    sim.run(trace, "policy");
+    CPPUNIT_ASSERT(sim.getPackets() == 8);
+    CPPUNIT_ASSERT(sim.getHits(1) == 4);
+
+    // unknown chain classifies nothing
+    sim.run(trace, "nat");
+    CPPUNIT_ASSERT(sim.getPackets() == 8);
+
+    sim.reset();
+    CPPUNIT_ASSERT(sim.getPackets() == 0);
+    CPPUNIT_ASSERT(sim.getHits(1) == 0);
+    CPPUNIT_ASSERT(sim.getAverageRulesEvaluated() == 0);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::ACCEPT) == 0);
+}
+
+void RuleHitSimulatorTest::testDeadAndHotRules()
+{
+    Policy *policy = addPolicy("policy");
+    addRule(policy, PolicyRule::Accept, NULL, addAddress("10.1.0.0/16"), NULL);
+    // shadowed by the rule above
+    addRule(policy, PolicyRule::Deny, NULL, addAddress("10.1.1.0/24"), NULL);
+    addRule(policy, PolicyRule::Accept, NULL, NULL, addTCP(22));
+    addRule(policy, PolicyRule::Deny, NULL, NULL, NULL);
+    policy->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    sim.addRuleSet(policy);
+
+    vector<PolicyModel::Packet> trace;
+    for (int n=0; n<5; ++n) trace.push_back(packet("10.2.0.1", "10.1.1.1", 80));
+    for (int n=0; n<2; ++n) trace.push_back(packet("10.2.0.1", "10.5.0.1", 22));
+    trace.push_back(packet("10.2.0.1", "10.5.0.1", 80));
+    sim.run(trace, "policy");
+
+    vector<int> dead = sim.getDeadRules();
+    CPPUNIT_ASSERT(dead.size() == 1);
+    CPPUNIT_ASSERT(dead[0] == 1);
+
+    vector<int> hot = sim.getHotRules(2);
+    CPPUNIT_ASSERT(hot.size() == 2);
+    CPPUNIT_ASSERT(hot[0] == 0);
+    CPPUNIT_ASSERT(hot[1] == 2);
+    CPPUNIT_ASSERT(sim.getHotRules(10).size() == 3);
+
+    string report = sim.toString();
+    CPPUNIT_ASSERT(report.find("packets: 8\n") != string::npos);
+    CPPUNIT_ASSERT(report.find("policy rule 0: 5\n") != string::npos);
+    CPPUNIT_ASSERT(report.find("policy rule 1: 0 (dead)\n") != string::npos);
+}
+
+/*
+ * The same rules laid out flat and behind a jump to a chain give the
+ * same decisions, the chain layout evaluates fewer rules per packet
+ */
+void RuleHitSimulatorTest::testChains()
+{
+    Policy *policy = addPolicy("rules");
+    FWObject *www = addTCP(80);
+    vector<Rule*> accept;
+    for (int n=0; n<20; ++n)
+    {
+        ostringstream str;
+        str << "10.1." << n << ".0/24";
+        accept.push_back(
+            addRule(policy, PolicyRule::Accept, NULL, addAddress(str.str()), www));
+    }
+    Rule *jump = addRule(policy, PolicyRule::Continue, NULL,
+                         addAddress("10.1.0.0/16"), NULL);
+    Rule *deny = addRule(policy, PolicyRule::Deny, NULL, NULL, NULL);
+    policy->renumberRules();
+
+    PolicyModel model(fw);
+
+    RuleHitSimulator flat(model);
+    for (unsigned n=0; n<accept.size(); ++n) flat.addRule("INPUT", accept[n]);
+    flat.addRule("INPUT", deny);
+
+    RuleHitSimulator chained(model);
+    int j = chained.addRule("INPUT", jump, "net");
+    chained.addRule("INPUT", deny);
+    for (unsigned n=0; n<accept.size(); ++n) chained.addRule("net", accept[n]);
+    CPPUNIT_ASSERT(chained.getChains().size() == 2);
+    CPPUNIT_ASSERT(chained.getRuleLabel(j) == "INPUT rule 20");
+
+    vector<PolicyModel::Packet> trace;
+    for (int n=0; n<20; ++n)
+    {
+        ostringstream str;
+        str << "10.1." << n << ".5";
+        trace.push_back(packet("10.2.0.1", str.str(), 80));
+    }
+    for (int n=0; n<80; ++n)
+    {
+        ostringstream str;
+        str << "10.9.0." << n + 1;
+        trace.push_back(packet("10.2.0.1", str.str(), 80));
+    }
+    // the jump does not decide, packets come back if the chain has
+    // no matching rule
+    trace.push_back(packet("10.2.0.1", "10.1.0.5", 443));
+
+    for (unsigned n=0; n<trace.size(); ++n)
+        CPPUNIT_ASSERT(flat.evaluate(trace[n], "INPUT") ==
+                       chained.evaluate(trace[n], "INPUT"));
+
+    flat.run(trace, "INPUT");
+    chained.run(trace, "INPUT");
+    CPPUNIT_ASSERT(flat.getDecisionCount(PolicyModel::ACCEPT) == 20);
+    CPPUNIT_ASSERT(chained.getDecisionCount(PolicyModel::ACCEPT) == 20);
+    CPPUNIT_ASSERT(chained.getDecisionCount(PolicyModel::DENY) == 81);
+    CPPUNIT_ASSERT(chained.getHits(j) == 21);
+    CPPUNIT_ASSERT(chained.getAverageRulesEvaluated() <
+                   flat.getAverageRulesEvaluated() / 4);
+}
+
+void RuleHitSimulatorTest::testBranchRuleSet()
+{
+    Policy *sub = addPolicy("sub");
+    addRule(sub, PolicyRule::Return, addAddress("10.1.1.1"), NULL, NULL);
+    addRule(sub, PolicyRule::Accept, NULL, NULL, addTCP(80));
+    // branch back to itself must not load the rule set twice or
+    // classify forever
+    PolicyRule *loop = addRule(sub, PolicyRule::Branch, NULL, NULL, addTCP(443));
+    loop->setBranch(sub);
+    sub->renumberRules();
+
+    Policy *a = addPolicy("a");
+    PolicyRule *r = addRule(a, PolicyRule::Branch, addAddress("10.1.0.0/16"),
+                            NULL, NULL);
+    r->setBranch(sub);
+    addRule(a, PolicyRule::Reject, NULL, NULL, NULL);
+    a->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    CPPUNIT_ASSERT(sim.addRuleSet(a) == 0);
+    CPPUNIT_ASSERT(sim.getChains().size() == 2);
+    CPPUNIT_ASSERT(sim.countRules() == 5);
+
+    int rule;
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.1.2.2", "10.9.9.9", 80), "a", &rule) ==
+                   PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(sim.getRuleLabel(rule) == "sub rule 1");
+    // Return sends the packet back to the next rule of a
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.1.1.1", "10.9.9.9", 80), "a", &rule) ==
+                   PolicyModel::REJECT);
+    CPPUNIT_ASSERT(sim.getRuleLabel(rule) == "a rule 1");
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.2.0.1", "10.9.9.9", 80), "a") ==
+                   PolicyModel::REJECT);
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.1.2.2", "10.9.9.9", 443), "a") ==
+                   PolicyModel::REJECT);
+}
+
+void RuleHitSimulatorTest::testNAT()
+{
+    NAT *nat = NAT::cast(db->createNAT());
+    nat->setName("NAT");
+    fw->add(nat);
+
+    NATRule *r0 = NATRule::cast(nat->createRule());
+    nat->add(r0);
+    r0->getOSrc()->addRef(addAddress("10.0.0.5"));
+    r0->setRuleType(NATRule::NONAT);
+
+    NATRule *r1 = NATRule::cast(nat->createRule());
+    nat->add(r1);
+    r1->getOSrc()->addRef(addAddress("10.0.0.0/24"));
+    r1->getTSrc()->addRef(fw->getFirstByType(Interface::TYPENAME));
+    r1->setRuleType(NATRule::SNAT);
+
+    // rule that has not been classified by the compiler yet
+    NATRule *r2 = NATRule::cast(nat->createRule());
+    nat->add(r2);
+    r2->getODst()->addRef(addAddress("192.0.2.10"));
+    r2->getTDst()->addRef(addAddress("10.0.0.80"));
+    nat->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    sim.addRuleSet(nat);
+    CPPUNIT_ASSERT(model.isExact());
+
+    vector<PolicyModel::Packet> trace;
+    trace.push_back(packet("10.0.0.5", "10.9.9.9", 80));
+    trace.push_back(packet("10.0.0.7", "10.9.9.9", 80));
+    trace.push_back(packet("10.0.0.8", "10.9.9.9", 80));
+    trace.push_back(packet("10.3.0.1", "192.0.2.10", 80));
+    trace.push_back(packet("10.3.0.1", "10.9.9.9", 80));
+    sim.run(trace, "NAT");
+
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::NO_TRANSLATION) == 1);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::TRANSLATE) == 3);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::NO_DECISION) == 1);
+    CPPUNIT_ASSERT(sim.getHits(1) == 2);
+    CPPUNIT_ASSERT(sim.getHits(2) == 1);
+}
+
+void RuleHitSimulatorTest::testTrace()
+{
+    Policy *policy = addPolicy("policy");
+    for (int n=0; n<30; ++n)
+    {
+        ostringstream str;
+        str << "10.1." << n << ".0/24";
+        addRule(policy, PolicyRule::Accept, NULL, addAddress(str.str()),
+                addTCP(1000 + n));
+    }
+    // shadowed by rule 3
+    addRule(policy, PolicyRule::Deny, NULL, addAddress("10.1.3.0/25"),
+            addTCP(1003));
+    addRule(policy, PolicyRule::Deny, NULL, NULL, NULL);
+    policy->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    sim.addRuleSet(policy);
+
+    vector<PolicyModel::Packet> t1, t2, t3;
+    sim.generateTrace(3000, 7, t1, 0.0);
+    sim.generateTrace(3000, 7, t2, 0.0);
+    sim.generateTrace(3000, 8, t3, 0.0);
+    CPPUNIT_ASSERT(t1.size() == 3000);
+    bool same = true;
+    bool same_as_other_seed = true;
+    for (unsigned n=0; n<t1.size(); ++n)
+    {
+        for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+        {
+            same = same && t1[n].value[d] == t2[n].value[d];
+            same_as_other_seed = same_as_other_seed &&
+                t1[n].value[d] == t3[n].value[d];
+        }
+    }
+    CPPUNIT_ASSERT(same);
+    CPPUNIT_ASSERT(!same_as_other_seed);
+
+    sim.run(t1, "policy");
+    vector<int> dead = sim.getDeadRules();
+    CPPUNIT_ASSERT(dead.size() == 1);
+    CPPUNIT_ASSERT(sim.getRuleLabel(dead[0]) == "policy rule 30");
+
+    vector<PolicyModel::Packet> background;
+    sim.generateTrace(1000, 7, background, 1.0);
+    CPPUNIT_ASSERT(background.size() == 1000);
+    for (unsigned n=0; n<background.size(); ++n)
+        for (int d=0; d<PolicyModel::DIMENSIONS; ++d)
+            CPPUNIT_ASSERT(model.getDomain(PolicyModel::Dimension(d)).contains(
+                               background[n].value[d]));
+    sim.reset();
+    sim.run(background, "policy");
+    // random packets almost never match the narrow rules
+    CPPUNIT_ASSERT(sim.getHits(sim.countRules() - 1) > 990);
+}
+
+void RuleHitSimulatorTest::testExplicitDecision()
+{
+    Policy *policy = addPolicy("rules");
+    Rule *r1 = addRule(policy, PolicyRule::Accept, NULL,
+                       addAddress("10.1.0.0/16"), NULL);
+    Rule *r2 = addRule(policy, PolicyRule::Accept, NULL,
+                       addAddress("10.1.1.0/24"), NULL);
+    Rule *r3 = addRule(policy, PolicyRule::Accept, NULL, NULL, NULL);
+    policy->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    CPPUNIT_ASSERT(&sim.getModel() == &model);
+
+    // the way a compiler lays the rules out: r1 jumps to a chain
+    // where r2 returns and r3 denies, actions of the rules are
+    // ignored
+    vector<PolicyModel::Term> terms;
+    model.buildTerms(r1, terms);
+    int j = sim.addRule("INPUT", r1, terms, PolicyModel::ACCEPT, false, "net");
+    terms.clear();
+    model.buildTerms(r2, terms);
+    int ret = sim.addRule("net", r2, terms, PolicyModel::NO_DECISION, true);
+    terms.clear();
+    model.buildTerms(r3, terms);
+    int deny = sim.addRule("net", r3, terms, PolicyModel::DENY, false);
+    CPPUNIT_ASSERT(sim.countRules() == 3);
+
+    int rule;
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.2.0.1", "10.1.2.1", 80),
+                                "INPUT", &rule) == PolicyModel::DENY);
+    CPPUNIT_ASSERT(rule == deny);
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.2.0.1", "10.1.1.1", 80),
+                                "INPUT", &rule) == PolicyModel::NO_DECISION);
+    CPPUNIT_ASSERT(sim.evaluate(packet("10.2.0.1", "10.2.0.2", 80),
+                                "INPUT") == PolicyModel::NO_DECISION);
+
+    vector<PolicyModel::Packet> trace;
+    trace.push_back(packet("10.2.0.1", "10.1.2.1", 80));
+    trace.push_back(packet("10.2.0.1", "10.1.1.1", 80));
+    sim.run(trace, "INPUT");
+    CPPUNIT_ASSERT(sim.getHits(j) == 2);
+    CPPUNIT_ASSERT(sim.getHits(ret) == 1);
+    CPPUNIT_ASSERT(sim.getHits(deny) == 1);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::DENY) == 1);
+}
+
+void RuleHitSimulatorTest::testBuildModel()
+{
+    Policy *sub = addPolicy("sub");
+    addRule(sub, PolicyRule::Return, addAddress("10.1.1.1"), NULL, NULL);
+    addRule(sub, PolicyRule::Accept, NULL, NULL, addTCP(80));
+    PolicyRule *loop = addRule(sub, PolicyRule::Branch, NULL, NULL, addTCP(443));
+    loop->setBranch(sub);
+    addRule(sub, PolicyRule::Deny, NULL, addAddress("10.9.0.0/16"), NULL);
+    sub->renumberRules();
+
+    Policy *a = addPolicy("a");
+    PolicyRule *r = addRule(a, PolicyRule::Branch, addAddress("10.1.0.0/16"),
+                            NULL, NULL);
+    r->setBranch(sub);
+    addRule(a, PolicyRule::Reject, NULL, NULL, addTCP(22));
+    a->renumberRules();
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    sim.addRuleSet(a);
+
+    // flat model decides like the chains
+    PolicyModel flat(fw);
+    sim.buildModel("a", flat);
+    CPPUNIT_ASSERT(flat.countRules() > 0);
+    vector<PolicyModel::Packet> trace;
+    sim.generateTrace(2000, 3, trace, 0.3);
+    trace.push_back(packet("10.1.1.1", "10.9.9.9", 80));
+    trace.push_back(packet("10.1.1.1", "10.9.9.9", 22));
+    trace.push_back(packet("10.1.2.2", "10.9.9.9", 443));
+    for (unsigned n=0; n<trace.size(); ++n)
+        CPPUNIT_ASSERT(flat.evaluate(trace[n]) == sim.evaluate(trace[n], "a"));
+    CPPUNIT_ASSERT(flat.evaluate(packet("10.1.1.1", "10.9.9.9", 80)) ==
+                   PolicyModel::NO_DECISION);
+    CPPUNIT_ASSERT(flat.evaluate(packet("10.1.2.2", "10.9.9.9", 22)) ==
+                   PolicyModel::DENY);
+
+    // the same rules laid out in one chain and with a jump compare
+    // equal, moving the deny rule makes them differ
+    Policy *rules = addPolicy("rules");
+    vector<Rule*> accept;
+    for (int n=0; n<8; ++n)
+    {
+        ostringstream str;
+        str << "10.2." << n << ".0/24";
+        accept.push_back(addRule(rules, PolicyRule::Accept, NULL,
+                                 addAddress(str.str()), addTCP(80)));
+    }
+    Rule *jump = addRule(rules, PolicyRule::Continue, NULL,
+                         addAddress("10.2.0.0/16"), NULL);
+    Rule *deny = addRule(rules, PolicyRule::Deny, NULL, NULL, NULL);
+    rules->renumberRules();
+
+    RuleHitSimulator one(model);
+    for (unsigned n=0; n<accept.size(); ++n) one.addRule("INPUT", accept[n]);
+    one.addRule("INPUT", deny);
+
+    RuleHitSimulator chained(model);
+    chained.addRule("INPUT", jump, "net");
+    chained.addRule("INPUT", deny);
+    for (unsigned n=0; n<accept.size(); ++n) chained.addRule("net", accept[n]);
+
+    RuleHitSimulator broken(model);
+    broken.addRule("INPUT", jump, "net");
+    broken.addRule("INPUT", deny);
+    broken.addRule("net", deny);
+    for (unsigned n=0; n<accept.size(); ++n) broken.addRule("net", accept[n]);
+
+    PolicyModel one_model(fw);
+    PolicyModel chained_model(fw);
+    PolicyModel broken_model(fw);
+    one.buildModel("INPUT", one_model);
+    chained.buildModel("INPUT", chained_model);
+    broken.buildModel("INPUT", broken_model);
+
+    vector<PolicyDecisionMap::Difference> diffs;
+    CPPUNIT_ASSERT(PolicyDecisionMap::compare(one_model, chained_model, diffs));
+    CPPUNIT_ASSERT(diffs.empty());
+    CPPUNIT_ASSERT(!PolicyDecisionMap::compare(one_model, broken_model, diffs));
+    CPPUNIT_ASSERT(!diffs.empty());
+    CPPUNIT_ASSERT(diffs[0].decision_a == PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(diffs[0].decision_b == PolicyModel::DENY);
+}
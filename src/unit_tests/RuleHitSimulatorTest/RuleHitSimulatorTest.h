@@ -0,0 +1,85 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef RULEHITSIMULATORTEST_H
+#define RULEHITSIMULATORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+
+#include "fwcompiler/PolicyModel.h"
+
+#include <string>
+
+
+class RuleHitSimulatorTest : public CppUnit::TestFixture
+{
+    libfwbuilder::FWObjectDatabase *db;
+    libfwbuilder::Library *lib;
+    libfwbuilder::Firewall *fw;
+
+    libfwbuilder::Policy* addPolicy(const std::string &name);
+    libfwbuilder::FWObject* addAddress(const std::string &addr);
+    libfwbuilder::FWObject* addTCP(int port);
+    libfwbuilder::PolicyRule* addRule(libfwbuilder::RuleSet *policy,
+                                      libfwbuilder::PolicyRule::Action action,
+                                      libfwbuilder::FWObject *src,
+                                      libfwbuilder::FWObject *dst,
+                                      libfwbuilder::FWObject *srv);
+    fwcompiler::PolicyModel::Packet packet(const std::string &src,
+                                           const std::string &dst,
+                                           int dport);
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testHits();
+    void testDeadAndHotRules();
+    void testChains();
+    void testBranchRuleSet();
+    void testNAT();
+    void testTrace();
+    void testExplicitDecision();
+    void testBuildModel();
+
+    CPPUNIT_TEST_SUITE(RuleHitSimulatorTest);
+
+    CPPUNIT_TEST(testHits);
+    CPPUNIT_TEST(testDeadAndHotRules);
+    CPPUNIT_TEST(testChains);
+    CPPUNIT_TEST(testBranchRuleSet);
+    CPPUNIT_TEST(testNAT);
+    CPPUNIT_TEST(testTrace);
+    CPPUNIT_TEST(testExplicitDecision);
+    CPPUNIT_TEST(testBuildModel);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // RULEHITSIMULATORTEST_H
@@ -39,6 +39,8 @@
 #include "QMetaProperty"
 #include "FWObjectClipboard.h"
 #include "RuleSetModel.h"
+#include "RuleSetViewDelegate.h"
+#include "RuleNode.h"
 #include "FWBApplication.h"
 
 using namespace std;
@@ -643,3 +645,79 @@ void RuleSetViewTest::test_copy_paste()
     QVERIFY(view->model()->rowCount() == 7);
 
 }
+
+void RuleSetViewTest::test_size_cache()
+{
+    RuleSetModel *md = (RuleSetModel*)view->model();
+    int rows_before = md->rowCount(QModelIndex());
+
+    for (int i=0; i<250; i++) md->insertNewRule();
+    QVERIFY(md->rowCount(QModelIndex()) == rows_before + 250);
+
+    // rows are measured in the background in batches
+    for (int i=0; i<50 && !md->getRowsWithoutSizes(1).isEmpty(); i++)
+        QTest::qWait(100);
+    QVERIFY(md->getRowsWithoutSizes(1000).isEmpty());
+
+    // cached display data and sizes of one row are dropped, the rest
+    // of the rule set keeps them
+    QModelIndex idx = md->index(10, 0, QModelIndex());
+    md->nodeFromIndex(idx)->resetSizes();
+    QList<QModelIndex> rows = md->getRowsWithoutSizes(1000);
+    QVERIFY(rows.size() == 1);
+    QVERIFY(rows.first().row() == 10);
+
+    // row height is known before the row is measured
+    QVERIFY(view->itemDelegate()->sizeHint(QStyleOptionViewItem(), idx).height() ==
+            RuleSetViewDelegate::getItemHeight() + 1);
+
+    view->calculateAllSizes();
+    QVERIFY(md->getRowsWithoutSizes(1000).isEmpty());
+
+    // new rules were inserted at the top
+    md->removeRows(0, 250, QModelIndex());
+    QVERIFY(md->rowCount(QModelIndex()) == rows_before);
+}
+
+void RuleSetViewTest::test_rule_numbers()
+{
+    RuleSetModel *md = (RuleSetModel*)view->model();
+    int rows_before = md->rowCount(QModelIndex());
+
+    for (int i=0; i<5; i++) md->insertNewRule();
+    view->calculateAllSizes();
+
+    Rule *first = md->findRuleForPosition(0);
+    QModelIndex idx = md->index(0, 0, QModelIndex());
+    QVERIFY(md->data(idx, Qt::DisplayRole).toString() == "0");
+
+    // number shown in column 0 must follow the rule when rules are
+    // inserted, moved or removed above it
+    md->insertNewRule();
+    QVERIFY(first->getPosition() == 1);
+    idx = md->index(1, 0, QModelIndex());
+    QVERIFY(md->data(idx, Qt::DisplayRole).toString() == "1");
+
+    md->moveRuleDown(QModelIndex(), 1, 1);
+    QVERIFY(first->getPosition() == 2);
+    idx = md->index(2, 0, QModelIndex());
+    QVERIFY(md->data(idx, Qt::DisplayRole).toString() == "2");
+
+    md->moveRuleUp(QModelIndex(), 2, 2);
+    md->removeRows(0, 1, QModelIndex());
+    QVERIFY(first->getPosition() == 0);
+    idx = md->index(0, 0, QModelIndex());
+    QVERIFY(md->data(idx, Qt::DisplayRole).toString() == "0");
+
+    for (int row=0; row<md->rowCount(QModelIndex()); row++)
+    {
+        idx = md->index(row, 0, QModelIndex());
+        RuleNode *node = md->nodeFromIndex(idx);
+        if (node == NULL || node->type != RuleNode::Rule) continue;
+        QVERIFY(md->data(idx, Qt::DisplayRole).toString() ==
+                QString::number(node->rule->getPosition()));
+    }
+
+    md->removeRows(0, 5, QModelIndex());
+    QVERIFY(md->rowCount(QModelIndex()) == rows_before);
+}
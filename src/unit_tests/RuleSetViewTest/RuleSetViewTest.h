@@ -68,6 +68,8 @@ private slots:
     void test_group();
     void test_move();
     void test_copy_paste();
+    void test_size_cache();
+    void test_rule_numbers();
 
 public slots:
     void actuallyClickMenuItem();
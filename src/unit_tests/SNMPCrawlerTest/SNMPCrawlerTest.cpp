@@ -0,0 +1,222 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+#include "SNMPCrawlerTest.h"
+
+#include "fwbuilder/libfwbuilder-config.h"
+#include "fwbuilder/Logger.h"
+#include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/snmp.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace std;
+
+#ifdef HAVE_LIBSNMP
+
+#define TEST_COMMUNITY "fwbtest"
+#define TEST_SYSNAME   "fwbtest-agent"
+
+/*
+ * Records hosts reported while the crawler runs
+ */
+class RecordingSNMPCrawler : public SNMPCrawler
+{
+public:
+    map<InetAddr, CrawlerFind> reported;
+
+protected:
+    virtual void hostProcessed(const InetAddr &addr, const CrawlerFind &host)
+    {
+        reported[addr] = host;
+    }
+};
+
+static double currentTime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static string findAgent()
+{
+    const char *env = getenv("SNMPD");
+    if (env != NULL) return env;
+
+    const char *dirs[] = { "/usr/sbin", "/usr/local/sbin", "/opt/local/sbin",
+                           NULL };
+    for (int i=0; dirs[i]!=NULL; ++i)
+    {
+        string path = string(dirs[i]) + "/snmpd";
+        if (access(path.c_str(), X_OK) == 0) return path;
+    }
+    return "";
+}
+
+bool SNMPCrawlerTest::startAgent()
+{
+    string agent = findAgent();
+    if (agent.empty())
+    {
+        cerr << "snmpd not found, skipping SNMP crawler test" << endl;
+        return false;
+    }
+
+    ofstream conf(config_file.c_str());
+    conf << "agentAddress udp:127.0.0.1:161" << endl;
+    conf << "rocommunity " << TEST_COMMUNITY << " 127.0.0.1" << endl;
+    conf << "sysName " << TEST_SYSNAME << endl;
+    conf << "sysLocation unit test" << endl;
+    conf << "sysContact root@localhost" << endl;
+    conf.close();
+
+    snmpd_pid = fork();
+    if (snmpd_pid == 0)
+    {
+        execl(agent.c_str(), agent.c_str(), "-f", "-C",
+              "-c", config_file.c_str(), "-Lf", "/dev/null",
+              "udp:127.0.0.1:161", (char*)NULL);
+        _exit(1);
+    }
+    if (snmpd_pid < 0) return false;
+
+    // give the agent time to bind the port; if it could not do that
+    // it exits right away
+    sleep(1);
+    if (waitpid(snmpd_pid, NULL, WNOHANG) != 0)
+    {
+        snmpd_pid = -1;
+        cerr << "could not start " << agent
+             << ", skipping SNMP crawler test" << endl;
+        return false;
+    }
+    return true;
+}
+
+void SNMPCrawlerTest::stopAgent()
+{
+    if (snmpd_pid > 0)
+    {
+        kill(snmpd_pid, SIGTERM);
+        waitpid(snmpd_pid, NULL, 0);
+        snmpd_pid = -1;
+    }
+    unlink(config_file.c_str());
+}
+
+void SNMPCrawlerTest::setUp()
+{
+    snmpd_pid = -1;
+    config_file = "snmpd_test.conf";
+}
+
+void SNMPCrawlerTest::tearDown()
+{
+    stopAgent();
+}
+
+/*
+ * Crawler with a small worker pool finds the agent, reports it while
+ * running and returns the same data at the end.
+ */
+void SNMPCrawlerTest::testCrawl()
+{
+    if (!startAgent()) return;
+
+    InetAddr seed("127.0.0.1");
+    vector<InetAddrMask> include;
+    include.push_back(InetAddrMask(InetAddr("127.0.0.0"),
+                                   InetAddr("255.0.0.0")));
+
+    RecordingSNMPCrawler crawler;
+    crawler.init(seed, TEST_COMMUNITY, false, false, false, 0,
+                 1, 1000000L, 0, 0, &include);
+    crawler.setConcurrency(4, 0);
+
+    NullLogger logger;
+    SyncFlag stop_flag;
+    crawler.run_impl(&logger, &stop_flag);
+
+    CPPUNIT_ASSERT(crawler.reported.count(seed) == 1);
+    CPPUNIT_ASSERT(crawler.reported[seed].have_snmpd);
+    CPPUNIT_ASSERT_EQUAL(string(TEST_SYSNAME), crawler.reported[seed].sysname);
+    CPPUNIT_ASSERT(crawler.reported[seed].interfaces.size() > 0);
+
+    map<InetAddr, CrawlerFind> all = crawler.getAllIPs();
+    CPPUNIT_ASSERT(all.count(seed) == 1);
+    CPPUNIT_ASSERT_EQUAL(string(TEST_SYSNAME), all[seed].sysname);
+}
+
+/*
+ * Requests sent to the agent are spaced by at least the interval set
+ * with setConcurrency(). Querying one host takes many requests, so
+ * the crawl can not finish faster than one interval.
+ */
+void SNMPCrawlerTest::testRequestInterval()
+{
+    if (!startAgent()) return;
+
+    InetAddr seed("127.0.0.1");
+
+    RecordingSNMPCrawler crawler;
+    crawler.init(seed, TEST_COMMUNITY, false, false, false, 0,
+                 1, 1000000L, 0, 0, NULL);
+    crawler.setConcurrency(1, 200);
+
+    NullLogger logger;
+    SyncFlag stop_flag;
+    double start = currentTime();
+    crawler.run_impl(&logger, &stop_flag);
+    double elapsed = currentTime() - start;
+
+    CPPUNIT_ASSERT(crawler.reported.count(seed) == 1);
+    CPPUNIT_ASSERT(crawler.reported[seed].have_snmpd);
+    CPPUNIT_ASSERT(elapsed >= 0.2);
+}
+
+#else
+
+bool SNMPCrawlerTest::startAgent() { return false; }
+void SNMPCrawlerTest::stopAgent() {}
+void SNMPCrawlerTest::setUp() {}
+void SNMPCrawlerTest::tearDown() {}
+
+void SNMPCrawlerTest::testCrawl()
+{
+    cerr << "built without SNMP support, skipping SNMP crawler test" << endl;
+}
+
+void SNMPCrawlerTest::testRequestInterval() {}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+#ifndef SNMPCRAWLERTEST_H
+#define SNMPCRAWLERTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+#include <sys/types.h>
+
+
+/*
+ * Runs the crawler against snmpd started on 127.0.0.1 for the
+ * duration of each test. Tests print a message and pass if snmpd is
+ * not installed or can not be started (it needs to bind port 161).
+ */
+class SNMPCrawlerTest : public CppUnit::TestFixture
+{
+    pid_t snmpd_pid;
+    std::string config_file;
+
+    bool startAgent();
+    void stopAgent();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testCrawl();
+    void testRequestInterval();
+
+    CPPUNIT_TEST_SUITE(SNMPCrawlerTest);
+
+    CPPUNIT_TEST(testCrawl);
+    CPPUNIT_TEST(testRequestInterval);
+
+    CPPUNIT_TEST_SUITE_END();
+};
+
+#endif // SNMPCRAWLERTEST_H
@@ -32,8 +32,14 @@
 
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/FWException.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/Firewall.h"
 #include "fwbuilder/IPService.h"
+#include "fwbuilder/IPv4.h"
 #include "fwbuilder/Constants.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
 
 #include <QApplication>
 #include <QStringList>
@@ -216,3 +222,101 @@ void GeneratedScriptTest::FwCommentTest()
     delete objdb;
 }
 
+/*
+ * Rule elements with many addresses are replaced with ipfw tables.
+ * Rules of the running firewall (set 0) use the same table numbers as
+ * the new rules loaded into set 1, so new addresses go to temporary
+ * tables that are swapped in together with the rule sets. Tables the
+ * running rules use must never be flushed.
+ */
+void GeneratedScriptTest::tablesTest()
+{
+    QFile::remove("ipfw1.fw");
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "ipfw1"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    FWOptions *fwopt = fw->getOptionsObject();
+    fwopt->setBool("ipfw_use_tables", true);
+    fwopt->setInt("ipfw_table_threshold", 4);
+
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    CPPUNIT_ASSERT(policy != NULL);
+
+    QList<FWObject*> hosts;
+    for (int n = 1; n <= 5; ++n)
+    {
+        IPv4 *addr = IPv4::cast(objdb->create(IPv4::TYPENAME));
+        addr->setName(QString("table-host-%1").arg(n).toStdString());
+        addr->setAddress(InetAddr(QString("10.9.0.%1").arg(n).toStdString()));
+        lib->add(addr);
+        hosts.push_back(addr);
+    }
+
+    // both rules use the same set of addresses and share one table,
+    // the third one has too few addresses for a table
+    for (int r = 0; r < 3; ++r)
+    {
+        PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+        rule->setAction(PolicyRule::Accept);
+        rule->setDirection(PolicyRule::Both);
+        int n_hosts = (r < 2) ? 5 : 2;
+        for (int n = 0; n < n_hosts; ++n)
+        {
+            if (r == 0) rule->getDst()->addRef(hosts[n]);
+            else rule->getSrc()->addRef(hosts[n]);
+        }
+    }
+
+    QStringList args;
+    args << "ipfw1";
+    CompilerDriver_ipfw driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipfw initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+
+    QFile file("ipfw1.fw");
+    CPPUNIT_ASSERT(file.open(QIODevice::ReadOnly));
+    QString script = QString::fromUtf8(file.readAll().constData());
+
+    CPPUNIT_ASSERT(script.count("create type addr >/dev/null") == 1);
+    CPPUNIT_ASSERT(script.indexOf("table 2 ") == -1);
+    CPPUNIT_ASSERT(script.count(" add 10.9.0.") == 5);
+    for (int n = 1; n <= 5; ++n)
+        CPPUNIT_ASSERT(script.indexOf(
+            QString("\"$IPFW\" table fwb_new_1 add 10.9.0.%1 || exit 1")
+            .arg(n)) != -1);
+    CPPUNIT_ASSERT(script.count("table(1)") >= 2);
+    // the small rule element is not converted, its addresses appear
+    // in the rules as well as in the table
+    CPPUNIT_ASSERT(script.count("10.9.0.2") >= 2);
+    CPPUNIT_ASSERT(script.count("10.9.0.3") == 1);
+
+    // running rules keep using the old contents until the swap
+    CPPUNIT_ASSERT(script.indexOf("table 1 flush") == -1);
+    CPPUNIT_ASSERT(script.indexOf("table 1 add") == -1);
+
+    int create = script.indexOf("\"$IPFW\" table 1 create type addr");
+    int fill = script.indexOf("\"$IPFW\" table fwb_new_1 create type addr");
+    int first_rule = script.indexOf("table(1)");
+    int table_swap = script.indexOf("\"$IPFW\" table 1 swap fwb_new_1");
+    int destroy = script.lastIndexOf("\"$IPFW\" table fwb_new_1 destroy");
+    int set_swap = script.indexOf("\"$IPFW\" set swap 0 1");
+    CPPUNIT_ASSERT(create != -1 && fill != -1 && first_rule != -1);
+    CPPUNIT_ASSERT(table_swap != -1 && destroy != -1 && set_swap != -1);
+    CPPUNIT_ASSERT(create < fill);
+    CPPUNIT_ASSERT(fill < first_rule);
+    CPPUNIT_ASSERT(first_rule < table_swap);
+    CPPUNIT_ASSERT(table_swap < destroy);
+    CPPUNIT_ASSERT(destroy < set_swap);
+    // tables are swapped right before the rule sets, after the epilog
+    CPPUNIT_ASSERT(script.indexOf("\nepilog_commands\n") < table_swap);
+
+    delete objdb;
+}
@@ -58,6 +58,7 @@ public:
     void ManifestTest_6();
     void ManifestTest_7();
     void FwCommentTest();
+    void tablesTest();
     
     CPPUNIT_TEST_SUITE(GeneratedScriptTest);
 
@@ -80,6 +81,8 @@ public:
 
     CPPUNIT_TEST(FwCommentTest);
 
+    CPPUNIT_TEST(tablesTest);
+
     CPPUNIT_TEST_SUITE_END();
 
 };
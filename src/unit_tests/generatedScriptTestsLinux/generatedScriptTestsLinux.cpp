@@ -29,16 +29,36 @@
 
 #include "CompilerDriver_ipt.h"
 #include "Configlet.h"
+#include "RuleHitSimulator_ipt.h"
 
+#include "fwbuilder/Cluster.h"
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/FWException.h"
 #include "fwbuilder/IPService.h"
 #include "fwbuilder/Constants.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TCPService.h"
+#include "fwbuilder/UDPService.h"
+#include "fwbuilder/FWOptions.h"
+
+#include "fwcompiler/PolicyDecisionMap.h"
+#include "fwcompiler/PolicyModel.h"
+#include "fwcompiler/RuleHitSimulator.h"
 
 #include <QApplication>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QProcess>
+#include <QRegExp>
+#include <QTextStream>
+#include <QMap>
 #include <QStringList>
 #include <QtDebug>
 
@@ -447,6 +467,1031 @@ void GeneratedScriptTest::runTimeAddressTablesWithIpSet2Test()
     delete objdb;
 }
 
+/*
+ * Run shell function reload_address_table from the generated script
+ * with a fake ipset utility that saves whatever it gets on stdin in
+ * "ipset restore" mode, and return the saved restore stream.
+ */
+static QStringList runReloadAddressTable(const QString &functions,
+                                         const QStringList &data_lines)
+{
+    QFile data_file("ipset_restore_test.dat");
+    data_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    QTextStream data_stream(&data_file);
+    foreach(QString line, data_lines) data_stream << line << "\n";
+    data_stream.flush();
+    data_file.close();
+
+    QFile::remove("ipset_restore_test.out");
+
+    QFile harness_file("ipset_restore_test.sh");
+    harness_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    QTextStream harness(&harness_file);
+    harness << "fake_ipset() {\n"
+            << "    case \"$1\" in\n"
+            << "        -exist) test \"$2\" = restore && cat > ipset_restore_test.out ;;\n"
+            << "        list) return 1 ;;\n"
+            << "    esac\n"
+            << "    return 0\n"
+            << "}\n"
+            << "IPSET=fake_ipset\n"
+            << functions << "\n"
+            << "reload_address_table bad_guys ipset_restore_test.dat\n";
+    harness.flush();
+    harness_file.close();
+
+    QProcess::execute("/bin/sh", QStringList() << "ipset_restore_test.sh");
+
+    QStringList res;
+    QFile out("ipset_restore_test.out");
+    if (out.open(QIODevice::ReadOnly))
+    {
+        QTextStream out_stream(&out);
+        while (!out_stream.atEnd())
+        {
+            QString line = out_stream.readLine().trimmed();
+            if (!line.isEmpty()) res.push_back(line);
+        }
+    }
+    return res;
+}
+
+void GeneratedScriptTest::runTimeAddressTablesWithIpSet3Test()
+{
+    QStringList sample_1;
+
+    sample_1 << "reload_address_table \"bad_guys\" \"/etc/fw/bad_guys.dat\" inet";
+    sample_1 << "reload_address_table \"bad_guys_2\" \"/etc/fw/bad_guys.dat\" inet";
+
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "test10", "test10.fw");
+
+    QString res = Configlet::findConfigletInFile("run_time_address_tables", "test10.fw");
+    // legacy iphash/nethash sets must not be used
+    CPPUNIT_ASSERT(res.indexOf("iphash") == -1);
+    CPPUNIT_ASSERT(res.indexOf("$IPSET -N") == -1);
+
+    int n1 = res.indexOf("load_run_time_address_table_files() {");
+    CPPUNIT_ASSERT_MESSAGE("Shell function load_run_time_address_table_files is missing", n1 != -1);
+    int n2 = res.indexOf("}", n1);
+    QString conf = res.mid(n1, n2-n1);
+
+    QStringList cmd_list;
+    foreach(QString line, conf.split("\n"))
+    {
+        if (line.indexOf("reload_address_table ")!=-1)
+            cmd_list.push_back(line.trimmed());
+    }
+    cmd_list.sort();
+    CPPUNIT_ASSERT(sample_1 == cmd_list);
+
+    // address tables must be loaded before rules that use them are added
+    QString skeleton = Configlet::findConfigletInFile("script_skeleton", "test10.fw");
+    n1 = skeleton.indexOf("        load_run_time_address_table_files\n");
+    n2 = skeleton.indexOf("        script_body\n");
+    CPPUNIT_ASSERT(n1 != -1 && n2 != -1 && n1 < n2);
+    CPPUNIT_ASSERT(skeleton.indexOf("load_run_time_address_table_files", n2) == -1);
+
+    QStringList data;
+    data << "# comment"
+         << "; another comment"
+         << ""
+         << "192.0.2.1"
+         << "  198.51.100.0/24"
+         << "203.0.113.7 trailing words are ignored";
+
+    QStringList stream_v4;
+    stream_v4 << "create tmp_fwb_set hash:net family inet maxelem 65536"
+              << "add tmp_fwb_set 192.0.2.1"
+              << "add tmp_fwb_set 198.51.100.0/24"
+              << "add tmp_fwb_set 203.0.113.7"
+              << "create bad_guys hash:net family inet maxelem 65536"
+              << "swap tmp_fwb_set bad_guys"
+              << "destroy tmp_fwb_set";
+
+    QStringList stream = runReloadAddressTable(res, data);
+    CPPUNIT_ASSERT_MESSAGE(stream.join("\n").toStdString(), stream == stream_v4);
+
+    data.clear();
+    data << "2001:db8::1" << "2001:db8:1::/48";
+
+    QStringList stream_v6;
+    stream_v6 << "create tmp_fwb_set hash:net family inet6 maxelem 65536"
+              << "add tmp_fwb_set 2001:db8::1"
+              << "add tmp_fwb_set 2001:db8:1::/48"
+              << "create bad_guys hash:net family inet6 maxelem 65536"
+              << "swap tmp_fwb_set bad_guys"
+              << "destroy tmp_fwb_set";
+
+    stream = runReloadAddressTable(res, data);
+    CPPUNIT_ASSERT_MESSAGE(stream.join("\n").toStdString(), stream == stream_v6);
+
+    delete objdb;
+}
+
+static QString compileAndReadScriptBody(FWObjectDatabase *objdb,
+                                        const QString &fw_name)
+{
+    QFile::remove(fw_name + ".fw");
+
+    QStringList args;
+    args << fw_name;
+
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+
+    return Configlet::findConfigletInFile("script_body_iptables_shell",
+                                          fw_name + ".fw");
+}
+
+void GeneratedScriptTest::groupIpSetTest()
+{
+    QStringList sample;
+
+    sample << "create fwb_r0_s_t hash:net family inet";
+    sample << "flush fwb_r0_s_t";
+    sample << "add fwb_r0_s_t 192.0.2.110";
+    sample << "add fwb_r0_s_t 192.0.2.111";
+    sample << "add fwb_r0_s_t 192.0.2.112";
+    sample << "add fwb_r0_s_t 198.51.100.0/24";
+    sample << "create fwb_r0_s hash:net family inet";
+    sample << "swap fwb_r0_s_t fwb_r0_s";
+    sample << "destroy fwb_r0_s_t";
+
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "test8", "test8.fw");
+
+    QString res = Configlet::findConfigletInFile("group_ipsets", "test8.fw");
+    int n1 = res.indexOf("load_group_ipsets() {");
+    CPPUNIT_ASSERT_MESSAGE("Shell function load_group_ipsets is missing", n1 != -1);
+
+    QStringList cmd_list;
+    foreach(QString line, res.split("\n"))
+    {
+        if (line.startsWith("create ") || line.startsWith("flush ") ||
+            line.startsWith("add ") || line.startsWith("swap ") ||
+            line.startsWith("destroy "))
+            cmd_list.push_back(line.trimmed());
+    }
+    CPPUNIT_ASSERT(cmd_list == sample);
+
+    res = Configlet::findConfigletInFile("script_body_iptables_shell", "test8.fw");
+    // group in rule 0 is above the threshold, single host in rule 1 is not
+    CPPUNIT_ASSERT(res.indexOf("-m set  --match-set fwb_r0_s src") != -1);
+    CPPUNIT_ASSERT(res.indexOf("-s 192.0.2.110") == -1);
+    CPPUNIT_ASSERT(res.indexOf("-s 192.0.2.100") != -1);
+
+    res = Configlet::findConfigletInFile("script_skeleton", "test8.fw");
+    CPPUNIT_ASSERT(res.indexOf("load_group_ipsets\n") != -1);
+
+    delete objdb;
+
+    // before 1.4.4 iptables matches sets with legacy option --set
+    // and the script can not load sets with ipset restore; groups are
+    // expanded into rules
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test8"));
+    CPPUNIT_ASSERT(fw != NULL);
+    fw->setStr("version", "1.4.3");
+    res = compileAndReadScriptBody(objdb, "test8");
+    CPPUNIT_ASSERT(!res.isEmpty());
+    CPPUNIT_ASSERT(res.indexOf("fwb_r0_s") == -1);
+    CPPUNIT_ASSERT(res.indexOf("-s 192.0.2.110") != -1);
+    res = Configlet::findConfigletInFile("script_skeleton", "test8.fw");
+    CPPUNIT_ASSERT(res.indexOf("load_group_ipsets\n") == -1);
+
+    delete objdb;
+}
+
+/*
+ * Minimal model of iptables filter table used to check that the
+ * decision tree of chains built by the compiler does not change
+ * the verdict for any packet. It understands only the subset of
+ * iptables command line the compiler generates for the policy built
+ * by decisionTreeTest(), everything else matches unconditionally.
+ */
+struct SimRule
+{
+    QString in_iface;
+    QString out_iface;
+    QString proto;
+    bool has_dst;
+    quint32 dst_first;
+    quint32 dst_last;
+    QList<int> dports;
+    QString state;
+    QString target;
+    SimRule() { has_dst = false; dst_first = 0; dst_last = 0; }
+};
+
+struct SimPacket
+{
+    QString in_iface;
+    QString out_iface;
+    QString proto;
+    quint32 dst;
+    int dport;
+};
+
+static quint32 parseIPv4(const QString &s)
+{
+    QStringList octets = s.split(".");
+    quint32 a = 0;
+    foreach(QString o, octets) a = (a << 8) | o.toUInt();
+    return a;
+}
+
+static void parseAddress(const QString &s, quint32 &first, quint32 &last)
+{
+    QString addr = s.section("/", 0, 0);
+    QString mask = s.section("/", 1, 1);
+    quint32 m = 0xffffffff;
+    if (mask.indexOf(".") != -1) m = parseIPv4(mask);
+    else
+        if (!mask.isEmpty())
+            m = (mask.toInt() == 0) ? 0 : (0xffffffff << (32 - mask.toInt()));
+    first = parseIPv4(addr) & m;
+    last = first | ~m;
+}
+
+static QMap<QString, QList<SimRule> > parseFilterTable(const QString &script)
+{
+    QMap<QString, QList<SimRule> > chains;
+
+    foreach(QString line, script.split("\n"))
+    {
+        QStringList words = line.trimmed().split(" ", QString::SkipEmptyParts);
+        if (words.size() < 3 || words[0] != "$IPTABLES") continue;
+        if (words.contains("-t")) continue;
+        int n = words.indexOf("-A");
+        if (n == -1) continue;
+
+        QString chain = words[n + 1];
+        SimRule rule;
+        for (int i = 1; i < words.size(); ++i)
+        {
+            QString w = words[i];
+            QString arg = (i + 1 < words.size()) ? words[i + 1] : "";
+            if (w == "-A" || w == "-m") { i++; continue; }
+            if (w == "-i") { rule.in_iface = arg; i++; continue; }
+            if (w == "-o") { rule.out_iface = arg; i++; continue; }
+            if (w == "-p") { rule.proto = arg; i++; continue; }
+            if (w == "-j") { rule.target = arg; i++; continue; }
+            if (w == "--state") { rule.state = arg; i++; continue; }
+            if (w == "-d")
+            {
+                rule.has_dst = true;
+                parseAddress(arg, rule.dst_first, rule.dst_last);
+                i++;
+                continue;
+            }
+            if (w == "--dport" || w == "--dports")
+            {
+                foreach(QString p, arg.split(","))
+                {
+                    int p1 = p.section(":", 0, 0).toInt();
+                    int p2 = (p.indexOf(":") != -1) ?
+                        p.section(":", 1, 1).toInt() : p1;
+                    for (int port = p1; port <= p2; ++port)
+                        rule.dports.push_back(port);
+                }
+                i++;
+                continue;
+            }
+            // skip arguments of options we do not model
+            while (i + 1 < words.size() && !words[i + 1].startsWith("-")) i++;
+        }
+        chains[chain].push_back(rule);
+    }
+    return chains;
+}
+
+static bool ifaceMatches(const QString &rule_iface, const QString &pkt_iface)
+{
+    if (rule_iface.isEmpty()) return true;
+    if (pkt_iface.isEmpty()) return false;
+    if (rule_iface.endsWith("+"))
+        return pkt_iface.startsWith(rule_iface.left(rule_iface.length() - 1));
+    return rule_iface == pkt_iface;
+}
+
+static QString evaluateChain(const QMap<QString, QList<SimRule> > &chains,
+                             const QString &chain, const SimPacket &pkt,
+                             int depth)
+{
+    if (depth > 32 || !chains.contains(chain)) return "";
+
+    foreach(SimRule rule, chains.value(chain))
+    {
+        if (!ifaceMatches(rule.in_iface, pkt.in_iface)) continue;
+        if (!ifaceMatches(rule.out_iface, pkt.out_iface)) continue;
+        if (!rule.proto.isEmpty() && rule.proto != pkt.proto) continue;
+        if (rule.has_dst && (pkt.dst < rule.dst_first || pkt.dst > rule.dst_last))
+            continue;
+        if (!rule.dports.isEmpty() && !rule.dports.contains(pkt.dport)) continue;
+        // all simulated packets open new sessions
+        if (!rule.state.isEmpty() && rule.state.indexOf("NEW") == -1) continue;
+
+        if (rule.target == "ACCEPT" || rule.target == "DROP" ||
+            rule.target == "REJECT")
+            return rule.target;
+
+        if (chains.contains(rule.target))
+        {
+            QString res = evaluateChain(chains, rule.target, pkt, depth + 1);
+            if (!res.isEmpty()) return res;
+        }
+    }
+    return "";
+}
+
+/*
+ * Compile randomly generated policies with and without the decision
+ * tree of chains and compare verdicts for random packets in both
+ * versions of the generated script.
+ */
+void GeneratedScriptTest::decisionTreeTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test9"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    FWOptions *fwopt = fw->getOptionsObject();
+
+    QStringList interfaces;
+    interfaces << "eth0" << "eth1";
+    int ports[] = { 22, 25, 53, 80, 443 };
+    int prefixes[] = { 16, 20, 24, 26, 28, 32 };
+
+    QList<FWObject*> services;
+    for (int i = 0; i < 5; ++i)
+    {
+        TCPUDPService *tcp = TCPService::cast(objdb->create(TCPService::TYPENAME));
+        tcp->setName(QString("dt-tcp-%1").arg(ports[i]).toStdString());
+        tcp->setDstRangeStart(ports[i]);
+        tcp->setDstRangeEnd(ports[i]);
+        lib->add(tcp);
+        services.push_back(tcp);
+
+        TCPUDPService *udp = UDPService::cast(objdb->create(UDPService::TYPENAME));
+        udp->setName(QString("dt-udp-%1").arg(ports[i]).toStdString());
+        udp->setDstRangeStart(ports[i]);
+        udp->setDstRangeEnd(ports[i]);
+        lib->add(udp);
+        services.push_back(udp);
+    }
+
+    for (int seed = 1; seed <= 5; ++seed)
+    {
+        srand(seed);
+
+        list<FWObject*> old_rules = policy->getByType(PolicyRule::TYPENAME);
+        for (list<FWObject*>::iterator i=old_rules.begin(); i!=old_rules.end(); ++i)
+            policy->remove(*i);
+
+        for (int n = 0; n < 40; ++n)
+        {
+            PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+
+            if (rand() % 5 != 0)
+            {
+                int len = prefixes[rand() % 6];
+                QString addr = QString("10.%1.%2.%3")
+                    .arg(rand() % 4).arg(rand() % 8).arg(rand() % 256);
+                Address *dst = Address::cast(objdb->create(
+                    (len == 32) ? IPv4::TYPENAME : Network::TYPENAME));
+                dst->setName(QString("dt-%1-%2/%3").arg(seed).arg(addr)
+                             .arg(len).toStdString());
+                dst->setAddress(InetAddr(addr.toStdString()) & InetAddr(len));
+                dst->setNetmask(InetAddr(len));
+                lib->add(dst);
+                rule->getDst()->addRef(dst);
+            }
+
+            if (rand() % 10 < 7)
+                rule->getSrv()->addRef(services[rand() % services.size()]);
+
+            if (rand() % 2 == 0)
+            {
+                rule->getItf()->addRef(fw->findObjectByName(
+                    Interface::TYPENAME,
+                    interfaces[rand() % 2].toStdString()));
+                rule->setDirection(PolicyRule::Inbound);
+            }
+
+            switch (rand() % 3)
+            {
+            case 0: rule->setAction(PolicyRule::Accept); break;
+            case 1: rule->setAction(PolicyRule::Deny); break;
+            default: rule->setAction(PolicyRule::Reject); break;
+            }
+
+            rule->getOptionsObject()->setBool("stateless", rand() % 2 == 0);
+        }
+
+        fwopt->setBool("ipt_decision_tree_chains", false);
+        QString flat_script = compileAndReadScriptBody(objdb, "test9");
+        fwopt->setBool("ipt_decision_tree_chains", true);
+        QString tree_script = compileAndReadScriptBody(objdb, "test9");
+
+        CPPUNIT_ASSERT(!flat_script.isEmpty());
+        CPPUNIT_ASSERT(tree_script.count("$IPTABLES -N ") >
+                       flat_script.count("$IPTABLES -N "));
+
+        QMap<QString, QList<SimRule> > flat = parseFilterTable(flat_script);
+        QMap<QString, QList<SimRule> > tree = parseFilterTable(tree_script);
+
+        QStringList builtin_chains;
+        builtin_chains << "INPUT" << "OUTPUT" << "FORWARD";
+
+        for (int n = 0; n < 3000; ++n)
+        {
+            SimPacket pkt;
+            QString chain = builtin_chains[rand() % 3];
+            if (chain != "OUTPUT") pkt.in_iface = interfaces[rand() % 2];
+            if (chain == "FORWARD")
+                pkt.out_iface = (pkt.in_iface == "eth0") ? "eth1" : "eth0";
+            if (chain == "OUTPUT") pkt.out_iface = interfaces[rand() % 2];
+            pkt.proto = (rand() % 2 == 0) ? "tcp" : "udp";
+            pkt.dport = ports[rand() % 5];
+            pkt.dst = parseIPv4(QString("10.%1.%2.%3")
+                                .arg(rand() % 4).arg(rand() % 8)
+                                .arg(rand() % 256));
+
+            QString flat_verdict = evaluateChain(flat, chain, pkt, 0);
+            QString tree_verdict = evaluateChain(tree, chain, pkt, 0);
+
+            CPPUNIT_ASSERT_MESSAGE(
+                QString("Verdict mismatch for seed %1 chain %2 packet to "
+                        "%3 %4/%5 via %6/%7: %8 vs %9")
+                .arg(seed).arg(chain).arg(pkt.dst, 0, 16)
+                .arg(pkt.proto).arg(pkt.dport)
+                .arg(pkt.in_iface).arg(pkt.out_iface)
+                .arg(flat_verdict).arg(tree_verdict).toStdString(),
+                flat_verdict == tree_verdict);
+        }
+    }
+
+    delete objdb;
+}
+
+/*
+ * Rules that do not check destination are copied into every branch
+ * of the tree. When there are many of them among rules that can be
+ * split by destination the tree gets too big and the compiler must
+ * keep the rules in a single chain.
+ */
+void GeneratedScriptTest::decisionTreeLimitTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test9"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    FWOptions *fwopt = fw->getOptionsObject();
+
+    list<FWObject*> old_rules = policy->getByType(PolicyRule::TYPENAME);
+    for (list<FWObject*>::iterator i=old_rules.begin(); i!=old_rules.end(); ++i)
+        policy->remove(*i);
+
+    for (int n = 0; n < 72; ++n)
+    {
+        PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+
+        if (n % 9 == 8)
+        {
+            TCPUDPService *tcp = TCPService::cast(
+                objdb->create(TCPService::TYPENAME));
+            tcp->setName(QString("dtl-tcp-%1").arg(8000 + n).toStdString());
+            tcp->setDstRangeStart(8000 + n);
+            tcp->setDstRangeEnd(8000 + n);
+            lib->add(tcp);
+            rule->getSrv()->addRef(tcp);
+        } else
+        {
+            QString addr = QString("10.0.%1.1").arg(n * 3);
+            IPv4 *dst = IPv4::cast(objdb->create(IPv4::TYPENAME));
+            dst->setName(QString("dtl-%1").arg(addr).toStdString());
+            dst->setAddress(InetAddr(addr.toStdString()));
+            lib->add(dst);
+            rule->getDst()->addRef(dst);
+        }
+
+        rule->setAction((n % 2) ? PolicyRule::Deny : PolicyRule::Accept);
+    }
+
+    fwopt->setBool("ipt_decision_tree_chains", false);
+    QString flat_script = compileAndReadScriptBody(objdb, "test9");
+    fwopt->setBool("ipt_decision_tree_chains", true);
+    QString tree_script = compileAndReadScriptBody(objdb, "test9");
+
+    CPPUNIT_ASSERT(!flat_script.isEmpty());
+    CPPUNIT_ASSERT(tree_script.count("$IPTABLES -N ") ==
+                   flat_script.count("$IPTABLES -N "));
+    CPPUNIT_ASSERT(tree_script.count("$IPTABLES -A ") ==
+                   flat_script.count("$IPTABLES -A "));
+
+    delete objdb;
+}
+
+/*
+ * Rules that come out of the iptables compiler are loaded into
+ * RuleHitSimulator by chain and target. Packets forwarded by the
+ * firewall must get the same decision from the compiled FORWARD
+ * chain as from the rule set they were compiled from.
+ */
+void GeneratedScriptTest::compiledRulesSimulationTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test9"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    Policy *policy = Policy::cast(fw->getFirstByType(Policy::TYPENAME));
+
+    const char *dst[] = { "10.0.1.0", "10.0.1.5", "10.0.2.0", "10.0.0.0" };
+    int dst_len[] = { 24, 32, 24, 16 };
+    int ports[] = { 80, 0, 53, 22 };
+    PolicyRule::Action actions[] = { PolicyRule::Accept, PolicyRule::Deny,
+                                     PolicyRule::Reject, PolicyRule::Accept };
+
+    for (int n = 0; n < 4; ++n)
+    {
+        PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+
+        Address *addr = Address::cast(objdb->create(
+            (dst_len[n] == 32) ? IPv4::TYPENAME : Network::TYPENAME));
+        addr->setName(QString("sim-%1/%2").arg(dst[n]).arg(dst_len[n])
+                      .toStdString());
+        addr->setAddress(InetAddr(dst[n]) & InetAddr(dst_len[n]));
+        addr->setNetmask(InetAddr(dst_len[n]));
+        lib->add(addr);
+        rule->getDst()->addRef(addr);
+
+        if (ports[n])
+        {
+            TCPUDPService *srv = (ports[n] == 53) ?
+                TCPUDPService::cast(objdb->create(UDPService::TYPENAME)) :
+                TCPUDPService::cast(objdb->create(TCPService::TYPENAME));
+            srv->setName(QString("sim-%1").arg(ports[n]).toStdString());
+            srv->setDstRangeStart(ports[n]);
+            srv->setDstRangeEnd(ports[n]);
+            lib->add(srv);
+            rule->getSrv()->addRef(srv);
+        }
+
+        if (n == 0)
+        {
+            rule->getItf()->addRef(
+                fw->findObjectByName(Interface::TYPENAME, "eth0"));
+            rule->setDirection(PolicyRule::Inbound);
+        }
+        rule->setAction(actions[n]);
+    }
+
+    PolicyModel source(fw);
+    source.addRuleSet(policy);
+
+    PolicyModel model(fw);
+    RuleHitSimulator sim(model);
+    RuleHitSimulator_ipt adapter(sim);
+
+    QStringList args;
+    args << "test9";
+
+    // compiled rules belong to the driver's copy of the objects, the
+    // driver must stay around while the simulator runs
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    driver.setRuleHitSimulator(&adapter);
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+
+    CPPUNIT_ASSERT(sim.countRules() >= 4);
+    CPPUNIT_ASSERT(adapter.getWarnings().empty());
+
+    string forward = RuleHitSimulator_ipt::chainName("filter", "FORWARD");
+    bool have_forward = false;
+    for (unsigned n = 0; n < sim.getChains().size(); ++n)
+        if (sim.getChains()[n].name == forward) have_forward = true;
+    CPPUNIT_ASSERT(have_forward);
+
+    vector<PolicyModel::Packet> trace;
+    sim.generateTrace(2000, 1, trace);
+    sim.run(trace, forward);
+    CPPUNIT_ASSERT(sim.getPackets() == 2000);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::ACCEPT) > 0);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::DENY) > 0);
+    CPPUNIT_ASSERT(sim.getDecisionCount(PolicyModel::REJECT) > 0);
+
+    int compared = 0;
+    for (unsigned n = 0; n < trace.size(); ++n)
+    {
+        const PolicyModel::Packet &p = trace[n];
+        // only packets that go through FORWARD chain
+        if (p.get(PolicyModel::IN_ITF) == 0 || p.get(PolicyModel::OUT_ITF) == 0)
+            continue;
+        PolicyModel::Decision expected = source.evaluate(p);
+        PolicyModel::Decision compiled = sim.evaluate(p, forward);
+        CPPUNIT_ASSERT_MESSAGE(
+            "Decision mismatch for packet " + model.toString(p) + ": " +
+            PolicyModel::decisionName(expected) + " vs " +
+            PolicyModel::decisionName(compiled),
+            expected == compiled);
+        compared++;
+    }
+    CPPUNIT_ASSERT(compared > 0);
+
+    delete objdb;
+}
+
+/*
+ * Compiles of the same rules with and without decision tree of
+ * chains must make the same decisions, compiles of rules in
+ * different order must not.
+ */
+void GeneratedScriptTest::compileAndCompareTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test9"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    FWOptions *fwopt = fw->getOptionsObject();
+
+    list<FWObject*> old_rules = policy->getByType(PolicyRule::TYPENAME);
+    for (list<FWObject*>::iterator i=old_rules.begin(); i!=old_rules.end(); ++i)
+        policy->remove(*i);
+
+    int ports[] = { 22, 25, 53, 80, 443 };
+
+    // pairs of rules, the second rule of a pair matches part of
+    // what the first one does and has different action
+    for (int k = 0; k < 12; ++k)
+    {
+        TCPUDPService *tcp = TCPService::cast(objdb->create(TCPService::TYPENAME));
+        tcp->setName(QString("cmp-tcp-%1").arg(k).toStdString());
+        tcp->setDstRangeStart(ports[k % 5]);
+        tcp->setDstRangeEnd(ports[k % 5]);
+        lib->add(tcp);
+
+        for (int n = 0; n < 2; ++n)
+        {
+            PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+
+            QString addr = QString("10.0.%1.%2").arg(k).arg((n) ? 8 * k : 0);
+            int len = (n) ? 29 : 24;
+            Network *dst = Network::cast(objdb->create(Network::TYPENAME));
+            dst->setName(QString("cmp-%1/%2").arg(addr).arg(len).toStdString());
+            dst->setAddress(InetAddr(addr.toStdString()));
+            dst->setNetmask(InetAddr(len));
+            lib->add(dst);
+            rule->getDst()->addRef(dst);
+            rule->getSrv()->addRef(tcp);
+
+            if (k % 3 == 0)
+            {
+                rule->getItf()->addRef(fw->findObjectByName(
+                    Interface::TYPENAME, (k % 2) ? "eth1" : "eth0"));
+                rule->setDirection(PolicyRule::Inbound);
+            }
+
+            if (n) rule->setAction(PolicyRule::Deny);
+            else rule->setAction((k % 2) ? PolicyRule::Reject : PolicyRule::Accept);
+        }
+    }
+
+    PolicyModel flat_model(fw);
+    PolicyModel tree_model(fw);
+    PolicyModel moved_model(fw);
+    RuleHitSimulator flat_sim(flat_model);
+    RuleHitSimulator tree_sim(tree_model);
+    RuleHitSimulator moved_sim(moved_model);
+    RuleHitSimulator_ipt flat(flat_sim);
+    RuleHitSimulator_ipt tree(tree_sim);
+    RuleHitSimulator_ipt moved(moved_sim);
+
+    fwopt->setBool("ipt_decision_tree_chains", false);
+    flat.compile(fw);
+    fwopt->setBool("ipt_decision_tree_chains", true);
+    tree.compile(fw);
+    policy->moveRuleDown(0);
+    moved.compile(fw);
+
+    CPPUNIT_ASSERT(tree_sim.getChains().size() > flat_sim.getChains().size());
+
+    QStringList builtin_chains;
+    builtin_chains << "INPUT" << "OUTPUT" << "FORWARD";
+    foreach(QString chain, builtin_chains)
+    {
+        string name = RuleHitSimulator_ipt::chainName("filter",
+                                                      chain.toStdString());
+        vector<PolicyDecisionMap::Difference> diffs;
+        CPPUNIT_ASSERT_MESSAGE(
+            "Decision tree changed decisions of chain " + name,
+            RuleHitSimulator_ipt::compare(fw, flat, tree, name, diffs));
+        CPPUNIT_ASSERT(diffs.empty());
+    }
+
+    vector<PolicyDecisionMap::Difference> diffs;
+    string forward = RuleHitSimulator_ipt::chainName("filter", "FORWARD");
+    CPPUNIT_ASSERT(!RuleHitSimulator_ipt::compare(fw, flat, moved, forward, diffs));
+    CPPUNIT_ASSERT(!diffs.empty());
+    CPPUNIT_ASSERT(diffs[0].decision_a == PolicyModel::ACCEPT);
+    CPPUNIT_ASSERT(diffs[0].decision_b == PolicyModel::DENY);
+
+    delete objdb;
+}
+
+/*
+ * Compile a rule with many TCP ports and port ranges, some of them
+ * overlapping or adjacent, with and without packing of ports for
+ * module multiport. Packing must produce fewer iptables commands and
+ * the same verdict for every port.
+ */
+void GeneratedScriptTest::multiportPackingTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "test9"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    FWOptions *fwopt = fw->getOptionsObject();
+
+    list<FWObject*> old_rules = policy->getByType(PolicyRule::TYPENAME);
+    for (list<FWObject*>::iterator i=old_rules.begin(); i!=old_rules.end(); ++i)
+        policy->remove(*i);
+
+    PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+    rule->setAction(PolicyRule::Accept);
+    rule->getItf()->addRef(fw->findObjectByName(Interface::TYPENAME, "eth0"));
+    rule->setDirection(PolicyRule::Inbound);
+
+    // 1000:1099 and 1050:1199 overlap, 2000:2099 and 2100:2199 are
+    // adjacent, 3000-3002 merge into one range, 4000:4009 contains 4005
+    int ranges[][2] = {
+        { 1000, 1099 }, { 1050, 1199 }, { 2000, 2099 }, { 2100, 2199 },
+        { 3000, 3000 }, { 3001, 3001 }, { 3002, 3002 },
+        { 4000, 4009 }, { 4005, 4005 },
+        { 5000, 5010 }, { 5100, 5110 }, { 5200, 5210 }, { 5300, 5310 },
+        { 5400, 5410 }, { 5500, 5510 }, { 5600, 5610 }, { 5700, 5710 }
+    };
+    int n_ranges = sizeof(ranges) / sizeof(ranges[0]);
+    for (int i = 0; i < n_ranges; ++i)
+    {
+        TCPUDPService *tcp = TCPService::cast(objdb->create(TCPService::TYPENAME));
+        tcp->setName(QString("mp-tcp-%1-%2")
+                     .arg(ranges[i][0]).arg(ranges[i][1]).toStdString());
+        tcp->setDstRangeStart(ranges[i][0]);
+        tcp->setDstRangeEnd(ranges[i][1]);
+        lib->add(tcp);
+        rule->getSrv()->addRef(tcp);
+    }
+    for (int port = 6000; port < 6060; port += 3)
+    {
+        TCPUDPService *tcp = TCPService::cast(objdb->create(TCPService::TYPENAME));
+        tcp->setName(QString("mp-tcp-%1").arg(port).toStdString());
+        tcp->setDstRangeStart(port);
+        tcp->setDstRangeEnd(port);
+        lib->add(tcp);
+        rule->getSrv()->addRef(tcp);
+    }
+
+    PolicyRule *deny = PolicyRule::cast(policy->appendRuleAtBottom());
+    deny->setAction(PolicyRule::Deny);
+
+    fwopt->setBool("ipt_pack_multiport_services", false);
+    QString plain_script = compileAndReadScriptBody(objdb, "test9");
+    fwopt->setBool("ipt_pack_multiport_services", true);
+    QString packed_script = compileAndReadScriptBody(objdb, "test9");
+
+    CPPUNIT_ASSERT(!plain_script.isEmpty());
+    CPPUNIT_ASSERT(packed_script.count("--dport") <
+                   plain_script.count("--dport"));
+    CPPUNIT_ASSERT(packed_script.indexOf("1000:1199") != -1);
+    CPPUNIT_ASSERT(packed_script.indexOf("2000:2199") != -1);
+    CPPUNIT_ASSERT(packed_script.indexOf("3000:3002") != -1);
+
+    QMap<QString, QList<SimRule> > plain = parseFilterTable(plain_script);
+    QMap<QString, QList<SimRule> > packed = parseFilterTable(packed_script);
+
+    for (int port = 900; port < 6100; ++port)
+    {
+        SimPacket pkt;
+        pkt.in_iface = "eth0";
+        pkt.proto = "tcp";
+        pkt.dport = port;
+        pkt.dst = parseIPv4("10.0.0.1");
+
+        QString plain_verdict = evaluateChain(plain, "INPUT", pkt, 0);
+        QString packed_verdict = evaluateChain(packed, "INPUT", pkt, 0);
+
+        CPPUNIT_ASSERT_MESSAGE(
+            QString("Verdict mismatch for port %1: %2 vs %3")
+            .arg(port).arg(plain_verdict).arg(packed_verdict).toStdString(),
+            plain_verdict == packed_verdict);
+    }
+
+    fwopt->setBool("ipt_pack_multiport_services", false);
+
+    delete objdb;
+}
+
+// -xmv compiles the target twice, using pruned and full copy of
+// the object database, and flags an error if generated files differ
+void GeneratedScriptTest::prunedObjectDatabaseTest()
+{
+    QStringList targets;
+    targets << "test1" << "test8" << "cluster-2-3";
+
+    foreach(QString target, targets)
+    {
+        objdb = new FWObjectDatabase();
+        loadDataFile("test1.fwb");
+
+        QStringList args;
+        args << "-xmv" << target;
+
+        CompilerDriver_ipt driver(objdb);
+        driver.setEmbeddedMode();
+        CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                               driver.prepare(args) == true);
+        driver.compile();
+        CPPUNIT_ASSERT_MESSAGE(
+            "Pruned object database copy changed generated script for " +
+            target.toStdString(),
+            driver.getStatus() != BaseCompiler::FWCOMPILER_ERROR);
+
+        delete objdb;
+    }
+}
+
+/*
+ * Read generated file replacing time stamps that differ between runs
+ */
+static QString readGeneratedScript(const QString &file_name)
+{
+    QFile file(file_name);
+    CPPUNIT_ASSERT_MESSAGE("Generated file " + file_name.toStdString() +
+                           " not found",
+                           file.open(QIODevice::ReadOnly));
+    QString text = QString::fromUtf8(file.readAll().constData());
+    text.replace(
+        QRegExp("\\w{3} \\w{3} [ \\d]\\d \\d{2}:\\d{2}:\\d{2} \\d{4}"),
+        "<timestamp>");
+    return text;
+}
+
+static QStringList compileCluster(FWObjectDatabase *objdb,
+                                  const QStringList &extra_args,
+                                  const QStringList &members,
+                                  QStringList &specialized_members)
+{
+    foreach(QString member, members) QFile::remove(member + ".fw");
+
+    QStringList args;
+    args << extra_args << "cluster-nodes";
+
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+    CPPUNIT_ASSERT(driver.getStatus() != BaseCompiler::FWCOMPILER_ERROR);
+    specialized_members = driver.getSpecializedMembers();
+
+    QStringList res;
+    foreach(QString member, members)
+        res << readGeneratedScript(member + ".fw");
+    return res;
+}
+
+/*
+ * Members node1 and node2 of cluster-nodes differ only in names and
+ * addresses. With -xs the script for node2 is made from the script
+ * compiled for node1 and should be identical to the one the compiler
+ * generates for node2.
+ */
+void GeneratedScriptTest::specializedClusterMembersTest()
+{
+    QStringList members;
+    members << "node1" << "node2";
+    QStringList specialized;
+
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    QStringList compiled = compileCluster(objdb, QStringList(), members,
+                                          specialized);
+    CPPUNIT_ASSERT(specialized.isEmpty());
+    delete objdb;
+
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    QStringList xs_args;
+    xs_args << "-xs";
+    QStringList generated = compileCluster(objdb, xs_args, members,
+                                           specialized);
+    CPPUNIT_ASSERT_MESSAGE("Script for node2 was compiled rather than "
+                           "specialized from that of node1",
+                           specialized.size() == 1 &&
+                           specialized.front() == "node2");
+    delete objdb;
+
+    CPPUNIT_ASSERT(compiled[0] == generated[0]);
+    CPPUNIT_ASSERT_MESSAGE("Specialized script for node2 differs from "
+                           "the compiled one",
+                           compiled[1] == generated[1]);
+
+    // cluster-2-3 uses heartbeat, generated scripts include addresses
+    // of the other member and can not be specialized
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    QStringList args;
+    args << "-xs" << "cluster-2-3";
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT(driver.prepare(args) == true);
+    driver.compile();
+    CPPUNIT_ASSERT(driver.getSpecializedMembers().isEmpty());
+    delete objdb;
+
+    // comment of a rule of the cluster names member node1. The
+    // compiler copies it to the scripts of both members as is,
+    // substitution would have changed it to node2 in the script of
+    // node2, so the member must be compiled
+    for (int i=0; i<2; ++i)
+    {
+        objdb = new FWObjectDatabase();
+        loadDataFile("test1.fwb");
+        FWObject *cluster =
+            objdb->findObjectByName(Cluster::TYPENAME, "cluster-nodes");
+        CPPUNIT_ASSERT(cluster != NULL);
+        RuleSet *policy = RuleSet::cast(cluster->getFirstByType(Policy::TYPENAME));
+        CPPUNIT_ASSERT(policy != NULL);
+        PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+        rule->setAction(PolicyRule::Accept);
+        rule->setComment("permitted on node1 only");
+        generated = compileCluster(objdb, (i == 0) ? QStringList() : xs_args,
+                                   members, specialized);
+        delete objdb;
+        if (i == 0) compiled = generated;
+    }
+    CPPUNIT_ASSERT(specialized.isEmpty());
+    CPPUNIT_ASSERT(generated[1].contains("# permitted on node1 only"));
+    CPPUNIT_ASSERT(compiled[1] == generated[1]);
+
+    // eth2 of node2 is moved to a different subnet with the same
+    // netmask. Substitution of the address would have left network
+    // of eth2 of node1 in the script of node2
+    for (int i=0; i<2; ++i)
+    {
+        objdb = new FWObjectDatabase();
+        loadDataFile("test1.fwb");
+        Address *addr = Address::cast(
+            objdb->findObjectByName(IPv4::TYPENAME, "node2:eth2:ip"));
+        CPPUNIT_ASSERT(addr != NULL);
+        addr->setAddress(InetAddr("10.3.26.2"));
+        generated = compileCluster(objdb, (i == 0) ? QStringList() : xs_args,
+                                   members, specialized);
+        delete objdb;
+        if (i == 0) compiled = generated;
+    }
+    CPPUNIT_ASSERT(specialized.isEmpty());
+    CPPUNIT_ASSERT(generated[1].contains("10.3.26."));
+    CPPUNIT_ASSERT(compiled[1] == generated[1]);
+}
+
 // compiler should place generated script in the directory specified
 // with -d option
 void GeneratedScriptTest::minusDTest()
@@ -59,6 +59,15 @@ public:
     void virtualAddressesForNat2Test();
     void runTimeAddressTablesWithIpSet1Test();
     void runTimeAddressTablesWithIpSet2Test();
+    void runTimeAddressTablesWithIpSet3Test();
+    void groupIpSetTest();
+    void decisionTreeTest();
+    void decisionTreeLimitTest();
+    void compiledRulesSimulationTest();
+    void compileAndCompareTest();
+    void multiportPackingTest();
+    void prunedObjectDatabaseTest();
+    void specializedClusterMembersTest();
     void minusDTest();
     void minusOTest1();
     void minusOTest2();
@@ -78,6 +87,15 @@ public:
     CPPUNIT_TEST(virtualAddressesForNat2Test);
     CPPUNIT_TEST(runTimeAddressTablesWithIpSet1Test);
     CPPUNIT_TEST(runTimeAddressTablesWithIpSet2Test);
+    CPPUNIT_TEST(runTimeAddressTablesWithIpSet3Test);
+    CPPUNIT_TEST(groupIpSetTest);
+    CPPUNIT_TEST(decisionTreeTest);
+    CPPUNIT_TEST(decisionTreeLimitTest);
+    CPPUNIT_TEST(compiledRulesSimulationTest);
+    CPPUNIT_TEST(compileAndCompareTest);
+    CPPUNIT_TEST(multiportPackingTest);
+    CPPUNIT_TEST(prunedObjectDatabaseTest);
+    CPPUNIT_TEST(specializedClusterMembersTest);
     CPPUNIT_TEST(minusDTest);
     CPPUNIT_TEST(minusOTest1);
     CPPUNIT_TEST(minusOTest2);
@@ -0,0 +1,368 @@
+/* 
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+
+#include "generatedScriptTestsNftables.h"
+
+#include "CompilerDriver_ipt.h"
+#include "Configlet.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/IPService.h"
+#include "fwbuilder/Constants.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TCPService.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QtDebug>
+
+using namespace std;
+using namespace libfwbuilder;
+using namespace fwcompiler;
+
+
+class UpgradePredicate: public XMLTools::UpgradePredicate
+{
+    public:
+    virtual bool operator()(const string&) const 
+    { 
+	cout << "Data file has been created in the old version of Firewall Builder. Use fwbuilder GUI to convert it." << std::endl;
+	return false;
+    }
+};
+
+
+void GeneratedScriptTest::setUp()
+{
+    // register protocols we need
+    IPService::addNamedProtocol(51, "ah");
+    IPService::addNamedProtocol(112, "vrrp");
+
+    Configlet::setDebugging(true);
+}
+
+void GeneratedScriptTest::tearDown()
+{
+}
+
+void GeneratedScriptTest::loadDataFile(const string &file_name)
+{
+    try
+    {
+        /* load the data file */
+        UpgradePredicate upgrade_predicate; 
+
+        objdb->setReadOnly( false );
+        objdb->load(file_name, &upgrade_predicate, Constants::getDTDDirectory());
+        objdb->setFileName(file_name);
+        objdb->reIndex();
+    } catch (FWException &ex)
+    {
+        qDebug() << ex.toString().c_str();
+    }
+}
+
+void GeneratedScriptTest::runCompiler(const std::string &test_file,
+                                      const std::string &firewall_object_name,
+                                      const std::string &generate_file_name)
+{
+    loadDataFile(test_file);
+
+    QStringList args;
+    args << firewall_object_name.c_str();
+
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+    // compiler should have created the .fw file
+    QFileInfo fi(generate_file_name.c_str());
+    CPPUNIT_ASSERT_MESSAGE("Generated file " + generate_file_name + " not found",
+                           fi.exists() == true);
+}
+
+/*
+ * Compiles firewall fw_name from the database objdb as it is in
+ * memory, so tests can add rules before compiling.
+ */
+static QString compileAndReadScriptBody(FWObjectDatabase *objdb,
+                                        const QString &fw_name)
+{
+    QFile::remove(fw_name + ".fw");
+
+    QStringList args;
+    args << fw_name;
+
+    CompilerDriver_ipt driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_ipt initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+
+    return Configlet::findConfigletInFile("script_body_nftables",
+                                          fw_name + ".fw");
+}
+
+/*
+ * Adds a rule at the top of the policy of firewall fw, above the
+ * catch-all rule that would shadow it
+ */
+static PolicyRule* addRule(Firewall *fw, PolicyRule::Action action)
+{
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    PolicyRule *rule = PolicyRule::cast(policy->insertRuleAtTop());
+    rule->setAction(action);
+    rule->setLogging(false);
+    return rule;
+}
+
+static TCPService* createTCPService(FWObjectDatabase *objdb, Library *lib,
+                                    int port)
+{
+    TCPService *tcp = TCPService::cast(objdb->create(TCPService::TYPENAME));
+    tcp->setName(QString("tcp-%1").arg(port).toStdString());
+    tcp->setDstRangeStart(port);
+    tcp->setDstRangeEnd(port);
+    lib->add(tcp);
+    return tcp;
+}
+
+void GeneratedScriptTest::CheckUtilitiesTest()
+{
+    QStringList utils;
+
+    QStringList nft1_utils;
+    nft1_utils << "find_program which";
+    nft1_utils << "find_program $IPTABLES";
+    nft1_utils << "find_program $MODPROBE";
+    nft1_utils << "find_program $IP";
+    nft1_utils << "find_program $NFT";
+
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "nft1", "nft1.fw");
+    QString res = Configlet::findConfigletInFile("check_utilities", "nft1.fw");
+    foreach(QString line, res.split("\n"))
+    {
+        if (line.indexOf("find_program ")!=-1)
+        {
+            utils.push_back(line.trimmed());
+        }
+    }
+    CPPUNIT_ASSERT(utils == nft1_utils);
+    delete objdb;
+}
+
+void GeneratedScriptTest::ScriptBodyTest()
+{
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "nft1", "nft1.fw");
+    QString res = Configlet::findConfigletInFile("script_body_nftables",
+                                                 "nft1.fw");
+    CPPUNIT_ASSERT(!res.isEmpty());
+    // the whole filter table is loaded in one transaction
+    CPPUNIT_ASSERT(res.indexOf("$NFT -f -") != -1);
+    CPPUNIT_ASSERT(res.indexOf("add table ip fwbuilder") != -1);
+    CPPUNIT_ASSERT(res.indexOf("delete table ip fwbuilder") != -1);
+    CPPUNIT_ASSERT(res.indexOf("policy drop") != -1);
+    // policy rules must not be generated as iptables commands
+    CPPUNIT_ASSERT(res.indexOf("$IPTABLES -w -A INPUT") == -1);
+    CPPUNIT_ASSERT(res.indexOf("$IPTABLES -A INPUT") == -1);
+    CPPUNIT_ASSERT(res.indexOf("add rule ip fwbuilder INPUT") != -1);
+    delete objdb;
+}
+
+void GeneratedScriptTest::NamedSetTest()
+{
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "nft1", "nft1.fw");
+    QString res = Configlet::findConfigletInFile("script_body_nftables",
+                                                 "nft1.fw");
+    // rule 0 uses group of three hosts as source, the compiler should
+    // generate one rule that matches named set instead of three rules
+    CPPUNIT_ASSERT(res.indexOf("add set ip fwbuilder") != -1);
+    CPPUNIT_ASSERT(res.indexOf(
+                       "192.0.2.10, 192.0.2.11, 192.0.2.12") != -1);
+    CPPUNIT_ASSERT(res.indexOf("ip saddr @") != -1);
+    delete objdb;
+}
+
+void GeneratedScriptTest::VerdictMapTest()
+{
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "nft1", "nft1.fw");
+    QString res = Configlet::findConfigletInFile("script_body_nftables",
+                                                 "nft1.fw");
+    // rules 1 and 2 differ only in source address and action
+    CPPUNIT_ASSERT(res.indexOf("add map ip fwbuilder") != -1);
+    CPPUNIT_ASSERT(res.indexOf("ipv4_addr : verdict") != -1);
+    CPPUNIT_ASSERT(res.indexOf("192.0.2.13 : accept") != -1);
+    CPPUNIT_ASSERT(res.indexOf("192.0.2.10 : drop") != -1);
+    CPPUNIT_ASSERT(res.indexOf("ip saddr vmap @") != -1);
+    // reject is not a verdict and can not be folded into the map
+    CPPUNIT_ASSERT(res.indexOf("192.0.2.11 : ") == -1);
+    delete objdb;
+}
+
+void GeneratedScriptTest::ResetTest()
+{
+    objdb = new FWObjectDatabase();
+    runCompiler("test1.fwb", "nft1", "nft1.fw");
+    QString res = Configlet::findConfigletInFile("reset_iptables", "nft1.fw");
+    CPPUNIT_ASSERT(res.indexOf("$NFT delete table ip fwbuilder") != -1);
+    delete objdb;
+}
+
+void GeneratedScriptTest::PortSetTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "nft1"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+
+    // more ports than iptables multiport module can take
+    PolicyRule *rule = addRule(fw, PolicyRule::Accept);
+    QStringList ports;
+    for (int port = 7001; port <= 7020; ++port)
+    {
+        rule->getSrv()->addRef(createTCPService(objdb, lib, port));
+        ports << QString::number(port);
+    }
+
+    QString res = compileAndReadScriptBody(objdb, "nft1");
+    CPPUNIT_ASSERT(!res.isEmpty());
+
+    // rule with "any" in source and destination goes into INPUT,
+    // OUTPUT and FORWARD; in each chain all ports are matched by one
+    // set in one rule
+    QString port_set = "tcp dport { " + ports.join(", ") + " }";
+    QStringList rules;
+    foreach(QString line, res.split("\n"))
+    {
+        if (line.indexOf("7001") != -1) rules.push_back(line);
+    }
+    CPPUNIT_ASSERT(rules.size() == 3);
+    foreach(QString line, rules)
+    {
+        CPPUNIT_ASSERT_MESSAGE(line.toStdString(), line.count(port_set) == 1);
+        CPPUNIT_ASSERT_MESSAGE(line.toStdString(), line.count("7001") == 1);
+    }
+    CPPUNIT_ASSERT(res.indexOf("multiport") == -1);
+
+    delete objdb;
+}
+
+/*
+ * Group with addresses of both families used in a rule of dual stack
+ * policy. Each address must end up in the rule for its own family
+ * and neither rule may match any address.
+ */
+void GeneratedScriptTest::MixedFamilyTest()
+{
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "nft1"));
+    CPPUNIT_ASSERT(fw != NULL);
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    policy->setDual();
+
+    IPv4 *addr4= IPv4::cast(objdb->create(IPv4::TYPENAME));
+    addr4->setName("mixed-v4");
+    addr4->setAddress(InetAddr("192.0.2.50"));
+    lib->add(addr4);
+
+    IPv6 *addr6 = IPv6::cast(objdb->create(IPv6::TYPENAME));
+    addr6->setName("mixed-v6");
+    addr6->setAddress(InetAddr(AF_INET6, "2001:db8::50"));
+    lib->add(addr6);
+
+    ObjectGroup *grp = ObjectGroup::cast(objdb->create(ObjectGroup::TYPENAME));
+    grp->setName("mixed-family");
+    lib->add(grp);
+    grp->addRef(addr4);
+    grp->addRef(addr6);
+
+    PolicyRule *rule = addRule(fw, PolicyRule::Deny);
+    rule->getDst()->addRef(grp);
+    rule->getSrv()->addRef(createTCPService(objdb, lib, 4444));
+
+    QString res = compileAndReadScriptBody(objdb, "nft1");
+    CPPUNIT_ASSERT(!res.isEmpty());
+    // ipv6 policy is loaded by the second copy of the configlet
+    res += Configlet::findConfigletInFile("script_body_nftables",
+                                          "nft1.fw", 2);
+
+    QStringList rules;
+    foreach(QString line, res.split("\n"))
+    {
+        if (line.indexOf("dport 4444") != -1) rules.push_back(line);
+    }
+    CPPUNIT_ASSERT(!rules.isEmpty());
+
+    bool found4 = false;
+    bool found6 = false;
+    foreach(QString line, rules)
+    {
+        if (line.indexOf("add rule ip fwbuilder") != -1)
+        {
+            CPPUNIT_ASSERT_MESSAGE(line.toStdString(),
+                                   line.indexOf("ip daddr 192.0.2.50") != -1);
+            found4 = true;
+        }
+        if (line.indexOf("add rule ip6 fwbuilder") != -1)
+        {
+            CPPUNIT_ASSERT_MESSAGE(line.toStdString(),
+                                   line.indexOf("ip6 daddr 2001:db8::50") != -1);
+            found6 = true;
+        }
+    }
+    CPPUNIT_ASSERT(found4);
+    CPPUNIT_ASSERT(found6);
+
+    delete objdb;
+}
@@ -0,0 +1,12 @@
+include(../tests_common.pri)
+QT += gui network
+
+HEADERS = generatedScriptTestsNftables.h
+SOURCES = main_generatedScriptTestsNftables.cpp \
+	  generatedScriptTestsNftables.cpp
+TARGET = generatedScriptTestsNftables
+
+run_tests.commands = echo "Running tests..." && \
+    rm -f *.fw && \
+    ./${TARGET}
+
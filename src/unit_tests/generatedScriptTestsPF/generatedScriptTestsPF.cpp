@@ -32,7 +32,15 @@
 
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/FWException.h"
+#include "fwbuilder/FWOptions.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Host.h"
 #include "fwbuilder/IPService.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/TagService.h"
 #include "fwbuilder/Constants.h"
 
 #include <QApplication>
@@ -41,6 +49,7 @@
 #include <QtDebug>
 #include <QDir>
 #include <QFile>
+#include <QRegExp>
 
 
 using namespace std;
@@ -429,5 +438,180 @@ void GeneratedScriptTest::ActivationCommandsTest_12()
     delete objdb;
 }
 
+static QString readGeneratedFile(const QString &file_name)
+{
+    QFile file(file_name);
+    CPPUNIT_ASSERT_MESSAGE("Generated file " + file_name.toStdString() +
+                           " not found",
+                           file.open(QIODevice::ReadOnly));
+    QString text = QString::fromUtf8(file.readAll().constData());
+    text.replace(
+        QRegExp("\\w{3} \\w{3} [ \\d]\\d \\d{2}:\\d{2}:\\d{2} \\d{4}"),
+        "<timestamp>");
+    return text;
+}
+
+static QStringList compilePFCluster(FWObjectDatabase *objdb,
+                                    const QStringList &extra_args,
+                                    QStringList &specialized_members)
+{
+    QStringList files;
+    files << "pfc1.fw" << "pfc1.conf"
+          << "pfc2.fw" << "pfc2.conf"
+          << "pfc3.fw" << "pfc3.conf";
+    foreach(QString file_name, files) QFile::remove(file_name);
+
+    QStringList args;
+    args << extra_args << "pf-cluster-1";
+
+    CompilerDriver_pf driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_pf initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+    CPPUNIT_ASSERT(driver.getStatus() != BaseCompiler::FWCOMPILER_ERROR);
+    specialized_members = driver.getSpecializedMembers();
+
+    QStringList res;
+    foreach(QString file_name, files) res << readGeneratedFile(file_name);
+    return res;
+}
+
+/*
+ * pfc1 is the CARP master in pf-cluster-1 and is always compiled. With
+ * -xs, files for pfc3 are made from those compiled for pfc2 and
+ * should be identical to the files the compiler generates for pfc3.
+ */
+void GeneratedScriptTest::SpecializedClusterMembersTest()
+{
+    QStringList specialized;
 
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    QStringList compiled = compilePFCluster(objdb, QStringList(), specialized);
+    CPPUNIT_ASSERT(specialized.isEmpty());
+    delete objdb;
+
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    QStringList args;
+    args << "-xs";
+    QStringList generated = compilePFCluster(objdb, args, specialized);
+    CPPUNIT_ASSERT_MESSAGE("Files for pfc3 were compiled rather than "
+                           "specialized from those of pfc2",
+                           specialized.size() == 1 &&
+                           specialized.front() == "pfc3");
+    delete objdb;
+
+    for (int i=0; i<compiled.size(); ++i)
+        CPPUNIT_ASSERT_MESSAGE("Generated file differs with -xs",
+                               compiled[i] == generated[i]);
+}
 
+/*
+ * Replace policy of pf1 with a single rule that permits tcp and udp
+ * services. The compiler splits it into one pf rule per protocol.
+ * Objects come from test1.fwb and the Standard library and have fixed
+ * ids, skip steps optimizer sorts rules by these ids, so the output
+ * does not depend on ids generated at run time.
+ */
+static PolicyRule* createSkipStepsPolicy(FWObjectDatabase *objdb)
+{
+    Firewall *fw = Firewall::cast(
+        objdb->findObjectByName(Firewall::TYPENAME, "pf1"));
+    CPPUNIT_ASSERT(fw != NULL);
+    fw->getOptionsObject()->setBool("pf_optimize_skip_steps", true);
+
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    list<FWObject*> old_rules = policy->getByType(PolicyRule::TYPENAME);
+    for (list<FWObject*>::iterator i=old_rules.begin(); i!=old_rules.end(); ++i)
+        policy->remove(*i);
+
+    FWObject *net = objdb->findObjectByName(Network::TYPENAME, "net-10.0.0.0");
+    FWObject *server = objdb->findObjectByName(Host::TYPENAME,
+                                               "internal server");
+    CPPUNIT_ASSERT(net != NULL && server != NULL);
+
+    PolicyRule *rule = PolicyRule::cast(policy->appendRuleAtBottom());
+    rule->getSrc()->addRef(net);
+    rule->getDst()->addRef(server);
+    const char* services[] = { "tcp-HTTP", "tcp-SSH", "udp-DNS", NULL };
+    for (const char **id=services; *id!=NULL; ++id)
+    {
+        FWObject *srv = objdb->findInIndex(FWObjectDatabase::getIntId(*id));
+        CPPUNIT_ASSERT(srv != NULL);
+        rule->getSrv()->addRef(srv);
+    }
+    rule->setAction(PolicyRule::Accept);
+    return rule;
+}
+
+static void compareWithExpected(const QString &file_name,
+                                const QString &expected_file_name)
+{
+    QString generated = readGeneratedFile(file_name);
+    QString expected = readGeneratedFile(expected_file_name);
+    CPPUNIT_ASSERT_MESSAGE(
+        "Generated file " + file_name.toStdString() + " differs from " +
+        expected_file_name.toStdString(),
+        generated == expected);
+}
+
+/*
+ * pf rules made for tcp and udp services of the same policy rule can
+ * trade places. Skip steps optimizer puts the udp rule first since
+ * rules are sorted by protocol number as a string.
+ */
+void GeneratedScriptTest::SkipStepsReorderTest()
+{
+    QFile::remove("pf1.conf");
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    createSkipStepsPolicy(objdb);
+
+    QStringList args;
+    args << "pf1";
+    CompilerDriver_pf driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_pf initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+    CPPUNIT_ASSERT(driver.getStatus() != BaseCompiler::FWCOMPILER_ERROR);
+    delete objdb;
+
+    compareWithExpected("pf1.conf", "pf1-skip-steps-reorder.conf.orig");
+}
+
+/*
+ * Rules that set a tag are never moved, so with tagging the pf rules
+ * keep the order in which the compiler created them.
+ */
+void GeneratedScriptTest::SkipStepsTaggingTest()
+{
+    QFile::remove("pf1.conf");
+    objdb = new FWObjectDatabase();
+    loadDataFile("test1.fwb");
+    PolicyRule *rule = createSkipStepsPolicy(objdb);
+
+    Library *lib = Library::cast(
+        objdb->findObjectByName(Library::TYPENAME, "User"));
+    CPPUNIT_ASSERT(lib != NULL);
+    TagService *tag = TagService::cast(objdb->create(TagService::TYPENAME));
+    tag->setName("skip-steps-tag");
+    tag->setCode("skipsteps");
+    lib->add(tag);
+    rule->setTagging(true);
+    rule->setTagObject(tag);
+
+    QStringList args;
+    args << "pf1";
+    CompilerDriver_pf driver(objdb);
+    driver.setEmbeddedMode();
+    CPPUNIT_ASSERT_MESSAGE("CompilerDriver_pf initialization failed",
+                           driver.prepare(args) == true);
+    driver.compile();
+    CPPUNIT_ASSERT(driver.getStatus() != BaseCompiler::FWCOMPILER_ERROR);
+    delete objdb;
+
+    compareWithExpected("pf1.conf", "pf1-skip-steps-tagging.conf.orig");
+}
@@ -76,6 +76,9 @@ public:
     void ActivationCommandsTest_10();
     void ActivationCommandsTest_11();
     void ActivationCommandsTest_12();
+    void SpecializedClusterMembersTest();
+    void SkipStepsReorderTest();
+    void SkipStepsTaggingTest();
     
     CPPUNIT_TEST_SUITE(GeneratedScriptTest);
 
@@ -119,6 +122,11 @@ public:
 
     CPPUNIT_TEST(FwCommentTest);
 
+    CPPUNIT_TEST(SpecializedClusterMembersTest);
+
+    CPPUNIT_TEST(SkipStepsReorderTest);
+    CPPUNIT_TEST(SkipStepsTaggingTest);
+
     CPPUNIT_TEST_SUITE_END();
 
 };